@@ -0,0 +1,687 @@
+//--------------------------------------------------------------------------------------
+// File: ADPCMCodec.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "ADPCMCodec.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+// VS 2010 has neither <chrono> nor <thread>, so there every block is coded on
+// the calling thread.
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+#define ADPCM_USE_QPC
+#define ADPCM_NO_THREADS
+#else
+#include <atomic>
+#include <chrono>
+#include <system_error>
+#include <thread>
+#endif
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define ADPCM_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+
+
+const short DirectX::ADPCMCoefficients1[ ADPCMCoefficientCount ] = { 256,  512, 0, 192, 240,  460,  392 };
+const short DirectX::ADPCMCoefficients2[ ADPCMCoefficientCount ] = {   0, -256, 0,  64,   0, -208, -232 };
+
+
+namespace
+{
+    // Scales the step size by the magnitude of each code (x / 256).
+    const int AdaptationTable[ 16 ] = { 230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230 };
+
+    const int MinDelta = 16;
+
+    // Keeps a corrupt block from overflowing the step size; real data never gets near it.
+    const int MaxDelta = INT_MAX / 768;
+
+    // Codes expanded per pass when decoding, so the scratch buffer fits on the stack.
+    const size_t DecodeChunkCodes = 1024;
+
+    // Fewer blocks than this per thread costs more to start the thread than it saves.
+    const size_t MinBlocksPerThread = 256;
+
+    struct ChannelState
+    {
+        int coef1;
+        int coef2;
+        int delta;
+        int sample1;
+        int sample2;
+    };
+
+    inline int16_t ReadShort( const uint8_t* ptr )
+    {
+        return static_cast<int16_t>( ptr[ 0 ] | ( ptr[ 1 ] << 8 ) );
+    }
+
+    inline void WriteShort( uint8_t* ptr, int value )
+    {
+        ptr[ 0 ] = static_cast<uint8_t>( value & 0xFF );
+        ptr[ 1 ] = static_cast<uint8_t>( ( value >> 8 ) & 0xFF );
+    }
+
+    inline int Clamp16( int value )
+    {
+        return ( value < SHRT_MIN ) ? SHRT_MIN : ( ( value > SHRT_MAX ) ? SHRT_MAX : value );
+    }
+
+    // Divides (rounding toward zero) rather than shifting, as the reference codec does.
+    inline int Predict( const ChannelState& state )
+    {
+        return ( state.sample1 * state.coef1 + state.sample2 * state.coef2 ) / 256;
+    }
+
+    // Reconstructs one sample from a signed 4-bit code and advances the channel.
+    inline int Step( ChannelState& state, int predicted, int code )
+    {
+        int sample = Clamp16( predicted + code * state.delta );
+
+        state.sample2 = state.sample1;
+        state.sample1 = sample;
+
+        int delta = ( AdaptationTable[ code & 15 ] * state.delta ) / 256;
+        state.delta = ( delta < MinDelta ) ? MinDelta : ( ( delta > MaxDelta ) ? MaxDelta : delta );
+
+        return sample;
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Decoding
+    //----------------------------------------------------------------------------------
+
+    // Splits byteCount bytes into signed codes, high nibble first.
+    void ExpandNibbles( const uint8_t* source, size_t byteCount, int8_t* codes )
+    {
+        size_t i = 0;
+
+#if defined(ADPCM_USE_SSE2)
+        const __m128i mask = _mm_set1_epi8( 0x0F );
+        const __m128i sign = _mm_set1_epi8( 0x08 );
+        for( ; i + 16 <= byteCount; i += 16 )
+        {
+            __m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + i ) );
+
+            // (x ^ 8) - 8 sign-extends a 4-bit value held in a byte.
+            __m128i high = _mm_and_si128( _mm_srli_epi16( bytes, 4 ), mask );
+            __m128i low = _mm_and_si128( bytes, mask );
+            high = _mm_sub_epi8( _mm_xor_si128( high, sign ), sign );
+            low = _mm_sub_epi8( _mm_xor_si128( low, sign ), sign );
+
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( codes + i * 2 ), _mm_unpacklo_epi8( high, low ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( codes + i * 2 + 16 ), _mm_unpackhi_epi8( high, low ) );
+        }
+#endif
+
+        for( ; i < byteCount; ++i )
+        {
+            int high = source[ i ] >> 4;
+            int low = source[ i ] & 0x0F;
+            codes[ i * 2 ] = static_cast<int8_t>( ( high ^ 8 ) - 8 );
+            codes[ i * 2 + 1 ] = static_cast<int8_t>( ( low ^ 8 ) - 8 );
+        }
+    }
+
+    bool DecodeBlock( const uint8_t* block, int channels, int samplesPerBlock, int16_t* output )
+    {
+        ChannelState state[ 2 ];
+
+        const uint8_t* ptr = block;
+        for( int ch = 0; ch < channels; ++ch )
+        {
+            int predictor = *ptr++;
+            if ( predictor >= ADPCMCoefficientCount )
+                return false;
+
+            state[ ch ].coef1 = ADPCMCoefficients1[ predictor ];
+            state[ ch ].coef2 = ADPCMCoefficients2[ predictor ];
+        }
+
+        for( int ch = 0; ch < channels; ++ch, ptr += 2 )
+            state[ ch ].delta = ReadShort( ptr );
+
+        for( int ch = 0; ch < channels; ++ch, ptr += 2 )
+            state[ ch ].sample1 = ReadShort( ptr );
+
+        for( int ch = 0; ch < channels; ++ch, ptr += 2 )
+            state[ ch ].sample2 = ReadShort( ptr );
+
+        // The header samples are the first two frames, oldest first.
+        for( int ch = 0; ch < channels; ++ch )
+        {
+            output[ ch ] = static_cast<int16_t>( state[ ch ].sample2 );
+            output[ channels + ch ] = static_cast<int16_t>( state[ ch ].sample1 );
+        }
+        output += channels * 2;
+
+        // Codes are in output order, so mono and stereo only differ in which
+        // channel each one advances. The count is always even.
+        int8_t codes[ DecodeChunkCodes ];
+        size_t remaining = size_t( samplesPerBlock - 2 ) * channels;
+        while ( remaining > 0 )
+        {
+            size_t count = std::min( remaining, DecodeChunkCodes );
+            ExpandNibbles( ptr, count / 2, codes );
+            ptr += count / 2;
+
+            if ( channels == 1 )
+            {
+                ChannelState& mono = state[ 0 ];
+                for( size_t j = 0; j < count; ++j )
+                {
+                    output[ j ] = static_cast<int16_t>( Step( mono, Predict( mono ), codes[ j ] ) );
+                }
+            }
+            else
+            {
+                ChannelState& left = state[ 0 ];
+                ChannelState& right = state[ 1 ];
+                for( size_t j = 0; j < count; j += 2 )
+                {
+                    output[ j ] = static_cast<int16_t>( Step( left, Predict( left ), codes[ j ] ) );
+                    output[ j + 1 ] = static_cast<int16_t>( Step( right, Predict( right ), codes[ j + 1 ] ) );
+                }
+            }
+
+            output += count;
+            remaining -= count;
+        }
+
+        return true;
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Encoding
+    //----------------------------------------------------------------------------------
+
+    // Starting step size for a channel: a quarter of the average prediction error
+    // over the first few samples, so the first codes land mid-range.
+    int InitialDelta( const int16_t* samples, int stride, int samplesPerBlock, int predictor )
+    {
+        ChannelState state;
+        state.coef1 = ADPCMCoefficients1[ predictor ];
+        state.coef2 = ADPCMCoefficients2[ predictor ];
+        state.sample2 = samples[ 0 ];
+        state.sample1 = samples[ stride ];
+
+        int count = std::min( samplesPerBlock - 2, 4 );
+        int total = 0;
+        for( int j = 0; j < count; ++j )
+        {
+            int sample = samples[ ( j + 2 ) * stride ];
+            total += abs( sample - Predict( state ) );
+            state.sample2 = state.sample1;
+            state.sample1 = sample;
+        }
+
+        int delta = total / ( count * 4 );
+        return ( delta < MinDelta ) ? MinDelta : ( ( delta > SHRT_MAX ) ? SHRT_MAX : delta );
+    }
+
+    // The coefficient set that best predicts the source itself, without encoding.
+    int PickPredictor( const int16_t* samples, int stride, int samplesPerBlock )
+    {
+        int best = 0;
+        int64_t bestError = INT64_MAX;
+        for( int predictor = 0; predictor < ADPCMCoefficientCount; ++predictor )
+        {
+            ChannelState state;
+            state.coef1 = ADPCMCoefficients1[ predictor ];
+            state.coef2 = ADPCMCoefficients2[ predictor ];
+            state.sample2 = samples[ 0 ];
+            state.sample1 = samples[ stride ];
+
+            int64_t error = 0;
+            for( int j = 2; j < samplesPerBlock; ++j )
+            {
+                int sample = samples[ j * stride ];
+                error += abs( sample - Predict( state ) );
+                state.sample2 = state.sample1;
+                state.sample1 = sample;
+            }
+
+            if ( error < bestError )
+            {
+                bestError = error;
+                best = predictor;
+            }
+        }
+
+        return best;
+    }
+
+    struct ChannelEncoding
+    {
+        int                 predictor;
+        int                 delta;
+        std::vector<int8_t> codes;      // samplesPerBlock - 2 signed codes
+    };
+
+    // Encodes one channel of a block, writing codes and returning the squared
+    // error. Gives up, returning INT64_MAX, once the error reaches limit.
+    int64_t EncodeChannel( const int16_t* samples, int stride, int samplesPerBlock, int predictor, int delta,
+                           int64_t limit, int8_t* codes )
+    {
+        ChannelState state;
+        state.coef1 = ADPCMCoefficients1[ predictor ];
+        state.coef2 = ADPCMCoefficients2[ predictor ];
+        state.delta = delta;
+        state.sample2 = samples[ 0 ];
+        state.sample1 = samples[ stride ];
+
+        int64_t error = 0;
+        for( int j = 2; j < samplesPerBlock; ++j )
+        {
+            int sample = samples[ j * stride ];
+            int predicted = Predict( state );
+
+            // Round to the nearest code; the decoder multiplies it back by delta.
+            int residual = sample - predicted;
+            int bias = ( residual < 0 ) ? -( state.delta / 2 ) : ( state.delta / 2 );
+            int code = ( residual + bias ) / state.delta;
+            code = ( code < -8 ) ? -8 : ( ( code > 7 ) ? 7 : code );
+
+            int decoded = Step( state, predicted, code );
+            int64_t difference = sample - decoded;
+            error += difference * difference;
+            if ( error >= limit )
+                return INT64_MAX;
+
+            codes[ j - 2 ] = static_cast<int8_t>( code );
+        }
+
+        return error;
+    }
+
+    // Holds the scratch space for encoding, so encoding many blocks doesn't allocate.
+    class BlockEncoder
+    {
+    public:
+        BlockEncoder( int channels, int samplesPerBlock ) :
+            mChannels( channels ),
+            mSamplesPerBlock( samplesPerBlock ),
+            mPadded( size_t( samplesPerBlock ) * channels ),
+            mTrial( size_t( samplesPerBlock - 2 ) )
+        {
+            for( int ch = 0; ch < channels; ++ch )
+            {
+                mChannel[ ch ].codes.resize( size_t( samplesPerBlock - 2 ) );
+            }
+        }
+
+        void Encode( const int16_t* samples, size_t frameCount, ADPCM_ENCODE_QUALITY quality, uint8_t* block )
+        {
+            if ( frameCount < size_t( mSamplesPerBlock ) )
+            {
+                std::fill( mPadded.begin(), mPadded.end(), int16_t( 0 ) );
+                if ( frameCount > 0 )
+                {
+                    memcpy( &mPadded[ 0 ], samples, frameCount * mChannels * sizeof(int16_t) );
+                }
+                samples = &mPadded[ 0 ];
+            }
+
+            for( int ch = 0; ch < mChannels; ++ch )
+            {
+                ChooseEncoding( samples + ch, quality, mChannel[ ch ] );
+            }
+
+            Write( samples, block );
+        }
+
+    private:
+        void ChooseEncoding( const int16_t* samples, ADPCM_ENCODE_QUALITY quality, ChannelEncoding& result )
+        {
+            int stride = mChannels;
+
+            if ( quality == ADPCM_ENCODE_FAST )
+            {
+                result.predictor = PickPredictor( samples, stride, mSamplesPerBlock );
+                result.delta = InitialDelta( samples, stride, mSamplesPerBlock, result.predictor );
+                EncodeChannel( samples, stride, mSamplesPerBlock, result.predictor, result.delta, INT64_MAX, &result.codes[ 0 ] );
+                return;
+            }
+
+            int64_t bestError = INT64_MAX;
+            for( int predictor = 0; predictor < ADPCMCoefficientCount; ++predictor )
+            {
+                int estimate = InitialDelta( samples, stride, mSamplesPerBlock, predictor );
+
+                // BEST also tries a range of step sizes around the estimate.
+                int first = ( quality == ADPCM_ENCODE_BEST ) ? -2 : 0;
+                int last = ( quality == ADPCM_ENCODE_BEST ) ? 2 : 0;
+                int tried = 0;
+                for( int scale = first; scale <= last; ++scale )
+                {
+                    int delta = ( scale < 0 ) ? ( estimate >> -scale ) : ( estimate << scale );
+                    delta = ( delta < MinDelta ) ? MinDelta : ( ( delta > SHRT_MAX ) ? SHRT_MAX : delta );
+                    if ( delta == tried )
+                        continue;
+                    tried = delta;
+
+                    int64_t error = EncodeChannel( samples, stride, mSamplesPerBlock, predictor, delta, bestError, &mTrial[ 0 ] );
+                    if ( error < bestError )
+                    {
+                        bestError = error;
+                        result.predictor = predictor;
+                        result.delta = delta;
+                        result.codes.swap( mTrial );
+                    }
+                }
+            }
+
+            // The first candidate is tried without a limit, so one is always kept.
+            assert( bestError != INT64_MAX );
+        }
+
+        void Write( const int16_t* samples, uint8_t* block ) const
+        {
+            uint8_t* ptr = block;
+            for( int ch = 0; ch < mChannels; ++ch )
+                *ptr++ = static_cast<uint8_t>( mChannel[ ch ].predictor );
+
+            for( int ch = 0; ch < mChannels; ++ch, ptr += 2 )
+                WriteShort( ptr, mChannel[ ch ].delta );
+
+            for( int ch = 0; ch < mChannels; ++ch, ptr += 2 )
+                WriteShort( ptr, samples[ mChannels + ch ] );
+
+            for( int ch = 0; ch < mChannels; ++ch, ptr += 2 )
+                WriteShort( ptr, samples[ ch ] );
+
+            size_t codeFrames = size_t( mSamplesPerBlock - 2 );
+            if ( mChannels == 1 )
+            {
+                const int8_t* codes = &mChannel[ 0 ].codes[ 0 ];
+                for( size_t j = 0; j < codeFrames; j += 2 )
+                {
+                    *ptr++ = static_cast<uint8_t>( ( ( codes[ j ] & 0x0F ) << 4 ) | ( codes[ j + 1 ] & 0x0F ) );
+                }
+            }
+            else
+            {
+                const int8_t* left = &mChannel[ 0 ].codes[ 0 ];
+                const int8_t* right = &mChannel[ 1 ].codes[ 0 ];
+                for( size_t j = 0; j < codeFrames; ++j )
+                {
+                    *ptr++ = static_cast<uint8_t>( ( ( left[ j ] & 0x0F ) << 4 ) | ( right[ j ] & 0x0F ) );
+                }
+            }
+        }
+
+        int                     mChannels;
+        int                     mSamplesPerBlock;
+        std::vector<int16_t>    mPadded;
+        std::vector<int8_t>     mTrial;
+        ChannelEncoding         mChannel[ 2 ];
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Threading
+    //----------------------------------------------------------------------------------
+
+    // Splits count blocks into contiguous ranges, one per thread that's worth starting.
+    std::vector<size_t> SplitBlocks( size_t count, unsigned int threadCount )
+    {
+#ifdef ADPCM_NO_THREADS
+        threadCount = 1;
+#else
+        if ( !threadCount )
+        {
+            threadCount = std::max( 1u, std::thread::hardware_concurrency() );
+        }
+#endif
+
+        size_t ranges = std::max<size_t>( 1, std::min<size_t>( threadCount, count / MinBlocksPerThread ) );
+
+        std::vector<size_t> bounds( ranges + 1 );
+        for( size_t j = 0; j <= ranges; ++j )
+        {
+            bounds[ j ] = count * j / ranges;
+        }
+        return bounds;
+    }
+
+    // Runs work( range, first, last ) for each range, the first on the calling
+    // thread. A range whose thread can't be started runs on the calling thread.
+    template<typename Work>
+    void ForEachRange( const std::vector<size_t>& bounds, Work work )
+    {
+        size_t ranges = bounds.size() - 1;
+
+#ifdef ADPCM_NO_THREADS
+        for( size_t j = 0; j < ranges; ++j )
+        {
+            work( j, bounds[ j ], bounds[ j + 1 ] );
+        }
+#else
+        std::vector<std::thread> threads;
+        threads.reserve( ranges );
+        for( size_t j = 1; j < ranges; ++j )
+        {
+            try
+            {
+                threads.emplace_back( work, j, bounds[ j ], bounds[ j + 1 ] );
+            }
+            catch( const std::system_error& )
+            {
+                work( j, bounds[ j ], bounds[ j + 1 ] );
+            }
+        }
+
+        work( size_t( 0 ), bounds[ 0 ], bounds[ 1 ] );
+
+        for( auto it = threads.begin(); it != threads.end(); ++it )
+        {
+            it->join();
+        }
+#endif
+    }
+
+    double SteadyClock()
+    {
+#ifdef ADPCM_USE_QPC
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency( &frequency );
+        QueryPerformanceCounter( &counter );
+        return double( counter.QuadPart ) / double( frequency.QuadPart );
+#else
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+#endif
+    }
+
+    void ValidateFormat( int channels, int samplesPerBlock )
+    {
+        if ( !ADPCMBlockAlign( channels, samplesPerBlock ) )
+        {
+            throw std::invalid_argument( "ADPCM format" );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------
+
+size_t DirectX::ADPCMBlockAlign( int channels, int samplesPerBlock )
+{
+    if ( ( channels != 1 && channels != 2 )
+         || ( samplesPerBlock < ADPCMMinSamplesPerBlock )
+         || ( samplesPerBlock > ADPCMMaxSamplesPerBlock )
+         || ( channels == 1 && ( samplesPerBlock % 2 ) != 0 ) )
+    {
+        return 0;
+    }
+
+    return size_t( ADPCMHeaderBytesPerChannel * channels ) + size_t( samplesPerBlock - 2 ) * 4 * channels / 8;
+}
+
+
+bool DirectX::DecodeADPCMBlock( const uint8_t* block, int channels, int samplesPerBlock, int16_t* output )
+{
+    ValidateFormat( channels, samplesPerBlock );
+
+    return DecodeBlock( block, channels, samplesPerBlock, output );
+}
+
+
+bool DirectX::DecodeADPCM( const uint8_t* blocks, size_t blockCount, int channels, int samplesPerBlock,
+                           int16_t* output, unsigned int threadCount )
+{
+    ValidateFormat( channels, samplesPerBlock );
+
+    size_t blockAlign = ADPCMBlockAlign( channels, samplesPerBlock );
+    size_t blockSamples = size_t( samplesPerBlock ) * channels;
+
+#ifdef ADPCM_NO_THREADS
+    bool failed = false;
+#else
+    std::atomic<bool> failed( false );
+#endif
+    ForEachRange( SplitBlocks( blockCount, threadCount ), [&]( size_t, size_t first, size_t last )
+    {
+        for( size_t j = first; j < last; ++j )
+        {
+            if ( !DecodeBlock( blocks + j * blockAlign, channels, samplesPerBlock, output + j * blockSamples ) )
+            {
+                failed = true;
+                break;
+            }
+        }
+    } );
+
+    return !failed;
+}
+
+
+void DirectX::EncodeADPCMBlock( const int16_t* samples, size_t frameCount, int channels, int samplesPerBlock,
+                                ADPCM_ENCODE_QUALITY quality, uint8_t* block )
+{
+    ValidateFormat( channels, samplesPerBlock );
+
+    BlockEncoder encoder( channels, samplesPerBlock );
+    encoder.Encode( samples, frameCount, quality, block );
+}
+
+
+size_t DirectX::EncodeADPCM( const int16_t* samples, size_t frameCount, int channels, int samplesPerBlock,
+                             ADPCM_ENCODE_QUALITY quality, std::vector<uint8_t>& output, unsigned int threadCount )
+{
+    ValidateFormat( channels, samplesPerBlock );
+
+    size_t blockAlign = ADPCMBlockAlign( channels, samplesPerBlock );
+    size_t blockCount = ( frameCount + samplesPerBlock - 1 ) / samplesPerBlock;
+
+    output.resize( blockCount * blockAlign );
+    if ( !blockCount )
+        return 0;
+
+    // Scratch space is allocated here, so the workers can't fail.
+    auto bounds = SplitBlocks( blockCount, threadCount );
+    std::vector<BlockEncoder> encoders( bounds.size() - 1, BlockEncoder( channels, samplesPerBlock ) );
+
+    uint8_t* blocks = &output[ 0 ];
+    ForEachRange( bounds, [&]( size_t range, size_t first, size_t last )
+    {
+        BlockEncoder& encoder = encoders[ range ];
+        for( size_t j = first; j < last; ++j )
+        {
+            size_t frame = j * samplesPerBlock;
+            encoder.Encode( samples + frame * channels, std::min<size_t>( samplesPerBlock, frameCount - frame ), quality, blocks + j * blockAlign );
+        }
+    } );
+
+    return blockCount;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+ADPCMBenchmark DirectX::BenchmarkADPCM( int channels, int samplesPerBlock, ADPCM_ENCODE_QUALITY quality,
+                                        double audioSeconds, unsigned int threadCount )
+{
+    ValidateFormat( channels, samplesPerBlock );
+
+    // A chord with a slow tremolo over a little noise, so every coefficient set
+    // and step size gets used.
+    const int sampleRate = 44100;
+    size_t frameCount = static_cast<size_t>( audioSeconds * sampleRate );
+    std::vector<int16_t> source( frameCount * channels );
+    uint32_t seed = 1;
+    for( size_t j = 0; j < frameCount; ++j )
+    {
+        float t = float( j ) / float( sampleRate );
+        float tone = 0.3f * sinf( t * 2.f * 3.14159265f * 220.f )
+                     + 0.2f * sinf( t * 2.f * 3.14159265f * 277.f )
+                     + 0.1f * sinf( t * 2.f * 3.14159265f * 3300.f );
+        tone *= 0.75f + 0.25f * sinf( t * 2.f * 3.14159265f * 0.5f );
+
+        for( int ch = 0; ch < channels; ++ch )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            float noise = float( int( seed >> 16 ) - 32768 ) / 32768.f * 0.01f;
+            float value = ( ch ? -tone : tone ) + noise;
+            source[ j * channels + ch ] = static_cast<int16_t>( value * 32767.f );
+        }
+    }
+
+    std::vector<uint8_t> encoded;
+    double start = SteadyClock();
+    size_t blockCount = EncodeADPCM( frameCount ? &source[ 0 ] : nullptr, frameCount, channels, samplesPerBlock, quality, encoded, threadCount );
+    double encodeEnd = SteadyClock();
+
+    std::vector<int16_t> decoded( blockCount * samplesPerBlock * channels );
+    double decodeStart = SteadyClock();
+    if ( blockCount )
+    {
+        DecodeADPCM( &encoded[ 0 ], blockCount, channels, samplesPerBlock, &decoded[ 0 ], threadCount );
+    }
+    double end = SteadyClock();
+
+    double signal = 0;
+    double noise = 0;
+    for( size_t j = 0; j < source.size(); ++j )
+    {
+        double difference = double( source[ j ] ) - double( decoded[ j ] );
+        signal += double( source[ j ] ) * double( source[ j ] );
+        noise += difference * difference;
+    }
+
+    ADPCMBenchmark result;
+    result.blockCount = blockCount;
+    result.threadCount = unsigned( SplitBlocks( blockCount, threadCount ).size() - 1 );
+    result.encodeSeconds = encodeEnd - start;
+    result.decodeSeconds = end - decodeStart;
+    result.decodeMegabytesPerSecond = ( result.decodeSeconds > 0 )
+                                      ? double( decoded.size() * sizeof(int16_t) ) / ( 1024.0 * 1024.0 ) / result.decodeSeconds : 0;
+    result.signalToNoise = ( noise > 0 ) ? 10.0 * log10( signal / noise ) : 0;
+    return result;
+}
@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------------------
+// File: ADPCMCodec.h
+//
+// Encodes and decodes Microsoft ADPCM (WAVE_FORMAT_ADPCM) blocks, for xwbtool and
+// for the runtime
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+
+namespace DirectX
+{
+    // A block starts with a header per channel (predictor index, delta, then the
+    // second and first sample), fields interleaved by channel. The remaining
+    // samplesPerBlock - 2 frames follow as 4-bit codes, high nibble first; in
+    // stereo the high nibble is the left channel. Every block starts from its own
+    // header, so blocks decode and encode independently of each other.
+
+    const int ADPCMHeaderBytesPerChannel = 7;       // MSADPCM_HEADER_LENGTH
+    const int ADPCMMinSamplesPerBlock = 4;          // MSADPCM_MIN_SAMPLES_PER_BLOCK
+    const int ADPCMMaxSamplesPerBlock = 64000;      // MSADPCM_MAX_SAMPLES_PER_BLOCK
+    const int ADPCMCoefficientCount = 7;            // MSADPCM_NUM_COEFFICIENTS
+
+    // Microsoft ADPCM standard encoding coefficients, as every WAVE_FORMAT_ADPCM
+    // format carries them.
+    extern const short ADPCMCoefficients1[ ADPCMCoefficientCount ];
+    extern const short ADPCMCoefficients2[ ADPCMCoefficientCount ];
+
+    // Bytes in a block, or 0 if channels or samplesPerBlock isn't valid (mono
+    // blocks need an even samplesPerBlock).
+    size_t ADPCMBlockAlign( int channels, int samplesPerBlock );
+
+    enum ADPCM_ENCODE_QUALITY
+    {
+        ADPCM_ENCODE_FAST,      // Picks coefficients from the source, then encodes once.
+        ADPCM_ENCODE_DEFAULT,   // Encodes with every coefficient set and keeps the closest.
+        ADPCM_ENCODE_BEST,      // Also searches the starting step size.
+    };
+
+    // Decodes one block into samplesPerBlock interleaved frames. Returns false if
+    // the block names a coefficient set that doesn't exist.
+    bool DecodeADPCMBlock( const uint8_t* block, int channels, int samplesPerBlock, int16_t* output );
+
+    // Decodes blockCount consecutive blocks, split across threadCount threads
+    // (0 for one per hardware thread). Returns false if any block is bad.
+    bool DecodeADPCM( const uint8_t* blocks, size_t blockCount, int channels, int samplesPerBlock,
+                      int16_t* output, unsigned int threadCount = 0 );
+
+    // Encodes up to samplesPerBlock interleaved frames into one block; a short
+    // final block is padded with silence.
+    void EncodeADPCMBlock( const int16_t* samples, size_t frameCount, int channels, int samplesPerBlock,
+                           ADPCM_ENCODE_QUALITY quality, uint8_t* block );
+
+    // Encodes frameCount interleaved frames into whole blocks, replacing the
+    // contents of output, split across threadCount threads (0 for one per
+    // hardware thread). Returns the number of blocks.
+    size_t EncodeADPCM( const int16_t* samples, size_t frameCount, int channels, int samplesPerBlock,
+                        ADPCM_ENCODE_QUALITY quality, std::vector<uint8_t>& output, unsigned int threadCount = 0 );
+
+
+    struct ADPCMBenchmark
+    {
+        size_t          blockCount;
+        unsigned int    threadCount;
+        double          encodeSeconds;
+        double          decodeSeconds;
+        double          decodeMegabytesPerSecond;   // PCM produced, in MB (2^20 bytes) per second
+        double          signalToNoise;              // Decoded against the source, in dB
+    };
+
+    // Encodes audioSeconds of 44.1 kHz test signal at the given quality, then
+    // times decoding it on threadCount threads (0 for one per hardware thread).
+    ADPCMBenchmark BenchmarkADPCM( int channels, int samplesPerBlock, ADPCM_ENCODE_QUALITY quality,
+                                   double audioSeconds, unsigned int threadCount = 0 );
+}
@@ -14,6 +14,7 @@
 #include "pch.h"
 #include "Audio.h"
 #include "SoundCommon.h"
+#include "VoicePool.h"
 
 #include <list>
 #include <unordered_map>
@@ -137,43 +138,44 @@ namespace
         XAUDIO2FX_I3DL2_PRESET_PLATE,               // Reverb_Plate
     };
 
-    inline unsigned int makeVoiceKey( _In_ const WAVEFORMATEX* wfx )
+    union KeyGen
     {
-        assert( IsValid(wfx) );
-
-        if ( wfx->nChannels > 0x7F )
-            return 0;
-
-        union KeyGen
+        struct
         {
-            struct
-            {
-                unsigned int tag : 9;
-                unsigned int channels : 7;
-                unsigned int bitsPerSample : 8;
-            } pcm;
+            unsigned int tag : 9;
+            unsigned int channels : 7;
+            unsigned int bitsPerSample : 8;
+        } pcm;
 
-            struct
-            {
-                unsigned int tag : 9;
-                unsigned int channels : 7;
-                unsigned int samplesPerBlock : 16;
-            } adpcm;
+        struct
+        {
+            unsigned int tag : 9;
+            unsigned int channels : 7;
+            unsigned int samplesPerBlock : 16;
+        } adpcm;
 
 #if defined(_XBOX_ONE) && defined(_TITLE)
-            struct
-            {
-                unsigned int tag : 9;
-                unsigned int channels : 7;
-                unsigned int encoderVersion : 8;
-            } xma;
+        struct
+        {
+            unsigned int tag : 9;
+            unsigned int channels : 7;
+            unsigned int encoderVersion : 8;
+        } xma;
 #endif
 
-            unsigned int key;
-        } result;
+        unsigned int key;
+    };
+
+    static_assert( sizeof(KeyGen) == sizeof(unsigned int), "KeyGen is invalid" ); 
+
+    inline unsigned int makeVoiceKey( _In_ const WAVEFORMATEX* wfx )
+    {
+        assert( IsValid(wfx) );
 
-        static_assert( sizeof(KeyGen) == sizeof(unsigned int), "KeyGen is invalid" ); 
+        if ( wfx->nChannels > 0x7F )
+            return 0;
 
+        KeyGen result;
         result.key = 0;
 
         if ( wfx->wFormatTag == WAVE_FORMAT_EXTENSIBLE )
@@ -243,6 +245,41 @@ namespace
 
         return result.key;
     }
+
+    // Builds the format a pooled voice is created with for a key from makeVoiceKey;
+    // voices are retuned to each sound's own rate with SetSourceSampleRate.
+    inline void makeVoiceFormat( unsigned int key, int sampleRate, _Out_writes_bytes_(64) WAVEFORMATEX* wfmt )
+    {
+        KeyGen gen;
+        gen.key = key;
+
+        memset( wfmt, 0, 64 );
+
+        switch( gen.pcm.tag )
+        {
+        case WAVE_FORMAT_PCM:
+            CreateIntegerPCM( wfmt, sampleRate, gen.pcm.channels, gen.pcm.bitsPerSample );
+            break;
+
+        case WAVE_FORMAT_IEEE_FLOAT:
+            CreateFloatPCM( wfmt, sampleRate, gen.pcm.channels );
+            break;
+
+        case WAVE_FORMAT_ADPCM:
+            CreateADPCM( wfmt, 64, sampleRate, gen.adpcm.channels, gen.adpcm.samplesPerBlock );
+            break;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+        case WAVE_FORMAT_XMA2:
+            CreateXMA2( wfmt, 64, sampleRate, gen.xma.channels, 65536, 2, 0 );
+            break;
+#endif
+
+        default:
+            assert( false );
+            break;
+        }
+    }
 }
 
 static_assert( _countof(gReverbPresets) == Reverb_MAX, "AUDIO_ENGINE_REVERB enum mismatch" );
@@ -253,9 +290,12 @@ static_assert( _countof(gReverbPresets) == Reverb_MAX, "AUDIO_ENGINE_REVERB enum
 //======================================================================================
 
 // Internal object implementation class.
-class AudioEngine::Impl
+class AudioEngine::Impl : public IVoicePoolFactory
 {
 public:
+    // mVoicePool calls back into this object, which it only stores here.
+#pragma warning( push )
+#pragma warning( disable : 4355 )
     Impl() :
         mMasterVoice( nullptr ),
         mReverbVoice( nullptr ),
@@ -268,11 +308,13 @@ public:
         mCriticalError( false ),
         mReverbEnabled( false ),
         mEngineFlags( AudioEngine_Default ),
+        mVoicePool( this ),
         mCategory( AudioCategory_GameEffects ),
         mVoiceInstances( 0 )
     {
         memset( &mX3DAudio, 0, X3DAUDIO_HANDLE_BYTESIZE );
     };
+#pragma warning( pop )
 
     HRESULT Initialize( AUDIO_ENGINE_FLAGS flags, _In_opt_ const WAVEFORMATEX* wfx, _In_opt_z_ const wchar_t* deviceId, AUDIO_STREAM_CATEGORY category );
 
@@ -291,6 +333,8 @@ public:
     AudioStatistics GetStatistics() const;
 
     void TrimVoicePool();
+
+    void PrewarmVoicePool( _In_ const WAVEFORMATEX* wfx, size_t count );
     
     void AllocateVoice( _In_ const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, _Outptr_result_maybenull_ IXAudio2SourceVoice** voice );
     void DestroyVoice( _In_ IXAudio2SourceVoice* voice );
@@ -298,6 +342,10 @@ public:
     void RegisterNotify( _In_ IVoiceNotify* notify, bool usesUpdate );
     void UnregisterNotify( _In_ IVoiceNotify* notify, bool oneshots, bool usesUpdate );
 
+    // IVoicePoolFactory
+    virtual void* CreatePoolVoice( unsigned int key ) override;
+    virtual void DestroyPoolVoice( void* voice ) override;
+
     ComPtr<IXAudio2>                    xaudio2;
     IXAudio2MasteringVoice*             mMasterVoice;
     IXAudio2SubmixVoice*                mReverbVoice;
@@ -317,16 +365,16 @@ public:
 
     AUDIO_ENGINE_FLAGS                  mEngineFlags;
 
+    VoicePool                           mVoicePool;     // Idle one-shot voices by voice key
+
 private:
     typedef std::set<IVoiceNotify*> notifylist_t;
     typedef std::list<std::pair<unsigned int, IXAudio2SourceVoice*>> oneshotlist_t;
-    typedef std::unordered_multimap<unsigned int,IXAudio2SourceVoice*> voicepool_t;
 
     AUDIO_STREAM_CATEGORY               mCategory;
     ComPtr<IUnknown>                    mReverbEffect;
     ComPtr<IUnknown>                    mVolumeLimiter;
     oneshotlist_t                       mOneShots;
-    voicepool_t                         mVoicePool;
     notifylist_t                        mNotifyObjects;
     notifylist_t                        mNotifyUpdates;
     size_t                              mVoiceInstances;
@@ -670,7 +718,7 @@ void AudioEngine::Impl::SetSilentMode()
     }
 
     mOneShots.clear();
-    mVoicePool.clear();
+    mVoicePool.Abandon();
 
     mVoiceInstances = 0;
 
@@ -698,7 +746,7 @@ void AudioEngine::Impl::Shutdown()
         xaudio2->StopEngine();
 
         mOneShots.clear();
-        mVoicePool.clear();
+        mVoicePool.Abandon();
 
         mVoiceInstances = 0;
 
@@ -759,8 +807,7 @@ bool AudioEngine::Impl::Update()
 #ifdef VERBOSE_TRACE
                     DebugTrace( "INFO: One-shot voice being saved for reuse (%08X)\n", it->first );
 #endif
-                    voicepool_t::value_type v( it->first, it->second );
-                    mVoicePool.emplace( v );
+                    mVoicePool.Release( it->first, it->second );
                 }
                 else
                 {
@@ -781,6 +828,9 @@ bool AudioEngine::Impl::Update()
         throw std::exception( "WaitForMultipleObjects" );
     }
 
+    // Release voices that have sat idle for longer than the pool policy allows
+    mVoicePool.Trim();
+
     //
     // Inform any notify objects of updates
     //
@@ -843,8 +893,15 @@ AudioStatistics AudioEngine::Impl::GetStatistics() const
     AudioStatistics stats;
     memset( &stats, 0, sizeof(stats) );
 
-    stats.allocatedVoices = stats.allocatedVoicesOneShot = mOneShots.size() + mVoicePool.size();
-    stats.allocatedVoicesIdle = mVoicePool.size();
+    stats.allocatedVoices = stats.allocatedVoicesOneShot = mOneShots.size() + mVoicePool.GetIdleCount();
+    stats.allocatedVoicesIdle = mVoicePool.GetIdleCount();
+
+    auto pool = mVoicePool.GetStatistics();
+    stats.voicePoolHits = static_cast<size_t>( pool.hits );
+    stats.voicePoolMisses = static_cast<size_t>( pool.misses );
+    stats.voicePoolEvictions = static_cast<size_t>( pool.evictions );
+    stats.voicePoolCreateTimeMS = ( pool.creations > 0 ) ? float( pool.createSeconds * 1000.0 / double( pool.creations ) ) : 0.f;
+    stats.voicePoolCreateTimeMaxMS = float( pool.createSecondsMax * 1000.0 );
 
     for( auto it = mNotifyObjects.begin(); it != mNotifyObjects.end(); ++it )
     {
@@ -852,7 +909,7 @@ AudioStatistics AudioEngine::Impl::GetStatistics() const
         (*it)->GatherStatistics( stats );
     }
 
-    assert( stats.allocatedVoices == ( mOneShots.size() + mVoicePool.size() + mVoiceInstances ) );
+    assert( stats.allocatedVoices == ( mOneShots.size() + mVoicePool.GetIdleCount() + mVoiceInstances ) );
 
     return stats;
 }
@@ -866,12 +923,76 @@ void AudioEngine::Impl::TrimVoicePool()
         (*it)->OnTrim();
     }
 
-    for( auto it = mVoicePool.begin(); it != mVoicePool.end(); ++it )
+    mVoicePool.Clear();
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::Impl::PrewarmVoicePool( const WAVEFORMATEX* wfx, size_t count )
+{
+    if ( !wfx )
+        throw std::exception( "Wave format is required\n" );
+
+    if ( !xaudio2 || mCriticalError || ( mEngineFlags & AudioEngine_DisableVoiceReuse ) )
+        return;
+
+    unsigned int voiceKey = makeVoiceKey( wfx );
+    if ( !voiceKey )
+        return;
+
+    // Prewarmed voices count against the one-shot limit like any other idle voice
+    size_t idle = mVoicePool.GetIdleCount( voiceKey );
+    size_t used = mVoicePool.GetIdleCount() + mOneShots.size();
+    if ( count > idle && maxVoiceOneshots > used + 1 )
+    {
+        count = std::min( count, idle + ( maxVoiceOneshots - used - 1 ) );
+    }
+    else
+    {
+        count = std::min( count, idle );
+    }
+
+    size_t created = mVoicePool.Prewarm( voiceKey, count );
+
+#ifdef VERBOSE_TRACE
+    DebugTrace( "INFO: Prewarmed %Iu voices for reuse (%08X)\n", created, voiceKey );
+#else
+    UNREFERENCED_PARAMETER( created );
+#endif
+}
+
+
+void* AudioEngine::Impl::CreatePoolVoice( unsigned int key )
+{
+    // makeVoiceKey already constrained the keys to the formats supported for reuse
+
+    char buff[64];
+    auto wfmt = reinterpret_cast<WAVEFORMATEX*>( buff );
+    makeVoiceFormat( key, defaultRate, wfmt );
+
+#ifdef VERBOSE_TRACE
+    DebugTrace( "INFO: Allocate reuse voice: Format Tag %u, %u channels, %u-bit, %u blkalign, %u Hz\n", wfmt->wFormatTag,
+                wfmt->nChannels, wfmt->wBitsPerSample, wfmt->nBlockAlign, wfmt->nSamplesPerSec );
+#endif
+
+    assert( key == makeVoiceKey( wfmt ) );
+
+    IXAudio2SourceVoice* voice = nullptr;
+    HRESULT hr = xaudio2->CreateSourceVoice( &voice, wfmt, 0, XAUDIO2_DEFAULT_FREQ_RATIO, &mVoiceCallback, nullptr, nullptr );
+    if ( FAILED(hr) )
     {
-        assert( it->second != 0 );
-        it->second->DestroyVoice();
+        DebugTrace( "ERROR: CreateSourceVoice (reuse) failed with error %08X\n", hr );
+        throw std::exception( "CreateSourceVoice" );
     }
-    mVoicePool.clear();
+
+    return voice;
+}
+
+
+void AudioEngine::Impl::DestroyPoolVoice( void* voice )
+{
+    assert( voice != 0 );
+    static_cast<IXAudio2SourceVoice*>( voice )->DestroyVoice();
 }
 
 
@@ -920,71 +1041,38 @@ void AudioEngine::Impl::AllocateVoice( const WAVEFORMATEX* wfx, SOUND_EFFECT_INS
             voiceKey = makeVoiceKey( wfx );
             if ( voiceKey != 0 )
             {
-                auto it = mVoicePool.find( voiceKey );
-                if ( it != mVoicePool.end() )
-                {
-                    // Found a matching (stopped) voice to reuse
-                    assert( it->second != 0 );
-                    *voice = it->second;
-                    mVoicePool.erase( it );
-                }
-                else if ( ( mVoicePool.size() + mOneShots.size() + 1 ) >= maxVoiceOneshots )
-                {
-                    DebugTrace( "WARNING: Too many one-shot voices in use (%Iu + %Iu >= %Iu); one-shot not played\n",
-                                mVoicePool.size(), mOneShots.size() + 1, maxVoiceOneshots );
-                    return;
-                }
-                else
+                if ( !mVoicePool.GetIdleCount( voiceKey ) )
                 {
-                    // makeVoiceKey already constrained the supported wfx formats to those supported for reuse
-
-                    char buff[64] = {0};
-                    auto wfmt = reinterpret_cast<WAVEFORMATEX*>( buff );
-
-                    uint32_t tag = GetFormatTag( wfx );
-                    switch( tag )
+                    // No matching (stopped) voice to reuse, so a new one is needed; idle voices
+                    // of other formats give way to it under the one-shot limit
+                    while ( ( mVoicePool.GetIdleCount() + mOneShots.size() + 1 ) >= maxVoiceOneshots
+                            && mVoicePool.EvictIdle() )
                     {
-                    case WAVE_FORMAT_PCM:
-                        CreateIntegerPCM( wfmt, defaultRate, wfx->nChannels, wfx->wBitsPerSample );
-                        break;
-
-                    case WAVE_FORMAT_IEEE_FLOAT:
-                        CreateFloatPCM( wfmt, defaultRate, wfx->nChannels );
-                        break;
-
-                    case WAVE_FORMAT_ADPCM:
-                        {
-                            auto wfadpcm = reinterpret_cast<const ADPCMWAVEFORMAT*>( wfx );
-                            CreateADPCM( wfmt, 64, defaultRate, wfx->nChannels, wfadpcm->wSamplesPerBlock );
-                        }
-                        break;
-
-#if defined(_XBOX_ONE) && defined(_TITLE)
-                    case WAVE_FORMAT_XMA2:
-                        CreateXMA2( wfmt, 64, defaultRate, wfx->nChannels, 65536, 2, 0 );
-                        break;
-#endif
                     }
 
-#ifdef VERBOSE_TRACE
-                    DebugTrace( "INFO: Allocate reuse voice: Format Tag %u, %u channels, %u-bit, %u blkalign, %u Hz\n", wfmt->wFormatTag,
-                                wfmt->nChannels, wfmt->wBitsPerSample, wfmt->nBlockAlign, wfmt->nSamplesPerSec );
-#endif
-
-                    assert( voiceKey == makeVoiceKey( wfmt ) );
-
-                    HRESULT hr = xaudio2->CreateSourceVoice( voice, wfmt, 0, XAUDIO2_DEFAULT_FREQ_RATIO, &mVoiceCallback, nullptr, nullptr );
-                    if ( FAILED(hr) )
+                    if ( ( mVoicePool.GetIdleCount() + mOneShots.size() + 1 ) >= maxVoiceOneshots )
                     {
-                        DebugTrace( "ERROR: CreateSourceVoice (reuse) failed with error %08X\n", hr );
-                        throw std::exception( "CreateSourceVoice" );
+                        DebugTrace( "WARNING: Too many one-shot voices in use (%Iu + %Iu >= %Iu); one-shot not played\n",
+                                    mVoicePool.GetIdleCount(), mOneShots.size() + 1, maxVoiceOneshots );
+                        return;
                     }
                 }
 
-                assert( *voice != 0 );
+                *voice = static_cast<IXAudio2SourceVoice*>( mVoicePool.Acquire( voiceKey ) );
+                if ( !*voice )
+                {
+                    DebugTrace( "WARNING: Voice pool budget exhausted (%Iu voices in use); one-shot not played; see SetVoicePoolPolicy\n",
+                                mVoicePool.GetActiveCount() );
+                    return;
+                }
+
                 HRESULT hr = (*voice)->SetSourceSampleRate( wfx->nSamplesPerSec );
                 if ( FAILED(hr) )
                 {
+                    // Hand the voice back, or it stays counted as active for good.
+                    mVoicePool.Release( voiceKey, *voice );
+                    *voice = nullptr;
+
                     DebugTrace( "ERROR: SetSourceSampleRate failed with error %08X\n", hr );
                     throw std::exception( "SetSourceSampleRate" );
                 }
@@ -996,10 +1084,10 @@ void AudioEngine::Impl::AllocateVoice( const WAVEFORMATEX* wfx, SOUND_EFFECT_INS
     {
         if ( oneshot )
         {
-            if ( ( mVoicePool.size() + mOneShots.size() + 1 ) >= maxVoiceOneshots )
+            if ( ( mVoicePool.GetIdleCount() + mOneShots.size() + 1 ) >= maxVoiceOneshots )
             {
                 DebugTrace( "WARNING: Too many one-shot voices in use (%Iu + %Iu >= %Iu); one-shot not played; see TrimVoicePool\n",
-                            mVoicePool.size(), mOneShots.size() + 1, maxVoiceOneshots );
+                            mVoicePool.GetIdleCount(), mOneShots.size() + 1, maxVoiceOneshots );
                 return;
             }
         }
@@ -1071,13 +1159,10 @@ void AudioEngine::Impl::DestroyVoice( _In_ IXAudio2SourceVoice* voice )
         }
     }
 
-    for( auto it = mVoicePool.cbegin(); it != mVoicePool.cend(); ++it )
+    if ( mVoicePool.IsIdle( voice ) )
     {
-        if ( it->second == voice )
-        {
-            DebugTrace( "ERROR: DestroyVoice should not be called for a one-shot voice; see TrimVoicePool\n" );
-            throw std::exception( "DestroyVoice" );
-        }
+        DebugTrace( "ERROR: DestroyVoice should not be called for a one-shot voice; see TrimVoicePool\n" );
+        throw std::exception( "DestroyVoice" );
     }
 #endif
 
@@ -1378,6 +1463,26 @@ void AudioEngine::TrimVoicePool()
 }
 
 
+void AudioEngine::SetVoicePoolPolicy( size_t maxIdleVoices, float maxIdleSeconds, size_t maxPooledVoices )
+{
+    if ( maxIdleSeconds < 0.f )
+        throw std::out_of_range( "AudioEngine::SetVoicePoolPolicy" );
+
+    VoicePoolPolicy policy;
+    policy.maxVoices = maxPooledVoices;
+    policy.maxIdleVoices = maxIdleVoices;
+    policy.maxIdleSeconds = maxIdleSeconds;
+    pImpl->mVoicePool.SetPolicy( policy );
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::PrewarmVoicePool( const WAVEFORMATEX* wfx, size_t count )
+{
+    pImpl->PrewarmVoicePool( wfx, count );
+}
+
+
 _Use_decl_annotations_
 void AudioEngine::AllocateVoice( const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, IXAudio2SourceVoice** voice )
 {
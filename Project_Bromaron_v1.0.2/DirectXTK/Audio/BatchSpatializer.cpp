@@ -0,0 +1,576 @@
+//--------------------------------------------------------------------------------------
+// File: BatchSpatializer.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "BatchSpatializer.h"
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// VS 2010 doesn't have <chrono>
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+#define SPATIALIZER_USE_QPC
+#else
+#include <chrono>
+#endif
+
+#if defined(__AVX__)
+#define SPATIALIZER_USE_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define SPATIALIZER_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace DirectX;
+
+
+namespace
+{
+    const float Pi = 3.14159265358979f;
+
+    double SteadyClock()
+    {
+#ifdef SPATIALIZER_USE_QPC
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency( &frequency );
+        QueryPerformanceCounter( &counter );
+        return double( counter.QuadPart ) / double( frequency.QuadPart );
+#else
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+#endif
+    }
+
+    // Closer than this, an emitter is treated as at the listener: centred, no
+    // Doppler, and inside its own cone.
+    const float MinDistance = 1e-6f;
+
+    // Projected velocities are clamped to half the speed of sound, which keeps
+    // the Doppler ratio finite before maxDoppler applies.
+    const float MaxProjectedSpeed = 0.5f;
+
+    //----------------------------------------------------------------------------------
+    // Lanes
+    //----------------------------------------------------------------------------------
+
+    // One kernel serves every instruction set through these; masks are all-ones
+    // or all-zeros per lane.
+
+    struct Lanes1
+    {
+        typedef float V;
+        typedef bool M;
+        static const size_t Width = 1;
+
+        static V Load( const float* p ) { return *p; }
+        static void Store( float* p, V v ) { *p = v; }
+        static V Set( float f ) { return f; }
+        static V Add( V a, V b ) { return a + b; }
+        static V Sub( V a, V b ) { return a - b; }
+        static V Mul( V a, V b ) { return a * b; }
+        static V Div( V a, V b ) { return a / b; }
+        static V Sqrt( V a ) { return sqrtf( a ); }
+        static V Min( V a, V b ) { return ( a < b ) ? a : b; }
+        static V Max( V a, V b ) { return ( a > b ) ? a : b; }
+        static V Abs( V a ) { return fabsf( a ); }
+        static M Less( V a, V b ) { return a < b; }
+        static V Select( M m, V a, V b ) { return m ? a : b; }
+        static int Bits( M m ) { return m ? 1 : 0; }
+    };
+
+#if defined(SPATIALIZER_USE_AVX) || defined(SPATIALIZER_USE_SSE)
+    struct Lanes4
+    {
+        typedef __m128 V;
+        typedef __m128 M;
+        static const size_t Width = 4;
+
+        static V Load( const float* p ) { return _mm_loadu_ps( p ); }
+        static void Store( float* p, V v ) { _mm_storeu_ps( p, v ); }
+        static V Set( float f ) { return _mm_set1_ps( f ); }
+        static V Add( V a, V b ) { return _mm_add_ps( a, b ); }
+        static V Sub( V a, V b ) { return _mm_sub_ps( a, b ); }
+        static V Mul( V a, V b ) { return _mm_mul_ps( a, b ); }
+        static V Div( V a, V b ) { return _mm_div_ps( a, b ); }
+        static V Sqrt( V a ) { return _mm_sqrt_ps( a ); }
+        static V Min( V a, V b ) { return _mm_min_ps( a, b ); }
+        static V Max( V a, V b ) { return _mm_max_ps( a, b ); }
+        static V Abs( V a ) { return _mm_andnot_ps( _mm_set1_ps( -0.f ), a ); }
+        static M Less( V a, V b ) { return _mm_cmplt_ps( a, b ); }
+        static V Select( M m, V a, V b ) { return _mm_or_ps( _mm_and_ps( m, a ), _mm_andnot_ps( m, b ) ); }
+        static int Bits( M m ) { return _mm_movemask_ps( m ); }
+    };
+#endif
+
+#if defined(SPATIALIZER_USE_AVX)
+    struct Lanes8
+    {
+        typedef __m256 V;
+        typedef __m256 M;
+        static const size_t Width = 8;
+
+        static V Load( const float* p ) { return _mm256_loadu_ps( p ); }
+        static void Store( float* p, V v ) { _mm256_storeu_ps( p, v ); }
+        static V Set( float f ) { return _mm256_set1_ps( f ); }
+        static V Add( V a, V b ) { return _mm256_add_ps( a, b ); }
+        static V Sub( V a, V b ) { return _mm256_sub_ps( a, b ); }
+        static V Mul( V a, V b ) { return _mm256_mul_ps( a, b ); }
+        static V Div( V a, V b ) { return _mm256_div_ps( a, b ); }
+        static V Sqrt( V a ) { return _mm256_sqrt_ps( a ); }
+        static V Min( V a, V b ) { return _mm256_min_ps( a, b ); }
+        static V Max( V a, V b ) { return _mm256_max_ps( a, b ); }
+        static V Abs( V a ) { return _mm256_andnot_ps( _mm256_set1_ps( -0.f ), a ); }
+        static M Less( V a, V b ) { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+        static V Select( M m, V a, V b ) { return _mm256_blendv_ps( b, a, m ); }
+        static int Bits( M m ) { return _mm256_movemask_ps( m ); }
+    };
+#endif
+
+    // Arc cosine to within 7e-5 radians (Abramowitz & Stegun 4.4.45).
+    template<class L>
+    typename L::V Acos( typename L::V x )
+    {
+        typedef typename L::V V;
+        V a = L::Abs( x );
+        V poly = L::Add( L::Set( 0.0742610f ), L::Mul( a, L::Set( -0.0187293f ) ) );
+        poly = L::Add( L::Set( -0.2121144f ), L::Mul( a, poly ) );
+        poly = L::Add( L::Set( 1.5707288f ), L::Mul( a, poly ) );
+        V r = L::Mul( L::Sqrt( L::Sub( L::Set( 1.f ), a ) ), poly );
+        return L::Select( L::Less( x, L::Set( 0.f ) ), L::Sub( L::Set( Pi ), r ), r );
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Kernel
+    //----------------------------------------------------------------------------------
+
+    // Everything about the listener and settings that is the same for every emitter.
+    struct Frame
+    {
+        float   position[3];
+        float   velocity[3];
+        float   right[3];
+        float   curveDistanceScaler;
+        float   speedOfSound;
+        float   dopplerScaler;
+        float   maxSpeed;
+        float   minDoppler;
+        float   maxDoppler;
+        float   audibleVolume;
+        float   coneInner;          // Half angles
+        float   coneInvRange;
+        float   coneInnerVolume;
+        float   coneVolumeRange;
+    };
+
+    void MakeFrame( const BatchListener& listener, const BatchSpatializerSettings& settings, Frame& frame )
+    {
+        for( int j = 0; j < 3; ++j )
+        {
+            frame.position[ j ] = listener.position[ j ];
+            frame.velocity[ j ] = listener.velocity[ j ];
+        }
+
+        // Left-handed: top x front points to the listener's right.
+        const float* t = listener.orientTop;
+        const float* f = listener.orientFront;
+        frame.right[ 0 ] = t[ 1 ] * f[ 2 ] - t[ 2 ] * f[ 1 ];
+        frame.right[ 1 ] = t[ 2 ] * f[ 0 ] - t[ 0 ] * f[ 2 ];
+        frame.right[ 2 ] = t[ 0 ] * f[ 1 ] - t[ 1 ] * f[ 0 ];
+
+        frame.curveDistanceScaler = settings.curveDistanceScaler;
+        frame.speedOfSound = settings.speedOfSound;
+        frame.dopplerScaler = settings.dopplerScaler;
+        frame.maxSpeed = settings.speedOfSound * MaxProjectedSpeed;
+        frame.minDoppler = 1.f / settings.maxDoppler;
+        frame.maxDoppler = settings.maxDoppler;
+        frame.audibleVolume = settings.audibleVolume;
+
+        float inner = settings.coneInnerAngle * 0.5f;
+        float outer = settings.coneOuterAngle * 0.5f;
+        frame.coneInner = inner;
+        frame.coneInvRange = ( outer > inner ) ? 1.f / ( outer - inner ) : 1e30f;
+        frame.coneInnerVolume = settings.useCone ? settings.coneInnerVolume : 1.f;
+        frame.coneVolumeRange = settings.useCone ? settings.coneOuterVolume - settings.coneInnerVolume : 0.f;
+    }
+
+    // Spatializes L::Width emitters from index i; returns how many are audible,
+    // adding their indices to the audible list if there is one.
+    template<class L>
+    size_t SpatializeLanes( const Frame& frame, const BatchEmitters& e, bool useCone,
+                            BatchSpatializerOutput& out, size_t i, uint32_t* audible )
+    {
+        typedef typename L::V V;
+        const V zero = L::Set( 0.f );
+        const V one = L::Set( 1.f );
+
+        V dx = L::Sub( L::Load( e.positionX + i ), L::Set( frame.position[ 0 ] ) );
+        V dy = L::Sub( L::Load( e.positionY + i ), L::Set( frame.position[ 1 ] ) );
+        V dz = L::Sub( L::Load( e.positionZ + i ), L::Set( frame.position[ 2 ] ) );
+        V dist = L::Sqrt( L::Add( L::Add( L::Mul( dx, dx ), L::Mul( dy, dy ) ), L::Mul( dz, dz ) ) );
+
+        auto atListener = L::Less( dist, L::Set( MinDistance ) );
+        V inv = L::Div( one, L::Max( dist, L::Set( MinDistance ) ) );
+        V ux = L::Select( atListener, zero, L::Mul( dx, inv ) );
+        V uy = L::Select( atListener, zero, L::Mul( dy, inv ) );
+        V uz = L::Select( atListener, zero, L::Mul( dz, inv ) );
+
+        V volume = L::Min( one, L::Mul( L::Set( frame.curveDistanceScaler ), inv ) );
+
+        if ( useCone )
+        {
+            // The listener is at angle acos( front . -u ) off the emitter's axis.
+            V c = L::Add( L::Add( L::Mul( L::Load( e.frontX + i ), ux ), L::Mul( L::Load( e.frontY + i ), uy ) ),
+                          L::Mul( L::Load( e.frontZ + i ), uz ) );
+            c = L::Select( atListener, one, L::Sub( zero, c ) );
+            c = L::Max( L::Set( -1.f ), L::Min( one, c ) );
+
+            V t = L::Mul( L::Sub( Acos<L>( c ), L::Set( frame.coneInner ) ), L::Set( frame.coneInvRange ) );
+            t = L::Max( zero, L::Min( one, t ) );
+            volume = L::Mul( volume, L::Add( L::Set( frame.coneInnerVolume ), L::Mul( t, L::Set( frame.coneVolumeRange ) ) ) );
+        }
+
+        V pan = L::Add( L::Add( L::Mul( ux, L::Set( frame.right[ 0 ] ) ), L::Mul( uy, L::Set( frame.right[ 1 ] ) ) ),
+                        L::Mul( uz, L::Set( frame.right[ 2 ] ) ) );
+        pan = L::Max( L::Set( -1.f ), L::Min( one, pan ) );
+
+        if ( out.volume )
+            L::Store( out.volume + i, volume );
+
+        if ( out.pan )
+            L::Store( out.pan + i, pan );
+
+        if ( out.left || out.right )
+        {
+            const V half = L::Set( 0.5f );
+            V left = L::Mul( volume, L::Sqrt( L::Mul( L::Sub( one, pan ), half ) ) );
+            V right = L::Mul( volume, L::Sqrt( L::Mul( L::Add( one, pan ), half ) ) );
+            if ( out.left )
+                L::Store( out.left + i, left );
+            if ( out.right )
+                L::Store( out.right + i, right );
+        }
+
+        if ( out.doppler )
+        {
+            V doppler = one;
+            if ( frame.dopplerScaler > 0 )
+            {
+                const V scaler = L::Set( frame.dopplerScaler );
+                const V maxSpeed = L::Set( frame.maxSpeed );
+                const V minSpeed = L::Set( -frame.maxSpeed );
+
+                V vl = L::Add( L::Add( L::Mul( ux, L::Set( frame.velocity[ 0 ] ) ), L::Mul( uy, L::Set( frame.velocity[ 1 ] ) ) ),
+                               L::Mul( uz, L::Set( frame.velocity[ 2 ] ) ) );
+                vl = L::Max( minSpeed, L::Min( maxSpeed, L::Mul( vl, scaler ) ) );
+
+                V ve = zero;
+                if ( e.velocityX )
+                {
+                    ve = L::Add( L::Add( L::Mul( ux, L::Load( e.velocityX + i ) ), L::Mul( uy, L::Load( e.velocityY + i ) ) ),
+                                 L::Mul( uz, L::Load( e.velocityZ + i ) ) );
+                    ve = L::Max( minSpeed, L::Min( maxSpeed, L::Mul( ve, scaler ) ) );
+                }
+
+                const V c = L::Set( frame.speedOfSound );
+                doppler = L::Div( L::Add( c, vl ), L::Add( c, ve ) );
+                doppler = L::Max( L::Set( frame.minDoppler ), L::Min( L::Set( frame.maxDoppler ), doppler ) );
+            }
+            L::Store( out.doppler + i, doppler );
+        }
+
+        int bits = ~L::Bits( L::Less( volume, L::Set( frame.audibleVolume ) ) );
+
+        size_t added = 0;
+        for( size_t lane = 0; lane < L::Width; ++lane )
+        {
+            if ( bits & ( 1 << lane ) )
+            {
+                if ( audible )
+                    audible[ added ] = static_cast<uint32_t>( i + lane );
+                ++added;
+            }
+        }
+
+        return added;
+    }
+
+    void Validate( const BatchEmitters& emitters, const BatchSpatializerSettings& settings )
+    {
+        if ( emitters.count > 0 && ( !emitters.positionX || !emitters.positionY || !emitters.positionZ ) )
+            throw std::invalid_argument( "SpatializeBatch" );
+
+        if ( !emitters.velocityX != !emitters.velocityY || !emitters.velocityX != !emitters.velocityZ )
+            throw std::invalid_argument( "SpatializeBatch" );
+
+        if ( settings.useCone && emitters.count > 0 && ( !emitters.frontX || !emitters.frontY || !emitters.frontZ ) )
+            throw std::invalid_argument( "SpatializeBatch" );
+
+        if ( settings.curveDistanceScaler <= 0 || settings.speedOfSound <= 0 || settings.maxDoppler < 1
+             || settings.dopplerScaler < 0 || settings.coneOuterAngle < settings.coneInnerAngle )
+            throw std::invalid_argument( "SpatializeBatch" );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Spatializer
+//--------------------------------------------------------------------------------------
+
+void DirectX::GetDefaultBatchSpatializerSettings( BatchSpatializerSettings& settings )
+{
+    settings.curveDistanceScaler = 1.f;
+    settings.dopplerScaler = 1.f;
+    settings.speedOfSound = 343.5f;         // X3DAUDIO_SPEED_OF_SOUND
+    settings.maxDoppler = 2.f;              // XAUDIO2_DEFAULT_FREQ_RATIO
+    settings.audibleVolume = 0.f;
+    settings.useCone = false;
+    settings.coneInnerAngle = 0.f;
+    settings.coneOuterAngle = 0.f;
+    settings.coneInnerVolume = 1.f;
+    settings.coneOuterVolume = 1.f;
+}
+
+
+size_t DirectX::SpatializeBatch( const BatchListener& listener, const BatchEmitters& emitters,
+                                 const BatchSpatializerSettings& settings, BatchSpatializerOutput& output )
+{
+    Validate( emitters, settings );
+
+    Frame frame;
+    MakeFrame( listener, settings, frame );
+
+    const size_t count = emitters.count;
+    const bool useCone = settings.useCone;
+    uint32_t* audible = output.audible;
+    size_t audibleCount = 0;
+
+    size_t i = 0;
+
+#if defined(SPATIALIZER_USE_AVX)
+    for( ; i + 8 <= count; i += 8 )
+    {
+        audibleCount += SpatializeLanes<Lanes8>( frame, emitters, useCone, output, i, audible ? audible + audibleCount : nullptr );
+    }
+#endif
+
+#if defined(SPATIALIZER_USE_AVX) || defined(SPATIALIZER_USE_SSE)
+    for( ; i + 4 <= count; i += 4 )
+    {
+        audibleCount += SpatializeLanes<Lanes4>( frame, emitters, useCone, output, i, audible ? audible + audibleCount : nullptr );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        audibleCount += SpatializeLanes<Lanes1>( frame, emitters, useCone, output, i, audible ? audible + audibleCount : nullptr );
+    }
+
+    return audibleCount;
+}
+
+
+BatchSpatializerResult DirectX::SpatializeEmitter( const BatchListener& listener, const float position[3],
+                                                   const float* velocity, const float* front,
+                                                   const BatchSpatializerSettings& settings )
+{
+    BatchSpatializerResult result;
+
+    float d[3];
+    for( int j = 0; j < 3; ++j )
+    {
+        d[ j ] = position[ j ] - listener.position[ j ];
+    }
+    float dist = sqrtf( d[ 0 ] * d[ 0 ] + d[ 1 ] * d[ 1 ] + d[ 2 ] * d[ 2 ] );
+
+    float u[3] = { 0, 0, 0 };
+    if ( dist >= MinDistance )
+    {
+        for( int j = 0; j < 3; ++j )
+        {
+            u[ j ] = d[ j ] / dist;
+        }
+    }
+
+    result.volume = ( dist > settings.curveDistanceScaler ) ? settings.curveDistanceScaler / dist : 1.f;
+
+    if ( settings.useCone && front )
+    {
+        float c = ( dist >= MinDistance ) ? -( front[ 0 ] * u[ 0 ] + front[ 1 ] * u[ 1 ] + front[ 2 ] * u[ 2 ] ) : 1.f;
+        float angle = acosf( std::max( -1.f, std::min( 1.f, c ) ) );
+
+        float inner = settings.coneInnerAngle * 0.5f;
+        float outer = settings.coneOuterAngle * 0.5f;
+        float cone;
+        if ( angle <= inner )
+        {
+            cone = settings.coneInnerVolume;
+        }
+        else if ( angle >= outer )
+        {
+            cone = settings.coneOuterVolume;
+        }
+        else
+        {
+            float t = ( angle - inner ) / ( outer - inner );
+            cone = settings.coneInnerVolume + t * ( settings.coneOuterVolume - settings.coneInnerVolume );
+        }
+        result.volume *= cone;
+    }
+
+    const float* t = listener.orientTop;
+    const float* f = listener.orientFront;
+    float right[3] = { t[ 1 ] * f[ 2 ] - t[ 2 ] * f[ 1 ],
+                       t[ 2 ] * f[ 0 ] - t[ 0 ] * f[ 2 ],
+                       t[ 0 ] * f[ 1 ] - t[ 1 ] * f[ 0 ] };
+    result.pan = std::max( -1.f, std::min( 1.f, u[ 0 ] * right[ 0 ] + u[ 1 ] * right[ 1 ] + u[ 2 ] * right[ 2 ] ) );
+    result.left = result.volume * sqrtf( ( 1.f - result.pan ) * 0.5f );
+    result.right = result.volume * sqrtf( ( 1.f + result.pan ) * 0.5f );
+
+    result.doppler = 1.f;
+    if ( settings.dopplerScaler > 0 )
+    {
+        float maxSpeed = settings.speedOfSound * MaxProjectedSpeed;
+        const float* lv = listener.velocity;
+        float vl = ( u[ 0 ] * lv[ 0 ] + u[ 1 ] * lv[ 1 ] + u[ 2 ] * lv[ 2 ] ) * settings.dopplerScaler;
+        float ve = velocity ? ( u[ 0 ] * velocity[ 0 ] + u[ 1 ] * velocity[ 1 ] + u[ 2 ] * velocity[ 2 ] ) * settings.dopplerScaler : 0.f;
+        vl = std::max( -maxSpeed, std::min( maxSpeed, vl ) );
+        ve = std::max( -maxSpeed, std::min( maxSpeed, ve ) );
+
+        float doppler = ( settings.speedOfSound + vl ) / ( settings.speedOfSound + ve );
+        result.doppler = std::max( 1.f / settings.maxDoppler, std::min( settings.maxDoppler, doppler ) );
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+BatchSpatializerBenchmark DirectX::BenchmarkBatchSpatializer( size_t emitterCount, size_t iterations )
+{
+    // A field of debris out to 500 units, each piece drifting and facing somewhere.
+    std::vector<float> data( emitterCount * 9 );
+    float* px = &data[ 0 ];
+    float* py = px + emitterCount;
+    float* pz = py + emitterCount;
+    float* vx = pz + emitterCount;
+    float* vy = vx + emitterCount;
+    float* vz = vy + emitterCount;
+    float* fx = vz + emitterCount;
+    float* fy = fx + emitterCount;
+    float* fz = fy + emitterCount;
+
+    uint32_t seed = 12345;
+    auto random = [&]() -> float
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return float( seed >> 8 ) / float( 1 << 24 ) * 2.f - 1.f;
+    };
+
+    for( size_t j = 0; j < emitterCount; ++j )
+    {
+        px[ j ] = random() * 500.f;
+        py[ j ] = random() * 500.f;
+        pz[ j ] = random() * 500.f;
+        vx[ j ] = random() * 80.f;
+        vy[ j ] = random() * 80.f;
+        vz[ j ] = random() * 80.f;
+
+        float x = random(), y = random(), z = random();
+        float len = sqrtf( x * x + y * y + z * z );
+        if ( len < 1e-3f )
+        {
+            x = 0; y = 0; z = len = 1.f;
+        }
+        fx[ j ] = x / len;
+        fy[ j ] = y / len;
+        fz[ j ] = z / len;
+    }
+
+    BatchListener listener = {};
+    listener.position[ 0 ] = 10.f;
+    listener.velocity[ 2 ] = 40.f;
+    listener.orientFront[ 0 ] = 0.6f;
+    listener.orientFront[ 2 ] = 0.8f;
+    listener.orientTop[ 1 ] = 1.f;
+
+    BatchSpatializerSettings settings;
+    GetDefaultBatchSpatializerSettings( settings );
+    settings.curveDistanceScaler = 20.f;
+    settings.audibleVolume = 0.1f;
+    settings.useCone = true;
+    settings.coneInnerAngle = Pi / 2.f;
+    settings.coneOuterAngle = Pi * 1.5f;
+    settings.coneInnerVolume = 1.f;
+    settings.coneOuterVolume = 0.25f;
+
+    BatchEmitters emitters = { emitterCount, px, py, pz, vx, vy, vz, fx, fy, fz };
+
+    std::vector<float> results( emitterCount * 5 );
+    std::vector<uint32_t> audible( emitterCount );
+    BatchSpatializerOutput output;
+    output.volume = &results[ 0 ];
+    output.pan = output.volume + emitterCount;
+    output.left = output.pan + emitterCount;
+    output.right = output.left + emitterCount;
+    output.doppler = output.right + emitterCount;
+    output.audible = audible.empty() ? nullptr : &audible[ 0 ];
+
+    BatchSpatializerBenchmark result;
+    result.emitterCount = emitterCount;
+    result.audibleCount = 0;
+
+    iterations = std::max<size_t>( iterations, 1 );
+
+    double start = SteadyClock();
+    for( size_t j = 0; j < iterations; ++j )
+    {
+        result.audibleCount = SpatializeBatch( listener, emitters, settings, output );
+    }
+    double end = SteadyClock();
+
+    result.seconds = ( end - start ) / double( iterations );
+    result.emittersPerSecond = ( result.seconds > 0 ) ? double( emitterCount ) / result.seconds : 0;
+
+    std::vector<BatchSpatializerResult> reference( emitterCount );
+    start = SteadyClock();
+    for( size_t j = 0; j < emitterCount; ++j )
+    {
+        float position[3] = { px[ j ], py[ j ], pz[ j ] };
+        float velocity[3] = { vx[ j ], vy[ j ], vz[ j ] };
+        float front[3] = { fx[ j ], fy[ j ], fz[ j ] };
+        reference[ j ] = SpatializeEmitter( listener, position, velocity, front, settings );
+    }
+    end = SteadyClock();
+    result.referenceSeconds = end - start;
+
+    result.maxError = 0;
+    for( size_t j = 0; j < emitterCount; ++j )
+    {
+        const BatchSpatializerResult& r = reference[ j ];
+        result.maxError = std::max( result.maxError, fabsf( r.volume - output.volume[ j ] ) );
+        result.maxError = std::max( result.maxError, fabsf( r.pan - output.pan[ j ] ) );
+        result.maxError = std::max( result.maxError, fabsf( r.left - output.left[ j ] ) );
+        result.maxError = std::max( result.maxError, fabsf( r.right - output.right[ j ] ) );
+        result.maxError = std::max( result.maxError, fabsf( r.doppler - output.doppler[ j ] ) );
+    }
+
+    return result;
+}
@@ -0,0 +1,118 @@
+//--------------------------------------------------------------------------------------
+// File: BatchSpatializer.h
+//
+// Computes distance attenuation, emitter cones, stereo panning and Doppler for many
+// mono emitters around one listener at a time
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    // This follows the model X3DAudioCalculate applies to one AudioEmitter per
+    // call: an inverse distance curve starting at curveDistanceScaler, a linear
+    // cone between the inner and outer angles and Doppler from the velocities
+    // along the line between emitter and listener. Positions use the same
+    // left-handed coordinates as AudioListener.
+
+    struct BatchListener
+    {
+        float   position[3];
+        float   velocity[3];
+        float   orientFront[3];     // Unit length
+        float   orientTop[3];       // Unit length, at right angles to orientFront
+    };
+
+    // Structure of arrays, one entry per emitter. Velocities and fronts may be
+    // null for emitters that are all still or all omnidirectional.
+    struct BatchEmitters
+    {
+        size_t          count;
+        const float*    positionX;
+        const float*    positionY;
+        const float*    positionZ;
+        const float*    velocityX;
+        const float*    velocityY;
+        const float*    velocityZ;
+        const float*    frontX;     // Unit length; used only when the cone is enabled
+        const float*    frontY;
+        const float*    frontZ;
+    };
+
+    struct BatchSpatializerSettings
+    {
+        float   curveDistanceScaler;    // Full volume inside this distance, 1 / distance beyond
+        float   dopplerScaler;          // 0 turns Doppler off
+        float   speedOfSound;           // In world units per second
+        float   maxDoppler;             // Doppler factors are clamped to 1 / maxDoppler .. maxDoppler
+        float   audibleVolume;          // Emitters quieter than this are culled
+        bool    useCone;
+        float   coneInnerAngle;         // Full angles, in radians, as X3DAUDIO_CONE
+        float   coneOuterAngle;
+        float   coneInnerVolume;
+        float   coneOuterVolume;
+    };
+
+    // Defaults match X3DAudio's: X3DAUDIO_SPEED_OF_SOUND, no cone, and a Doppler
+    // range of XAUDIO2_DEFAULT_FREQ_RATIO.
+    void GetDefaultBatchSpatializerSettings( BatchSpatializerSettings& settings );
+
+    // Structure of arrays, count entries each. Any array may be null if it isn't
+    // wanted; audible needs room for every emitter.
+    struct BatchSpatializerOutput
+    {
+        float*      volume;     // Distance and cone attenuation, for SetVolume
+        float*      pan;        // -1 (left) .. 1 (right), for SetPan
+        float*      left;       // Constant-power stereo matrix, volume included
+        float*      right;
+        float*      doppler;    // Frequency ratio, for SetPitch or SetFrequencyRatio
+        uint32_t*   audible;    // Indices of emitters at or above audibleVolume, in order
+    };
+
+    // Spatializes every emitter. Returns the number of audible emitters.
+    size_t SpatializeBatch( const BatchListener& listener, const BatchEmitters& emitters,
+                            const BatchSpatializerSettings& settings, BatchSpatializerOutput& output );
+
+    struct BatchSpatializerResult
+    {
+        float   volume;
+        float   pan;
+        float   left;
+        float   right;
+        float   doppler;
+    };
+
+    // Spatializes one emitter in straightforward scalar code; SpatializeBatch
+    // agrees with it to within float rounding and its arc cosine approximation.
+    BatchSpatializerResult SpatializeEmitter( const BatchListener& listener, const float position[3],
+                                              const float* velocity, const float* front,
+                                              const BatchSpatializerSettings& settings );
+
+
+    struct BatchSpatializerBenchmark
+    {
+        size_t      emitterCount;
+        size_t      audibleCount;
+        double      seconds;                // Per SpatializeBatch call
+        double      emittersPerSecond;
+        double      referenceSeconds;       // Per pass of SpatializeEmitter over every emitter
+        float       maxError;               // Largest difference from SpatializeEmitter in any output
+    };
+
+    // Spatializes emitterCount moving, coned emitters scattered around a moving
+    // listener, iterations times, and checks the results against SpatializeEmitter.
+    BatchSpatializerBenchmark BenchmarkBatchSpatializer( size_t emitterCount, size_t iterations );
+}
@@ -0,0 +1,268 @@
+//--------------------------------------------------------------------------------------
+// File: MappedFile.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include "PlatformHelpers.h"
+
+#if defined(WINAPI_FAMILY) && (WINAPI_FAMILY == WINAPI_FAMILY_PHONE_APP) && (_WIN32_WINNT < 0x0603 /*_WIN32_WINNT_WINBLUE*/)
+#define MAPPEDFILE_USE_READ
+#elif defined(WINAPI_FAMILY) && (WINAPI_FAMILY != WINAPI_FAMILY_DESKTOP_APP)
+#define MAPPEDFILE_USE_FROMAPP
+#endif
+
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+
+//======================================================================================
+// MappedFile
+//======================================================================================
+
+// Internal object implementation class.
+class MappedFile::Impl
+{
+public:
+    Impl() :
+        mData( nullptr ),
+        mSize( 0 )
+    {
+    }
+
+    ~Impl()
+    {
+#if defined(MAPPEDFILE_USE_READ)
+        // mBuffer frees itself
+#elif defined(_WIN32)
+        if ( mData )
+            UnmapViewOfFile( mData );
+#else
+        if ( mData )
+            munmap( const_cast<uint8_t*>( mData ), mSize );
+#endif
+    }
+
+    bool Open( const MappedFileChar* fileName );
+
+    const uint8_t*                  mData;
+    size_t                          mSize;
+
+#ifdef MAPPEDFILE_USE_READ
+    std::unique_ptr<uint8_t[]>      mBuffer;
+#endif
+};
+
+
+#ifdef _WIN32
+
+bool MappedFile::Impl::Open( const MappedFileChar* fileName )
+{
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile( safe_handle( CreateFile2( fileName,
+                                                  GENERIC_READ,
+                                                  FILE_SHARE_READ,
+                                                  OPEN_EXISTING,
+                                                  nullptr ) ) );
+#else
+    ScopedHandle hFile( safe_handle( CreateFileW( fileName,
+                                                  GENERIC_READ,
+                                                  FILE_SHARE_READ,
+                                                  nullptr,
+                                                  OPEN_EXISTING,
+                                                  FILE_ATTRIBUTE_NORMAL,
+                                                  nullptr ) ) );
+#endif
+
+    if ( !hFile )
+        return false;
+
+    LARGE_INTEGER fileSize = { 0 };
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_VISTA)
+    FILE_STANDARD_INFO fileInfo;
+    if ( !GetFileInformationByHandleEx( hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo) ) )
+        return false;
+    fileSize = fileInfo.EndOfFile;
+#else
+    if ( !GetFileSizeEx( hFile.get(), &fileSize ) )
+        return false;
+#endif
+
+    if ( uint64_t( fileSize.QuadPart ) > SIZE_MAX )
+    {
+        SetLastError( ERROR_FILE_TOO_LARGE );
+        return false;
+    }
+
+    mSize = static_cast<size_t>( fileSize.QuadPart );
+
+    // Neither API maps an empty file.
+    if ( !mSize )
+        return true;
+
+#if defined(MAPPEDFILE_USE_READ)
+
+    if ( fileSize.HighPart > 0 )
+    {
+        SetLastError( ERROR_FILE_TOO_LARGE );
+        return false;
+    }
+
+    mBuffer.reset( new (std::nothrow) uint8_t[ mSize ] );
+    if ( !mBuffer )
+    {
+        SetLastError( ERROR_NOT_ENOUGH_MEMORY );
+        return false;
+    }
+
+    DWORD bytesRead = 0;
+    if ( !ReadFile( hFile.get(), mBuffer.get(), fileSize.LowPart, &bytesRead, nullptr ) )
+        return false;
+
+    if ( bytesRead < fileSize.LowPart )
+    {
+        SetLastError( ERROR_HANDLE_EOF );
+        return false;
+    }
+
+    mData = mBuffer.get();
+
+#else
+
+    // The view keeps the file and the mapping object alive, so their handles can
+    // close as soon as it exists.
+#if defined(MAPPEDFILE_USE_FROMAPP)
+    ScopedHandle hMapping( CreateFileMappingFromApp( hFile.get(), nullptr, PAGE_READONLY, 0, nullptr ) );
+#else
+    ScopedHandle hMapping( CreateFileMappingW( hFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr ) );
+#endif
+    if ( !hMapping )
+        return false;
+
+#if defined(MAPPEDFILE_USE_FROMAPP)
+    mData = static_cast<const uint8_t*>( MapViewOfFileFromApp( hMapping.get(), FILE_MAP_READ, 0, 0 ) );
+#else
+    mData = static_cast<const uint8_t*>( MapViewOfFile( hMapping.get(), FILE_MAP_READ, 0, 0, 0 ) );
+#endif
+    if ( !mData )
+        return false;
+
+#endif
+
+    return true;
+}
+
+#else // !_WIN32
+
+bool MappedFile::Impl::Open( const MappedFileChar* fileName )
+{
+    int fd = open( fileName, O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 )
+        return false;
+
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 )
+    {
+        int error = errno;
+        close( fd );
+        errno = error;
+        return false;
+    }
+
+    if ( uint64_t( info.st_size ) > SIZE_MAX )
+    {
+        close( fd );
+        errno = EFBIG;
+        return false;
+    }
+
+    mSize = static_cast<size_t>( info.st_size );
+
+    if ( mSize > 0 )
+    {
+        void* data = mmap( nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( data == MAP_FAILED )
+        {
+            int error = errno;
+            close( fd );
+            errno = error;
+            return false;
+        }
+
+        mData = static_cast<const uint8_t*>( data );
+    }
+
+    // The mapping holds its own reference to the file.
+    close( fd );
+    return true;
+}
+
+#endif
+
+
+//--------------------------------------------------------------------------------------
+// MappedFile
+//--------------------------------------------------------------------------------------
+
+MappedFile::MappedFile() :
+    pImpl( new Impl() )
+{
+}
+
+
+// Public destructor.
+MappedFile::~MappedFile()
+{
+}
+
+
+// Public methods.
+std::shared_ptr<const MappedFile> MappedFile::Open( const MappedFileChar* fileName )
+{
+    if ( !fileName )
+    {
+#ifdef _WIN32
+        SetLastError( ERROR_INVALID_PARAMETER );
+#else
+        errno = EINVAL;
+#endif
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedFile> file( new MappedFile() );
+    if ( !file->pImpl->Open( fileName ) )
+        return nullptr;
+
+    return file;
+}
+
+
+const uint8_t* MappedFile::GetData() const
+{
+    return pImpl->mData;
+}
+
+
+size_t MappedFile::GetSize() const
+{
+    return pImpl->mSize;
+}
@@ -0,0 +1,59 @@
+//--------------------------------------------------------------------------------------
+// File: MappedFile.h
+//
+// Read-only memory mapping of a whole file, shared by everything that points into it
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+
+namespace DirectX
+{
+    // Uses file mapping on Windows and mmap elsewhere. Windows Phone 8.0 has no
+    // file mapping for apps, so there the file is read into memory instead; the
+    // interface is the same.
+
+#ifdef _WIN32
+    typedef wchar_t MappedFileChar;
+#else
+    typedef char MappedFileChar;
+#endif
+
+    class MappedFile
+    {
+    public:
+        // Maps fileName read-only. Returns nullptr on failure, with the reason in
+        // GetLastError() on Windows and errno elsewhere. Pointers from GetData stay
+        // valid for as long as any copy of the returned pointer is held.
+        static std::shared_ptr<const MappedFile> Open( const MappedFileChar* fileName );
+
+        virtual ~MappedFile();
+
+        const uint8_t* GetData() const;     // nullptr for an empty file
+        size_t GetSize() const;
+
+    private:
+        MappedFile();
+
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        MappedFile(MappedFile const&);
+        MappedFile& operator= (MappedFile const&);
+    };
+}
@@ -0,0 +1,931 @@
+//--------------------------------------------------------------------------------------
+// File: ProceduralSynth.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "ProceduralSynth.h"
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// VS 2010 doesn't have <chrono>
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+#define SYNTH_USE_QPC
+#else
+#include <chrono>
+#endif
+
+using namespace DirectX;
+
+
+namespace
+{
+    const int MaxChannels = 2;
+
+    // Frames rendered per voice per pass; Render works through larger requests in passes of this size.
+    const size_t QuantumFrames = 256;
+
+    // Tonal oscillators and filter cutoffs stay below this fraction of the sample rate.
+    const float MaxTonalFrequency = 0.45f;
+
+    const float Pi = 3.14159265f;
+
+    double SteadyClock()
+    {
+#ifdef SYNTH_USE_QPC
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency( &frequency );
+        QueryPerformanceCounter( &counter );
+        return double( counter.QuadPart ) / double( frequency.QuadPart );
+#else
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+#endif
+    }
+
+    float Clamp( float value, float low, float high )
+    {
+        return std::min( high, std::max( low, value ) );
+    }
+
+    // Output gains for a mono voice panned to a stereo output. Matches the matrix
+    // SoundEffectInstanceBase::SetPan gives XAudio2 for SPEAKER_STEREO.
+    void ComputePan( float pan, float& left, float& right )
+    {
+        left = ( pan >= 0 ) ? ( 1.f - pan ) : 1.f;
+        right = ( pan <= 0 ) ? ( pan + 1.f ) : 1.f;
+    }
+
+    // xorshift32, -1 .. 1
+    float NextNoise( uint32_t& state )
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return float( int32_t( state ) ) * ( 1.f / 2147483648.f );
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Oscillators
+    //----------------------------------------------------------------------------------
+
+    // Band-limited step correction for the discontinuities in the square and saw
+    // waves (polynomial BLEP), which keeps high pitches from folding back down.
+    float PolyBlep( float t, float dt )
+    {
+        if ( t < dt )
+        {
+            t /= dt;
+            return t + t - t * t - 1.f;
+        }
+
+        if ( t > 1.f - dt )
+        {
+            t = ( t - 1.f ) / dt;
+            return t * t + t + t + 1.f;
+        }
+
+        return 0.f;
+    }
+
+    struct SineShape
+    {
+        // Parabolic sine with one correction step; within 0.1% of sinf.
+        static float Sample( float phase, float )
+        {
+            float x = 1.f - 2.f * phase;
+            float y = 4.f * x * ( 1.f - fabsf( x ) );
+            return y + 0.225f * ( y * fabsf( y ) - y );
+        }
+    };
+
+    struct TriangleShape
+    {
+        static float Sample( float phase, float )
+        {
+            return 1.f - 4.f * fabsf( phase - 0.5f );
+        }
+    };
+
+    struct SquareShape
+    {
+        static float Sample( float phase, float increment )
+        {
+            float half = phase + 0.5f;
+            if ( half >= 1.f )
+                half -= 1.f;
+
+            float s = ( phase < 0.5f ) ? 1.f : -1.f;
+            return s + PolyBlep( phase, increment ) - PolyBlep( half, increment );
+        }
+    };
+
+    struct SawShape
+    {
+        static float Sample( float phase, float increment )
+        {
+            return 2.f * phase - 1.f - PolyBlep( phase, increment );
+        }
+    };
+
+    struct Oscillator
+    {
+        SYNTH_WAVEFORM  waveform;
+        float           level;
+        float           phase;          // 0 .. 1
+        float           increment;      // Cycles per frame
+        float           endIncrement;
+        float           glide;          // Multiplies increment every frame while glideFrames > 0
+        uint32_t        glideFrames;
+        float           held;           // Noise value for this cycle
+    };
+
+    template<typename Shape>
+    void RunTonal( Oscillator& o, float* dest, size_t count, float glide )
+    {
+        float phase = o.phase;
+        float increment = o.increment;
+        float level = o.level;
+
+        for( size_t i = 0; i < count; ++i )
+        {
+            dest[ i ] += Shape::Sample( phase, increment ) * level;
+
+            phase += increment;
+            if ( phase >= 1.f )
+                phase -= 1.f;
+
+            increment *= glide;
+        }
+
+        o.phase = phase;
+        o.increment = increment;
+    }
+
+    void RunNoise( Oscillator& o, float* dest, size_t count, float glide, uint32_t& noise )
+    {
+        float phase = o.phase;
+        float increment = o.increment;
+        float level = o.level;
+        float held = o.held;
+
+        for( size_t i = 0; i < count; ++i )
+        {
+            dest[ i ] += held * level;
+
+            phase += increment;
+            if ( phase >= 1.f )
+            {
+                phase -= 1.f;
+                held = NextNoise( noise );
+            }
+
+            increment *= glide;
+        }
+
+        o.phase = phase;
+        o.increment = increment;
+        o.held = held;
+    }
+
+    void RunSegment( Oscillator& o, float* dest, size_t count, float glide, uint32_t& noise )
+    {
+        switch( o.waveform )
+        {
+        case SYNTH_WAVEFORM_SINE:       RunTonal<SineShape>( o, dest, count, glide ); break;
+        case SYNTH_WAVEFORM_TRIANGLE:   RunTonal<TriangleShape>( o, dest, count, glide ); break;
+        case SYNTH_WAVEFORM_SQUARE:     RunTonal<SquareShape>( o, dest, count, glide ); break;
+        case SYNTH_WAVEFORM_SAW:        RunTonal<SawShape>( o, dest, count, glide ); break;
+        default:                        RunNoise( o, dest, count, glide, noise ); break;
+        }
+    }
+
+    // dest[i] += oscillator output
+    void RunOscillator( Oscillator& o, float* dest, size_t count, uint32_t& noise )
+    {
+        size_t done = 0;
+
+        if ( o.glideFrames > 0 )
+        {
+            done = std::min( count, static_cast<size_t>( o.glideFrames ) );
+            RunSegment( o, dest, done, o.glide, noise );
+
+            o.glideFrames -= static_cast<uint32_t>( done );
+            if ( !o.glideFrames )
+                o.increment = o.endIncrement;
+        }
+
+        if ( done < count )
+        {
+            RunSegment( o, dest + done, count - done, 1.f, noise );
+        }
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Voices
+    //----------------------------------------------------------------------------------
+
+    enum ENVELOPE_STAGE
+    {
+        STAGE_ATTACK = 0,
+        STAGE_DECAY,
+        STAGE_SUSTAIN,
+        STAGE_RELEASE,
+        STAGE_DONE,
+    };
+
+    struct Voice
+    {
+        unsigned int    handle;             // 0 when free
+        uint16_t        generation;
+
+        Oscillator      oscillators[ SynthPatch::MaxOscillators ];
+        size_t          oscillatorCount;
+        uint32_t        noise;
+
+        // Envelope, advanced linearly a stage at a time
+        int             stage;
+        float           level;
+        float           step;
+        uint32_t        stageFrames;        // Left in this stage
+        uint32_t        decayFrames;
+        uint32_t        releaseFrames;
+        float           sustain;
+        uint32_t        holdFrames;         // Left before release; 0 holds until Release
+
+        // Topology-preserving state variable filter (Andrew Simper's form), with
+        // coefficients updated every ControlFrames
+        SYNTH_FILTER    filter;
+        float           cutoff;             // Cycles per frame
+        float           cutoffGlide;        // Multiplies cutoff every control block
+        uint32_t        cutoffGlideBlocks;
+        float           endCutoff;
+        float           damping;            // 2 - 2 * resonance, kept just above 0
+        float           ic1;
+        float           ic2;
+
+        float           gain;
+        float           left;
+        float           right;
+    };
+
+    void BeginRelease( Voice& v )
+    {
+        if ( v.stage >= STAGE_RELEASE )
+            return;
+
+        v.stage = STAGE_RELEASE;
+        v.stageFrames = v.releaseFrames;
+        v.step = -v.level / float( v.releaseFrames );
+        v.holdFrames = 0;
+    }
+
+    void NextStage( Voice& v )
+    {
+        switch( v.stage )
+        {
+        case STAGE_ATTACK:
+            v.stage = STAGE_DECAY;
+            v.level = 1.f;
+            v.stageFrames = v.decayFrames;
+            v.step = ( v.sustain - 1.f ) / float( v.decayFrames );
+            break;
+
+        case STAGE_DECAY:
+            if ( v.sustain <= 0 )
+            {
+                // Percussive: nothing left to hold.
+                v.stage = STAGE_DONE;
+                v.level = 0.f;
+                break;
+            }
+            v.stage = STAGE_SUSTAIN;
+            // fall through
+
+        case STAGE_SUSTAIN:
+            v.level = v.sustain;
+            v.step = 0.f;
+            v.stageFrames = UINT32_MAX;
+            break;
+
+        default:
+            v.stage = STAGE_DONE;
+            v.level = 0.f;
+            break;
+        }
+    }
+
+    // dest[i] *= envelope; returns false once the note has finished.
+    bool RunEnvelope( Voice& v, float* dest, size_t count )
+    {
+        size_t i = 0;
+        while ( i < count && v.stage != STAGE_DONE )
+        {
+            size_t run = std::min( count - i, static_cast<size_t>( v.stageFrames ) );
+            if ( v.holdFrames > 0 && v.stage < STAGE_RELEASE )
+                run = std::min( run, static_cast<size_t>( v.holdFrames ) );
+
+            float level = v.level;
+            float step = v.step;
+            for( size_t j = 0; j < run; ++j )
+            {
+                dest[ i + j ] *= level;
+                level += step;
+            }
+
+            v.level = level;
+            v.stageFrames -= static_cast<uint32_t>( run );
+            i += run;
+
+            if ( v.holdFrames > 0 && v.stage < STAGE_RELEASE )
+            {
+                v.holdFrames -= static_cast<uint32_t>( run );
+                if ( !v.holdFrames )
+                {
+                    BeginRelease( v );
+                    continue;
+                }
+            }
+
+            if ( !v.stageFrames )
+                NextStage( v );
+        }
+
+        if ( i < count )
+            memset( dest + i, 0, sizeof(float) * ( count - i ) );
+
+        return v.stage != STAGE_DONE;
+    }
+
+    void RunFilter( Voice& v, float* dest, size_t count )
+    {
+        for( size_t block = 0; block < count; block += ProceduralSynth::ControlFrames )
+        {
+            size_t n = std::min( count - block, static_cast<size_t>( ProceduralSynth::ControlFrames ) );
+
+            float g = tanf( Pi * v.cutoff );
+            float k = v.damping;
+            float a1 = 1.f / ( 1.f + g * ( g + k ) );
+            float a2 = g * a1;
+            float a3 = g * a2;
+
+            float ic1 = v.ic1;
+            float ic2 = v.ic2;
+            float* s = dest + block;
+
+            switch( v.filter )
+            {
+            case SYNTH_FILTER_LOWPASS:
+                for( size_t j = 0; j < n; ++j )
+                {
+                    float v3 = s[ j ] - ic2;
+                    float v1 = a1 * ic1 + a2 * v3;
+                    float v2 = ic2 + a2 * ic1 + a3 * v3;
+                    ic1 = 2.f * v1 - ic1;
+                    ic2 = 2.f * v2 - ic2;
+                    s[ j ] = v2;
+                }
+                break;
+
+            case SYNTH_FILTER_HIGHPASS:
+                for( size_t j = 0; j < n; ++j )
+                {
+                    float v0 = s[ j ];
+                    float v3 = v0 - ic2;
+                    float v1 = a1 * ic1 + a2 * v3;
+                    float v2 = ic2 + a2 * ic1 + a3 * v3;
+                    ic1 = 2.f * v1 - ic1;
+                    ic2 = 2.f * v2 - ic2;
+                    s[ j ] = v0 - k * v1 - v2;
+                }
+                break;
+
+            default:
+                for( size_t j = 0; j < n; ++j )
+                {
+                    float v3 = s[ j ] - ic2;
+                    float v1 = a1 * ic1 + a2 * v3;
+                    float v2 = ic2 + a2 * ic1 + a3 * v3;
+                    ic1 = 2.f * v1 - ic1;
+                    ic2 = 2.f * v2 - ic2;
+                    s[ j ] = v1;
+                }
+                break;
+            }
+
+            v.ic1 = ic1;
+            v.ic2 = ic2;
+
+            if ( v.cutoffGlideBlocks > 0 )
+            {
+                v.cutoff = ( --v.cutoffGlideBlocks > 0 ) ? v.cutoff * v.cutoffGlide : v.endCutoff;
+            }
+        }
+    }
+
+    uint32_t SecondsToFrames( float seconds, int sampleRate )
+    {
+        double frames = double( std::max( 0.f, seconds ) ) * sampleRate;
+        return static_cast<uint32_t>( std::min( frames, double( UINT32_MAX - 1 ) ) );
+    }
+
+    // Increment that takes from to to over frames, one multiply per frame.
+    float GlideFactor( float from, float to, uint32_t frames )
+    {
+        return powf( to / from, 1.f / float( frames ) );
+    }
+}
+
+
+//======================================================================================
+// ProceduralSynth
+//======================================================================================
+
+// Internal object implementation class.
+class ProceduralSynth::Impl
+{
+public:
+    Impl( int sampleRate, int channels, size_t maxVoices ) :
+        mSampleRate( sampleRate ),
+        mChannels( channels ),
+        mPlaying( 0 )
+    {
+        memset( &mStats, 0, sizeof(mStats) );
+
+        Voice v;
+        memset( &v, 0, sizeof(Voice) );
+        v.stage = STAGE_DONE;
+        mVoices.resize( maxVoices, v );
+
+        mScratch.resize( QuantumFrames );
+    }
+
+    Voice* Find( unsigned int handle );
+    size_t TakeSlot();
+    void Start( Voice& v, const SynthPatch& patch, float volume, float pan );
+    void Free( Voice& v );
+    void RenderQuantum( float* output, size_t frameCount );
+
+    int                     mSampleRate;
+    int                     mChannels;
+    size_t                  mPlaying;
+    std::vector<Voice>      mVoices;
+    std::vector<float>      mScratch;   // One voice, one quantum
+    ProceduralSynthStatistics mStats;
+};
+
+
+Voice* ProceduralSynth::Impl::Find( unsigned int handle )
+{
+    size_t slot = ( handle & 0xFFFF );
+    if ( !slot || slot > mVoices.size() )
+        return nullptr;
+
+    Voice& v = mVoices[ slot - 1 ];
+    return ( v.handle == handle ) ? &v : nullptr;
+}
+
+
+size_t ProceduralSynth::Impl::TakeSlot()
+{
+    size_t quietest = 0;
+    float quietestLevel = FLT_MAX;
+
+    for( size_t j = 0; j < mVoices.size(); ++j )
+    {
+        const Voice& v = mVoices[ j ];
+        if ( !v.handle )
+            return j;
+
+        float level = v.level * v.gain;
+        if ( level < quietestLevel )
+        {
+            quietest = j;
+            quietestLevel = level;
+        }
+    }
+
+    ++mStats.notesStolen;
+    Free( mVoices[ quietest ] );
+    return quietest;
+}
+
+
+void ProceduralSynth::Impl::Start( Voice& v, const SynthPatch& patch, float volume, float pan )
+{
+    float rate = float( mSampleRate );
+
+    v.oscillatorCount = 0;
+    for( size_t j = 0; j < SynthPatch::MaxOscillators; ++j )
+    {
+        const SynthOscillator& src = patch.oscillators[ j ];
+        if ( src.level == 0 || src.frequency <= 0 )
+            continue;
+
+        // Noise may change value every frame; anything tonal stays clear of Nyquist.
+        float maxIncrement = ( src.waveform == SYNTH_WAVEFORM_NOISE ) ? 1.f : MaxTonalFrequency;
+
+        Oscillator& o = v.oscillators[ v.oscillatorCount++ ];
+        o.waveform = src.waveform;
+        o.level = src.level;
+        o.phase = 0.f;
+        o.increment = Clamp( src.frequency / rate, 1e-6f, maxIncrement );
+        o.endIncrement = ( src.endFrequency > 0 ) ? Clamp( src.endFrequency / rate, 1e-6f, maxIncrement ) : o.increment;
+        o.glideFrames = SecondsToFrames( src.glideTime, mSampleRate );
+        o.glide = 1.f;
+        o.held = NextNoise( v.noise );
+
+        if ( o.glideFrames > 0 && o.endIncrement != o.increment )
+            o.glide = GlideFactor( o.increment, o.endIncrement, o.glideFrames );
+        else
+            o.glideFrames = 0;
+    }
+
+    v.stage = STAGE_ATTACK;
+    v.level = 0.f;
+    v.sustain = Clamp( patch.amplitude.sustain, 0.f, 1.f );
+    v.stageFrames = std::max<uint32_t>( 1, SecondsToFrames( patch.amplitude.attack, mSampleRate ) );
+    v.step = 1.f / float( v.stageFrames );
+    v.decayFrames = std::max<uint32_t>( 1, SecondsToFrames( patch.amplitude.decay, mSampleRate ) );
+    v.releaseFrames = std::max<uint32_t>( 1, SecondsToFrames( patch.amplitude.release, mSampleRate ) );
+    v.holdFrames = ( patch.holdTime > 0 ) ? std::max<uint32_t>( 1, SecondsToFrames( patch.holdTime, mSampleRate ) ) : 0;
+
+    v.filter = patch.filter;
+    v.ic1 = v.ic2 = 0.f;
+    v.cutoffGlideBlocks = 0;
+    if ( v.filter != SYNTH_FILTER_NONE )
+    {
+        float low = 20.f / rate;
+        v.cutoff = Clamp( patch.cutoff / rate, low, MaxTonalFrequency );
+        v.endCutoff = ( patch.endCutoff > 0 ) ? Clamp( patch.endCutoff / rate, low, MaxTonalFrequency ) : v.cutoff;
+        v.cutoffGlide = 1.f;
+        v.damping = 2.f - 1.96f * Clamp( patch.resonance, 0.f, 1.f );
+
+        uint32_t blocks = SecondsToFrames( patch.cutoffGlideTime, mSampleRate ) / ControlFrames;
+        if ( blocks > 0 && v.endCutoff != v.cutoff )
+        {
+            v.cutoffGlideBlocks = blocks;
+            v.cutoffGlide = GlideFactor( v.cutoff, v.endCutoff, blocks );
+        }
+    }
+
+    v.gain = std::max( 0.f, volume * patch.volume );
+    if ( mChannels == 2 )
+    {
+        ComputePan( Clamp( pan, -1.f, 1.f ), v.left, v.right );
+        v.left *= v.gain;
+        v.right *= v.gain;
+    }
+    else
+    {
+        v.left = v.right = v.gain;
+    }
+}
+
+
+void ProceduralSynth::Impl::Free( Voice& v )
+{
+    if ( v.handle )
+    {
+        v.handle = 0;
+        v.stage = STAGE_DONE;
+        assert( mPlaying > 0 );
+        --mPlaying;
+    }
+}
+
+
+void ProceduralSynth::Impl::RenderQuantum( float* output, size_t frameCount )
+{
+    memset( output, 0, sizeof(float) * frameCount * mChannels );
+
+    if ( !mPlaying )
+        return;
+
+    float* scratch = &mScratch[ 0 ];
+
+    for( auto it = mVoices.begin(); it != mVoices.end(); ++it )
+    {
+        Voice& v = *it;
+        if ( !v.handle )
+            continue;
+
+        memset( scratch, 0, sizeof(float) * frameCount );
+
+        for( size_t j = 0; j < v.oscillatorCount; ++j )
+        {
+            RunOscillator( v.oscillators[ j ], scratch, frameCount, v.noise );
+        }
+
+        if ( v.filter != SYNTH_FILTER_NONE )
+            RunFilter( v, scratch, frameCount );
+
+        bool playing = RunEnvelope( v, scratch, frameCount );
+
+        if ( mChannels == 2 )
+        {
+            float left = v.left;
+            float right = v.right;
+            for( size_t i = 0; i < frameCount; ++i )
+            {
+                output[ i * 2 ] += scratch[ i ] * left;
+                output[ i * 2 + 1 ] += scratch[ i ] * right;
+            }
+        }
+        else
+        {
+            float gain = v.gain;
+            for( size_t i = 0; i < frameCount; ++i )
+            {
+                output[ i ] += scratch[ i ] * gain;
+            }
+        }
+
+        if ( !playing )
+            Free( v );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// ProceduralSynth
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+ProceduralSynth::ProceduralSynth( int sampleRate, int channels, size_t maxVoices )
+{
+    // Handles keep the slot in their low 16 bits.
+    if ( sampleRate <= 0 || channels < 1 || channels > MaxChannels || !maxVoices || maxVoices > 0xFFFF )
+        throw std::invalid_argument( "ProceduralSynth" );
+
+    pImpl.reset( new Impl( sampleRate, channels, maxVoices ) );
+}
+
+
+// Move constructor.
+ProceduralSynth::ProceduralSynth(ProceduralSynth&& moveFrom)
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+ProceduralSynth& ProceduralSynth::operator= (ProceduralSynth&& moveFrom)
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+ProceduralSynth::~ProceduralSynth()
+{
+}
+
+
+// Public methods.
+unsigned int ProceduralSynth::Play( const SynthPatch& patch, float volume, float pan )
+{
+    size_t slot = pImpl->TakeSlot();
+    Voice& v = pImpl->mVoices[ slot ];
+
+    ++pImpl->mStats.notesPlayed;
+
+    // A different noise sequence for every note, so repeated shots don't sound sampled.
+    v.noise = 0x9E3779B9u * static_cast<uint32_t>( pImpl->mStats.notesPlayed );
+    if ( !v.noise )
+        v.noise = 1;
+
+    pImpl->Start( v, patch, volume, pan );
+
+    ++v.generation;
+    v.handle = ( static_cast<unsigned int>( v.generation ) << 16 ) | static_cast<unsigned int>( slot + 1 );
+    ++pImpl->mPlaying;
+    return v.handle;
+}
+
+
+void ProceduralSynth::Release( unsigned int voice )
+{
+    Voice* v = pImpl->Find( voice );
+    if ( v )
+        BeginRelease( *v );
+}
+
+
+void ProceduralSynth::Stop( unsigned int voice )
+{
+    Voice* v = pImpl->Find( voice );
+    if ( v )
+        pImpl->Free( *v );
+}
+
+
+void ProceduralSynth::StopAll()
+{
+    for( auto it = pImpl->mVoices.begin(); it != pImpl->mVoices.end(); ++it )
+    {
+        pImpl->Free( *it );
+    }
+}
+
+
+bool ProceduralSynth::IsPlaying( unsigned int voice ) const
+{
+    return pImpl->Find( voice ) != nullptr;
+}
+
+
+void ProceduralSynth::Render( float* output, size_t frameCount )
+{
+    while ( frameCount > 0 )
+    {
+        size_t count = std::min( frameCount, QuantumFrames );
+        pImpl->RenderQuantum( output, count );
+        pImpl->mStats.framesRendered += count;
+        output += count * pImpl->mChannels;
+        frameCount -= count;
+    }
+}
+
+
+ProceduralSynthStatistics ProceduralSynth::GetStatistics() const
+{
+    ProceduralSynthStatistics stats = pImpl->mStats;
+    stats.playingVoices = pImpl->mPlaying;
+    stats.maxVoices = pImpl->mVoices.size();
+    return stats;
+}
+
+
+int ProceduralSynth::GetSampleRate() const
+{
+    return pImpl->mSampleRate;
+}
+
+
+int ProceduralSynth::GetOutputChannels() const
+{
+    return pImpl->mChannels;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Patches
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+    void SetOscillator( SynthOscillator& o, SYNTH_WAVEFORM waveform, float level, float frequency, float endFrequency, float glideTime )
+    {
+        o.waveform = waveform;
+        o.level = level;
+        o.frequency = frequency;
+        o.endFrequency = endFrequency;
+        o.glideTime = glideTime;
+    }
+
+    void SetEnvelope( SynthEnvelope& e, float attack, float decay, float sustain, float release )
+    {
+        e.attack = attack;
+        e.decay = decay;
+        e.sustain = sustain;
+        e.release = release;
+    }
+
+    void SetFilter( SynthPatch& patch, SYNTH_FILTER filter, float cutoff, float endCutoff, float glideTime, float resonance )
+    {
+        patch.filter = filter;
+        patch.cutoff = cutoff;
+        patch.endCutoff = endCutoff;
+        patch.cutoffGlideTime = glideTime;
+        patch.resonance = resonance;
+    }
+}
+
+
+void DirectX::GetWeaponPatch( int weaponType, float energy, SynthPatch& patch )
+{
+    memset( &patch, 0, sizeof(SynthPatch) );
+
+    float e = Clamp( energy, 0.f, 1.f );
+
+    switch( weaponType )
+    {
+    case 0:
+        // Light twin laser: a quick falling square with a slightly detuned saw.
+        SetOscillator( patch.oscillators[ 0 ], SYNTH_WAVEFORM_SQUARE, 0.6f, 1800.f + 800.f * e, 300.f, 0.12f );
+        SetOscillator( patch.oscillators[ 1 ], SYNTH_WAVEFORM_SAW, 0.35f, 1820.f + 800.f * e, 310.f, 0.12f );
+        SetFilter( patch, SYNTH_FILTER_LOWPASS, 6000.f + 4000.f * e, 1500.f, 0.15f, 0.3f );
+        SetEnvelope( patch.amplitude, 0.002f, 0.12f + 0.05f * e, 0.f, 0.02f );
+        patch.volume = 0.5f + 0.3f * e;
+        break;
+
+    case 1:
+        // Continuous beam: beating saws and an octave sine through a rising band-pass.
+        SetOscillator( patch.oscillators[ 0 ], SYNTH_WAVEFORM_SAW, 0.45f, 110.f + 40.f * e, 0.f, 0.f );
+        SetOscillator( patch.oscillators[ 1 ], SYNTH_WAVEFORM_SAW, 0.45f, 110.8f + 40.3f * e, 0.f, 0.f );
+        SetOscillator( patch.oscillators[ 2 ], SYNTH_WAVEFORM_SINE, 0.4f, 220.f + 80.f * e, 0.f, 0.f );
+        SetFilter( patch, SYNTH_FILTER_BANDPASS, 900.f + 900.f * e, 1800.f + 1200.f * e, 0.3f, 0.6f );
+        SetEnvelope( patch.amplitude, 0.03f, 0.1f, 0.7f, 0.12f );
+        patch.volume = 0.7f + 0.3f * e;
+        break;
+
+    default:
+        // Heavy single shot: a sine thump, a falling saw and a burst of noise.
+        SetOscillator( patch.oscillators[ 0 ], SYNTH_WAVEFORM_SINE, 0.8f, 220.f + 80.f * e, 45.f, 0.35f );
+        SetOscillator( patch.oscillators[ 1 ], SYNTH_WAVEFORM_SAW, 0.4f, 440.f + 160.f * e, 80.f, 0.25f );
+        SetOscillator( patch.oscillators[ 2 ], SYNTH_WAVEFORM_NOISE, 0.5f, 16000.f, 3000.f, 0.2f );
+        SetFilter( patch, SYNTH_FILTER_LOWPASS, 5000.f + 5000.f * e, 400.f, 0.3f, 0.25f );
+        SetEnvelope( patch.amplitude, 0.003f, 0.35f + 0.25f * e, 0.f, 0.05f );
+        patch.volume = 0.4f + 0.15f * e;
+        break;
+    }
+}
+
+
+void DirectX::GetExplosionPatch( float energy, SynthPatch& patch )
+{
+    memset( &patch, 0, sizeof(SynthPatch) );
+
+    float e = Clamp( energy, 0.f, 1.f );
+
+    // Bright noise that darkens as it falls, a low sine thump and a slow crackle.
+    SetOscillator( patch.oscillators[ 0 ], SYNTH_WAVEFORM_NOISE, 0.9f, 12000.f + 12000.f * e, 600.f, 0.6f + e );
+    SetOscillator( patch.oscillators[ 1 ], SYNTH_WAVEFORM_SINE, 0.7f, 90.f - 30.f * e, 30.f, 0.3f + 0.3f * e );
+    SetOscillator( patch.oscillators[ 2 ], SYNTH_WAVEFORM_NOISE, 0.4f, 400.f, 60.f, 1.f );
+    SetFilter( patch, SYNTH_FILTER_LOWPASS, 3000.f + 6000.f * e, 150.f, 0.5f + e, 0.2f );
+    SetEnvelope( patch.amplitude, 0.004f, 0.5f + 1.5f * e, 0.f, 0.1f );
+    patch.volume = 0.35f + 0.2f * e;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+ProceduralSynthBenchmark DirectX::BenchmarkProceduralSynth( size_t voiceCount, double audioSeconds )
+{
+    const int sampleRate = 48000;
+    const size_t blockFrames = 480;     // 10 ms, as a device callback would ask for
+
+    voiceCount = std::max<size_t>( 1, std::min<size_t>( voiceCount, 0xFFFF ) );
+
+    ProceduralSynth synth( sampleRate, 2, voiceCount );
+
+    // Every weapon at two energies and explosions at three; beams are given a
+    // hold time so they take their turn like the rest.
+    const size_t patchCount = 9;
+    SynthPatch patches[ patchCount ];
+    for( int j = 0; j < 3; ++j )
+    {
+        GetWeaponPatch( j, 0.3f, patches[ j * 2 ] );
+        GetWeaponPatch( j, 1.f, patches[ j * 2 + 1 ] );
+    }
+    patches[ 2 ].holdTime = patches[ 3 ].holdTime = 0.5f;
+    GetExplosionPatch( 0.2f, patches[ 6 ] );
+    GetExplosionPatch( 0.6f, patches[ 7 ] );
+    GetExplosionPatch( 1.f, patches[ 8 ] );
+
+    size_t totalFrames = static_cast<size_t>( audioSeconds * sampleRate );
+    std::vector<float> sink( totalFrames * 2 );
+
+    size_t next = 0;
+    float volume = 1.f / float( voiceCount );
+
+    double start = SteadyClock();
+    for( size_t done = 0; done < totalFrames; done += blockFrames )
+    {
+        for( size_t playing = synth.GetStatistics().playingVoices; playing < voiceCount; ++playing, ++next )
+        {
+            synth.Play( patches[ next % patchCount ], volume, float( next % 9 ) / 4.f - 1.f );
+        }
+
+        synth.Render( &sink[ done * 2 ], std::min( blockFrames, totalFrames - done ) );
+    }
+    double end = SteadyClock();
+
+    ProceduralSynthBenchmark result;
+    result.voiceCount = voiceCount;
+    result.audioSeconds = double( totalFrames ) / sampleRate;
+    result.renderSeconds = end - start;
+    result.realTimeFraction = ( result.audioSeconds > 0 ) ? result.renderSeconds / result.audioSeconds : 0;
+    result.voicesPerCore = ( result.realTimeFraction > 0 ) ? double( voiceCount ) / result.realTimeFraction : 0;
+    return result;
+}
@@ -0,0 +1,153 @@
+//--------------------------------------------------------------------------------------
+// File: ProceduralSynth.h
+//
+// Renders weapon and explosion sounds from oscillators, noise, ADSR envelopes and
+// filters instead of sample files
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+
+namespace DirectX
+{
+    // Every voice is allocated up front: Play, Release and Render never touch the
+    // heap, so Render can run inside a DynamicSoundEffectInstance BufferNeeded
+    // callback (see SynthSoundEffect).
+
+    enum SYNTH_WAVEFORM
+    {
+        SYNTH_WAVEFORM_SINE = 0,
+        SYNTH_WAVEFORM_TRIANGLE,
+        SYNTH_WAVEFORM_SQUARE,
+        SYNTH_WAVEFORM_SAW,
+        SYNTH_WAVEFORM_NOISE,       // A new random value every cycle; at the sample rate, white noise
+    };
+
+    enum SYNTH_FILTER
+    {
+        SYNTH_FILTER_NONE = 0,
+        SYNTH_FILTER_LOWPASS,
+        SYNTH_FILTER_HIGHPASS,
+        SYNTH_FILTER_BANDPASS,
+    };
+
+    struct SynthOscillator
+    {
+        SYNTH_WAVEFORM  waveform;
+        float           level;          // 0 leaves the oscillator out
+        float           frequency;      // Hz at the start of the note
+        float           endFrequency;   // Reached exponentially after glideTime
+        float           glideTime;      // Seconds; 0 stays at frequency
+    };
+
+    struct SynthEnvelope
+    {
+        float   attack;     // Seconds
+        float   decay;      // Seconds
+        float   sustain;    // Level, 0 .. 1
+        float   release;    // Seconds
+    };
+
+    struct SynthPatch
+    {
+        static const size_t MaxOscillators = 3;
+
+        SynthOscillator oscillators[ MaxOscillators ];
+        SynthEnvelope   amplitude;
+        float           holdTime;           // Seconds from the start before release; 0 holds until Release
+        SYNTH_FILTER    filter;             // Applied to the sum of the oscillators
+        float           cutoff;             // Hz at the start of the note
+        float           endCutoff;          // Reached exponentially after cutoffGlideTime
+        float           cutoffGlideTime;    // Seconds; 0 stays at cutoff
+        float           resonance;          // 0 .. 1
+        float           volume;
+    };
+
+    // Weapon types follow Laser::type in the game: 0 is the light twin laser, 1 the
+    // continuous beam (held until Release) and anything else the heavy single shot.
+    // energy is 0 .. 1 and raises weight, brightness and length.
+    void GetWeaponPatch( int weaponType, float energy, SynthPatch& patch );
+
+    // energy 0 .. 1 runs from a small rock cracking to a large asteroid breaking up.
+    void GetExplosionPatch( float energy, SynthPatch& patch );
+
+    struct ProceduralSynthStatistics
+    {
+        size_t      playingVoices;
+        size_t      maxVoices;
+        uint64_t    notesPlayed;
+        uint64_t    notesStolen;        // Played over the quietest voice because all were busy
+        uint64_t    framesRendered;
+    };
+
+    class ProceduralSynth
+    {
+    public:
+        // Frames of envelope and filter glide between coefficient updates.
+        static const size_t ControlFrames = 16;
+
+        // channels is 1 or 2; output from Render is interleaved.
+        ProceduralSynth( int sampleRate, int channels, size_t maxVoices );
+
+        ProceduralSynth(ProceduralSynth&& moveFrom);
+        ProceduralSynth& operator= (ProceduralSynth&& moveFrom);
+        virtual ~ProceduralSynth();
+
+        // Starts a note. With every voice busy, the quietest one is taken. Returns
+        // a handle for Release and Stop, which is never 0. As SoundEffectInstance::SetPan,
+        // -1 is left and 1 is right.
+        unsigned int Play( const SynthPatch& patch, float volume = 1.f, float pan = 0.f );
+
+        // Starts the release of a note. Handles of finished or stolen notes are ignored.
+        void Release( unsigned int voice );
+
+        void Stop( unsigned int voice );
+        void StopAll();
+        bool IsPlaying( unsigned int voice ) const;
+
+        // Renders every playing note into frameCount interleaved frames, replacing
+        // what output held.
+        void Render( float* output, size_t frameCount );
+
+        ProceduralSynthStatistics GetStatistics() const;
+
+        int GetSampleRate() const;
+        int GetOutputChannels() const;
+
+    private:
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        ProceduralSynth(ProceduralSynth const&);
+        ProceduralSynth& operator= (ProceduralSynth const&);
+    };
+
+
+    struct ProceduralSynthBenchmark
+    {
+        size_t      voiceCount;
+        double      audioSeconds;       // Audio rendered
+        double      renderSeconds;      // Time it took
+        double      realTimeFraction;   // renderSeconds / audioSeconds
+        double      voicesPerCore;      // voiceCount / realTimeFraction
+    };
+
+    // Keeps voiceCount weapon and explosion notes playing, replacing each as it
+    // finishes, for audioSeconds of 48 kHz stereo and times it on one thread.
+    ProceduralSynthBenchmark BenchmarkProceduralSynth( size_t voiceCount, double audioSeconds );
+}
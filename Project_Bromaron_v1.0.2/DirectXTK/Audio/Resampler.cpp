@@ -0,0 +1,601 @@
+//--------------------------------------------------------------------------------------
+// File: Resampler.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Resampler.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// VS 2010 doesn't have <chrono>
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+#define RESAMPLER_USE_QPC
+#else
+#include <chrono>
+#endif
+
+#if defined(__AVX__)
+#define RESAMPLER_USE_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define RESAMPLER_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace DirectX;
+
+
+namespace
+{
+    struct FilterDesign
+    {
+        size_t  taps;
+        size_t  phases;     // Rows in the table; coefficients are interpolated between them.
+        double  cutoff;     // Fraction of the lower Nyquist frequency passed
+        double  beta;       // Kaiser window shape
+    };
+
+    const FilterDesign Designs[] =
+    {
+        {  2,   1, 1.0,   0 },      // RESAMPLER_QUALITY_LINEAR
+        {  8,  64, 0.80,  6 },      // RESAMPLER_QUALITY_LOW
+        { 16, 128, 0.88,  8 },      // RESAMPLER_QUALITY_MEDIUM
+        { 32, 256, 0.92, 10 },      // RESAMPLER_QUALITY_HIGH
+    };
+
+    // Input buffered beyond the filter length, so most of a call is converted
+    // between moves of the history.
+    const size_t HistoryBlockFrames = 1024;
+
+    // Downsampling narrows the filter in steps of a half octave, each step's table
+    // built the first time it's needed.
+    const int TableStepsPerOctave = 2;
+    const int MaxTables = 8 * TableStepsPerOctave + 1;     // log2( MaxRatio ) steps
+
+    const double Pi = 3.14159265358979323846;
+
+    double SteadyClock()
+    {
+#ifdef RESAMPLER_USE_QPC
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency( &frequency );
+        QueryPerformanceCounter( &counter );
+        return double( counter.QuadPart ) / double( frequency.QuadPart );
+#else
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+#endif
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Filter design
+    //----------------------------------------------------------------------------------
+
+    // Zeroth-order modified Bessel function of the first kind, for the Kaiser window.
+    double BesselI0( double x )
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for( int k = 1; k < 50; ++k )
+        {
+            term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+            sum += term;
+            if ( term < sum * 1e-12 )
+                break;
+        }
+        return sum;
+    }
+
+    // Table rows are phases 0 .. phases inclusive, taps coefficients each. Row p is
+    // the filter for an output that falls p / phases of a frame after tap taps / 2 - 1.
+    std::vector<float> BuildTable( const FilterDesign& design, double ratio )
+    {
+        const size_t taps = design.taps;
+        const size_t phases = design.phases;
+        const double half = double( taps / 2 );
+
+        // Downsampling moves the cutoff down to the output's Nyquist frequency.
+        double cutoff = design.cutoff / std::max( 1.0, ratio );
+
+        std::vector<float> table( ( phases + 1 ) * taps );
+        for( size_t p = 0; p <= phases; ++p )
+        {
+            double frac = double( p ) / double( phases );
+            float* row = &table[ p * taps ];
+
+            double sum = 0;
+            for( size_t k = 0; k < taps; ++k )
+            {
+                double t = double( k ) - ( half - 1.0 ) - frac;
+                double value;
+                if ( taps == 2 )
+                {
+                    value = 1.0 - fabs( t );
+                }
+                else
+                {
+                    double x = t / half;
+                    double window = ( fabs( x ) < 1.0 ) ? BesselI0( design.beta * sqrt( 1.0 - x * x ) ) / BesselI0( design.beta ) : 0.0;
+                    double sinc = ( t == 0 ) ? 1.0 : sin( Pi * t * cutoff ) / ( Pi * t * cutoff );
+                    value = sinc * window;
+                }
+                row[ k ] = float( value );
+                sum += value;
+            }
+
+            // Unity gain at DC for every phase, so a constant input stays constant.
+            for( size_t k = 0; k < taps; ++k )
+            {
+                row[ k ] = float( row[ k ] / sum );
+            }
+        }
+
+        return table;
+    }
+
+    int TableIndex( double ratio )
+    {
+        if ( ratio <= 1.0 )
+            return 0;
+
+        // Round up, so the filter never passes more than the output can hold.
+        int index = static_cast<int>( ceil( log( ratio ) / log( 2.0 ) * TableStepsPerOctave - 1e-9 ) );
+        return std::min( index, MaxTables - 1 );
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Kernels
+    //----------------------------------------------------------------------------------
+
+    // dest[i] = a[i] + ( b[i] - a[i] ) * t
+    void Lerp( float* dest, const float* a, const float* b, float t, size_t count )
+    {
+        size_t i = 0;
+
+#if defined(RESAMPLER_USE_AVX)
+        __m256 t8 = _mm256_set1_ps( t );
+        for( ; i + 8 <= count; i += 8 )
+        {
+            __m256 va = _mm256_loadu_ps( a + i );
+            __m256 vb = _mm256_loadu_ps( b + i );
+            _mm256_storeu_ps( dest + i, _mm256_add_ps( va, _mm256_mul_ps( _mm256_sub_ps( vb, va ), t8 ) ) );
+        }
+#endif
+
+#if defined(RESAMPLER_USE_AVX) || defined(RESAMPLER_USE_SSE)
+        __m128 t4 = _mm_set1_ps( t );
+        for( ; i + 4 <= count; i += 4 )
+        {
+            __m128 va = _mm_loadu_ps( a + i );
+            __m128 vb = _mm_loadu_ps( b + i );
+            _mm_storeu_ps( dest + i, _mm_add_ps( va, _mm_mul_ps( _mm_sub_ps( vb, va ), t4 ) ) );
+        }
+#endif
+
+        for( ; i < count; ++i )
+        {
+            dest[ i ] = a[ i ] + ( b[ i ] - a[ i ] ) * t;
+        }
+    }
+
+    // Sum of a[i] * b[i]
+    float Dot( const float* a, const float* b, size_t count )
+    {
+        size_t i = 0;
+        float result = 0.f;
+
+#if defined(RESAMPLER_USE_AVX)
+        if ( count >= 8 )
+        {
+            __m256 sum8 = _mm256_setzero_ps();
+            for( ; i + 8 <= count; i += 8 )
+            {
+                sum8 = _mm256_add_ps( sum8, _mm256_mul_ps( _mm256_loadu_ps( a + i ), _mm256_loadu_ps( b + i ) ) );
+            }
+            __m128 sum4 = _mm_add_ps( _mm256_castps256_ps128( sum8 ), _mm256_extractf128_ps( sum8, 1 ) );
+            sum4 = _mm_add_ps( sum4, _mm_movehl_ps( sum4, sum4 ) );
+            sum4 = _mm_add_ss( sum4, _mm_shuffle_ps( sum4, sum4, 1 ) );
+            result = _mm_cvtss_f32( sum4 );
+        }
+#elif defined(RESAMPLER_USE_SSE)
+        if ( count >= 4 )
+        {
+            __m128 sum4 = _mm_setzero_ps();
+            for( ; i + 4 <= count; i += 4 )
+            {
+                sum4 = _mm_add_ps( sum4, _mm_mul_ps( _mm_loadu_ps( a + i ), _mm_loadu_ps( b + i ) ) );
+            }
+            sum4 = _mm_add_ps( sum4, _mm_movehl_ps( sum4, sum4 ) );
+            sum4 = _mm_add_ss( sum4, _mm_shuffle_ps( sum4, sum4, 1 ) );
+            result = _mm_cvtss_f32( sum4 );
+        }
+#endif
+
+        for( ; i < count; ++i )
+        {
+            result += a[ i ] * b[ i ];
+        }
+        return result;
+    }
+}
+
+
+// Private implementation.
+class Resampler::Impl
+{
+public:
+    Impl( int channels, RESAMPLER_QUALITY quality ) :
+        mChannels( channels ),
+        mQuality( quality ),
+        mDesign( Designs[ quality ] ),
+        mRatio( 1.0 ),
+        mStep( uint64_t( 1 ) << 32 ),
+        mTable( nullptr ),
+        mFill( 0 ),
+        mPosition( 0 )
+    {
+        for( int c = 0; c < channels; ++c )
+        {
+            mHistory[ c ].resize( mDesign.taps + HistoryBlockFrames );
+        }
+        mCoefficients.resize( mDesign.taps );
+
+        SelectTable();
+        Reset();
+    }
+
+    void SelectTable()
+    {
+        // The linear table has no cutoff to move.
+        int index = ( mDesign.taps == 2 ) ? 0 : TableIndex( mRatio );
+        if ( mTables[ index ].empty() )
+        {
+            double ratio = ( index == 0 ) ? 1.0 : pow( 2.0, double( index ) / TableStepsPerOctave );
+            mTables[ index ] = BuildTable( mDesign, ratio );
+        }
+        mTable = &mTables[ index ][ 0 ];
+    }
+
+    void Reset()
+    {
+        // Start with half a filter of silence, so the first output lines up with
+        // the first input frame.
+        size_t lead = mDesign.taps / 2 - 1;
+        for( int c = 0; c < mChannels; ++c )
+        {
+            std::fill( mHistory[ c ].begin(), mHistory[ c ].begin() + lead, 0.f );
+        }
+        mFill = lead;
+        mPosition = uint64_t( lead ) << 32;
+    }
+
+    size_t Process( const float* input, size_t inputFrames, size_t& inputConsumed, float* output, size_t outputCapacity );
+
+    int                     mChannels;
+    RESAMPLER_QUALITY       mQuality;
+    FilterDesign            mDesign;
+    double                  mRatio;
+    uint64_t                mStep;          // Input frames per output frame, 32.32 fixed point
+
+    std::vector<float>      mTables[ MaxTables ];
+    const float*            mTable;
+
+    std::vector<float>      mHistory[ MaxChannels ];    // Planar input not yet finished with
+    size_t                  mFill;
+    uint64_t                mPosition;      // Next output, in history frames, 32.32 fixed point
+    std::vector<float>      mCoefficients;  // One output's interpolated filter
+};
+
+
+size_t Resampler::Impl::Process( const float* input, size_t inputFrames, size_t& inputConsumed, float* output, size_t outputCapacity )
+{
+    const size_t taps = mDesign.taps;
+    const size_t behind = taps / 2 - 1;     // Taps before the output position
+    const size_t ahead = taps / 2;          // Taps at or after it
+    const size_t capacity = mHistory[ 0 ].size();
+    const uint64_t phases = mDesign.phases;
+
+    size_t consumed = 0;
+    size_t written = 0;
+
+    for( ;; )
+    {
+        // Convert everything the buffered input covers.
+        while ( written < outputCapacity )
+        {
+            size_t index = static_cast<size_t>( mPosition >> 32 );
+            if ( index + ahead >= mFill )
+                break;
+
+            uint64_t scaled = uint64_t( uint32_t( mPosition ) ) * phases;
+            const float* row = mTable + static_cast<size_t>( scaled >> 32 ) * taps;
+            float t = float( uint32_t( scaled ) ) * ( 1.f / 4294967296.f );
+            Lerp( &mCoefficients[ 0 ], row, row + taps, t, taps );
+
+            float* dest = output + written * mChannels;
+            for( int c = 0; c < mChannels; ++c )
+            {
+                dest[ c ] = Dot( &mHistory[ c ][ index - behind ], &mCoefficients[ 0 ], taps );
+            }
+
+            mPosition += mStep;
+            ++written;
+        }
+
+        if ( written == outputCapacity )
+            break;
+
+        // Drop the frames no output will use again.
+        size_t index = static_cast<size_t>( mPosition >> 32 );
+        size_t unused = ( index > behind ) ? index - behind : 0;
+        size_t drop = std::min( unused, mFill );
+        if ( drop > 0 )
+        {
+            for( int c = 0; c < mChannels; ++c )
+            {
+                memmove( &mHistory[ c ][ 0 ], &mHistory[ c ][ drop ], ( mFill - drop ) * sizeof(float) );
+            }
+            mFill -= drop;
+            mPosition -= uint64_t( drop ) << 32;
+            unused -= drop;
+        }
+
+        // Downsampling far enough steps over input that never needs buffering.
+        if ( unused > 0 )
+        {
+            size_t skip = std::min( unused, inputFrames - consumed );
+            consumed += skip;
+            mPosition -= uint64_t( skip ) << 32;
+            if ( skip < unused )
+                break;
+        }
+
+        if ( consumed == inputFrames )
+            break;
+
+        size_t count = std::min( capacity - mFill, inputFrames - consumed );
+        const float* src = input + consumed * mChannels;
+        if ( mChannels == 1 )
+        {
+            memcpy( &mHistory[ 0 ][ mFill ], src, count * sizeof(float) );
+        }
+        else
+        {
+            for( size_t j = 0; j < count; ++j )
+            {
+                for( int c = 0; c < mChannels; ++c )
+                {
+                    mHistory[ c ][ mFill + j ] = src[ j * mChannels + c ];
+                }
+            }
+        }
+        mFill += count;
+        consumed += count;
+    }
+
+    inputConsumed = consumed;
+    return written;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Resampler
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+Resampler::Resampler( int channels, RESAMPLER_QUALITY quality )
+{
+    if ( channels < 1 || channels > MaxChannels || quality < RESAMPLER_QUALITY_LINEAR || quality > RESAMPLER_QUALITY_HIGH )
+        throw std::invalid_argument( "Resampler" );
+
+    pImpl.reset( new Impl( channels, quality ) );
+}
+
+
+// Move constructor.
+Resampler::Resampler(Resampler&& moveFrom)
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+Resampler& Resampler::operator= (Resampler&& moveFrom)
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+Resampler::~Resampler()
+{
+}
+
+
+// Public methods.
+void Resampler::SetRatio( double ratio )
+{
+    assert( ratio > 0 );
+
+    ratio = std::min( double( MaxRatio ), std::max( 1.0 / MaxRatio, ratio ) );
+    if ( ratio == pImpl->mRatio )
+        return;
+
+    pImpl->mRatio = ratio;
+    pImpl->mStep = static_cast<uint64_t>( ratio * 4294967296.0 + 0.5 );
+    pImpl->SelectTable();
+}
+
+
+double Resampler::GetRatio() const
+{
+    return pImpl->mRatio;
+}
+
+
+size_t Resampler::Process( const float* input, size_t inputFrames, size_t& inputConsumed, float* output, size_t outputCapacity )
+{
+    return pImpl->Process( input, inputFrames, inputConsumed, output, outputCapacity );
+}
+
+
+void Resampler::Reset()
+{
+    pImpl->Reset();
+}
+
+
+size_t Resampler::GetLatency() const
+{
+    return pImpl->mDesign.taps / 2;
+}
+
+
+int Resampler::GetChannels() const
+{
+    return pImpl->mChannels;
+}
+
+
+RESAMPLER_QUALITY Resampler::GetQuality() const
+{
+    return pImpl->mQuality;
+}
+
+
+size_t Resampler::GetTaps( RESAMPLER_QUALITY quality )
+{
+    return ( quality >= RESAMPLER_QUALITY_LINEAR && quality <= RESAMPLER_QUALITY_HIGH ) ? Designs[ quality ].taps : 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+ResamplerBenchmark DirectX::BenchmarkResampler( RESAMPLER_QUALITY quality, int channels, int inputRate, int outputRate,
+                                                double audioSeconds )
+{
+    if ( inputRate <= 0 || outputRate <= 0 )
+        throw std::invalid_argument( "BenchmarkResampler" );
+
+    Resampler resampler( channels, quality );
+    resampler.SetRatio( double( inputRate ) / double( outputRate ) );
+
+    // 1 kHz at -1 dBFS, with the latency's worth of silence after it.
+    const double frequency = 1000.0;
+    const double amplitude = pow( 10.0, -1.0 / 20.0 );
+    size_t outputFrames = static_cast<size_t>( audioSeconds * outputRate );
+    size_t inputFrames = static_cast<size_t>( audioSeconds * inputRate ) + resampler.GetLatency();
+
+    std::vector<float> input( inputFrames * channels );
+    for( size_t j = 0; j + resampler.GetLatency() < inputFrames; ++j )
+    {
+        float s = float( amplitude * sin( 2.0 * Pi * frequency * double( j ) / double( inputRate ) ) );
+        for( int c = 0; c < channels; ++c )
+        {
+            input[ j * channels + c ] = s;
+        }
+    }
+
+    std::vector<float> output( outputFrames * channels );
+
+    // In blocks of about 10 ms, as a mixer would call it.
+    const size_t blockFrames = std::max<size_t>( 1, outputRate / 100 );
+    size_t read = 0;
+    size_t written = 0;
+
+    double start = SteadyClock();
+    while ( written < outputFrames )
+    {
+        size_t consumed = 0;
+        size_t count = resampler.Process( &input[ read * channels ], inputFrames - read, consumed,
+                                          &output[ written * channels ], std::min( blockFrames, outputFrames - written ) );
+        read += consumed;
+        written += count;
+        if ( !count && !consumed )
+            break;
+    }
+    double end = SteadyClock();
+
+    // Fit the sine (and DC) to the first channel by least squares, away from the
+    // edges, and call everything left over distortion and noise.
+    double thdPlusNoise = 0;
+    size_t margin = std::min( written / 4, size_t( outputRate / 50 ) );
+    if ( written > margin * 2 + 16 )
+    {
+        double m[ 3 ][ 3 ] = {};
+        double v[ 3 ] = {};
+        for( size_t j = margin; j < written - margin; ++j )
+        {
+            double phase = 2.0 * Pi * frequency * double( j ) / double( outputRate );
+            double basis[ 3 ] = { sin( phase ), cos( phase ), 1.0 };
+            double y = output[ j * channels ];
+            for( int r = 0; r < 3; ++r )
+            {
+                for( int k = 0; k < 3; ++k )
+                    m[ r ][ k ] += basis[ r ] * basis[ k ];
+                v[ r ] += basis[ r ] * y;
+            }
+        }
+
+        // Gaussian elimination; the system is small and well conditioned.
+        for( int r = 0; r < 3; ++r )
+        {
+            for( int k = r + 1; k < 3; ++k )
+            {
+                double f = m[ k ][ r ] / m[ r ][ r ];
+                for( int i = r; i < 3; ++i )
+                    m[ k ][ i ] -= f * m[ r ][ i ];
+                v[ k ] -= f * v[ r ];
+            }
+        }
+        double x[ 3 ];
+        for( int r = 2; r >= 0; --r )
+        {
+            double s = v[ r ];
+            for( int k = r + 1; k < 3; ++k )
+                s -= m[ r ][ k ] * x[ k ];
+            x[ r ] = s / m[ r ][ r ];
+        }
+
+        double signal = 0;
+        double residual = 0;
+        for( size_t j = margin; j < written - margin; ++j )
+        {
+            double phase = 2.0 * Pi * frequency * double( j ) / double( outputRate );
+            double fit = x[ 0 ] * sin( phase ) + x[ 1 ] * cos( phase );
+            double error = output[ j * channels ] - fit - x[ 2 ];
+            signal += fit * fit;
+            residual += error * error;
+        }
+
+        thdPlusNoise = ( residual > 0 && signal > 0 ) ? 10.0 * log10( residual / signal ) : 0;
+    }
+
+    ResamplerBenchmark result;
+    result.quality = quality;
+    result.audioSeconds = double( written ) / outputRate;
+    result.processSeconds = end - start;
+    result.realTimeFraction = ( result.audioSeconds > 0 ) ? result.processSeconds / result.audioSeconds : 0;
+    result.thdPlusNoise = thdPlusNoise;
+    return result;
+}
@@ -0,0 +1,95 @@
+//--------------------------------------------------------------------------------------
+// File: Resampler.h
+//
+// Streaming polyphase windowed-sinc sample rate converter, for bringing voices at
+// mixed sample rates (and pitches) to one mix rate
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+
+
+namespace DirectX
+{
+    enum RESAMPLER_QUALITY
+    {
+        RESAMPLER_QUALITY_LINEAR,   // 2 taps: linear interpolation, no anti-aliasing.
+        RESAMPLER_QUALITY_LOW,      // 8 taps
+        RESAMPLER_QUALITY_MEDIUM,   // 16 taps
+        RESAMPLER_QUALITY_HIGH,     // 32 taps
+    };
+
+    class Resampler
+    {
+    public:
+        // Most interleaved channels a resampler converts together.
+        static const int MaxChannels = 8;
+
+        // SetRatio clamps to 1 / MaxRatio .. MaxRatio.
+        static const int MaxRatio = 256;
+
+        Resampler( int channels, RESAMPLER_QUALITY quality );
+
+        Resampler(Resampler&& moveFrom);
+        Resampler& operator= (Resampler&& moveFrom);
+        virtual ~Resampler();
+
+        // Source frames per output frame: source rate / output rate * pitch. Can
+        // change between calls (for pitch bends) and applies from the next output frame.
+        void SetRatio( double ratio );
+        double GetRatio() const;
+
+        // Converts interleaved frames. Takes as much input as it can hold and writes
+        // up to outputCapacity frames; returns the frames written and sets
+        // inputConsumed. Input not consumed must be offered again on the next call.
+        size_t Process( const float* input, size_t inputFrames, size_t& inputConsumed,
+                        float* output, size_t outputCapacity );
+
+        // Forgets all buffered input, as for a new stream.
+        void Reset();
+
+        // Input frames held back by the filter. Feeding this many frames of silence
+        // after the last real frame brings all of it out.
+        size_t GetLatency() const;
+
+        int GetChannels() const;
+        RESAMPLER_QUALITY GetQuality() const;
+
+        static size_t GetTaps( RESAMPLER_QUALITY quality );
+
+    private:
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        Resampler(Resampler const&);
+        Resampler& operator= (Resampler const&);
+    };
+
+
+    struct ResamplerBenchmark
+    {
+        RESAMPLER_QUALITY   quality;
+        double              audioSeconds;       // Output produced
+        double              processSeconds;     // Time it took
+        double              realTimeFraction;   // processSeconds / audioSeconds
+        double              thdPlusNoise;       // 1 kHz sine at -1 dBFS, in dB relative to it
+    };
+
+    // Converts audioSeconds of a 1 kHz sine from inputRate to outputRate, timing it
+    // and measuring the distortion and noise the conversion added.
+    ResamplerBenchmark BenchmarkResampler( RESAMPLER_QUALITY quality, int channels, int inputRate, int outputRate,
+                                           double audioSeconds );
+}
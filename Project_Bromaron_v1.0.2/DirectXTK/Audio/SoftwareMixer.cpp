@@ -0,0 +1,837 @@
+//--------------------------------------------------------------------------------------
+// File: SoftwareMixer.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "SoftwareMixer.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// VS 2010 doesn't have <chrono>
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+#define MIXER_USE_QPC
+#else
+#include <chrono>
+#endif
+
+#if defined(__AVX__)
+#define MIXER_USE_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define MIXER_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace DirectX;
+
+
+namespace
+{
+    const int MaxChannels = 2;
+
+    double SteadyClock()
+    {
+#ifdef MIXER_USE_QPC
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency( &frequency );
+        QueryPerformanceCounter( &counter );
+        return double( counter.QuadPart ) / double( frequency.QuadPart );
+#else
+        auto now = std::chrono::high_resolution_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+#endif
+    }
+
+    //----------------------------------------------------------------------------------
+    // Kernels
+    //----------------------------------------------------------------------------------
+
+    // dest[i] += source[i] * gain
+    void MixAdd( float* dest, const float* source, float gain, size_t count )
+    {
+        size_t i = 0;
+
+#if defined(MIXER_USE_AVX)
+        __m256 g8 = _mm256_set1_ps( gain );
+        for( ; i + 8 <= count; i += 8 )
+        {
+            __m256 d = _mm256_loadu_ps( dest + i );
+            __m256 s = _mm256_loadu_ps( source + i );
+            _mm256_storeu_ps( dest + i, _mm256_add_ps( d, _mm256_mul_ps( s, g8 ) ) );
+        }
+#endif
+
+#if defined(MIXER_USE_AVX) || defined(MIXER_USE_SSE)
+        __m128 g4 = _mm_set1_ps( gain );
+        for( ; i + 4 <= count; i += 4 )
+        {
+            __m128 d = _mm_loadu_ps( dest + i );
+            __m128 s = _mm_loadu_ps( source + i );
+            _mm_storeu_ps( dest + i, _mm_add_ps( d, _mm_mul_ps( s, g4 ) ) );
+        }
+#endif
+
+        for( ; i < count; ++i )
+        {
+            dest[ i ] += source[ i ] * gain;
+        }
+    }
+
+    // dest[i * 2] = left[i] * gain, dest[i * 2 + 1] = right[i] * gain
+    void InterleaveStereo( float* dest, const float* left, const float* right, float gain, size_t count )
+    {
+        size_t i = 0;
+
+#if defined(MIXER_USE_AVX) || defined(MIXER_USE_SSE)
+        __m128 g4 = _mm_set1_ps( gain );
+        for( ; i + 4 <= count; i += 4 )
+        {
+            __m128 l = _mm_mul_ps( _mm_loadu_ps( left + i ), g4 );
+            __m128 r = _mm_mul_ps( _mm_loadu_ps( right + i ), g4 );
+            _mm_storeu_ps( dest + i * 2, _mm_unpacklo_ps( l, r ) );
+            _mm_storeu_ps( dest + i * 2 + 4, _mm_unpackhi_ps( l, r ) );
+        }
+#endif
+
+        for( ; i < count; ++i )
+        {
+            dest[ i * 2 ] = left[ i ] * gain;
+            dest[ i * 2 + 1 ] = right[ i ] * gain;
+        }
+    }
+
+    void Scale( float* dest, const float* source, float gain, size_t count )
+    {
+        for( size_t i = 0; i < count; ++i )
+        {
+            dest[ i ] = source[ i ] * gain;
+        }
+    }
+
+    // Output gains for a mono voice panned to a stereo output. Matches the matrix
+    // SoundEffectInstanceBase::SetPan gives XAudio2 for SPEAKER_STEREO.
+    void ComputePan( float pan, float& left, float& right )
+    {
+        left = ( pan >= 0 ) ? ( 1.f - pan ) : 1.f;
+        right = ( pan <= 0 ) ? ( pan + 1.f ) : 1.f;
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Graph
+    //----------------------------------------------------------------------------------
+
+    struct Bus
+    {
+        int                 output;
+        float               volume;
+        std::vector<float>  buffer[ MaxChannels ];  // Planar, one quantum
+    };
+
+    struct Voice
+    {
+        bool            allocated;
+        bool            playing;
+        bool            loop;
+        int             channels;
+        int             sampleRate;
+        int             output;
+        float           volume;
+        float           pitch;
+        float           pan;
+        bool            filtered;   // Going through its resampler since the buffer was submitted
+        const float*    samples;
+        size_t          frameCount;
+        uint64_t        position;   // Frames, 32.32 fixed point
+    };
+}
+
+
+// Private implementation.
+class SoftwareMixer::Impl
+{
+public:
+    Impl( int sampleRate, int channels ) :
+        mSampleRate( sampleRate ),
+        mChannels( channels ),
+        mFramesRendered( 0 ),
+        mQuality( RESAMPLER_QUALITY_LINEAR )
+    {
+        mMaster.output = MasterBus;
+        mMaster.volume = 1.f;
+        for( int c = 0; c < MaxChannels; ++c )
+        {
+            mMaster.buffer[ c ].resize( QuantumFrames );
+            mScratch[ c ].resize( QuantumFrames );
+        }
+        mInterleaved.resize( QuantumFrames * MaxChannels );
+        mSilence.resize( Resampler::GetTaps( RESAMPLER_QUALITY_HIGH ) * MaxChannels );
+    }
+
+    Bus& GetBus( int bus )
+    {
+        return ( bus == MasterBus ) ? mMaster : mBuses[ bus ];
+    }
+
+    bool IsValidBus( int bus ) const
+    {
+        return bus == MasterBus || ( bus >= 0 && static_cast<size_t>( bus ) < mBuses.size() );
+    }
+
+    Voice* GetVoice( int voice )
+    {
+        if ( voice < 0 || static_cast<size_t>( voice ) >= mVoices.size() || !mVoices[ voice ].allocated )
+        {
+            assert( false );
+            return nullptr;
+        }
+        return &mVoices[ voice ];
+    }
+
+    uint64_t GetStep( const Voice& v ) const
+    {
+        double ratio = double( v.pitch ) * double( v.sampleRate ) / double( mSampleRate );
+        return static_cast<uint64_t>( ratio * 4294967296.0 + 0.5 );
+    }
+
+    void CreateResampler( size_t voice );
+
+    size_t ResampleFiltered( Voice& v, Resampler& resampler, size_t count );
+    void Resample( Voice& v, Resampler* resampler, size_t count );
+    void MixVoice( Voice& v, Resampler* resampler, size_t count );
+    void RenderQuantum( float* output, size_t count );
+
+    int                     mSampleRate;
+    int                     mChannels;
+    uint64_t                mFramesRendered;
+
+    Bus                     mMaster;
+    std::vector<Bus>        mBuses;
+    std::vector<Voice>      mVoices;
+    std::vector<float>      mScratch[ MaxChannels ];    // One voice's resampled quantum
+
+    RESAMPLER_QUALITY                       mQuality;
+    std::vector<std::unique_ptr<Resampler>> mResamplers;    // Per voice, unless mQuality is linear
+    std::vector<float>                      mInterleaved;   // One voice's quantum from its resampler
+    std::vector<float>                      mSilence;       // Fed to a resampler to flush its tail
+};
+
+
+void SoftwareMixer::Impl::CreateResampler( size_t voice )
+{
+    auto& resampler = mResamplers[ voice ];
+    if ( mQuality == RESAMPLER_QUALITY_LINEAR || !mVoices[ voice ].allocated )
+    {
+        resampler.reset();
+    }
+    else if ( !resampler || resampler->GetQuality() != mQuality || resampler->GetChannels() != mVoices[ voice ].channels )
+    {
+        resampler.reset( new Resampler( mVoices[ voice ].channels, mQuality ) );
+    }
+}
+
+
+// Pulls the voice's next count frames through its resampler into the scratch buffers.
+// Past the end, a looping voice carries on from its first frame, and a one-shot feeds
+// the filter silence until its tail is out. Returns the frames written.
+size_t SoftwareMixer::Impl::ResampleFiltered( Voice& v, Resampler& resampler, size_t count )
+{
+    const int channels = v.channels;
+    resampler.SetRatio( double( v.pitch ) * double( v.sampleRate ) / double( mSampleRate ) );
+    v.filtered = true;
+
+    float* output = &mInterleaved[ 0 ];
+    size_t n = 0;
+    while ( n < count )
+    {
+        size_t index = static_cast<size_t>( v.position >> 32 );
+        const float* input;
+        size_t available;
+        if ( index < v.frameCount )
+        {
+            input = v.samples + index * channels;
+            available = v.frameCount - index;
+        }
+        else if ( v.loop )
+        {
+            v.position = 0;
+            continue;
+        }
+        else
+        {
+            size_t tail = index - v.frameCount;
+            if ( tail >= resampler.GetLatency() )
+            {
+                v.playing = false;
+                break;
+            }
+            input = &mSilence[ 0 ];
+            available = resampler.GetLatency() - tail;
+        }
+
+        size_t consumed = 0;
+        n += resampler.Process( input, available, consumed, output + n * channels, count - n );
+        v.position = uint64_t( index + consumed ) << 32;
+    }
+
+    if ( channels == 1 )
+    {
+        memcpy( &mScratch[ 0 ][ 0 ], output, n * sizeof(float) );
+    }
+    else
+    {
+        for( size_t j = 0; j < n; ++j )
+        {
+            mScratch[ 0 ][ j ] = output[ j * 2 ];
+            mScratch[ 1 ][ j ] = output[ j * 2 + 1 ];
+        }
+    }
+
+    return n;
+}
+
+
+// Fills the scratch buffers with the voice's next count frames, planar.
+void SoftwareMixer::Impl::Resample( Voice& v, Resampler* resampler, size_t count )
+{
+    const int channels = v.channels;
+    const uint64_t step = GetStep( v );
+    const uint64_t end = uint64_t( v.frameCount ) << 32;
+
+    size_t n = 0;
+
+    if ( resampler && ( v.filtered || step != ( uint64_t( 1 ) << 32 ) ) )
+    {
+        // Once a voice is filtered it stays filtered until its next buffer, so a
+        // pitch bend through 1.0 doesn't jump by the filter's latency.
+        n = ResampleFiltered( v, *resampler, count );
+    }
+    else if ( step == ( uint64_t( 1 ) << 32 ) && ( v.position & 0xFFFFFFFF ) == 0 )
+    {
+        // Unpitched at the output rate: a straight copy.
+        while ( n < count && v.playing )
+        {
+            size_t index = static_cast<size_t>( v.position >> 32 );
+            size_t run = std::min( count - n, v.frameCount - index );
+            const float* src = v.samples + index * channels;
+
+            if ( channels == 1 )
+            {
+                memcpy( &mScratch[ 0 ][ n ], src, run * sizeof(float) );
+            }
+            else
+            {
+                for( size_t j = 0; j < run; ++j )
+                {
+                    mScratch[ 0 ][ n + j ] = src[ j * 2 ];
+                    mScratch[ 1 ][ n + j ] = src[ j * 2 + 1 ];
+                }
+            }
+
+            n += run;
+            v.position += uint64_t( run ) << 32;
+            if ( v.position >= end )
+            {
+                if ( v.loop )
+                    v.position -= end;
+                else
+                    v.playing = false;
+            }
+        }
+    }
+    else
+    {
+        // Linear interpolation between neighbouring frames. Past the end, a looping
+        // voice interpolates towards its first frame and a one-shot towards silence.
+        const uint64_t last = end - ( uint64_t( 1 ) << 32 );
+
+        while ( n < count )
+        {
+            while ( v.position >= end && v.loop )
+            {
+                v.position -= end;
+            }
+
+            if ( v.position >= end )
+            {
+                v.playing = false;
+                break;
+            }
+
+            // Frames before the position reaches the last source frame need no
+            // bounds checks, since the next frame always exists.
+            size_t run = 0;
+            if ( v.position < last )
+            {
+                run = static_cast<size_t>( std::min<uint64_t>( count - n, ( last - v.position + step - 1 ) / step ) );
+            }
+
+            if ( run > 0 )
+            {
+                uint64_t position = v.position;
+                if ( channels == 1 )
+                {
+                    float* dest = &mScratch[ 0 ][ n ];
+                    for( size_t j = 0; j < run; ++j, position += step )
+                    {
+                        const float* src = v.samples + static_cast<size_t>( position >> 32 );
+                        float frac = float( uint32_t( position ) ) * ( 1.f / 4294967296.f );
+                        dest[ j ] = src[ 0 ] + ( src[ 1 ] - src[ 0 ] ) * frac;
+                    }
+                }
+                else
+                {
+                    float* left = &mScratch[ 0 ][ n ];
+                    float* right = &mScratch[ 1 ][ n ];
+                    for( size_t j = 0; j < run; ++j, position += step )
+                    {
+                        const float* src = v.samples + static_cast<size_t>( position >> 32 ) * 2;
+                        float frac = float( uint32_t( position ) ) * ( 1.f / 4294967296.f );
+                        left[ j ] = src[ 0 ] + ( src[ 2 ] - src[ 0 ] ) * frac;
+                        right[ j ] = src[ 1 ] + ( src[ 3 ] - src[ 1 ] ) * frac;
+                    }
+                }
+
+                v.position = position;
+                n += run;
+                continue;
+            }
+
+            size_t index = static_cast<size_t>( v.position >> 32 );
+            float frac = float( uint32_t( v.position ) ) * ( 1.f / 4294967296.f );
+
+            for( int c = 0; c < channels; ++c )
+            {
+                float s0 = v.samples[ index * channels + c ];
+                float s1 = v.loop ? v.samples[ c ] : 0.f;
+                mScratch[ c ][ n ] = s0 + ( s1 - s0 ) * frac;
+            }
+
+            v.position += step;
+            ++n;
+        }
+    }
+
+    for( int c = 0; c < channels; ++c )
+    {
+        std::fill( mScratch[ c ].begin() + n, mScratch[ c ].begin() + count, 0.f );
+    }
+}
+
+
+void SoftwareMixer::Impl::MixVoice( Voice& v, Resampler* resampler, size_t count )
+{
+    Resample( v, resampler, count );
+
+    Bus& bus = GetBus( v.output );
+
+    if ( mChannels == 1 )
+    {
+        // Stereo folds down to mono at half level per side, as XAudio2's default matrix.
+        float gain = ( v.channels == 1 ) ? v.volume : v.volume * 0.5f;
+        for( int c = 0; c < v.channels; ++c )
+        {
+            MixAdd( &bus.buffer[ 0 ][ 0 ], &mScratch[ c ][ 0 ], gain, count );
+        }
+    }
+    else if ( v.channels == 1 )
+    {
+        float left, right;
+        ComputePan( v.pan, left, right );
+        MixAdd( &bus.buffer[ 0 ][ 0 ], &mScratch[ 0 ][ 0 ], v.volume * left, count );
+        MixAdd( &bus.buffer[ 1 ][ 0 ], &mScratch[ 0 ][ 0 ], v.volume * right, count );
+    }
+    else
+    {
+        MixAdd( &bus.buffer[ 0 ][ 0 ], &mScratch[ 0 ][ 0 ], v.volume, count );
+        MixAdd( &bus.buffer[ 1 ][ 0 ], &mScratch[ 1 ][ 0 ], v.volume, count );
+    }
+}
+
+
+void SoftwareMixer::Impl::RenderQuantum( float* output, size_t count )
+{
+    assert( count <= QuantumFrames );
+
+    for( int c = 0; c < mChannels; ++c )
+    {
+        std::fill( mMaster.buffer[ c ].begin(), mMaster.buffer[ c ].begin() + count, 0.f );
+        for( auto it = mBuses.begin(); it != mBuses.end(); ++it )
+        {
+            std::fill( it->buffer[ c ].begin(), it->buffer[ c ].begin() + count, 0.f );
+        }
+    }
+
+    for( size_t j = 0; j < mVoices.size(); ++j )
+    {
+        if ( mVoices[ j ].playing )
+        {
+            MixVoice( mVoices[ j ], mResamplers[ j ].get(), count );
+        }
+    }
+
+    // Buses only send to earlier buses, so going backwards finishes each bus before
+    // it is mixed onwards.
+    for( size_t j = mBuses.size(); j > 0; --j )
+    {
+        Bus& bus = mBuses[ j - 1 ];
+        Bus& target = GetBus( bus.output );
+        for( int c = 0; c < mChannels; ++c )
+        {
+            MixAdd( &target.buffer[ c ][ 0 ], &bus.buffer[ c ][ 0 ], bus.volume, count );
+        }
+    }
+
+    if ( mChannels == 2 )
+    {
+        InterleaveStereo( output, &mMaster.buffer[ 0 ][ 0 ], &mMaster.buffer[ 1 ][ 0 ], mMaster.volume, count );
+    }
+    else
+    {
+        Scale( output, &mMaster.buffer[ 0 ][ 0 ], mMaster.volume, count );
+    }
+
+    mFramesRendered += count;
+}
+
+
+//--------------------------------------------------------------------------------------
+// SoftwareMixer
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+SoftwareMixer::SoftwareMixer( int sampleRate, int channels )
+{
+    if ( sampleRate <= 0 || channels < 1 || channels > MaxChannels )
+        throw std::invalid_argument( "SoftwareMixer" );
+
+    pImpl.reset( new Impl( sampleRate, channels ) );
+}
+
+
+// Move constructor.
+SoftwareMixer::SoftwareMixer(SoftwareMixer&& moveFrom)
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+SoftwareMixer& SoftwareMixer::operator= (SoftwareMixer&& moveFrom)
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+SoftwareMixer::~SoftwareMixer()
+{
+}
+
+
+// Public methods.
+int SoftwareMixer::CreateBus( int outputBus )
+{
+    if ( !pImpl->IsValidBus( outputBus ) )
+        return -1;
+
+    Bus bus;
+    bus.output = outputBus;
+    bus.volume = 1.f;
+    for( int c = 0; c < MaxChannels; ++c )
+    {
+        bus.buffer[ c ].resize( QuantumFrames );
+    }
+
+    pImpl->mBuses.push_back( std::move( bus ) );
+    return static_cast<int>( pImpl->mBuses.size() ) - 1;
+}
+
+
+void SoftwareMixer::SetBusVolume( int bus, float volume )
+{
+    if ( !pImpl->IsValidBus( bus ) )
+    {
+        assert( false );
+        return;
+    }
+
+    pImpl->GetBus( bus ).volume = volume;
+}
+
+
+int SoftwareMixer::CreateVoice( int sampleRate, int channels, int outputBus )
+{
+    if ( sampleRate <= 0 || channels < 1 || channels > MaxChannels || !pImpl->IsValidBus( outputBus ) )
+        return -1;
+
+    Voice v;
+    memset( &v, 0, sizeof(Voice) );
+    v.allocated = true;
+    v.channels = channels;
+    v.sampleRate = sampleRate;
+    v.output = outputBus;
+    v.volume = 1.f;
+    v.pitch = 1.f;
+
+    // Reuse the slot of a destroyed voice if there is one.
+    auto& voices = pImpl->mVoices;
+    size_t slot = 0;
+    while ( slot < voices.size() && voices[ slot ].allocated )
+    {
+        ++slot;
+    }
+
+    if ( slot == voices.size() )
+    {
+        voices.push_back( v );
+        pImpl->mResamplers.push_back( std::unique_ptr<Resampler>() );
+    }
+    else
+    {
+        voices[ slot ] = v;
+    }
+
+    pImpl->CreateResampler( slot );
+    return static_cast<int>( slot );
+}
+
+
+void SoftwareMixer::DestroyVoice( int voice )
+{
+    Voice* v = pImpl->GetVoice( voice );
+    if ( v )
+    {
+        v->allocated = false;
+        v->playing = false;
+        v->samples = nullptr;
+        pImpl->mResamplers[ voice ].reset();
+    }
+}
+
+
+void SoftwareMixer::SubmitBuffer( int voice, const float* samples, size_t frameCount, bool loop )
+{
+    Voice* v = pImpl->GetVoice( voice );
+    if ( !v )
+        return;
+
+    v->samples = samples;
+    v->frameCount = ( samples ) ? frameCount : 0;
+    v->loop = loop;
+    v->position = 0;
+    v->filtered = false;
+
+    if ( pImpl->mResamplers[ voice ] )
+        pImpl->mResamplers[ voice ]->Reset();
+
+    if ( !v->frameCount )
+        v->playing = false;
+}
+
+
+void SoftwareMixer::Start( int voice )
+{
+    Voice* v = pImpl->GetVoice( voice );
+    if ( v && v->frameCount > 0 && ( uint64_t( v->frameCount ) << 32 ) > v->position )
+    {
+        v->playing = true;
+    }
+}
+
+
+void SoftwareMixer::Stop( int voice )
+{
+    Voice* v = pImpl->GetVoice( voice );
+    if ( v )
+    {
+        v->playing = false;
+    }
+}
+
+
+bool SoftwareMixer::IsPlaying( int voice ) const
+{
+    if ( voice < 0 || static_cast<size_t>( voice ) >= pImpl->mVoices.size() )
+        return false;
+
+    return pImpl->mVoices[ voice ].playing;
+}
+
+
+void SoftwareMixer::SetVolume( int voice, float volume )
+{
+    Voice* v = pImpl->GetVoice( voice );
+    if ( v )
+    {
+        v->volume = volume;
+    }
+}
+
+
+void SoftwareMixer::SetPitch( int voice, float frequencyRatio )
+{
+    assert( frequencyRatio > 0.f && frequencyRatio <= float( MaxFrequencyRatio ) );
+
+    Voice* v = pImpl->GetVoice( voice );
+    if ( v )
+    {
+        v->pitch = std::min<float>( float( MaxFrequencyRatio ), std::max<float>( 1.f / 1024.f, frequencyRatio ) );
+    }
+}
+
+
+bool SoftwareMixer::SetPan( int voice, float pan )
+{
+    Voice* v = pImpl->GetVoice( voice );
+    if ( !v || v->channels != 1 )
+        return false;
+
+    v->pan = std::min<float>( 1.f, std::max<float>( -1.f, pan ) );
+    return true;
+}
+
+
+void SoftwareMixer::SetResamplerQuality( RESAMPLER_QUALITY quality )
+{
+    if ( quality < RESAMPLER_QUALITY_LINEAR || quality > RESAMPLER_QUALITY_HIGH )
+    {
+        assert( false );
+        return;
+    }
+
+    pImpl->mQuality = quality;
+    for( size_t j = 0; j < pImpl->mVoices.size(); ++j )
+    {
+        pImpl->CreateResampler( j );
+        pImpl->mVoices[ j ].filtered = false;
+    }
+}
+
+
+RESAMPLER_QUALITY SoftwareMixer::GetResamplerQuality() const
+{
+    return pImpl->mQuality;
+}
+
+
+void SoftwareMixer::Render( float* output, size_t frameCount )
+{
+    while ( frameCount > 0 )
+    {
+        size_t count = std::min( frameCount, static_cast<size_t>( QuantumFrames ) );
+        pImpl->RenderQuantum( output, count );
+        output += count * pImpl->mChannels;
+        frameCount -= count;
+    }
+}
+
+
+SoftwareMixerStatistics SoftwareMixer::GetStatistics() const
+{
+    SoftwareMixerStatistics stats;
+    memset( &stats, 0, sizeof(stats) );
+
+    for( auto it = pImpl->mVoices.begin(); it != pImpl->mVoices.end(); ++it )
+    {
+        if ( it->allocated )
+            ++stats.allocatedVoices;
+        if ( it->playing )
+            ++stats.playingVoices;
+    }
+
+    stats.buses = pImpl->mBuses.size();
+    stats.framesRendered = pImpl->mFramesRendered;
+    return stats;
+}
+
+
+int SoftwareMixer::GetSampleRate() const
+{
+    return pImpl->mSampleRate;
+}
+
+
+int SoftwareMixer::GetOutputChannels() const
+{
+    return pImpl->mChannels;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+SoftwareMixerBenchmark DirectX::BenchmarkSoftwareMixer( size_t voiceCount, double audioSeconds, RESAMPLER_QUALITY quality )
+{
+    const int sampleRate = 48000;
+    const size_t blockFrames = 480;     // 10 ms, as a device callback would ask for
+
+    SoftwareMixer mixer( sampleRate, 2 );
+    mixer.SetResamplerQuality( quality );
+
+    int buses[ 4 ];
+    for( int j = 0; j < 4; ++j )
+    {
+        buses[ j ] = mixer.CreateBus();
+        mixer.SetBusVolume( buses[ j ], 0.5f );
+    }
+
+    // One second of tone at 44.1 kHz, so every voice resamples as most assets would.
+    const size_t sourceFrames = 44100;
+    std::vector<float> mono( sourceFrames );
+    std::vector<float> stereo( sourceFrames * 2 );
+    for( size_t j = 0; j < sourceFrames; ++j )
+    {
+        float s = sinf( float( j ) * 2.f * 3.14159265f * 440.f / 44100.f );
+        mono[ j ] = s;
+        stereo[ j * 2 ] = s;
+        stereo[ j * 2 + 1 ] = -s;
+    }
+
+    for( size_t j = 0; j < voiceCount; ++j )
+    {
+        bool isMono = ( j % 2 ) == 0;
+        int voice = mixer.CreateVoice( 44100, isMono ? 1 : 2, ( j % 3 ) ? buses[ j % 4 ] : SoftwareMixer::MasterBus );
+        mixer.SubmitBuffer( voice, isMono ? &mono[ 0 ] : &stereo[ 0 ], sourceFrames, true );
+        mixer.SetVolume( voice, 1.f / float( voiceCount ) );
+        mixer.SetPitch( voice, 0.5f + float( j % 16 ) / 10.f );
+        if ( isMono )
+        {
+            mixer.SetPan( voice, float( j % 9 ) / 4.f - 1.f );
+        }
+        mixer.Start( voice );
+    }
+
+    size_t totalFrames = static_cast<size_t>( audioSeconds * sampleRate );
+    std::vector<float> sink( totalFrames * 2 );
+
+    double start = SteadyClock();
+    for( size_t done = 0; done < totalFrames; done += blockFrames )
+    {
+        mixer.Render( &sink[ done * 2 ], std::min( blockFrames, totalFrames - done ) );
+    }
+    double end = SteadyClock();
+
+    SoftwareMixerBenchmark result;
+    result.voiceCount = voiceCount;
+    result.audioSeconds = double( totalFrames ) / sampleRate;
+    result.renderSeconds = end - start;
+    result.realTimeFraction = ( result.audioSeconds > 0 ) ? result.renderSeconds / result.audioSeconds : 0;
+    return result;
+}
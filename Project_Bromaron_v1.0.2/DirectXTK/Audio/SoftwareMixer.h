@@ -0,0 +1,120 @@
+//--------------------------------------------------------------------------------------
+// File: SoftwareMixer.h
+//
+// Mixes float32 source voices through submix buses into a memory buffer, without
+// XAudio2, so the audio path can be profiled and tested on any platform
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+#include "Resampler.h"
+
+
+namespace DirectX
+{
+    // Voices mirror the controls SoundEffectInstanceBase drives on an XAudio2
+    // source voice: SetVolume, SetFrequencyRatio (pitch) and the output matrix
+    // SetPan builds. Voices at other sample rates or pitches are brought to the
+    // mix rate by linear interpolation, or by a Resampler once
+    // SetResamplerQuality picks a better tier.
+
+    struct SoftwareMixerStatistics
+    {
+        size_t      playingVoices;
+        size_t      allocatedVoices;
+        size_t      buses;
+        uint64_t    framesRendered;
+    };
+
+    class SoftwareMixer
+    {
+    public:
+        // Identifies the mastering bus wherever a bus is expected.
+        static const int MasterBus = -1;
+
+        // Frames mixed per pass; Render works through larger requests in passes of this size.
+        static const size_t QuantumFrames = 256;
+
+        // Highest pitch (frequency ratio) a voice accepts, as XAUDIO2_DEFAULT_FREQ_RATIO.
+        static const int MaxFrequencyRatio = 2;
+
+        // channels is 1 or 2; output from Render is interleaved.
+        SoftwareMixer( int sampleRate, int channels );
+
+        SoftwareMixer(SoftwareMixer&& moveFrom);
+        SoftwareMixer& operator= (SoftwareMixer&& moveFrom);
+        virtual ~SoftwareMixer();
+
+        // Submix buses. A bus sends to the master or to a bus created before it.
+        int CreateBus( int outputBus = MasterBus );
+        void SetBusVolume( int bus, float volume );
+
+        // Source voices, 1 or 2 channels at any sample rate; returns -1 if the format isn't supported.
+        int CreateVoice( int sampleRate, int channels, int outputBus = MasterBus );
+        void DestroyVoice( int voice );
+
+        // Sets what the voice plays, from the start. The samples are interleaved
+        // and must stay valid until the voice is destroyed or given another buffer.
+        void SubmitBuffer( int voice, const float* samples, size_t frameCount, bool loop );
+
+        void Start( int voice );
+        void Stop( int voice );
+        bool IsPlaying( int voice ) const;
+
+        void SetVolume( int voice, float volume );
+        void SetPitch( int voice, float frequencyRatio );
+
+        // -1 is left, 1 is right; as SoundEffectInstance::SetPan, only mono voices pan.
+        // Returns false for a stereo voice.
+        bool SetPan( int voice, float pan );
+
+        // Applies to every voice; RESAMPLER_QUALITY_LINEAR (the default) keeps the
+        // built-in interpolation, which has no latency.
+        void SetResamplerQuality( RESAMPLER_QUALITY quality );
+        RESAMPLER_QUALITY GetResamplerQuality() const;
+
+        // Mixes every playing voice into frameCount interleaved frames.
+        void Render( float* output, size_t frameCount );
+
+        SoftwareMixerStatistics GetStatistics() const;
+
+        int GetSampleRate() const;
+        int GetOutputChannels() const;
+
+    private:
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        SoftwareMixer(SoftwareMixer const&);
+        SoftwareMixer& operator= (SoftwareMixer const&);
+    };
+
+
+    struct SoftwareMixerBenchmark
+    {
+        size_t      voiceCount;
+        double      audioSeconds;       // Audio rendered
+        double      renderSeconds;      // Time it took
+        double      realTimeFraction;   // renderSeconds / audioSeconds
+    };
+
+    // Mixes voiceCount looping voices (a mix of mono and stereo, panned, pitched and
+    // spread over submix buses) for audioSeconds of 48 kHz stereo and times it.
+    SoftwareMixerBenchmark BenchmarkSoftwareMixer( size_t voiceCount, double audioSeconds,
+                                                   RESAMPLER_QUALITY quality = RESAMPLER_QUALITY_LINEAR );
+}
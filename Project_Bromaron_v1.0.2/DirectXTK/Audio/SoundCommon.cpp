@@ -651,7 +651,7 @@ void SoundEffectInstanceBase::SetPan( float pan )
         return;
 
     float left = ( pan >= 0 ) ? ( 1.f - pan ) : 1.f;
-    float right = ( pan <= 0 ) ? ( - pan - 1.f ) : 1.f;
+    float right = ( pan <= 0 ) ? ( pan + 1.f ) : 1.f;
 
     float matrix[8];
     for( size_t j = 0; j < 8; ++j )
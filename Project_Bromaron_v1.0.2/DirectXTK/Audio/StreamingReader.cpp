@@ -0,0 +1,1018 @@
+//--------------------------------------------------------------------------------------
+// File: StreamingReader.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "StreamingReader.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include "PlatformHelpers.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+
+namespace
+{
+    // Covers the sector size of every drive unbuffered reads are likely to meet.
+    const size_t IOAlignment = 4096;
+
+    double SteadyClock()
+    {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Thread pool backend
+    //----------------------------------------------------------------------------------
+
+    class ThreadPoolStreamingIO : public StreamingIO
+    {
+    public:
+        ThreadPoolStreamingIO() :
+            mFileSize( 0 ),
+            mStop( false )
+#ifndef _WIN32
+            , mFile( -1 )
+#endif
+        {
+        }
+
+        virtual ~ThreadPoolStreamingIO()
+        {
+            {
+                std::lock_guard<std::mutex> lock( mMutex );
+                mStop = true;
+            }
+            mWake.notify_all();
+
+            for( auto it = mThreads.begin(); it != mThreads.end(); ++it )
+            {
+                it->join();
+            }
+
+#ifndef _WIN32
+            if ( mFile >= 0 )
+                close( mFile );
+#endif
+        }
+
+        bool Open( const MappedFileChar* fileName, unsigned int threadCount, bool unbuffered );
+
+        bool Start( unsigned int threadCount )
+        {
+            try
+            {
+                for( unsigned int j = 0; j < threadCount; ++j )
+                {
+                    mThreads.push_back( std::thread( &ThreadPoolStreamingIO::Worker, this, size_t( j ) ) );
+                }
+            }
+            catch( const std::system_error& )
+            {
+                // Run with the threads that did start
+            }
+
+            return !mThreads.empty();
+        }
+
+        virtual bool Read( uint64_t offset, uint8_t* dest, size_t bytes, Completion completion, void* context ) override
+        {
+            if ( !dest || !completion || ( offset % IOAlignment ) != 0 || ( bytes % IOAlignment ) != 0 )
+                return false;
+
+            Request request = { offset, dest, bytes, completion, context };
+            {
+                std::lock_guard<std::mutex> lock( mMutex );
+                if ( mStop )
+                    return false;
+
+                mQueue.push_back( request );
+            }
+            mWake.notify_one();
+            return true;
+        }
+
+        virtual size_t GetAlignment() const override
+        {
+            return IOAlignment;
+        }
+
+        virtual uint64_t GetFileSize() const override
+        {
+            return mFileSize;
+        }
+
+    private:
+        struct Request
+        {
+            uint64_t    offset;
+            uint8_t*    dest;
+            size_t      bytes;
+            Completion  completion;
+            void*       context;
+        };
+
+        void Worker( size_t index );
+        bool ReadAt( size_t index, uint64_t offset, uint8_t* dest, size_t bytes, size_t& bytesRead );
+
+        uint64_t                    mFileSize;
+        bool                        mStop;
+        std::mutex                  mMutex;
+        std::condition_variable     mWake;
+        std::deque<Request>         mQueue;
+        std::vector<std::thread>    mThreads;
+
+#ifdef _WIN32
+        std::vector<ScopedHandle>   mFiles;     // One per thread
+#else
+        int                         mFile;
+#endif
+    };
+
+
+#ifdef _WIN32
+
+    bool ThreadPoolStreamingIO::Open( const MappedFileChar* fileName, unsigned int threadCount, bool unbuffered )
+    {
+        for( unsigned int j = 0; j < threadCount; ++j )
+        {
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+            CREATEFILE2_EXTENDED_PARAMETERS params = { sizeof(params), 0 };
+            params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+            params.dwFileFlags = unbuffered ? FILE_FLAG_NO_BUFFERING : 0;
+            params.dwSecurityQosFlags = SECURITY_IMPERSONATION;
+            ScopedHandle hFile( safe_handle( CreateFile2( fileName,
+                                                          GENERIC_READ,
+                                                          FILE_SHARE_READ,
+                                                          OPEN_EXISTING,
+                                                          &params ) ) );
+#else
+            ScopedHandle hFile( safe_handle( CreateFileW( fileName,
+                                                          GENERIC_READ,
+                                                          FILE_SHARE_READ,
+                                                          nullptr,
+                                                          OPEN_EXISTING,
+                                                          unbuffered ? FILE_FLAG_NO_BUFFERING : FILE_ATTRIBUTE_NORMAL,
+                                                          nullptr ) ) );
+#endif
+            if ( !hFile )
+                return false;
+
+            mFiles.push_back( std::move( hFile ) );
+        }
+
+        FILE_STANDARD_INFO fileInfo;
+        if ( !GetFileInformationByHandleEx( mFiles[ 0 ].get(), FileStandardInfo, &fileInfo, sizeof(fileInfo) ) )
+            return false;
+
+        mFileSize = static_cast<uint64_t>( fileInfo.EndOfFile.QuadPart );
+        return true;
+    }
+
+
+    bool ThreadPoolStreamingIO::ReadAt( size_t index, uint64_t offset, uint8_t* dest, size_t bytes, size_t& bytesRead )
+    {
+        // An offset in the OVERLAPPED makes a read on a synchronous handle positional.
+        OVERLAPPED request;
+        memset( &request, 0, sizeof(request) );
+        request.Offset = static_cast<DWORD>( offset );
+        request.OffsetHigh = static_cast<DWORD>( offset >> 32 );
+
+        DWORD read = 0;
+        if ( !ReadFile( mFiles[ index ].get(), dest, static_cast<DWORD>( bytes ), &read, &request ) )
+        {
+            if ( GetLastError() != ERROR_HANDLE_EOF )
+                return false;
+        }
+
+        bytesRead = read;
+        return true;
+    }
+
+#else // !_WIN32
+
+    bool ThreadPoolStreamingIO::Open( const MappedFileChar* fileName, unsigned int, bool unbuffered )
+    {
+#ifdef O_DIRECT
+        // tmpfs and some others refuse O_DIRECT; they get the cache.
+        if ( unbuffered )
+            mFile = open( fileName, O_RDONLY | O_CLOEXEC | O_DIRECT );
+        if ( mFile < 0 )
+#endif
+            mFile = open( fileName, O_RDONLY | O_CLOEXEC );
+
+        if ( mFile < 0 )
+            return false;
+
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+        if ( unbuffered )
+            (void)fcntl( mFile, F_NOCACHE, 1 );
+#else
+        (void)unbuffered;
+#endif
+
+        struct stat info;
+        if ( fstat( mFile, &info ) != 0 )
+            return false;
+
+        mFileSize = static_cast<uint64_t>( info.st_size );
+        return true;
+    }
+
+
+    bool ThreadPoolStreamingIO::ReadAt( size_t, uint64_t offset, uint8_t* dest, size_t bytes, size_t& bytesRead )
+    {
+        bytesRead = 0;
+        while ( bytesRead < bytes )
+        {
+            ssize_t result = pread( mFile, dest + bytesRead, bytes - bytesRead, static_cast<off_t>( offset + bytesRead ) );
+            if ( result < 0 )
+            {
+                if ( errno == EINTR )
+                    continue;
+                return false;
+            }
+
+            if ( !result )
+                break;
+
+            bytesRead += static_cast<size_t>( result );
+        }
+
+        return true;
+    }
+
+#endif
+
+
+    void ThreadPoolStreamingIO::Worker( size_t index )
+    {
+        for( ;; )
+        {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock( mMutex );
+                while ( !mStop && mQueue.empty() )
+                {
+                    mWake.wait( lock );
+                }
+
+                // Everything queued still completes, so no caller waits forever.
+                if ( mQueue.empty() )
+                    return;
+
+                request = mQueue.front();
+                mQueue.pop_front();
+            }
+
+            size_t bytesRead = 0;
+            bool succeeded = ReadAt( index, request.offset, request.dest, request.bytes, bytesRead );
+            request.completion( request.context, bytesRead, succeeded );
+        }
+    }
+}
+
+
+std::unique_ptr<StreamingIO> DirectX::CreateThreadPoolStreamingIO( const MappedFileChar* fileName, unsigned int threadCount, bool unbuffered )
+{
+    if ( !fileName )
+        return nullptr;
+
+    threadCount = std::max( 1u, threadCount );
+
+    std::unique_ptr<ThreadPoolStreamingIO> io( new ThreadPoolStreamingIO() );
+    if ( !io->Open( fileName, threadCount, unbuffered ) || !io->Start( threadCount ) )
+        return nullptr;
+
+    return std::unique_ptr<StreamingIO>( std::move( io ) );
+}
+
+
+//======================================================================================
+// StreamingReader
+//======================================================================================
+
+namespace
+{
+    enum ENTRY_STATE
+    {
+        ENTRY_READING = 0,
+        ENTRY_READY,
+        ENTRY_HELD,
+    };
+
+    // One buffer's worth of a stream, in stream order.
+    struct Entry
+    {
+        uint32_t    buffer;
+        uint32_t    state;
+        size_t      skew;       // Where the stream's bytes start in the buffer
+        size_t      bytes;
+    };
+
+    struct Stream
+    {
+        Stream() :
+            handle( 0 ),
+            generation( 0 ),
+            loop( false ),
+            failed( false ),
+            firstBuffer( false ),
+            priority( 0 ),
+            readAhead( 0 ),
+            start( 0 ),
+            end( 0 ),
+            next( 0 ),
+            head( 0 ),
+            acquire( 0 ),
+            tail( 0 ),
+            ticket( 0 ),
+            openTime( 0 )
+        {
+        }
+
+        unsigned int        handle;         // 0 when closed
+        uint16_t            generation;
+        bool                loop;
+        bool                failed;
+        bool                firstBuffer;
+        int                 priority;
+        size_t              readAhead;
+        uint64_t            start;          // File offsets
+        uint64_t            end;
+        uint64_t            next;           // Where the next read starts
+        uint64_t            head;           // Entry sequence: [head, acquire) are held by
+        uint64_t            acquire;        // the consumer, [acquire, tail) are reading
+        uint64_t            tail;           // or read
+        uint64_t            ticket;         // Last served or consumed, for ties
+        double              openTime;
+        std::vector<Entry>  entries;        // Ring indexed by sequence
+    };
+}
+
+
+// Internal object implementation class.
+class StreamingReader::Impl
+{
+public:
+    Impl( StreamingIO* io, size_t bufferBytes, size_t bufferCount, size_t maxReadsInFlight, size_t maxStreams );
+
+    ~Impl()
+    {
+        std::unique_lock<std::mutex> lock( mMutex );
+        mClosing = true;
+
+        for( auto it = mStreams.begin(); it != mStreams.end(); ++it )
+        {
+            if ( it->handle )
+                Close( *it );
+        }
+
+        // Completions still to come point at this object.
+        while ( mInFlight > 0 || mCallbacks > 0 )
+        {
+            mChanged.wait( lock );
+        }
+    }
+
+    // What it takes to start one read; filled under the lock, issued outside it.
+    struct ReadContext
+    {
+        Impl*           impl;
+        size_t          slot;
+        unsigned int    handle;
+        uint64_t        sequence;
+        double          issued;
+    };
+
+    Stream* Find( unsigned int handle );
+    Entry& EntryAt( Stream& s, uint64_t sequence ) { return s.entries[ static_cast<size_t>( sequence % s.entries.size() ) ]; }
+    uint8_t* BufferAt( size_t buffer ) { return mBuffers + buffer * mBufferBytes; }
+
+    void Close( Stream& s );
+    bool PickRead( ReadContext*& context, uint64_t& offset );
+    void Dispatch();
+    void Finish( ReadContext& context, size_t bytesRead, bool succeeded );
+
+    static void OnComplete( void* context, size_t bytesRead, bool succeeded );
+
+    StreamingIO*                mIO;
+    size_t                      mBufferBytes;
+    size_t                      mMaxInFlight;
+    std::unique_ptr<uint8_t[]>  mPool;
+    uint8_t*                    mBuffers;   // mPool aligned for unbuffered reads
+    std::vector<uint32_t>       mFree;
+    std::vector<ReadContext>    mContexts;  // One per buffer; a read owns its buffer
+    std::vector<Stream>         mStreams;
+    size_t                      mOpenStreams;
+    size_t                      mInFlight;
+    size_t                      mCallbacks;
+    uint64_t                    mTickets;
+    bool                        mClosing;
+    mutable std::mutex          mMutex;
+    std::condition_variable     mChanged;
+
+    uint64_t                    mReadsCompleted;
+    uint64_t                    mReadErrors;
+    uint64_t                    mBytesRead;
+    double                      mReadSeconds;
+    double                      mMaxReadSeconds;
+    uint64_t                    mFirstBuffers;
+    double                      mFirstBufferSeconds;
+    double                      mMaxFirstBufferSeconds;
+};
+
+
+StreamingReader::Impl::Impl( StreamingIO* io, size_t bufferBytes, size_t bufferCount, size_t maxReadsInFlight, size_t maxStreams ) :
+    mIO( io ),
+    mMaxInFlight( maxReadsInFlight ),
+    mBuffers( nullptr ),
+    mOpenStreams( 0 ),
+    mInFlight( 0 ),
+    mCallbacks( 0 ),
+    mTickets( 0 ),
+    mClosing( false ),
+    mReadsCompleted( 0 ),
+    mReadErrors( 0 ),
+    mBytesRead( 0 ),
+    mReadSeconds( 0 ),
+    mMaxReadSeconds( 0 ),
+    mFirstBuffers( 0 ),
+    mFirstBufferSeconds( 0 ),
+    mMaxFirstBufferSeconds( 0 )
+{
+    size_t alignment = std::max<size_t>( 1, io->GetAlignment() );
+    mBufferBytes = ( ( std::max( bufferBytes, alignment ) + alignment - 1 ) / alignment ) * alignment;
+
+    mPool.reset( new uint8_t[ mBufferBytes * bufferCount + alignment ] );
+    uintptr_t base = reinterpret_cast<uintptr_t>( mPool.get() );
+    mBuffers = mPool.get() + ( ( alignment - base % alignment ) % alignment );
+
+    mFree.reserve( bufferCount );
+    for( size_t j = bufferCount; j > 0; --j )
+    {
+        mFree.push_back( static_cast<uint32_t>( j - 1 ) );
+    }
+
+    mContexts.resize( bufferCount );
+
+    // A stream can own at most every buffer, so that is as long as its ring gets.
+    mStreams.resize( maxStreams );
+    for( auto it = mStreams.begin(); it != mStreams.end(); ++it )
+    {
+        it->entries.resize( bufferCount );
+    }
+}
+
+
+Stream* StreamingReader::Impl::Find( unsigned int handle )
+{
+    size_t slot = ( handle & 0xFFFF );
+    if ( !slot || slot > mStreams.size() )
+        return nullptr;
+
+    Stream& s = mStreams[ slot - 1 ];
+    return ( s.handle == handle ) ? &s : nullptr;
+}
+
+
+void StreamingReader::Impl::Close( Stream& s )
+{
+    // Reads in flight give their buffers back in Finish, as the handle won't match.
+    for( uint64_t j = s.head; j < s.tail; ++j )
+    {
+        Entry& e = EntryAt( s, j );
+        if ( e.state != ENTRY_READING )
+            mFree.push_back( e.buffer );
+    }
+
+    s.handle = 0;
+    --mOpenStreams;
+}
+
+
+bool StreamingReader::Impl::PickRead( ReadContext*& context, uint64_t& offset )
+{
+    if ( mClosing || mFree.empty() || mInFlight >= mMaxInFlight )
+        return false;
+
+    // Fewest buffers ahead of the consumer first. A consumer faster than the disk
+    // keeps every stream at none, so then a stream that hasn't started goes first,
+    // then priority, then whichever has waited longest.
+    Stream* best = nullptr;
+    for( auto it = mStreams.begin(); it != mStreams.end(); ++it )
+    {
+        Stream& s = *it;
+        if ( !s.handle || s.failed || s.next == s.end )
+            continue;
+
+        uint64_t ahead = s.tail - s.acquire;
+        if ( ahead >= s.readAhead || s.tail - s.head >= s.entries.size() )
+            continue;
+
+        if ( best )
+        {
+            uint64_t bestAhead = best->tail - best->acquire;
+            if ( ahead != bestAhead )
+            {
+                if ( ahead > bestAhead )
+                    continue;
+            }
+            else if ( ( s.tail == 0 ) != ( best->tail == 0 ) )
+            {
+                if ( s.tail != 0 )
+                    continue;
+            }
+            else if ( s.priority != best->priority )
+            {
+                if ( s.priority < best->priority )
+                    continue;
+            }
+            else if ( s.ticket > best->ticket )
+            {
+                continue;
+            }
+        }
+
+        best = &s;
+    }
+
+    if ( !best )
+        return false;
+
+    Stream& s = *best;
+
+    uint32_t buffer = mFree.back();
+    mFree.pop_back();
+
+    size_t alignment = mIO->GetAlignment();
+    uint64_t skew = s.next % alignment;
+
+    Entry& e = EntryAt( s, s.tail );
+    e.buffer = buffer;
+    e.state = ENTRY_READING;
+    e.skew = static_cast<size_t>( skew );
+    e.bytes = static_cast<size_t>( std::min<uint64_t>( mBufferBytes - skew, s.end - s.next ) );
+
+    ReadContext& c = mContexts[ buffer ];
+    c.impl = this;
+    c.slot = static_cast<size_t>( best - &mStreams[ 0 ] );
+    c.handle = s.handle;
+    c.sequence = s.tail;
+    c.issued = SteadyClock();
+
+    offset = s.next - skew;
+
+    ++s.tail;
+    s.ticket = ++mTickets;
+    s.next += e.bytes;
+    if ( s.next == s.end && s.loop )
+        s.next = s.start;
+
+    ++mInFlight;
+    context = &c;
+    return true;
+}
+
+
+void StreamingReader::Impl::Dispatch()
+{
+    for( ;; )
+    {
+        ReadContext* context = nullptr;
+        uint64_t offset = 0;
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            if ( !PickRead( context, offset ) )
+                return;
+        }
+
+        uint32_t buffer = static_cast<uint32_t>( context - &mContexts[ 0 ] );
+        if ( !mIO->Read( offset, BufferAt( buffer ), mBufferBytes, &Impl::OnComplete, context ) )
+        {
+            {
+                std::lock_guard<std::mutex> lock( mMutex );
+                Finish( *context, 0, false );
+            }
+            mChanged.notify_all();
+        }
+    }
+}
+
+
+void StreamingReader::Impl::Finish( ReadContext& context, size_t bytesRead, bool succeeded )
+{
+    --mInFlight;
+
+    double now = SteadyClock();
+    double seconds = now - context.issued;
+    mReadSeconds += seconds;
+    mMaxReadSeconds = std::max( mMaxReadSeconds, seconds );
+    ++mReadsCompleted;
+
+    uint32_t buffer = static_cast<uint32_t>( &context - &mContexts[ 0 ] );
+
+    Stream& s = mStreams[ context.slot ];
+    if ( s.handle != context.handle )
+    {
+        // Closed while this was reading
+        mFree.push_back( buffer );
+        return;
+    }
+
+    Entry& e = EntryAt( s, context.sequence );
+    if ( !succeeded || bytesRead < e.skew + e.bytes )
+    {
+        // Short of what the stream needs: an error, or a file cut off early
+        ++mReadErrors;
+        s.failed = true;
+        e.state = ENTRY_READY;
+        return;
+    }
+
+    mBytesRead += bytesRead;
+    e.state = ENTRY_READY;
+
+    if ( !s.firstBuffer && !context.sequence )
+    {
+        s.firstBuffer = true;
+        seconds = now - s.openTime;
+        ++mFirstBuffers;
+        mFirstBufferSeconds += seconds;
+        mMaxFirstBufferSeconds = std::max( mMaxFirstBufferSeconds, seconds );
+    }
+}
+
+
+void StreamingReader::Impl::OnComplete( void* context, size_t bytesRead, bool succeeded )
+{
+    auto c = static_cast<ReadContext*>( context );
+    Impl* impl = c->impl;
+
+    {
+        std::lock_guard<std::mutex> lock( impl->mMutex );
+        ++impl->mCallbacks;
+        impl->Finish( *c, bytesRead, succeeded );
+    }
+    impl->mChanged.notify_all();
+
+    // The slot just freed goes to the most urgent read waiting.
+    impl->Dispatch();
+
+    std::lock_guard<std::mutex> lock( impl->mMutex );
+    --impl->mCallbacks;
+    impl->mChanged.notify_all();
+}
+
+
+//--------------------------------------------------------------------------------------
+// StreamingReader
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+StreamingReader::StreamingReader( StreamingIO* io, size_t bufferBytes, size_t bufferCount, size_t maxReadsInFlight, size_t maxStreams )
+{
+    if ( !io || !bufferBytes || !bufferCount || bufferCount > UINT32_MAX || !maxReadsInFlight || !maxStreams || maxStreams > 0xFFFF )
+        throw std::invalid_argument( "StreamingReader" );
+
+    pImpl.reset( new Impl( io, bufferBytes, bufferCount, maxReadsInFlight, maxStreams ) );
+}
+
+
+// Move constructor.
+StreamingReader::StreamingReader(StreamingReader&& moveFrom)
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+StreamingReader& StreamingReader::operator= (StreamingReader&& moveFrom)
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+StreamingReader::~StreamingReader()
+{
+}
+
+
+// Public methods.
+unsigned int StreamingReader::OpenStream( uint64_t offset, uint64_t length, size_t readAhead, int priority, bool loop )
+{
+    if ( !length || offset + length < offset )
+        throw std::invalid_argument( "StreamingReader::OpenStream" );
+
+    unsigned int handle = 0;
+    {
+        std::lock_guard<std::mutex> lock( pImpl->mMutex );
+
+        auto it = std::find_if( pImpl->mStreams.begin(), pImpl->mStreams.end(), []( const Stream& s ) { return !s.handle; } );
+        if ( it == pImpl->mStreams.end() )
+            return 0;
+
+        Stream& s = *it;
+        s.loop = loop;
+        s.failed = false;
+        s.firstBuffer = false;
+        s.priority = priority;
+        s.readAhead = std::max<size_t>( 1, std::min( readAhead, s.entries.size() ) );
+        s.start = s.next = offset;
+        s.end = offset + length;
+        s.head = s.acquire = s.tail = 0;
+        s.ticket = ++pImpl->mTickets;
+        s.openTime = SteadyClock();
+
+        ++s.generation;
+        size_t slot = static_cast<size_t>( it - pImpl->mStreams.begin() );
+        s.handle = ( static_cast<unsigned int>( s.generation ) << 16 ) | static_cast<unsigned int>( slot + 1 );
+        ++pImpl->mOpenStreams;
+        handle = s.handle;
+    }
+
+    pImpl->Dispatch();
+    return handle;
+}
+
+
+void StreamingReader::CloseStream( unsigned int stream )
+{
+    {
+        std::lock_guard<std::mutex> lock( pImpl->mMutex );
+
+        Stream* s = pImpl->Find( stream );
+        if ( !s )
+            return;
+
+        pImpl->Close( *s );
+    }
+
+    pImpl->Dispatch();
+}
+
+
+bool StreamingReader::AcquireBuffer( unsigned int stream, StreamingBuffer& buffer )
+{
+    {
+        std::lock_guard<std::mutex> lock( pImpl->mMutex );
+
+        Stream* s = pImpl->Find( stream );
+        if ( !s || s->failed || s->acquire == s->tail )
+            return false;
+
+        Entry& e = pImpl->EntryAt( *s, s->acquire );
+        if ( e.state != ENTRY_READY )
+            return false;
+
+        e.state = ENTRY_HELD;
+        ++s->acquire;
+        s->ticket = ++pImpl->mTickets;
+
+        buffer.data = pImpl->BufferAt( e.buffer ) + e.skew;
+        buffer.bytes = e.bytes;
+    }
+
+    // One fewer buffer ahead of the consumer
+    pImpl->Dispatch();
+    return true;
+}
+
+
+void StreamingReader::ReleaseBuffer( unsigned int stream )
+{
+    {
+        std::lock_guard<std::mutex> lock( pImpl->mMutex );
+
+        Stream* s = pImpl->Find( stream );
+        if ( !s || s->head == s->acquire )
+            return;
+
+        pImpl->mFree.push_back( pImpl->EntryAt( *s, s->head ).buffer );
+        ++s->head;
+    }
+
+    pImpl->Dispatch();
+}
+
+
+bool StreamingReader::WaitForBuffer( unsigned int stream, unsigned int timeoutMilliseconds )
+{
+    std::unique_lock<std::mutex> lock( pImpl->mMutex );
+
+    Impl* impl = pImpl.get();
+    auto ready = [impl, stream]() -> bool
+    {
+        Stream* s = impl->Find( stream );
+        if ( !s || s->failed )
+            return true;
+
+        if ( s->acquire < s->tail )
+            return impl->EntryAt( *s, s->acquire ).state == ENTRY_READY;
+
+        return !s->loop && s->next == s->end;
+    };
+
+    pImpl->mChanged.wait_for( lock, std::chrono::milliseconds( timeoutMilliseconds ), ready );
+
+    Stream* s = pImpl->Find( stream );
+    return s && !s->failed && s->acquire < s->tail && pImpl->EntryAt( *s, s->acquire ).state == ENTRY_READY;
+}
+
+
+bool StreamingReader::IsEndOfStream( unsigned int stream ) const
+{
+    std::lock_guard<std::mutex> lock( pImpl->mMutex );
+
+    const Stream* s = pImpl->Find( stream );
+    if ( !s || s->failed )
+        return true;
+
+    return !s->loop && s->next == s->end && s->acquire == s->tail;
+}
+
+
+bool StreamingReader::HasFailed( unsigned int stream ) const
+{
+    std::lock_guard<std::mutex> lock( pImpl->mMutex );
+
+    const Stream* s = pImpl->Find( stream );
+    return s && s->failed;
+}
+
+
+size_t StreamingReader::GetBufferBytes() const
+{
+    return pImpl->mBufferBytes;
+}
+
+
+StreamingStatistics StreamingReader::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( pImpl->mMutex );
+
+    StreamingStatistics stats;
+    stats.openStreams = pImpl->mOpenStreams;
+    stats.buffersFree = pImpl->mFree.size();
+    stats.readsInFlight = pImpl->mInFlight;
+    stats.readsCompleted = pImpl->mReadsCompleted;
+    stats.readErrors = pImpl->mReadErrors;
+    stats.bytesRead = pImpl->mBytesRead;
+    stats.averageReadSeconds = pImpl->mReadsCompleted ? pImpl->mReadSeconds / double( pImpl->mReadsCompleted ) : 0;
+    stats.maxReadSeconds = pImpl->mMaxReadSeconds;
+    stats.firstBuffers = pImpl->mFirstBuffers;
+    stats.averageFirstBufferSeconds = pImpl->mFirstBuffers ? pImpl->mFirstBufferSeconds / double( pImpl->mFirstBuffers ) : 0;
+    stats.maxFirstBufferSeconds = pImpl->mMaxFirstBufferSeconds;
+    return stats;
+}
+
+
+size_t StreamingReader::ComputeReadAhead( uint32_t bytesPerSecond, size_t bufferBytes, double ioLatencySeconds )
+{
+    if ( !bufferBytes )
+        return 2;
+
+    double bytes = double( bytesPerSecond ) * std::max( 0.0, ioLatencySeconds );
+    size_t buffers = static_cast<size_t>( ceil( bytes / double( bufferBytes ) ) ) + 1;
+    return std::max<size_t>( 2, buffers );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+StreamingBenchmark DirectX::BenchmarkStreamingReader( const MappedFileChar* fileName, size_t streamCount, size_t readAhead,
+                                                      size_t bufferBytes, unsigned int threadCount, double seconds, bool unbuffered )
+{
+    StreamingBenchmark result;
+    memset( &result, 0, sizeof(result) );
+
+    streamCount = std::max<size_t>( 1, std::min<size_t>( streamCount, 0xFFFF ) );
+    readAhead = std::max<size_t>( 1, readAhead );
+    result.streams = streamCount;
+
+    auto io = CreateThreadPoolStreamingIO( fileName, threadCount, unbuffered );
+    if ( !io )
+        return result;
+
+    // A buffer per stream beyond its read-ahead, for the one being consumed.
+    StreamingReader reader( io.get(), bufferBytes, streamCount * ( readAhead + 1 ),
+                            std::max<size_t>( 4, size_t( threadCount ) * 2 ), streamCount );
+    bufferBytes = reader.GetBufferBytes();
+
+    size_t alignment = io->GetAlignment();
+    uint64_t fileSize = io->GetFileSize() - io->GetFileSize() % alignment;
+    if ( fileSize < bufferBytes )
+        return result;
+
+    // Each stream loops over a stretch of the file; a restart moves it somewhere random.
+    uint64_t stretch = std::max<uint64_t>( bufferBytes, ( fileSize / streamCount ) - ( fileSize / streamCount ) % alignment );
+    uint32_t random = 0x9E3779B9u;
+    auto place = [&]() -> uint64_t
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        uint64_t blocks = ( fileSize - stretch ) / alignment + 1;
+        return ( random % blocks ) * alignment;
+    };
+
+    std::vector<unsigned int> streams( streamCount );
+    std::vector<double> restarted( streamCount, 0 );
+    for( size_t j = 0; j < streamCount; ++j )
+    {
+        uint64_t offset = std::min( j * stretch, fileSize - stretch );
+        streams[ j ] = reader.OpenStream( offset, stretch, readAhead, 0, true );
+    }
+
+    double firstBufferSeconds = 0;
+    size_t firstBuffers = 0;
+    size_t nextRestart = 0;
+
+    double start = SteadyClock();
+    double restartTime = start + 0.01;
+    double now = start;
+    while ( now - start < seconds )
+    {
+        bool consumed = false;
+        size_t waitFor = 0;
+        for( size_t j = 0; j < streamCount; ++j )
+        {
+            StreamingBuffer buffer;
+            if ( reader.AcquireBuffer( streams[ j ], buffer ) )
+            {
+                reader.ReleaseBuffer( streams[ j ] );
+                consumed = true;
+
+                if ( restarted[ j ] > 0 )
+                {
+                    double latency = SteadyClock() - restarted[ j ];
+                    firstBufferSeconds += latency;
+                    result.maxFirstBufferSeconds = std::max( result.maxFirstBufferSeconds, latency );
+                    ++firstBuffers;
+                    restarted[ j ] = 0;
+                }
+            }
+            else if ( restarted[ j ] > 0 )
+            {
+                waitFor = j;
+            }
+        }
+
+        now = SteadyClock();
+        if ( now >= restartTime )
+        {
+            size_t j = nextRestart++ % streamCount;
+            reader.CloseStream( streams[ j ] );
+            restarted[ j ] = SteadyClock();
+            streams[ j ] = reader.OpenStream( place(), stretch, readAhead, 0, true );
+            restartTime += 0.01;
+        }
+        else if ( !consumed )
+        {
+            reader.WaitForBuffer( streams[ waitFor ], 1 );
+        }
+    }
+
+    double elapsed = SteadyClock() - start;
+    auto stats = reader.GetStatistics();
+
+    result.bytesRead = stats.bytesRead;
+    result.seconds = elapsed;
+    result.megabytesPerSecond = ( elapsed > 0 ) ? double( stats.bytesRead ) / ( 1024.0 * 1024.0 ) / elapsed : 0;
+    result.averageReadSeconds = stats.averageReadSeconds;
+    result.averageFirstBufferSeconds = firstBuffers ? firstBufferSeconds / double( firstBuffers ) : 0;
+    return result;
+}
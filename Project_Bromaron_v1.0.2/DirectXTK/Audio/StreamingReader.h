@@ -0,0 +1,154 @@
+//--------------------------------------------------------------------------------------
+// File: StreamingReader.h
+//
+// Reads many audio streams from one file at once through a pool of aligned,
+// fixed-size buffers
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+#include "MappedFile.h"
+
+
+namespace DirectX
+{
+    // StreamingIO is the whole I/O layer; StreamingReader only ever asks it for
+    // aligned reads, so a backend built on IOCP or io_uring drops in beside the
+    // thread pool one below.
+
+    class StreamingIO
+    {
+    public:
+        // Called once per read, from any thread but never from inside Read.
+        typedef void (*Completion)( void* context, size_t bytesRead, bool succeeded );
+
+        virtual ~StreamingIO() {}
+
+        // Starts reading bytes at offset into dest; all three are multiples of
+        // GetAlignment(). A read that passes the end of the file completes short.
+        // Returns false if the read couldn't be started, in which case completion
+        // is never called.
+        virtual bool Read( uint64_t offset, uint8_t* dest, size_t bytes, Completion completion, void* context ) = 0;
+
+        virtual size_t GetAlignment() const = 0;
+        virtual uint64_t GetFileSize() const = 0;
+    };
+
+    // threadCount threads each doing blocking positional reads: pread, or ReadFile
+    // at an offset on Windows, where each thread has its own handle because reads
+    // on one synchronous handle are serialized. unbuffered bypasses the OS cache
+    // (O_DIRECT or FILE_FLAG_NO_BUFFERING) where the file system allows it. Returns
+    // nullptr if the file can't be opened.
+    std::unique_ptr<StreamingIO> CreateThreadPoolStreamingIO( const MappedFileChar* fileName, unsigned int threadCount = 2, bool unbuffered = true );
+
+
+    struct StreamingBuffer
+    {
+        const uint8_t*  data;
+        size_t          bytes;
+    };
+
+    struct StreamingStatistics
+    {
+        size_t      openStreams;
+        size_t      buffersFree;
+        size_t      readsInFlight;
+        uint64_t    readsCompleted;
+        uint64_t    readErrors;
+        uint64_t    bytesRead;
+        double      averageReadSeconds;         // Read issued to read complete
+        double      maxReadSeconds;
+        uint64_t    firstBuffers;               // Streams that have had a first buffer
+        double      averageFirstBufferSeconds;  // OpenStream to its first buffer ready
+        double      maxFirstBufferSeconds;
+    };
+
+    class StreamingReader
+    {
+    public:
+        // bufferBytes is rounded up to the I/O alignment. At most maxReadsInFlight
+        // reads are given to io at once; the rest wait here, so the next read to go
+        // is always the most urgent one. io must outlive the reader.
+        StreamingReader( StreamingIO* io, size_t bufferBytes = 65536, size_t bufferCount = 64,
+                         size_t maxReadsInFlight = 16, size_t maxStreams = 64 );
+
+        StreamingReader(StreamingReader&& moveFrom);
+        StreamingReader& operator= (StreamingReader&& moveFrom);
+
+        // Waits for the reads in flight.
+        virtual ~StreamingReader();
+
+        // Streams [offset, offset + length) of the file, keeping up to readAhead
+        // buffers read or being read ahead of the consumer; loop starts again at
+        // offset after the end. The read with the fewest buffers ahead of its
+        // consumer goes first, so a stream starting now beats every read-ahead;
+        // among equals a stream yet to start wins, then higher priority, then the
+        // one waiting longest. Returns a handle that is never 0, or 0 if every
+        // stream is in use.
+        unsigned int OpenStream( uint64_t offset, uint64_t length, size_t readAhead, int priority = 0, bool loop = false );
+
+        // Buffers held by the consumer go back to the pool; reads in flight go back
+        // as they complete.
+        void CloseStream( unsigned int stream );
+
+        // Hands over the stream's next buffer, in order, if it has been read. The
+        // consumer can hold several; ReleaseBuffer gives back the oldest.
+        bool AcquireBuffer( unsigned int stream, StreamingBuffer& buffer );
+        void ReleaseBuffer( unsigned int stream );
+
+        // Waits until AcquireBuffer would succeed or the stream has ended.
+        bool WaitForBuffer( unsigned int stream, unsigned int timeoutMilliseconds );
+
+        // Every buffer has been acquired, or a read failed.
+        bool IsEndOfStream( unsigned int stream ) const;
+        bool HasFailed( unsigned int stream ) const;
+
+        size_t GetBufferBytes() const;
+
+        StreamingStatistics GetStatistics() const;
+
+        // Buffers needed ahead of a consumer of bytesPerSecond to ride out reads
+        // taking ioLatencySeconds, plus one being consumed. Never less than 2.
+        static size_t ComputeReadAhead( uint32_t bytesPerSecond, size_t bufferBytes, double ioLatencySeconds );
+
+    private:
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        StreamingReader(StreamingReader const&);
+        StreamingReader& operator= (StreamingReader const&);
+    };
+
+
+    struct StreamingBenchmark
+    {
+        size_t      streams;
+        uint64_t    bytesRead;
+        double      seconds;
+        double      megabytesPerSecond;         // Sustained, all streams together
+        double      averageReadSeconds;
+        double      averageFirstBufferSeconds;  // Streams restarted while the others read
+        double      maxFirstBufferSeconds;
+    };
+
+    // Keeps streamCount looping streams spread across fileName reading for seconds,
+    // consuming each buffer as soon as it arrives, and restarts one stream at a new
+    // place every 10 ms to time its first buffer under that load.
+    StreamingBenchmark BenchmarkStreamingReader( const MappedFileChar* fileName, size_t streamCount, size_t readAhead,
+                                                 size_t bufferBytes, unsigned int threadCount, double seconds, bool unbuffered = true );
+}
@@ -0,0 +1,380 @@
+//--------------------------------------------------------------------------------------
+// File: StreamingWaveBank.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "StreamingWaveBank.h"
+#include "WaveBankReader.h"
+#include "SoundCommon.h"
+#include "PlatformHelpers.h"
+
+using namespace DirectX;
+
+namespace
+{
+    // DynamicSoundEffectInstance calls back when two or fewer buffers are left,
+    // so keeping three queued means one is always playing while it waits.
+    const int QueueDepth = 3;
+
+    // Reads are assumed to take at least this long until some have been timed.
+    const double MinReadSeconds = 0.05;
+
+    // Played while the stream's next buffer is still being read, so the voice
+    // keeps calling back.
+    const uint32_t SilenceMilliseconds = 10;
+
+    // Shared by the bank and its streams; the reader goes before the I/O it uses.
+    struct StreamingWaveBankIO
+    {
+        StreamingWaveBankIO( std::unique_ptr<StreamingIO>&& io, size_t bufferBytes, size_t bufferCount ) :
+            mIO( std::move( io ) ),
+            mReader( mIO.get(), bufferBytes, bufferCount )
+        {
+        }
+
+        std::unique_ptr<StreamingIO>    mIO;
+        StreamingReader                 mReader;
+    };
+}
+
+
+//======================================================================================
+// WaveBankStream
+//======================================================================================
+
+// Internal object implementation class.
+class WaveBankStream::Impl
+{
+public:
+    Impl( _In_ AudioEngine* engine, const std::shared_ptr<StreamingWaveBankIO>& io, unsigned int stream,
+          _In_ const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags ) :
+        mIO( io ),
+        mStream( stream ),
+        mStarted( false ),
+        mEnded( false ),
+        mUnderruns( 0 ),
+        mQueued( 0 ),
+        mQueueHead( 0 )
+    {
+        memset( mFromStream, 0, sizeof(mFromStream) );
+
+        // Everything the callback touches is allocated here.
+        size_t frames = std::max<size_t>( 1, wfx->nSamplesPerSec * SilenceMilliseconds / 1000 );
+        mSilence.resize( frames * wfx->nBlockAlign, static_cast<uint8_t>( ( wfx->wBitsPerSample == 8 ) ? 0x80 : 0 ) );
+
+        mInstance.reset( new DynamicSoundEffectInstance( engine,
+            [this]( DynamicSoundEffectInstance* instance ) { OnBufferNeeded( instance ); },
+            static_cast<int>( wfx->nSamplesPerSec ), wfx->nChannels, wfx->wBitsPerSample, flags ) );
+    }
+
+    ~Impl()
+    {
+        // The voice goes first; it may still be reading buffers the stream holds.
+        mInstance.reset();
+        mIO->mReader.CloseStream( mStream );
+    }
+
+    void OnBufferNeeded( DynamicSoundEffectInstance* instance );
+
+    std::shared_ptr<StreamingWaveBankIO>            mIO;
+    std::unique_ptr<DynamicSoundEffectInstance>     mInstance;
+    unsigned int                                    mStream;
+    bool                                            mStarted;
+    bool                                            mEnded;
+    size_t                                          mUnderruns;
+    int                                             mQueued;
+    int                                             mQueueHead;
+    bool                                            mFromStream[ QueueDepth ];  // Otherwise silence
+    std::vector<uint8_t>                            mSilence;
+};
+
+
+void WaveBankStream::Impl::OnBufferNeeded( DynamicSoundEffectInstance* instance )
+{
+    StreamingReader& reader = mIO->mReader;
+
+    // Buffers play in order, so the oldest submitted are the ones finished.
+    for( int pending = instance->GetPendingBufferCount(); mQueued > pending; --mQueued )
+    {
+        if ( mFromStream[ mQueueHead ] )
+            reader.ReleaseBuffer( mStream );
+
+        mQueueHead = ( mQueueHead + 1 ) % QueueDepth;
+    }
+
+    while( mQueued < QueueDepth )
+    {
+        int tail = ( mQueueHead + mQueued ) % QueueDepth;
+
+        StreamingBuffer buffer;
+        if ( reader.AcquireBuffer( mStream, buffer ) )
+        {
+            instance->SubmitBuffer( buffer.data, buffer.bytes );
+            mFromStream[ tail ] = true;
+            mStarted = true;
+        }
+        else if ( reader.IsEndOfStream( mStream ) )
+        {
+            mEnded = ( mQueued == 0 );
+            break;
+        }
+        else if ( mQueued == 0 )
+        {
+            // Nothing is left to call back on, so play silence until the read lands.
+            instance->SubmitBuffer( &mSilence[ 0 ], mSilence.size() );
+            mFromStream[ tail ] = false;
+
+            if ( mStarted )
+                ++mUnderruns;
+        }
+        else
+        {
+            break;
+        }
+
+        ++mQueued;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// WaveBankStream
+//--------------------------------------------------------------------------------------
+
+// Private constructor.
+WaveBankStream::WaveBankStream( Impl* impl ) :
+    pImpl( impl )
+{
+}
+
+
+// Public destructor.
+WaveBankStream::~WaveBankStream()
+{
+}
+
+
+// Public methods.
+void WaveBankStream::Play()
+{
+    pImpl->mInstance->Play();
+}
+
+
+void WaveBankStream::Stop( bool immediate )
+{
+    pImpl->mInstance->Stop( immediate );
+}
+
+
+DynamicSoundEffectInstance* WaveBankStream::GetInstance()
+{
+    return pImpl->mInstance.get();
+}
+
+
+bool WaveBankStream::IsEndOfStream() const
+{
+    return pImpl->mEnded;
+}
+
+
+size_t WaveBankStream::GetUnderrunCount() const
+{
+    return pImpl->mUnderruns;
+}
+
+
+//======================================================================================
+// StreamingWaveBank
+//======================================================================================
+
+// Internal object implementation class.
+class StreamingWaveBank::Impl
+{
+public:
+    explicit Impl( _In_ AudioEngine* engine ) :
+        mEngine( engine ),
+        mAudioOffset( 0 )
+    {
+    }
+
+    HRESULT Initialize( _In_z_ const wchar_t* wbFileName, size_t bufferBytes, size_t bufferCount, unsigned int ioThreads );
+
+    AudioEngine*                            mEngine;
+    WaveBankReader                          mReader;
+    uint64_t                                mAudioOffset;
+    std::shared_ptr<StreamingWaveBankIO>    mIO;
+};
+
+
+_Use_decl_annotations_
+HRESULT StreamingWaveBank::Impl::Initialize( const wchar_t* wbFileName, size_t bufferBytes, size_t bufferCount, unsigned int ioThreads )
+{
+    HRESULT hr = mReader.Open( wbFileName );
+    if ( FAILED(hr) )
+        return hr;
+
+    if ( !mReader.IsStreamingBank() )
+    {
+        DebugTrace( "ERROR: StreamingWaveBank needs a streaming wave bank; use WaveBank for in-memory ones\n" );
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+    }
+
+    mAudioOffset = mReader.BankAudioOffset();
+
+    auto io = CreateThreadPoolStreamingIO( wbFileName, ioThreads );
+    if ( !io )
+    {
+        DWORD error = GetLastError();
+        return error ? HRESULT_FROM_WIN32( error ) : E_FAIL;
+    }
+
+    mIO = std::make_shared<StreamingWaveBankIO>( std::move( io ), bufferBytes, bufferCount );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// StreamingWaveBank
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+_Use_decl_annotations_
+StreamingWaveBank::StreamingWaveBank( AudioEngine* engine, const wchar_t* wbFileName,
+                                      size_t bufferBytes, size_t bufferCount, unsigned int ioThreads )
+{
+    if ( !engine || !wbFileName || !bufferBytes || !bufferCount || !ioThreads )
+        throw std::invalid_argument( "StreamingWaveBank" );
+
+    pImpl.reset( new Impl( engine ) );
+
+    HRESULT hr = pImpl->Initialize( wbFileName, bufferBytes, bufferCount, ioThreads );
+    if ( FAILED(hr) )
+    {
+        DebugTrace( "ERROR: StreamingWaveBank failed (%08X) to intialize from .xwb file \"%S\"\n", hr, wbFileName );
+        throw std::exception( "StreamingWaveBank" );
+    }
+
+    DebugTrace( "INFO: StreamingWaveBank \"%s\" with %u entries opened from .xwb file \"%S\"\n",
+                pImpl->mReader.BankName(), pImpl->mReader.Count(), wbFileName );
+}
+
+
+// Move constructor.
+StreamingWaveBank::StreamingWaveBank(StreamingWaveBank&& moveFrom)
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+StreamingWaveBank& StreamingWaveBank::operator= (StreamingWaveBank&& moveFrom)
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+StreamingWaveBank::~StreamingWaveBank()
+{
+}
+
+
+// Public methods.
+std::unique_ptr<WaveBankStream> StreamingWaveBank::CreateStream( int index, bool loop, int priority, SOUND_EFFECT_INSTANCE_FLAGS flags )
+{
+    auto& wb = pImpl->mReader;
+
+    if ( index < 0 || uint32_t(index) >= wb.Count() )
+    {
+        // We don't throw an exception here as titles often simply ignore missing assets rather than fail
+        return std::unique_ptr<WaveBankStream>();
+    }
+
+    char wfxbuff[64];
+    auto wfx = reinterpret_cast<WAVEFORMATEX*>( wfxbuff );
+    ThrowIfFailed( wb.GetFormat( index, wfx, 64 ) );
+
+    WaveBankReader::Metadata metadata;
+    ThrowIfFailed( wb.GetMetadata( index, metadata ) );
+
+    StreamingReader& reader = pImpl->mIO->mReader;
+    uint64_t offset = pImpl->mAudioOffset + metadata.offsetBytes;
+
+    // Every buffer but the first starts on the I/O alignment and the first starts
+    // at the entry, so each holds whole blocks only if both are block aligned.
+    uint32_t blockAlign = wfx->nBlockAlign;
+    if ( GetFormatTag( wfx ) != WAVE_FORMAT_PCM
+         || ( wfx->wBitsPerSample != 8 && wfx->wBitsPerSample != 16 )
+         || !blockAlign || ( blockAlign & ( blockAlign - 1 ) ) != 0
+         || ( pImpl->mIO->mIO->GetAlignment() % blockAlign ) != 0
+         || ( offset % blockAlign ) != 0 )
+    {
+        DebugTrace( "ERROR: StreamingWaveBank entry %d isn't 8-bit or 16-bit PCM with a power of two block size\n", index );
+        throw std::exception( "StreamingWaveBank::CreateStream" );
+    }
+
+    if ( !metadata.lengthBytes )
+        return std::unique_ptr<WaveBankStream>();
+
+    StreamingStatistics stats = reader.GetStatistics();
+    double readSeconds = std::max( MinReadSeconds, 2.0 * stats.averageReadSeconds );
+    size_t readAhead = StreamingReader::ComputeReadAhead( wfx->nAvgBytesPerSec, reader.GetBufferBytes(), readSeconds );
+
+    unsigned int stream = reader.OpenStream( offset, metadata.lengthBytes, readAhead, priority, loop );
+    if ( !stream )
+    {
+        DebugTrace( "WARNING: StreamingWaveBank has no streams free, entry %d not streamed\n", index );
+        return std::unique_ptr<WaveBankStream>();
+    }
+
+    std::unique_ptr<WaveBankStream::Impl> impl;
+    try
+    {
+        impl.reset( new WaveBankStream::Impl( pImpl->mEngine, pImpl->mIO, stream, wfx, flags ) );
+    }
+    catch( ... )
+    {
+        reader.CloseStream( stream );
+        throw;
+    }
+
+    return std::unique_ptr<WaveBankStream>( new WaveBankStream( impl.release() ) );
+}
+
+
+std::unique_ptr<WaveBankStream> StreamingWaveBank::CreateStream( const char* name, bool loop, int priority, SOUND_EFFECT_INSTANCE_FLAGS flags )
+{
+    int index = Find( name );
+    if ( index == -1 )
+    {
+        // We don't throw an exception here as titles often simply ignore missing assets rather than fail
+        return std::unique_ptr<WaveBankStream>();
+    }
+
+    return CreateStream( index, loop, priority, flags );
+}
+
+
+int StreamingWaveBank::Find( const char* name ) const
+{
+    return static_cast<int>( pImpl->mReader.Find( name ) );
+}
+
+
+StreamingStatistics StreamingWaveBank::GetStatistics() const
+{
+    return pImpl->mIO->mReader.GetStatistics();
+}
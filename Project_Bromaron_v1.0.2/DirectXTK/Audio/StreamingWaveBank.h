@@ -0,0 +1,99 @@
+//--------------------------------------------------------------------------------------
+// File: StreamingWaveBank.h
+//
+// Plays entries of a streaming wave bank through DynamicSoundEffectInstances fed
+// by a StreamingReader
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Audio.h"
+#include "StreamingReader.h"
+
+
+namespace DirectX
+{
+    // WaveBank only plays in-memory banks. Here every stream shares one pool of
+    // bufferCount buffers read by ioThreads threads, and XAudio2 plays each buffer
+    // in place. Only 8-bit and 16-bit PCM entries can stream, and only with a
+    // block size that is a power of two, so that every buffer holds whole blocks.
+    // Like any DynamicSoundEffectInstance a stream is fed from AudioEngine::Update,
+    // so call Play and Stop on that thread.
+
+    class WaveBankStream
+    {
+    public:
+        virtual ~WaveBankStream();
+
+        // Plays the entry once, or loops the whole of it. Play after Stop carries
+        // on from the next buffer; create another stream to start over.
+        void __cdecl Play();
+        void __cdecl Stop( bool immediate = true );
+
+        // Volume, pitch, pause and Apply3D.
+        DynamicSoundEffectInstance* __cdecl GetInstance();
+
+        // Every buffer has played, or a read failed.
+        bool __cdecl IsEndOfStream() const;
+
+        // Times a buffer wasn't read in time and silence played instead.
+        size_t __cdecl GetUnderrunCount() const;
+
+    private:
+        friend class StreamingWaveBank;
+
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        explicit WaveBankStream( Impl* impl );
+
+        // Prevent copying.
+        WaveBankStream(WaveBankStream const&);
+        WaveBankStream& operator= (WaveBankStream const&);
+    };
+
+    class StreamingWaveBank
+    {
+    public:
+        // The bank must be a streaming one. Streams keep the reader alive, so they
+        // may outlive the bank.
+        StreamingWaveBank( _In_ AudioEngine* engine, _In_z_ const wchar_t* wbFileName,
+                           size_t bufferBytes = 65536, size_t bufferCount = 64, unsigned int ioThreads = 2 );
+
+        StreamingWaveBank(StreamingWaveBank&& moveFrom);
+        StreamingWaveBank& operator= (StreamingWaveBank&& moveFrom);
+        virtual ~StreamingWaveBank();
+
+        // Reads ahead as far as the entry's data rate needs to ride out the reads
+        // seen so far. A stream starting now is read before any stream's
+        // read-ahead; priority, higher first, settles streams that are equally
+        // short. Returns nullptr if the entry isn't there or every stream is in use.
+        std::unique_ptr<WaveBankStream> __cdecl CreateStream( int index, bool loop = false, int priority = 0,
+                                                              SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default );
+        std::unique_ptr<WaveBankStream> __cdecl CreateStream( _In_z_ const char* name, bool loop = false, int priority = 0,
+                                                              SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default );
+
+        int __cdecl Find( _In_z_ const char* name ) const;
+
+        StreamingStatistics __cdecl GetStatistics() const;
+
+    private:
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        StreamingWaveBank(StreamingWaveBank const&);
+        StreamingWaveBank& operator= (StreamingWaveBank const&);
+    };
+}
@@ -0,0 +1,197 @@
+//--------------------------------------------------------------------------------------
+// File: SynthSoundEffect.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "SynthSoundEffect.h"
+#include "SoundCommon.h"
+
+using namespace DirectX;
+
+
+//======================================================================================
+// SynthSoundEffect
+//======================================================================================
+
+// Internal object implementation class.
+class SynthSoundEffect::Impl
+{
+public:
+    Impl( _In_ AudioEngine* engine, int sampleRate, int channels, size_t maxVoices,
+          size_t bufferCount, size_t bufferFrames, SOUND_EFFECT_INSTANCE_FLAGS flags ) :
+        mSynth( sampleRate, channels, maxVoices ),
+        mBufferCount( bufferCount ),
+        mBufferFrames( bufferFrames ),
+        mBufferSamples( bufferFrames * channels ),
+        mNextBuffer( 0 )
+    {
+        // Everything the callback touches is allocated here.
+        mMix.resize( mBufferSamples );
+        mBuffers.resize( mBufferSamples * bufferCount );
+
+        mInstance.reset( new DynamicSoundEffectInstance( engine,
+            [this]( DynamicSoundEffectInstance* instance ) { OnBufferNeeded( instance ); },
+            sampleRate, channels, 16, flags ) );
+    }
+
+    ~Impl()
+    {
+        // The voice goes first; it may still be reading the ring.
+        mInstance.reset();
+    }
+
+    void OnBufferNeeded( DynamicSoundEffectInstance* instance );
+
+    ProceduralSynth                                 mSynth;
+    std::unique_ptr<DynamicSoundEffectInstance>     mInstance;
+    size_t                                          mBufferCount;
+    size_t                                          mBufferFrames;
+    size_t                                          mBufferSamples;
+    size_t                                          mNextBuffer;
+    std::vector<float>                              mMix;
+    std::vector<int16_t>                            mBuffers;   // The ring; XAudio2 reads them in place
+};
+
+
+void SynthSoundEffect::Impl::OnBufferNeeded( DynamicSoundEffectInstance* instance )
+{
+    // Buffers play in order, so with fewer than mBufferCount queued the next one
+    // in the ring has finished and can be written again.
+    for( int pending = instance->GetPendingBufferCount(); pending < static_cast<int>( mBufferCount ); ++pending )
+    {
+        int16_t* buffer = &mBuffers[ mNextBuffer * mBufferSamples ];
+
+        // Silence keeps the voice running, so the next buffer end calls back again.
+        if ( mSynth.GetStatistics().playingVoices > 0 )
+        {
+            mSynth.Render( &mMix[ 0 ], mBufferFrames );
+
+            for( size_t j = 0; j < mBufferSamples; ++j )
+            {
+                float s = std::min( 1.f, std::max( -1.f, mMix[ j ] ) );
+                buffer[ j ] = static_cast<int16_t>( s * 32767.f );
+            }
+        }
+        else
+        {
+            memset( buffer, 0, mBufferSamples * sizeof(int16_t) );
+        }
+
+        instance->SubmitBuffer( reinterpret_cast<const uint8_t*>( buffer ), mBufferSamples * sizeof(int16_t) );
+
+        mNextBuffer = ( mNextBuffer + 1 ) % mBufferCount;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// SynthSoundEffect
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+_Use_decl_annotations_
+SynthSoundEffect::SynthSoundEffect( AudioEngine* engine, size_t maxVoices, size_t bufferCount, size_t bufferFrames,
+                                    SOUND_EFFECT_INSTANCE_FLAGS flags )
+{
+    if ( !engine || !bufferCount || !bufferFrames )
+        throw std::invalid_argument( "SynthSoundEffect" );
+
+    // Render at the mastering rate so XAudio2 has nothing to convert.
+    int sampleRate = static_cast<int>( engine->GetOutputFormat().Format.nSamplesPerSec );
+    if ( sampleRate < XAUDIO2_MIN_SAMPLE_RATE || sampleRate > XAUDIO2_MAX_SAMPLE_RATE )
+        sampleRate = 48000;
+
+    int channels = ( flags & SoundEffectInstance_Use3D ) ? 1 : 2;
+
+    pImpl.reset( new Impl( engine, sampleRate, channels, maxVoices, bufferCount, bufferFrames, flags ) );
+    pImpl->mInstance->Play();
+}
+
+
+// Move constructor.
+SynthSoundEffect::SynthSoundEffect(SynthSoundEffect&& moveFrom)
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+SynthSoundEffect& SynthSoundEffect::operator= (SynthSoundEffect&& moveFrom)
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+SynthSoundEffect::~SynthSoundEffect()
+{
+}
+
+
+// Public methods.
+unsigned int SynthSoundEffect::Play( const SynthPatch& patch, float volume, float pan )
+{
+    return pImpl->mSynth.Play( patch, volume, pan );
+}
+
+
+unsigned int SynthSoundEffect::PlayWeapon( int weaponType, float energy, float pan )
+{
+    SynthPatch patch;
+    GetWeaponPatch( weaponType, energy, patch );
+    return pImpl->mSynth.Play( patch, 1.f, pan );
+}
+
+
+unsigned int SynthSoundEffect::PlayExplosion( float energy, float pan )
+{
+    SynthPatch patch;
+    GetExplosionPatch( energy, patch );
+    return pImpl->mSynth.Play( patch, 1.f, pan );
+}
+
+
+void SynthSoundEffect::Release( unsigned int voice )
+{
+    pImpl->mSynth.Release( voice );
+}
+
+
+void SynthSoundEffect::Stop( unsigned int voice )
+{
+    pImpl->mSynth.Stop( voice );
+}
+
+
+void SynthSoundEffect::StopAll()
+{
+    pImpl->mSynth.StopAll();
+}
+
+
+bool SynthSoundEffect::IsPlaying( unsigned int voice ) const
+{
+    return pImpl->mSynth.IsPlaying( voice );
+}
+
+
+DynamicSoundEffectInstance* SynthSoundEffect::GetInstance()
+{
+    return pImpl->mInstance.get();
+}
+
+
+ProceduralSynthStatistics SynthSoundEffect::GetStatistics() const
+{
+    return pImpl->mSynth.GetStatistics();
+}
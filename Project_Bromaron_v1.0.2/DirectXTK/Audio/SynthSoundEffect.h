@@ -0,0 +1,71 @@
+//--------------------------------------------------------------------------------------
+// File: SynthSoundEffect.h
+//
+// Plays a ProceduralSynth through a DynamicSoundEffectInstance from a preallocated
+// ring of buffers
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Audio.h"
+#include "ProceduralSynth.h"
+
+
+namespace DirectX
+{
+    // Every note shares one source voice at the mastering voice's sample rate:
+    // stereo, or mono with SoundEffectInstance_Use3D so Apply3D can place it.
+    // The BufferNeeded callback renders into the next buffer of the ring and
+    // submits it, without allocating. Like any DynamicSoundEffectInstance it is
+    // fed from AudioEngine::Update, so call Play and Release on that thread.
+
+    class SynthSoundEffect
+    {
+    public:
+        // bufferCount buffers of bufferFrames each are kept queued; together they
+        // must outlast the time between AudioEngine::Update calls, and they set
+        // how soon a new note is heard.
+        SynthSoundEffect( _In_ AudioEngine* engine, size_t maxVoices = 32,
+                          size_t bufferCount = 4, size_t bufferFrames = 512,
+                          SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default );
+
+        SynthSoundEffect(SynthSoundEffect&& moveFrom);
+        SynthSoundEffect& operator= (SynthSoundEffect&& moveFrom);
+        virtual ~SynthSoundEffect();
+
+        // As ProceduralSynth::Play; returns a handle for Release and Stop.
+        unsigned int __cdecl Play( const SynthPatch& patch, float volume = 1.f, float pan = 0.f );
+
+        // GetWeaponPatch and GetExplosionPatch, played.
+        unsigned int __cdecl PlayWeapon( int weaponType, float energy, float pan = 0.f );
+        unsigned int __cdecl PlayExplosion( float energy, float pan = 0.f );
+
+        void __cdecl Release( unsigned int voice );
+        void __cdecl Stop( unsigned int voice );
+        void __cdecl StopAll();
+        bool __cdecl IsPlaying( unsigned int voice ) const;
+
+        // Volume, pitch, pause and Apply3D for everything the synth plays.
+        DynamicSoundEffectInstance* __cdecl GetInstance();
+
+        ProceduralSynthStatistics __cdecl GetStatistics() const;
+
+    private:
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        SynthSoundEffect(SynthSoundEffect const&);
+        SynthSoundEffect& operator= (SynthSoundEffect const&);
+    };
+}
@@ -0,0 +1,402 @@
+//--------------------------------------------------------------------------------------
+// File: VoicePool.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "VoicePool.h"
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+
+// VS 2010 doesn't have <chrono>
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+#define VOICEPOOL_USE_QPC
+#else
+#include <chrono>
+#endif
+
+using namespace DirectX;
+
+
+namespace
+{
+    double SteadyClock()
+    {
+#ifdef VOICEPOOL_USE_QPC
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency( &frequency );
+        QueryPerformanceCounter( &counter );
+        return double( counter.QuadPart ) / double( frequency.QuadPart );
+#else
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+#endif
+    }
+}
+
+
+//======================================================================================
+// VoicePool
+//======================================================================================
+
+// Internal object implementation class.
+class VoicePool::Impl
+{
+public:
+    Impl( IVoicePoolFactory* factory, VoicePoolClock clock ) :
+        mFactory( factory ),
+        mClock( clock ? clock : SteadyClock ),
+        mActive( 0 )
+    {
+        mPolicy.maxVoices = SIZE_MAX;
+        mPolicy.maxIdleVoices = SIZE_MAX;
+        mPolicy.maxIdleSeconds = 0;
+
+        memset( &mStats, 0, sizeof(mStats) );
+    }
+
+    struct IdleVoice
+    {
+        unsigned int    key;
+        void*           voice;
+        double          released;
+    };
+
+    typedef std::list<IdleVoice> idlelist_t;
+    typedef std::unordered_map<unsigned int, std::deque<idlelist_t::iterator>> keymap_t;
+
+    size_t GetTotal() const { return mIdle.size() + mActive; }
+
+    void* Create( unsigned int key );
+    void* TakeIdle( unsigned int key );
+    void DestroyOldest();
+    void ApplyIdleLimit();
+
+    IVoicePoolFactory*  mFactory;
+    VoicePoolClock      mClock;
+    VoicePoolPolicy     mPolicy;
+    VoicePoolStatistics mStats;
+    size_t              mActive;
+    idlelist_t          mIdle;      // Least recently released first
+    keymap_t            mByKey;     // Into mIdle, least recently released first
+};
+
+
+void* VoicePool::Impl::Create( unsigned int key )
+{
+    double start = SteadyClock();
+    void* voice = mFactory->CreatePoolVoice( key );
+    double seconds = SteadyClock() - start;
+
+    if ( voice )
+    {
+        ++mStats.creations;
+        mStats.createSeconds += seconds;
+        mStats.createSecondsMax = std::max( mStats.createSecondsMax, seconds );
+    }
+
+    return voice;
+}
+
+
+void* VoicePool::Impl::TakeIdle( unsigned int key )
+{
+    auto it = mByKey.find( key );
+    if ( it == mByKey.end() )
+        return nullptr;
+
+    // The most recently released voice is the one least likely to be trimmed next.
+    auto idle = it->second.back();
+    it->second.pop_back();
+    if ( it->second.empty() )
+        mByKey.erase( it );
+
+    void* voice = idle->voice;
+    mIdle.erase( idle );
+    return voice;
+}
+
+
+void VoicePool::Impl::DestroyOldest()
+{
+    assert( !mIdle.empty() );
+    auto idle = mIdle.begin();
+
+    auto it = mByKey.find( idle->key );
+    assert( it != mByKey.end() && it->second.front() == idle );
+    it->second.pop_front();
+    if ( it->second.empty() )
+        mByKey.erase( it );
+
+    void* voice = idle->voice;
+    mIdle.erase( idle );
+
+    ++mStats.evictions;
+    mFactory->DestroyPoolVoice( voice );
+}
+
+
+void VoicePool::Impl::ApplyIdleLimit()
+{
+    while ( !mIdle.empty() && ( mIdle.size() > mPolicy.maxIdleVoices || GetTotal() > mPolicy.maxVoices ) )
+    {
+        DestroyOldest();
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// VoicePool
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+VoicePool::VoicePool( IVoicePoolFactory* factory, VoicePoolClock clock )
+{
+    if ( !factory )
+        throw std::invalid_argument( "VoicePool" );
+
+    pImpl.reset( new Impl( factory, clock ) );
+}
+
+
+// Move constructor.
+VoicePool::VoicePool(VoicePool&& moveFrom)
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+VoicePool& VoicePool::operator= (VoicePool&& moveFrom)
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor. Idle voices are left to the factory's owner, which may
+// already be going away; call Clear first to destroy them.
+VoicePool::~VoicePool()
+{
+}
+
+
+// Public methods.
+void VoicePool::SetPolicy( const VoicePoolPolicy& policy )
+{
+    if ( policy.maxIdleSeconds < 0 )
+        throw std::invalid_argument( "VoicePool::SetPolicy" );
+
+    pImpl->mPolicy = policy;
+    pImpl->ApplyIdleLimit();
+}
+
+
+VoicePoolPolicy VoicePool::GetPolicy() const
+{
+    return pImpl->mPolicy;
+}
+
+
+void* VoicePool::Acquire( unsigned int key )
+{
+    void* voice = pImpl->TakeIdle( key );
+    if ( voice )
+    {
+        ++pImpl->mStats.hits;
+    }
+    else
+    {
+        ++pImpl->mStats.misses;
+
+        while ( pImpl->GetTotal() >= pImpl->mPolicy.maxVoices && !pImpl->mIdle.empty() )
+        {
+            pImpl->DestroyOldest();
+        }
+
+        if ( pImpl->GetTotal() >= pImpl->mPolicy.maxVoices )
+        {
+            ++pImpl->mStats.budgetFailures;
+            return nullptr;
+        }
+
+        voice = pImpl->Create( key );
+        if ( !voice )
+            return nullptr;
+    }
+
+    ++pImpl->mActive;
+    return voice;
+}
+
+
+void VoicePool::Release( unsigned int key, void* voice )
+{
+    assert( voice != 0 && !IsIdle( voice ) );
+    assert( pImpl->mActive > 0 );
+
+    if ( pImpl->mActive > 0 )
+        --pImpl->mActive;
+
+    Impl::IdleVoice idle;
+    idle.key = key;
+    idle.voice = voice;
+    idle.released = pImpl->mClock();
+
+    auto it = pImpl->mIdle.insert( pImpl->mIdle.end(), idle );
+    pImpl->mByKey[ key ].push_back( it );
+
+    pImpl->ApplyIdleLimit();
+}
+
+
+size_t VoicePool::Prewarm( unsigned int key, size_t count )
+{
+    size_t created = 0;
+    for( size_t idle = GetIdleCount( key ); idle < count; ++idle )
+    {
+        if ( pImpl->GetTotal() >= pImpl->mPolicy.maxVoices || pImpl->mIdle.size() >= pImpl->mPolicy.maxIdleVoices )
+            break;
+
+        void* voice = pImpl->Create( key );
+        if ( !voice )
+            break;
+
+        // Prewarmed voices count as released now, so an idle-time policy gives
+        // them as long as any other voice to be picked up.
+        Impl::IdleVoice entry;
+        entry.key = key;
+        entry.voice = voice;
+        entry.released = pImpl->mClock();
+
+        // Go in as least recently used, so they don't push out voices that
+        // have actually played when the idle limit is reached.
+        auto it = pImpl->mIdle.insert( pImpl->mIdle.begin(), entry );
+        pImpl->mByKey[ key ].push_front( it );
+        ++created;
+    }
+
+    return created;
+}
+
+
+size_t VoicePool::Trim()
+{
+    if ( pImpl->mPolicy.maxIdleSeconds <= 0 || pImpl->mIdle.empty() )
+        return 0;
+
+    // Prewarmed voices sit at the front with their own timestamps, so look at the
+    // whole list rather than stopping at the first voice that is young enough.
+    double expired = pImpl->mClock() - pImpl->mPolicy.maxIdleSeconds;
+
+    size_t count = 0;
+    for( auto idle = pImpl->mIdle.begin(); idle != pImpl->mIdle.end(); )
+    {
+        if ( idle->released >= expired )
+        {
+            ++idle;
+            continue;
+        }
+
+        auto it = pImpl->mByKey.find( idle->key );
+        assert( it != pImpl->mByKey.end() );
+        auto& queue = it->second;
+        queue.erase( std::find( queue.begin(), queue.end(), idle ) );
+        if ( queue.empty() )
+            pImpl->mByKey.erase( it );
+
+        void* voice = idle->voice;
+        idle = pImpl->mIdle.erase( idle );
+
+        ++pImpl->mStats.evictions;
+        pImpl->mFactory->DestroyPoolVoice( voice );
+        ++count;
+    }
+
+    return count;
+}
+
+
+bool VoicePool::EvictIdle()
+{
+    if ( pImpl->mIdle.empty() )
+        return false;
+
+    pImpl->DestroyOldest();
+    return true;
+}
+
+
+void VoicePool::Clear()
+{
+    for( auto it = pImpl->mIdle.begin(); it != pImpl->mIdle.end(); ++it )
+    {
+        assert( it->voice != 0 );
+        pImpl->mFactory->DestroyPoolVoice( it->voice );
+    }
+
+    pImpl->mIdle.clear();
+    pImpl->mByKey.clear();
+}
+
+
+void VoicePool::Abandon()
+{
+    pImpl->mIdle.clear();
+    pImpl->mByKey.clear();
+    pImpl->mActive = 0;
+}
+
+
+bool VoicePool::IsIdle( const void* voice ) const
+{
+    for( auto it = pImpl->mIdle.cbegin(); it != pImpl->mIdle.cend(); ++it )
+    {
+        if ( it->voice == voice )
+            return true;
+    }
+
+    return false;
+}
+
+
+size_t VoicePool::GetIdleCount() const
+{
+    return pImpl->mIdle.size();
+}
+
+
+size_t VoicePool::GetIdleCount( unsigned int key ) const
+{
+    auto it = pImpl->mByKey.find( key );
+    return ( it != pImpl->mByKey.end() ) ? it->second.size() : 0;
+}
+
+
+size_t VoicePool::GetActiveCount() const
+{
+    return pImpl->mActive;
+}
+
+
+VoicePoolStatistics VoicePool::GetStatistics() const
+{
+    VoicePoolStatistics stats = pImpl->mStats;
+    stats.idleVoices = pImpl->mIdle.size();
+    stats.activeVoices = pImpl->mActive;
+    return stats;
+}
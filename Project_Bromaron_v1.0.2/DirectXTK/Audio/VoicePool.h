@@ -0,0 +1,122 @@
+//--------------------------------------------------------------------------------------
+// File: VoicePool.h
+//
+// Keeps idle voices by format key for reuse, with a voice budget, LRU and idle-time
+// trimming, prewarming and hit/miss statistics
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+
+namespace DirectX
+{
+    // The pool never looks inside a voice: AudioEngine supplies a factory that
+    // turns a voice key (see makeVoiceKey) into an XAudio2 source voice, and tests
+    // can supply one that doesn't.
+
+    class IVoicePoolFactory
+    {
+    public:
+        virtual ~IVoicePoolFactory() {}
+
+        virtual void* CreatePoolVoice( unsigned int key ) = 0;
+            // Returns a new stopped voice for the key, or nullptr if it can't
+
+        virtual void DestroyPoolVoice( void* voice ) = 0;
+    };
+
+    // Seconds from any fixed point; the pool only compares them.
+    typedef double (*VoicePoolClock)();
+
+    struct VoicePoolPolicy
+    {
+        size_t  maxVoices;          // Idle and in use together; SIZE_MAX for no budget
+        size_t  maxIdleVoices;      // Beyond this the least recently used idle voices go
+        double  maxIdleSeconds;     // Trim destroys voices idle for longer; 0 keeps them
+    };
+
+    struct VoicePoolStatistics
+    {
+        size_t      idleVoices;
+        size_t      activeVoices;       // Acquired and not yet released
+        uint64_t    hits;               // Acquires served by an idle voice
+        uint64_t    misses;             // Acquires that had to create one
+        uint64_t    budgetFailures;     // Misses refused because the budget was full
+        uint64_t    creations;          // Voices created, including by Prewarm
+        uint64_t    evictions;          // Idle voices destroyed by the budget or policy
+        double      createSeconds;      // Total time spent in the factory creating voices
+        double      createSecondsMax;   // Longest single creation
+    };
+
+    class VoicePool
+    {
+    public:
+        // With no clock, idle times come from a monotonic system clock. Creation
+        // times always do.
+        explicit VoicePool( IVoicePoolFactory* factory, VoicePoolClock clock = nullptr );
+
+        VoicePool(VoicePool&& moveFrom);
+        VoicePool& operator= (VoicePool&& moveFrom);
+        virtual ~VoicePool();
+
+        // Idle voices over the new limits go at once; voices in use are never taken
+        // back, so a lower budget only applies as they are released.
+        void SetPolicy( const VoicePoolPolicy& policy );
+        VoicePoolPolicy GetPolicy() const;
+
+        // Returns the most recently released idle voice for the key, or creates one.
+        // With the budget full, the least recently used idle voice of any key is
+        // destroyed to make room; returns nullptr if every pooled voice is in use.
+        void* Acquire( unsigned int key );
+
+        // Hands back a voice from Acquire, stopped, for reuse.
+        void Release( unsigned int key, void* voice );
+
+        // Creates idle voices until the key has count of them, within the budget and
+        // idle limit (nothing is evicted for it). Returns the number created.
+        size_t Prewarm( unsigned int key, size_t count );
+
+        // Destroys voices idle for longer than the policy allows. Returns the number
+        // destroyed.
+        size_t Trim();
+
+        // Destroys the least recently used idle voice; false if there are none.
+        bool EvictIdle();
+
+        // Destroys every idle voice.
+        void Clear();
+
+        // Forgets every voice without destroying any, for when their owner (the
+        // XAudio2 engine) has already gone.
+        void Abandon();
+
+        bool IsIdle( const void* voice ) const;
+        size_t GetIdleCount() const;
+        size_t GetIdleCount( unsigned int key ) const;
+        size_t GetActiveCount() const;
+
+        VoicePoolStatistics GetStatistics() const;
+
+    private:
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        VoicePool(VoicePool const&);
+        VoicePool& operator= (VoicePool const&);
+    };
+}
@@ -24,6 +24,8 @@
 #include <memory>
 #include <mmreg.h>
 
+#include "MappedFile.h"
+
 
 namespace DirectX
 {
@@ -56,4 +58,13 @@ namespace DirectX
     HRESULT LoadWAVAudioFromFileEx( _In_z_ const wchar_t* szFileName, 
                                     _Inout_ std::unique_ptr<uint8_t[]>& wavData,
                                     _Out_ WAVData& result );
+
+    // As LoadWAVAudioFromFileEx, but the file is mapped rather than read, so opening
+    // doesn't wait for the audio to come off the disk. The pointers in result are
+    // valid while mapping is held. Pages are read in on first touch, so keep this
+    // away from voices whose buffers the audio thread reads in real time unless the
+    // file is known to be resident.
+    HRESULT LoadWAVAudioFromFileMapped( _In_z_ const wchar_t* szFileName,
+                                        _Out_ std::shared_ptr<const MappedFile>& mapping,
+                                        _Out_ WAVData& result );
 }
\ No newline at end of file
@@ -0,0 +1,471 @@
+//--------------------------------------------------------------------------------------
+// File: WAVParser.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "WAVParser.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+// VS 2010 doesn't have <chrono>
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+#define WAVPARSER_USE_QPC
+#else
+#include <chrono>
+#endif
+
+using namespace DirectX;
+
+
+namespace
+{
+    //----------------------------------------------------------------------------------
+    // .WAV files
+    //----------------------------------------------------------------------------------
+    const uint32_t FOURCC_RIFF_TAG      = 'FFIR';
+    const uint32_t FOURCC_FORMAT_TAG    = ' tmf';
+    const uint32_t FOURCC_DATA_TAG      = 'atad';
+    const uint32_t FOURCC_WAVE_FILE_TAG = 'EVAW';
+    const uint32_t FOURCC_XWMA_FILE_TAG = 'AMWX';
+    const uint32_t FOURCC_DLS_SAMPLE    = 'pmsw';
+    const uint32_t FOURCC_MIDI_SAMPLE   = 'lpms';
+    const uint32_t FOURCC_XWMA_DPDS     = 'sdpd';
+    const uint32_t FOURCC_XMA_SEEK      = 'kees';
+
+    const uint32_t TAG_PCM          = 0x0001;   // WAVE_FORMAT_PCM
+    const uint32_t TAG_ADPCM        = 0x0002;   // WAVE_FORMAT_ADPCM
+    const uint32_t TAG_IEEE_FLOAT   = 0x0003;   // WAVE_FORMAT_IEEE_FLOAT
+    const uint32_t TAG_WMAUDIO2     = 0x0161;   // WAVE_FORMAT_WMAUDIO2
+    const uint32_t TAG_WMAUDIO3     = 0x0162;   // WAVE_FORMAT_WMAUDIO3
+    const uint32_t TAG_XMA2         = 0x0166;   // WAVE_FORMAT_XMA2
+    const uint32_t TAG_EXTENSIBLE   = 0xFFFE;   // WAVE_FORMAT_EXTENSIBLE
+
+    // Structure sizes and field offsets, read byte by byte since nothing in the
+    // file is guaranteed to be aligned.
+    const size_t RIFF_CHUNK_BYTES           = 8;
+    const size_t RIFF_HEADER_BYTES          = 12;
+    const size_t PCMWAVEFORMAT_BYTES        = 16;
+    const size_t WAVEFORMATEX_BYTES         = 18;
+    const size_t WAVEFORMATEX_CBSIZE        = 16;
+    const size_t WAVEFORMATEXTENSIBLE_BYTES = 40;
+    const size_t WAVEFORMATEXTENSIBLE_SUB   = 24;
+    const size_t XMA2WAVEFORMATEX_BYTES     = 52;
+    const size_t MSADPCM_EXTRA_BYTES        = 32;
+
+    const size_t DLS_SAMPLE_BYTES           = 20;   // RIFFDLSSample: size, unityNote, fineTune, gain, options, loopCount
+    const size_t DLS_SAMPLE_LOOPCOUNT       = 16;
+    const size_t DLS_LOOP_BYTES             = 16;   // DLSLoop: size, loopType, loopStart, loopLength
+    const uint32_t DLS_LOOP_FORWARD         = 0;
+    const uint32_t DLS_LOOP_RELEASE         = 1;
+
+    const size_t MIDI_SAMPLE_BYTES          = 36;   // RIFFMIDISample, loopCount at 28
+    const size_t MIDI_SAMPLE_LOOPCOUNT      = 28;
+    const size_t MIDI_LOOP_BYTES            = 24;   // MIDILoop: cuePointId, type, start, end, fraction, playCount
+    const uint32_t MIDI_LOOP_FORWARD        = 0;
+
+    // KSDATAFORMAT_SUBTYPE_* share everything after Data1.
+    const uint8_t s_subtypeBase[ 12 ] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+    // RIFF is little-endian, as every target is.
+    uint16_t ReadU16( const uint8_t* p )
+    {
+        uint16_t value;
+        memcpy( &value, p, sizeof(value) );
+        return value;
+    }
+
+    uint32_t ReadU32( const uint8_t* p )
+    {
+        uint32_t value;
+        memcpy( &value, p, sizeof(value) );
+        return value;
+    }
+
+
+    WAV_PARSE_RESULT ValidateFormat( const RIFFChunkView& fmt, WAVFileView& view )
+    {
+        if ( fmt.size < PCMWAVEFORMAT_BYTES )
+            return WAV_PARSE_INVALID;
+
+        const uint8_t* p = fmt.data;
+        uint32_t tag = ReadU16( p );
+        view.formatTag = tag;
+
+        // PCM and float can be a PCMWAVEFORMAT or a WAVEFORMATEX
+        if ( tag == TAG_PCM || tag == TAG_IEEE_FLOAT )
+            return WAV_PARSE_OK;
+
+        if ( fmt.size < WAVEFORMATEX_BYTES )
+            return WAV_PARSE_INVALID;
+
+        uint32_t cbSize = ReadU16( p + WAVEFORMATEX_CBSIZE );
+        if ( fmt.size < WAVEFORMATEX_BYTES + cbSize )
+            return WAV_PARSE_INVALID;
+
+        switch( tag )
+        {
+        case TAG_WMAUDIO2:
+        case TAG_WMAUDIO3:
+            view.dpds = true;
+            return WAV_PARSE_OK;
+
+        case TAG_XMA2:
+            if ( fmt.size < XMA2WAVEFORMATEX_BYTES || cbSize < XMA2WAVEFORMATEX_BYTES - WAVEFORMATEX_BYTES )
+                return WAV_PARSE_INVALID;
+            view.xmaSeek = true;
+            return WAV_PARSE_OK;
+
+        case TAG_ADPCM:
+            if ( fmt.size < WAVEFORMATEX_BYTES + MSADPCM_EXTRA_BYTES || cbSize < MSADPCM_EXTRA_BYTES )
+                return WAV_PARSE_INVALID;
+            return WAV_PARSE_OK;
+
+        case TAG_EXTENSIBLE:
+            if ( fmt.size < WAVEFORMATEXTENSIBLE_BYTES || cbSize < WAVEFORMATEXTENSIBLE_BYTES - WAVEFORMATEX_BYTES )
+                return WAV_PARSE_INVALID;
+
+            if ( memcmp( p + WAVEFORMATEXTENSIBLE_SUB + 4, s_subtypeBase, sizeof(s_subtypeBase) ) != 0 )
+                return WAV_PARSE_UNSUPPORTED;
+
+            view.formatTag = ReadU32( p + WAVEFORMATEXTENSIBLE_SUB );
+            switch( view.formatTag )
+            {
+            case TAG_PCM:
+            case TAG_IEEE_FLOAT:
+                return WAV_PARSE_OK;
+
+            // MS-ADPCM and XMA2 are not supported as WAVEFORMATEXTENSIBLE
+
+            case TAG_WMAUDIO2:
+            case TAG_WMAUDIO3:
+                view.dpds = true;
+                return WAV_PARSE_OK;
+
+            default:
+                return WAV_PARSE_UNSUPPORTED;
+            }
+
+        default:
+            return WAV_PARSE_UNSUPPORTED;
+        }
+    }
+
+
+    // A missing chunk is fine here; one that runs off the end isn't.
+    WAV_PARSE_RESULT FindOptionalChunk( const uint8_t* list, size_t listSize, uint32_t tag, RIFFChunkView& chunk, bool& found )
+    {
+        WAV_PARSE_RESULT result = FindRIFFChunk( list, listSize, tag, chunk );
+        found = ( result == WAV_PARSE_OK );
+        return ( result == WAV_PARSE_INVALID ) ? WAV_PARSE_OK : result;
+    }
+
+
+    WAV_PARSE_RESULT FindLoop( const uint8_t* list, size_t listSize, WAVFileView& view )
+    {
+        // 'wsmp' (DLS) first
+        RIFFChunkView chunk;
+        bool found;
+        WAV_PARSE_RESULT result = FindOptionalChunk( list, listSize, FOURCC_DLS_SAMPLE, chunk, found );
+        if ( result != WAV_PARSE_OK )
+            return result;
+
+        if ( found && chunk.size >= DLS_SAMPLE_BYTES )
+        {
+            uint32_t headerBytes = ReadU32( chunk.data );
+            uint32_t loopCount = ReadU32( chunk.data + DLS_SAMPLE_LOOPCOUNT );
+
+            if ( uint64_t( headerBytes ) + uint64_t( loopCount ) * DLS_LOOP_BYTES <= chunk.size )
+            {
+                const uint8_t* loop = chunk.data + headerBytes;
+                for( uint32_t j = 0; j < loopCount; ++j, loop += DLS_LOOP_BYTES )
+                {
+                    uint32_t type = ReadU32( loop + 4 );
+                    if ( type == DLS_LOOP_FORWARD || type == DLS_LOOP_RELEASE )
+                    {
+                        view.loopStart = ReadU32( loop + 8 );
+                        view.loopLength = ReadU32( loop + 12 );
+                        return WAV_PARSE_OK;
+                    }
+                }
+            }
+        }
+
+        // Then 'smpl' (MIDI)
+        result = FindOptionalChunk( list, listSize, FOURCC_MIDI_SAMPLE, chunk, found );
+        if ( result != WAV_PARSE_OK )
+            return result;
+
+        if ( found && chunk.size >= MIDI_SAMPLE_BYTES )
+        {
+            uint32_t loopCount = ReadU32( chunk.data + MIDI_SAMPLE_LOOPCOUNT );
+
+            if ( MIDI_SAMPLE_BYTES + uint64_t( loopCount ) * MIDI_LOOP_BYTES <= chunk.size )
+            {
+                const uint8_t* loop = chunk.data + MIDI_SAMPLE_BYTES;
+                for( uint32_t j = 0; j < loopCount; ++j, loop += MIDI_LOOP_BYTES )
+                {
+                    uint32_t type = ReadU32( loop + 4 );
+                    uint32_t start = ReadU32( loop + 8 );
+                    uint32_t end = ReadU32( loop + 12 );
+
+                    // The end sample is inclusive.
+                    if ( type == MIDI_LOOP_FORWARD && end >= start )
+                    {
+                        view.loopStart = start;
+                        view.loopLength = end - start + 1;
+                        return WAV_PARSE_OK;
+                    }
+                }
+            }
+        }
+
+        return WAV_PARSE_OK;
+    }
+
+
+    double SteadyClock()
+    {
+#ifdef WAVPARSER_USE_QPC
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency( &frequency );
+        QueryPerformanceCounter( &counter );
+        return double( counter.QuadPart ) / double( frequency.QuadPart );
+#else
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+#endif
+    }
+
+    FILE* OpenForRead( const MappedFileChar* fileName )
+    {
+#ifdef _WIN32
+        FILE* file = nullptr;
+        return ( _wfopen_s( &file, fileName, L"rb" ) == 0 ) ? file : nullptr;
+#else
+        return fopen( fileName, "rb" );
+#endif
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+WAV_PARSE_RESULT DirectX::FindRIFFChunk( const uint8_t* data, size_t size, uint32_t tag, RIFFChunkView& chunk )
+{
+    memset( &chunk, 0, sizeof(chunk) );
+
+    if ( !data )
+        return WAV_PARSE_INVALID;
+
+    // Offsets rather than pointers, so a huge chunk size can't wrap around.
+    size_t offset = 0;
+    while ( size - offset >= RIFF_CHUNK_BYTES )
+    {
+        uint32_t chunkTag = ReadU32( data + offset );
+        uint32_t chunkSize = ReadU32( data + offset + 4 );
+        size_t body = offset + RIFF_CHUNK_BYTES;
+        size_t available = size - body;
+
+        if ( chunkTag == tag )
+        {
+            chunk.tag = tag;
+            chunk.data = data + body;
+
+            if ( chunkSize > available )
+            {
+                chunk.size = static_cast<uint32_t>( available );
+                return WAV_PARSE_TRUNCATED;
+            }
+
+            chunk.size = chunkSize;
+            return WAV_PARSE_OK;
+        }
+
+        uint64_t skip = uint64_t( chunkSize ) + ( chunkSize & 1 );
+        if ( skip >= available )
+            break;
+
+        offset = body + static_cast<size_t>( skip );
+    }
+
+    return WAV_PARSE_INVALID;
+}
+
+
+//--------------------------------------------------------------------------------------
+WAV_PARSE_RESULT DirectX::ParseWAV( const uint8_t* data, size_t size, WAVFileView& view )
+{
+    memset( &view, 0, sizeof(view) );
+
+    if ( !data || size < WAVMinFileBytes )
+        return WAV_PARSE_INVALID;
+
+    // Locate RIFF 'WAVE'. Writers often leave the RIFF size wrong, so a list that
+    // claims more than the file holds is read as far as the file goes.
+    RIFFChunkView riff;
+    WAV_PARSE_RESULT result = FindRIFFChunk( data, size, FOURCC_RIFF_TAG, riff );
+    if ( result == WAV_PARSE_INVALID || riff.size < 4 )
+        return WAV_PARSE_INVALID;
+
+    uint32_t riffType = ReadU32( riff.data );
+    if ( riffType != FOURCC_WAVE_FILE_TAG && riffType != FOURCC_XWMA_FILE_TAG )
+        return WAV_PARSE_INVALID;
+
+    const uint8_t* list = riff.data + 4;
+    size_t listSize = riff.size - 4;
+    if ( listSize < RIFF_CHUNK_BYTES )
+        return WAV_PARSE_TRUNCATED;
+
+    // Locate 'fmt '
+    RIFFChunkView fmt;
+    result = FindRIFFChunk( list, listSize, FOURCC_FORMAT_TAG, fmt );
+    if ( result != WAV_PARSE_OK )
+        return result;
+
+    result = ValidateFormat( fmt, view );
+    if ( result != WAV_PARSE_OK )
+        return result;
+
+    view.format = fmt.data;
+    view.formatBytes = fmt.size;
+
+    // Locate 'data'
+    RIFFChunkView audio;
+    result = FindRIFFChunk( list, listSize, FOURCC_DATA_TAG, audio );
+    if ( result == WAV_PARSE_INVALID || !audio.size )
+        return WAV_PARSE_NO_AUDIO;
+    if ( result != WAV_PARSE_OK )
+        return result;
+
+    view.startAudio = audio.data;
+    view.audioBytes = audio.size;
+
+    // xWMA files do not contain loop information
+    if ( riffType == FOURCC_WAVE_FILE_TAG )
+    {
+        result = FindLoop( list, listSize, view );
+        if ( result != WAV_PARSE_OK )
+            return result;
+    }
+
+    if ( view.dpds || view.xmaSeek )
+    {
+        RIFFChunkView table;
+        bool found;
+        result = FindOptionalChunk( list, listSize, view.dpds ? FOURCC_XWMA_DPDS : FOURCC_XMA_SEEK, table, found );
+        if ( result != WAV_PARSE_OK )
+            return result;
+
+        if ( found )
+        {
+            if ( ( table.size % sizeof(uint32_t) ) != 0 )
+                return WAV_PARSE_INVALID;
+
+            view.seek = reinterpret_cast<const uint32_t*>( table.data );
+            view.seekCount = table.size / 4;
+        }
+    }
+
+    return WAV_PARSE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+WAV_PARSE_RESULT DirectX::MapWAVFile( const MappedFileChar* fileName, MappedWAV& result )
+{
+    result.file.reset();
+    memset( &result.wave, 0, sizeof(result.wave) );
+
+    auto file = MappedFile::Open( fileName );
+    if ( !file )
+        return WAV_PARSE_OPEN_FAILED;
+
+    WAV_PARSE_RESULT parsed = ParseWAV( file->GetData(), file->GetSize(), result.wave );
+    if ( parsed == WAV_PARSE_OK )
+        result.file = file;
+
+    return parsed;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+WAVOpenBenchmark DirectX::BenchmarkWAVOpen( const MappedFileChar* fileName, size_t iterations )
+{
+    WAVOpenBenchmark result;
+    memset( &result, 0, sizeof(result) );
+
+    iterations = std::max<size_t>( 1, iterations );
+
+    // Copy path, as LoadWAVAudioFromFileEx
+    double start = SteadyClock();
+    for( size_t j = 0; j < iterations; ++j )
+    {
+        FILE* file = OpenForRead( fileName );
+        if ( !file )
+            return result;
+
+        fseek( file, 0, SEEK_END );
+        long size = ftell( file );
+        fseek( file, 0, SEEK_SET );
+
+        if ( size <= 0 )
+        {
+            fclose( file );
+            return result;
+        }
+
+        std::unique_ptr<uint8_t[]> wavData( new uint8_t[ size ] );
+        size_t bytesRead = fread( wavData.get(), 1, static_cast<size_t>( size ), file );
+        fclose( file );
+
+        WAVFileView view;
+        if ( ParseWAV( wavData.get(), bytesRead, view ) != WAV_PARSE_OK )
+            return result;
+
+        result.fileBytes = bytesRead;
+    }
+    result.copySeconds = ( SteadyClock() - start ) / iterations;
+
+    // Mapped, parsed and nothing more
+    start = SteadyClock();
+    for( size_t j = 0; j < iterations; ++j )
+    {
+        MappedWAV wav;
+        if ( MapWAVFile( fileName, wav ) != WAV_PARSE_OK )
+            return result;
+    }
+    result.mappedSeconds = ( SteadyClock() - start ) / iterations;
+
+    // Mapped, with every page of audio faulted in as playback would
+    volatile uint8_t sink = 0;
+    start = SteadyClock();
+    for( size_t j = 0; j < iterations; ++j )
+    {
+        MappedWAV wav;
+        if ( MapWAVFile( fileName, wav ) != WAV_PARSE_OK )
+            return result;
+
+        uint8_t sum = 0;
+        for( size_t offset = 0; offset < wav.wave.audioBytes; offset += 4096 )
+        {
+            sum ^= wav.wave.startAudio[ offset ];
+        }
+        sink = static_cast<uint8_t>( sink ^ sum );
+    }
+    result.mappedTouchSeconds = ( SteadyClock() - start ) / iterations;
+
+    return result;
+}
@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------------------
+// File: WAVParser.h
+//
+// Bounds-checked RIFF chunk walker and WAV validation, in place over any buffer or
+// file mapping
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+#include "MappedFile.h"
+
+
+namespace DirectX
+{
+    // WAVFileReader turns the results into HRESULTs. Nothing is copied: the views
+    // point into the caller's bytes, which are never read outside [data, data + size)
+    // whatever the chunk headers claim.
+
+    enum WAV_PARSE_RESULT
+    {
+        WAV_PARSE_OK = 0,
+        WAV_PARSE_INVALID,          // Not RIFF 'WAVE' or 'XWMA', or a chunk is malformed (E_FAIL)
+        WAV_PARSE_TRUNCATED,        // A chunk runs past the end of the data (ERROR_HANDLE_EOF)
+        WAV_PARSE_NO_AUDIO,         // No 'data' chunk, or an empty one (ERROR_INVALID_DATA)
+        WAV_PARSE_UNSUPPORTED,      // Format tag or extensible subformat isn't supported (ERROR_NOT_SUPPORTED)
+        WAV_PARSE_OPEN_FAILED,      // MapWAVFile only; see GetLastError() or errno
+    };
+
+    // Chunks are word aligned, as RIFF requires: a chunk with an odd size is
+    // followed by a pad byte.
+    struct RIFFChunkView
+    {
+        uint32_t        tag;
+        const uint8_t*  data;
+        uint32_t        size;
+    };
+
+    // Two chunk headers, the RIFF type and a WAVEFORMAT.
+    const size_t WAVMinFileBytes = 34;
+
+    // Finds the first chunk with the tag among the chunks in [data, data + size).
+    // Returns WAV_PARSE_INVALID if it isn't there, and WAV_PARSE_TRUNCATED if it
+    // runs past the end, with chunk.size cut to the bytes that are there.
+    WAV_PARSE_RESULT FindRIFFChunk( const uint8_t* data, size_t size, uint32_t tag, RIFFChunkView& chunk );
+
+    struct WAVFileView
+    {
+        const uint8_t*  format;         // WAVEFORMAT, PCMWAVEFORMAT, WAVEFORMATEX or WAVEFORMATEXTENSIBLE
+        uint32_t        formatBytes;
+        uint32_t        formatTag;      // The extensible subformat, where there is one
+        const uint8_t*  startAudio;
+        uint32_t        audioBytes;
+        uint32_t        loopStart;      // From 'wsmp' or 'smpl', in samples; 0 and 0 for none
+        uint32_t        loopLength;
+        const uint32_t* seek;           // 'dpds' (xWMA) or 'seek' (XMA2, big-endian); may be unaligned
+        uint32_t        seekCount;
+        bool            dpds;           // The format needs a 'dpds' table
+        bool            xmaSeek;        // The format needs a 'seek' table
+    };
+
+    // Validates the RIFF, 'fmt ', 'data', 'wsmp'/'smpl' and 'dpds'/'seek' chunks
+    // and points view into data.
+    WAV_PARSE_RESULT ParseWAV( const uint8_t* data, size_t size, WAVFileView& view );
+
+    struct MappedWAV
+    {
+        std::shared_ptr<const MappedFile>   file;   // Keeps the views in wave valid
+        WAVFileView                         wave;
+    };
+
+    // Maps the file and parses it in place, so the audio is only read from disk
+    // as it is touched.
+    WAV_PARSE_RESULT MapWAVFile( const MappedFileChar* fileName, MappedWAV& result );
+
+
+    struct WAVOpenBenchmark
+    {
+        size_t      fileBytes;
+        double      copySeconds;        // Read the whole file into memory, then parse
+        double      mappedSeconds;      // Map and parse; the audio isn't read yet
+        double      mappedTouchSeconds; // Map, parse and touch every page of the audio
+    };
+
+    // Opens fileName iterations times each way and reports the average time to a
+    // playable buffer. The file stays in the OS cache after the first open, so this
+    // measures the cost of copying rather than of the disk.
+    WAVOpenBenchmark BenchmarkWAVOpen( const MappedFileChar* fileName, size_t iterations );
+}
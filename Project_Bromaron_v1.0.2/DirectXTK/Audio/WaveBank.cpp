@@ -147,7 +147,7 @@ void WaveBank::Impl::Play( int index )
 {
     if ( mStreaming )
     {
-        DebugTrace( "ERROR: One-shots can only be created from an in-memory wave bank\n");
+        DebugTrace( "ERROR: One-shots can only be created from an in-memory wave bank; use StreamingWaveBank for streaming ones\n");
         throw std::exception( "WaveBank::Play" );
     }
 
@@ -288,7 +288,7 @@ std::unique_ptr<SoundEffectInstance> WaveBank::CreateInstance( int index, SOUND_
 
     if ( pImpl->mStreaming )
     {
-        DebugTrace( "ERROR: SoundEffectInstances can only be created from an in-memory wave bank\n");
+        DebugTrace( "ERROR: SoundEffectInstances can only be created from an in-memory wave bank; use StreamingWaveBank for streaming ones\n");
         throw std::exception( "WaveBank::CreateInstance" );
     }
 
@@ -420,6 +420,25 @@ int WaveBank::Find( const char* name ) const
 }
 
 
+void WaveBank::PrewarmVoices( size_t voicesPerFormat )
+{
+    // Streaming banks can't play one-shots, which are all the pool serves
+    if ( !pImpl->mEngine || pImpl->mStreaming )
+        return;
+
+    // Entries sharing a format share voices, so prewarming is by format not entry
+    char buff[64];
+    auto wfx = reinterpret_cast<WAVEFORMATEX*>( buff );
+    for( uint32_t j = 0; j < pImpl->mReader.Count(); ++j )
+    {
+        HRESULT hr = pImpl->mReader.GetFormat( j, wfx, 64 );
+        ThrowIfFailed( hr );
+
+        pImpl->mEngine->PrewarmVoicePool( wfx, voicesPerFormat );
+    }
+}
+
+
 #if defined(_XBOX_ONE) || (_WIN32_WINNT < _WIN32_WINNT_WIN8)
 
 _Use_decl_annotations_
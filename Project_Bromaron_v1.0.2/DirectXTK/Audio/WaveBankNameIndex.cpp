@@ -0,0 +1,561 @@
+//--------------------------------------------------------------------------------------
+// File: WaveBankNameIndex.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "WaveBankNameIndex.h"
+
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+// VS 2010 doesn't have <chrono>
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+#define WAVEBANKNAMEINDEX_USE_QPC
+#else
+#include <chrono>
+#endif
+
+using namespace DirectX;
+
+
+namespace
+{
+    // Header words, then (1 << bucketBits) + 1 bucket starts, then count records
+    // of hash and entry sorted by hash and then entry.
+    const uint32_t INDEX_MAGIC      = 'INBW';   // "WBNI" in the file
+    const uint32_t INDEX_VERSION    = 1;
+
+    enum INDEX_HEADER
+    {
+        HDR_MAGIC = 0,
+        HDR_VERSION,
+        HDR_COUNT,
+        HDR_STRIDE,
+        HDR_BUCKET_BITS,
+        HDR_RESERVED,
+        HDR_TABLE_HASH_LO,      // Of the whole names table, so a stale index is refused
+        HDR_TABLE_HASH_HI,
+        HDR_WORDS
+    };
+
+    // As WaveBankReader and xwbtool: names are at most 64 characters.
+    const size_t MaxNameLength = 64;
+
+    const uint32_t MaxBucketBits = 24;
+
+    size_t NameLength( const char* slot, size_t stride )
+    {
+        size_t limit = std::min( stride, MaxNameLength );
+        auto end = static_cast<const char*>( memchr( slot, 0, limit ) );
+        return end ? size_t( end - slot ) : limit;
+    }
+
+    // FNV-1a, then a finalizer so the top bits that pick the bucket are well
+    // mixed even for names that differ only at the end.
+    uint32_t HashName( const char* name, size_t length )
+    {
+        uint32_t hash = 2166136261u;
+        for( size_t j = 0; j < length; ++j )
+        {
+            hash ^= static_cast<uint8_t>( name[ j ] );
+            hash *= 16777619u;
+        }
+
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35u;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    // FNV-1a a word at a time; it only has to notice the table changing, and
+    // Attach runs it over the whole table.
+    uint64_t HashTable( const char* names, size_t bytes )
+    {
+        uint64_t hash = 14695981039346656037ull;
+
+        size_t j = 0;
+        for( ; j + sizeof(uint64_t) <= bytes; j += sizeof(uint64_t) )
+        {
+            uint64_t word;
+            memcpy( &word, names + j, sizeof(word) );
+            hash ^= word;
+            hash *= 1099511628211ull;
+        }
+
+        for( ; j < bytes; ++j )
+        {
+            hash ^= static_cast<uint8_t>( names[ j ] );
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint32_t BucketOf( uint32_t hash, uint32_t bucketBits )
+    {
+        return bucketBits ? ( hash >> ( 32 - bucketBits ) ) : 0;
+    }
+
+    size_t IndexWords( uint32_t count, uint32_t bucketBits )
+    {
+        return HDR_WORDS + ( size_t( 1 ) << bucketBits ) + 1 + size_t( count ) * 2;
+    }
+
+    double SteadyClock()
+    {
+#ifdef WAVEBANKNAMEINDEX_USE_QPC
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency( &frequency );
+        QueryPerformanceCounter( &counter );
+        return double( counter.QuadPart ) / double( frequency.QuadPart );
+#else
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+#endif
+    }
+}
+
+
+//======================================================================================
+// WaveBankNameIndex
+//======================================================================================
+
+// Internal object implementation class.
+class WaveBankNameIndex::Impl
+{
+public:
+    Impl() :
+        mNames( nullptr ),
+        mStride( 0 ),
+        mCount( 0 ),
+        mBucketBits( 0 ),
+        mWords( nullptr ),
+        mSize( 0 )
+    {
+    }
+
+    void Reset()
+    {
+        mNames = nullptr;
+        mStride = 0;
+        mCount = 0;
+        mBucketBits = 0;
+        mWords = nullptr;
+        mSize = 0;
+        mBuilt.clear();
+        mFile.reset();
+    }
+
+    bool Validate( const uint32_t* words, size_t size, const char* names, size_t stride, uint32_t count ) const;
+
+    const uint32_t* Buckets() const { return mWords + HDR_WORDS; }
+    const uint32_t* Records() const { return mWords + HDR_WORDS + ( size_t( 1 ) << mBucketBits ) + 1; }
+
+    const char*                         mNames;
+    size_t                              mStride;
+    uint32_t                            mCount;
+    uint32_t                            mBucketBits;
+    const uint32_t*                     mWords;     // mBuilt, or a file or buffer used in place
+    size_t                              mSize;
+    std::vector<uint32_t>               mBuilt;
+    std::shared_ptr<const MappedFile>   mFile;
+};
+
+
+bool WaveBankNameIndex::Impl::Validate( const uint32_t* words, size_t size, const char* names, size_t stride, uint32_t count ) const
+{
+    if ( size < HDR_WORDS * sizeof(uint32_t) || ( size % sizeof(uint32_t) ) != 0 )
+        return false;
+
+    if ( words[ HDR_MAGIC ] != INDEX_MAGIC
+         || words[ HDR_VERSION ] != INDEX_VERSION
+         || words[ HDR_COUNT ] != count
+         || words[ HDR_STRIDE ] != stride
+         || words[ HDR_BUCKET_BITS ] > MaxBucketBits )
+        return false;
+
+    // Also keeps IndexWords from overflowing.
+    if ( count > size / ( sizeof(uint32_t) * 2 ) )
+        return false;
+
+    uint32_t bucketBits = words[ HDR_BUCKET_BITS ];
+    if ( size != IndexWords( count, bucketBits ) * sizeof(uint32_t) )
+        return false;
+
+    uint64_t tableHash = ( uint64_t( words[ HDR_TABLE_HASH_HI ] ) << 32 ) | words[ HDR_TABLE_HASH_LO ];
+    if ( tableHash != HashTable( names, stride * count ) )
+        return false;
+
+    // Every record in range and in its bucket, in order, so Find can trust the
+    // layout without checking it again.
+    size_t bucketCount = size_t( 1 ) << bucketBits;
+    const uint32_t* buckets = words + HDR_WORDS;
+    const uint32_t* records = buckets + bucketCount + 1;
+
+    if ( buckets[ 0 ] != 0 || buckets[ bucketCount ] != count )
+        return false;
+
+    for( size_t b = 0; b < bucketCount; ++b )
+    {
+        if ( buckets[ b ] > buckets[ b + 1 ] || buckets[ b + 1 ] > count )
+            return false;
+
+        for( uint32_t j = buckets[ b ]; j < buckets[ b + 1 ]; ++j )
+        {
+            uint32_t hash = records[ j * 2 ];
+            uint32_t entry = records[ j * 2 + 1 ];
+            if ( entry >= count || BucketOf( hash, bucketBits ) != b )
+                return false;
+
+            if ( j > 0 )
+            {
+                uint32_t prevHash = records[ j * 2 - 2 ];
+                if ( prevHash > hash || ( prevHash == hash && records[ j * 2 - 1 ] >= entry ) )
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// WaveBankNameIndex
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+WaveBankNameIndex::WaveBankNameIndex() :
+    pImpl( new Impl() )
+{
+}
+
+
+// Move constructor.
+WaveBankNameIndex::WaveBankNameIndex(WaveBankNameIndex&& moveFrom)
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+WaveBankNameIndex& WaveBankNameIndex::operator= (WaveBankNameIndex&& moveFrom)
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+WaveBankNameIndex::~WaveBankNameIndex()
+{
+}
+
+
+// Public methods.
+void WaveBankNameIndex::Build( const char* names, size_t stride, uint32_t count )
+{
+    if ( ( !names && count ) || !stride || stride > UINT32_MAX )
+        throw std::invalid_argument( "WaveBankNameIndex::Build" );
+
+    pImpl->Reset();
+
+    uint32_t bucketBits = 0;
+    while( ( uint32_t( 1 ) << bucketBits ) < count && bucketBits < MaxBucketBits )
+        ++bucketBits;
+
+    std::vector<uint64_t> sorted( count );
+    for( uint32_t j = 0; j < count; ++j )
+    {
+        const char* slot = names + size_t( j ) * stride;
+        sorted[ j ] = ( uint64_t( HashName( slot, NameLength( slot, stride ) ) ) << 32 ) | j;
+    }
+    std::sort( sorted.begin(), sorted.end() );
+
+    size_t bucketCount = size_t( 1 ) << bucketBits;
+    std::vector<uint32_t>& words = pImpl->mBuilt;
+    words.assign( IndexWords( count, bucketBits ), 0 );
+
+    uint64_t tableHash = HashTable( names, stride * count );
+    words[ HDR_MAGIC ] = INDEX_MAGIC;
+    words[ HDR_VERSION ] = INDEX_VERSION;
+    words[ HDR_COUNT ] = count;
+    words[ HDR_STRIDE ] = static_cast<uint32_t>( stride );
+    words[ HDR_BUCKET_BITS ] = bucketBits;
+    words[ HDR_TABLE_HASH_LO ] = static_cast<uint32_t>( tableHash );
+    words[ HDR_TABLE_HASH_HI ] = static_cast<uint32_t>( tableHash >> 32 );
+
+    uint32_t* buckets = &words[ HDR_WORDS ];
+    uint32_t* records = buckets + bucketCount + 1;
+
+    size_t j = 0;
+    for( size_t b = 0; b <= bucketCount; ++b )
+    {
+        while( j < count && BucketOf( static_cast<uint32_t>( sorted[ j ] >> 32 ), bucketBits ) < b )
+            ++j;
+        buckets[ b ] = static_cast<uint32_t>( j );
+    }
+
+    for( j = 0; j < count; ++j )
+    {
+        records[ j * 2 ] = static_cast<uint32_t>( sorted[ j ] >> 32 );
+        records[ j * 2 + 1 ] = static_cast<uint32_t>( sorted[ j ] );
+    }
+
+    pImpl->mNames = names;
+    pImpl->mStride = stride;
+    pImpl->mCount = count;
+    pImpl->mBucketBits = bucketBits;
+    pImpl->mWords = &words[ 0 ];
+    pImpl->mSize = words.size() * sizeof(uint32_t);
+}
+
+
+bool WaveBankNameIndex::Attach( const std::shared_ptr<const MappedFile>& file, const char* names, size_t stride, uint32_t count )
+{
+    if ( !file || !Attach( file->GetData(), file->GetSize(), names, stride, count ) )
+        return false;
+
+    pImpl->mFile = file;
+    return true;
+}
+
+
+bool WaveBankNameIndex::Attach( const uint8_t* data, size_t size, const char* names, size_t stride, uint32_t count )
+{
+    pImpl->Reset();
+
+    if ( !data || ( !names && count ) || !stride )
+        return false;
+
+    // Mappings and the vectors Build fills are always aligned.
+    if ( ( reinterpret_cast<uintptr_t>( data ) % sizeof(uint32_t) ) != 0 )
+        return false;
+
+    auto words = reinterpret_cast<const uint32_t*>( data );
+    if ( !pImpl->Validate( words, size, names, stride, count ) )
+        return false;
+
+    pImpl->mNames = names;
+    pImpl->mStride = stride;
+    pImpl->mCount = count;
+    pImpl->mBucketBits = words[ HDR_BUCKET_BITS ];
+    pImpl->mWords = words;
+    pImpl->mSize = size;
+    return true;
+}
+
+
+void WaveBankNameIndex::Reset()
+{
+    pImpl->Reset();
+}
+
+
+uint32_t WaveBankNameIndex::Find( const char* name ) const
+{
+    if ( !name || !pImpl->mWords || !pImpl->mCount )
+        return uint32_t(-1);
+
+    size_t length = strlen( name );
+    if ( length > std::min( pImpl->mStride, MaxNameLength ) )
+        return uint32_t(-1);
+
+    uint32_t hash = HashName( name, length );
+    uint32_t bucket = BucketOf( hash, pImpl->mBucketBits );
+
+    const uint32_t* buckets = pImpl->Buckets();
+    const uint32_t* records = pImpl->Records();
+
+    // Records with the same hash are in entry order, so the last match wins.
+    uint32_t result = uint32_t(-1);
+    for( uint32_t j = buckets[ bucket ]; j < buckets[ bucket + 1 ]; ++j )
+    {
+        uint32_t recordHash = records[ j * 2 ];
+        if ( recordHash > hash )
+            break;
+        if ( recordHash != hash )
+            continue;
+
+        uint32_t entry = records[ j * 2 + 1 ];
+        const char* slot = pImpl->mNames + size_t( entry ) * pImpl->mStride;
+        if ( NameLength( slot, pImpl->mStride ) == length && memcmp( slot, name, length ) == 0 )
+            result = entry;
+    }
+
+    return result;
+}
+
+
+bool WaveBankNameIndex::IsEmpty() const
+{
+    return !pImpl->mWords;
+}
+
+
+const uint8_t* WaveBankNameIndex::GetData() const
+{
+    return reinterpret_cast<const uint8_t*>( pImpl->mWords );
+}
+
+
+size_t WaveBankNameIndex::GetSize() const
+{
+    return pImpl->mSize;
+}
+
+
+//--------------------------------------------------------------------------------------
+std::basic_string<MappedFileChar> DirectX::GetNameIndexFileName( const MappedFileChar* bankFileName )
+{
+    std::basic_string<MappedFileChar> fileName;
+    if ( bankFileName )
+        fileName = bankFileName;
+
+    // Only a dot after the last path separator starts an extension.
+    for( size_t j = fileName.size(); j > 0; --j )
+    {
+        MappedFileChar c = fileName[ j - 1 ];
+        if ( c == '\\' || c == '/' )
+            break;
+
+        if ( c == '.' )
+        {
+            fileName.erase( j - 1 );
+            break;
+        }
+    }
+
+    const MappedFileChar extension[] = { '.', 'x', 'w', 'i', 0 };
+    fileName += extension;
+    return fileName;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+WaveBankNameBenchmark DirectX::BenchmarkWaveBankNameLookup( uint32_t entryCount, size_t lookups )
+{
+    WaveBankNameBenchmark result;
+    memset( &result, 0, sizeof(result) );
+    result.entryCount = entryCount;
+
+    if ( !entryCount || !lookups )
+        return result;
+
+    // Names sharing long prefixes, as asset names do, laid out as xwbtool does.
+    static const char* const prefixes[] = { "ui_click_", "weapon_fire_", "explosion_large_", "footstep_stone_", "ambient_wind_" };
+    const size_t stride = MaxNameLength;
+
+    std::unique_ptr<char[]> table( new char[ size_t( entryCount ) * stride ] );
+    memset( table.get(), 0, size_t( entryCount ) * stride );
+
+    std::vector<std::string> names( entryCount );
+    for( uint32_t j = 0; j < entryCount; ++j )
+    {
+        std::string& name = names[ j ];
+        name = prefixes[ j % ( sizeof(prefixes) / sizeof(prefixes[0]) ) ];
+
+        char digits[ 11 ];
+        size_t k = sizeof(digits) - 1;
+        digits[ k ] = 0;
+        uint32_t n = j;
+        do
+        {
+            digits[ --k ] = static_cast<char>( '0' + n % 10 );
+            n /= 10;
+        } while( n );
+        name += &digits[ k ];
+
+        memcpy( table.get() + size_t( j ) * stride, name.c_str(), name.size() );
+    }
+
+    std::vector<const char*> queries( lookups );
+    uint32_t seed = 0x9E3779B9u;
+    for( size_t j = 0; j < lookups; ++j )
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        queries[ j ] = names[ seed % entryCount ].c_str();
+    }
+
+    volatile uint32_t sink = 0;
+    uint32_t sum = 0;
+
+    // Linear scan, stopping at the first match
+    double start = SteadyClock();
+    for( size_t j = 0; j < lookups; ++j )
+    {
+        const char* query = queries[ j ];
+        size_t length = strlen( query );
+        for( uint32_t k = 0; k < entryCount; ++k )
+        {
+            const char* slot = table.get() + size_t( k ) * stride;
+            if ( NameLength( slot, stride ) == length && memcmp( slot, query, length ) == 0 )
+            {
+                sum += k;
+                break;
+            }
+        }
+    }
+    result.linearSeconds = ( SteadyClock() - start ) / double( lookups );
+
+    // std::map, as WaveBankReader kept before
+    start = SteadyClock();
+    std::map<std::string, uint32_t> map;
+    for( uint32_t j = 0; j < entryCount; ++j )
+    {
+        map[ names[ j ] ] = j;
+    }
+    result.mapBuildSeconds = SteadyClock() - start;
+
+    start = SteadyClock();
+    for( size_t j = 0; j < lookups; ++j )
+    {
+        auto it = map.find( queries[ j ] );
+        if ( it != map.end() )
+            sum += it->second;
+    }
+    result.mapSeconds = ( SteadyClock() - start ) / double( lookups );
+
+    // The index, built here
+    WaveBankNameIndex index;
+    start = SteadyClock();
+    index.Build( table.get(), stride, entryCount );
+    result.buildSeconds = SteadyClock() - start;
+
+    start = SteadyClock();
+    for( size_t j = 0; j < lookups; ++j )
+    {
+        sum += index.Find( queries[ j ] );
+    }
+    result.indexSeconds = ( SteadyClock() - start ) / double( lookups );
+
+    // The index, serialized and used in place as a mapped file would be
+    std::vector<uint32_t> serialized( index.GetSize() / sizeof(uint32_t) );
+    memcpy( &serialized[ 0 ], index.GetData(), index.GetSize() );
+
+    WaveBankNameIndex attached;
+    start = SteadyClock();
+    if ( attached.Attach( reinterpret_cast<const uint8_t*>( &serialized[ 0 ] ), index.GetSize(), table.get(), stride, entryCount ) )
+        sum += attached.Find( queries[ 0 ] );
+    result.attachSeconds = SteadyClock() - start;
+
+    sink = sink + sum;
+    return result;
+}
@@ -0,0 +1,96 @@
+//--------------------------------------------------------------------------------------
+// File: WaveBankNameIndex.h
+//
+// Sorted-hash index from wave bank entry friendly names to entry indices, built by
+// xwbtool and mapped at runtime
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+
+namespace DirectX
+{
+    // The names are the bank's own table: count slots of stride bytes, each a name
+    // of up to 64 characters padded with nuls. The index holds only hashes and
+    // entry numbers, sorted by hash, with a directory on the top bits of the hash
+    // that puts about one record in each bucket, so a lookup hashes the name once
+    // and compares it against one or two names. The serialized index is the same
+    // bytes in memory and on disk, little-endian.
+
+    class WaveBankNameIndex
+    {
+    public:
+        WaveBankNameIndex();
+
+        WaveBankNameIndex(WaveBankNameIndex&& moveFrom);
+        WaveBankNameIndex& operator= (WaveBankNameIndex&& moveFrom);
+
+        virtual ~WaveBankNameIndex();
+
+        // names must outlive the index, whichever way it was made.
+        void Build( const char* names, size_t stride, uint32_t count );
+
+        // Uses a serialized index in place, provided it was built from exactly this
+        // names table; otherwise returns false and the index is left empty.
+        bool Attach( const std::shared_ptr<const MappedFile>& file, const char* names, size_t stride, uint32_t count );
+        bool Attach( const uint8_t* data, size_t size, const char* names, size_t stride, uint32_t count );
+
+        void Reset();
+
+        // Returns the entry, or uint32_t(-1). A name given to several entries finds
+        // the last of them.
+        uint32_t Find( const char* name ) const;
+
+        bool IsEmpty() const;
+
+        // The serialized index, for writing out.
+        const uint8_t* GetData() const;
+        size_t GetSize() const;
+
+    private:
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        WaveBankNameIndex(WaveBankNameIndex const&);
+        WaveBankNameIndex& operator= (WaveBankNameIndex const&);
+    };
+
+    // The companion index for a bank: its file name with the extension changed
+    // to .xwi.
+    std::basic_string<MappedFileChar> GetNameIndexFileName( const MappedFileChar* bankFileName );
+
+
+    struct WaveBankNameBenchmark
+    {
+        uint32_t    entryCount;
+        double      linearSeconds;      // Per lookup, scanning the names table
+        double      mapSeconds;         // Per lookup, std::map<std::string, uint32_t>
+        double      indexSeconds;       // Per lookup, WaveBankNameIndex
+        double      mapBuildSeconds;    // Filling the map from the table
+        double      buildSeconds;       // Building the index from the table
+        double      attachSeconds;      // Validating a serialized index to use in place
+    };
+
+    // Makes a table of entryCount names, then looks up lookups of them, chosen at
+    // random, each way.
+    WaveBankNameBenchmark BenchmarkWaveBankNameLookup( uint32_t entryCount, size_t lookups );
+}
@@ -15,6 +15,7 @@
 
 #include "pch.h"
 #include "WaveBankReader.h"
+#include "WaveBankNameIndex.h"
 #include "Audio.h"
 #include "PlatformHelpers.h"
 
@@ -462,7 +463,8 @@ public:
         memset( &m_header, 0, sizeof(HEADER) );
         memset( &m_data, 0, sizeof(BANKDATA ) );
 
-        m_names.clear();
+        m_nameIndex.Reset();
+        m_names.reset();
         m_entries.reset();
         m_seekData.reset();
         m_waveData.reset();
@@ -483,9 +485,10 @@ public:
 
     HEADER                              m_header;
     BANKDATA                            m_data;
-    std::map<std::string, uint32_t>     m_names;
+    WaveBankNameIndex                   m_nameIndex;
 
 private:
+    std::unique_ptr<char[]>             m_names;
     std::unique_ptr<uint8_t[]>          m_entries;
     std::unique_ptr<uint8_t[]>          m_seekData;
     std::unique_ptr<uint8_t[]>          m_waveData;
@@ -697,14 +700,17 @@ HRESULT WaveBankReader::Impl::Open( const wchar_t* szFileName )
                 return HRESULT_FROM_WIN32( GetLastError() );
             }
 
-            for( uint32_t j = 0; j < m_data.dwEntryCount; ++j )
-            {
-                DWORD n = m_data.dwEntryNameElementSize * j;
+            m_names = std::move( temp );
 
-                char name[ 64 ] = {0};
-                strncpy_s( name, &temp.get()[ n ], 64 );
-
-                m_names[ name ] = j;
+            // xwbtool writes the index beside the bank; it's used in place if it
+            // was built from these names, and built here if not.
+            if ( m_data.dwEntryNameElementSize > 0 )
+            {
+                auto indexFile = MappedFile::Open( GetNameIndexFileName( szFileName ).c_str() );
+                if ( !m_nameIndex.Attach( indexFile, m_names.get(), m_data.dwEntryNameElementSize, m_data.dwEntryCount ) )
+                {
+                    m_nameIndex.Build( m_names.get(), m_data.dwEntryNameElementSize, m_data.dwEntryCount );
+                }
             }
         }
     }
@@ -1284,13 +1290,7 @@ HRESULT WaveBankReader::Open( const wchar_t* szFileName )
 _Use_decl_annotations_
 uint32_t WaveBankReader::Find( const char* name ) const
 {
-    auto it = pImpl->m_names.find( name );
-    if ( it != pImpl->m_names.cend() )
-    {
-        return it->second;
-    }
-
-    return uint32_t(-1);
+    return pImpl->m_nameIndex.Find( name );
 }
 
 
@@ -1319,7 +1319,7 @@ void WaveBankReader::WaitOnPrepare()
 
 bool WaveBankReader::HasNames() const
 {
-    return !pImpl->m_names.empty();
+    return !pImpl->m_nameIndex.IsEmpty();
 }
 
 
@@ -1355,6 +1355,12 @@ uint32_t WaveBankReader::BankAudioSize() const
 }
 
 
+uint32_t WaveBankReader::BankAudioOffset() const
+{
+    return pImpl->m_header.Segments[HEADER::SEGIDX_ENTRYWAVEDATA].dwOffset;
+}
+
+
 _Use_decl_annotations_
 HRESULT WaveBankReader::GetFormat( uint32_t index, WAVEFORMATEX* pFormat, size_t maxsize ) const
 {
@@ -53,6 +53,9 @@ namespace DirectX
 
         uint32_t BankAudioSize() const;
 
+        // Where the wave data starts in the file; Metadata::offsetBytes is from here.
+        uint32_t BankAudioOffset() const;
+
         HRESULT GetFormat( _In_ uint32_t index, _Out_writes_bytes_(maxsize) WAVEFORMATEX* pFormat, _In_ size_t maxsize ) const;
 
         HRESULT GetWaveData( _In_ uint32_t index, _Outptr_ const uint8_t** pData, _Out_ uint32_t& dataSize ) const;
@@ -97,6 +97,11 @@ namespace DirectX
         size_t  allocatedVoicesOneShot; // Number of XAudio2 voices allocated for one-shot sounds
         size_t  allocatedVoicesIdle;    // Number of XAudio2 voices allocated for one-shot sounds but not currently in use
         size_t  audioBytes;             // Total wave data (in bytes) in SoundEffects and in-memory WaveBanks
+        size_t  voicePoolHits;          // One-shots played on an idle voice from the pool
+        size_t  voicePoolMisses;        // One-shots that needed a new voice
+        size_t  voicePoolEvictions;     // Idle voices released by the pool policy or to make room
+        float   voicePoolCreateTimeMS;  // Average time to create a pooled voice (in milliseconds)
+        float   voicePoolCreateTimeMaxMS;   // Longest time to create a pooled voice (in milliseconds)
 #if defined(_XBOX_ONE) && defined(_TITLE)
         size_t  xmaAudioBytes;          // Total wave data (in bytes) in SoundEffects and in-memory WaveBanks allocated with ApuAlloc
 #endif
@@ -262,6 +267,13 @@ namespace DirectX
         void __cdecl TrimVoicePool();
             // Releases any currently unused voices
 
+        void __cdecl SetVoicePoolPolicy( size_t maxIdleVoices, float maxIdleSeconds, size_t maxPooledVoices = SIZE_MAX );
+            // Unused one-shot voices beyond maxIdleVoices are released least recently used first, and any unused for
+            // longer than maxIdleSeconds (0 for no limit) are released by Update; maxPooledVoices also counts those playing
+
+        void __cdecl PrewarmVoicePool( _In_ const WAVEFORMATEX* wfx, size_t count );
+            // Creates unused one-shot voices for the format ahead of time (such as at level load), up to count
+
         void __cdecl AllocateVoice( _In_ const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, _Outptr_result_maybenull_ IXAudio2SourceVoice** voice );
 
         void __cdecl DestroyVoice( _In_ IXAudio2SourceVoice* voice );
@@ -329,6 +341,9 @@ namespace DirectX
 
         int __cdecl Find( _In_z_ const char* name ) const;
 
+        void __cdecl PrewarmVoices( size_t voicesPerFormat );
+            // Prewarms the engine's voice pool for every format in the bank (for one-shots from an in-memory bank)
+
 #if defined(_XBOX_ONE) || (_WIN32_WINNT < _WIN32_WINNT_WIN8)
         bool __cdecl FillSubmitBuffer( int index, _Out_ XAUDIO2_BUFFER& buffer, _Out_ XAUDIO2_BUFFER_WMA& wmaBuffer ) const;
 #else
@@ -0,0 +1,2251 @@
+//--------------------------------------------------------------------------------------
+// File: WaveBankBuilder.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#include "WaveBankBuilder.h"
+#include "WAVParser.h"
+#include "ADPCMCodec.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+// VS 2010 has neither <chrono> nor <thread>, so there everything is loaded on the
+// calling thread.
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+#define WAVEBANKBUILDER_USE_QPC
+#define WAVEBANKBUILDER_NO_THREADS
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <atomic>
+#include <chrono>
+#include <system_error>
+#include <thread>
+#endif
+
+using namespace DirectX;
+
+
+namespace
+{
+    //----------------------------------------------------------------------------------
+    // Wave bank format
+    //----------------------------------------------------------------------------------
+
+    #define BLOCKALIGNPAD(a, b) \
+        ((((a) + ((b) - 1)) / (b)) * (b))
+
+    #define XACT_CONTENT_VERSION 46 // DirectX SDK (June 2010)
+
+    #pragma pack(push, 1)
+
+    static const size_t DVD_SECTOR_SIZE = 2048;
+    static const size_t DVD_BLOCK_SIZE = DVD_SECTOR_SIZE * 16;
+
+    static const size_t ALIGNMENT_MIN = 4;
+    static const size_t ALIGNMENT_DVD = DVD_SECTOR_SIZE;
+
+    static const size_t MAX_DATA_SEGMENT_SIZE = 0xFFFFFFFF;
+    static const size_t MAX_COMPACT_DATA_SEGMENT_SIZE = 0x001FFFFF;
+
+    struct REGION
+    {
+        uint32_t    dwOffset;   // Region offset, in bytes.
+        uint32_t    dwLength;   // Region length, in bytes.
+    };
+
+    struct SAMPLEREGION
+    {
+        uint32_t    dwStartSample;  // Start sample for the region.
+        uint32_t    dwTotalSamples; // Region length in samples.
+    };
+
+    struct HEADER
+    {
+        static const uint32_t SIGNATURE = 'DNBW';
+        static const uint32_t VERSION = 44;
+
+        enum SEGIDX
+        {
+            SEGIDX_BANKDATA = 0,       // Bank data
+            SEGIDX_ENTRYMETADATA,      // Entry meta-data
+            SEGIDX_SEEKTABLES,         // Storage for seek tables for the encoded waves.
+            SEGIDX_ENTRYNAMES,         // Entry friendly names
+            SEGIDX_ENTRYWAVEDATA,      // Entry wave data
+            SEGIDX_COUNT
+        };
+
+        uint32_t    dwSignature;            // File signature
+        uint32_t    dwVersion;              // Version of the tool that created the file
+        uint32_t    dwHeaderVersion;        // Version of the file format
+        REGION      Segments[SEGIDX_COUNT]; // Segment lookup table
+    };
+
+#ifdef _MSC_VER
+    #pragma warning( disable : 4201 4203 )
+#endif
+
+    union MINIWAVEFORMAT
+    {
+        static const uint32_t TAG_PCM   = 0x0;
+        static const uint32_t TAG_XMA   = 0x1;
+        static const uint32_t TAG_ADPCM = 0x2;
+        static const uint32_t TAG_WMA   = 0x3;
+
+        static const uint32_t BITDEPTH_8 = 0x0; // PCM only
+        static const uint32_t BITDEPTH_16 = 0x1; // PCM only
+
+        static const size_t ADPCM_BLOCKALIGN_CONVERSION_OFFSET = 22;
+
+        struct
+        {
+            uint32_t       wFormatTag      : 2;        // Format tag
+            uint32_t       nChannels       : 3;        // Channel count (1 - 6)
+            uint32_t       nSamplesPerSec  : 18;       // Sampling rate
+            uint32_t       wBlockAlign     : 8;        // Block alignment.  For WMA, lower 6 bits block alignment index, upper 2 bits bytes-per-second index.
+            uint32_t       wBitsPerSample  : 1;        // Bits per sample (8 vs. 16, PCM only); WMAudio2/WMAudio3 (for WMA)
+        };
+
+        uint32_t           dwValue;
+    };
+
+    struct ENTRY
+    {
+        union
+        {
+            struct
+            {
+                // Entry flags
+                uint32_t                   dwFlags  :  4;
+
+                // Duration of the wave, in units of one sample.
+                // For instance, a ten second long wave sampled
+                // at 48KHz would have a duration of 480,000.
+                // This value is not affected by the number of
+                // channels, the number of bits per sample, or the
+                // compression format of the wave.
+                uint32_t                   Duration : 28;
+            };
+            uint32_t dwFlagsAndDuration;
+        };
+
+        MINIWAVEFORMAT  Format;         // Entry format.
+        REGION          PlayRegion;     // Region within the wave data segment that contains this entry.
+        SAMPLEREGION    LoopRegion;     // Region within the wave data (in samples) that should loop.
+    };
+
+    struct ENTRYCOMPACT
+    {
+        uint32_t       dwOffset            : 21;       // Data offset, in multiplies of the bank alignment
+        uint32_t       dwLengthDeviation   : 11;       // Data length deviation, in bytes
+    };
+
+    struct BANKDATA
+    {
+        static const size_t BANKNAME_LENGTH = 64;
+
+        static const uint32_t TYPE_BUFFER = 0x00000000;
+        static const uint32_t TYPE_STREAMING = 0x00000001;
+
+        static const uint32_t FLAGS_ENTRYNAMES = 0x00010000;
+        static const uint32_t FLAGS_COMPACT = 0x00020000;
+        static const uint32_t FLAGS_SEEKTABLES = 0x00080000;
+
+        uint32_t        dwFlags;                        // Bank flags
+        uint32_t        dwEntryCount;                   // Number of entries in the bank
+        char            szBankName[BANKNAME_LENGTH];    // Bank friendly name
+        uint32_t        dwEntryMetaDataElementSize;     // Size of each entry meta-data element, in bytes
+        uint32_t        dwEntryNameElementSize;         // Size of each entry name element, in bytes
+        uint32_t        dwAlignment;                    // Entry alignment, in bytes
+        MINIWAVEFORMAT  CompactFormat;                  // Format data for compact bank
+        uint32_t        BuildTime[2];                   // Build timestamp, as a FILETIME
+    };
+
+    #pragma pack(pop)
+
+    static_assert( sizeof(REGION)==8, "Mismatch with xact3wb.h" );
+    static_assert( sizeof(SAMPLEREGION)==8, "Mismatch with xact3wb.h" );
+    static_assert( sizeof(HEADER)==52, "Mismatch with xact3wb.h" );
+    static_assert( sizeof(ENTRY)==24, "Mismatch with xact3wb.h" );
+    static_assert( sizeof(MINIWAVEFORMAT)==4, "Mismatch with xact3wb.h" );
+    static_assert( sizeof(ENTRYCOMPACT)==4, "Mismatch with xact3wb.h" );
+    static_assert( sizeof(BANKDATA)==96, "Mismatch with xact3wb.h" );
+
+
+    //----------------------------------------------------------------------------------
+    // .WAV formats, read from the bytes WAVParser points at
+    //----------------------------------------------------------------------------------
+
+    const uint32_t TAG_PCM          = 0x0001;   // WAVE_FORMAT_PCM
+    const uint32_t TAG_ADPCM        = 0x0002;   // WAVE_FORMAT_ADPCM
+    const uint32_t TAG_IEEE_FLOAT   = 0x0003;   // WAVE_FORMAT_IEEE_FLOAT
+    const uint32_t TAG_MPEGLAYER3   = 0x0055;   // WAVE_FORMAT_MPEGLAYER3
+    const uint32_t TAG_AC3_SPDIF    = 0x0092;   // WAVE_FORMAT_DOLBY_AC3_SPDIF
+    const uint32_t TAG_WMAUDIO2     = 0x0161;   // WAVE_FORMAT_WMAUDIO2
+    const uint32_t TAG_WMAUDIO3     = 0x0162;   // WAVE_FORMAT_WMAUDIO3
+    const uint32_t TAG_WMASPDIF     = 0x0164;   // WAVE_FORMAT_WMASPDIF
+    const uint32_t TAG_XMA          = 0x0165;   // WAVE_FORMAT_XMA
+    const uint32_t TAG_XMA2         = 0x0166;   // WAVE_FORMAT_XMA2
+    const uint32_t TAG_EXTENSIBLE   = 0xFFFE;   // WAVE_FORMAT_EXTENSIBLE
+
+    // WAVEFORMATEX
+    const size_t FMT_TAG            = 0;
+    const size_t FMT_CHANNELS       = 2;
+    const size_t FMT_SAMPLE_RATE    = 4;
+    const size_t FMT_AVG_BYTES      = 8;
+    const size_t FMT_BLOCK_ALIGN    = 12;
+    const size_t FMT_BITS           = 14;
+    const size_t FMT_CBSIZE         = 16;
+    const size_t WAVEFORMATEX_BYTES = 18;
+
+    // ADPCMWAVEFORMAT
+    const size_t ADPCM_SAMPLES_PER_BLOCK_FIELD = 18;
+    const size_t ADPCM_NUM_COEF     = 20;
+    const size_t ADPCM_COEF         = 22;
+    const size_t ADPCM_EXTRA_BYTES  = 32;       // MSADPCM_FORMAT_EXTRA_BYTES
+    const size_t ADPCM_FORMAT_BYTES = WAVEFORMATEX_BYTES + ADPCM_EXTRA_BYTES;
+
+    // XMA2WAVEFORMATEX
+    const size_t XMA2_NUM_STREAMS   = 18;
+    const size_t XMA2_CHANNEL_MASK  = 20;
+    const size_t XMA2_SAMPLES_ENCODED = 24;
+    const size_t XMA2_BYTES_PER_BLOCK = 28;
+    const size_t XMA2_PLAY_BEGIN    = 32;
+    const size_t XMA2_PLAY_LENGTH   = 36;
+    const size_t XMA2_LOOP_BEGIN    = 40;
+    const size_t XMA2_LOOP_LENGTH   = 44;
+    const size_t XMA2_ENCODER_VERSION = 49;
+    const size_t XMA2_BLOCK_COUNT   = 50;
+    const size_t XMA2_EXTRA_BYTES   = 34;
+
+    // WAVEFORMATEXTENSIBLE
+    const size_t EXT_VALID_BITS     = 18;
+    const size_t EXT_CHANNEL_MASK   = 20;
+    const size_t EXT_SUBFORMAT      = 24;
+    const size_t EXT_EXTRA_BYTES    = 22;
+
+    // KSDATAFORMAT_SUBTYPE_* share everything after Data1.
+    const uint8_t s_subtypeBase[ 12 ] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+    // Frames per block when compressing; small enough for the compact format's block size.
+    const int ADPCM_SAMPLES_PER_BLOCK = 512;
+
+    uint16_t ReadU16( const uint8_t* p )
+    {
+        uint16_t value;
+        memcpy( &value, p, sizeof(value) );
+        return value;
+    }
+
+    uint32_t ReadU32( const uint8_t* p )
+    {
+        uint32_t value;
+        memcpy( &value, p, sizeof(value) );
+        return value;
+    }
+
+    void WriteU16( uint8_t* p, uint32_t value )
+    {
+        uint16_t v = static_cast<uint16_t>( value );
+        memcpy( p, &v, sizeof(v) );
+    }
+
+    void WriteU32( uint8_t* p, uint32_t value )
+    {
+        memcpy( p, &value, sizeof(value) );
+    }
+
+    uint32_t ByteSwap32( uint32_t value )
+    {
+        return ( value >> 24 ) | ( ( value >> 8 ) & 0xFF00 ) | ( ( value << 8 ) & 0xFF0000 ) | ( value << 24 );
+    }
+
+    // Appends to a log; every message starts a new line after the file name.
+    void Log( std::string& log, const char* format, ... )
+    {
+        char text[ 512 ];
+
+        va_list args;
+        va_start( args, format );
+#ifdef _MSC_VER
+        _vsnprintf_s( text, _TRUNCATE, format, args );
+#else
+        vsnprintf( text, sizeof(text), format, args );
+#endif
+        va_end( args );
+
+        log += text;
+    }
+
+    template <typename T> uint32_t ChannelsSpecifiedInMask(T x)
+    {
+        uint32_t bitCount = 0;
+        while (x) {++bitCount; x &= (x-1);}
+        return bitCount;
+    }
+
+    uint32_t AdpcmBlockSizeFromPcmFrames(uint32_t nPcmFrames, uint32_t nChannels)
+    {
+        // The full calculation is as follows:
+        //    UINT uHeaderBytes = MSADPCM_HEADER_LENGTH * nChannels;
+        //    UINT uBitsPerSample = MSADPCM_BITS_PER_SAMPLE * nChannels;
+        //    UINT uBlockAlign = uHeaderBytes + (nPcmFrames - 2) * uBitsPerSample / 8;
+        //    return WORD(uBlockAlign);
+
+        assert(nChannels == 1 || nChannels == 2);
+
+        if (nPcmFrames)
+        {
+            if (nChannels == 1)
+            {
+                assert(nPcmFrames % 2 == 0); // Mono data needs even nPcmFrames
+                return nPcmFrames / 2 + 6;
+            }
+            else
+            {
+                return nPcmFrames + 12;
+            }
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    uint32_t EncodeWMABlockAlign(uint32_t dwBlockAlign, uint32_t dwAvgBytesPerSec)
+    {
+        static const uint32_t aWMABlockAlign[] =
+        {
+            929,
+            1487,
+            1280,
+            2230,
+            8917,
+            8192,
+            4459,
+            5945,
+            2304,
+            1536,
+            1485,
+            1008,
+            2731,
+            4096,
+            6827,
+            5462,
+            1280
+        };
+
+        static const uint32_t aWMAAvgBytesPerSec[] =
+        {
+            12000,
+            24000,
+            4000,
+            6000,
+            8000,
+            20000,
+            2500
+        };
+
+        auto bit = std::find( std::begin(aWMABlockAlign), std::end(aWMABlockAlign), dwBlockAlign );
+        if ( bit == std::end(aWMABlockAlign) )
+            return uint32_t(-1);
+
+        uint32_t blockAlignIndex = uint32_t(bit - std::begin(aWMABlockAlign));
+
+        auto ait = std::find( std::begin(aWMAAvgBytesPerSec), std::end(aWMAAvgBytesPerSec), dwAvgBytesPerSec );
+        if ( ait == std::end(aWMAAvgBytesPerSec) )
+            return uint32_t(-1);
+
+        uint32_t bytesPerSecIndex = uint32_t(ait - std::begin(aWMAAvgBytesPerSec));
+
+        return uint32_t( blockAlignIndex | (bytesPerSecIndex << 5) );
+    }
+
+    const char* GetFormatTagName( uint32_t wFormatTag )
+    {
+        switch( wFormatTag )
+        {
+        case TAG_PCM: return "PCM";
+        case TAG_ADPCM: return "MS ADPCM";
+        case TAG_EXTENSIBLE: return "EXTENSIBLE";
+        case TAG_IEEE_FLOAT: return "IEEE float";
+        case TAG_MPEGLAYER3: return "ISO/MPEG Layer3";
+        case TAG_AC3_SPDIF: return "Dolby Audio Codec 3 over S/PDIF";
+        case TAG_WMAUDIO2: return "Windows Media Audio";
+        case TAG_WMAUDIO3: return "Windows Media Audio Pro";
+        case TAG_WMASPDIF: return "Windows Media Audio over S/PDIF";
+        case TAG_XMA: return "Xbox XMA";
+        case TAG_XMA2: return "Xbox XMA2";
+        default: return "*UNKNOWN*";
+        }
+    }
+
+    const char* GetParseResultName( WAV_PARSE_RESULT result )
+    {
+        switch( result )
+        {
+        case WAV_PARSE_INVALID: return "not a valid .WAV file";
+        case WAV_PARSE_TRUNCATED: return "file is truncated";
+        case WAV_PARSE_NO_AUDIO: return "no audio data";
+        case WAV_PARSE_UNSUPPORTED: return "unsupported format";
+        case WAV_PARSE_OPEN_FAILED: return "could not open file";
+        default: return "unknown error";
+        }
+    }
+
+    bool ConvertXWMAToMiniFormat( const uint8_t* wfx, uint32_t nBlockAlign, uint32_t nAvgBytesPerSec, MINIWAVEFORMAT& miniFmt, std::string& log )
+    {
+        miniFmt.wFormatTag = MINIWAVEFORMAT::TAG_WMA;
+        miniFmt.wBitsPerSample = ( ReadU16( wfx + FMT_TAG ) == TAG_WMAUDIO3 ) ? MINIWAVEFORMAT::BITDEPTH_16 : MINIWAVEFORMAT::BITDEPTH_8;
+
+        uint32_t blockAlign = EncodeWMABlockAlign( nBlockAlign, nAvgBytesPerSec );
+        if ( blockAlign == uint32_t(-1) )
+        {
+            Log( log, "\nERROR: Failed encoding nBlockAlign and nAvgBytesPerSec for xWMA" );
+            return false;
+        }
+        miniFmt.wBlockAlign = blockAlign;
+        return true;
+    }
+
+    bool ConvertToMiniFormat( const uint8_t* wfx, uint32_t formatBytes, bool hasSeek, MINIWAVEFORMAT& miniFmt, std::string& log )
+    {
+        if ( !wfx )
+            return false;
+
+        uint32_t wFormatTag = ReadU16( wfx + FMT_TAG );
+        uint32_t nChannels = ReadU16( wfx + FMT_CHANNELS );
+        uint32_t nSamplesPerSec = ReadU32( wfx + FMT_SAMPLE_RATE );
+        uint32_t nAvgBytesPerSec = ReadU32( wfx + FMT_AVG_BYTES );
+        uint32_t nBlockAlign = ReadU16( wfx + FMT_BLOCK_ALIGN );
+        uint32_t wBitsPerSample = ReadU16( wfx + FMT_BITS );
+
+        // PCM may be a PCMWAVEFORMAT; WAVParser has checked cbSize fits everything else.
+        uint32_t cbSize = ( formatBytes >= WAVEFORMATEX_BYTES ) ? ReadU16( wfx + FMT_CBSIZE ) : 0;
+
+        if ( !nChannels )
+        {
+            Log( log, "\nERROR: Wave bank entry must have at least 1 channel" );
+            return false;
+        }
+
+        if ( nChannels > 7 )
+        {
+            Log( log, "\nERROR: Wave banks only support up to 7 channels" );
+            return false;
+        }
+
+        if ( !nSamplesPerSec )
+        {
+            Log( log, "\nERROR: Wave banks entry sample rate must be non-zero" );
+            return false;
+        }
+
+        if ( nSamplesPerSec > 262143 )
+        {
+            Log( log, "\nERROR: Wave banks only support sample rates up to 2^18 (262143)" );
+            return false;
+        }
+
+        miniFmt.dwValue = 0;
+        miniFmt.nSamplesPerSec = nSamplesPerSec;
+        miniFmt.nChannels = nChannels;
+
+        switch ( wFormatTag )
+        {
+        case TAG_PCM:
+            if ( ( wBitsPerSample != 8 ) && ( wBitsPerSample != 16 ) )
+            {
+                Log( log, "\nERROR: Wave banks only support 8-bit or 16-bit integer PCM data" );
+                return false;
+            }
+
+            if ( nBlockAlign > 255 )
+            {
+                Log( log, "\nERROR: Wave banks only support block alignments up to 255 (%u)", nBlockAlign );
+                return false;
+            }
+
+            if ( nBlockAlign != ( nChannels * wBitsPerSample / 8 ) )
+            {
+                Log( log, "\nERROR: nBlockAlign (%u) != nChannels (%u) * wBitsPerSample (%u) / 8",
+                     nBlockAlign, nChannels, wBitsPerSample );
+                return false;
+            }
+
+            if ( nAvgBytesPerSec != ( nSamplesPerSec * nBlockAlign ) )
+            {
+                Log( log, "\nERROR: nAvgBytesPerSec (%u) != nSamplesPerSec (%u) * nBlockAlign (%u)",
+                     nAvgBytesPerSec, nSamplesPerSec, nBlockAlign );
+                return false;
+            }
+
+            miniFmt.wFormatTag = MINIWAVEFORMAT::TAG_PCM;
+            miniFmt.wBitsPerSample = (wBitsPerSample == 16) ? MINIWAVEFORMAT::BITDEPTH_16 : MINIWAVEFORMAT::BITDEPTH_8;
+            miniFmt.wBlockAlign = nBlockAlign;
+            return true;
+
+        case TAG_IEEE_FLOAT:
+            Log( log, "\nERROR: Wave banks do not support IEEE float PCM data" );
+            return false;
+
+        case TAG_ADPCM:
+            if ( ( nChannels != 1 ) && ( nChannels != 2 ) )
+            {
+                Log( log, "\nERROR: ADPCM wave format must have 1 or 2 channels (not %u)", nChannels );
+                return false;
+            }
+
+            if ( wBitsPerSample != 4 /*MSADPCM_BITS_PER_SAMPLE*/ )
+            {
+                Log( log, "\nERROR: ADPCM wave format must have 4 bits per sample (not %u)", wBitsPerSample );
+                return false;
+            }
+
+            if ( cbSize != ADPCM_EXTRA_BYTES )
+            {
+                Log( log, "\nERROR: ADPCM wave format must have cbSize = 32 (not %u)", cbSize );
+                return false;
+            }
+            else
+            {
+                uint32_t wNumCoef = ReadU16( wfx + ADPCM_NUM_COEF );
+                if ( wNumCoef != 7 /*MSADPCM_NUM_COEFFICIENTS*/ )
+                {
+                    Log( log, "\nERROR: ADPCM wave format must have 7 coefficients (not %u)", wNumCoef );
+                    return false;
+                }
+
+                bool valid = true;
+                for ( int j = 0; j < ADPCMCoefficientCount; ++j )
+                {
+                    short iCoef1 = static_cast<short>( ReadU16( wfx + ADPCM_COEF + j * 4 ) );
+                    short iCoef2 = static_cast<short>( ReadU16( wfx + ADPCM_COEF + j * 4 + 2 ) );
+
+                    if ( iCoef1 != ADPCMCoefficients1[j] || iCoef2 != ADPCMCoefficients2[j] )
+                    {
+                        valid = false;
+                    }
+                }
+
+                if ( !valid )
+                {
+                    Log( log, "\nERROR: Non-standard coefficients for ADPCM found" );
+                    return false;
+                }
+
+                uint32_t wSamplesPerBlock = ReadU16( wfx + ADPCM_SAMPLES_PER_BLOCK_FIELD );
+                if ( ( wSamplesPerBlock < 4 /*MSADPCM_MIN_SAMPLES_PER_BLOCK*/ )
+                      ||  ( wSamplesPerBlock > 64000 /*MSADPCM_MAX_SAMPLES_PER_BLOCK*/ ) )
+                {
+                    Log( log, "\nERROR: ADPCM wave format wSamplesPerBlock must be 4..64000" );
+                    return false;
+                }
+
+                if ( nChannels == 1 && ( wSamplesPerBlock % 2 ) )
+                {
+                    Log( log, "\nERROR: ADPCM wave format mono files must have even wSamplesPerBlock" );
+                    return false;
+                }
+
+                int nHeaderBytes = 7 /*MSADPCM_HEADER_LENGTH*/ * int( nChannels );
+                int nBitsPerFrame = 4 /*MSADPCM_BITS_PER_SAMPLE*/ * int( nChannels );
+                int nPcmFramesPerBlock = ( int( nBlockAlign ) - nHeaderBytes ) * 8 / nBitsPerFrame + 2;
+
+                if ( int( wSamplesPerBlock ) != nPcmFramesPerBlock )
+                {
+                    Log( log, "\nERROR: ADPCM %u-channel format with nBlockAlign = %u must have wSamplesPerBlock = %d (not %u)",
+                         nChannels, nBlockAlign, nPcmFramesPerBlock, wSamplesPerBlock );
+                    return false;
+                }
+
+                miniFmt.wFormatTag = MINIWAVEFORMAT::TAG_ADPCM;
+                miniFmt.wBitsPerSample = 0;
+                miniFmt.wBlockAlign = AdpcmBlockSizeFromPcmFrames( wSamplesPerBlock, 1 ) - MINIWAVEFORMAT::ADPCM_BLOCKALIGN_CONVERSION_OFFSET;
+            }
+            return true;
+
+        case TAG_WMAUDIO2:
+        case TAG_WMAUDIO3:
+            if ( !hasSeek )
+            {
+                Log( log, "\nERROR: xWMA requires seek tables ('dpds' chunk)" );
+                return false;
+            }
+
+            if ( wBitsPerSample != 16 )
+            {
+                Log( log, "\nERROR: Wave banks only support 16-bit xWMA data" );
+                return false;
+            }
+
+            if ( !nBlockAlign )
+            {
+                Log( log, "\nERROR: Wave bank xWMA must have a non-zero nBlockAlign" );
+                return false;
+            }
+
+            if ( !nAvgBytesPerSec )
+            {
+                Log( log, "\nERROR: Wave bank xWMA must have a non-zero nAvgBytesPerSec" );
+                return false;
+            }
+
+            if ( cbSize != 0 )
+            {
+                Log( log, "\nERROR: Unexpected data found in xWMA header" );
+                return false;
+            }
+
+            return ConvertXWMAToMiniFormat( wfx, nBlockAlign, nAvgBytesPerSec, miniFmt, log );
+
+        case TAG_XMA2:
+            if ( !hasSeek )
+            {
+                Log( log, "\nERROR: XMA2 requires seek tables ('seek' chunk)" );
+                return false;
+            }
+
+            if ( nBlockAlign != nChannels * 2 /*XMA_OUTPUT_SAMPLE_BYTES*/ )
+            {
+                Log( log, "\nERROR: XMA2 nBlockAlign (%u) != nChannels(%u) * 2", nBlockAlign, nChannels );
+                return false;
+            }
+
+            if ( wBitsPerSample != 16 /*XMA_OUTPUT_SAMPLE_BITS*/ )
+            {
+                Log( log, "\nERROR: XMA2 wBitsPerSample (%u) should be 16", wBitsPerSample );
+                return false;
+            }
+
+            if ( cbSize != XMA2_EXTRA_BYTES )
+            {
+                Log( log, "\nERROR: XMA2 cbSize must be %u (%u)", uint32_t( XMA2_EXTRA_BYTES ), cbSize );
+                return false;
+            }
+            else
+            {
+                uint32_t encoderVersion = wfx[ XMA2_ENCODER_VERSION ];
+                if ( encoderVersion < 3 )
+                {
+                    Log( log, "\nERROR: XMA2 encoder version (%u) - 3 or higher is required", encoderVersion );
+                    return false;
+                }
+
+                if ( !ReadU16( wfx + XMA2_BLOCK_COUNT ) )
+                {
+                    Log( log, "\nERROR: XMA2 BlockCount must be non-zero" );
+                    return false;
+                }
+
+                uint32_t bytesPerBlock = ReadU32( wfx + XMA2_BYTES_PER_BLOCK );
+                if ( !bytesPerBlock || ( bytesPerBlock > 8386560 /*XMA_READBUFFER_MAX_BYTES*/ ) )
+                {
+                    Log( log, "\nERROR: XMA2 BytesPerBlock (%u) is invalid", bytesPerBlock );
+                    return false;
+                }
+
+                uint32_t channelMask = ReadU32( wfx + XMA2_CHANNEL_MASK );
+                if ( channelMask )
+                {
+                    auto channelBits = ChannelsSpecifiedInMask( channelMask );
+                    if ( channelBits != nChannels )
+                    {
+                        Log( log, "\nERROR: XMA2 nChannels=%u but ChannelMask (%08X) has %u bits set",
+                             nChannels, channelMask, channelBits );
+                        return false;
+                    }
+                }
+
+                uint32_t numStreams = ReadU16( wfx + XMA2_NUM_STREAMS );
+                if ( numStreams != ( ( nChannels + 1) / 2 ) )
+                {
+                    Log( log, "\nERROR: XMA2 NumStreams (%u) != ( nChannels(%u) + 1 ) / 2", numStreams, nChannels );
+                    return false;
+                }
+
+                uint32_t samplesEncoded = ReadU32( wfx + XMA2_SAMPLES_ENCODED );
+                if ( !samplesEncoded )
+                {
+                    Log( log, "\nERROR: XMA2 SamplesEncoded must be non-zero" );
+                    return false;
+                }
+
+                uint32_t playBegin = ReadU32( wfx + XMA2_PLAY_BEGIN );
+                uint32_t playLength = ReadU32( wfx + XMA2_PLAY_LENGTH );
+                if ( ( uint64_t( playBegin ) + playLength ) > samplesEncoded )
+                {
+                    Log( log, "\nERROR: XMA2 play region too large (%u + %u > %u)", playBegin, playLength, samplesEncoded );
+                    return false;
+                }
+
+                uint32_t loopBegin = ReadU32( wfx + XMA2_LOOP_BEGIN );
+                uint32_t loopLength = ReadU32( wfx + XMA2_LOOP_LENGTH );
+                if ( ( uint64_t( loopBegin ) + loopLength ) > samplesEncoded )
+                {
+                    Log( log, "\nERROR: XMA2 loop region too large (%u + %u > %u)", loopBegin, loopLength, samplesEncoded );
+                    return false;
+                }
+
+                miniFmt.wFormatTag = MINIWAVEFORMAT::TAG_XMA;
+                miniFmt.wBlockAlign = 2 * nChannels;
+                miniFmt.wBitsPerSample = MINIWAVEFORMAT::BITDEPTH_16;
+            }
+            return true;
+
+        case TAG_EXTENSIBLE:
+            if ( cbSize < EXT_EXTRA_BYTES )
+            {
+                Log( log, "\nERROR: WAVEFORMATEXTENSIBLE cbSize must be at least %u (%u)", uint32_t( EXT_EXTRA_BYTES ), cbSize );
+                return false;
+            }
+            else
+            {
+                const uint8_t* subFormat = wfx + EXT_SUBFORMAT;
+                if ( memcmp( subFormat + sizeof(uint32_t), s_subtypeBase, sizeof(s_subtypeBase) ) != 0 )
+                {
+                    Log( log, "\nERROR: WAVEFORMATEXTENSIBLE encountered with unknown GUID ({%8.8X-%4.4X-%4.4X-%2.2X%2.2X-%2.2X%2.2X%2.2X%2.2X%2.2X%2.2X})",
+                         ReadU32( subFormat ), ReadU16( subFormat + 4 ), ReadU16( subFormat + 6 ),
+                         subFormat[8], subFormat[9], subFormat[10], subFormat[11],
+                         subFormat[12], subFormat[13], subFormat[14], subFormat[15] );
+                    return false;
+                }
+
+                uint32_t wValidBitsPerSample = ReadU16( wfx + EXT_VALID_BITS );
+
+                switch( ReadU32( subFormat ) )
+                {
+                case TAG_PCM:
+                    if ( ( wBitsPerSample != 8 ) && ( wBitsPerSample != 16 ) )
+                    {
+                        Log( log, "\nERROR: Wave banks only support 8-bit or 16-bit integer PCM data (%u)", wBitsPerSample );
+                        return false;
+                    }
+
+                    if ( !wValidBitsPerSample )
+                    {
+                        Log( log, "\nWARNING: Integer PCM WAVEFORMATEXTENSIBLE format should not have wValidBitsPerSample = 0" );
+                    }
+                    else if ( ( ( wValidBitsPerSample != 8 ) && ( wValidBitsPerSample != 16 ) )
+                              || ( wValidBitsPerSample > wBitsPerSample ) )
+                    {
+                        Log( log, "\nERROR: Unexpected wValidBitsPerSample value (%u)", wValidBitsPerSample );
+                        return false;
+                    }
+
+                    if ( nBlockAlign > 255 )
+                    {
+                        Log( log, "\nERROR: Wave banks only support block alignments up to 255 (%u)", nBlockAlign );
+                        return false;
+                    }
+
+                    if ( nBlockAlign != ( nChannels * wBitsPerSample / 8 ) )
+                    {
+                        Log( log, "\nERROR: nBlockAlign (%u) != nChannels (%u) * wBitsPerSample (%u) / 8",
+                             nBlockAlign, nChannels, wBitsPerSample );
+                        return false;
+                    }
+
+                    if ( nAvgBytesPerSec != ( nSamplesPerSec * nBlockAlign ) )
+                    {
+                        Log( log, "\nERROR: nAvgBytesPerSec (%u) != nSamplesPerSec (%u) * nBlockAlign (%u)",
+                             nAvgBytesPerSec, nSamplesPerSec, nBlockAlign );
+                        return false;
+                    }
+
+                    miniFmt.wFormatTag = MINIWAVEFORMAT::TAG_PCM;
+                    miniFmt.wBitsPerSample = (wValidBitsPerSample == 16) ? MINIWAVEFORMAT::BITDEPTH_16 : MINIWAVEFORMAT::BITDEPTH_8;
+                    miniFmt.wBlockAlign = nBlockAlign;
+                    break;
+
+                case TAG_IEEE_FLOAT:
+                    Log( log, "\nERROR: Wave banks do not support float PCM data" );
+                    return false;
+
+                case TAG_ADPCM:
+                    Log( log, "\nERROR: ADPCM is not supported as a WAVEFORMATEXTENSIBLE" );
+                    return false;
+
+                case TAG_WMAUDIO2:
+                case TAG_WMAUDIO3:
+                    if ( !hasSeek )
+                    {
+                        Log( log, "\nERROR: xWMA requires seek tables (dpds chunk)" );
+                        return false;
+                    }
+
+                    if ( wBitsPerSample != 16 )
+                    {
+                        Log( log, "\nERROR: Wave banks only support 16-bit xWMA data" );
+                        return false;
+                    }
+
+                    if ( !nBlockAlign )
+                    {
+                        Log( log, "\nERROR: Wave bank xWMA must have a non-zero nBlockAlign" );
+                        return false;
+                    }
+
+                    if ( !nAvgBytesPerSec )
+                    {
+                        Log( log, "\nERROR: Wave bank xWMA must have a non-zero nAvgBytesPerSec" );
+                        return false;
+                    }
+
+                    if ( !ConvertXWMAToMiniFormat( wfx, nBlockAlign, nAvgBytesPerSec, miniFmt, log ) )
+                        return false;
+                    break;
+
+                case TAG_XMA2:
+                    Log( log, "\nERROR: XMA2 is not supported as a WAVEFORMATEXTENSIBLE" );
+                    return false;
+
+                default:
+                    Log( log, "\nERROR: Unknown WAVEFORMATEXTENSIBLE format tag" );
+                    return false;
+                }
+
+                uint32_t dwChannelMask = ReadU32( wfx + EXT_CHANNEL_MASK );
+                if ( dwChannelMask )
+                {
+                    auto channelBits = ChannelsSpecifiedInMask( dwChannelMask );
+                    if ( channelBits != nChannels )
+                    {
+                        Log( log, "\nERROR: WAVEFORMATEXTENSIBLE: nChannels=%u but ChannelMask has %u bits set",
+                             nChannels, channelBits );
+                        return false;
+                    }
+                    else
+                    {
+                        Log( log, "\nWARNING: WAVEFORMATEXTENSIBLE ChannelMask is ignored in wave banks" );
+                    }
+                }
+
+                return true;
+            }
+
+        default:
+            return false;
+        }
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Build cache
+    //----------------------------------------------------------------------------------
+
+    // Header, then count records, each followed by its payload: the log text, then
+    // for a compressed wave its format and blocks, padded to 8 bytes. Offsets in
+    // a record are into the source file, which has the same contents as when the
+    // record was written.
+    const uint32_t CACHE_MAGIC      = 'CBWX';   // "XWBC" in the file
+    const uint32_t CACHE_VERSION    = 1;
+
+    const uint32_t CACHE_ADPCM      = 0x1;      // Built with WaveBankBuild_ADPCM
+    const uint32_t CACHE_CONVERTED  = 0x2;      // Format and audio are in the payload
+
+    struct CACHEHEADER
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        uint32_t    count;
+        uint32_t    reserved;
+    };
+
+    struct CACHERECORD
+    {
+        uint64_t    contentHash;
+        uint64_t    fileSize;
+        uint64_t    audioHash;
+        uint32_t    flags;
+        uint32_t    miniFormat;
+        uint32_t    formatOffset;
+        uint32_t    formatBytes;
+        uint32_t    audioOffset;
+        uint32_t    audioBytes;
+        uint32_t    seekOffset;
+        uint32_t    seekCount;
+        uint32_t    loopStart;
+        uint32_t    loopLength;
+        uint32_t    logBytes;
+        uint32_t    payloadBytes;
+    };
+
+    static_assert( sizeof(CACHEHEADER) == 16, "Cache layout" );
+    static_assert( sizeof(CACHERECORD) == 72, "Cache layout" );
+
+    // A multiply and a fold of the high half per word, so that every bit of a
+    // word reaches every bit of the hash; fast enough to run over every file on
+    // every build.
+    uint64_t HashBytes( const uint8_t* data, size_t bytes )
+    {
+        const uint64_t k = 0xc6a4a7935bd1e995ull;
+
+        uint64_t hash = 0x9E3779B97F4A7C15ull ^ ( uint64_t( bytes ) * k );
+
+        size_t j = 0;
+        for( ; j + sizeof(uint64_t) <= bytes; j += sizeof(uint64_t) )
+        {
+            uint64_t word;
+            memcpy( &word, data + j, sizeof(word) );
+            hash = ( hash ^ word ) * k;
+            hash ^= hash >> 32;
+        }
+
+        if ( j < bytes )
+        {
+            uint64_t word = 0;
+            memcpy( &word, data + j, bytes - j );
+            hash = ( hash ^ word ) * k;
+            hash ^= hash >> 32;
+        }
+
+        hash ^= hash >> 29;
+        hash *= k;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    bool InRange( uint64_t offset, uint64_t bytes, uint64_t size )
+    {
+        return offset <= size && bytes <= size - offset;
+    }
+
+    // What a previous build found for each file, read from the cache.
+    class BuildCache
+    {
+    public:
+        void Open( const MappedFileChar* fileName )
+        {
+            mRecords.clear();
+            mFile = MappedFile::Open( fileName );
+            if ( !mFile )
+                return;
+
+            const uint8_t* data = mFile->GetData();
+            size_t size = mFile->GetSize();
+            if ( size < sizeof(CACHEHEADER) )
+                return;
+
+            CACHEHEADER header;
+            memcpy( &header, data, sizeof(header) );
+            if ( header.magic != CACHE_MAGIC || header.version != CACHE_VERSION )
+                return;
+
+            // A record that doesn't fit ends the cache; the files it and those after
+            // it describe are simply loaded again.
+            size_t offset = sizeof(CACHEHEADER);
+            for( uint32_t j = 0; j < header.count; ++j )
+            {
+                if ( !InRange( offset, sizeof(CACHERECORD), size ) )
+                    break;
+
+                auto record = reinterpret_cast<const CACHERECORD*>( data + offset );
+                uint64_t payload = record->payloadBytes;
+                uint64_t needed = uint64_t( record->logBytes )
+                                  + ( ( record->flags & CACHE_CONVERTED ) ? uint64_t( record->formatBytes ) + record->audioBytes : 0 );
+                if ( needed > payload || ( payload % 8 ) != 0 || !InRange( offset + sizeof(CACHERECORD), payload, size ) )
+                    break;
+
+                mRecords[ record->contentHash ] = record;
+                offset += sizeof(CACHERECORD) + size_t( payload );
+            }
+        }
+
+        void Close()
+        {
+            mRecords.clear();
+            mFile.reset();
+        }
+
+        const CACHERECORD* Find( uint64_t contentHash, uint64_t fileSize, uint32_t flags ) const
+        {
+            auto it = mRecords.find( contentHash );
+            if ( it == mRecords.end() )
+                return nullptr;
+
+            const CACHERECORD* record = it->second;
+            if ( record->fileSize != fileSize || ( record->flags & CACHE_ADPCM ) != flags )
+                return nullptr;
+
+            return record;
+        }
+
+    private:
+        std::shared_ptr<const MappedFile>                       mFile;
+        std::unordered_map<uint64_t, const CACHERECORD*>        mRecords;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Files
+    //----------------------------------------------------------------------------------
+
+    // Writes go out this many bytes at a time, at offsets that are multiples of it.
+    const size_t WriteBlockBytes = 4 * 1024 * 1024;
+
+    FILE* OpenForWrite( const MappedFileChar* fileName )
+    {
+#ifdef _WIN32
+        FILE* file = nullptr;
+        return ( _wfopen_s( &file, fileName, L"wb" ) == 0 ) ? file : nullptr;
+#else
+        return fopen( fileName, "wb" );
+#endif
+    }
+
+    void RemoveFile( const MappedFileChar* fileName )
+    {
+#ifdef _WIN32
+        _wremove( fileName );
+#else
+        remove( fileName );
+#endif
+    }
+
+    // Gathers small writes into whole blocks and passes large ones straight
+    // through, so a bank of thousands of entries still goes to disk as a few
+    // large sequential writes.
+    class SequentialWriter
+    {
+    public:
+        SequentialWriter() :
+            mFile( nullptr ),
+            mUsed( 0 ),
+            mWritten( 0 ),
+            mFailed( false )
+        {
+        }
+
+        ~SequentialWriter()
+        {
+            if ( mFile )
+                fclose( mFile );
+        }
+
+        bool Open( const MappedFileChar* fileName )
+        {
+            mFile = OpenForWrite( fileName );
+            if ( !mFile )
+                return false;
+
+            setvbuf( mFile, nullptr, _IONBF, 0 );
+            mBuffer.reset( new uint8_t[ WriteBlockBytes ] );
+            return true;
+        }
+
+        void Write( const void* data, size_t bytes )
+        {
+            auto source = static_cast<const uint8_t*>( data );
+            while ( bytes > 0 && !mFailed )
+            {
+                if ( !mUsed && bytes >= WriteBlockBytes )
+                {
+                    size_t direct = bytes - ( bytes % WriteBlockBytes );
+                    Put( source, direct );
+                    source += direct;
+                    bytes -= direct;
+                    continue;
+                }
+
+                size_t chunk = std::min( bytes, WriteBlockBytes - mUsed );
+                memcpy( mBuffer.get() + mUsed, source, chunk );
+                mUsed += chunk;
+                source += chunk;
+                bytes -= chunk;
+
+                if ( mUsed == WriteBlockBytes )
+                {
+                    Put( mBuffer.get(), mUsed );
+                    mUsed = 0;
+                }
+            }
+        }
+
+        void Pad( size_t alignment )
+        {
+            static const uint8_t zeros[ DVD_SECTOR_SIZE ] = { 0 };
+
+            size_t remainder = size_t( GetPosition() % alignment );
+            size_t padding = remainder ? alignment - remainder : 0;
+            while ( padding > 0 )
+            {
+                size_t chunk = std::min( padding, sizeof(zeros) );
+                Write( zeros, chunk );
+                padding -= chunk;
+            }
+        }
+
+        uint64_t GetPosition() const { return mWritten + mUsed; }
+
+        bool Close()
+        {
+            if ( mUsed )
+                Put( mBuffer.get(), mUsed );
+            mUsed = 0;
+
+            if ( mFile && fclose( mFile ) != 0 )
+                mFailed = true;
+            mFile = nullptr;
+
+            return !mFailed;
+        }
+
+    private:
+        void Put( const uint8_t* data, size_t bytes )
+        {
+            if ( fwrite( data, 1, bytes, mFile ) != bytes )
+                mFailed = true;
+            mWritten += bytes;
+        }
+
+        FILE*                       mFile;
+        std::unique_ptr<uint8_t[]>  mBuffer;
+        size_t                      mUsed;
+        uint64_t                    mWritten;
+        bool                        mFailed;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Threading
+    //----------------------------------------------------------------------------------
+
+    unsigned int PoolSize( unsigned int threadCount, size_t count )
+    {
+#ifdef WAVEBANKBUILDER_NO_THREADS
+        UNREFERENCED_PARAMETER( threadCount );
+        UNREFERENCED_PARAMETER( count );
+        return 1;
+#else
+        if ( !threadCount )
+        {
+            threadCount = std::max( 1u, std::thread::hardware_concurrency() );
+        }
+        return unsigned( std::max<size_t>( 1, std::min<size_t>( threadCount, count ) ) );
+#endif
+    }
+
+    // Runs work( index ) for every index below count. Files vary widely in size,
+    // so each thread takes the next index as it finishes one rather than a fixed
+    // share. If a thread can't be started the others do its share.
+    template<typename Work>
+    void ForEachIndex( size_t count, unsigned int poolSize, Work work )
+    {
+#ifdef WAVEBANKBUILDER_NO_THREADS
+        UNREFERENCED_PARAMETER( poolSize );
+        for( size_t j = 0; j < count; ++j )
+        {
+            work( j );
+        }
+#else
+        std::atomic<size_t> next( 0 );
+        auto run = [&]()
+        {
+            for( ;; )
+            {
+                size_t j = next++;
+                if ( j >= count )
+                    break;
+                work( j );
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve( poolSize );
+        for( unsigned int j = 1; j < poolSize; ++j )
+        {
+            try
+            {
+                threads.emplace_back( run );
+            }
+            catch( const std::system_error& )
+            {
+                break;
+            }
+        }
+
+        run();
+
+        for( auto it = threads.begin(); it != threads.end(); ++it )
+        {
+            it->join();
+        }
+#endif
+    }
+
+    double SteadyClock()
+    {
+#ifdef WAVEBANKBUILDER_USE_QPC
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency( &frequency );
+        QueryPerformanceCounter( &counter );
+        return double( counter.QuadPart ) / double( frequency.QuadPart );
+#else
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>( now ).count();
+#endif
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Loaded waves
+    //----------------------------------------------------------------------------------
+
+    struct LoadedWave
+    {
+        std::shared_ptr<const MappedFile>   file;       // Keeps the pointers below valid
+        const uint8_t*                      format;
+        uint32_t                            formatBytes;
+        const uint8_t*                      startAudio;
+        uint32_t                            audioBytes;
+        uint32_t                            loopStart;
+        uint32_t                            loopLength;
+        const uint8_t*                      seek;       // May be unaligned
+        uint32_t                            seekCount;
+        std::vector<uint8_t>                converted;  // Format, then blocks, when compressed
+        MINIWAVEFORMAT                      miniFmt;
+        uint64_t                            contentHash;
+        uint64_t                            audioHash;
+        uint32_t                            offset;     // In the wave data segment
+
+        LoadedWave() :
+            format( nullptr ),
+            formatBytes( 0 ),
+            startAudio( nullptr ),
+            audioBytes( 0 ),
+            loopStart( 0 ),
+            loopLength( 0 ),
+            seek( nullptr ),
+            seekCount( 0 ),
+            contentHash( 0 ),
+            audioHash( 0 ),
+            offset( 0 )
+        {
+            miniFmt.dwValue = 0;
+        }
+
+        uint32_t Tag() const { return ReadU16( format + FMT_TAG ); }
+        uint32_t Channels() const { return ReadU16( format + FMT_CHANNELS ); }
+        uint32_t SampleRate() const { return ReadU32( format + FMT_SAMPLE_RATE ); }
+        uint32_t BlockAlign() const { return ReadU16( format + FMT_BLOCK_ALIGN ); }
+        uint32_t BitsPerSample() const { return ReadU16( format + FMT_BITS ); }
+
+        uint32_t FileOffset( const uint8_t* p ) const
+        {
+            return ( p && !converted.size() ) ? uint32_t( p - file->GetData() ) : 0;
+        }
+    };
+
+    void ConvertToADPCM( LoadedWave& wave, unsigned int encodeThreads, std::string& log )
+    {
+        uint32_t tag = wave.Tag();
+        if ( tag == TAG_ADPCM )
+            return;
+
+        uint32_t channels = wave.Channels();
+        if ( tag != TAG_PCM || wave.BitsPerSample() != 16 || ( channels != 1 && channels != 2 ) )
+        {
+            Log( log, "\nWARNING: Only 16-bit mono or stereo PCM is compressed to ADPCM" );
+            return;
+        }
+
+        // XAudio2 can only loop ADPCM on block boundaries.
+        if ( wave.loopLength > 0
+             && ( ( wave.loopStart % ADPCM_SAMPLES_PER_BLOCK ) != 0 || ( wave.loopLength % ADPCM_SAMPLES_PER_BLOCK ) != 0 ) )
+        {
+            Log( log, "\nWARNING: Loop region isn't a multiple of %d samples, so this wave stays PCM", ADPCM_SAMPLES_PER_BLOCK );
+            return;
+        }
+
+        size_t frames = wave.audioBytes / ( channels * 2 );
+
+        // RIFF only word aligns chunks, which is all 16-bit samples need, but a
+        // writer that ignores that leaves them misaligned.
+        std::vector<int16_t> aligned;
+        const int16_t* samples = reinterpret_cast<const int16_t*>( wave.startAudio );
+        if ( reinterpret_cast<uintptr_t>( wave.startAudio ) % sizeof(int16_t) )
+        {
+            aligned.resize( frames * channels + 1 );
+            memcpy( &aligned[ 0 ], wave.startAudio, frames * channels * sizeof(int16_t) );
+            samples = &aligned[ 0 ];
+        }
+
+        std::vector<uint8_t> blocks;
+        EncodeADPCM( samples, frames, int( channels ), ADPCM_SAMPLES_PER_BLOCK, ADPCM_ENCODE_BEST, blocks, encodeThreads );
+
+        size_t blockAlign = ADPCMBlockAlign( int( channels ), ADPCM_SAMPLES_PER_BLOCK );
+        uint32_t sampleRate = wave.SampleRate();
+
+        std::vector<uint8_t> converted( ADPCM_FORMAT_BYTES + blocks.size() );
+        uint8_t* adpcm = &converted[ 0 ];
+        WriteU16( adpcm + FMT_TAG, TAG_ADPCM );
+        WriteU16( adpcm + FMT_CHANNELS, channels );
+        WriteU32( adpcm + FMT_SAMPLE_RATE, sampleRate );
+        WriteU32( adpcm + FMT_AVG_BYTES, uint32_t( blockAlign * sampleRate / ADPCM_SAMPLES_PER_BLOCK ) );
+        WriteU16( adpcm + FMT_BLOCK_ALIGN, uint32_t( blockAlign ) );
+        WriteU16( adpcm + FMT_BITS, 4 /*MSADPCM_BITS_PER_SAMPLE*/ );
+        WriteU16( adpcm + FMT_CBSIZE, ADPCM_EXTRA_BYTES );
+        WriteU16( adpcm + ADPCM_SAMPLES_PER_BLOCK_FIELD, ADPCM_SAMPLES_PER_BLOCK );
+        WriteU16( adpcm + ADPCM_NUM_COEF, ADPCMCoefficientCount );
+        for( int j = 0; j < ADPCMCoefficientCount; ++j )
+        {
+            WriteU16( adpcm + ADPCM_COEF + j * 4, uint16_t( ADPCMCoefficients1[j] ) );
+            WriteU16( adpcm + ADPCM_COEF + j * 4 + 2, uint16_t( ADPCMCoefficients2[j] ) );
+        }
+
+        if ( !blocks.empty() )
+            memcpy( adpcm + ADPCM_FORMAT_BYTES, &blocks[0], blocks.size() );
+
+        wave.converted.swap( converted );
+        wave.format = &wave.converted[ 0 ];
+        wave.formatBytes = uint32_t( ADPCM_FORMAT_BYTES );
+        wave.startAudio = wave.format + ADPCM_FORMAT_BYTES;
+        wave.audioBytes = uint32_t( blocks.size() );
+
+        Log( log, " -> %s", GetFormatTagName( TAG_ADPCM ) );
+    }
+
+    uint32_t SeekEntry( const LoadedWave& wave, uint32_t index )
+    {
+        return ReadU32( wave.seek + index * sizeof(uint32_t) );
+    }
+
+    uint64_t Duration( const LoadedWave& wave )
+    {
+        switch( wave.miniFmt.wFormatTag )
+        {
+        case MINIWAVEFORMAT::TAG_XMA:
+            return ReadU32( wave.format + XMA2_SAMPLES_ENCODED );
+
+        case MINIWAVEFORMAT::TAG_ADPCM:
+            {
+                uint32_t blockAlign = wave.BlockAlign();
+                uint32_t channels = wave.Channels();
+                uint64_t duration = uint64_t( wave.audioBytes / blockAlign ) * ReadU16( wave.format + ADPCM_SAMPLES_PER_BLOCK_FIELD );
+                uint32_t partial = wave.audioBytes % blockAlign;
+                if ( partial )
+                {
+                    if ( partial >= ( 7 * channels ) )
+                        duration += ( partial * 2 / channels - 12 );
+                }
+                return duration;
+            }
+
+        case MINIWAVEFORMAT::TAG_WMA:
+            if ( wave.seekCount > 0 )
+                return SeekEntry( wave, wave.seekCount - 1 ) / uint32_t( 2 * wave.Channels() );
+            return 0;
+
+        default: // MINIWAVEFORMAT::TAG_PCM
+            return ( uint64_t( wave.audioBytes ) * 8 ) / uint64_t( wave.BitsPerSample() * wave.Channels() );
+        }
+    }
+
+    bool HasSeekTable( const LoadedWave& wave )
+    {
+        return wave.seekCount > 0
+               && ( wave.miniFmt.wFormatTag == MINIWAVEFORMAT::TAG_WMA || wave.miniFmt.wFormatTag == MINIWAVEFORMAT::TAG_XMA );
+    }
+}
+
+
+//======================================================================================
+// WaveBankBuilder
+//======================================================================================
+
+// Internal object implementation class.
+class WaveBankBuilder::Impl
+{
+public:
+    explicit Impl( unsigned int threadCount ) :
+        mThreadCount( threadCount ),
+        mFlags( WaveBankBuild_Default ),
+        mAlignment( ALIGNMENT_MIN ),
+        mCompact( false ),
+        mSharedCount( 0 ),
+        mWaveBytes( 0 ),
+        mBankBytes( 0 )
+    {
+        mCompactFormat.dwValue = 0;
+        memset( &mHeader, 0, sizeof(mHeader) );
+    }
+
+    void LoadOne( size_t index, const BuildCache& cache, unsigned int encodeThreads );
+    bool Restore( const CACHERECORD& record, LoadedWave& wave, WaveBankSource& source ) const;
+
+    unsigned int                    mThreadCount;
+    WAVEBANK_BUILD_FLAGS            mFlags;
+    std::vector<WaveBankSource>     mSources;
+    std::vector<LoadedWave>         mWaves;
+
+    // Layout
+    uint32_t                        mAlignment;
+    bool                            mCompact;
+    MINIWAVEFORMAT                  mCompactFormat;
+    size_t                          mSharedCount;
+    std::vector<uint8_t>            mEntries;
+    std::vector<uint32_t>           mSeekTables;
+    std::vector<char>               mEntryNames;
+    HEADER                          mHeader;
+    uint64_t                        mWaveBytes;
+    uint64_t                        mBankBytes;
+};
+
+
+void WaveBankBuilder::Impl::LoadOne( size_t index, const BuildCache& cache, unsigned int encodeThreads )
+{
+    WaveBankSource& source = mSources[ index ];
+    LoadedWave& wave = mWaves[ index ];
+
+    wave.file = MappedFile::Open( source.fileName.c_str() );
+    if ( !wave.file )
+    {
+        Log( source.log, "\nERROR: Failed to load file (%s)", GetParseResultName( WAV_PARSE_OPEN_FAILED ) );
+        source.failed = true;
+        return;
+    }
+
+    const uint8_t* data = wave.file->GetData();
+    size_t size = wave.file->GetSize();
+    wave.contentHash = HashBytes( data, size );
+
+    uint32_t cacheFlags = ( mFlags & WaveBankBuild_ADPCM ) ? CACHE_ADPCM : 0;
+    const CACHERECORD* record = cache.Find( wave.contentHash, size, cacheFlags );
+    if ( record && Restore( *record, wave, source ) )
+    {
+        source.cached = true;
+        return;
+    }
+
+    WAVFileView view;
+    WAV_PARSE_RESULT result = ParseWAV( data, size, view );
+    if ( result != WAV_PARSE_OK )
+    {
+        Log( source.log, "\nERROR: Failed to load file (%s)", GetParseResultName( result ) );
+        source.failed = true;
+        return;
+    }
+
+    wave.format = view.format;
+    wave.formatBytes = view.formatBytes;
+    wave.startAudio = view.startAudio;
+    wave.audioBytes = view.audioBytes;
+    wave.loopStart = view.loopStart;
+    wave.loopLength = view.loopLength;
+    wave.seek = reinterpret_cast<const uint8_t*>( view.seek );
+    wave.seekCount = view.seekCount;
+
+    Log( source.log, " (%s %u channels, %u-bit, %u Hz)", GetFormatTagName( wave.Tag() ), wave.Channels(), wave.BitsPerSample(), wave.SampleRate() );
+
+    if ( mFlags & WaveBankBuild_ADPCM )
+        ConvertToADPCM( wave, encodeThreads, source.log );
+
+    if ( !ConvertToMiniFormat( wave.format, wave.formatBytes, wave.seekCount != 0, wave.miniFmt, source.log ) )
+    {
+        Log( source.log, "\nFailed encoding" );
+        source.failed = true;
+        return;
+    }
+
+    wave.audioHash = HashBytes( wave.startAudio, wave.audioBytes );
+}
+
+
+bool WaveBankBuilder::Impl::Restore( const CACHERECORD& record, LoadedWave& wave, WaveBankSource& source ) const
+{
+    uint64_t size = wave.file->GetSize();
+    auto payload = reinterpret_cast<const uint8_t*>( &record + 1 );
+
+    if ( !InRange( record.seekOffset, uint64_t( record.seekCount ) * sizeof(uint32_t), size ) )
+        return false;
+
+    if ( record.flags & CACHE_CONVERTED )
+    {
+        if ( record.formatBytes < WAVEFORMATEX_BYTES )
+            return false;
+
+        const uint8_t* converted = payload + record.logBytes;
+        wave.converted.assign( converted, converted + record.formatBytes + record.audioBytes );
+        wave.format = &wave.converted[ 0 ];
+        wave.startAudio = wave.format + record.formatBytes;
+    }
+    else
+    {
+        if ( record.formatBytes < 16 /*PCMWAVEFORMAT*/
+             || !InRange( record.formatOffset, record.formatBytes, size )
+             || !InRange( record.audioOffset, record.audioBytes, size ) )
+            return false;
+
+        wave.format = wave.file->GetData() + record.formatOffset;
+        wave.startAudio = wave.file->GetData() + record.audioOffset;
+    }
+
+    wave.formatBytes = record.formatBytes;
+    wave.audioBytes = record.audioBytes;
+    wave.seek = record.seekCount ? wave.file->GetData() + record.seekOffset : nullptr;
+    wave.seekCount = record.seekCount;
+    wave.loopStart = record.loopStart;
+    wave.loopLength = record.loopLength;
+    wave.miniFmt.dwValue = record.miniFormat;
+    wave.audioHash = record.audioHash;
+
+    source.log.assign( reinterpret_cast<const char*>( payload ), record.logBytes );
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// WaveBankBuilder
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+WaveBankBuilder::WaveBankBuilder( unsigned int threadCount ) :
+    pImpl( new Impl( threadCount ) )
+{
+}
+
+
+// Move constructor.
+WaveBankBuilder::WaveBankBuilder(WaveBankBuilder&& moveFrom)
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+WaveBankBuilder& WaveBankBuilder::operator= (WaveBankBuilder&& moveFrom)
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+WaveBankBuilder::~WaveBankBuilder()
+{
+}
+
+
+// Public methods.
+void WaveBankBuilder::AddFile( const MappedFileChar* fileName, const char* entryName )
+{
+    WaveBankSource source;
+    source.fileName = fileName ? fileName : std::basic_string<MappedFileChar>();
+    source.entryName = entryName ? entryName : "";
+    if ( source.entryName.size() >= WaveBankEntryNameLength )
+        source.entryName.resize( WaveBankEntryNameLength - 1 );
+    source.failed = false;
+    source.cached = false;
+    source.sharedWith = uint32_t(-1);
+
+    pImpl->mSources.push_back( source );
+}
+
+
+bool WaveBankBuilder::Load( WAVEBANK_BUILD_FLAGS flags, const MappedFileChar* cacheFileName )
+{
+    pImpl->mFlags = flags;
+
+    size_t count = pImpl->mSources.size();
+    for( auto it = pImpl->mSources.begin(); it != pImpl->mSources.end(); ++it )
+    {
+        it->log.clear();
+        it->failed = false;
+        it->cached = false;
+        it->sharedWith = uint32_t(-1);
+    }
+
+    pImpl->mWaves.clear();
+    pImpl->mWaves.resize( count );
+
+    BuildCache cache;
+    if ( cacheFileName )
+        cache.Open( cacheFileName );
+
+    // A lone file gets every thread for its compression; otherwise each file is
+    // compressed on the thread that loaded it.
+    unsigned int poolSize = PoolSize( pImpl->mThreadCount, count );
+    unsigned int encodeThreads = ( poolSize > 1 ) ? 1 : pImpl->mThreadCount;
+
+    Impl* impl = pImpl.get();
+    ForEachIndex( count, poolSize, [&]( size_t index )
+    {
+        try
+        {
+            impl->LoadOne( index, cache, encodeThreads );
+        }
+        catch( const std::exception& e )
+        {
+            Log( impl->mSources[ index ].log, "\nERROR: %s", e.what() );
+            impl->mSources[ index ].failed = true;
+        }
+    });
+
+    // The cache mapping goes, so SaveCache can replace the file.
+    cache.Close();
+
+    bool loaded = true;
+    for( auto it = pImpl->mSources.begin(); it != pImpl->mSources.end(); ++it )
+    {
+        if ( it->failed )
+            loaded = false;
+    }
+    return loaded;
+}
+
+
+bool WaveBankBuilder::Layout( std::string& log )
+{
+    auto& sources = pImpl->mSources;
+    auto& waves = pImpl->mWaves;
+    size_t count = waves.size();
+
+    if ( !count || count != sources.size() )
+    {
+        Log( log, "ERROR: Need at least 1 wave file to build wave bank\n" );
+        return false;
+    }
+
+    bool xma = false;
+    for( auto it = waves.begin(); it != waves.end(); ++it )
+    {
+        if ( it->miniFmt.wFormatTag == MINIWAVEFORMAT::TAG_XMA )
+            xma = true;
+    }
+
+    uint32_t dwAlignment = ALIGNMENT_MIN;
+    if ( pImpl->mFlags & WaveBankBuild_Streaming )
+        dwAlignment = ALIGNMENT_DVD;
+    else if ( xma )
+        dwAlignment = 2048;
+
+    // Entries with byte-identical wave data play the first copy of it. The hash
+    // only finds candidates; the bytes decide.
+    std::unordered_map<uint64_t, uint32_t> firstByHash;
+    firstByHash.reserve( count );
+
+    size_t sharedCount = 0;
+    for( size_t j = 0; j < count; ++j )
+    {
+        const LoadedWave& wave = waves[ j ];
+        sources[ j ].sharedWith = uint32_t(-1);
+
+        uint64_t key = wave.audioHash ^ ( uint64_t( wave.audioBytes ) << 32 );
+        auto it = firstByHash.find( key );
+        if ( it == firstByHash.end() )
+        {
+            firstByHash[ key ] = uint32_t( j );
+            continue;
+        }
+
+        const LoadedWave& first = waves[ it->second ];
+        if ( first.audioBytes == wave.audioBytes
+             && ( !wave.audioBytes || memcmp( first.startAudio, wave.startAudio, wave.audioBytes ) == 0 ) )
+        {
+            sources[ j ].sharedWith = it->second;
+            ++sharedCount;
+        }
+    }
+
+    // Check to see if we can use the compact wave bank format
+    bool compact = ( pImpl->mFlags & WaveBankBuild_NoCompact ) ? false : true;
+    int reason = 0;
+    uint64_t waveOffset = 0;
+
+    MINIWAVEFORMAT compactFormat;
+    compactFormat.dwValue = 0;
+
+    for( size_t j = 0; j < count; ++j )
+    {
+        LoadedWave& wave = waves[ j ];
+
+        if ( !j )
+        {
+            compactFormat.dwValue = wave.miniFmt.dwValue;
+        }
+        else if ( compactFormat.dwValue != wave.miniFmt.dwValue )
+        {
+            compact = false;
+            reason |= 0x1;
+        }
+
+        if ( wave.loopLength > 0 )
+        {
+            compact = false;
+            reason |= 0x2;
+        }
+
+        uint32_t shared = sources[ j ].sharedWith;
+        if ( shared != uint32_t(-1) )
+        {
+            wave.offset = waves[ shared ].offset;
+            continue;
+        }
+
+        if ( waveOffset > 0xFFFFFFFF )
+            break;
+
+        wave.offset = uint32_t( waveOffset );
+        waveOffset += BLOCKALIGNPAD( uint64_t( wave.audioBytes ), dwAlignment );
+    }
+
+    if ( waveOffset > 0xFFFFFFFF )
+    {
+        Log( log, "ERROR: Audio wave data is too large to encode into wavebank (offset %llu)\n", static_cast<unsigned long long>( waveOffset ) );
+        return false;
+    }
+    else if ( waveOffset > ( MAX_COMPACT_DATA_SEGMENT_SIZE * dwAlignment ) )
+    {
+        compact = false;
+        reason |= 0x4;
+    }
+
+    if ( ( pImpl->mFlags & WaveBankBuild_Compact ) && !compact )
+    {
+        Log( log, "ERROR: Cannot create compact wave bank:\n" );
+        if ( reason & 0x1 )
+        {
+            Log( log, "- Mismatched formats. All formats must be identical for a compact wavebank.\n" );
+        }
+        if ( reason & 0x2 )
+        {
+            Log( log, "- Found loop points. Compact wavebanks do not support loop points.\n" );
+        }
+        if ( reason & 0x4 )
+        {
+            Log( log, "- Audio wave data is too large to encode in compact wavebank (%llu > %llu).\n",
+                 static_cast<unsigned long long>( waveOffset ), static_cast<unsigned long long>( MAX_COMPACT_DATA_SEGMENT_SIZE * dwAlignment ) );
+        }
+        return false;
+    }
+
+    // Build entry metadata, seek tables and friendly names
+    size_t elementSize = compact ? sizeof(ENTRYCOMPACT) : sizeof(ENTRY);
+    std::vector<uint8_t> entries( elementSize * count );
+
+    std::vector<char> entryNames;
+    if ( pImpl->mFlags & WaveBankBuild_EntryNames )
+        entryNames.resize( count * WaveBankEntryNameLength );
+
+    size_t seekEntries = 0;
+    for( size_t j = 0; j < count; ++j )
+    {
+        if ( HasSeekTable( waves[ j ] ) )
+            seekEntries += waves[ j ].seekCount + 1;
+    }
+
+    std::vector<uint32_t> seekTables;
+    if ( seekEntries > 0 )
+    {
+        seekEntries += count; // Room for an offset per entry
+        seekTables.resize( seekEntries );
+    }
+
+    uint32_t seekoffset = 0;
+    for( size_t j = 0; j < count; ++j )
+    {
+        const LoadedWave& wave = waves[ j ];
+        uint32_t alignedSize = uint32_t( BLOCKALIGNPAD( uint64_t( wave.audioBytes ), dwAlignment ) );
+
+        if ( compact )
+        {
+            auto entry = reinterpret_cast<ENTRYCOMPACT*>( &entries[ j * sizeof(ENTRYCOMPACT) ] );
+
+            assert( wave.offset <= ( MAX_COMPACT_DATA_SEGMENT_SIZE * dwAlignment ) );
+            entry->dwOffset = wave.offset / dwAlignment;
+
+            assert( dwAlignment <= 2048 );
+            entry->dwLengthDeviation = alignedSize - wave.audioBytes;
+        }
+        else
+        {
+            auto entry = reinterpret_cast<ENTRY*>( &entries[ j * sizeof(ENTRY) ] );
+
+            uint64_t duration = Duration( wave );
+            if ( duration > 268435455 )
+            {
+                Log( log, "ERROR: Duration of audio too long to encode into wavebank (%llu > 2^28))\n", static_cast<unsigned long long>( duration ) );
+                return false;
+            }
+
+            entry->Duration = uint32_t( duration );
+            entry->Format.dwValue = wave.miniFmt.dwValue;
+            entry->PlayRegion.dwOffset = wave.offset;
+            entry->PlayRegion.dwLength = wave.audioBytes;
+
+            if ( wave.loopLength > 0 )
+            {
+                entry->LoopRegion.dwStartSample = wave.loopStart;
+                entry->LoopRegion.dwTotalSamples = wave.loopLength;
+            }
+        }
+
+        if ( !seekTables.empty() )
+        {
+            if ( HasSeekTable( wave ) )
+            {
+                seekTables[ j ] = seekoffset * sizeof(uint32_t);
+
+                uint32_t baseoffset = uint32_t( count + seekoffset );
+                seekTables[ baseoffset ] = wave.seekCount;
+
+                // XMA2 seek tables are big-endian in the file
+                bool swap = ( wave.miniFmt.wFormatTag == MINIWAVEFORMAT::TAG_XMA );
+                for( uint32_t k = 0; k < wave.seekCount; ++k )
+                {
+                    uint32_t value = SeekEntry( wave, k );
+                    seekTables[ baseoffset + k + 1 ] = swap ? ByteSwap32( value ) : value;
+                }
+
+                seekoffset += wave.seekCount + 1;
+            }
+            else
+            {
+                seekTables[ j ] = uint32_t( -1 );
+            }
+        }
+
+        if ( !entryNames.empty() )
+        {
+            const std::string& name = sources[ j ].entryName;
+            memcpy( &entryNames[ j * WaveBankEntryNameLength ], name.c_str(), name.size() );
+        }
+    }
+
+    // Segments, in the order Write puts them out
+    HEADER header;
+    memset( &header, 0, sizeof(header) );
+    header.dwSignature = HEADER::SIGNATURE;
+    header.dwHeaderVersion = HEADER::VERSION;
+    header.dwVersion = XACT_CONTENT_VERSION;
+
+    uint64_t segmentOffset = sizeof(HEADER);
+
+    header.Segments[ HEADER::SEGIDX_BANKDATA ].dwOffset = uint32_t( segmentOffset );
+    header.Segments[ HEADER::SEGIDX_BANKDATA ].dwLength = sizeof(BANKDATA);
+    segmentOffset += sizeof(BANKDATA);
+
+    header.Segments[ HEADER::SEGIDX_ENTRYMETADATA ].dwOffset = uint32_t( segmentOffset );
+    header.Segments[ HEADER::SEGIDX_ENTRYMETADATA ].dwLength = uint32_t( entries.size() );
+    segmentOffset += entries.size();
+
+    header.Segments[ HEADER::SEGIDX_SEEKTABLES ].dwOffset = uint32_t( segmentOffset );
+    header.Segments[ HEADER::SEGIDX_SEEKTABLES ].dwLength = uint32_t( seekTables.size() * sizeof(uint32_t) );
+    segmentOffset += seekTables.size() * sizeof(uint32_t);
+
+    if ( !entryNames.empty() )
+    {
+        header.Segments[ HEADER::SEGIDX_ENTRYNAMES ].dwOffset = uint32_t( segmentOffset );
+        header.Segments[ HEADER::SEGIDX_ENTRYNAMES ].dwLength = uint32_t( entryNames.size() );
+        segmentOffset += entryNames.size();
+    }
+
+    segmentOffset = BLOCKALIGNPAD( segmentOffset, dwAlignment );
+
+    if ( ( segmentOffset + waveOffset ) > 0xFFFFFFFF )
+    {
+        Log( log, "ERROR: Data exceeds maximum size for wavebank\n" );
+        return false;
+    }
+
+    header.Segments[ HEADER::SEGIDX_ENTRYWAVEDATA ].dwOffset = uint32_t( segmentOffset );
+    header.Segments[ HEADER::SEGIDX_ENTRYWAVEDATA ].dwLength = uint32_t( waveOffset );
+
+    pImpl->mAlignment = dwAlignment;
+    pImpl->mCompact = compact;
+    pImpl->mCompactFormat = compactFormat;
+    pImpl->mSharedCount = sharedCount;
+    pImpl->mEntries.swap( entries );
+    pImpl->mSeekTables.swap( seekTables );
+    pImpl->mEntryNames.swap( entryNames );
+    pImpl->mHeader = header;
+    pImpl->mWaveBytes = waveOffset;
+    pImpl->mBankBytes = segmentOffset + waveOffset;
+    return true;
+}
+
+
+bool WaveBankBuilder::Write( const MappedFileChar* bankFileName, const char* bankName, std::string& log ) const
+{
+    const Impl& impl = *pImpl;
+    const HEADER& header = impl.mHeader;
+
+    if ( !impl.mBankBytes )
+    {
+        Log( log, "ERROR: Wave bank has not been laid out\n" );
+        return false;
+    }
+
+    BANKDATA data;
+    memset( &data, 0, sizeof(data) );
+
+    data.dwEntryCount = uint32_t( impl.mWaves.size() );
+    data.dwAlignment = impl.mAlignment;
+
+    // FILETIME counts 100ns intervals since 1601
+    uint64_t buildTime = ( uint64_t( time( nullptr ) ) + 11644473600ull ) * 10000000ull;
+    data.BuildTime[0] = uint32_t( buildTime );
+    data.BuildTime[1] = uint32_t( buildTime >> 32 );
+
+    data.dwFlags = ( impl.mFlags & WaveBankBuild_Streaming ) ? BANKDATA::TYPE_STREAMING : BANKDATA::TYPE_BUFFER;
+
+    data.dwFlags |= BANKDATA::FLAGS_SEEKTABLES;
+
+    if ( !impl.mEntryNames.empty() )
+    {
+        data.dwFlags |= BANKDATA::FLAGS_ENTRYNAMES;
+        data.dwEntryNameElementSize = uint32_t( WaveBankEntryNameLength );
+    }
+
+    if ( impl.mCompact )
+    {
+        data.dwFlags |= BANKDATA::FLAGS_COMPACT;
+        data.dwEntryMetaDataElementSize = sizeof(ENTRYCOMPACT);
+        data.CompactFormat = impl.mCompactFormat;
+    }
+    else
+    {
+        data.dwEntryMetaDataElementSize = sizeof(ENTRY);
+    }
+
+    if ( bankName )
+    {
+        size_t length = std::min( strlen( bankName ), BANKDATA::BANKNAME_LENGTH - 1 );
+        memcpy( data.szBankName, bankName, length );
+    }
+
+    SequentialWriter writer;
+    if ( !writer.Open( bankFileName ) )
+    {
+        Log( log, "ERROR: Failed opening output file\n" );
+        return false;
+    }
+
+    writer.Write( &header, sizeof(header) );
+    writer.Write( &data, sizeof(data) );
+
+    if ( !impl.mEntries.empty() )
+        writer.Write( &impl.mEntries[ 0 ], impl.mEntries.size() );
+
+    if ( !impl.mSeekTables.empty() )
+        writer.Write( &impl.mSeekTables[ 0 ], impl.mSeekTables.size() * sizeof(uint32_t) );
+
+    if ( !impl.mEntryNames.empty() )
+        writer.Write( &impl.mEntryNames[ 0 ], impl.mEntryNames.size() );
+
+    writer.Pad( impl.mAlignment );
+    assert( writer.GetPosition() == header.Segments[ HEADER::SEGIDX_ENTRYWAVEDATA ].dwOffset );
+
+    for( size_t j = 0; j < impl.mWaves.size(); ++j )
+    {
+        if ( impl.mSources[ j ].sharedWith != uint32_t(-1) )
+            continue;
+
+        const LoadedWave& wave = impl.mWaves[ j ];
+        assert( writer.GetPosition() == uint64_t( header.Segments[ HEADER::SEGIDX_ENTRYWAVEDATA ].dwOffset ) + wave.offset );
+
+        writer.Write( wave.startAudio, wave.audioBytes );
+        writer.Pad( impl.mAlignment );
+    }
+
+    assert( writer.GetPosition() == impl.mBankBytes );
+
+    if ( !writer.Close() )
+    {
+        Log( log, "ERROR: Failed writing wave bank\n" );
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WaveBankBuilder::SaveCache( const MappedFileChar* cacheFileName ) const
+{
+    const Impl& impl = *pImpl;
+
+    // Files with the same contents share a record.
+    std::unordered_map<uint64_t, size_t> saved;
+    std::vector<size_t> records;
+    for( size_t j = 0; j < impl.mWaves.size(); ++j )
+    {
+        if ( impl.mSources[ j ].failed || !impl.mWaves[ j ].file )
+            continue;
+
+        if ( saved.insert( std::make_pair( impl.mWaves[ j ].contentHash, j ) ).second )
+            records.push_back( j );
+    }
+
+    SequentialWriter writer;
+    if ( !writer.Open( cacheFileName ) )
+        return false;
+
+    CACHEHEADER header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.count = uint32_t( records.size() );
+    header.reserved = 0;
+    writer.Write( &header, sizeof(header) );
+
+    for( auto it = records.begin(); it != records.end(); ++it )
+    {
+        const WaveBankSource& source = impl.mSources[ *it ];
+        const LoadedWave& wave = impl.mWaves[ *it ];
+        bool converted = !wave.converted.empty();
+
+        CACHERECORD record;
+        memset( &record, 0, sizeof(record) );
+        record.contentHash = wave.contentHash;
+        record.fileSize = wave.file->GetSize();
+        record.audioHash = wave.audioHash;
+        record.flags = ( ( impl.mFlags & WaveBankBuild_ADPCM ) ? CACHE_ADPCM : 0 ) | ( converted ? CACHE_CONVERTED : 0 );
+        record.miniFormat = wave.miniFmt.dwValue;
+        record.formatOffset = wave.FileOffset( wave.format );
+        record.formatBytes = wave.formatBytes;
+        record.audioOffset = wave.FileOffset( wave.startAudio );
+        record.audioBytes = wave.audioBytes;
+        record.seekOffset = wave.seek ? uint32_t( wave.seek - wave.file->GetData() ) : 0;
+        record.seekCount = wave.seekCount;
+        record.loopStart = wave.loopStart;
+        record.loopLength = wave.loopLength;
+        record.logBytes = uint32_t( source.log.size() );
+
+        size_t payload = source.log.size() + ( converted ? wave.converted.size() : 0 );
+        record.payloadBytes = uint32_t( BLOCKALIGNPAD( payload, 8 ) );
+
+        uint64_t start = writer.GetPosition();
+        writer.Write( &record, sizeof(record) );
+        writer.Write( source.log.c_str(), source.log.size() );
+        if ( converted )
+            writer.Write( &wave.converted[ 0 ], wave.converted.size() );
+        writer.Pad( 8 );
+
+        assert( writer.GetPosition() == start + sizeof(record) + record.payloadBytes );
+        (void)start;
+    }
+
+    return writer.Close();
+}
+
+
+size_t WaveBankBuilder::GetSourceCount() const
+{
+    return pImpl->mSources.size();
+}
+
+
+const WaveBankSource& WaveBankBuilder::GetSource( size_t index ) const
+{
+    return pImpl->mSources[ index ];
+}
+
+
+bool WaveBankBuilder::IsCompact() const
+{
+    return pImpl->mCompact;
+}
+
+
+size_t WaveBankBuilder::GetSharedCount() const
+{
+    return pImpl->mSharedCount;
+}
+
+
+const char* WaveBankBuilder::GetEntryNames() const
+{
+    return pImpl->mEntryNames.empty() ? nullptr : &pImpl->mEntryNames[ 0 ];
+}
+
+
+uint64_t WaveBankBuilder::GetBankBytes() const
+{
+    return pImpl->mBankBytes;
+}
+
+
+//--------------------------------------------------------------------------------------
+std::basic_string<MappedFileChar> DirectX::GetBuildCacheFileName( const MappedFileChar* bankFileName )
+{
+    std::basic_string<MappedFileChar> fileName;
+    if ( bankFileName )
+        fileName = bankFileName;
+
+    // Only a dot after the last path separator starts an extension.
+    for( size_t j = fileName.size(); j > 0; --j )
+    {
+        MappedFileChar c = fileName[ j - 1 ];
+        if ( c == '\\' || c == '/' )
+            break;
+
+        if ( c == '.' )
+        {
+            fileName.erase( j - 1 );
+            break;
+        }
+    }
+
+    const MappedFileChar extension[] = { '.', 'x', 'w', 'c', 0 };
+    fileName += extension;
+    return fileName;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+    std::basic_string<MappedFileChar> BenchmarkFileName( const MappedFileChar* directory, const char* name )
+    {
+        std::basic_string<MappedFileChar> fileName( directory );
+        if ( !fileName.empty() && fileName[ fileName.size() - 1 ] != '/' && fileName[ fileName.size() - 1 ] != '\\' )
+            fileName += MappedFileChar( '/' );
+
+        for( const char* c = name; *c; ++c )
+        {
+            fileName += MappedFileChar( *c );
+        }
+        return fileName;
+    }
+
+    // A 16-bit PCM .WAV of a decaying tone, a tenth to half a second long.
+    bool WriteBenchmarkWAV( const MappedFileChar* fileName, uint32_t seed )
+    {
+        const uint32_t sampleRate = 44100;
+        uint32_t channels = 1 + ( seed & 1 );
+        uint32_t frames = sampleRate / 10 + ( seed * 7919u ) % ( sampleRate * 2 / 5 );
+        uint32_t audioBytes = frames * channels * 2;
+
+        std::vector<uint8_t> file( 44 + audioBytes );
+        uint8_t* p = &file[ 0 ];
+        memcpy( p, "RIFF", 4 );
+        WriteU32( p + 4, uint32_t( 36 + audioBytes ) );
+        memcpy( p + 8, "WAVEfmt ", 8 );
+        WriteU32( p + 16, 16 );
+        WriteU16( p + 20 + FMT_TAG, TAG_PCM );
+        WriteU16( p + 20 + FMT_CHANNELS, channels );
+        WriteU32( p + 20 + FMT_SAMPLE_RATE, sampleRate );
+        WriteU32( p + 20 + FMT_AVG_BYTES, sampleRate * channels * 2 );
+        WriteU16( p + 20 + FMT_BLOCK_ALIGN, channels * 2 );
+        WriteU16( p + 20 + FMT_BITS, 16 );
+        memcpy( p + 36, "data", 4 );
+        WriteU32( p + 40, audioBytes );
+
+        double frequency = 110.0 + double( seed % 880 );
+        for( uint32_t j = 0; j < frames; ++j )
+        {
+            double t = double( j ) / double( sampleRate );
+            double value = sin( 6.283185307179586 * frequency * t ) * exp( -4.0 * t );
+            for( uint32_t c = 0; c < channels; ++c )
+            {
+                WriteU16( p + 44 + ( j * channels + c ) * 2, uint16_t( int16_t( value * ( 16000.0 - 4000.0 * c ) ) ) );
+            }
+        }
+
+        FILE* out = OpenForWrite( fileName );
+        if ( !out )
+            return false;
+
+        bool written = fwrite( p, 1, file.size(), out ) == file.size();
+        return ( fclose( out ) == 0 ) && written;
+    }
+
+    // Returns the seconds taken, or a negative number if the build failed.
+    double TimeBuild( const std::vector<std::basic_string<MappedFileChar>>& files, WAVEBANK_BUILD_FLAGS flags, unsigned int threadCount,
+                      const MappedFileChar* bankFileName, const MappedFileChar* cacheFileName, WaveBankBuilder& builder )
+    {
+        double start = SteadyClock();
+
+        builder = WaveBankBuilder( threadCount );
+        for( size_t j = 0; j < files.size(); ++j )
+        {
+            builder.AddFile( files[ j ].c_str(), "" );
+        }
+
+        std::string log;
+        if ( !builder.Load( flags, cacheFileName )
+             || !builder.Layout( log )
+             || !builder.Write( bankFileName, "benchmark", log ) )
+            return -1.0;
+
+        if ( cacheFileName && !builder.SaveCache( cacheFileName ) )
+            return -1.0;
+
+        return SteadyClock() - start;
+    }
+}
+
+WaveBankBuildBenchmark DirectX::BenchmarkWaveBankBuild( const MappedFileChar* directory, size_t fileCount,
+                                                        WAVEBANK_BUILD_FLAGS flags, unsigned int threadCount )
+{
+    WaveBankBuildBenchmark result;
+    memset( &result, 0, sizeof(result) );
+
+    if ( !directory || !fileCount )
+        return result;
+
+    result.fileCount = fileCount;
+    result.threadCount = PoolSize( threadCount, fileCount );
+
+    // Every sixteenth file repeats the one before it, as a bank of many similar
+    // sounds tends to.
+    std::vector<std::basic_string<MappedFileChar>> files( fileCount );
+    double start = SteadyClock();
+    for( size_t j = 0; j < fileCount; ++j )
+    {
+        std::string name;
+        Log( name, "wave%06u.wav", unsigned( j ) );
+        files[ j ] = BenchmarkFileName( directory, name.c_str() );
+
+        uint32_t seed = uint32_t( ( j % 16 == 15 ) ? j - 1 : j );
+        if ( !WriteBenchmarkWAV( files[ j ].c_str(), seed ) )
+            return result;
+    }
+    result.generateSeconds = SteadyClock() - start;
+
+    auto bankFileName = BenchmarkFileName( directory, "benchmark.xwb" );
+    auto cacheFileName = GetBuildCacheFileName( bankFileName.c_str() );
+    RemoveFile( cacheFileName.c_str() );
+
+    WaveBankBuilder builder;
+    result.serialSeconds = TimeBuild( files, flags, 1, bankFileName.c_str(), nullptr, builder );
+    result.parallelSeconds = TimeBuild( files, flags, threadCount, bankFileName.c_str(), nullptr, builder );
+    result.coldCacheSeconds = TimeBuild( files, flags, threadCount, bankFileName.c_str(), cacheFileName.c_str(), builder );
+
+    if ( WriteBenchmarkWAV( files[ 0 ].c_str(), 0x5EED ) )
+        result.warmCacheSeconds = TimeBuild( files, flags, threadCount, bankFileName.c_str(), cacheFileName.c_str(), builder );
+
+    result.sharedCount = builder.GetSharedCount();
+    result.bankBytes = builder.GetBankBytes();
+
+    builder = WaveBankBuilder();
+    for( auto it = files.begin(); it != files.end(); ++it )
+    {
+        RemoveFile( it->c_str() );
+    }
+    RemoveFile( bankFileName.c_str() );
+    RemoveFile( cacheFileName.c_str() );
+
+    return result;
+}
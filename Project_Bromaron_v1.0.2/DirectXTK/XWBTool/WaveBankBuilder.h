@@ -0,0 +1,130 @@
+//--------------------------------------------------------------------------------------
+// File: WaveBankBuilder.h
+//
+// Loads, validates and lays out .WAV files for xwbtool on a pool of threads, and
+// writes them as an XACT-style wave bank
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "MappedFile.h"
+
+
+namespace DirectX
+{
+    // Each file is mapped and parsed in place rather than copied into memory. A
+    // cache file remembers what loading found for each file, keyed by a hash of
+    // its contents, so a rebuild skips validation and, above all, ADPCM
+    // compression of every file that hasn't changed. Entries with byte-identical
+    // wave data share one copy of it in the bank.
+
+    enum WAVEBANK_BUILD_FLAGS
+    {
+        WaveBankBuild_Default       = 0x0,
+        WaveBankBuild_Streaming     = 0x1,      // Otherwise an in-memory bank
+        WaveBankBuild_Compact       = 0x2,      // Fail unless the bank can be compact
+        WaveBankBuild_NoCompact     = 0x4,
+        WaveBankBuild_EntryNames    = 0x8,
+        WaveBankBuild_ADPCM         = 0x10,     // Compress 16-bit PCM waves as MS ADPCM
+    };
+
+    inline WAVEBANK_BUILD_FLAGS operator|(WAVEBANK_BUILD_FLAGS a, WAVEBANK_BUILD_FLAGS b) { return static_cast<WAVEBANK_BUILD_FLAGS>( static_cast<int>(a) | static_cast<int>(b) ); }
+
+    struct WaveBankSource
+    {
+        std::basic_string<MappedFileChar>   fileName;
+        std::string                         entryName;  // At most 63 characters are kept
+        std::string                         log;        // As xwbtool prints it after the file name
+        bool                                failed;
+        bool                                cached;     // Taken from the cache rather than parsed
+        uint32_t                            sharedWith; // Entry whose wave data this one plays, or uint32_t(-1)
+    };
+
+    class WaveBankBuilder
+    {
+    public:
+        // threadCount of 0 starts one per hardware thread.
+        explicit WaveBankBuilder( unsigned int threadCount = 0 );
+
+        WaveBankBuilder(WaveBankBuilder&& moveFrom);
+        WaveBankBuilder& operator= (WaveBankBuilder&& moveFrom);
+
+        virtual ~WaveBankBuilder();
+
+        // Entries are numbered in the order they are added.
+        void AddFile( const MappedFileChar* fileName, const char* entryName );
+
+        // Loads every file, taking what cacheFileName (if not nullptr) holds for any
+        // file whose contents are unchanged. Returns false if any file failed; its
+        // log says why.
+        bool Load( WAVEBANK_BUILD_FLAGS flags, const MappedFileChar* cacheFileName = nullptr );
+
+        // Finds shared wave data, picks the bank format and assigns offsets.
+        // Returns false, with the reasons in log, if the waves won't fit a bank.
+        bool Layout( std::string& log );
+
+        // Writes the laid out bank in one sequential pass.
+        bool Write( const MappedFileChar* bankFileName, const char* bankName, std::string& log ) const;
+
+        // Records every file loaded, replacing the cache's previous contents.
+        bool SaveCache( const MappedFileChar* cacheFileName ) const;
+
+        size_t GetSourceCount() const;
+        const WaveBankSource& GetSource( size_t index ) const;
+
+        // After Layout.
+        bool IsCompact() const;
+        size_t GetSharedCount() const;
+        const char* GetEntryNames() const;     // GetSourceCount() slots of WaveBankEntryNameLength
+        uint64_t GetBankBytes() const;
+
+    private:
+        // Private implementation.
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+
+        // Prevent copying.
+        WaveBankBuilder(WaveBankBuilder const&);
+        WaveBankBuilder& operator= (WaveBankBuilder const&);
+    };
+
+    const size_t WaveBankEntryNameLength = 64;
+
+    // The cache for a bank: its file name with the extension changed to .xwc.
+    std::basic_string<MappedFileChar> GetBuildCacheFileName( const MappedFileChar* bankFileName );
+
+
+    struct WaveBankBuildBenchmark
+    {
+        size_t          fileCount;
+        size_t          sharedCount;            // Entries whose data duplicates another's
+        uint64_t        bankBytes;
+        unsigned int    threadCount;
+        double          generateSeconds;        // Writing the corpus
+        double          serialSeconds;          // One thread, no cache
+        double          parallelSeconds;        // threadCount threads, no cache
+        double          coldCacheSeconds;       // threadCount threads, filling an empty cache
+        double          warmCacheSeconds;       // Rebuilding with one file changed
+    };
+
+    // Writes fileCount generated .WAV files, one in every sixteen a copy of
+    // another, to directory (which must exist) and builds a bank from them each
+    // way. The files stay in the OS cache after they are written, so this
+    // measures the tool rather than the disk.
+    WaveBankBuildBenchmark BenchmarkWaveBankBuild( const MappedFileChar* directory, size_t fileCount,
+                                                   WAVEBANK_BUILD_FLAGS flags, unsigned int threadCount = 0 );
+}
@@ -0,0 +1,277 @@
+//--------------------------------------------------------------------------------------
+// File: ADPCMCodecTests.cpp
+//
+// Decoded output is compared bit for bit against a plain reference decoder,
+// written from the format description rather than from ADPCMCodec.cpp.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "ADPCMCodec.h"
+
+using namespace DirectX;
+
+namespace
+{
+    const int AdaptationTable[16] = { 230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230 };
+    const int Coefficient1[7] = { 256, 512, 0, 192, 240, 460, 392 };
+    const int Coefficient2[7] = { 0, -256, 0, 64, 0, -208, -232 };
+
+    int ReadShort( const uint8_t* p )
+    {
+        return static_cast<int16_t>( p[0] | ( p[1] << 8 ) );
+    }
+
+    bool ReferenceDecode( const uint8_t* block, int channels, int samplesPerBlock, int16_t* output )
+    {
+        int predictor[2];
+        int delta[2];
+        int sample1[2];
+        int sample2[2];
+
+        const uint8_t* p = block;
+        for ( int c = 0; c < channels; c++ )
+        {
+            predictor[c] = *p++;
+            if ( predictor[c] > 6 )
+            {
+                return false;
+            }
+        }
+
+        for ( int c = 0; c < channels; c++, p += 2 )    delta[c] = ReadShort( p );
+        for ( int c = 0; c < channels; c++, p += 2 )    sample1[c] = ReadShort( p );
+        for ( int c = 0; c < channels; c++, p += 2 )    sample2[c] = ReadShort( p );
+
+        int o = 0;
+        for ( int c = 0; c < channels; c++ )    output[o++] = static_cast<int16_t>( sample2[c] );
+        for ( int c = 0; c < channels; c++ )    output[o++] = static_cast<int16_t>( sample1[c] );
+
+        int total = ( samplesPerBlock - 2 ) * channels;
+        for ( int i = 0; i < total; i++ )
+        {
+            int nibble = ( ( i % 2 ) == 0 ) ? ( p[i / 2] >> 4 ) : ( p[i / 2] & 15 );
+            int c = ( channels == 2 ) ? ( i % 2 ) : 0;
+            int signedNibble = ( nibble >= 8 ) ? nibble - 16 : nibble;
+
+            long long prediction = ( static_cast<long long>( sample1[c] ) * Coefficient1[predictor[c]]
+                                   + static_cast<long long>( sample2[c] ) * Coefficient2[predictor[c]] ) / 256;
+            long long value = prediction + static_cast<long long>( signedNibble ) * delta[c];
+            value = std::min( 32767LL, std::max( -32768LL, value ) );
+
+            output[o++] = static_cast<int16_t>( value );
+            sample2[c] = sample1[c];
+            sample1[c] = static_cast<int>( value );
+
+            long long nextDelta = static_cast<long long>( AdaptationTable[nibble] ) * delta[c] / 256;
+            delta[c] = static_cast<int>( std::min( static_cast<long long>( INT32_MAX / 768 ), std::max( 16LL, nextDelta ) ) );
+        }
+
+        return true;
+    }
+
+    // A sine per channel with some noise, and a run of full-scale square wave to
+    // make the encoder clamp.
+    std::vector<int16_t> MakeTestSignal( std::mt19937& random, size_t frameCount, int channels )
+    {
+        std::vector<int16_t> samples( frameCount * channels );
+        for ( size_t i = 0; i < frameCount; i++ )
+        {
+            for ( int c = 0; c < channels; c++ )
+            {
+                int noise = static_cast<int>( random() % 200 ) - 100;
+                samples[i * channels + c] = static_cast<int16_t>( 12000 * sin( i * 0.05 * ( c + 1 ) ) + noise );
+            }
+        }
+
+        for ( size_t i = 1000; i < 1200 && i < frameCount; i++ )
+        {
+            for ( int c = 0; c < channels; c++ )
+            {
+                samples[i * channels + c] = ( ( i / 10 ) % 2 ) ? 32767 : -32768;
+            }
+        }
+
+        return samples;
+    }
+}
+
+TEST( ADPCMCodec_BlockAlign )
+{
+    CHECK( ADPCMBlockAlign( 1, 4 ) == 8 );
+    CHECK( ADPCMBlockAlign( 1, 512 ) == 256 + 6 );
+    CHECK( ADPCMBlockAlign( 2, 512 ) == 512 + 12 );
+    CHECK( ADPCMBlockAlign( 2, 5 ) == 14 + 3 );
+
+    // Mono needs an even number of samples; only mono and stereo.
+    CHECK( ADPCMBlockAlign( 1, 5 ) == 0 );
+    CHECK( ADPCMBlockAlign( 3, 8 ) == 0 );
+    CHECK( ADPCMBlockAlign( 1, 2 ) == 0 );
+    CHECK( ADPCMBlockAlign( 1, ADPCMMaxSamplesPerBlock + 2 ) == 0 );
+}
+
+// A block worked out by hand.
+TEST( ADPCMCodec_DecodesKnownBlock )
+{
+    uint8_t block[8] = { 0, 16, 0, 100, 0, 50, 0, 0x1F };
+    int16_t output[4];
+    CHECK( DecodeADPCMBlock( block, 1, 4, output ) );
+    CHECK( output[0] == 50 && output[1] == 100 && output[2] == 116 && output[3] == 100 );
+
+    // There are only seven coefficient sets.
+    block[0] = 7;
+    CHECK( !DecodeADPCMBlock( block, 1, 4, output ) );
+}
+
+// Random blocks at many sizes, decoded on several threads, match the reference;
+// one bad block anywhere fails the whole decode.
+TEST( ADPCMCodec_MatchesReferenceDecoder )
+{
+    const int blockSizes[] = { 4, 6, 32, 34, 512, 1000, 2050, 4097, 64000 };
+    std::mt19937 random( 7 );
+
+    for ( int channels = 1; channels <= 2; channels++ )
+    {
+        for ( unsigned int s = 0; s < ARRAYSIZE( blockSizes ); s++ )
+        {
+            int samplesPerBlock = blockSizes[s];
+            size_t blockAlign = ADPCMBlockAlign( channels, samplesPerBlock );
+            if ( blockAlign == 0 )
+            {
+                continue;
+            }
+
+            int blockCount = ( samplesPerBlock == 64000 ) ? 3 : 600;
+            std::vector<uint8_t> blocks( blockAlign * blockCount );
+            for ( size_t i = 0; i < blocks.size(); i++ )
+            {
+                blocks[i] = static_cast<uint8_t>( random() );
+            }
+
+            for ( int b = 0; b < blockCount; b++ )
+            {
+                for ( int c = 0; c < channels; c++ )
+                {
+                    blocks[b * blockAlign + c] %= 7;
+                }
+            }
+
+            std::vector<int16_t> decoded( size_t( samplesPerBlock ) * channels * blockCount );
+            std::vector<int16_t> expected( decoded.size() );
+            CHECK( DecodeADPCM( &blocks[0], blockCount, channels, samplesPerBlock, &decoded[0], 4 ) );
+            for ( int b = 0; b < blockCount; b++ )
+            {
+                ReferenceDecode( &blocks[b * blockAlign], channels, samplesPerBlock, &expected[size_t( b ) * samplesPerBlock * channels] );
+            }
+
+            CHECK( decoded == expected );
+
+            blocks[blockAlign * ( blockCount - 1 ) + channels - 1] = 9;
+            CHECK( !DecodeADPCM( &blocks[0], blockCount, channels, samplesPerBlock, &decoded[0], 3 ) );
+        }
+    }
+}
+
+// Encoding gives the same blocks on any number of threads, they decode as the
+// reference decodes them, and the decoded signal stays close to the source.
+TEST( ADPCMCodec_EncodeRoundTrip )
+{
+    const size_t frameCount = 44100 + 123;
+    const int samplesPerBlock = 512;
+    std::mt19937 random( 7 );
+
+    for ( int channels = 1; channels <= 2; channels++ )
+    {
+        for ( int quality = ADPCM_ENCODE_FAST; quality <= ADPCM_ENCODE_BEST; quality++ )
+        {
+            std::vector<int16_t> source = MakeTestSignal( random, frameCount, channels );
+            size_t blockAlign = ADPCMBlockAlign( channels, samplesPerBlock );
+
+            std::vector<uint8_t> encoded;
+            size_t blockCount = EncodeADPCM( &source[0], frameCount, channels, samplesPerBlock, static_cast<ADPCM_ENCODE_QUALITY>( quality ), encoded, 3 );
+            CHECK( blockCount == ( frameCount + samplesPerBlock - 1 ) / samplesPerBlock );
+            CHECK( encoded.size() == blockCount * blockAlign );
+
+            std::vector<uint8_t> encodedOnOneThread;
+            EncodeADPCM( &source[0], frameCount, channels, samplesPerBlock, static_cast<ADPCM_ENCODE_QUALITY>( quality ), encodedOnOneThread, 1 );
+            CHECK( encoded == encodedOnOneThread );
+
+            std::vector<int16_t> decoded( blockCount * samplesPerBlock * channels );
+            std::vector<int16_t> expected( decoded.size() );
+            CHECK( DecodeADPCM( &encoded[0], blockCount, channels, samplesPerBlock, &decoded[0] ) );
+            for ( size_t b = 0; b < blockCount; b++ )
+            {
+                ReferenceDecode( &encoded[b * blockAlign], channels, samplesPerBlock, &expected[b * samplesPerBlock * channels] );
+            }
+
+            CHECK( decoded == expected );
+
+            double signal = 0.0;
+            double noise = 0.0;
+            for ( size_t i = 0; i < source.size(); i++ )
+            {
+                double difference = double( source[i] ) - decoded[i];
+                signal += double( source[i] ) * source[i];
+                noise += difference * difference;
+            }
+
+            double signalToNoise = 10.0 * log10( signal / noise );
+            CHECK( signalToNoise > 15.0 );
+            wprintf( L"    %d channel(s), quality %d: %.2f dB\n", channels, quality, signalToNoise );
+        }
+    }
+}
+
+TEST( ADPCMCodec_SilenceAndShortInput )
+{
+    // Fewer frames than a block pad it out with silence.
+    std::vector<int16_t> silence( 100, 0 );
+    std::vector<uint8_t> encoded;
+    CHECK( EncodeADPCM( &silence[0], 50, 2, 64, ADPCM_ENCODE_BEST, encoded ) == 1 );
+
+    std::vector<int16_t> decoded( 128, 1 );
+    CHECK( DecodeADPCM( &encoded[0], 1, 2, 64, &decoded[0] ) );
+    CHECK( std::count( decoded.begin(), decoded.end(), 0 ) == 128 );
+
+    CHECK( EncodeADPCM( nullptr, 0, 1, 64, ADPCM_ENCODE_FAST, encoded ) == 0 );
+    CHECK( encoded.empty() );
+
+    bool threw = false;
+    try
+    {
+        EncodeADPCM( nullptr, 0, 1, 63, ADPCM_ENCODE_FAST, encoded );
+    }
+    catch ( const std::invalid_argument& )
+    {
+        threw = true;
+    }
+
+    CHECK( threw );
+}
+
+// Encode and decode times for 30 s of audio, by channels, threads and quality.
+BENCHMARK( ADPCMCodec_EncodeAndDecode )
+{
+    const unsigned int threadCounts[] = { 1, 2, 4 };
+    for ( int channels = 1; channels <= 2; channels++ )
+    {
+        for ( unsigned int t = 0; t < ARRAYSIZE( threadCounts ); t++ )
+        {
+            for ( int quality = ADPCM_ENCODE_FAST; quality <= ADPCM_ENCODE_BEST; quality++ )
+            {
+                ADPCMBenchmark result = BenchmarkADPCM( channels, 512, static_cast<ADPCM_ENCODE_QUALITY>( quality ), 30.0, threadCounts[t] );
+                CHECK( result.blockCount > 0 );
+                wprintf( L"    %d channel(s), %u thread(s), quality %d: encode %.3f s, decode %.4f s (%.0f MB/s), %.2f dB\n",
+                         channels, result.threadCount, quality, result.encodeSeconds, result.decodeSeconds,
+                         result.decodeMegabytesPerSecond, result.signalToNoise );
+            }
+        }
+    }
+}
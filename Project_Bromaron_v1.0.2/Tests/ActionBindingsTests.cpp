@@ -0,0 +1,250 @@
+//--------------------------------------------------------------------------------------
+// File: ActionBindingsTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "ActionBindings.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    enum TestAction
+    {
+        TEST_ACTION_NONE,
+        TEST_ACTION_MOVE,
+        TEST_ACTION_FIRE_DOWN,
+        TEST_ACTION_JUMP_DOWN,
+        TEST_ACTION_START,
+        TEST_ACTION_EXIT,
+        TEST_ACTION_WEAPON_ONE,
+        TEST_ACTION_WEAPON_TWO,
+    };
+
+    const ActionName TestActionNames[] =
+    {
+        { "NONE",           TEST_ACTION_NONE },
+        { "MOVE",           TEST_ACTION_MOVE },
+        { "FIRE_DOWN",      TEST_ACTION_FIRE_DOWN },
+        { "JUMP_DOWN",      TEST_ACTION_JUMP_DOWN },
+        { "START",          TEST_ACTION_START },
+        { "EXIT",           TEST_ACTION_EXIT },
+        { "WEAPON_ONE",     TEST_ACTION_WEAPON_ONE },
+        { "WEAPON_TWO",     TEST_ACTION_WEAPON_TWO },
+    };
+
+    const char TestBindings[] =
+        "# Comments and blank lines are skipped.\n"
+        "key Escape    = EXIT       value=1\n"
+        "key Space     = FIRE_DOWN  value=1 firing=1   # fire\n"
+        "key 1         = WEAPON_ONE value=1 firetype=0\n"
+        "key Control+1 = WEAPON_TWO value=1 firetype=1\n"
+        "key W         = MOVE       value=-1 pitch=1\n"
+        "key A         = MOVE       value=-1 yaw=1\n"
+        "key S         = MOVE       value=-1 pitch=-1\n"
+        "key Left      = MOVE       value=-1 x=-1\n"
+        "\n"
+        "pad Start           = START     value=1\n"
+        "pad A               = FIRE_DOWN value=1\n"
+        "pad LeftShoulder+A  = JUMP_DOWN value=1\n"
+        "pad RightTrigger    = FIRE_DOWN value=1\n"
+        "touch 1 = JUMP_DOWN\n";
+
+    const unsigned int KeyControl = 0x11;
+    const unsigned int KeySpace = 0x20;
+    const unsigned int KeyLeft = 0x25;
+    const unsigned int PadStart = 0x0010;
+    const unsigned int PadLeftShoulder = 0x0100;
+    const unsigned int PadA = 0x1000;
+
+    bool CompileText( ActionBindings* bindings, const char* text, std::string* error )
+    {
+        return bindings->Compile( text, TestActionNames, ARRAYSIZE( TestActionNames ), error );
+    }
+}
+
+TEST( ActionBindings_MergesKeyboardBindings )
+{
+    ActionBindings bindings;
+    std::string error;
+    CHECK( CompileText( &bindings, TestBindings, &error ) );
+    CHECK( error.empty() );
+    CHECK( bindings.GetKeyboardBindingCount() == 8 );
+    CHECK( bindings.GetGamepadBindingCount() == 4 );
+
+    KeyStateTable keys;
+    BoundAction actions[ACTION_BINDING_MAX_ACTIONS];
+    CHECK( bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) ) == 0 );
+
+    // Three MOVE keys merge into one action carrying the newest timestamp.
+    keys.SetDown( 'W', 100 );
+    keys.SetDown( 'A', 200 );
+    keys.SetDown( KeyLeft, 50 );
+    unsigned int count = bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 1 );
+    CHECK( actions[0].Action == TEST_ACTION_MOVE );
+    CHECK( actions[0].Pitch == 1.0f && actions[0].Yaw == 1.0f && actions[0].X == -1.0f );
+    CHECK( actions[0].Value == -1.0f );
+    CHECK( actions[0].Timestamp == 200 );
+
+    // Opposite keys cancel.
+    keys.SetDown( 'S', 300 );
+    count = bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 1 && actions[0].Pitch == 0.0f && actions[0].Timestamp == 300 );
+}
+
+TEST( ActionBindings_ChordsShadowTheirParts )
+{
+    ActionBindings bindings;
+    CHECK( CompileText( &bindings, TestBindings, nullptr ) );
+
+    KeyStateTable keys;
+    BoundAction actions[ACTION_BINDING_MAX_ACTIONS];
+
+    keys.SetDown( '1', 5 );
+    unsigned int count = bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 1 && actions[0].Action == TEST_ACTION_WEAPON_ONE && actions[0].FireType == 0 );
+
+    // Control+1 takes 1 away from the binding on 1 alone.
+    keys.SetDown( KeyControl, 9 );
+    count = bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 1 && actions[0].Action == TEST_ACTION_WEAPON_TWO && actions[0].FireType == 1 );
+    CHECK( actions[0].Timestamp == 9 );
+
+    // Unrelated keys still count, in action order.
+    keys.SetDown( KeySpace, 11 );
+    count = bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 2 );
+    CHECK( actions[0].Action == TEST_ACTION_FIRE_DOWN && actions[0].IsFiring );
+    CHECK( actions[1].Action == TEST_ACTION_WEAPON_TWO );
+
+    // The caller's capacity is respected.
+    CHECK( bindings.TranslateKeyboard( keys, actions, 1 ) == 1 );
+
+    keys.SetUp( KeyControl );
+    count = bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 2 && actions[1].Action == TEST_ACTION_WEAPON_ONE );
+}
+
+TEST( ActionBindings_GamepadAndTouch )
+{
+    ActionBindings bindings;
+    CHECK( CompileText( &bindings, TestBindings, nullptr ) );
+
+    BoundAction actions[ACTION_BINDING_MAX_ACTIONS];
+    CHECK( bindings.TranslateGamepad( 0, 77, actions, ARRAYSIZE( actions ) ) == 0 );
+
+    unsigned int count = bindings.TranslateGamepad( PadA, 77, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 1 && actions[0].Action == TEST_ACTION_FIRE_DOWN && actions[0].Timestamp == 77 );
+
+    count = bindings.TranslateGamepad( PadA | PadLeftShoulder, 78, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 1 && actions[0].Action == TEST_ACTION_JUMP_DOWN );
+
+    // Two bindings for FIRE_DOWN merge and clamp.
+    count = bindings.TranslateGamepad( PadA | PadStart | ACTION_BINDING_PAD_RIGHT_TRIGGER, 79, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 2 );
+    CHECK( actions[0].Action == TEST_ACTION_FIRE_DOWN && actions[0].Value == 1.0f );
+    CHECK( actions[1].Action == TEST_ACTION_START );
+
+    CHECK( bindings.GetTouchAction( 1, TEST_ACTION_MOVE ) == TEST_ACTION_JUMP_DOWN );
+    CHECK( bindings.GetTouchAction( 0, TEST_ACTION_MOVE ) == TEST_ACTION_MOVE );
+    CHECK( bindings.GetTouchAction( 99, TEST_ACTION_MOVE ) == TEST_ACTION_MOVE );
+}
+
+TEST( ActionBindings_KeyNamesAndClamping )
+{
+    ActionBindings bindings;
+    CHECK( CompileText( &bindings, "key 0x41 = MOVE\nkey Number2 = MOVE\nkey f12 = MOVE\nkey space = FIRE_DOWN\n", nullptr ) );
+    CHECK( bindings.GetKeyboardBindingCount() == 4 );
+
+    KeyStateTable keys;
+    BoundAction actions[ACTION_BINDING_MAX_ACTIONS];
+    keys.SetDown( 0x7B );
+    CHECK( bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) ) == 1 );
+
+    CHECK( CompileText( &bindings, "key W = MOVE value=-1 pitch=3\n", nullptr ) );
+    keys.Clear();
+    keys.SetDown( 'W' );
+    unsigned int count = bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) );
+    CHECK( count == 1 && actions[0].Pitch == 1.0f && actions[0].Value == -1.0f );
+}
+
+// Every error leaves no bindings at all, and says what was wrong.
+TEST( ActionBindings_RejectsBadFiles )
+{
+    const char* badLines[] =
+    {
+        "key W MOVE\n",
+        "key Foo = MOVE\n",
+        "key W = JUMP\n",
+        "key W = MOVE speed=1\n",
+        "pad Z = MOVE\n",
+        "key A+B+C+D+E = MOVE\n",
+        "mouse W = MOVE\n",
+        "touch 1 = MOVE\ntouch 1 = MOVE\n",
+        "key W = MOVE x=abc\n",
+        "touch 99 = MOVE\n",
+    };
+
+    for ( unsigned int i = 0; i < ARRAYSIZE( badLines ); i++ )
+    {
+        ActionBindings bindings;
+        std::string error;
+        std::string text = std::string( "key Q = MOVE\npad A = FIRE_DOWN\n" ) + badLines[i];
+
+        CHECK( !CompileText( &bindings, text.c_str(), &error ) );
+        CHECK( !error.empty() );
+        CHECK( bindings.GetKeyboardBindingCount() == 0 );
+        CHECK( bindings.GetGamepadBindingCount() == 0 );
+    }
+}
+
+// One keyboard translation with ten keys held against 40 bindings, half of
+// them chords.
+BENCHMARK( ActionBindings_TranslateKeyboard )
+{
+    const char* keyNames[] =
+    {
+        "W", "A", "S", "D", "Q", "E", "I", "J", "K", "L",
+        "Up", "Down", "Left", "Right", "Space", "Control", "Escape", "1", "2", "3",
+    };
+
+    std::string text;
+    for ( unsigned int i = 0; i < ARRAYSIZE( keyNames ); i++ )
+    {
+        text += std::string( "key " ) + keyNames[i] + " = MOVE value=-1 pitch=1\n";
+        text += std::string( "key Shift+" ) + keyNames[i] + " = FIRE_DOWN value=1\n";
+    }
+
+    ActionBindings bindings;
+    CHECK( CompileText( &bindings, text.c_str(), nullptr ) );
+
+    KeyStateTable keys;
+    for ( unsigned int i = 0; i < 10; i++ )
+    {
+        keys.SetDown( static_cast<unsigned int>( keyNames[i][0] ) );
+    }
+
+    const unsigned int iterations = 1000000;
+    BoundAction actions[ACTION_BINDING_MAX_ACTIONS];
+    unsigned int total = 0;
+
+    double start = Tests::GetSeconds();
+    for ( unsigned int i = 0; i < iterations; i++ )
+    {
+        total += bindings.TranslateKeyboard( keys, actions, ARRAYSIZE( actions ) );
+    }
+    double seconds = Tests::GetSeconds() - start;
+
+    CHECK( total == iterations );
+    wprintf( L"    %u bindings, 10 keys held: %.1f ns per translation\n",
+             bindings.GetKeyboardBindingCount(), seconds * 1e9 / iterations );
+}
@@ -0,0 +1,152 @@
+//--------------------------------------------------------------------------------------
+// File: AllocationTrackerTests.cpp
+//
+// The tracker's counters are process-wide, so these tests compare snapshots taken
+// before and after rather than absolute values.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "AllocationTracker.h"
+#include "EntityWorld.h"
+#include "TransformHierarchy.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    typedef std::vector<unsigned char, TrackingAllocator<unsigned char, MEMORY_TAG_AUDIO>> AudioBuffer;
+}
+
+TEST( AllocationTracker_CountsFramesAndTags )
+{
+    if ( !AllocationTracker::IsEnabled() )
+    {
+        wprintf( L"    skipped: ALLOCATION_TRACKING is off\n" );
+        return;
+    }
+
+    MemorySnapshot before;
+    AllocationTracker::BeginFrame();
+    AllocationTracker::GetSnapshot( &before );
+
+    {
+        AudioBuffer buffer( 4000 );
+        AudioBuffer other( 1000 );
+
+        MemorySnapshot during;
+        AllocationTracker::GetSnapshot( &during );
+
+        const MemoryTagStats& audio = during.Tags[MEMORY_TAG_AUDIO];
+        CHECK( audio.LiveBytes == before.Tags[MEMORY_TAG_AUDIO].LiveBytes + 5000 );
+        CHECK( audio.PeakBytes >= audio.LiveBytes );
+        CHECK( audio.TotalAllocations == before.Tags[MEMORY_TAG_AUDIO].TotalAllocations + 2 );
+        CHECK( during.TotalAllocations >= before.TotalAllocations + 2 );
+    }
+
+    AllocationTracker::BeginFrame();
+    CHECK( AllocationTracker::GetLastFrameAllocationCount() >= 2 );
+    CHECK( AllocationTracker::GetLastFrameAllocationBytes() >= 5000 );
+
+    // A frame without allocations lands in histogram bucket 0 of every tag.
+    AllocationTracker::BeginFrame();
+    CHECK( AllocationTracker::GetLastFrameAllocationCount() == 0 );
+
+    MemorySnapshot after;
+    AllocationTracker::GetSnapshot( &after );
+
+    const MemoryTagStats& audio = after.Tags[MEMORY_TAG_AUDIO];
+    CHECK( audio.LiveBytes == before.Tags[MEMORY_TAG_AUDIO].LiveBytes );
+    CHECK( audio.TotalFrees == before.Tags[MEMORY_TAG_AUDIO].TotalFrees + 2 );
+    CHECK( audio.LastFrameAllocations == 0 );
+    CHECK( audio.FrameHistogram[0] == before.Tags[MEMORY_TAG_AUDIO].FrameHistogram[0] + 1 );
+
+    // Two allocations in one frame: bucket 2 holds frames with 2 or 3.
+    CHECK( audio.FrameHistogram[2] == before.Tags[MEMORY_TAG_AUDIO].FrameHistogram[2] + 1 );
+    CHECK( after.FrameCount == before.FrameCount + 2 );
+}
+
+// Scene nodes and entities are charged to MEMORY_TAG_SCENE, and give it all
+// back when they go.
+TEST( AllocationTracker_ChargesScene )
+{
+    if ( !AllocationTracker::IsEnabled() )
+    {
+        wprintf( L"    skipped: ALLOCATION_TRACKING is off\n" );
+        return;
+    }
+
+    MemorySnapshot before;
+    AllocationTracker::GetSnapshot( &before );
+
+    {
+        TransformHierarchy transforms;
+        TransformNode root = transforms.AddNode();
+        for ( int i = 0; i < 100; i++ )
+        {
+            transforms.AddNode( root );
+        }
+
+        MemorySnapshot nodes;
+        AllocationTracker::GetSnapshot( &nodes );
+        CHECK( nodes.Tags[MEMORY_TAG_SCENE].LiveBytes >= before.Tags[MEMORY_TAG_SCENE].LiveBytes + 101 * sizeof( XMFLOAT4X4 ) * 2 );
+
+        EntityWorld world;
+        for ( int i = 0; i < 100; i++ )
+        {
+            world.CreateEntity( float( i ), i );
+        }
+
+        MemorySnapshot entities;
+        AllocationTracker::GetSnapshot( &entities );
+        CHECK( entities.Tags[MEMORY_TAG_SCENE].LiveBytes >= nodes.Tags[MEMORY_TAG_SCENE].LiveBytes + ENTITY_CHUNK_BYTES );
+    }
+
+    MemorySnapshot after;
+    AllocationTracker::GetSnapshot( &after );
+    CHECK( after.Tags[MEMORY_TAG_SCENE].LiveBytes == before.Tags[MEMORY_TAG_SCENE].LiveBytes );
+    CHECK( after.Tags[MEMORY_TAG_SCENE].TotalFrees > before.Tags[MEMORY_TAG_SCENE].TotalFrees );
+}
+
+TEST( AllocationTracker_SnapshotJson )
+{
+    MemorySnapshot snapshot;
+    memset( &snapshot, 0, sizeof( snapshot ) );
+    snapshot.FrameCount = 3;
+    snapshot.TotalAllocations = 12;
+    snapshot.TotalBytes = 4096;
+    snapshot.Tags[MEMORY_TAG_INPUT].LiveBytes = 64;
+    snapshot.Tags[MEMORY_TAG_INPUT].FrameHistogram[1] = 2;
+
+    std::string json = AllocationTracker::SnapshotToJson( snapshot );
+
+    CHECK( json.find( "\"frames\": 3" ) != std::string::npos );
+    CHECK( json.find( "\"allocs\": 12" ) != std::string::npos );
+    CHECK( json.find( "\"bytes\": 4096" ) != std::string::npos );
+    CHECK( json.find( "\"input\": { \"live\": 64" ) != std::string::npos );
+    CHECK( json.find( "\"frameHistogram\": [ 0, 2, 0" ) != std::string::npos );
+
+    for ( unsigned int t = 0; t < MEMORY_TAG_COUNT; t++ )
+    {
+        std::string name = std::string( "\"" ) + AllocationTracker::GetTagName( static_cast<MEMORY_TAG>( t ) ) + "\":";
+        CHECK( json.find( name ) != std::string::npos );
+    }
+
+    // Balanced braces and brackets, so the file loads as JSON.
+    int depth = 0;
+    bool balanced = true;
+    for ( size_t i = 0; i < json.size(); i++ )
+    {
+        if ( json[i] == '{' || json[i] == '[' ) depth++;
+        if ( json[i] == '}' || json[i] == ']' ) depth--;
+        balanced = balanced && depth >= 0;
+    }
+    CHECK( balanced && depth == 0 );
+}
@@ -0,0 +1,277 @@
+//--------------------------------------------------------------------------------------
+// File: BatchSpatializerTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "BatchSpatializer.h"
+
+using namespace DirectX;
+
+namespace
+{
+    // At the origin, facing +z with +y up.
+    BatchListener MakeListener()
+    {
+        BatchListener listener;
+        memset( &listener, 0, sizeof( listener ) );
+        listener.orientFront[2] = 1.0f;
+        listener.orientTop[1] = 1.0f;
+        return listener;
+    }
+
+    bool IsNearValue( float a, float b )
+    {
+        return fabsf( a - b ) <= 1e-4f;
+    }
+
+    // Emitters stored as SpatializeBatch takes them: positions, velocities and
+    // unit fronts, nine arrays of count each.
+    struct EmitterArrays
+    {
+        EmitterArrays( size_t emitterCount, uint32_t seed ) :
+            data( 9 * emitterCount + 1 ),
+            count( emitterCount )
+        {
+            for ( size_t i = 0; i < data.size(); i++ )
+            {
+                seed = seed * 1664525u + 1013904223u;
+                data[i] = ( float( seed >> 8 ) / 16777216.0f * 2.0f - 1.0f ) * 50.0f;
+            }
+
+            for ( size_t j = 0; j < count; j++ )
+            {
+                float* x = &data[6 * count + j];
+                float* y = &data[7 * count + j];
+                float* z = &data[8 * count + j];
+                float length = sqrtf( *x * *x + *y * *y + *z * *z );
+                if ( length < 1e-3f )
+                {
+                    *x = 0.0f;
+                    *y = 0.0f;
+                    *z = 1.0f;
+                }
+                else
+                {
+                    *x /= length;
+                    *y /= length;
+                    *z /= length;
+                }
+            }
+        }
+
+        BatchEmitters Get( bool moving ) const
+        {
+            const float* base = &data[0];
+            BatchEmitters emitters =
+            {
+                count, base, base + count, base + 2 * count,
+                moving ? base + 3 * count : nullptr, moving ? base + 4 * count : nullptr, moving ? base + 5 * count : nullptr,
+                base + 6 * count, base + 7 * count, base + 8 * count
+            };
+            return emitters;
+        }
+
+        std::vector<float>  data;
+        size_t              count;
+    };
+}
+
+// An emitter off to the right is panned hard right at 1 / distance; one inside
+// curveDistanceScaler is at full volume.
+TEST( BatchSpatializer_DistanceAndPan )
+{
+    BatchListener listener = MakeListener();
+    BatchSpatializerSettings settings;
+    GetDefaultBatchSpatializerSettings( settings );
+
+    float position[3] = { 5.0f, 0.0f, 0.0f };
+    BatchSpatializerResult result = SpatializeEmitter( listener, position, nullptr, nullptr, settings );
+    CHECK( IsNearValue( result.pan, 1.0f ) && IsNearValue( result.volume, 0.2f ) );
+    CHECK( IsNearValue( result.left, 0.0f ) && IsNearValue( result.right, 0.2f ) );
+    CHECK( result.doppler == 1.0f );
+
+    position[0] = -0.5f;
+    result = SpatializeEmitter( listener, position, nullptr, nullptr, settings );
+    CHECK( IsNearValue( result.pan, -1.0f ) && result.volume == 1.0f );
+}
+
+// Closing speed raises the pitch, whichever of the two is moving, up to maxDoppler.
+TEST( BatchSpatializer_Doppler )
+{
+    BatchListener listener = MakeListener();
+    BatchSpatializerSettings settings;
+    GetDefaultBatchSpatializerSettings( settings );
+
+    float position[3] = { 0.0f, 0.0f, 100.0f };
+    float velocity[3] = { 0.0f, 0.0f, -34.35f };
+    BatchSpatializerResult result = SpatializeEmitter( listener, position, velocity, nullptr, settings );
+    CHECK( IsNearValue( result.doppler, 343.5f / ( 343.5f - 34.35f ) ) );
+
+    velocity[2] = 34.35f;
+    result = SpatializeEmitter( listener, position, velocity, nullptr, settings );
+    CHECK( result.doppler < 1.0f );
+
+    listener.velocity[2] = 34.35f;
+    result = SpatializeEmitter( listener, position, nullptr, nullptr, settings );
+    CHECK( IsNearValue( result.doppler, 1.1f ) );
+
+    velocity[2] = -1000.0f;
+    result = SpatializeEmitter( listener, position, velocity, nullptr, settings );
+    CHECK( result.doppler == settings.maxDoppler );
+}
+
+// Inner volume facing the listener, outer volume facing away or beyond half the
+// outer angle, and linear in between.
+TEST( BatchSpatializer_Cone )
+{
+    BatchListener listener = MakeListener();
+    BatchSpatializerSettings settings;
+    GetDefaultBatchSpatializerSettings( settings );
+    settings.useCone = true;
+    settings.coneInnerAngle = 1.0f;
+    settings.coneOuterAngle = 2.0f;
+    settings.coneInnerVolume = 1.0f;
+    settings.coneOuterVolume = 0.5f;
+    settings.curveDistanceScaler = 200.0f;
+
+    float position[3] = { 0.0f, 0.0f, 100.0f };
+    float front[3] = { 0.0f, 0.0f, -1.0f };
+    CHECK( IsNearValue( SpatializeEmitter( listener, position, nullptr, front, settings ).volume, 1.0f ) );
+
+    front[2] = 1.0f;
+    CHECK( IsNearValue( SpatializeEmitter( listener, position, nullptr, front, settings ).volume, 0.5f ) );
+
+    front[0] = 1.0f;
+    front[2] = 0.0f;
+    CHECK( IsNearValue( SpatializeEmitter( listener, position, nullptr, front, settings ).volume, 0.5f ) );
+
+    // 0.75 rad off axis is halfway between the inner (0.5) and outer (1) half-angles.
+    front[0] = sinf( 0.75f );
+    front[2] = -cosf( 0.75f );
+    CHECK( IsNearValue( SpatializeEmitter( listener, position, nullptr, front, settings ).volume, 0.75f ) );
+}
+
+// Every batch size up to past several SIMD widths, with and without cones and
+// velocities, agrees with the scalar path and lists the audible emitters in order.
+TEST( BatchSpatializer_MatchesScalarPath )
+{
+    BatchListener listener = MakeListener();
+    listener.position[0] = 1.0f;
+    listener.velocity[0] = 20.0f;
+    listener.orientFront[0] = 0.6f;
+    listener.orientFront[2] = 0.8f;
+
+    float worst = 0.0f;
+    bool ordered = true;
+    bool countsMatch = true;
+
+    for ( size_t count = 0; count < 68; count++ )
+    {
+        EmitterArrays arrays( count, uint32_t( count * 7 + 1 ) );
+
+        // One emitter right at the listener.
+        if ( count > 3 )
+        {
+            arrays.data[2] = 1.0f;
+            arrays.data[count + 2] = 0.0f;
+            arrays.data[2 * count + 2] = 0.0f;
+        }
+
+        for ( int cone = 0; cone < 2; cone++ )
+        {
+            for ( int moving = 0; moving < 2; moving++ )
+            {
+                BatchSpatializerSettings settings;
+                GetDefaultBatchSpatializerSettings( settings );
+                settings.curveDistanceScaler = 10.0f;
+                settings.audibleVolume = 0.3f;
+                settings.useCone = ( cone != 0 );
+                settings.coneInnerAngle = 1.0f;
+                settings.coneOuterAngle = 4.0f;
+                settings.coneOuterVolume = 0.1f;
+
+                BatchEmitters emitters = arrays.Get( moving != 0 );
+                std::vector<float> values( 5 * count + 1 );
+                std::vector<uint32_t> audible( count + 1 );
+                BatchSpatializerOutput output = { &values[0], &values[count], &values[2 * count], &values[3 * count], &values[4 * count], &audible[0] };
+                size_t audibleCount = SpatializeBatch( listener, emitters, settings, output );
+
+                BatchSpatializerOutput nothing = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+                countsMatch = countsMatch && ( SpatializeBatch( listener, emitters, settings, nothing ) == audibleCount );
+
+                size_t expected = 0;
+                for ( size_t j = 0; j < count; j++ )
+                {
+                    const float* data = &arrays.data[0];
+                    float position[3] = { data[j], data[count + j], data[2 * count + j] };
+                    float velocity[3] = { data[3 * count + j], data[4 * count + j], data[5 * count + j] };
+                    float front[3] = { data[6 * count + j], data[7 * count + j], data[8 * count + j] };
+                    BatchSpatializerResult result = SpatializeEmitter( listener, position, moving ? velocity : nullptr, front, settings );
+
+                    worst = std::max( worst, fabsf( result.volume - values[j] ) );
+                    worst = std::max( worst, fabsf( result.pan - values[count + j] ) );
+                    worst = std::max( worst, fabsf( result.left - values[2 * count + j] ) );
+                    worst = std::max( worst, fabsf( result.right - values[3 * count + j] ) );
+                    worst = std::max( worst, fabsf( result.doppler - values[4 * count + j] ) );
+
+                    if ( values[j] >= settings.audibleVolume )
+                    {
+                        ordered = ordered && ( expected < audibleCount ) && ( audible[expected] == j );
+                        expected++;
+                    }
+                }
+
+                countsMatch = countsMatch && ( expected == audibleCount );
+            }
+        }
+    }
+
+    CHECK( worst < 1e-4f );
+    CHECK( ordered );
+    CHECK( countsMatch );
+}
+
+TEST( BatchSpatializer_MissingPositions )
+{
+    BatchListener listener = MakeListener();
+    BatchSpatializerSettings settings;
+    GetDefaultBatchSpatializerSettings( settings );
+
+    BatchEmitters emitters = { 3, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+    BatchSpatializerOutput nothing = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+
+    bool threw = false;
+    try
+    {
+        SpatializeBatch( listener, emitters, settings, nothing );
+    }
+    catch ( const std::invalid_argument& )
+    {
+        threw = true;
+    }
+
+    CHECK( threw );
+}
+
+// Batch time per call against a loop over SpatializeEmitter, for moving, coned
+// emitters around a moving listener.
+BENCHMARK( BatchSpatializer_EmitterCounts )
+{
+    const size_t emitterCounts[] = { 1000, 5000, 20000, 50000 };
+    for ( size_t i = 0; i < ARRAYSIZE( emitterCounts ); i++ )
+    {
+        BatchSpatializerBenchmark result = BenchmarkBatchSpatializer( emitterCounts[i], 200 );
+        CHECK( result.maxError < 1e-4f );
+        wprintf( L"    %6u emitters: %7.1f us per batch (%.1f M emitters/s), scalar %7.1f us, %u audible\n",
+                 static_cast<unsigned int>( result.emitterCount ), result.seconds * 1e6, result.emittersPerSecond / 1e6,
+                 result.referenceSeconds * 1e6, static_cast<unsigned int>( result.audibleCount ) );
+    }
+}
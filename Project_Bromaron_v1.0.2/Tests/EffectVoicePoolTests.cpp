@@ -0,0 +1,442 @@
+//--------------------------------------------------------------------------------------
+// File: EffectVoicePoolTests.cpp
+//
+// The pool is driven the way SoundPlayer drives it, with stand-in sounds and
+// the test playing the part of the mixer by calling OnVoiceEnd.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "EffectVoicePool.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    const float ReferenceDistance = 10.0f;
+
+    std::shared_ptr<const SoundAsset> MakeSound()
+    {
+        std::shared_ptr<SoundAsset> sound( new SoundAsset() );
+        sound->Format.assign( 18, 0 );
+        sound->Data.assign( 256, 0 );
+        return sound;
+    }
+
+    EffectVoiceRequest MakeRequest( const std::shared_ptr<const SoundAsset>& sound, EFFECT_PRIORITY priority, float volume, float distance = 0.0f )
+    {
+        EffectVoiceRequest request;
+        request.Sound = sound;
+        request.Priority = priority;
+        request.Volume = volume;
+        request.Distance = distance;
+        return request;
+    }
+}
+
+TEST( EffectVoicePool_UsesFreeVoicesFirst )
+{
+    EffectVoicePool pool( 4, ReferenceDistance );
+    CHECK( pool.GetVoiceCount() == 4 );
+    CHECK( EffectVoicePool( 100, ReferenceDistance ).GetVoiceCount() == EFFECT_VOICE_POOL_MAX_VOICES );
+
+    std::shared_ptr<const SoundAsset> sound = MakeSound();
+    for ( unsigned int i = 0; i < 4; i++ )
+    {
+        unsigned int slot = 99;
+        float gain = 0.0f;
+        CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 0.8f ), &slot, &gain ) == EFFECT_VOICE_FREE );
+        CHECK( slot == i );
+        CHECK( gain == 0.8f );
+    }
+
+    EffectVoiceStats stats;
+    pool.GetStats( &stats );
+    CHECK( stats.Started == 4 && stats.Playing == 4 && stats.Stolen == 0 && stats.Retiring == 0 );
+
+    // A voice whose buffer ended is free again after Update, not before.
+    pool.OnVoiceEnd( 2 );
+    unsigned int slot;
+    float gain;
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_LOW, 1.0f ), &slot, &gain ) == EFFECT_VOICE_REJECTED );
+    pool.Update();
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_LOW, 1.0f ), &slot, &gain ) == EFFECT_VOICE_FREE );
+    CHECK( slot == 2 );
+}
+
+// Distance attenuates inverse to the reference distance, and sounds too quiet
+// to hear never take a voice.
+TEST( EffectVoicePool_CullsInaudibleSounds )
+{
+    EffectVoicePool pool( 4, ReferenceDistance );
+    std::shared_ptr<const SoundAsset> sound = MakeSound();
+
+    unsigned int slot;
+    float gain;
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 1.0f, 5.0f ), &slot, &gain ) == EFFECT_VOICE_FREE );
+    CHECK( gain == 1.0f );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 1.0f, 40.0f ), &slot, &gain ) == EFFECT_VOICE_FREE );
+    CHECK( Tests::IsNear( gain, 0.25, 1e-6 ) );
+
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_CRITICAL, 0.005f ), &slot, &gain ) == EFFECT_VOICE_CULLED );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_CRITICAL, 1.0f, 2000.0f ), &slot, &gain ) == EFFECT_VOICE_CULLED );
+    CHECK( pool.Allocate( MakeRequest( nullptr, EFFECT_PRIORITY_CRITICAL, 1.0f ), &slot, &gain ) == EFFECT_VOICE_CULLED );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_CRITICAL, std::numeric_limits<float>::quiet_NaN() ), &slot, &gain ) == EFFECT_VOICE_CULLED );
+
+    EffectVoiceStats stats;
+    pool.GetStats( &stats );
+    CHECK( stats.Culled == 4 && stats.Started == 2 && stats.Playing == 2 );
+}
+
+// With every voice busy: lowest priority goes first, then the quietest, then
+// the oldest. Nothing steals from a more important or louder sound.
+TEST( EffectVoicePool_StealsLeastImportant )
+{
+    EffectVoicePool pool( 4, ReferenceDistance );
+    std::shared_ptr<const SoundAsset> sound = MakeSound();
+
+    unsigned int slot;
+    float gain;
+    pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_HIGH, 0.5f ), &slot, &gain );      // 0
+    pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 0.9f ), &slot, &gain );    // 1
+    pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 0.3f ), &slot, &gain );    // 2
+    pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_LOW, 1.0f ), &slot, &gain );       // 3
+
+    // A low-priority sound takes the low-priority voice, if it's at least as loud.
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_LOW, 0.5f ), &slot, &gain ) == EFFECT_VOICE_REJECTED );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_LOW, 1.0f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    CHECK( slot == 3 );
+
+    // Then the low-priority voice again, as it is still the least important.
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 0.1f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    CHECK( slot == 3 );
+
+    // Now three normal voices: the quietest (slot 3, at 0.1) goes before slot 2.
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 0.3f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    CHECK( slot == 3 );
+
+    // Slots 2 and 3 are equally quiet; the older one goes.
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 0.3f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    CHECK( slot == 2 );
+
+    // Nothing quieter than the quietest normal voice gets in.
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 0.2f ), &slot, &gain ) == EFFECT_VOICE_REJECTED );
+
+    // Critical sounds take the normal voices, quietest first, and then the
+    // high one.
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_CRITICAL, 0.05f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    CHECK( slot == 3 );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_CRITICAL, 0.05f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    CHECK( slot == 2 );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_CRITICAL, 0.05f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    CHECK( slot == 1 );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_CRITICAL, 0.05f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    CHECK( slot == 0 );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_HIGH, 1.0f ), &slot, &gain ) == EFFECT_VOICE_REJECTED );
+
+    EffectVoiceStats stats;
+    pool.GetStats( &stats );
+    CHECK( stats.Stolen == 8 && stats.Rejected == 3 && stats.Playing == 4 );
+    CHECK( stats.Retiring == 8 );
+}
+
+// A stolen sound stays alive until the mixer reports its buffer ended, even if
+// nothing else holds it.
+TEST( EffectVoicePool_HoldsStolenSoundsUntilEnded )
+{
+    EffectVoicePool pool( 1, ReferenceDistance );
+
+    std::shared_ptr<const SoundAsset> first = MakeSound();
+    std::weak_ptr<const SoundAsset> firstAlive = first;
+
+    unsigned int slot;
+    float gain;
+    CHECK( pool.Allocate( MakeRequest( first, EFFECT_PRIORITY_NORMAL, 0.5f ), &slot, &gain ) == EFFECT_VOICE_FREE );
+    first.reset();
+    CHECK( !firstAlive.expired() );
+
+    std::shared_ptr<const SoundAsset> second = MakeSound();
+    std::weak_ptr<const SoundAsset> secondAlive = second;
+    CHECK( pool.Allocate( MakeRequest( second, EFFECT_PRIORITY_NORMAL, 0.5f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    second.reset();
+
+    pool.Update();
+    CHECK( !firstAlive.expired() );
+
+    EffectVoiceStats stats;
+    pool.GetStats( &stats );
+    CHECK( stats.Retiring == 1 && stats.Playing == 1 );
+
+    // The first buffer ends: the stolen sound goes, the new one keeps playing.
+    pool.OnVoiceEnd( slot );
+    pool.Update();
+    CHECK( firstAlive.expired() && !secondAlive.expired() );
+    pool.GetStats( &stats );
+    CHECK( stats.Retiring == 0 && stats.Playing == 1 );
+
+    pool.OnVoiceEnd( slot );
+    pool.Update();
+    CHECK( secondAlive.expired() );
+    pool.GetStats( &stats );
+    CHECK( stats.Playing == 0 );
+}
+
+TEST( EffectVoicePool_CancelAndRecreate )
+{
+    EffectVoicePool pool( 2, ReferenceDistance );
+    std::shared_ptr<const SoundAsset> sound = MakeSound();
+
+    // A sound that couldn't be submitted frees its voice at once, and doesn't
+    // throw off the count of buffers ended.
+    unsigned int slot;
+    float gain;
+    pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 1.0f ), &slot, &gain );
+    CHECK( slot == 0 );
+    pool.Cancel( slot );
+    pool.Cancel( slot );
+    pool.Cancel( 99 );
+
+    EffectVoiceStats stats;
+    pool.GetStats( &stats );
+    CHECK( stats.Playing == 0 && stats.Started == 0 );
+
+    pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 1.0f ), &slot, &gain );
+    CHECK( slot == 0 );
+    pool.OnVoiceEnd( slot );
+    pool.Update();
+    pool.GetStats( &stats );
+    CHECK( stats.Playing == 0 && stats.Started == 1 );
+
+    // A voice recreated after stealing never reports the stolen buffer; the
+    // stolen sound goes, and the current one keeps its voice.
+    std::shared_ptr<const SoundAsset> stolen = MakeSound();
+    std::weak_ptr<const SoundAsset> stolenAlive = stolen;
+    pool.Allocate( MakeRequest( stolen, EFFECT_PRIORITY_NORMAL, 0.5f ), &slot, &gain );
+    pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 0.5f ), &slot, &gain );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_NORMAL, 0.5f ), &slot, &gain ) == EFFECT_VOICE_STOLEN );
+    CHECK( slot == 0 );
+    stolen.reset();
+
+    pool.OnVoiceRecreated( slot );
+    pool.Update();
+    CHECK( stolenAlive.expired() );
+    pool.GetStats( &stats );
+    CHECK( stats.Playing == 2 && stats.Retiring == 0 );
+
+    // A voice recreated while free stays free, and the next sound on it plays
+    // until its own buffer ends.
+    pool.OnVoiceEnd( 0 );
+    pool.OnVoiceEnd( 1 );
+    pool.Update();
+    pool.OnVoiceRecreated( 1 );
+    pool.OnVoiceRecreated( 99 );
+    pool.Update();
+    pool.GetStats( &stats );
+    CHECK( stats.Playing == 0 );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_LOW, 1.0f ), &slot, &gain ) == EFFECT_VOICE_FREE );
+    CHECK( pool.Allocate( MakeRequest( sound, EFFECT_PRIORITY_LOW, 1.0f ), &slot, &gain ) == EFFECT_VOICE_FREE );
+    CHECK( slot == 1 );
+    pool.Update();
+    pool.GetStats( &stats );
+    CHECK( stats.Playing == 2 );
+    pool.OnVoiceEnd( 1 );
+    pool.Update();
+    pool.GetStats( &stats );
+    CHECK( stats.Playing == 1 );
+}
+
+// A mixer thread ends buffers while the game thread allocates and updates.
+// Once everything has ended, every sound has been let go.
+TEST( EffectVoicePool_MixerThreadEndsBuffers )
+{
+    const unsigned int soundCount = 20000;
+
+    EffectVoicePool pool( 8, ReferenceDistance );
+
+    std::mutex mutex;
+    std::deque<unsigned int> submitted;
+    bool done = false;
+
+    std::thread mixer( [&]()
+    {
+        for ( ;; )
+        {
+            unsigned int slot;
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                if ( submitted.empty() )
+                {
+                    if ( done )
+                    {
+                        return;
+                    }
+
+                    continue;
+                }
+
+                slot = submitted.front();
+                submitted.pop_front();
+            }
+
+            pool.OnVoiceEnd( slot );
+        }
+    } );
+
+    std::vector<std::weak_ptr<const SoundAsset>> sounds;
+    std::mt19937 random( 40 );
+    std::uniform_int_distribution<int> priority( EFFECT_PRIORITY_LOW, EFFECT_PRIORITY_CRITICAL );
+    std::uniform_real_distribution<float> volume( 0.0f, 1.0f );
+
+    for ( unsigned int i = 0; i < soundCount; i++ )
+    {
+        pool.Update();
+
+        std::shared_ptr<const SoundAsset> sound = MakeSound();
+        unsigned int slot;
+        float gain;
+        EFFECT_VOICE_RESULT result = pool.Allocate( MakeRequest( sound, static_cast<EFFECT_PRIORITY>( priority( random ) ), volume( random ) ), &slot, &gain );
+        if ( ( result == EFFECT_VOICE_FREE ) || ( result == EFFECT_VOICE_STOLEN ) )
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            submitted.push_back( slot );
+            sounds.push_back( sound );
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        done = true;
+    }
+
+    mixer.join();
+    pool.Update();
+
+    EffectVoiceStats stats;
+    pool.GetStats( &stats );
+    CHECK( stats.Playing == 0 && stats.Retiring == 0 );
+    CHECK( stats.Started == sounds.size() );
+    CHECK( stats.Stolen > 0 );
+
+    bool allExpired = true;
+    for ( size_t i = 0; i < sounds.size(); i++ )
+    {
+        allExpired = allExpired && sounds[i].expired();
+    }
+
+    CHECK( allExpired );
+}
+
+// Once the retired list has grown, a frame of allocating, stealing and updating
+// doesn't allocate. The mixer ends each frame's buffers during the next one.
+TEST( EffectVoicePool_SteadyStateMakesNoAllocations )
+{
+    if ( !AllocationTracker::IsEnabled() )
+    {
+        wprintf( L"    skipped: ALLOCATION_TRACKING is off\n" );
+        return;
+    }
+
+    const unsigned int soundsPerFrame = EFFECT_VOICE_POOL_MAX_VOICES + 8;
+
+    EffectVoicePool pool( EFFECT_VOICE_POOL_MAX_VOICES, ReferenceDistance );
+    std::shared_ptr<const SoundAsset> sounds[4] = { MakeSound(), MakeSound(), MakeSound(), MakeSound() };
+
+    unsigned int submitted[soundsPerFrame];
+    unsigned int submittedCount = 0;
+    unsigned int totalBefore = 0;
+
+    for ( unsigned int frame = 0; frame < 200; frame++ )
+    {
+        if ( frame == 100 )
+        {
+            totalBefore = AllocationTracker::GetTotalAllocationCount();
+        }
+
+        for ( unsigned int i = 0; i < submittedCount; i++ )
+        {
+            pool.OnVoiceEnd( submitted[i] );
+        }
+
+        submittedCount = 0;
+        pool.Update();
+
+        for ( unsigned int i = 0; i < soundsPerFrame; i++ )
+        {
+            unsigned int slot;
+            float gain;
+            EFFECT_VOICE_RESULT result = pool.Allocate( MakeRequest( sounds[i & 3], EFFECT_PRIORITY_NORMAL, 0.5f ), &slot, &gain );
+            if ( ( result == EFFECT_VOICE_FREE ) || ( result == EFFECT_VOICE_STOLEN ) )
+            {
+                submitted[submittedCount++] = slot;
+            }
+        }
+    }
+
+    unsigned int allocations = AllocationTracker::GetTotalAllocationCount() - totalBefore;
+    EffectVoiceStats stats;
+    pool.GetStats( &stats );
+    wprintf( L"    %u allocations in 100 frames, %llu sounds stolen\n", allocations, stats.Stolen );
+    CHECK( allocations == 0 );
+    CHECK( stats.Stolen > 0 );
+}
+
+// The cost of one Allocate on a busy pool of 32 voices, and of the Update
+// before it. Each sound plays until 48 more have been asked for, so most
+// requests find every voice playing.
+BENCHMARK( EffectVoicePool_AllocateAndUpdate )
+{
+    const unsigned int iterations = 1000000;
+
+    EffectVoicePool pool( EFFECT_VOICE_POOL_MAX_VOICES, ReferenceDistance );
+    std::shared_ptr<const SoundAsset> sound = MakeSound();
+
+    std::mt19937 random( 1 );
+    std::uniform_real_distribution<float> volume( 0.0f, 1.0f );
+    std::vector<EffectVoiceRequest> requests;
+    for ( unsigned int i = 0; i < 1024; i++ )
+    {
+        requests.push_back( MakeRequest( sound, static_cast<EFFECT_PRIORITY>( i & 3 ), volume( random ), volume( random ) * 40.0f ) );
+    }
+
+    const unsigned int playLength = 48;
+    unsigned int playing[playLength];
+    for ( unsigned int i = 0; i < playLength; i++ )
+    {
+        playing[i] = EFFECT_VOICE_POOL_MAX_VOICES;
+    }
+
+    unsigned int played = 0;
+    double start = Tests::GetSeconds();
+    for ( unsigned int i = 0; i < iterations; i++ )
+    {
+        unsigned int& ending = playing[i % playLength];
+        if ( ending != EFFECT_VOICE_POOL_MAX_VOICES )
+        {
+            pool.OnVoiceEnd( ending );
+            ending = EFFECT_VOICE_POOL_MAX_VOICES;
+        }
+
+        pool.Update();
+
+        unsigned int slot;
+        float gain;
+        EFFECT_VOICE_RESULT result = pool.Allocate( requests[i & 1023], &slot, &gain );
+        if ( ( result == EFFECT_VOICE_FREE ) || ( result == EFFECT_VOICE_STOLEN ) )
+        {
+            ending = slot;
+            played++;
+        }
+    }
+    double seconds = Tests::GetSeconds() - start;
+
+    CHECK( played > 0 );
+    wprintf( L"    %u voices: %.1f ns per Update and Allocate, %u of %u sounds played\n",
+             EFFECT_VOICE_POOL_MAX_VOICES, seconds * 1e9 / iterations, played, iterations );
+}
@@ -0,0 +1,253 @@
+//--------------------------------------------------------------------------------------
+// File: EntityWorldTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "EntityWorld.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    struct TestPose
+    {
+        float Position[4];
+        float Orientation[4];
+    };
+
+    struct TestMotion
+    {
+        float Velocity[4];
+        float AngularVelocity[4];
+    };
+
+    struct TestTag
+    {
+        int Value;
+    };
+
+    TestPose MakePose( float x )
+    {
+        TestPose pose = { { x, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } };
+        return pose;
+    }
+
+    TestMotion MakeMotion( float speed )
+    {
+        TestMotion motion = { { speed, 0.0f, 0.0f, 0.0f }, { 0.0f, speed, 0.0f, 0.0f } };
+        return motion;
+    }
+
+    // The asteroid record the renderer kept before the move to EntityWorld: every
+    // field of every asteroid in one array of structs.
+    struct LegacyAsteroid
+    {
+        float   pos[4];
+        float   ori[4];
+        float   L[4];
+        float   vel[4];
+        bool    boolDraw;
+        int     hitCounter;
+    };
+}
+
+TEST( EntityWorld_CreateDestroyAndGenerations )
+{
+    EntityWorld world;
+
+    Entity a = world.CreateEntity( MakePose( 1.0f ), MakeMotion( 2.0f ) );
+    Entity b = world.CreateEntity( MakePose( 3.0f ) );
+    CHECK( world.GetEntityCount() == 2 );
+    CHECK( world.IsAlive( a ) && world.IsAlive( b ) );
+
+    CHECK( world.GetComponent<TestPose>( a )->Position[0] == 1.0f );
+    CHECK( world.GetComponent<TestMotion>( a )->Velocity[0] == 2.0f );
+    CHECK( world.GetComponent<TestMotion>( b ) == nullptr );
+
+    world.DestroyEntity( a );
+    CHECK( !world.IsAlive( a ) );
+    CHECK( world.GetComponent<TestPose>( a ) == nullptr );
+    CHECK( world.GetEntityCount() == 1 );
+
+    // The slot is reused with a new generation; the old handle stays dead.
+    Entity c = world.CreateEntity( MakePose( 5.0f ), MakeMotion( 6.0f ) );
+    CHECK( c.Index == a.Index );
+    CHECK( c.Generation != a.Generation );
+    CHECK( !world.IsAlive( a ) );
+    CHECK( world.GetComponent<TestPose>( c )->Position[0] == 5.0f );
+
+    world.Clear();
+    CHECK( world.GetEntityCount() == 0 );
+    CHECK( !world.IsAlive( b ) && !world.IsAlive( c ) );
+}
+
+// Destroying fills the hole with the archetype's last row, across chunk boundaries.
+TEST( EntityWorld_DestroyKeepsOtherEntitiesIntact )
+{
+    EntityWorld world;
+    std::vector<Entity> entities;
+
+    const unsigned int count = 2000;
+    for ( unsigned int i = 0; i < count; i++ )
+    {
+        entities.push_back( world.CreateEntity( MakePose( float( i ) ), MakeMotion( float( i ) ) ) );
+    }
+
+    for ( unsigned int i = 0; i < count; i += 3 )
+    {
+        world.DestroyEntity( entities[i] );
+    }
+
+    bool intact = true;
+    for ( unsigned int i = 0; i < count; i++ )
+    {
+        TestPose* pose = world.GetComponent<TestPose>( entities[i] );
+        TestMotion* motion = world.GetComponent<TestMotion>( entities[i] );
+
+        if ( i % 3 == 0 )
+        {
+            intact = intact && !pose && !motion;
+        }
+        else
+        {
+            intact = intact && pose && motion && pose->Position[0] == float( i ) && motion->Velocity[0] == float( i );
+        }
+    }
+
+    CHECK( intact );
+    CHECK( world.GetEntityCount() == count - ( count + 2 ) / 3 );
+}
+
+TEST( EntityWorld_ForEachVisitsMatchingArchetypes )
+{
+    EntityWorld world;
+
+    TestTag tag = { 7 };
+    world.CreateEntity( MakePose( 1.0f ) );
+    world.CreateEntity( MakePose( 2.0f ), MakeMotion( 1.0f ) );
+    world.CreateEntity( MakePose( 3.0f ), MakeMotion( 1.0f ), tag );
+    world.CreateEntity( MakeMotion( 1.0f ) );
+
+    unsigned int poses = 0;
+    float sum = 0.0f;
+    world.ForEach<TestPose>( [&]( const TestPose& pose ) { poses++; sum += pose.Position[0]; } );
+    CHECK( poses == 3 );
+    CHECK( sum == 6.0f );
+
+    unsigned int moving = 0;
+    world.ForEach<TestPose, TestMotion>( [&]( TestPose& pose, const TestMotion& motion )
+    {
+        pose.Position[0] += motion.Velocity[0];
+        moving++;
+    } );
+    CHECK( moving == 2 );
+
+    sum = 0.0f;
+    world.ForEach<TestPose>( [&]( const TestPose& pose ) { sum += pose.Position[0]; } );
+    CHECK( sum == 8.0f );
+}
+
+TEST( EntitySystemScheduler_StagesFollowConflicts )
+{
+    ComponentMask pose = ComponentMaskOf<TestPose>();
+    ComponentMask motion = ComponentMaskOf<TestMotion>();
+    ComponentMask tag = ComponentMaskOf<TestTag>();
+
+    std::vector<int> order;
+    std::mutex orderLock;
+    auto record = [&]( int id ) { std::lock_guard<std::mutex> lock( orderLock ); order.push_back( id ); };
+
+    EntitySystemScheduler scheduler;
+    scheduler.AddSystem( "ReadPose", pose, 0, [&]( EntityWorld& ) { record( 0 ); } );
+    scheduler.AddSystem( "ReadPoseToo", pose, tag, [&]( EntityWorld& ) { record( 1 ); } );
+    scheduler.AddSystem( "WritePose", motion, pose, [&]( EntityWorld& ) { record( 2 ); } );
+    scheduler.AddSystem( "ReadPoseAfter", pose, 0, [&]( EntityWorld& ) { record( 3 ); } );
+
+    // Both readers share a stage; the writer waits for them, and the last reader
+    // for the writer.
+    CHECK( scheduler.GetStageCount() == 3 );
+
+    EntityWorld world;
+    scheduler.Run( world );
+
+    CHECK( order.size() == 4 );
+    if ( order.size() == 4 )
+    {
+        CHECK( ( order[0] == 0 && order[1] == 1 ) || ( order[0] == 1 && order[1] == 0 ) );
+        CHECK( order[2] == 2 );
+        CHECK( order[3] == 3 );
+    }
+}
+
+// The per-frame asteroid update, over the legacy array of structs and over
+// EntityWorld chunks.
+BENCHMARK( EntityWorld_IterationVsStructArray )
+{
+    const unsigned int count = 100000;
+    const unsigned int iterations = 50;
+    const float dt = 1.0f / 60.0f;
+
+    std::vector<LegacyAsteroid> legacy( count );
+    EntityWorld world;
+
+    for ( unsigned int i = 0; i < count; i++ )
+    {
+        TestPose pose = MakePose( float( i ) );
+        TestMotion motion = MakeMotion( 1.0f );
+
+        LegacyAsteroid& asteroid = legacy[i];
+        memcpy( asteroid.pos, pose.Position, sizeof( asteroid.pos ) );
+        memcpy( asteroid.ori, pose.Orientation, sizeof( asteroid.ori ) );
+        memcpy( asteroid.vel, motion.Velocity, sizeof( asteroid.vel ) );
+        memcpy( asteroid.L, motion.AngularVelocity, sizeof( asteroid.L ) );
+        asteroid.boolDraw = true;
+        asteroid.hitCounter = 0;
+
+        world.CreateEntity( pose, motion );
+    }
+
+    double start = Tests::GetSeconds();
+    for ( unsigned int n = 0; n < iterations; n++ )
+    {
+        for ( unsigned int i = 0; i < count; i++ )
+        {
+            LegacyAsteroid& asteroid = legacy[i];
+            for ( int k = 0; k < 4; k++ )
+            {
+                asteroid.pos[k] += asteroid.vel[k] * dt;
+                asteroid.ori[k] += asteroid.L[k] * dt;
+            }
+        }
+    }
+    double legacySeconds = Tests::GetSeconds() - start;
+
+    start = Tests::GetSeconds();
+    for ( unsigned int n = 0; n < iterations; n++ )
+    {
+        world.ForEach<TestPose, TestMotion>( [dt]( TestPose& pose, const TestMotion& motion )
+        {
+            for ( int k = 0; k < 4; k++ )
+            {
+                pose.Position[k] += motion.Velocity[k] * dt;
+                pose.Orientation[k] += motion.AngularVelocity[k] * dt;
+            }
+        } );
+    }
+    double worldSeconds = Tests::GetSeconds() - start;
+
+    // Both paths ran the same arithmetic on the same data.
+    TestPose* last = nullptr;
+    world.ForEach<TestPose>( [&]( TestPose& pose ) { last = &pose; } );
+    CHECK( last && Tests::IsNear( last->Position[0], legacy[count - 1].pos[0], 1e-3 ) );
+
+    wprintf( L"    %u entities: struct array %.3f ms, EntityWorld %.3f ms per update\n",
+             count, legacySeconds * 1000.0 / iterations, worldSeconds * 1000.0 / iterations );
+}
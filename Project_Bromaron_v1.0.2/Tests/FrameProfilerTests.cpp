@@ -0,0 +1,220 @@
+//--------------------------------------------------------------------------------------
+// File: FrameProfilerTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "FrameProfiler.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    const ProfileScopeSummary* FindScope( const std::vector<ProfileScopeSummary>& summary, const char* name )
+    {
+        for ( size_t i = 0; i < summary.size(); i++ )
+        {
+            if ( !strcmp( summary[i].Name, name ) )
+            {
+                return &summary[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    unsigned int CountOccurrences( const std::string& text, const char* pattern )
+    {
+        unsigned int count = 0;
+        for ( size_t at = text.find( pattern ); at != std::string::npos; at = text.find( pattern, at + 1 ) )
+        {
+            count++;
+        }
+
+        return count;
+    }
+}
+
+TEST( FrameProfiler_SummarizesNestedScopes )
+{
+    FrameProfiler::Reset();
+
+    for ( int frame = 0; frame < 10; frame++ )
+    {
+        PROFILE_SCOPE( "TestFrame" );
+        CHECK( FrameProfiler::ThreadDepth() == 1 );
+
+        for ( int i = 0; i < 3; i++ )
+        {
+            PROFILE_SCOPE( "TestInner" );
+            CHECK( FrameProfiler::ThreadDepth() == 2 );
+        }
+    }
+
+    CHECK( FrameProfiler::ThreadDepth() == 0 );
+
+    std::vector<ProfileScopeSummary> summary;
+    FrameProfiler::GetSummary( &summary );
+
+    const ProfileScopeSummary* frame = FindScope( summary, "TestFrame" );
+    const ProfileScopeSummary* inner = FindScope( summary, "TestInner" );
+    CHECK( frame && frame->Count == 10 );
+    CHECK( inner && inner->Count == 30 );
+
+    if ( frame && inner )
+    {
+        CHECK( frame->MeanMilliseconds > 0.0 );
+        CHECK( frame->MeanMilliseconds <= frame->MaxMilliseconds );
+        CHECK( frame->P99Milliseconds <= frame->MaxMilliseconds );
+
+        // Each frame contains three inner scopes.
+        CHECK( frame->MeanMilliseconds * 10 >= inner->MeanMilliseconds * 30 * 0.99 );
+    }
+
+    FrameProfiler::Reset();
+    FrameProfiler::GetSummary( &summary );
+    CHECK( summary.empty() );
+}
+
+TEST( FrameProfiler_ChromeTraceHasEveryThread )
+{
+    FrameProfiler::Reset();
+
+    const unsigned int threadCount = 3;
+    const unsigned int scopesPerThread = 100;
+
+    std::vector<std::thread> threads;
+    for ( unsigned int t = 0; t < threadCount; t++ )
+    {
+        threads.push_back( std::thread( [scopesPerThread]()
+        {
+            for ( unsigned int i = 0; i < scopesPerThread; i++ )
+            {
+                PROFILE_SCOPE( "TestWorker" );
+            }
+        } ) );
+    }
+
+    for ( size_t t = 0; t < threads.size(); t++ )
+    {
+        threads[t].join();
+    }
+
+    std::string trace = FrameProfiler::ExportChromeTrace();
+
+    CHECK( trace.compare( 0, 16, "{\"traceEvents\":[" ) == 0 );
+    CHECK( trace.find( "],\"displayTimeUnit\":\"ms\"}" ) == trace.size() - 25 );
+    CHECK( CountOccurrences( trace, "\"name\":\"TestWorker\",\"ph\":\"X\"" ) == threadCount * scopesPerThread );
+
+    FrameProfiler::Reset();
+}
+
+// Reset while other threads keep recording; every event recorded after the last
+// Reset must still be reported, and none from before it.
+TEST( FrameProfiler_ResetWhileRecording )
+{
+    FrameProfiler::Reset();
+
+    std::atomic<bool> stop( false );
+    std::thread worker( [&stop]()
+    {
+        while ( !stop )
+        {
+            PROFILE_SCOPE( "TestBackground" );
+        }
+    } );
+
+    for ( int i = 0; i < 100; i++ )
+    {
+        FrameProfiler::Reset();
+    }
+
+    stop = true;
+    worker.join();
+    FrameProfiler::Reset();
+
+    {
+        PROFILE_SCOPE( "TestAfterReset" );
+    }
+
+    std::vector<ProfileScopeSummary> summary;
+    FrameProfiler::GetSummary( &summary );
+    CHECK( summary.size() == 1 );
+    CHECK( FindScope( summary, "TestAfterReset" ) != nullptr );
+
+    FrameProfiler::Reset();
+}
+
+// Collect while another thread laps its ring many times over. Its events are
+// one tick long and named after their depth, so a copy torn between two events
+// shows up as a wrong name or a huge duration. Run it under a race checker too;
+// a torn copy needs the writer preempted mid-event to show up here.
+TEST( FrameProfiler_CollectWhileRecording )
+{
+    static const char* const names[] = { "TestTornA", "TestTornB", "TestTornC" };
+
+    FrameProfiler::Reset();
+
+    std::atomic<bool> stop( false );
+    std::atomic<unsigned int> recorded( 0 );
+    std::thread worker( [&stop, &recorded]()
+    {
+        for ( unsigned __int64 n = 0; !stop; n++ )
+        {
+            FrameProfiler::Record( names[n % 3], n * 2, n * 2 + 1, static_cast<unsigned int>( n % 3 ) );
+            recorded++;
+            std::this_thread::yield();
+        }
+    } );
+
+    // Start once the ring is full, so every collection races the writer on the
+    // slots it copies first.
+    while ( recorded < PROFILER_EVENTS_PER_THREAD )
+    {
+        std::this_thread::yield();
+    }
+
+    double maxMilliseconds = 1.5 * 1000.0 / FrameProfiler::GetTicksPerSecond();
+    unsigned int collected = 0;
+    bool intact = true;
+    for ( int i = 0; i < 200; i++ )
+    {
+        std::vector<ProfileScopeSummary> summary;
+        FrameProfiler::GetSummary( &summary );
+
+        unsigned int count = 0;
+        for ( size_t j = 0; j < summary.size(); j++ )
+        {
+            bool known = summary[j].Name == names[0] || summary[j].Name == names[1] || summary[j].Name == names[2];
+            intact = intact && known && summary[j].MaxMilliseconds <= maxMilliseconds;
+            count += summary[j].Count;
+        }
+
+        intact = intact && count <= PROFILER_EVENTS_PER_THREAD;
+        collected += count;
+    }
+
+    stop = true;
+    worker.join();
+    FrameProfiler::Reset();
+
+    CHECK( intact );
+    CHECK( collected > 0 );
+}
+
+// The target is a few tens of nanoseconds per scope in an optimized build. Most of
+// that is the two time stamp counter reads, which cost several times more under
+// some virtual machines, so the result is reported rather than checked.
+BENCHMARK( FrameProfiler_ScopeOverhead )
+{
+    double nanoseconds = FrameProfiler::MeasureScopeOverhead( 1000000 );
+
+    wprintf( L"    %.1f ns per scope, %.0f ticks per second\n", nanoseconds, FrameProfiler::GetTicksPerSecond() );
+}
@@ -0,0 +1,236 @@
+//--------------------------------------------------------------------------------------
+// File: GamepadPollerTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "GamepadPoller.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    long long GetPerformanceCounter()
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter( &counter );
+        return counter.QuadPart;
+    }
+
+    long long GetPerformanceFrequency()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency( &frequency );
+        return frequency.QuadPart;
+    }
+
+    // Controllers whose state the test sets by hand, on a clock the test advances.
+    class ScriptedGamepadSource : public GamepadSource
+    {
+    public:
+        ScriptedGamepadSource() :
+            Now( 0 )
+        {
+            memset( State, 0, sizeof( State ) );
+            memset( IsConnected, 0, sizeof( IsConnected ) );
+        }
+
+        virtual bool GetState( unsigned int controller, GamepadSample* sample ) override
+        {
+            if ( !IsConnected[controller] )
+            {
+                return false;
+            }
+
+            *sample = State[controller];
+            return true;
+        }
+
+        virtual long long GetTimestamp() override           { return Now; }
+        virtual long long GetTimestampFrequency() override  { return 1000; }
+
+        long long       Now;
+        GamepadSample   State[GAMEPAD_POLLER_MAX_CONTROLLERS];
+        bool            IsConnected[GAMEPAD_POLLER_MAX_CONTROLLERS];
+    };
+
+    // One controller whose state is a function of the real clock, so the polling
+    // thread can read it without sharing anything with the test. Both sticks
+    // carry the same value, which lets a reader spot a torn sample.
+    class ClockedGamepadSource : public GamepadSource
+    {
+    public:
+        ClockedGamepadSource() :
+            m_frequency( GetPerformanceFrequency() ),
+            Polls( 0 )
+        {
+        }
+
+        virtual bool GetState( unsigned int, GamepadSample* sample ) override
+        {
+            long long step = GetPerformanceCounter() / ( m_frequency / 10000 );
+
+            memset( sample, 0, sizeof( *sample ) );
+            sample->IsConnected = true;
+            sample->ThumbLX = static_cast<short>( step );
+            sample->ThumbLY = static_cast<short>( step );
+            sample->Buttons = ( step & 1 ) ? 0x1000 : 0;
+            Polls++;
+            return true;
+        }
+
+        virtual long long GetTimestamp() override           { return GetPerformanceCounter(); }
+        virtual long long GetTimestampFrequency() override  { return m_frequency; }
+
+    private:
+        long long       m_frequency;
+
+    public:
+        std::atomic<unsigned int>   Polls;
+    };
+}
+
+// Presses and trigger pulls that start and end between two frames still show up
+// in the frame's interval, and the sticks are averaged over the time held.
+TEST( GamepadPoller_IntervalKeepsShortPresses )
+{
+    ScriptedGamepadSource* source = new ScriptedGamepadSource();
+    source->IsConnected[0] = true;
+    GamepadPoller poller( std::unique_ptr<GamepadSource>( source ), 2 );
+
+    GamepadInterval interval;
+    CHECK( !poller.GetHistory( 0 ).Query( 0, 10, &interval ) );
+
+    source->Now = 0;
+    poller.Poll();
+    source->Now = 5;
+    source->State[0].Buttons = 0x1000;
+    source->State[0].ThumbLX = 1000;
+    poller.Poll();
+    source->Now = 7;
+    source->State[0].Buttons = 0;
+    poller.Poll();
+    source->Now = 8;
+    poller.Poll();
+    source->Now = 10;
+    source->State[0].ThumbLX = 0;
+    source->State[0].RightTrigger = 200;
+    poller.Poll();
+    source->Now = 12;
+    source->State[0].RightTrigger = 0;
+    poller.Poll();
+
+    CHECK( poller.GetHistory( 0 ).Query( 0, 16, &interval ) );
+    CHECK( interval.Changed && interval.LastChange == 12 );
+    CHECK( interval.Pressed == 0x1000 && interval.Released == 0x1000 );
+    CHECK( interval.Latest.Buttons == 0 );
+    CHECK( interval.RightTriggerPeak == 200 );
+    CHECK( Tests::IsNear( interval.ThumbLX, 1000.0 * 5 / 16, 1e-3 ) );
+
+    // Nothing changed after 12.
+    CHECK( poller.GetHistory( 0 ).Query( 12, 16, &interval ) );
+    CHECK( !interval.Changed && interval.Pressed == 0 && interval.ThumbLX == 0.0f );
+
+    // Changes after the end of the interval are ignored.
+    CHECK( poller.GetHistory( 0 ).Query( 0, 6, &interval ) );
+    CHECK( interval.Latest.Buttons == 0x1000 && interval.Pressed == 0x1000 && interval.Released == 0 );
+
+    // The second controller was never connected, which is a state of its own.
+    CHECK( poller.GetHistory( 1 ).Query( 0, 16, &interval ) && !interval.Latest.IsConnected );
+
+    GamepadSample latest;
+    CHECK( poller.GetHistory( 0 ).GetLatest( &latest ) && latest.Timestamp == 12 );
+
+    source->Now = 20;
+    source->State[0].ThumbRY = -32768;
+    poller.Poll();
+    CHECK( poller.GetHistory( 0 ).GetLatest( &latest ) && latest.ThumbRY == -32768 );
+}
+
+// Once the ring wraps, queries reaching further back start at the oldest sample
+// still held.
+TEST( GamepadPoller_HistoryWraps )
+{
+    ScriptedGamepadSource* source = new ScriptedGamepadSource();
+    source->IsConnected[0] = true;
+    GamepadPoller poller( std::unique_ptr<GamepadSource>( source ), 1 );
+
+    for ( int i = 0; i < 1000; i++ )
+    {
+        source->Now = 100 + i;
+        source->State[0].ThumbLY = static_cast<short>( i );
+        poller.Poll();
+    }
+
+    GamepadInterval interval;
+    CHECK( poller.GetHistory( 0 ).Query( 1000, 1099, &interval ) );
+    CHECK( interval.Latest.ThumbLY == 999 );
+    CHECK( Tests::IsNear( interval.ThumbLY, ( 900 + 998 ) / 2.0, 1.0 ) );
+
+    CHECK( poller.GetHistory( 0 ).Query( 0, 1099, &interval ) );
+    CHECK( interval.ThumbLY >= 1000.0f - GAMEPAD_HISTORY_SIZE );
+}
+
+// The game thread queries while the poller thread writes; every sample it reads
+// is whole and time only moves forward.
+TEST( GamepadPoller_ThreadedReadsAreConsistent )
+{
+    ClockedGamepadSource* source = new ClockedGamepadSource();
+    GamepadPoller poller( std::unique_ptr<GamepadSource>( source ), 1 );
+    poller.Start( GAMEPAD_POLLER_DEFAULT_RATE );
+    CHECK( poller.IsRunning() );
+
+    long long from = 0;
+    long long lastTimestamp = 0;
+    unsigned int queries = 0;
+    bool consistent = true;
+
+    double end = Tests::GetSeconds() + 0.3;
+    while ( Tests::GetSeconds() < end )
+    {
+        long long now = poller.GetTimestamp();
+        GamepadInterval interval;
+        if ( poller.GetHistory( 0 ).Query( from, now, &interval ) )
+        {
+            consistent = consistent
+                && interval.Latest.ThumbLX == interval.Latest.ThumbLY
+                && interval.Latest.Timestamp <= now
+                && interval.Latest.Timestamp >= lastTimestamp;
+            lastTimestamp = interval.Latest.Timestamp;
+            queries++;
+        }
+
+        from = now;
+    }
+
+    poller.Stop();
+    CHECK( !poller.IsRunning() );
+    CHECK( consistent );
+    CHECK( queries > 0 );
+    CHECK( source->Polls > 0 );
+}
+
+// How close the polling thread gets to 1000 polls a second.
+BENCHMARK( GamepadPoller_PollRate )
+{
+    ClockedGamepadSource* source = new ClockedGamepadSource();
+    GamepadPoller poller( std::unique_ptr<GamepadSource>( source ), 1 );
+
+    double start = Tests::GetSeconds();
+    poller.Start( GAMEPAD_POLLER_DEFAULT_RATE );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 2100 ) );
+    unsigned int rate = poller.GetPollRate();
+    poller.Stop();
+    double seconds = Tests::GetSeconds() - start;
+
+    wprintf( L"    asked for %u polls per second: %u reported, %.0f measured\n",
+             GAMEPAD_POLLER_DEFAULT_RATE, rate, source->Polls / seconds );
+    CHECK( rate > 0 );
+}
@@ -0,0 +1,279 @@
+//--------------------------------------------------------------------------------------
+// File: InputEventQueueTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "InputEventQueue.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    struct QueueTestEvent
+    {
+        unsigned int    Producer;
+        unsigned int    Sequence;
+        double          Timestamp;
+    };
+
+    // What InputManager did before the queue: a vector of events behind a mutex,
+    // swapped out by the game thread.
+    class MutexEventQueue
+    {
+    public:
+        bool TryPush( const QueueTestEvent& value )
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_events.push_back( value );
+            return true;
+        }
+
+        template<typename Func>
+        unsigned int Drain( Func handler )
+        {
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_draining.swap( m_events );
+            }
+
+            for ( size_t i = 0; i < m_draining.size(); i++ )
+            {
+                handler( m_draining[i] );
+            }
+
+            unsigned int count = static_cast<unsigned int>( m_draining.size() );
+            m_draining.clear();
+            return count;
+        }
+
+        unsigned int GetDroppedCount() const { return 0; }
+
+    private:
+        std::mutex                      m_mutex;
+        std::vector<QueueTestEvent>     m_events;
+        std::vector<QueueTestEvent>     m_draining;
+    };
+
+    struct LatencyResult
+    {
+        double          MeanMicroseconds;
+        double          P99Microseconds;
+        double          PushNanoseconds;
+        unsigned int    Delivered;
+        unsigned int    Dropped;
+    };
+
+    // Producers push timestamped events at a steady rate while the consumer drains
+    // in a loop; latency is push-to-handled.
+    template<typename TQueue>
+    LatencyResult MeasureLatency( TQueue& queue, unsigned int producerCount, unsigned int eventsPerProducer )
+    {
+        std::atomic<unsigned int> running( producerCount );
+        std::atomic<long long> pushTicks( 0 );
+        std::vector<std::thread> producers;
+
+        for ( unsigned int p = 0; p < producerCount; p++ )
+        {
+            producers.push_back( std::thread( [&, p]()
+            {
+                double pushSeconds = 0.0;
+                for ( unsigned int i = 0; i < eventsPerProducer; i++ )
+                {
+                    QueueTestEvent value = { p, i, Tests::GetSeconds() };
+                    queue.TryPush( value );
+                    pushSeconds += Tests::GetSeconds() - value.Timestamp;
+
+                    // Roughly the spacing of pointer moves during a fast drag.
+                    if ( ( i & 63 ) == 63 )
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+
+                pushTicks += static_cast<long long>( pushSeconds * 1e9 );
+                running--;
+            } ) );
+        }
+
+        std::vector<double> latencies;
+        latencies.reserve( producerCount * eventsPerProducer );
+
+        bool more = true;
+        while ( more )
+        {
+            more = running != 0;
+            queue.Drain( [&]( const QueueTestEvent& value )
+            {
+                latencies.push_back( Tests::GetSeconds() - value.Timestamp );
+            } );
+        }
+
+        for ( size_t p = 0; p < producers.size(); p++ )
+        {
+            producers[p].join();
+        }
+
+        queue.Drain( [&]( const QueueTestEvent& value ) { latencies.push_back( Tests::GetSeconds() - value.Timestamp ); } );
+
+        LatencyResult result = {};
+        result.Delivered = static_cast<unsigned int>( latencies.size() );
+        result.Dropped = queue.GetDroppedCount();
+        result.PushNanoseconds = double( pushTicks.load() ) / double( producerCount * eventsPerProducer );
+
+        if ( !latencies.empty() )
+        {
+            std::sort( latencies.begin(), latencies.end() );
+
+            double total = 0.0;
+            for ( size_t i = 0; i < latencies.size(); i++ )
+            {
+                total += latencies[i];
+            }
+
+            result.MeanMicroseconds = total / latencies.size() * 1e6;
+            result.P99Microseconds = latencies[( latencies.size() - 1 ) * 99 / 100] * 1e6;
+        }
+
+        return result;
+    }
+}
+
+TEST( InputEventQueue_FifoAndOverflow )
+{
+    InputEventQueue<unsigned int, 8> queue;
+    CHECK( queue.GetCapacity() == 8 );
+
+    unsigned int value = 0;
+    CHECK( !queue.TryPop( &value ) );
+
+    for ( unsigned int i = 0; i < 8; i++ )
+    {
+        CHECK( queue.TryPush( i ) );
+    }
+    CHECK( !queue.TryPush( 100 ) );
+    CHECK( !queue.TryPush( 101 ) );
+    CHECK( queue.GetDroppedCount() == 2 );
+
+    CHECK( queue.TryPop( &value ) && value == 0 );
+    CHECK( queue.TryPush( 8 ) );
+
+    std::vector<unsigned int> drained;
+    CHECK( queue.Drain( [&]( unsigned int v ) { drained.push_back( v ); } ) == 8 );
+    CHECK( drained.size() == 8 && drained.front() == 1 && drained.back() == 8 );
+
+    // Wraps around the ring many times.
+    for ( unsigned int i = 0; i < 1000; i++ )
+    {
+        queue.TryPush( i );
+        queue.TryPush( i + 1 );
+        CHECK( queue.TryPop( &value ) && value == i );
+        CHECK( queue.TryPop( &value ) && value == i + 1 );
+    }
+    CHECK( queue.GetDroppedCount() == 2 );
+}
+
+// Producer threads hammer a small ring while the consumer drains it. Every event
+// is either delivered or counted as dropped, and each producer's events arrive in
+// the order it pushed them.
+TEST( InputEventQueue_StressManyProducers )
+{
+    const unsigned int producerCount = 4;
+    const unsigned int eventsPerProducer = 200000;
+
+    std::unique_ptr<InputEventQueue<QueueTestEvent, 256>> queue( new InputEventQueue<QueueTestEvent, 256>() );
+    std::atomic<unsigned int> running( producerCount );
+    std::atomic<unsigned int> pushed( 0 );
+    std::vector<std::thread> producers;
+
+    for ( unsigned int p = 0; p < producerCount; p++ )
+    {
+        producers.push_back( std::thread( [&, p]()
+        {
+            unsigned int accepted = 0;
+            for ( unsigned int i = 0; i < eventsPerProducer; i++ )
+            {
+                QueueTestEvent value = { p, i, 0.0 };
+                if ( queue->TryPush( value ) )
+                {
+                    accepted++;
+                }
+            }
+
+            pushed += accepted;
+            running--;
+        } ) );
+    }
+
+    unsigned int lastSequence[producerCount];
+    bool seen[producerCount] = {};
+    bool ordered = true;
+    bool known = true;
+    unsigned int delivered = 0;
+
+    auto handler = [&]( const QueueTestEvent& value )
+    {
+        if ( value.Producer >= producerCount )
+        {
+            known = false;
+            return;
+        }
+
+        if ( seen[value.Producer] && value.Sequence <= lastSequence[value.Producer] )
+        {
+            ordered = false;
+        }
+
+        seen[value.Producer] = true;
+        lastSequence[value.Producer] = value.Sequence;
+        delivered++;
+    };
+
+    bool more = true;
+    while ( more )
+    {
+        more = running != 0;
+        queue->Drain( handler );
+    }
+
+    for ( size_t p = 0; p < producers.size(); p++ )
+    {
+        producers[p].join();
+    }
+
+    queue->Drain( handler );
+
+    CHECK( known );
+    CHECK( ordered );
+    CHECK( delivered == pushed );
+    CHECK( delivered + queue->GetDroppedCount() == producerCount * eventsPerProducer );
+}
+
+// Push-to-handled latency and producer-side push cost, against the mutex-guarded
+// vector the queue replaced.
+BENCHMARK( InputEventQueue_LatencyVsMutex )
+{
+    const unsigned int producerCount = 2;
+    const unsigned int eventsPerProducer = 200000;
+
+    std::unique_ptr<InputEventQueue<QueueTestEvent, 1024>> ring( new InputEventQueue<QueueTestEvent, 1024>() );
+    LatencyResult lockFree = MeasureLatency( *ring, producerCount, eventsPerProducer );
+
+    MutexEventQueue locked;
+    LatencyResult mutex = MeasureLatency( locked, producerCount, eventsPerProducer );
+
+    wprintf( L"    lock-free: mean %.2f us, p99 %.2f us, push %.0f ns, %u delivered, %u dropped\n",
+             lockFree.MeanMicroseconds, lockFree.P99Microseconds, lockFree.PushNanoseconds, lockFree.Delivered, lockFree.Dropped );
+    wprintf( L"    mutex:     mean %.2f us, p99 %.2f us, push %.0f ns, %u delivered\n",
+             mutex.MeanMicroseconds, mutex.P99Microseconds, mutex.PushNanoseconds, mutex.Delivered );
+
+    CHECK( lockFree.Delivered + lockFree.Dropped == producerCount * eventsPerProducer );
+    CHECK( mutex.Delivered == producerCount * eventsPerProducer );
+}
@@ -0,0 +1,245 @@
+//--------------------------------------------------------------------------------------
+// File: InputLatencyTrackerTests.cpp
+//
+// The tracker is driven by a synthetic clock counting microseconds, so every
+// latency below is exact.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "InputLatencyTracker.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    const long long MicrosecondsPerSecond = 1000000;
+}
+
+TEST( InputLatencyTracker_CountsEachStampOnce )
+{
+    long long now = 0;
+    InputLatencyTracker tracker( [&now]() { return now; }, MicrosecondsPerSecond );
+
+    // The same held input is seen on two frames; unstamped input is ignored.
+    now = 5000;
+    tracker.RecordSimulation( 2000 );
+    tracker.RecordSimulation( 2000 );
+    tracker.RecordSimulation( 0 );
+
+    now = 9000;
+    tracker.RecordSubmit();
+    tracker.RecordSubmit();
+
+    InputLatencyStats simulation;
+    InputLatencyStats submit;
+    tracker.GetEventToSimulation( &simulation );
+    tracker.GetSimulationToSubmit( &submit );
+
+    CHECK( simulation.Count == 1 );
+    CHECK( Tests::IsNear( simulation.MeanMilliseconds, 3.0, 1e-9 ) );
+    CHECK( simulation.Histogram[2] == 1 );
+    CHECK( submit.Count == 1 );
+    CHECK( Tests::IsNear( submit.MeanMilliseconds, 4.0, 1e-9 ) );
+    CHECK( submit.Histogram[3] == 1 );
+
+    // An older, distinct input simulated later still counts; the held one
+    // seen again doesn't.
+    now = 10000;
+    tracker.RecordSimulation( 1000 );
+    tracker.RecordSimulation( 2000 );
+    tracker.GetEventToSimulation( &simulation );
+    CHECK( simulation.Count == 2 );
+    CHECK( Tests::IsNear( simulation.MaxMilliseconds, 9.0, 1e-9 ) );
+
+    tracker.Reset();
+    tracker.GetEventToSimulation( &simulation );
+    tracker.GetSimulationToSubmit( &submit );
+    CHECK( simulation.Count == 0 && simulation.MeanMilliseconds == 0.0 && simulation.MaxMilliseconds == 0.0 );
+    CHECK( submit.Count == 0 );
+
+    // After Reset the same stamp counts again.
+    tracker.RecordSimulation( 2000 );
+    tracker.GetEventToSimulation( &simulation );
+    CHECK( simulation.Count == 1 );
+}
+
+TEST( InputLatencyTracker_HistogramBuckets )
+{
+    CHECK( InputLatencyTracker::GetBucketLowerBound( 0 ) == 0.0 );
+    CHECK( InputLatencyTracker::GetBucketLowerBound( 1 ) == 1.0 );
+    CHECK( InputLatencyTracker::GetBucketLowerBound( 4 ) == 8.0 );
+
+    long long now = 0;
+    InputLatencyTracker tracker( [&now]() { return now; }, MicrosecondsPerSecond );
+
+    // Latencies in microseconds, and the bucket each one lands in.
+    const long long latencies[] = { 500, 1000, 1999, 2000, 16667, 127999, 128000, 5000000 };
+    const unsigned int buckets[] = { 0, 1, 1, 2, 5, 7, 8, 8 };
+
+    long long stamp = 1;
+    for ( unsigned int i = 0; i < ARRAYSIZE( latencies ); i++ )
+    {
+        stamp += 10000000;
+        now = stamp + latencies[i];
+        tracker.RecordSimulation( stamp );
+    }
+
+    unsigned int expected[INPUT_LATENCY_BUCKETS] = {};
+    for ( unsigned int i = 0; i < ARRAYSIZE( buckets ); i++ )
+    {
+        expected[buckets[i]]++;
+    }
+
+    InputLatencyStats stats;
+    tracker.GetEventToSimulation( &stats );
+    CHECK( stats.Count == ARRAYSIZE( latencies ) );
+    CHECK( Tests::IsNear( stats.MaxMilliseconds, 5000.0, 1e-9 ) );
+    CHECK( memcmp( stats.Histogram, expected, sizeof( expected ) ) == 0 );
+}
+
+// The game visits held actions in map order, not arrival order. Every distinct
+// input counts once, whatever order each frame reports them in, for as many
+// inputs held at once as the tracker remembers.
+TEST( InputLatencyTracker_UnorderedStamps )
+{
+    long long now = 0;
+    InputLatencyTracker tracker( [&now]() { return now; }, MicrosecondsPerSecond );
+
+    std::mt19937 random( 1 );
+    std::vector<long long> held;
+    unsigned int distinct = 0;
+    for ( unsigned int frame = 1; frame <= 100; frame++ )
+    {
+        now = frame * 10000;
+
+        // Release some inputs, press some new ones, all stamped during the
+        // frame just gone.
+        for ( size_t i = held.size(); i-- > 0; )
+        {
+            if ( random() % 4 == 0 )
+            {
+                held.erase( held.begin() + i );
+            }
+        }
+
+        while ( held.size() < INPUT_LATENCY_RECENT_STAMPS && random() % 3 != 0 )
+        {
+            held.push_back( now - 1 - static_cast<long long>( distinct % 9999 ) );
+            distinct++;
+        }
+
+        std::shuffle( held.begin(), held.end(), random );
+        for ( size_t i = 0; i < held.size(); i++ )
+        {
+            tracker.RecordSimulation( held[i] );
+        }
+    }
+
+    InputLatencyStats simulation;
+    tracker.GetEventToSimulation( &simulation );
+    CHECK( distinct > INPUT_LATENCY_RECENT_STAMPS );
+    CHECK( simulation.Count == distinct );
+    CHECK( simulation.MaxMilliseconds < 10.0 );
+
+    // Past that many, the stamp seen longest ago is forgotten and would count
+    // again.
+    tracker.Reset();
+    for ( long long stamp = 1; stamp <= INPUT_LATENCY_RECENT_STAMPS + 1; stamp++ )
+    {
+        tracker.RecordSimulation( stamp );
+    }
+
+    tracker.RecordSimulation( 2 );
+    tracker.GetEventToSimulation( &simulation );
+    CHECK( simulation.Count == INPUT_LATENCY_RECENT_STAMPS + 1 );
+    tracker.RecordSimulation( 1 );
+    tracker.GetEventToSimulation( &simulation );
+    CHECK( simulation.Count == INPUT_LATENCY_RECENT_STAMPS + 2 );
+}
+
+// More inputs simulated between two submits than the tracker keeps pending: all
+// of them count for event->sim, and the first INPUT_LATENCY_MAX_PENDING for
+// sim->submit.
+TEST( InputLatencyTracker_PendingOverflow )
+{
+    long long now = 0;
+    InputLatencyTracker tracker( [&now]() { return now; }, MicrosecondsPerSecond );
+
+    const unsigned int inputCount = INPUT_LATENCY_MAX_PENDING + 8;
+    for ( unsigned int i = 0; i < inputCount; i++ )
+    {
+        now = 1000 * ( i + 1 );
+        tracker.RecordSimulation( now - 100 );
+    }
+
+    now += 1000;
+    tracker.RecordSubmit();
+
+    InputLatencyStats simulation;
+    InputLatencyStats submit;
+    tracker.GetEventToSimulation( &simulation );
+    tracker.GetSimulationToSubmit( &submit );
+    CHECK( simulation.Count == inputCount );
+    CHECK( submit.Count == INPUT_LATENCY_MAX_PENDING );
+
+    // The next submit starts from an empty list.
+    now += 1000;
+    tracker.RecordSubmit();
+    tracker.GetSimulationToSubmit( &submit );
+    CHECK( submit.Count == INPUT_LATENCY_MAX_PENDING );
+}
+
+// A 60 Hz loop on the synthetic clock: input arrives evenly through each frame,
+// is simulated at the start of the next one, and the frame is submitted 4 ms
+// later. Event->sim is then never more than a frame, and sim->submit always 4 ms.
+TEST( InputLatencyTracker_SimulatedFrameLoop )
+{
+    const long long frameTicks = MicrosecondsPerSecond / 60;
+    const long long submitTicks = 4000;
+    const unsigned int frameCount = 600;
+    const unsigned int inputsPerFrame = 4;
+
+    long long now = 0;
+    InputLatencyTracker tracker( [&now]() { return now; }, MicrosecondsPerSecond );
+
+    double expectedTotal = 0.0;
+    for ( unsigned int frame = 1; frame <= frameCount; frame++ )
+    {
+        long long frameStart = frame * frameTicks;
+        now = frameStart;
+
+        for ( unsigned int i = 0; i < inputsPerFrame; i++ )
+        {
+            long long stamp = frameStart - frameTicks + ( frameTicks * i ) / inputsPerFrame + 1;
+            tracker.RecordSimulation( stamp );
+            expectedTotal += double( frameStart - stamp ) / 1000.0;
+        }
+
+        now = frameStart + submitTicks;
+        tracker.RecordSubmit();
+    }
+
+    InputLatencyStats simulation;
+    InputLatencyStats submit;
+    tracker.GetEventToSimulation( &simulation );
+    tracker.GetSimulationToSubmit( &submit );
+
+    CHECK( simulation.Count == frameCount * inputsPerFrame );
+    CHECK( Tests::IsNear( simulation.MeanMilliseconds, expectedTotal / simulation.Count, 1e-6 ) );
+    CHECK( simulation.MaxMilliseconds <= frameTicks / 1000.0 );
+
+    CHECK( submit.Count == frameCount * inputsPerFrame );
+    CHECK( Tests::IsNear( submit.MeanMilliseconds, 4.0, 1e-9 ) );
+    CHECK( submit.Histogram[3] == submit.Count );
+
+    wprintf( L"    event->sim mean %.2f ms, max %.2f ms; sim->submit mean %.2f ms\n",
+             simulation.MeanMilliseconds, simulation.MaxMilliseconds, submit.MeanMilliseconds );
+}
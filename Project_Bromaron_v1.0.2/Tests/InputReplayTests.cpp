@@ -0,0 +1,484 @@
+//--------------------------------------------------------------------------------------
+// File: InputReplayTests.cpp
+//
+// Sessions are recorded from random actions against a stand-in simulation
+// whose state checksum folds in every action it applies, the way the game's
+// scene checksum does.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "InputReplay.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    const unsigned int TestSeed = 1234;
+    const unsigned long long TestTargetElapsedTicks = 166666;
+
+    const wchar_t TestLogName[] = L"InputReplayTests.bril";
+    const wchar_t TestCsvName[] = L"InputReplayTests.csv";
+
+    // Float fields, as the log orders them.
+    float PlayerInputData::* const FloatFields[] =
+    {
+        &PlayerInputData::NormalizedInputValue,
+        &PlayerInputData::X,
+        &PlayerInputData::Y,
+        &PlayerInputData::Roll,
+        &PlayerInputData::Pitch,
+        &PlayerInputData::Yaw,
+        &PlayerInputData::laserPitch,
+        &PlayerInputData::laserYaw,
+        &PlayerInputData::PointerRawX,
+        &PlayerInputData::PointerRawY,
+        &PlayerInputData::PointerThrowX,
+        &PlayerInputData::PointerThrowY,
+    };
+
+    // An action with each float set about a third of the time, the rest zero.
+    PlayerInputData MakeAction( std::mt19937& random )
+    {
+        PlayerInputData action;
+        action.ID = random() % 4;
+        action.PlayerAction = static_cast<PLAYER_ACTION_TYPES>( random() % ( INPUT_WEAPON_THREE + 1 ) );
+        action.IsTouchAction = ( random() % 2 ) != 0;
+        action.isFiring = ( random() % 2 ) != 0;
+        action.firetype = static_cast<int>( random() % 5 ) - 2;
+        action.Timestamp = 0;
+
+        for ( size_t f = 0; f < ARRAYSIZE( FloatFields ); f++ )
+        {
+            action.*FloatFields[f] = ( random() % 3 == 0 ) ? std::uniform_real_distribution<float>( -1.f, 1.f )( random ) : 0.f;
+        }
+
+        return action;
+    }
+
+    bool SameAction( const PlayerInputData& a, const PlayerInputData& b )
+    {
+        bool same = a.ID == b.ID && a.PlayerAction == b.PlayerAction && a.IsTouchAction == b.IsTouchAction &&
+                    a.isFiring == b.isFiring && a.firetype == b.firetype;
+        for ( size_t f = 0; f < ARRAYSIZE( FloatFields ); f++ )
+        {
+            same = same && ( a.*FloatFields[f] == b.*FloatFields[f] );
+        }
+
+        return same;
+    }
+
+    // Stands in for the scene: its state is a hash of every action applied so far.
+    struct StandInSimulation
+    {
+        StandInSimulation() : State( 2166136261u ) {}
+
+        void Apply( const PlayerInputData* actions, unsigned int count )
+        {
+            for ( unsigned int i = 0; i < count; i++ )
+            {
+                State = ( State ^ ( actions[i].ID + 1 ) ) * 16777619u;
+                State = ( State ^ actions[i].PlayerAction ) * 16777619u;
+                for ( size_t f = 0; f < ARRAYSIZE( FloatFields ); f++ )
+                {
+                    unsigned int bits;
+                    memcpy( &bits, &( actions[i].*FloatFields[f] ), sizeof( bits ) );
+                    State = ( State ^ bits ) * 16777619u;
+                }
+            }
+
+            State = ( State ^ count ) * 16777619u;
+        }
+
+        unsigned int State;
+    };
+
+    // A recorded session: the actions of every tick and the checksum recorded
+    // with it, taken before the tick's actions are applied as the game does.
+    struct Session
+    {
+        std::vector<std::vector<PlayerInputData>>   Ticks;
+        std::vector<unsigned int>                   Checksums;
+    };
+
+    Session RecordSession( InputRecorder& recorder, std::mt19937& random, unsigned int tickCount )
+    {
+        Session session;
+        StandInSimulation simulation;
+
+        recorder.Begin( TestSeed, TestTargetElapsedTicks );
+        for ( unsigned int t = 0; t < tickCount; t++ )
+        {
+            std::vector<PlayerInputData> actions( random() % 4 );
+            for ( size_t i = 0; i < actions.size(); i++ )
+            {
+                actions[i] = MakeAction( random );
+            }
+
+            recorder.RecordTick( simulation.State, actions.data(), static_cast<unsigned int>( actions.size() ) );
+            session.Ticks.push_back( actions );
+            session.Checksums.push_back( simulation.State );
+            simulation.Apply( actions.data(), static_cast<unsigned int>( actions.size() ) );
+        }
+
+        return session;
+    }
+
+    std::vector<unsigned char> ReadTestFile( const wchar_t* name )
+    {
+        std::vector<unsigned char> data;
+        FILE* file = nullptr;
+        if ( _wfopen_s( &file, name, L"rb" ) == 0 && file )
+        {
+            unsigned char chunk[4096];
+            for ( size_t read; ( read = fread( chunk, 1, sizeof( chunk ), file ) ) > 0; )
+            {
+                data.insert( data.end(), chunk, chunk + read );
+            }
+
+            fclose( file );
+        }
+
+        return data;
+    }
+
+    bool WriteTestFile( const wchar_t* name, const std::vector<unsigned char>& data, size_t bytes )
+    {
+        FILE* file = nullptr;
+        if ( _wfopen_s( &file, name, L"wb" ) != 0 || !file )
+        {
+            return false;
+        }
+
+        bool written = ( bytes == 0 ) || ( fwrite( data.data(), 1, bytes, file ) == bytes );
+        fclose( file );
+        return written;
+    }
+
+    bool IsEmpty( const InputReplay& replay )
+    {
+        return replay.GetTickCount() == 0 && replay.GetSeed() == 0 && replay.GetTargetElapsedTicks() == 0 && replay.IsFinished();
+    }
+}
+
+// Every tick's actions and checksum come back from the file as recorded, and a
+// rewound replay plays the same again.
+TEST( InputReplay_RoundTrip )
+{
+    std::mt19937 random( 1 );
+    InputRecorder recorder;
+    CHECK( !recorder.IsRecording() );
+
+    Session session = RecordSession( recorder, random, 600 );
+    CHECK( recorder.IsRecording() && recorder.GetTickCount() == 600 );
+    CHECK( recorder.Save( TestLogName ) );
+
+    InputReplay replay;
+    CHECK( replay.Load( TestLogName ) );
+    CHECK( replay.GetSeed() == TestSeed && replay.GetTargetElapsedTicks() == TestTargetElapsedTicks );
+    CHECK( replay.GetTickCount() == 600 && replay.GetTicksPlayed() == 0 && !replay.IsFinished() );
+
+    for ( int pass = 0; pass < 2; pass++ )
+    {
+        bool same = true;
+        for ( size_t t = 0; t < session.Ticks.size(); t++ )
+        {
+            PlayerInputData actions[8];
+            unsigned int count = 99;
+            unsigned int checksum = 0;
+            same = same && replay.NextTick( actions, ARRAYSIZE( actions ), &count, &checksum );
+            same = same && count == session.Ticks[t].size() && checksum == session.Checksums[t];
+            for ( unsigned int i = 0; same && i < count; i++ )
+            {
+                same = SameAction( actions[i], session.Ticks[t][i] ) && actions[i].Timestamp == 0;
+            }
+        }
+
+        CHECK( same );
+        CHECK( replay.IsFinished() && replay.GetTicksPlayed() == 600 );
+
+        PlayerInputData action;
+        unsigned int count = 99;
+        unsigned int checksum = 99;
+        CHECK( !replay.NextTick( &action, 1, &count, &checksum ) && count == 0 && checksum == 0 );
+
+        replay.Rewind();
+    }
+
+    // With room for fewer actions than a tick holds, the extras are skipped and
+    // the next tick still lines up.
+    bool inStep = true;
+    for ( size_t t = 0; t < session.Ticks.size(); t++ )
+    {
+        PlayerInputData action;
+        unsigned int count = 0;
+        unsigned int checksum = 0;
+        replay.NextTick( &action, 1, &count, &checksum );
+        inStep = inStep && checksum == session.Checksums[t] && count == std::min<size_t>( 1, session.Ticks[t].size() );
+        inStep = inStep && ( count == 0 || SameAction( action, session.Ticks[t][0] ) );
+    }
+
+    CHECK( inStep );
+
+    // Recording carries on after a save; End stops it.
+    unsigned int before = recorder.GetTickCount();
+    recorder.RecordTick( 0, nullptr, 0 );
+    recorder.End();
+    recorder.RecordTick( 0, nullptr, 0 );
+    CHECK( !recorder.IsRecording() && recorder.GetTickCount() == before + 1 );
+
+    _wremove( TestLogName );
+}
+
+// A log that is missing, cut short anywhere, or has a bad header loads as
+// nothing, even over a replay that had a log loaded.
+TEST( InputReplay_RejectsDamagedLogs )
+{
+    std::mt19937 random( 2 );
+    InputRecorder recorder;
+    RecordSession( recorder, random, 20 );
+    CHECK( recorder.Save( TestLogName ) );
+
+    std::vector<unsigned char> log = ReadTestFile( TestLogName );
+    CHECK( log.size() > 24 );
+
+    InputReplay replay;
+    CHECK( replay.Load( TestLogName ) );
+
+    _wremove( TestLogName );
+    CHECK( !replay.Load( TestLogName ) && IsEmpty( replay ) );
+
+    // Every length short of the whole log.
+    bool rejected = true;
+    for ( size_t bytes = 0; bytes < log.size(); bytes++ )
+    {
+        CHECK( WriteTestFile( TestLogName, log, bytes ) );
+        rejected = rejected && !replay.Load( TestLogName ) && IsEmpty( replay );
+    }
+
+    CHECK( rejected );
+
+    // A wrong magic or version, and a zero timer step (the step's high half is
+    // already zero).
+    const size_t offsets[] = { 0, 4, 16 };
+    const unsigned int values[] = { INPUT_LOG_MAGIC + 1, INPUT_LOG_VERSION - 1, 0 };
+    for ( size_t i = 0; i < ARRAYSIZE( offsets ); i++ )
+    {
+        std::vector<unsigned char> damaged( log );
+        memcpy( &damaged[offsets[i]], &values[i], sizeof( values[i] ) );
+        CHECK( WriteTestFile( TestLogName, damaged, damaged.size() ) );
+        CHECK( !replay.Load( TestLogName ) && IsEmpty( replay ) );
+    }
+
+    // A tick count claiming more ticks than the file holds.
+    std::vector<unsigned char> overcounted( log );
+    overcounted[12]++;
+    CHECK( WriteTestFile( TestLogName, overcounted, overcounted.size() ) );
+    CHECK( !replay.Load( TestLogName ) && IsEmpty( replay ) );
+
+    CHECK( WriteTestFile( TestLogName, log, log.size() ) );
+    CHECK( replay.Load( TestLogName ) && replay.GetTickCount() == 20 );
+
+    _wremove( TestLogName );
+}
+
+// A recording stops at INPUT_LOG_MAX_BYTES, ending on a whole tick, and what was
+// kept still saves and loads.
+TEST( InputRecorder_StopsAtCapacity )
+{
+    std::mt19937 random( 3 );
+
+    // Eight actions with every float set, the most a tick costs here.
+    PlayerInputData actions[8];
+    for ( size_t i = 0; i < ARRAYSIZE( actions ); i++ )
+    {
+        actions[i] = MakeAction( random );
+        for ( size_t f = 0; f < ARRAYSIZE( FloatFields ); f++ )
+        {
+            actions[i].*FloatFields[f] = 0.5f;
+        }
+    }
+
+    const size_t tickBytes = 6 + ARRAYSIZE( actions ) * ( 6 + ARRAYSIZE( FloatFields ) * sizeof( float ) );
+
+    InputRecorder recorder;
+    recorder.Begin( TestSeed, TestTargetElapsedTicks );
+    unsigned int calls = 0;
+    while ( recorder.IsRecording() && calls < INPUT_LOG_MAX_BYTES )
+    {
+        recorder.RecordTick( calls, actions, ARRAYSIZE( actions ) );
+        calls++;
+    }
+
+    unsigned int ticks = recorder.GetTickCount();
+    CHECK( !recorder.IsRecording() && ticks == calls - 1 );
+    CHECK( ticks == INPUT_LOG_MAX_BYTES / tickBytes );
+
+    recorder.RecordTick( 0, actions, 1 );
+    CHECK( recorder.GetTickCount() == ticks );
+
+    CHECK( recorder.Save( TestLogName ) );
+    CHECK( ReadTestFile( TestLogName ).size() == 24 + ticks * tickBytes );
+
+    InputReplay replay;
+    CHECK( replay.Load( TestLogName ) && replay.GetTickCount() == ticks );
+
+    bool same = true;
+    for ( unsigned int t = 0; t < ticks; t++ )
+    {
+        PlayerInputData played[8];
+        unsigned int count = 0;
+        unsigned int checksum = 0;
+        replay.NextTick( played, ARRAYSIZE( played ), &count, &checksum );
+        same = same && checksum == t && count == ARRAYSIZE( actions ) && SameAction( played[7], actions[7] );
+    }
+
+    CHECK( same && replay.IsFinished() );
+
+    // Begin starts a fresh log.
+    recorder.Begin( TestSeed + 1, TestTargetElapsedTicks );
+    CHECK( recorder.IsRecording() && recorder.GetTickCount() == 0 );
+
+    _wremove( TestLogName );
+}
+
+// Replaying a log against the simulation the way the game loop does: the
+// checksum before each tick is compared with the recorded one, and a frame
+// whose simulation drifted counts a desync on every tick from there on.
+TEST( InputReplay_CountsDesyncs )
+{
+    std::mt19937 random( 4 );
+    InputRecorder recorder;
+    RecordSession( recorder, random, 300 );
+    CHECK( recorder.Save( TestLogName ) );
+
+    InputReplay replay;
+    CHECK( replay.Load( TestLogName ) );
+
+    const unsigned int driftTicks[] = { 0xFFFFFFFF, 200 };
+    for ( size_t run = 0; run < ARRAYSIZE( driftTicks ); run++ )
+    {
+        replay.Rewind();
+        StandInSimulation simulation;
+        unsigned int desyncs = 0;
+
+        PlayerInputData actions[INPUT_MAX_PLAYER_ACTIONS];
+        unsigned int count;
+        unsigned int recordedChecksum;
+        for ( unsigned int tick = 0; replay.NextTick( actions, INPUT_MAX_PLAYER_ACTIONS, &count, &recordedChecksum ); tick++ )
+        {
+            if ( simulation.State != recordedChecksum )
+            {
+                desyncs++;
+            }
+
+            if ( tick == driftTicks[run] )
+            {
+                actions[0].X += 0.25f;
+                count = std::max( count, 1u );
+            }
+
+            simulation.Apply( actions, count );
+        }
+
+        CHECK( desyncs == ( ( run == 0 ) ? 0u : 300 - 201u ) );
+    }
+
+    _wremove( TestLogName );
+}
+
+TEST( InputReplay_WritesTimingCsv )
+{
+    std::vector<ReplayFrameTiming> timings;
+    for ( unsigned int i = 0; i < 50; i++ )
+    {
+        ReplayFrameTiming timing;
+        timing.UpdateMilliseconds = 0.125f * i;
+        timing.RenderMilliseconds = 16.5f + i;
+        timing.Desyncs = i / 10;
+        timing.Allocations = i * 3;
+        timings.push_back( timing );
+    }
+
+    CHECK( InputReplay::WriteTimingCsv( TestCsvName, timings ) );
+
+    std::vector<unsigned char> data = ReadTestFile( TestCsvName );
+    std::string csv( data.begin(), data.end() );
+    CHECK( csv.compare( 0, 41, "frame,update_ms,render_ms,desyncs,allocs\n" ) == 0 );
+
+    bool rowsMatch = true;
+    unsigned int rows = 0;
+    for ( size_t at = csv.find( '\n' ) + 1; at < csv.size(); at = csv.find( '\n', at ) + 1 )
+    {
+        unsigned int frame, desyncs, allocs;
+        float update, render;
+        rowsMatch = rowsMatch && sscanf_s( csv.c_str() + at, "%u,%f,%f,%u,%u", &frame, &update, &render, &desyncs, &allocs ) == 5;
+        rowsMatch = rowsMatch && frame == rows && update == timings[rows].UpdateMilliseconds && render == timings[rows].RenderMilliseconds;
+        rowsMatch = rowsMatch && desyncs == timings[rows].Desyncs && allocs == timings[rows].Allocations;
+        rows++;
+    }
+
+    CHECK( rowsMatch && rows == timings.size() );
+
+    // Just the header for no frames; false where the file can't be created.
+    CHECK( InputReplay::WriteTimingCsv( TestCsvName, std::vector<ReplayFrameTiming>() ) );
+    CHECK( ReadTestFile( TestCsvName ).size() == 41 );
+    CHECK( !InputReplay::WriteTimingCsv( L"Missing/InputReplayTests.csv", timings ) );
+
+    _wremove( TestCsvName );
+}
+
+// Recording cost per tick and log bytes per tick for typical play, and how fast
+// a log loads and plays back.
+BENCHMARK( InputReplay_RecordAndPlay )
+{
+    std::mt19937 random( 5 );
+    const unsigned int tickCount = 216000;
+
+    std::vector<std::vector<PlayerInputData>> ticks( 1000 );
+    for ( size_t t = 0; t < ticks.size(); t++ )
+    {
+        ticks[t].resize( random() % 3 );
+        for ( size_t i = 0; i < ticks[t].size(); i++ )
+        {
+            ticks[t][i] = MakeAction( random );
+        }
+    }
+
+    InputRecorder recorder;
+    double start = Tests::GetSeconds();
+    recorder.Begin( TestSeed, TestTargetElapsedTicks );
+    for ( unsigned int t = 0; t < tickCount; t++ )
+    {
+        const std::vector<PlayerInputData>& actions = ticks[t % ticks.size()];
+        recorder.RecordTick( t, actions.data(), static_cast<unsigned int>( actions.size() ) );
+    }
+
+    double recordSeconds = Tests::GetSeconds() - start;
+    CHECK( recorder.GetTickCount() == tickCount && recorder.Save( TestLogName ) );
+
+    InputReplay replay;
+    start = Tests::GetSeconds();
+    CHECK( replay.Load( TestLogName ) );
+    double loadSeconds = Tests::GetSeconds() - start;
+
+    start = Tests::GetSeconds();
+    PlayerInputData actions[INPUT_MAX_PLAYER_ACTIONS];
+    unsigned int count;
+    unsigned int checksum;
+    while ( replay.NextTick( actions, INPUT_MAX_PLAYER_ACTIONS, &count, &checksum ) ) {}
+    double playSeconds = Tests::GetSeconds() - start;
+
+    size_t logBytes = ReadTestFile( TestLogName ).size();
+    _wremove( TestLogName );
+
+    wprintf( L"    %u ticks (an hour at 60 Hz): %.1f bytes per tick; record %.0f ns, play %.0f ns per tick; load %.2f ms\n",
+             tickCount, double( logBytes ) / tickCount, recordSeconds * 1e9 / tickCount, playSeconds * 1e9 / tickCount, loadSeconds * 1e3 );
+}
@@ -0,0 +1,194 @@
+//--------------------------------------------------------------------------------------
+// File: MemoryArenaTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "MemoryArena.h"
+#include "AllocationTracker.h"
+#include "EntityWorld.h"
+#include "FrameProfiler.h"
+#include "TransformHierarchy.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    struct SteadyPose
+    {
+        float Position[4];
+    };
+
+    struct SteadyLifetime
+    {
+        unsigned int FramesLeft;
+    };
+}
+
+TEST( LinearArena_AlignsAndResets )
+{
+    LinearArena arena( 1024 );
+    CHECK( arena.GetCapacity() == 1024 );
+
+    void* a = arena.Allocate( 3 );
+    void* b = arena.Allocate( 8, 64 );
+    CHECK( reinterpret_cast<size_t>( a ) % ARENA_MIN_ALIGNMENT == 0 );
+    CHECK( reinterpret_cast<size_t>( b ) % 64 == 0 );
+    CHECK( b > a );
+
+    size_t marker = arena.GetMarker();
+    {
+        ScopedArena scoped( arena );
+        scoped.AllocateArray<float>( 100 );
+        CHECK( arena.GetUsed() >= marker + 400 );
+    }
+    CHECK( arena.GetUsed() == marker );
+
+    size_t peak = arena.GetPeak();
+    arena.Reset();
+    CHECK( arena.GetUsed() == 0 );
+    CHECK( arena.GetPeak() == peak );
+    CHECK( arena.Allocate( 1 ) == a );
+}
+
+TEST( LinearArena_ThrowsWhenFull )
+{
+    LinearArena arena( 256 );
+    arena.Allocate( 200 );
+
+    bool threw = false;
+    try
+    {
+        arena.Allocate( 100 );
+    }
+    catch ( Platform::OutOfMemoryException* e )
+    {
+        threw = true;
+        delete e;
+    }
+
+    CHECK( threw );
+    CHECK( arena.GetUsed() <= arena.GetCapacity() );
+}
+
+TEST( BlockPool_ReusesFreedBlocks )
+{
+    BlockPool pool( 40, 4 );
+    CHECK( pool.GetBlockSize() == 48 );
+
+    void* blocks[5];
+    for ( int i = 0; i < 5; i++ )
+    {
+        blocks[i] = pool.Allocate();
+    }
+    CHECK( pool.GetBlocksInUse() == 5 );
+    CHECK( pool.GetBlockCount() == 8 );
+
+    pool.Free( blocks[2] );
+    CHECK( pool.Allocate() == blocks[2] );
+    CHECK( pool.GetBlockCount() == 8 );
+
+    for ( int i = 0; i < 5; i++ )
+    {
+        pool.Free( blocks[i] );
+    }
+    CHECK( pool.GetBlocksInUse() == 0 );
+}
+
+// A frame of the work the game loop does through these helpers: reset the frame
+// arena and take the spline points from it, spawn and expire short-lived
+// entities, move everything, rebuild the transform hierarchy, under profiler
+// scopes. Once the first frames have sized the pools, a frame makes no heap
+// allocations at all.
+TEST( SteadyStateFrame_MakesNoHeapAllocations )
+{
+    if ( !AllocationTracker::IsEnabled() )
+    {
+        wprintf( L"    skipped: ALLOCATION_TRACKING is off\n" );
+        return;
+    }
+
+    LinearArena frameArena( FRAME_ARENA_BYTES );
+    EntityWorld world;
+    TransformHierarchy hierarchy;
+
+    TransformNode camera = hierarchy.AddNode();
+    TransformNode laser = hierarchy.AddNode( camera );
+    hierarchy.AddNode( laser );
+
+    for ( unsigned int i = 0; i < 1000; i++ )
+    {
+        SteadyPose pose = { { float( i ), 0.0f, 0.0f, 1.0f } };
+        world.CreateEntity( pose );
+    }
+
+    std::vector<Entity> shots;
+    shots.reserve( 64 );
+
+    const unsigned int warmupFrames = 30;
+    const unsigned int frameCount = 300;
+    unsigned int allocatingFrames = 0;
+
+    for ( unsigned int frame = 0; frame < warmupFrames + frameCount; frame++ )
+    {
+        AllocationTracker::BeginFrame();
+        if ( frame > warmupFrames && AllocationTracker::GetLastFrameAllocationCount() != 0 )
+        {
+            allocatingFrames++;
+        }
+
+        PROFILE_SCOPE( "Frame" );
+
+        frameArena.Reset();
+        XMFLOAT4* spline = frameArena.AllocateArray<XMFLOAT4>( 64 );
+        for ( unsigned int i = 0; i < 64; i++ )
+        {
+            spline[i] = XMFLOAT4( float( i ), float( frame ), 0.0f, 1.0f );
+        }
+
+        {
+            PROFILE_SCOPE( "Update" );
+
+            // A shot every frame, each living 20 frames counting this one.
+            SteadyPose pose = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+            SteadyLifetime lifetime = { 20 };
+            shots.push_back( world.CreateEntity( pose, lifetime ) );
+
+            world.ForEach<SteadyPose>( []( SteadyPose& p ) { p.Position[2] += 0.1f; } );
+            world.ForEach<SteadyLifetime>( []( SteadyLifetime& l ) { l.FramesLeft--; } );
+
+            for ( size_t i = 0; i < shots.size(); )
+            {
+                if ( world.GetComponent<SteadyLifetime>( shots[i] )->FramesLeft == 0 )
+                {
+                    world.DestroyEntity( shots[i] );
+                    shots[i] = shots.back();
+                    shots.pop_back();
+                }
+                else
+                {
+                    i++;
+                }
+            }
+
+            hierarchy.SetLocalRotation( camera, XMQuaternionRotationRollPitchYaw( 0.0f, float( frame ) * 0.01f, 0.0f ) );
+            hierarchy.Update();
+        }
+    }
+
+    AllocationTracker::BeginFrame();
+    if ( AllocationTracker::GetLastFrameAllocationCount() != 0 )
+    {
+        allocatingFrames++;
+    }
+
+    CHECK( allocatingFrames == 0 );
+    CHECK( shots.size() == 19 );
+}
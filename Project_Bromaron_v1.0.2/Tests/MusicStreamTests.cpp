@@ -0,0 +1,428 @@
+//--------------------------------------------------------------------------------------
+// File: MusicStreamTests.cpp
+//
+// The stream is given a stand-in decoder that produces a known byte pattern
+// instead of reading a file, and sinks that either play each buffer on a
+// thread of their own in scaled real time, as a voice would, or hand it
+// straight back from Submit.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "MusicStream.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    // 44.1 kHz 16-bit stereo.
+    const unsigned int BytesPerSecond = 176400;
+    const unsigned int BlockAlign = 4;
+
+    long long GetPerformanceCounter()
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter( &counter );
+        return counter.QuadPart;
+    }
+
+    long long GetPerformanceFrequency()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency( &frequency );
+        return frequency.QuadPart;
+    }
+
+    // Byte i of every test track.
+    unsigned char GetTrackByte( size_t i )
+    {
+        return static_cast<unsigned char>( i * 7 + i / 251 );
+    }
+
+    // A track of trackBytes bytes, read at most 4 KB at a time like a real
+    // decoder, optionally sleeping before each read.
+    class StandInDecoder : public MusicDecoder
+    {
+    public:
+        StandInDecoder( size_t trackBytes, unsigned int blockAlign = BlockAlign, unsigned int readDelayMicroseconds = 0 ) :
+            m_trackBytes( trackBytes ),
+            m_blockAlign( blockAlign ),
+            m_readDelayMicroseconds( readDelayMicroseconds ),
+            m_position( 0 )
+        {
+        }
+
+        virtual bool Open( const std::wstring& name, std::vector<unsigned char>* format ) override
+        {
+            if ( name.find( L"missing" ) != std::wstring::npos )
+            {
+                return false;
+            }
+
+            // A WAVEFORMATEX; only nBlockAlign, at byte 12, matters to the stream.
+            format->assign( 18, 0 );
+            (*format)[12] = static_cast<unsigned char>( m_blockAlign );
+            (*format)[13] = static_cast<unsigned char>( m_blockAlign >> 8 );
+            return true;
+        }
+
+        virtual unsigned int Read( unsigned char* buffer, unsigned int capacity ) override
+        {
+            if ( m_readDelayMicroseconds != 0 )
+            {
+                std::this_thread::sleep_for( std::chrono::microseconds( m_readDelayMicroseconds ) );
+            }
+
+            size_t bytes = std::min<size_t>( std::min<size_t>( capacity, 4096 ), m_trackBytes - m_position );
+            for ( size_t i = 0; i < bytes; i++ )
+            {
+                buffer[i] = GetTrackByte( m_position + i );
+            }
+
+            m_position += bytes;
+            return static_cast<unsigned int>( bytes );
+        }
+
+        virtual bool Rewind() override
+        {
+            m_position = 0;
+            return true;
+        }
+
+    private:
+        size_t          m_trackBytes;
+        unsigned int    m_blockAlign;
+        unsigned int    m_readDelayMicroseconds;
+        size_t          m_position;
+    };
+
+    // Plays each buffer on its own thread, taking as long as the audio in it
+    // lasts divided by speed, then reports it played.
+    class PlayingSink : public MusicSink
+    {
+    public:
+        PlayingSink( MusicStream* stream, double speed ) :
+            m_stream( stream ),
+            m_speed( speed ),
+            m_stop( false ),
+            EndOfStream( false )
+        {
+            m_thread = std::thread( &PlayingSink::Run, this );
+        }
+
+        ~PlayingSink()
+        {
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_stop = true;
+            }
+
+            m_submitted.notify_one();
+            m_thread.join();
+        }
+
+        virtual void Submit( const unsigned char* data, unsigned int bytes, bool endOfStream ) override
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_queue.push_back( std::vector<unsigned char>( data, data + bytes ) );
+            EndOfStream = EndOfStream || endOfStream;
+            m_submitted.notify_one();
+        }
+
+        // Everything played so far. Call once the sink is done.
+        const std::vector<unsigned char>& GetPlayed() const     { return m_played; }
+
+    private:
+        void Run()
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            for ( ;; )
+            {
+                while ( !m_stop && m_queue.empty() )
+                {
+                    m_submitted.wait( lock );
+                }
+
+                if ( m_stop )
+                {
+                    return;
+                }
+
+                std::vector<unsigned char> buffer;
+                buffer.swap( m_queue.front() );
+                m_queue.pop_front();
+                lock.unlock();
+
+                std::this_thread::sleep_for( std::chrono::microseconds( static_cast<long long>( buffer.size() * 1e6 / BytesPerSecond / m_speed ) ) );
+                m_played.insert( m_played.end(), buffer.begin(), buffer.end() );
+                m_stream->OnBufferEnd();
+
+                lock.lock();
+            }
+        }
+
+        MusicStream*                            m_stream;
+        double                                  m_speed;
+        std::thread                             m_thread;
+        std::mutex                              m_mutex;
+        std::condition_variable                 m_submitted;
+        std::deque<std::vector<unsigned char>>  m_queue;
+        std::vector<unsigned char>              m_played;
+        bool                                    m_stop;
+
+    public:
+        bool                                    EndOfStream;
+    };
+
+    // Plays every buffer instantly, from inside Submit.
+    class ImmediateSink : public MusicSink
+    {
+    public:
+        ImmediateSink( MusicStream* stream, bool keepData ) :
+            m_stream( stream ),
+            m_keepData( keepData ),
+            Bytes( 0 ),
+            Buffers( 0 ),
+            EmptyBuffers( 0 ),
+            EndOfStream( false ),
+            EndOfStreamBuffer( 0 )
+        {
+        }
+
+        virtual void Submit( const unsigned char* data, unsigned int bytes, bool endOfStream ) override
+        {
+            if ( m_keepData )
+            {
+                Played.insert( Played.end(), data, data + bytes );
+            }
+
+            Bytes += bytes;
+            Buffers++;
+            EmptyBuffers += ( bytes == 0 ) ? 1 : 0;
+            if ( endOfStream && !EndOfStream )
+            {
+                EndOfStream = true;
+                EndOfStreamBuffer = Buffers;
+            }
+
+            m_stream->OnBufferEnd();
+        }
+
+    private:
+        MusicStream*    m_stream;
+        bool            m_keepData;
+
+    public:
+        std::vector<unsigned char>  Played;
+        unsigned long long          Bytes;
+        unsigned int                Buffers;
+        unsigned int                EmptyBuffers;
+        bool                        EndOfStream;
+        unsigned int                EndOfStreamBuffer;      // 1-based; the first buffer marked as the end.
+    };
+
+    MusicStream* MakeStream( StandInDecoder* decoder )
+    {
+        return new MusicStream( std::unique_ptr<MusicDecoder>( decoder ), GetPerformanceCounter, GetPerformanceFrequency() );
+    }
+
+    bool IsTrackData( const std::vector<unsigned char>& played, size_t trackBytes )
+    {
+        for ( size_t i = 0; i < played.size(); i++ )
+        {
+            if ( played[i] != GetTrackByte( i % trackBytes ) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void WaitUntilFinished( const MusicStream& stream, double timeoutSeconds )
+    {
+        double end = Tests::GetSeconds() + timeoutSeconds;
+        while ( !stream.IsFinished() && Tests::GetSeconds() < end )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+    }
+}
+
+TEST( MusicStream_OpenRoundsBuffersToBlocks )
+{
+    std::unique_ptr<MusicStream> stream( MakeStream( new StandInDecoder( 1000, 6 ) ) );
+    CHECK( stream->Open( L"track.wav", false ) );
+    CHECK( stream->GetFormat().size() == 18 );
+
+    MusicStreamStats stats;
+    stream->GetStats( &stats );
+    CHECK( stats.BufferBytes == ( MUSIC_STREAM_BUFFER_BYTES - MUSIC_STREAM_BUFFER_BYTES % 6 ) * MUSIC_STREAM_BUFFER_COUNT );
+    CHECK( stats.BuffersSubmitted == 0 && stats.FirstAudioMilliseconds == 0.0 );
+
+    std::unique_ptr<MusicStream> missing( MakeStream( new StandInDecoder( 1000 ) ) );
+    CHECK( !missing->Open( L"missing.wav", false ) );
+
+    // Starting without a track, or without a sink, does nothing.
+    ImmediateSink sink( missing.get(), false );
+    missing->Start( &sink );
+    stream->Start( nullptr );
+    CHECK( sink.Buffers == 0 );
+
+    std::unique_ptr<MusicStream> badAlign( MakeStream( new StandInDecoder( 1000, 0 ) ) );
+    CHECK( !badAlign->Open( L"track.wav", false ) );
+}
+
+// A track that doesn't loop plays through exactly once, with the last buffer
+// marked as the end.
+TEST( MusicStream_PlaysTrackOnce )
+{
+    const size_t trackBytes = 5 * MUSIC_STREAM_BUFFER_BYTES + 1000;
+
+    std::unique_ptr<MusicStream> stream( MakeStream( new StandInDecoder( trackBytes ) ) );
+    CHECK( stream->Open( L"track.wav", false ) );
+
+    {
+        PlayingSink sink( stream.get(), 20.0 );
+        stream->Start( &sink );
+        WaitUntilFinished( *stream, 5.0 );
+        CHECK( stream->IsFinished() );
+        stream->Stop();
+        CHECK( sink.EndOfStream );
+        CHECK( sink.GetPlayed().size() == trackBytes );
+        CHECK( IsTrackData( sink.GetPlayed(), trackBytes ) );
+    }
+
+    MusicStreamStats stats;
+    stream->GetStats( &stats );
+    CHECK( stats.BytesDecoded == trackBytes );
+    CHECK( stats.BuffersSubmitted == 6 );
+    CHECK( stats.Loops == 0 );
+    CHECK( stats.FirstAudioMilliseconds > 0.0 );
+}
+
+// A track ending exactly on a buffer boundary marks its last full buffer as the
+// end, without submitting an empty one after it; likewise a track one block
+// longer, whose last buffer holds just that block. Buffers of 4-byte blocks fill
+// MUSIC_STREAM_BUFFER_BYTES exactly, and of 6-byte blocks fall two bytes short.
+TEST( MusicStream_EndsOnBufferBoundary )
+{
+    const unsigned int blockAligns[] = { BlockAlign, 6 };
+    for ( size_t i = 0; i < ARRAYSIZE( blockAligns ); i++ )
+    {
+        const size_t bufferBytes = MUSIC_STREAM_BUFFER_BYTES - MUSIC_STREAM_BUFFER_BYTES % blockAligns[i];
+        for ( size_t extra = 0; extra <= blockAligns[i]; extra += blockAligns[i] )
+        {
+            const size_t trackBytes = 4 * bufferBytes + extra;
+            const unsigned int bufferCount = ( extra != 0 ) ? 5 : 4;
+
+            std::unique_ptr<MusicStream> stream( MakeStream( new StandInDecoder( trackBytes, blockAligns[i] ) ) );
+            CHECK( stream->Open( L"track.wav", false ) );
+
+            ImmediateSink sink( stream.get(), true );
+            stream->Start( &sink );
+            WaitUntilFinished( *stream, 5.0 );
+            stream->Stop();
+
+            CHECK( sink.Buffers == bufferCount && sink.EmptyBuffers == 0 );
+            CHECK( sink.EndOfStream && sink.EndOfStreamBuffer == bufferCount );
+            CHECK( sink.Played.size() == trackBytes && IsTrackData( sink.Played, trackBytes ) );
+            CHECK( stream->IsFinished() );
+
+            MusicStreamStats stats;
+            stream->GetStats( &stats );
+            CHECK( stats.BytesDecoded == trackBytes && stats.BuffersSubmitted == bufferCount );
+        }
+    }
+}
+
+// A looping track wraps inside a buffer, so the audio runs on with no gap.
+TEST( MusicStream_LoopsWithoutGap )
+{
+    const size_t trackBytes = MUSIC_STREAM_BUFFER_BYTES + MUSIC_STREAM_BUFFER_BYTES / 3 + 2;
+
+    std::unique_ptr<MusicStream> stream( MakeStream( new StandInDecoder( trackBytes ) ) );
+    CHECK( stream->Open( L"track.wav", true ) );
+
+    {
+        PlayingSink sink( stream.get(), 50.0 );
+        stream->Start( &sink );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 300 ) );
+        stream->Stop();
+
+        CHECK( !sink.EndOfStream && !stream->IsFinished() );
+        CHECK( sink.GetPlayed().size() > 2 * trackBytes );
+        CHECK( IsTrackData( sink.GetPlayed(), trackBytes ) );
+    }
+
+    MusicStreamStats stats;
+    stream->GetStats( &stats );
+    CHECK( stats.Loops >= 2 );
+
+    // An empty looping track ends instead of rewinding forever.
+    std::unique_ptr<MusicStream> empty( MakeStream( new StandInDecoder( 0 ) ) );
+    CHECK( empty->Open( L"track.wav", true ) );
+    ImmediateSink emptySink( empty.get(), false );
+    empty->Start( &emptySink );
+    WaitUntilFinished( *empty, 5.0 );
+    empty->Stop();
+    CHECK( emptySink.Buffers == 0 );
+}
+
+// A decoder slower than real time starves the sink, and the stream counts it.
+TEST( MusicStream_CountsUnderruns )
+{
+    std::unique_ptr<MusicStream> fast( MakeStream( new StandInDecoder( 40 * MUSIC_STREAM_BUFFER_BYTES ) ) );
+    CHECK( fast->Open( L"track.wav", true ) );
+
+    std::unique_ptr<MusicStream> slow( MakeStream( new StandInDecoder( 40 * MUSIC_STREAM_BUFFER_BYTES, BlockAlign, 20000 ) ) );
+    CHECK( slow->Open( L"track.wav", true ) );
+
+    {
+        PlayingSink fastSink( fast.get(), 4.0 );
+        PlayingSink slowSink( slow.get(), 50.0 );
+        fast->Start( &fastSink );
+        slow->Start( &slowSink );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 500 ) );
+        fast->Stop();
+        slow->Stop();
+    }
+
+    MusicStreamStats fastStats;
+    MusicStreamStats slowStats;
+    fast->GetStats( &fastStats );
+    slow->GetStats( &slowStats );
+    CHECK( fastStats.Underruns == 0 );
+    CHECK( slowStats.Underruns > 0 );
+}
+
+// How soon the first buffer reaches the sink, and how fast the decode thread
+// turns over buffers when the sink never holds them.
+BENCHMARK( MusicStream_FirstAudioAndThroughput )
+{
+    const size_t trackBytes = 60 * BytesPerSecond;
+
+    std::unique_ptr<MusicStream> stream( MakeStream( new StandInDecoder( trackBytes ) ) );
+    CHECK( stream->Open( L"track.wav", false ) );
+
+    ImmediateSink sink( stream.get(), false );
+    double start = Tests::GetSeconds();
+    stream->Start( &sink );
+    WaitUntilFinished( *stream, 30.0 );
+    double seconds = Tests::GetSeconds() - start;
+    stream->Stop();
+
+    MusicStreamStats stats;
+    stream->GetStats( &stats );
+    CHECK( sink.Bytes == trackBytes );
+
+    wprintf( L"    first audio after %.3f ms; a minute of audio streamed in %.1f ms; %u KB of buffers\n",
+             stats.FirstAudioMilliseconds, seconds * 1000.0, static_cast<unsigned int>( stats.BufferBytes / 1024 ) );
+}
@@ -0,0 +1,232 @@
+//--------------------------------------------------------------------------------------
+// File: ProceduralSynthTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "AllocationTracker.h"
+#include "ProceduralSynth.h"
+
+using namespace DirectX;
+using namespace DirectXGame2;
+
+namespace
+{
+    const int SampleRate = 48000;
+
+    struct NoteMeasurement
+    {
+        double  seconds;
+        float   peak;
+        bool    finite;
+    };
+
+    // Plays one mono note until it ends or maxSeconds pass.
+    NoteMeasurement MeasureNote( const SynthPatch& patch, double maxSeconds )
+    {
+        ProceduralSynth synth( SampleRate, 1, 2 );
+        unsigned int note = synth.Play( patch );
+
+        NoteMeasurement result = { 0.0, 0.0f, true };
+        std::vector<float> output( 480 );
+        size_t frames = 0;
+        while ( synth.IsPlaying( note ) && frames < size_t( maxSeconds * SampleRate ) )
+        {
+            synth.Render( &output[0], output.size() );
+            for ( size_t i = 0; i < output.size(); i++ )
+            {
+                result.finite = result.finite && ( output[i] == output[i] ) && fabsf( output[i] ) < 1e6f;
+                result.peak = std::max( result.peak, fabsf( output[i] ) );
+            }
+
+            frames += output.size();
+        }
+
+        result.seconds = double( frames ) / SampleRate;
+        return result;
+    }
+}
+
+// Every weapon type and an explosion make an audible, finite note that ends by
+// itself (the beam once its hold time is set).
+TEST( ProceduralSynth_PatchesEnd )
+{
+    for ( int type = 0; type < 4; type++ )
+    {
+        for ( int e = 0; e <= 2; e++ )
+        {
+            float energy = e * 0.5f;
+            SynthPatch patch;
+            if ( type < 3 )
+            {
+                GetWeaponPatch( type, energy, patch );
+            }
+            else
+            {
+                GetExplosionPatch( energy, patch );
+            }
+
+            if ( type == 1 )
+            {
+                patch.holdTime = 0.4f;
+            }
+
+            NoteMeasurement note = MeasureNote( patch, 5.0 );
+            CHECK( note.finite );
+            CHECK( note.peak > 0.01f );
+            CHECK( note.seconds > 0.0 && note.seconds < 5.0 );
+
+            if ( e == 2 )
+            {
+                wprintf( L"    %s: %.3f s, peak %.3f\n", ( type < 3 ) ? L"weapon" : L"explosion", note.seconds, note.peak );
+            }
+        }
+    }
+}
+
+// The beam holds until Release, then fades within its release time; handles of
+// finished notes are ignored.
+TEST( ProceduralSynth_HeldUntilRelease )
+{
+    ProceduralSynth synth( SampleRate, 2, 4 );
+    std::vector<float> output( 2 * SampleRate );
+
+    SynthPatch patch;
+    GetWeaponPatch( 1, 0.5f, patch );
+    unsigned int beam = synth.Play( patch );
+    CHECK( beam != 0 && synth.IsPlaying( beam ) );
+
+    synth.Render( &output[0], SampleRate );
+    CHECK( synth.IsPlaying( beam ) );
+
+    synth.Release( beam );
+    synth.Render( &output[0], SampleRate / 5 );
+    CHECK( !synth.IsPlaying( beam ) );
+
+    synth.Release( beam );
+    synth.Stop( beam );
+    CHECK( synth.GetStatistics().playingVoices == 0 );
+}
+
+// A mono note panned hard left leaves the right channel silent; with nothing
+// playing, Render writes silence over the buffer.
+TEST( ProceduralSynth_PanAndSilence )
+{
+    ProceduralSynth synth( SampleRate, 2, 4 );
+    CHECK( synth.GetSampleRate() == SampleRate && synth.GetOutputChannels() == 2 );
+
+    std::vector<float> output( 2 * 4800, 1.0f );
+    synth.Render( &output[0], 4800 );
+    CHECK( std::count( output.begin(), output.end(), 0.0f ) == ptrdiff_t( output.size() ) );
+
+    SynthPatch patch;
+    GetExplosionPatch( 0.5f, patch );
+    synth.Play( patch, 1.0f, -1.0f );
+    synth.Render( &output[0], 4800 );
+
+    float left = 0.0f;
+    float right = 0.0f;
+    for ( size_t i = 0; i < 4800; i++ )
+    {
+        left = std::max( left, fabsf( output[i * 2] ) );
+        right = std::max( right, fabsf( output[i * 2 + 1] ) );
+    }
+
+    CHECK( left > 0.01f && right < 1e-6f );
+}
+
+// With every voice busy, a new note takes the quietest; the stolen note's handle
+// goes stale and is never handed out again.
+TEST( ProceduralSynth_StealsQuietest )
+{
+    ProceduralSynth synth( SampleRate, 2, 4 );
+    std::vector<float> output( 2 * 64 );
+
+    SynthPatch patch;
+    GetExplosionPatch( 1.0f, patch );
+
+    unsigned int notes[6];
+    for ( int i = 0; i < 6; i++ )
+    {
+        notes[i] = synth.Play( patch, ( i == 0 ) ? 0.01f : 1.0f );
+        synth.Render( &output[0], 64 );
+    }
+
+    ProceduralSynthStatistics stats = synth.GetStatistics();
+    CHECK( stats.playingVoices == 4 && stats.maxVoices == 4 );
+    CHECK( stats.notesPlayed == 6 && stats.notesStolen == 2 );
+    CHECK( !synth.IsPlaying( notes[0] ) );
+    CHECK( synth.IsPlaying( notes[5] ) );
+
+    synth.StopAll();
+    CHECK( synth.GetStatistics().playingVoices == 0 );
+
+    unsigned int next = synth.Play( patch );
+    CHECK( next != 0 && next != notes[0] && next != notes[1] );
+
+    bool threw = false;
+    try
+    {
+        ProceduralSynth bad( SampleRate, 3, 4 );
+    }
+    catch ( const std::invalid_argument& )
+    {
+        threw = true;
+    }
+
+    CHECK( threw );
+}
+
+// Play, Release and Render never allocate, so they can run in a BufferNeeded
+// callback.
+TEST( ProceduralSynth_NoAllocationsWhilePlaying )
+{
+    if ( !AllocationTracker::IsEnabled() )
+    {
+        wprintf( L"    skipped: ALLOCATION_TRACKING is off\n" );
+        return;
+    }
+
+    ProceduralSynth synth( SampleRate, 2, 16 );
+    std::vector<float> output( 2 * 512 );
+    SynthPatch weapon;
+    SynthPatch explosion;
+    GetWeaponPatch( 0, 0.7f, weapon );
+    GetExplosionPatch( 0.7f, explosion );
+
+    unsigned int totalBefore = AllocationTracker::GetTotalAllocationCount();
+    for ( int frame = 0; frame < 500; frame++ )
+    {
+        unsigned int note = synth.Play( ( frame % 3 ) ? weapon : explosion, 0.5f, ( frame % 5 ) * 0.4f - 0.8f );
+        if ( frame % 4 == 0 )
+        {
+            synth.Release( note );
+        }
+
+        synth.Render( &output[0], 512 );
+    }
+
+    unsigned int allocations = AllocationTracker::GetTotalAllocationCount() - totalBefore;
+    wprintf( L"    %u allocations in 500 buffers, %u notes stolen\n", allocations, static_cast<unsigned int>( synth.GetStatistics().notesStolen ) );
+    CHECK( allocations == 0 );
+}
+
+// Render cost at each voice count, as a share of real time for 48 kHz stereo.
+BENCHMARK( ProceduralSynth_VoiceCounts )
+{
+    const size_t voiceCounts[] = { 16, 64, 256, 1024 };
+    for ( size_t i = 0; i < ARRAYSIZE( voiceCounts ); i++ )
+    {
+        ProceduralSynthBenchmark result = BenchmarkProceduralSynth( voiceCounts[i], 5.0 );
+        CHECK( result.voiceCount == voiceCounts[i] );
+        wprintf( L"    %4u voices: %.2f%% of real time, about %.0f voices per core\n",
+                 static_cast<unsigned int>( result.voiceCount ), result.realTimeFraction * 100.0, result.voicesPerCore );
+    }
+}
@@ -0,0 +1,298 @@
+//--------------------------------------------------------------------------------------
+// File: ResamplerTests.cpp
+//
+// Output is compared against a reference filter that works out the exact
+// coefficients for every output frame in double precision, rather than looking
+// them up in Resampler's tables.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "Resampler.h"
+
+using namespace DirectX;
+
+namespace
+{
+    const double Pi = 3.14159265358979323846;
+
+    // The same taps, cutoffs and Kaiser windows Resampler documents for each tier.
+    struct ReferenceDesign
+    {
+        int     taps;
+        double  cutoff;
+        double  beta;
+    };
+
+    const ReferenceDesign Designs[] =
+    {
+        {  2, 1.0,   0 },
+        {  8, 0.80,  6 },
+        { 16, 0.88,  8 },
+        { 32, 0.92, 10 },
+    };
+
+    double BesselI0( double x )
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for ( int k = 1; k < 60; k++ )
+        {
+            term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    // Every channel of one output frame at input position position, reading silence
+    // outside the input. Downsampling narrows the cutoff in half-octave steps.
+    void ReferenceFrame( const std::vector<float>& input, int channels, double position, int quality, double ratio, double* output )
+    {
+        const ReferenceDesign& design = Designs[quality];
+        int half = design.taps / 2;
+        long first = static_cast<long>( floor( position ) );
+        double fraction = position - first;
+
+        double cutoff = design.cutoff;
+        if ( design.taps > 2 && ratio > 1.0 )
+        {
+            int step = std::min( 16, static_cast<int>( ceil( log( ratio ) / log( 2.0 ) * 2.0 - 1e-9 ) ) );
+            cutoff /= pow( 2.0, step / 2.0 );
+        }
+
+        long frames = static_cast<long>( input.size() / channels );
+        double sum = 0.0;
+        for ( int c = 0; c < channels; c++ )
+        {
+            output[c] = 0.0;
+        }
+
+        for ( int k = 0; k < design.taps; k++ )
+        {
+            double t = k - ( half - 1 ) - fraction;
+            double value;
+            if ( design.taps == 2 )
+            {
+                value = 1.0 - fabs( t );
+            }
+            else
+            {
+                double x = t / half;
+                double window = ( fabs( x ) < 1.0 ) ? BesselI0( design.beta * sqrt( 1.0 - x * x ) ) / BesselI0( design.beta ) : 0.0;
+                double sinc = ( t == 0 ) ? 1.0 : sin( Pi * t * cutoff ) / ( Pi * t * cutoff );
+                value = sinc * window;
+            }
+
+            sum += value;
+            long n = first - ( half - 1 ) + k;
+            if ( n >= 0 && n < frames )
+            {
+                for ( int c = 0; c < channels; c++ )
+                {
+                    output[c] += value * input[n * channels + c];
+                }
+            }
+        }
+
+        for ( int c = 0; c < channels; c++ )
+        {
+            output[c] /= sum;
+        }
+    }
+
+    std::vector<float> MakeNoise( std::mt19937& random, size_t samples )
+    {
+        std::uniform_real_distribution<float> distribution( -1.0f, 1.0f );
+        std::vector<float> noise( samples );
+        for ( size_t i = 0; i < samples; i++ )
+        {
+            noise[i] = distribution( random );
+        }
+
+        return noise;
+    }
+
+    // Includes ratios past MaxRatio, which SetRatio clamps.
+    const double TestRatios[] = { 1.0, 44100.0 / 48000.0, 48000.0 / 44100.0, 0.5, 2.0, 3.7, 0.013, 40.0, 300.0 };
+}
+
+TEST( Resampler_Construction )
+{
+    bool threw = false;
+    try
+    {
+        Resampler resampler( 0, RESAMPLER_QUALITY_LOW );
+    }
+    catch ( const std::invalid_argument& )
+    {
+        threw = true;
+    }
+
+    CHECK( threw );
+
+    CHECK( Resampler::GetTaps( RESAMPLER_QUALITY_LINEAR ) == 2 );
+    CHECK( Resampler::GetTaps( RESAMPLER_QUALITY_HIGH ) == 32 );
+
+    Resampler resampler( 2, RESAMPLER_QUALITY_MEDIUM );
+    CHECK( resampler.GetChannels() == 2 && resampler.GetQuality() == RESAMPLER_QUALITY_MEDIUM );
+
+    resampler.SetRatio( 1000.0 );
+    CHECK( resampler.GetRatio() == Resampler::MaxRatio );
+    resampler.SetRatio( 0.0001 );
+    CHECK( Tests::IsNear( resampler.GetRatio(), 1.0 / Resampler::MaxRatio, 1e-9 ) );
+}
+
+// Feeding the input in random pieces into random amounts of output space gives
+// exactly what one call does, and both match the reference filter.
+TEST( Resampler_MatchesReferenceInAnyChunks )
+{
+    const size_t frameCount = 2000;
+    const size_t checkedFrames = 1500;
+    std::mt19937 random( 3 );
+
+    for ( int quality = RESAMPLER_QUALITY_LINEAR; quality <= RESAMPLER_QUALITY_HIGH; quality++ )
+    {
+        for ( int channels = 1; channels <= 3; channels++ )
+        {
+            for ( unsigned int r = 0; r < ARRAYSIZE( TestRatios ); r++ )
+            {
+                double ratio = TestRatios[r];
+                std::vector<float> input = MakeNoise( random, frameCount * channels );
+
+                Resampler whole( channels, static_cast<RESAMPLER_QUALITY>( quality ) );
+                Resampler pieces( channels, static_cast<RESAMPLER_QUALITY>( quality ) );
+                whole.SetRatio( ratio );
+                pieces.SetRatio( ratio );
+
+                size_t capacity = static_cast<size_t>( frameCount / std::min( ratio, double( Resampler::MaxRatio ) ) ) + 64;
+                std::vector<float> wholeOutput( capacity * channels );
+                std::vector<float> piecesOutput( capacity * channels );
+
+                size_t consumed;
+                size_t written = whole.Process( &input[0], frameCount, consumed, &wholeOutput[0], capacity );
+                CHECK( consumed == frameCount );
+
+                size_t read = 0;
+                size_t piecesWritten = 0;
+                for ( ;; )
+                {
+                    size_t inputFrames = std::min<size_t>( random() % 300, frameCount - read );
+                    size_t outputFrames = std::min<size_t>( random() % 200 + 1, capacity - piecesWritten );
+                    size_t pieceConsumed;
+                    size_t pieceWritten = pieces.Process( input.data() + read * channels, inputFrames, pieceConsumed,
+                                                          &piecesOutput[piecesWritten * channels], outputFrames );
+                    read += pieceConsumed;
+                    piecesWritten += pieceWritten;
+
+                    if ( piecesWritten == capacity || ( read == frameCount && pieceWritten == 0 ) )
+                    {
+                        break;
+                    }
+                }
+
+                CHECK( piecesWritten == written );
+                CHECK( std::equal( wholeOutput.begin(), wholeOutput.begin() + written * channels, piecesOutput.begin() ) );
+
+                // Output frame j falls at input position j * ratio, in 32.32 fixed point.
+                double clamped = std::min( double( Resampler::MaxRatio ), std::max( 1.0 / Resampler::MaxRatio, ratio ) );
+                uint64_t step = static_cast<uint64_t>( clamped * 4294967296.0 + 0.5 );
+                double worst = 0.0;
+                double expected[3];
+                for ( size_t j = 0; j < std::min( written, checkedFrames ); j++ )
+                {
+                    ReferenceFrame( input, channels, double( step * j ) / 4294967296.0, quality, clamped, expected );
+                    for ( int c = 0; c < channels; c++ )
+                    {
+                        worst = std::max( worst, fabs( expected[c] - wholeOutput[j * channels + c] ) );
+                    }
+                }
+
+                // The tables interpolate between phases, so only the linear tier is exact.
+                const double tolerances[] = { 1e-5, 2e-3, 1e-3, 5e-4 };
+                CHECK( worst <= tolerances[quality] );
+            }
+        }
+    }
+}
+
+// A constant input stays constant while the ratio changes every few frames.
+TEST( Resampler_DCThroughPitchBends )
+{
+    for ( int quality = RESAMPLER_QUALITY_LINEAR; quality <= RESAMPLER_QUALITY_HIGH; quality++ )
+    {
+        Resampler resampler( 2, static_cast<RESAMPLER_QUALITY>( quality ) );
+        std::vector<float> input( 2 * 4000, 0.5f );
+        std::vector<float> output( 2 * 20000 );
+
+        size_t read = 0;
+        size_t written = 0;
+        for ( int k = 0; k < 200 && read < 4000; k++ )
+        {
+            resampler.SetRatio( 0.5 + 1.5 * ( k % 20 ) / 20.0 );
+
+            size_t consumed;
+            written += resampler.Process( &input[read * 2], std::min<size_t>( 50, 4000 - read ), consumed,
+                                          &output[written * 2], std::min<size_t>( 40, 20000 - written ) );
+            read += consumed;
+        }
+
+        // Skip the filter ramping up from silence and down at the end.
+        double worst = 0.0;
+        for ( size_t j = 40; j + 40 < written; j++ )
+        {
+            worst = std::max( worst, double( fabsf( output[j * 2] - 0.5f ) ) );
+        }
+
+        CHECK( worst < 1e-4 );
+    }
+}
+
+// An impulse is held back until GetLatency frames of silence follow it.
+TEST( Resampler_LatencyDrain )
+{
+    Resampler resampler( 1, RESAMPLER_QUALITY_HIGH );
+    const float impulse = 1.0f;
+    float output[64];
+
+    size_t consumed;
+    CHECK( resampler.Process( &impulse, 1, consumed, output, ARRAYSIZE( output ) ) == 0 );
+    CHECK( consumed == 1 );
+
+    std::vector<float> silence( resampler.GetLatency(), 0.0f );
+    CHECK( resampler.Process( &silence[0], silence.size(), consumed, output, ARRAYSIZE( output ) ) == 1 );
+
+    double expected;
+    ReferenceFrame( std::vector<float>( 1, 1.0f ), 1, 0.0, RESAMPLER_QUALITY_HIGH, 1.0, &expected );
+    CHECK( Tests::IsNear( output[0], expected, 1e-4 ) );
+
+    // Reset forgets the buffered impulse, so silence in the same place comes out as silence.
+    resampler.Process( &impulse, 1, consumed, output, ARRAYSIZE( output ) );
+    resampler.Reset();
+    silence.push_back( 0.0f );
+    CHECK( resampler.Process( &silence[0], silence.size(), consumed, output, ARRAYSIZE( output ) ) == 1 );
+    CHECK( output[0] == 0.0f );
+}
+
+// Cost and THD+N of each tier, for the conversions the game's assets need.
+BENCHMARK( Resampler_QualityTiers )
+{
+    const int rates[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 22050, 48000 }, { 96000, 48000 } };
+    for ( int quality = RESAMPLER_QUALITY_LINEAR; quality <= RESAMPLER_QUALITY_HIGH; quality++ )
+    {
+        for ( unsigned int r = 0; r < ARRAYSIZE( rates ); r++ )
+        {
+            ResamplerBenchmark result = BenchmarkResampler( static_cast<RESAMPLER_QUALITY>( quality ), 2, rates[r][0], rates[r][1], 10.0 );
+            CHECK( result.audioSeconds > 0.0 );
+            wprintf( L"    quality %d, %5d -> %5d Hz: %.3f%% of real time, THD+N %.1f dB\n",
+                     quality, rates[r][0], rates[r][1], result.realTimeFraction * 100.0, result.thdPlusNoise );
+        }
+    }
+}
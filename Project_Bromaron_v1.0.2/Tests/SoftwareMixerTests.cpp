@@ -0,0 +1,240 @@
+//--------------------------------------------------------------------------------------
+// File: SoftwareMixerTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "SoftwareMixer.h"
+
+using namespace DirectX;
+
+namespace
+{
+    bool IsNearSample( float a, float b )
+    {
+        return fabsf( a - b ) < 1e-5f;
+    }
+}
+
+// A mono voice at the mix rate is copied straight through, at its volume and
+// with the pan law SoundEffectInstance::SetPan uses.
+TEST( SoftwareMixer_VolumeAndPan )
+{
+    SoftwareMixer mixer( 44100, 2 );
+    std::vector<float> source( 1000, 1.0f );
+
+    int voice = mixer.CreateVoice( 44100, 1 );
+    CHECK( voice >= 0 );
+    mixer.SubmitBuffer( voice, &source[0], source.size(), false );
+    mixer.SetVolume( voice, 0.5f );
+    CHECK( mixer.SetPan( voice, -0.5f ) );
+    mixer.Start( voice );
+    CHECK( mixer.IsPlaying( voice ) );
+
+    std::vector<float> output( 2 * 1200, 9.0f );
+    mixer.Render( &output[0], 1200 );
+    CHECK( IsNearSample( output[0], 0.5f ) && IsNearSample( output[1], 0.25f ) );
+    CHECK( IsNearSample( output[2 * 999], 0.5f ) );
+
+    // The voice stops at the end of its buffer, and the rest is silence.
+    CHECK( IsNearSample( output[2 * 1000], 0.0f ) && IsNearSample( output[2 * 1199 + 1], 0.0f ) );
+    CHECK( !mixer.IsPlaying( voice ) );
+
+    // Only mono voices pan.
+    int stereo = mixer.CreateVoice( 44100, 2 );
+    CHECK( !mixer.SetPan( stereo, 0.3f ) );
+
+    // Formats the mixer doesn't take.
+    CHECK( mixer.CreateVoice( 44100, 6 ) == -1 );
+}
+
+// A looping stereo voice at twice the pitch reads every other frame, wrapping.
+TEST( SoftwareMixer_LoopsAtPitch )
+{
+    const size_t sourceFrames = 101;
+
+    SoftwareMixer mixer( 44100, 2 );
+    std::vector<float> source( sourceFrames * 2 );
+    for ( size_t i = 0; i < sourceFrames; i++ )
+    {
+        source[i * 2] = float( i );
+        source[i * 2 + 1] = -float( i );
+    }
+
+    int voice = mixer.CreateVoice( 44100, 2 );
+    mixer.SubmitBuffer( voice, &source[0], sourceFrames, true );
+    mixer.SetPitch( voice, 2.0f );
+    mixer.Start( voice );
+
+    std::vector<float> output( 2 * 1000 );
+    mixer.Render( &output[0], 1000 );
+
+    bool matches = true;
+    for ( size_t n = 0; n < 1000; n++ )
+    {
+        float expected = float( ( 2 * n ) % sourceFrames );
+        matches = matches && IsNearSample( output[n * 2], expected ) && IsNearSample( output[n * 2 + 1], -expected );
+    }
+
+    CHECK( matches );
+    CHECK( mixer.IsPlaying( voice ) );
+    CHECK( mixer.GetStatistics().framesRendered == 1000 );
+}
+
+// A voice at half the mix rate is interpolated halfway between its samples.
+TEST( SoftwareMixer_LinearResampling )
+{
+    SoftwareMixer mixer( 44100, 1 );
+    const float source[] = { 0.0f, 1.0f, 2.0f, 3.0f };
+
+    int voice = mixer.CreateVoice( 22050, 1 );
+    mixer.SubmitBuffer( voice, source, ARRAYSIZE( source ), false );
+    mixer.Start( voice );
+
+    float output[10];
+    mixer.Render( output, ARRAYSIZE( output ) );
+    CHECK( IsNearSample( output[0], 0.0f ) && IsNearSample( output[1], 0.5f ) && IsNearSample( output[2], 1.0f ) );
+    CHECK( IsNearSample( output[5], 2.5f ) && IsNearSample( output[8], 0.0f ) );
+}
+
+// Voice -> bus 1 -> bus 0 -> master, each with its own volume.
+TEST( SoftwareMixer_BusChain )
+{
+    SoftwareMixer mixer( 48000, 2 );
+    int bus0 = mixer.CreateBus();
+    int bus1 = mixer.CreateBus( bus0 );
+    CHECK( bus0 >= 0 && bus1 >= 0 );
+    CHECK( mixer.CreateBus( 5 ) == -1 );
+
+    mixer.SetBusVolume( bus0, 0.5f );
+    mixer.SetBusVolume( bus1, 0.5f );
+    mixer.SetBusVolume( SoftwareMixer::MasterBus, 2.0f );
+
+    std::vector<float> source( 600, 1.0f );
+    int voice = mixer.CreateVoice( 48000, 1, bus1 );
+    mixer.SubmitBuffer( voice, &source[0], source.size(), true );
+    mixer.Start( voice );
+
+    // Not a whole number of quanta.
+    std::vector<float> output( 2 * 513 );
+    mixer.Render( &output[0], 513 );
+
+    bool matches = true;
+    for ( size_t i = 0; i < output.size(); i++ )
+    {
+        matches = matches && IsNearSample( output[i], 0.5f );
+    }
+
+    CHECK( matches );
+
+    SoftwareMixerStatistics stats = mixer.GetStatistics();
+    CHECK( stats.playingVoices == 1 && stats.buses == 2 );
+
+    // A destroyed voice's slot is reused.
+    mixer.DestroyVoice( voice );
+    CHECK( mixer.CreateVoice( 48000, 2 ) == voice );
+}
+
+// With a Resampler tier selected, a voice matches a standalone Resampler, plays
+// out its filter tail and stops; looping DC stays DC through a pitch bend.
+TEST( SoftwareMixer_ResamplerQualities )
+{
+    for ( int quality = RESAMPLER_QUALITY_LINEAR + 1; quality <= RESAMPLER_QUALITY_HIGH; quality++ )
+    {
+        SoftwareMixer mixer( 48000, 1 );
+        mixer.SetResamplerQuality( static_cast<RESAMPLER_QUALITY>( quality ) );
+        CHECK( mixer.GetResamplerQuality() == quality );
+
+        std::vector<float> source( 3000 );
+        for ( size_t i = 0; i < source.size(); i++ )
+        {
+            source[i] = sinf( i * 0.01f );
+        }
+
+        int voice = mixer.CreateVoice( 44100, 1 );
+        mixer.SubmitBuffer( voice, &source[0], source.size(), false );
+        mixer.Start( voice );
+
+        std::vector<float> output( 4000 );
+        mixer.Render( &output[0], output.size() );
+        CHECK( !mixer.IsPlaying( voice ) );
+
+        Resampler resampler( 1, static_cast<RESAMPLER_QUALITY>( quality ) );
+        resampler.SetRatio( 44100.0 / 48000.0 );
+        std::vector<float> input( source );
+        input.resize( source.size() + resampler.GetLatency(), 0.0f );
+        std::vector<float> expected( output.size(), 0.0f );
+        size_t consumed;
+        size_t written = resampler.Process( &input[0], input.size(), consumed, &expected[0], expected.size() );
+        CHECK( written > 3260 && written < 3270 );
+
+        bool matches = true;
+        for ( size_t i = 0; i < output.size(); i++ )
+        {
+            matches = matches && IsNearSample( output[i], expected[i] );
+        }
+
+        CHECK( matches );
+
+        SoftwareMixer looping( 48000, 2 );
+        looping.SetResamplerQuality( static_cast<RESAMPLER_QUALITY>( quality ) );
+        std::vector<float> dc( 2 * 77, 0.25f );
+        int loopVoice = looping.CreateVoice( 22050, 2 );
+        looping.SubmitBuffer( loopVoice, &dc[0], 77, true );
+        looping.Start( loopVoice );
+
+        std::vector<float> loopOutput( 2 * 2000 );
+        float worst = 0.0f;
+        for ( int pass = 0; pass < 20; pass++ )
+        {
+            looping.SetPitch( loopVoice, 0.5f + pass * 0.07f );
+            looping.Render( &loopOutput[0], 2000 );
+
+            // Skip the filter's ramp-up at the very start.
+            for ( size_t i = ( pass != 0 ) ? 0 : 200; i < loopOutput.size(); i++ )
+            {
+                worst = std::max( worst, fabsf( loopOutput[i] - 0.25f ) );
+            }
+        }
+
+        CHECK( worst < 1e-4f );
+        CHECK( looping.IsPlaying( loopVoice ) );
+
+        // A voice at the mix rate and unity pitch is still copied, not filtered.
+        int unity = looping.CreateVoice( 48000, 2 );
+        looping.SubmitBuffer( unity, &dc[0], 77, false );
+        looping.Start( unity );
+        looping.SetResamplerQuality( RESAMPLER_QUALITY_LINEAR );
+        looping.DestroyVoice( loopVoice );
+        looping.Render( &loopOutput[0], 100 );
+        CHECK( IsNearSample( loopOutput[0], 0.25f ) && IsNearSample( loopOutput[2 * 76], 0.25f ) );
+        CHECK( IsNearSample( loopOutput[2 * 77], 0.0f ) );
+    }
+}
+
+// How much of real time mixing takes at each voice count, and what each
+// resampler tier costs at 128 voices.
+BENCHMARK( SoftwareMixer_VoiceCounts )
+{
+    const size_t voiceCounts[] = { 32, 128, 512 };
+    for ( size_t i = 0; i < ARRAYSIZE( voiceCounts ); i++ )
+    {
+        SoftwareMixerBenchmark result = BenchmarkSoftwareMixer( voiceCounts[i], 10.0 );
+        CHECK( result.voiceCount == voiceCounts[i] );
+        wprintf( L"    %3u voices: %.3f s for %.0f s of audio, %.2f%% of real time\n",
+                 static_cast<unsigned int>( result.voiceCount ), result.renderSeconds, result.audioSeconds, result.realTimeFraction * 100.0 );
+    }
+
+    for ( int quality = RESAMPLER_QUALITY_LINEAR; quality <= RESAMPLER_QUALITY_HIGH; quality++ )
+    {
+        SoftwareMixerBenchmark result = BenchmarkSoftwareMixer( 128, 10.0, static_cast<RESAMPLER_QUALITY>( quality ) );
+        wprintf( L"    resampler quality %d, 128 voices: %.2f%% of real time\n", quality, result.realTimeFraction * 100.0 );
+    }
+}
@@ -0,0 +1,339 @@
+//--------------------------------------------------------------------------------------
+// File: SoundCacheTests.cpp
+//
+// The cache is given a stand-in decoder instead of the WAV one, so no files
+// are read. The decoder takes the size of each sound in kilobytes from its
+// name ("4.wav" decodes to 4 KB, format included) and fails on any name
+// containing "missing".
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "SoundCache.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    const size_t FormatBytes = 18;
+    const size_t KB = 1024;
+
+    // Counted by the stand-in decoder; owned by the test, since the cache owns
+    // the decoder.
+    struct DecoderCounts
+    {
+        DecoderCounts() :
+            Decodes( 0 ),
+            LoaderBegins( 0 ),
+            LoaderEnds( 0 )
+        {
+        }
+
+        std::atomic<unsigned int>   Decodes;
+        std::atomic<unsigned int>   LoaderBegins;
+        std::atomic<unsigned int>   LoaderEnds;
+    };
+
+    class StandInDecoder : public SoundDecoder
+    {
+    public:
+        StandInDecoder( DecoderCounts* counts, unsigned int delayMilliseconds = 0 ) :
+            m_counts( counts ),
+            m_delayMilliseconds( delayMilliseconds )
+        {
+        }
+
+        virtual bool Decode( const std::wstring& name, SoundAsset* asset ) override
+        {
+            m_counts->Decodes++;
+            if ( m_delayMilliseconds != 0 )
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( m_delayMilliseconds ) );
+            }
+
+            if ( name.find( L"missing" ) != std::wstring::npos )
+            {
+                return false;
+            }
+
+            unsigned long kilobytes = wcstoul( name.c_str(), nullptr, 10 );
+            asset->Format.assign( FormatBytes, 1 );
+            asset->Data.assign( kilobytes * KB - FormatBytes, static_cast<unsigned char>( kilobytes ) );
+            return true;
+        }
+
+        virtual void BeginLoaderThread() override   { m_counts->LoaderBegins++; }
+        virtual void EndLoaderThread() override     { m_counts->LoaderEnds++; }
+
+    private:
+        DecoderCounts*  m_counts;
+        unsigned int    m_delayMilliseconds;
+    };
+
+    std::unique_ptr<SoundDecoder> MakeDecoder( DecoderCounts* counts, unsigned int delayMilliseconds = 0 )
+    {
+        return std::unique_ptr<SoundDecoder>( new StandInDecoder( counts, delayMilliseconds ) );
+    }
+
+    std::wstring MakeName( unsigned int kilobytes )
+    {
+        return std::to_wstring( kilobytes ) + L".wav";
+    }
+}
+
+TEST( SoundCache_InternsNames )
+{
+    DecoderCounts counts;
+    SoundCache cache( MakeDecoder( &counts ), 64 * KB );
+
+    SoundAssetId first = cache.Intern( L"4.wav" );
+    SoundAssetId second = cache.Intern( L"3.wav" );
+    CHECK( first == 0 && second == 1 );
+    CHECK( cache.Intern( L"4.wav" ) == first );
+    CHECK( cache.GetName( second ) == L"3.wav" );
+    CHECK( cache.GetName( 99 ).empty() );
+
+    // Interning decodes nothing; unknown ids decode nothing either.
+    CHECK( !cache.Get( 99 ) );
+    CHECK( !cache.Get( INVALID_SOUND_ASSET_ID ) );
+    CHECK( counts.Decodes == 0 );
+}
+
+TEST( SoundCache_HitsAndMisses )
+{
+    DecoderCounts counts;
+    SoundCache cache( MakeDecoder( &counts ), 64 * KB );
+
+    SoundCacheStats stats;
+    cache.GetStats( &stats );
+    CHECK( stats.HitRate == 0.0f && stats.Budget == 64 * KB );
+
+    SoundAssetId id = cache.Intern( L"4.wav" );
+    std::shared_ptr<const SoundAsset> first = cache.Get( id );
+    CHECK( first && first->Format.size() == FormatBytes );
+    CHECK( first->Data.size() == 4 * KB - FormatBytes && first->Data[0] == 4 );
+
+    // The second Get hands out the same decoded sound.
+    std::shared_ptr<const SoundAsset> second = cache.Get( id );
+    CHECK( second == first );
+    CHECK( counts.Decodes == 1 );
+
+    cache.Get( id );
+    cache.Get( id );
+    cache.GetStats( &stats );
+    CHECK( stats.Hits == 3 && stats.Misses == 1 );
+    CHECK( Tests::IsNear( stats.HitRate, 0.75, 1e-6 ) );
+    CHECK( stats.BytesResident == 4 * KB && stats.AssetsResident == 1 );
+}
+
+// Over budget, the least recently used sounds go first, and a sound a voice
+// still holds stays alive after it is evicted.
+TEST( SoundCache_EvictsLeastRecentlyUsed )
+{
+    DecoderCounts counts;
+    SoundCache cache( MakeDecoder( &counts ), 10 * KB );
+
+    SoundAssetId a = cache.Intern( L"4.wav" );
+    SoundAssetId b = cache.Intern( L"3.wav" );
+    SoundAssetId c = cache.Intern( L"5.wav" );
+
+    std::shared_ptr<const SoundAsset> held = cache.Get( a );
+    cache.Get( b );
+    cache.Get( a );         // b is now the oldest.
+    cache.Get( c );         // 12 KB: b goes.
+
+    SoundCacheStats stats;
+    cache.GetStats( &stats );
+    CHECK( stats.Evictions == 1 );
+    CHECK( stats.BytesResident == 9 * KB && stats.AssetsResident == 2 );
+
+    cache.Get( a );
+    CHECK( counts.Decodes == 3 );
+
+    // b decodes again, and c, now the oldest, goes.
+    cache.Get( b );
+    CHECK( counts.Decodes == 4 );
+    cache.GetStats( &stats );
+    CHECK( stats.Evictions == 2 && stats.BytesResident == 7 * KB );
+
+    cache.Get( c );
+    CHECK( counts.Decodes == 5 );
+    cache.GetStats( &stats );
+    CHECK( stats.BytesResident <= 10 * KB );
+
+    // a was evicted by that last Get, but the pointer from the first one
+    // still reads its data.
+    CHECK( held->Data.size() == 4 * KB - FormatBytes && held->Data[0] == 4 );
+
+    // A sound larger than the whole budget plays, but isn't kept.
+    std::shared_ptr<const SoundAsset> big = cache.Get( cache.Intern( L"20.wav" ) );
+    CHECK( big && big->Data.size() == 20 * KB - FormatBytes );
+    cache.GetStats( &stats );
+    CHECK( stats.BytesResident == 0 && stats.AssetsResident == 0 );
+}
+
+TEST( SoundCache_SetBudgetAndClear )
+{
+    DecoderCounts counts;
+    SoundCache cache( MakeDecoder( &counts ), 100 * KB );
+
+    SoundAssetId a = cache.Intern( L"4.wav" );
+    SoundAssetId b = cache.Intern( L"3.wav" );
+    SoundAssetId missing = cache.Intern( L"missing.wav" );
+
+    cache.Get( a );
+    cache.Get( b );
+
+    SoundCacheStats stats;
+    cache.SetBudget( 4 * KB );
+    cache.GetStats( &stats );
+    CHECK( stats.Budget == 4 * KB );
+    CHECK( stats.BytesResident == 3 * KB && stats.AssetsResident == 1 );
+
+    // A failed decode is remembered, not retried on every Get...
+    CHECK( !cache.Get( missing ) );
+    CHECK( !cache.Get( missing ) );
+    CHECK( counts.Decodes == 3 );
+
+    // ...until Clear, which also drops everything resident.
+    cache.Clear();
+    cache.GetStats( &stats );
+    CHECK( stats.BytesResident == 0 && stats.AssetsResident == 0 );
+    CHECK( !cache.Get( missing ) );
+    CHECK( counts.Decodes == 4 );
+
+    CHECK( cache.Get( b ) );
+    CHECK( counts.Decodes == 5 );
+}
+
+// A Get on a sound the loader thread is still decoding waits for it rather than
+// decoding it again, and a preloaded sound counts as a hit.
+TEST( SoundCache_PreloadDecodesOnce )
+{
+    DecoderCounts counts;
+    {
+        SoundCache cache( MakeDecoder( &counts, 50 ), 1024 * KB );
+        SoundAssetId a = cache.Intern( L"4.wav" );
+        SoundAssetId b = cache.Intern( L"2.wav" );
+
+        cache.Preload( a );
+        cache.Preload( a );
+        cache.Preload( b );
+
+        std::shared_ptr<const SoundAsset> asset = cache.Get( a );
+        CHECK( asset && asset->Data[0] == 4 );
+
+        std::this_thread::sleep_for( std::chrono::milliseconds( 150 ) );
+        CHECK( counts.Decodes == 2 );
+        CHECK( cache.Get( b ) );
+        CHECK( counts.Decodes == 2 );
+
+        SoundCacheStats stats;
+        cache.GetStats( &stats );
+        CHECK( stats.Misses == 0 && stats.Hits == 2 );
+
+        // Preloading a resident sound does nothing.
+        cache.Preload( a );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+        CHECK( counts.Decodes == 2 );
+
+        // Destroyed with work still queued.
+        cache.Preload( cache.Intern( L"7.wav" ) );
+        cache.Preload( cache.Intern( L"6.wav" ) );
+    }
+
+    CHECK( counts.LoaderBegins == 1 && counts.LoaderEnds == 1 );
+}
+
+// Several threads getting and preloading from a small cache always get the
+// sound they asked for, and the budget holds.
+TEST( SoundCache_ThreadedGets )
+{
+    DecoderCounts counts;
+    SoundCache cache( MakeDecoder( &counts ), 12 * KB );
+
+    const unsigned int soundCount = 8;
+    const unsigned int threadCount = 6;
+    const unsigned int getsPerThread = 40;
+
+    SoundAssetId ids[soundCount];
+    for ( unsigned int i = 0; i < soundCount; i++ )
+    {
+        ids[i] = cache.Intern( MakeName( i + 1 ) );
+    }
+
+    std::atomic<unsigned int> correct( 0 );
+    std::vector<std::thread> threads;
+    for ( unsigned int t = 0; t < threadCount; t++ )
+    {
+        threads.push_back( std::thread( [&, t]()
+        {
+            for ( unsigned int i = 0; i < getsPerThread; i++ )
+            {
+                if ( ( i % 5 ) == 0 )
+                {
+                    cache.Preload( ids[( i + t ) % soundCount] );
+                }
+
+                unsigned int index = ( i * 7 + t ) % soundCount;
+                std::shared_ptr<const SoundAsset> asset = cache.Get( ids[index] );
+                if ( asset && asset->Data[0] == index + 1 )
+                {
+                    correct++;
+                }
+            }
+        } ) );
+    }
+
+    for ( size_t t = 0; t < threads.size(); t++ )
+    {
+        threads[t].join();
+    }
+
+    SoundCacheStats stats;
+    cache.GetStats( &stats );
+    CHECK( correct == threadCount * getsPerThread );
+    CHECK( stats.BytesResident <= 12 * KB );
+    CHECK( stats.Hits + stats.Misses == threadCount * getsPerThread );
+}
+
+// What playing a cached sound costs the game thread: Intern by name and Get,
+// as SoundPlayer::PlaySound does, against decoding every time.
+BENCHMARK( SoundCache_HitLookup )
+{
+    const unsigned int iterations = 1000000;
+
+    DecoderCounts counts;
+    SoundCache cache( MakeDecoder( &counts ), 1024 * KB );
+    cache.Get( cache.Intern( L"200.wav" ) );
+
+    size_t total = 0;
+    double start = Tests::GetSeconds();
+    for ( unsigned int i = 0; i < iterations; i++ )
+    {
+        total += cache.Get( cache.Intern( L"200.wav" ) )->Data.size();
+    }
+    double seconds = Tests::GetSeconds() - start;
+
+    const unsigned int decodeIterations = 1000;
+    StandInDecoder decoder( &counts );
+    double decodeStart = Tests::GetSeconds();
+    for ( unsigned int i = 0; i < decodeIterations; i++ )
+    {
+        SoundAsset asset;
+        decoder.Decode( L"200.wav", &asset );
+        total += asset.Data.size();
+    }
+    double decodeSeconds = Tests::GetSeconds() - decodeStart;
+
+    CHECK( total != 0 );
+    wprintf( L"    200 KB sound: %.1f ns per cached Intern+Get, %.1f us per decode\n",
+             seconds * 1e9 / iterations, decodeSeconds * 1e6 / decodeIterations );
+}
@@ -0,0 +1,535 @@
+//--------------------------------------------------------------------------------------
+// File: StreamingReaderTests.cpp
+//
+// Most of these drive StreamingReader through a stand-in StreamingIO that holds
+// every read until the test completes it, so the order reads are issued in and
+// what happens when they land are deterministic.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "StreamingReader.h"
+
+using namespace DirectX;
+
+namespace
+{
+    const size_t Alignment = 4096;
+
+    // The byte at each file offset.
+    uint8_t PatternAt( uint64_t offset )
+    {
+        return static_cast<uint8_t>( ( offset * 2654435761u ) >> 13 );
+    }
+
+    class StandInIO : public StreamingIO
+    {
+    public:
+        explicit StandInIO( uint64_t fileSize ) :
+            FileSize( fileSize ),
+            RejectReads( false ),
+            FailReads( false ),
+            Misaligned( false )
+        {
+        }
+
+        virtual bool Read( uint64_t offset, uint8_t* dest, size_t bytes, Completion completion, void* context ) override
+        {
+            if ( RejectReads )
+            {
+                return false;
+            }
+
+            Misaligned = Misaligned || ( offset % Alignment ) != 0 || ( bytes % Alignment ) != 0
+                                    || ( reinterpret_cast<uintptr_t>( dest ) % Alignment ) != 0;
+
+            Request request = { offset, dest, bytes, completion, context };
+            Pending.push_back( request );
+            Offsets.push_back( offset );
+            return true;
+        }
+
+        virtual size_t GetAlignment() const override
+        {
+            return Alignment;
+        }
+
+        virtual uint64_t GetFileSize() const override
+        {
+            return FileSize;
+        }
+
+        // Completes the oldest read, short at the end of the file, as a worker
+        // thread would.
+        bool CompleteOne()
+        {
+            if ( Pending.empty() )
+            {
+                return false;
+            }
+
+            Request request = Pending.front();
+            Pending.pop_front();
+
+            size_t bytesRead = 0;
+            if ( request.offset < FileSize )
+            {
+                bytesRead = static_cast<size_t>( std::min<uint64_t>( request.bytes, FileSize - request.offset ) );
+            }
+
+            for ( size_t i = 0; i < bytesRead; i++ )
+            {
+                request.dest[i] = PatternAt( request.offset + i );
+            }
+
+            request.completion( request.context, bytesRead, !FailReads );
+            return true;
+        }
+
+        void CompleteAll()
+        {
+            while ( CompleteOne() )
+            {
+            }
+        }
+
+        struct Request
+        {
+            uint64_t    offset;
+            uint8_t*    dest;
+            size_t      bytes;
+            Completion  completion;
+            void*       context;
+        };
+
+        uint64_t                FileSize;
+        bool                    RejectReads;
+        bool                    FailReads;
+        bool                    Misaligned;
+        std::deque<Request>     Pending;
+        std::vector<uint64_t>   Offsets;
+    };
+
+    // Reads the stream to its end, completing reads one at a time when io is given
+    // and waiting on the reader otherwise. Checks every byte and that each buffer
+    // starts where its file offset falls in an aligned block.
+    bool ReadWholeStream( StreamingReader& reader, unsigned int stream, uint64_t offset, uint64_t length, StandInIO* io )
+    {
+        uint64_t position = offset;
+        bool matches = true;
+        while ( !reader.IsEndOfStream( stream ) )
+        {
+            StreamingBuffer buffer;
+            if ( reader.AcquireBuffer( stream, buffer ) )
+            {
+                for ( size_t i = 0; i < buffer.bytes; i++ )
+                {
+                    matches = matches && ( buffer.data[i] == PatternAt( position + i ) );
+                }
+
+                matches = matches && ( ( reinterpret_cast<uintptr_t>( buffer.data ) - position % Alignment ) % Alignment == 0 );
+                position += buffer.bytes;
+                reader.ReleaseBuffer( stream );
+            }
+            else if ( io )
+            {
+                if ( !io->CompleteOne() )
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                reader.WaitForBuffer( stream, 100 );
+            }
+        }
+
+        return matches && !reader.HasFailed( stream ) && position == offset + length;
+    }
+
+    const MappedFileChar TestFileName[] = L"StreamingReaderTests.bin";
+    const MappedFileChar MissingFileName[] = L"StreamingReaderTests_missing.bin";
+
+    bool WriteTestFile( const MappedFileChar* fileName, uint64_t bytes )
+    {
+        FILE* file = nullptr;
+        if ( _wfopen_s( &file, fileName, L"wb" ) != 0 || !file )
+        {
+            return false;
+        }
+
+        std::vector<uint8_t> block( 1024 * 1024 );
+        bool succeeded = true;
+        for ( uint64_t offset = 0; offset < bytes && succeeded; offset += block.size() )
+        {
+            size_t count = static_cast<size_t>( std::min<uint64_t>( block.size(), bytes - offset ) );
+            for ( size_t i = 0; i < count; i++ )
+            {
+                block[i] = PatternAt( offset + i );
+            }
+
+            succeeded = ( fwrite( &block[0], 1, count, file ) == count );
+        }
+
+        return ( fclose( file ) == 0 ) && succeeded;
+    }
+}
+
+TEST( StreamingReader_Construction )
+{
+    StandInIO io( 1024 * 1024 );
+
+    bool threw = false;
+    try
+    {
+        StreamingReader reader( &io, 65536, 0 );
+    }
+    catch ( const std::invalid_argument& )
+    {
+        threw = true;
+    }
+
+    CHECK( threw );
+
+    StreamingReader reader( &io, 10000, 16, 4, 8 );
+    CHECK( reader.GetBufferBytes() == 12288 );
+
+    threw = false;
+    try
+    {
+        reader.OpenStream( 0, 0, 4 );
+    }
+    catch ( const std::invalid_argument& )
+    {
+        threw = true;
+    }
+
+    CHECK( threw );
+
+    CHECK( StreamingReader::ComputeReadAhead( 176400, 65536, 0.05 ) == 2 );
+    CHECK( StreamingReader::ComputeReadAhead( 1411200, 16384, 0.1 ) == 10 );
+    CHECK( StreamingReader::ComputeReadAhead( 1411200, 0, 0.1 ) == 2 );
+}
+
+// A stretch that starts and ends partway through aligned blocks comes back byte
+// for byte, with every read aligned and no more than readAhead of them ahead.
+TEST( StreamingReader_ReadsUnalignedStretches )
+{
+    StandInIO io( 1024 * 1024 );
+    StreamingReader reader( &io, 10000, 16, 4, 8 );
+
+    const uint64_t offsets[] = { 0, 7, 2048 + 7, 4095, 12288 };
+    const uint64_t lengths[] = { 1, 100, 12288, 100000, 300001 };
+    for ( size_t i = 0; i < ARRAYSIZE( offsets ); i++ )
+    {
+        for ( size_t j = 0; j < ARRAYSIZE( lengths ); j++ )
+        {
+            unsigned int stream = reader.OpenStream( offsets[i], lengths[j], 3 );
+            CHECK( stream != 0 );
+            CHECK( io.Pending.size() <= 3 );
+            CHECK( ReadWholeStream( reader, stream, offsets[i], lengths[j], &io ) );
+            reader.CloseStream( stream );
+        }
+    }
+
+    CHECK( !io.Misaligned );
+
+    StreamingStatistics stats = reader.GetStatistics();
+    CHECK( stats.openStreams == 0 && stats.buffersFree == 16 && stats.readsInFlight == 0 );
+    CHECK( stats.readErrors == 0 && stats.firstBuffers == ARRAYSIZE( offsets ) * ARRAYSIZE( lengths ) );
+}
+
+// With reads to spare only for the first stream, a stream yet to start goes
+// before its read-ahead, the higher priority first.
+TEST( StreamingReader_MostUrgentFirst )
+{
+    StandInIO io( 4 * 1024 * 1024 );
+    StreamingReader reader( &io, 4096, 32, 2, 8 );
+
+    unsigned int first = reader.OpenStream( 0, 1024 * 1024, 8 );
+    CHECK( io.Pending.size() == 2 );
+
+    unsigned int low = reader.OpenStream( 512 * 1024, 1024 * 1024, 8, 0 );
+    unsigned int high = reader.OpenStream( 768 * 1024, 1024 * 1024, 8, 5 );
+    CHECK( io.Pending.size() == 2 );
+
+    io.CompleteOne();
+    io.CompleteOne();
+    CHECK( io.Offsets.size() == 4 );
+    CHECK( io.Offsets[2] == 768 * 1024 && io.Offsets[3] == 512 * 1024 );
+
+    CHECK( ReadWholeStream( reader, first, 0, 1024 * 1024, &io ) );
+
+    // Buffers of closed streams come back as their reads land.
+    reader.CloseStream( low );
+    reader.CloseStream( high );
+    io.CompleteAll();
+    CHECK( reader.GetStatistics().buffersFree == 32 );
+}
+
+// A looping stream wraps to its start without ending, and the consumer can hold
+// several buffers at once.
+TEST( StreamingReader_LoopsAndHolds )
+{
+    StandInIO io( 1024 * 1024 );
+    StreamingReader reader( &io, 4096, 8, 4, 4 );
+
+    const uint64_t start = 3 * 4096 + 100;
+    const uint64_t length = 20000;
+    unsigned int stream = reader.OpenStream( start, length, 4, 0, true );
+
+    uint64_t position = start;
+    uint64_t consumed = 0;
+    bool matches = true;
+    while ( consumed < 10 * length )
+    {
+        StreamingBuffer buffer;
+        if ( reader.AcquireBuffer( stream, buffer ) )
+        {
+            for ( size_t i = 0; i < buffer.bytes; i++ )
+            {
+                matches = matches && ( buffer.data[i] == PatternAt( position ) );
+                if ( ++position == start + length )
+                {
+                    position = start;
+                }
+            }
+
+            consumed += buffer.bytes;
+            reader.ReleaseBuffer( stream );
+        }
+        else
+        {
+            io.CompleteOne();
+        }
+    }
+
+    CHECK( matches );
+    CHECK( !reader.IsEndOfStream( stream ) );
+
+    io.CompleteAll();
+    StreamingBuffer held[3];
+    CHECK( reader.AcquireBuffer( stream, held[0] ) && reader.AcquireBuffer( stream, held[1] ) && reader.AcquireBuffer( stream, held[2] ) );
+    CHECK( held[0].data != held[1].data && held[1].data != held[2].data );
+    CHECK( reader.GetStatistics().buffersFree + 3 <= 8 );
+
+    // Releasing gives back the oldest, which the next read may reuse.
+    reader.ReleaseBuffer( stream );
+    reader.ReleaseBuffer( stream );
+    reader.ReleaseBuffer( stream );
+    io.CompleteAll();
+    reader.CloseStream( stream );
+    CHECK( reader.IsEndOfStream( stream ) && !reader.HasFailed( stream ) );
+    CHECK( reader.GetStatistics().buffersFree == 8 );
+}
+
+// A stretch past the end of the file, a failed read and a read the backend won't
+// start each fail the stream without touching the others.
+TEST( StreamingReader_Failures )
+{
+    StandInIO io( 64 * 1024 );
+    StreamingReader reader( &io, 4096, 16, 4, 4 );
+
+    unsigned int good = reader.OpenStream( 0, 8192, 2 );
+    unsigned int pastEnd = reader.OpenStream( 60 * 1024, 8192, 2 );
+    io.CompleteAll();
+    CHECK( reader.HasFailed( pastEnd ) && reader.IsEndOfStream( pastEnd ) );
+    CHECK( !reader.HasFailed( good ) );
+    CHECK( ReadWholeStream( reader, good, 0, 8192, &io ) );
+
+    StreamingBuffer buffer;
+    CHECK( !reader.AcquireBuffer( pastEnd, buffer ) );
+    CHECK( !reader.WaitForBuffer( pastEnd, 1000 ) );
+    reader.CloseStream( pastEnd );
+    reader.CloseStream( good );
+
+    io.FailReads = true;
+    unsigned int failed = reader.OpenStream( 0, 8192, 2 );
+    io.CompleteAll();
+    CHECK( reader.HasFailed( failed ) );
+    reader.CloseStream( failed );
+    io.FailReads = false;
+
+    io.RejectReads = true;
+    unsigned int rejected = reader.OpenStream( 0, 8192, 2 );
+    CHECK( rejected != 0 && reader.HasFailed( rejected ) );
+    reader.CloseStream( rejected );
+    io.RejectReads = false;
+
+    StreamingStatistics stats = reader.GetStatistics();
+    CHECK( stats.readErrors >= 3 && stats.buffersFree == 16 && stats.openStreams == 0 );
+
+    // Handles of closed streams are never handed out again.
+    unsigned int reopened = reader.OpenStream( 0, 8192, 2 );
+    CHECK( reopened != good && reopened != pastEnd && reopened != failed && reopened != rejected );
+    CHECK( !reader.HasFailed( good ) && reader.IsEndOfStream( good ) );
+    reader.CloseStream( reopened );
+    io.CompleteAll();
+}
+
+// Every stream slot in use makes OpenStream return 0; closing streams with reads
+// in flight, over and over, loses no buffers.
+TEST( StreamingReader_StreamsAndBuffers )
+{
+    StandInIO io( 8 * 1024 * 1024 );
+    StreamingReader reader( &io, 4096, 32, 8, 8 );
+
+    unsigned int streams[8];
+    for ( int i = 0; i < 8; i++ )
+    {
+        streams[i] = reader.OpenStream( i * 100000, 100000, 4 );
+        CHECK( streams[i] != 0 );
+    }
+
+    CHECK( reader.OpenStream( 0, 100000, 4 ) == 0 );
+    CHECK( reader.GetStatistics().openStreams == 8 );
+
+    std::mt19937 random( 5 );
+    for ( int k = 0; k < 2000; k++ )
+    {
+        int i = static_cast<int>( random() % 8 );
+        switch ( random() % 4 )
+        {
+        case 0:
+            reader.CloseStream( streams[i] );
+            streams[i] = reader.OpenStream( random() % ( 4 * 1024 * 1024 ), random() % 200000 + 1, random() % 8 + 1,
+                                             static_cast<int>( random() % 3 ) - 1, ( random() % 2 ) != 0 );
+            CHECK( streams[i] != 0 );
+            break;
+
+        case 1:
+            {
+                StreamingBuffer buffer;
+                reader.AcquireBuffer( streams[i], buffer );
+            }
+            break;
+
+        case 2:
+            reader.ReleaseBuffer( streams[i] );
+            break;
+
+        default:
+            io.CompleteOne();
+            break;
+        }
+    }
+
+    for ( int i = 0; i < 8; i++ )
+    {
+        reader.CloseStream( streams[i] );
+    }
+
+    io.CompleteAll();
+    StreamingStatistics stats = reader.GetStatistics();
+    CHECK( stats.buffersFree == 32 && stats.readsInFlight == 0 && stats.openStreams == 0 );
+    CHECK( !io.Misaligned );
+}
+
+// The thread pool backend on a real file: concurrent streams come back intact,
+// the reader can go with reads in flight, and a missing file gives nullptr.
+TEST( StreamingReader_ThreadPoolFile )
+{
+    const uint64_t fileBytes = 8 * 1024 * 1024;
+    CHECK( WriteTestFile( TestFileName, fileBytes ) );
+
+    CHECK( !CreateThreadPoolStreamingIO( MissingFileName ) );
+
+    for ( int unbuffered = 0; unbuffered < 2; unbuffered++ )
+    {
+        std::unique_ptr<StreamingIO> io = CreateThreadPoolStreamingIO( TestFileName, 3, unbuffered != 0 );
+        CHECK( io && io->GetFileSize() == fileBytes );
+        if ( !io )
+        {
+            continue;
+        }
+
+        {
+            StreamingReader reader( io.get(), 16384, 24, 4, 8 );
+
+            unsigned int streams[6];
+            uint64_t positions[6];
+            uint64_t ends[6];
+            for ( int i = 0; i < 6; i++ )
+            {
+                positions[i] = i * 1000003ull;
+                ends[i] = positions[i] + 300000 + i * 777;
+                streams[i] = reader.OpenStream( positions[i], ends[i] - positions[i], 3, i & 1 );
+            }
+
+            bool matches = true;
+            for ( int finished = 0; finished < 6; )
+            {
+                finished = 0;
+                for ( int i = 0; i < 6; i++ )
+                {
+                    StreamingBuffer buffer;
+                    if ( reader.IsEndOfStream( streams[i] ) )
+                    {
+                        finished++;
+                    }
+                    else if ( reader.AcquireBuffer( streams[i], buffer ) )
+                    {
+                        for ( size_t k = 0; k < buffer.bytes; k++ )
+                        {
+                            matches = matches && ( buffer.data[k] == PatternAt( positions[i] + k ) );
+                        }
+
+                        positions[i] += buffer.bytes;
+                        reader.ReleaseBuffer( streams[i] );
+                    }
+                    else
+                    {
+                        reader.WaitForBuffer( streams[i], 5 );
+                    }
+                }
+            }
+
+            CHECK( matches );
+            for ( int i = 0; i < 6; i++ )
+            {
+                CHECK( !reader.HasFailed( streams[i] ) && positions[i] == ends[i] );
+                reader.CloseStream( streams[i] );
+            }
+
+            unsigned int last = reader.OpenStream( fileBytes - 4096, 100000, 4 );
+            while ( !reader.IsEndOfStream( last ) )
+            {
+                reader.WaitForBuffer( last, 100 );
+            }
+
+            CHECK( reader.HasFailed( last ) );
+            reader.CloseStream( last );
+
+            // Goes out of scope with this one still reading.
+            reader.OpenStream( 0, fileBytes, 16 );
+        }
+    }
+
+    _wremove( TestFileName );
+}
+
+// Sustained throughput and first-buffer latency from a 64 MB file as the number
+// of streams grows, with one stream restarting every 10 ms.
+BENCHMARK( StreamingReader_StreamCounts )
+{
+    CHECK( WriteTestFile( TestFileName, 64 * 1024 * 1024 ) );
+
+    const size_t streamCounts[] = { 4, 16, 64 };
+    for ( size_t i = 0; i < ARRAYSIZE( streamCounts ); i++ )
+    {
+        StreamingBenchmark result = BenchmarkStreamingReader( TestFileName, streamCounts[i], 4, 65536, 4, 2.0 );
+        CHECK( result.bytesRead > 0 );
+        wprintf( L"    %3u streams: %.0f MB/s, read %.3f ms, first buffer %.3f ms (max %.3f ms)\n",
+                 static_cast<unsigned int>( result.streams ), result.megabytesPerSecond, result.averageReadSeconds * 1e3,
+                 result.averageFirstBufferSeconds * 1e3, result.maxFirstBufferSeconds * 1e3 );
+    }
+
+    _wremove( TestFileName );
+}
@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------------------------
+// File: TestFramework.h
+//
+// Minimal test and benchmark registration for the Tests console project.
+//
+//     TEST( TransformHierarchy_ChildFollowsParent )
+//     {
+//         ...
+//         CHECK( hierarchy.GetNodeCount() == 2 );
+//     }
+//
+// TEST bodies run every time the executable runs; BENCHMARK bodies only run with
+// -benchmark, and report their timings with wprintf. A failed CHECK is reported and
+// the test carries on, so one run lists every failure.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+namespace Tests
+{
+    typedef void (*TestFunction)();
+
+    // Adds a test to the list TestMain runs. Used by the macros below, from static
+    // initializers, so the list is built before main starts.
+    struct TestRegistration
+    {
+        TestRegistration( const char* name, TestFunction function, bool isBenchmark );
+    };
+
+    // Records a failed CHECK against the test that is running.
+    void ReportFailure( const char* file, int line, const char* expression );
+
+    // Seconds on a monotonic clock with sub-microsecond resolution.
+    double GetSeconds();
+
+    inline bool IsNear( double a, double b, double tolerance )
+    {
+        return fabs( a - b ) <= tolerance;
+    }
+}
+
+#define TEST_REGISTER_( name, isBenchmark ) \
+    static void name(); \
+    static ::Tests::TestRegistration name##_registration( #name, name, isBenchmark ); \
+    static void name()
+
+#define TEST( name )        TEST_REGISTER_( name, false )
+#define BENCHMARK( name )   TEST_REGISTER_( name, true )
+
+#define CHECK( expression ) \
+    do { if ( !( expression ) ) ::Tests::ReportFailure( __FILE__, __LINE__, #expression ); } while( 0 )
@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------------------
+// File: TestMain.cpp
+//
+// Runs the registered tests, and with -benchmark the benchmarks as well:
+//
+//   Tests [-benchmark] [name]
+//
+// name limits the run to tests whose name contains it. The exit code is the number
+// of tests that failed.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+
+namespace
+{
+    struct TestEntry
+    {
+        const char*             name;
+        Tests::TestFunction     function;
+        bool                    isBenchmark;
+    };
+
+    // Function-local so that registrations from other translation units' static
+    // initializers never see it unconstructed.
+    std::vector<TestEntry>& GetTests()
+    {
+        static std::vector<TestEntry> s_tests;
+        return s_tests;
+    }
+
+    unsigned int g_failures = 0;
+}
+
+Tests::TestRegistration::TestRegistration( const char* name, TestFunction function, bool isBenchmark )
+{
+    TestEntry entry = { name, function, isBenchmark };
+    GetTests().push_back( entry );
+}
+
+void Tests::ReportFailure( const char* file, int line, const char* expression )
+{
+    wprintf( L"    %S(%d): CHECK( %S ) failed\n", file, line, expression );
+    g_failures++;
+}
+
+double Tests::GetSeconds()
+{
+    static LARGE_INTEGER s_frequency = {};
+    if ( !s_frequency.QuadPart )
+    {
+        QueryPerformanceFrequency( &s_frequency );
+    }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter( &counter );
+    return double( counter.QuadPart ) / double( s_frequency.QuadPart );
+}
+
+int __cdecl main( int argc, char* argv[] )
+{
+    bool runBenchmarks = false;
+    const char* filter = nullptr;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( !strcmp( argv[i], "-benchmark" ) )
+        {
+            runBenchmarks = true;
+        }
+        else if ( argv[i][0] == '-' )
+        {
+            wprintf( L"Usage: Tests [-benchmark] [name]\n" );
+            return 1;
+        }
+        else
+        {
+            filter = argv[i];
+        }
+    }
+
+    unsigned int run = 0;
+    unsigned int failed = 0;
+
+    const std::vector<TestEntry>& tests = GetTests();
+    for ( size_t i = 0; i < tests.size(); i++ )
+    {
+        const TestEntry& test = tests[i];
+        if ( ( test.isBenchmark && !runBenchmarks ) || ( filter && !strstr( test.name, filter ) ) )
+        {
+            continue;
+        }
+
+        wprintf( L"%s %S\n", test.isBenchmark ? L"[bench]" : L"[test ]", test.name );
+
+        unsigned int failuresBefore = g_failures;
+        try
+        {
+            test.function();
+        }
+        catch ( const std::exception& e )
+        {
+            wprintf( L"    unhandled exception: %S\n", e.what() );
+            g_failures++;
+        }
+        catch ( ... )
+        {
+            wprintf( L"    unhandled exception\n" );
+            g_failures++;
+        }
+
+        run++;
+        if ( g_failures != failuresBefore )
+        {
+            failed++;
+        }
+    }
+
+    wprintf( L"%u run, %u failed\n", run, failed );
+
+    return int( failed );
+}
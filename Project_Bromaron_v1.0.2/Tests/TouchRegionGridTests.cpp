@@ -0,0 +1,226 @@
+//--------------------------------------------------------------------------------------
+// File: TouchRegionGridTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "TouchRegionGrid.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    struct TestRegion
+    {
+        float   Left;
+        float   Top;
+        float   Right;
+        float   Bottom;
+        int     Priority;
+        bool    IsEnabled;
+    };
+
+    // The hit test InputManager did before the grid: every region, in the order
+    // added, keeping the highest priority.
+    int LinearHitTest( const std::vector<TestRegion>& regions, float x, float y )
+    {
+        int hit = -1;
+        for ( size_t i = 0; i < regions.size(); i++ )
+        {
+            const TestRegion& region = regions[i];
+            if ( region.IsEnabled
+                && x >= region.Left && x <= region.Right
+                && y >= region.Top && y <= region.Bottom
+                && ( hit < 0 || region.Priority > regions[hit].Priority ) )
+            {
+                hit = static_cast<int>( i );
+            }
+        }
+
+        return hit;
+    }
+
+    // A screen's worth of overlapping regions at a few priorities.
+    void MakeRandomLayout( std::mt19937& random, unsigned int count, std::vector<TestRegion>* regions, TouchRegionGrid* grid )
+    {
+        std::uniform_real_distribution<float> position( 0.0f, 1800.0f );
+        std::uniform_real_distribution<float> size( 20.0f, 300.0f );
+        std::uniform_int_distribution<int> priority( 0, 3 );
+
+        regions->clear();
+        grid->Clear();
+
+        for ( unsigned int i = 0; i < count; i++ )
+        {
+            TestRegion region;
+            region.Left = position( random );
+            region.Top = position( random ) * 0.6f;
+            region.Right = region.Left + size( random );
+            region.Bottom = region.Top + size( random );
+            region.Priority = priority( random );
+            region.IsEnabled = ( i % 5 ) != 4;
+
+            int id = grid->AddRegion( region.Left, region.Top, region.Right, region.Bottom, region.Priority );
+            CHECK( id == static_cast<int>( i ) );
+            grid->SetEnabled( i, region.IsEnabled );
+
+            regions->push_back( region );
+        }
+    }
+}
+
+TEST( TouchRegionGrid_HitsEdgesAndPriorities )
+{
+    TouchRegionGrid grid;
+    CHECK( grid.HitTest( 10.0f, 10.0f ) == -1 );
+
+    CHECK( grid.AddRegion( 0.0f, 0.0f, 100.0f, 100.0f ) == 0 );
+    CHECK( grid.AddRegion( 100.0f, 0.0f, 200.0f, 100.0f ) == 1 );
+    CHECK( grid.AddRegion( 50.0f, 50.0f, 150.0f, 150.0f, 1 ) == 2 );
+    CHECK( grid.GetRegionCount() == 3 );
+
+    CHECK( grid.HitTest( 10.0f, 10.0f ) == 0 );
+    CHECK( grid.HitTest( 190.0f, 10.0f ) == 1 );
+
+    // Edges are inclusive; a shared edge goes to the region added first.
+    CHECK( grid.HitTest( 0.0f, 0.0f ) == 0 );
+    CHECK( grid.HitTest( 100.0f, 10.0f ) == 0 );
+    CHECK( grid.HitTest( 200.0f, 100.0f ) == 1 );
+
+    // The higher priority wins where regions overlap.
+    CHECK( grid.HitTest( 75.0f, 75.0f ) == 2 );
+    CHECK( grid.HitTest( 125.0f, 75.0f ) == 2 );
+
+    // Outside the bounding box, or inside it but in no region.
+    CHECK( grid.HitTest( -1.0f, 10.0f ) == -1 );
+    CHECK( grid.HitTest( 10.0f, 500.0f ) == -1 );
+    CHECK( grid.HitTest( 10.0f, 140.0f ) == -1 );
+
+    // A disabled region uncovers the ones below it.
+    grid.SetEnabled( 2, false );
+    CHECK( !grid.IsEnabled( 2 ) );
+    CHECK( grid.HitTest( 75.0f, 75.0f ) == 0 );
+    CHECK( grid.HitTest( 125.0f, 140.0f ) == -1 );
+    grid.SetEnabled( 2, true );
+    CHECK( grid.HitTest( 75.0f, 75.0f ) == 2 );
+
+    CHECK( !grid.IsEnabled( 7 ) );
+    grid.Clear();
+    CHECK( grid.GetRegionCount() == 0 );
+    CHECK( grid.HitTest( 10.0f, 10.0f ) == -1 );
+}
+
+TEST( TouchRegionGrid_RejectsInvalidRegions )
+{
+    TouchRegionGrid grid;
+    CHECK( grid.AddRegion( 10.0f, 0.0f, 5.0f, 10.0f ) == -1 );
+    CHECK( grid.AddRegion( 0.0f, 10.0f, 10.0f, 5.0f ) == -1 );
+
+    // A single point is a valid region.
+    CHECK( grid.AddRegion( 3.0f, 3.0f, 3.0f, 3.0f ) == 0 );
+    CHECK( grid.HitTest( 3.0f, 3.0f ) == 0 );
+
+    for ( unsigned int i = 1; i < TOUCH_REGION_GRID_MAX_REGIONS; i++ )
+    {
+        CHECK( grid.AddRegion( float( i ) * 10.0f, 0.0f, float( i ) * 10.0f + 5.0f, 5.0f ) == static_cast<int>( i ) );
+    }
+
+    CHECK( grid.AddRegion( 0.0f, 100.0f, 10.0f, 110.0f ) == -1 );
+    CHECK( grid.GetRegionCount() == TOUCH_REGION_GRID_MAX_REGIONS );
+    CHECK( grid.HitTest( 312.0f, 2.0f ) == 31 );
+}
+
+// Random layouts give the same answer as the linear scan everywhere, including
+// on region edges.
+TEST( TouchRegionGrid_MatchesLinearScan )
+{
+    std::mt19937 random( 35 );
+    std::uniform_real_distribution<float> point( -50.0f, 2200.0f );
+
+    unsigned int mismatches = 0;
+    unsigned int hits = 0;
+
+    for ( unsigned int layout = 0; layout < 20; layout++ )
+    {
+        std::vector<TestRegion> regions;
+        TouchRegionGrid grid;
+        MakeRandomLayout( random, TOUCH_REGION_GRID_MAX_REGIONS, &regions, &grid );
+
+        for ( unsigned int i = 0; i < 5000; i++ )
+        {
+            float x = point( random );
+            float y = point( random ) * 0.6f;
+
+            // Every fourth point sits exactly on a corner of some region.
+            if ( ( i & 3 ) == 0 )
+            {
+                const TestRegion& region = regions[i % regions.size()];
+                x = ( i & 4 ) ? region.Left : region.Right;
+                y = ( i & 8 ) ? region.Top : region.Bottom;
+            }
+
+            int expected = LinearHitTest( regions, x, y );
+            mismatches += ( grid.HitTest( x, y ) != expected ) ? 1 : 0;
+            hits += ( expected >= 0 ) ? 1 : 0;
+        }
+    }
+
+    CHECK( mismatches == 0 );
+    CHECK( hits > 0 );
+}
+
+// Hit tests per second for a full layout, through the grid and the linear scan.
+BENCHMARK( TouchRegionGrid_HitTestThroughput )
+{
+    const unsigned int pointCount = 4096;
+    const unsigned int passes = 500;
+
+    std::mt19937 random( 1 );
+    std::vector<TestRegion> regions;
+    TouchRegionGrid grid;
+    MakeRandomLayout( random, TOUCH_REGION_GRID_MAX_REGIONS, &regions, &grid );
+
+    std::uniform_real_distribution<float> point( 0.0f, 2000.0f );
+    std::vector<float> xs( pointCount );
+    std::vector<float> ys( pointCount );
+    for ( unsigned int i = 0; i < pointCount; i++ )
+    {
+        xs[i] = point( random );
+        ys[i] = point( random ) * 0.6f;
+    }
+
+    int gridSum = 0;
+    double start = Tests::GetSeconds();
+    for ( unsigned int pass = 0; pass < passes; pass++ )
+    {
+        for ( unsigned int i = 0; i < pointCount; i++ )
+        {
+            gridSum += grid.HitTest( xs[i], ys[i] );
+        }
+    }
+    double gridSeconds = Tests::GetSeconds() - start;
+
+    int linearSum = 0;
+    start = Tests::GetSeconds();
+    for ( unsigned int pass = 0; pass < passes; pass++ )
+    {
+        for ( unsigned int i = 0; i < pointCount; i++ )
+        {
+            linearSum += LinearHitTest( regions, xs[i], ys[i] );
+        }
+    }
+    double linearSeconds = Tests::GetSeconds() - start;
+
+    CHECK( gridSum == linearSum );
+
+    double tests = double( pointCount ) * passes;
+    wprintf( L"    %u regions: grid %.1f ns, linear scan %.1f ns per hit test\n",
+             TOUCH_REGION_GRID_MAX_REGIONS, gridSeconds * 1e9 / tests, linearSeconds * 1e9 / tests );
+}
@@ -0,0 +1,199 @@
+//--------------------------------------------------------------------------------------
+// File: TransformHierarchyTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "TransformHierarchy.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    bool MatricesNear( FXMMATRIX a, CXMMATRIX b )
+    {
+        XMFLOAT4X4 fa, fb;
+        XMStoreFloat4x4( &fa, a );
+        XMStoreFloat4x4( &fb, b );
+
+        for ( int r = 0; r < 4; r++ )
+        {
+            for ( int c = 0; c < 4; c++ )
+            {
+                if ( !Tests::IsNear( fa.m[r][c], fb.m[r][c], 1e-4 ) )
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    XMMATRIX ComposeLocal( FXMVECTOR scale, FXMVECTOR quaternion, FXMVECTOR translation )
+    {
+        return XMMatrixScaling( XMVectorGetX( scale ), XMVectorGetY( scale ), XMVectorGetZ( scale ) )
+             * XMMatrixRotationQuaternion( quaternion )
+             * XMMatrixTranslation( XMVectorGetX( translation ), XMVectorGetY( translation ), XMVectorGetZ( translation ) );
+    }
+}
+
+// The camera -> laser -> target chain the renderer used to build by hand.
+TEST( TransformHierarchy_MatchesExplicitChain )
+{
+    TransformHierarchy hierarchy;
+    TransformNode camera = hierarchy.AddNode();
+    TransformNode laser = hierarchy.AddNode( camera );
+    TransformNode target = hierarchy.AddNode( laser );
+
+    XMVECTOR cameraRotation = XMQuaternionRotationRollPitchYaw( 0.3f, -1.1f, 0.0f );
+    XMVECTOR cameraPosition = XMVectorSet( 4.0f, 1.5f, -7.0f, 0.0f );
+    XMVECTOR laserRotation = XMQuaternionRotationRollPitchYaw( 0.0f, 0.25f, 0.5f );
+    XMVECTOR laserOffset = XMVectorSet( 0.2f, -0.3f, 1.0f, 0.0f );
+    XMVECTOR targetScale = XMVectorSet( 0.5f, 0.5f, 2.0f, 0.0f );
+    XMVECTOR targetOffset = XMVectorSet( 0.0f, 0.0f, 25.0f, 0.0f );
+    XMVECTOR one = XMVectorSplatOne();
+
+    hierarchy.SetLocalTransform( camera, one, cameraRotation, cameraPosition );
+    hierarchy.SetLocalTransform( laser, one, laserRotation, laserOffset );
+    hierarchy.SetLocalTransform( target, targetScale, XMQuaternionIdentity(), targetOffset );
+
+    CHECK( hierarchy.Update() == 3 );
+
+    XMMATRIX cameraWorld = ComposeLocal( one, cameraRotation, cameraPosition );
+    XMMATRIX laserWorld = ComposeLocal( one, laserRotation, laserOffset ) * cameraWorld;
+    XMMATRIX targetWorld = ComposeLocal( targetScale, XMQuaternionIdentity(), targetOffset ) * laserWorld;
+
+    CHECK( MatricesNear( hierarchy.GetWorldMatrix( camera ), cameraWorld ) );
+    CHECK( MatricesNear( hierarchy.GetWorldMatrix( laser ), laserWorld ) );
+    CHECK( MatricesNear( hierarchy.GetWorldMatrix( target ), targetWorld ) );
+
+    // Moving the camera carries the whole chain along.
+    cameraPosition = XMVectorSet( -2.0f, 0.0f, 3.0f, 0.0f );
+    hierarchy.SetLocalTranslation( camera, cameraPosition );
+    CHECK( hierarchy.Update() == 3 );
+
+    cameraWorld = ComposeLocal( one, cameraRotation, cameraPosition );
+    laserWorld = ComposeLocal( one, laserRotation, laserOffset ) * cameraWorld;
+    targetWorld = ComposeLocal( targetScale, XMQuaternionIdentity(), targetOffset ) * laserWorld;
+
+    CHECK( MatricesNear( hierarchy.GetWorldMatrix( target ), targetWorld ) );
+}
+
+TEST( TransformHierarchy_OnlyDirtySubtreesUpdate )
+{
+    TransformHierarchy hierarchy;
+    TransformNode rootA = hierarchy.AddNode();
+    TransformNode childA = hierarchy.AddNode( rootA );
+    TransformNode rootB = hierarchy.AddNode();
+    TransformNode childB = hierarchy.AddNode( rootB );
+    TransformNode grandchildB = hierarchy.AddNode( childB );
+
+    CHECK( hierarchy.Update() == 5 );
+    CHECK( hierarchy.Update() == 0 );
+
+    // Setting a value a node already has leaves it clean.
+    hierarchy.SetLocalTranslation( childA, XMVectorZero() );
+    CHECK( !hierarchy.IsDirty( childA ) );
+    CHECK( hierarchy.Update() == 0 );
+
+    // childB and everything below it; rootB and the first tree stay as they were.
+    hierarchy.SetLocalTranslation( childB, XMVectorSet( 1.0f, 2.0f, 3.0f, 0.0f ) );
+    CHECK( hierarchy.IsDirty( childB ) );
+    CHECK( hierarchy.Update() == 2 );
+
+    XMMATRIX expected = XMMatrixTranslation( 1.0f, 2.0f, 3.0f );
+    CHECK( MatricesNear( hierarchy.GetWorldMatrix( grandchildB ), expected ) );
+    CHECK( MatricesNear( hierarchy.GetWorldMatrix( rootB ), XMMatrixIdentity() ) );
+
+    hierarchy.SetLocalScale( rootA, XMVectorReplicate( 2.0f ) );
+    CHECK( hierarchy.Update() == 2 );
+}
+
+TEST( TransformHierarchy_RejectsParentsAfterChildren )
+{
+    TransformHierarchy hierarchy;
+    TransformNode root = hierarchy.AddNode();
+
+    CHECK( hierarchy.AddNode( root + 1 ) == INVALID_TRANSFORM_NODE );
+    CHECK( hierarchy.GetNodeCount() == 1 );
+
+    CHECK( hierarchy.AddNode( root ) == 1 );
+    CHECK( hierarchy.GetParent( 1 ) == root );
+
+    hierarchy.Clear();
+    CHECK( hierarchy.GetNodeCount() == 0 );
+    CHECK( hierarchy.GetWorldMatrices() == nullptr );
+    CHECK( hierarchy.Update() == 0 );
+}
+
+// 100k nodes as 25k four-deep chains: a full rebuild, then the per-frame case where
+// only a handful of roots move.
+BENCHMARK( TransformHierarchy_Update100k )
+{
+    const unsigned int chainCount = 25000;
+    const unsigned int chainDepth = 4;
+    const unsigned int iterations = 20;
+
+    TransformHierarchy hierarchy;
+    hierarchy.Reserve( chainCount * chainDepth );
+
+    std::vector<TransformNode> roots;
+    roots.reserve( chainCount );
+
+    for ( unsigned int c = 0; c < chainCount; c++ )
+    {
+        TransformNode node = hierarchy.AddNode();
+        roots.push_back( node );
+
+        for ( unsigned int d = 1; d < chainDepth; d++ )
+        {
+            node = hierarchy.AddNode( node );
+            hierarchy.SetLocalTranslation( node, XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f ) );
+        }
+    }
+
+    hierarchy.Update();
+
+    double fullSeconds = 0.0;
+    double partialSeconds = 0.0;
+    unsigned int partialUpdated = 0;
+
+    for ( unsigned int i = 0; i < iterations; i++ )
+    {
+        // Never zero, so every set below really changes the node.
+        float angle = float( i + 1 ) * 0.01f;
+
+        for ( unsigned int c = 0; c < chainCount; c++ )
+        {
+            hierarchy.SetLocalRotation( roots[c], XMQuaternionRotationRollPitchYaw( 0.0f, angle, 0.0f ) );
+        }
+
+        double start = Tests::GetSeconds();
+        CHECK( hierarchy.Update() == chainCount * chainDepth );
+        fullSeconds += Tests::GetSeconds() - start;
+
+        // One root in a hundred moves, spread over the whole array.
+        for ( unsigned int c = i % 100; c < chainCount; c += 100 )
+        {
+            hierarchy.SetLocalTranslation( roots[c], XMVectorSet( angle, 0.0f, 0.0f, 0.0f ) );
+        }
+
+        start = Tests::GetSeconds();
+        partialUpdated = hierarchy.Update();
+        partialSeconds += Tests::GetSeconds() - start;
+    }
+
+    wprintf( L"    %u nodes: full update %.3f ms, %u dirty nodes %.3f ms\n",
+             hierarchy.GetNodeCount(),
+             fullSeconds * 1000.0 / iterations,
+             partialUpdated,
+             partialSeconds * 1000.0 / iterations );
+}
@@ -0,0 +1,362 @@
+//--------------------------------------------------------------------------------------
+// File: VoicePoolTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "VoicePool.h"
+
+using namespace DirectX;
+
+namespace
+{
+    double gNow = 0.0;
+
+    double StandInClock()
+    {
+        return gNow;
+    }
+
+    // Each voice is a heap int holding the key it was made for; the factory keeps
+    // the live ones, so a voice destroyed twice or leaked shows up.
+    class StandInFactory : public IVoicePoolFactory
+    {
+    public:
+        StandInFactory() :
+            Fail( false ),
+            Throw( false ),
+            DoubleDestroys( 0 )
+        {
+        }
+
+        virtual ~StandInFactory()
+        {
+            for ( auto it = Live.begin(); it != Live.end(); ++it )
+            {
+                delete *it;
+            }
+        }
+
+        virtual void* CreatePoolVoice( unsigned int key ) override
+        {
+            if ( Throw )
+            {
+                throw std::runtime_error( "CreatePoolVoice" );
+            }
+
+            if ( Fail )
+            {
+                return nullptr;
+            }
+
+            int* voice = new int( static_cast<int>( key ) );
+            Live.insert( voice );
+            return voice;
+        }
+
+        virtual void DestroyPoolVoice( void* voice ) override
+        {
+            int* p = static_cast<int*>( voice );
+            if ( Live.erase( p ) != 1 )
+            {
+                DoubleDestroys++;
+                return;
+            }
+
+            delete p;
+        }
+
+        std::set<int*>  Live;
+        bool            Fail;
+        bool            Throw;
+        int             DoubleDestroys;
+    };
+
+    VoicePoolPolicy MakePolicy( size_t maxVoices, size_t maxIdleVoices, double maxIdleSeconds )
+    {
+        VoicePoolPolicy policy;
+        policy.maxVoices = maxVoices;
+        policy.maxIdleVoices = maxIdleVoices;
+        policy.maxIdleSeconds = maxIdleSeconds;
+        return policy;
+    }
+
+    unsigned int KeyOf( void* voice )
+    {
+        return static_cast<unsigned int>( *static_cast<int*>( voice ) );
+    }
+}
+
+// Released voices come back most recently released first, for their own key.
+TEST( VoicePool_ReusesByKey )
+{
+    StandInFactory factory;
+    VoicePool pool( &factory, StandInClock );
+
+    gNow = 0.0;
+    void* a = pool.Acquire( 1 );
+    void* b = pool.Acquire( 1 );
+    void* c = pool.Acquire( 2 );
+    CHECK( a && KeyOf( a ) == 1 && KeyOf( c ) == 2 );
+    CHECK( pool.GetActiveCount() == 3 && pool.GetIdleCount() == 0 );
+
+    gNow = 1.0;
+    pool.Release( 1, a );
+    gNow = 2.0;
+    pool.Release( 1, b );
+    gNow = 3.0;
+    pool.Release( 2, c );
+    CHECK( pool.GetIdleCount() == 3 && pool.GetIdleCount( 1 ) == 2 && pool.IsIdle( b ) );
+
+    CHECK( pool.Acquire( 1 ) == b );
+    CHECK( !pool.IsIdle( b ) );
+
+    VoicePoolStatistics stats = pool.GetStatistics();
+    CHECK( stats.hits == 1 && stats.misses == 3 && stats.creations == 3 );
+    CHECK( stats.activeVoices == 1 && stats.idleVoices == 2 );
+    CHECK( stats.createSecondsMax >= 0.0 && stats.createSeconds >= stats.createSecondsMax );
+
+    pool.Release( 1, b );
+    pool.Clear();
+    CHECK( factory.Live.empty() && factory.DoubleDestroys == 0 );
+}
+
+// The idle limit drops the least recently used voice; Trim drops old ones.
+TEST( VoicePool_IdleLimitAndAge )
+{
+    StandInFactory factory;
+    VoicePool pool( &factory, StandInClock );
+
+    gNow = 0.0;
+    void* a = pool.Acquire( 1 );
+    void* b = pool.Acquire( 1 );
+    void* c = pool.Acquire( 2 );
+    gNow = 1.0;
+    pool.Release( 1, a );
+    gNow = 2.0;
+    pool.Release( 1, b );
+    gNow = 3.0;
+    pool.Release( 2, c );
+
+    pool.SetPolicy( MakePolicy( SIZE_MAX, 2, 0.0 ) );
+    CHECK( pool.GetIdleCount() == 2 && !pool.IsIdle( a ) && pool.IsIdle( b ) && pool.IsIdle( c ) );
+    CHECK( pool.GetStatistics().evictions == 1 );
+
+    // With a 5 s limit, b (released at 2) goes stale first, then c (at 3).
+    pool.SetPolicy( MakePolicy( SIZE_MAX, SIZE_MAX, 5.0 ) );
+    gNow = 7.5;
+    CHECK( pool.Trim() == 1 && pool.IsIdle( c ) );
+    gNow = 8.5;
+    CHECK( pool.Trim() == 1 && pool.GetIdleCount() == 0 );
+
+    CHECK( factory.Live.empty() && factory.DoubleDestroys == 0 );
+}
+
+// With the budget full of idle voices, a miss on another key evicts the least
+// recently used one; with every voice in use, Acquire fails.
+TEST( VoicePool_Budget )
+{
+    StandInFactory factory;
+    VoicePool pool( &factory, StandInClock );
+    pool.SetPolicy( MakePolicy( 2, SIZE_MAX, 0.0 ) );
+
+    gNow = 0.0;
+    void* x = pool.Acquire( 3 );
+    void* y = pool.Acquire( 3 );
+    CHECK( x && y );
+    CHECK( pool.Acquire( 5 ) == nullptr );
+    CHECK( pool.GetStatistics().budgetFailures == 1 );
+
+    gNow = 8.0;
+    pool.Release( 3, x );
+    gNow = 9.0;
+    pool.Release( 3, y );
+
+    void* z = pool.Acquire( 4 );
+    CHECK( z && KeyOf( z ) == 4 );
+    CHECK( !pool.IsIdle( x ) && pool.IsIdle( y ) );
+    CHECK( pool.EvictIdle() && !pool.EvictIdle() );
+
+    pool.Release( 4, z );
+    CHECK( factory.Live.size() == 1 );
+}
+
+// Prewarm stays within the budget and the idle limit and evicts nothing, and
+// prewarmed voices are the first to go.
+TEST( VoicePool_Prewarm )
+{
+    StandInFactory factory;
+    VoicePool pool( &factory, StandInClock );
+
+    gNow = 0.0;
+    pool.SetPolicy( MakePolicy( 2, SIZE_MAX, 0.0 ) );
+    pool.Release( 4, pool.Acquire( 4 ) );
+    pool.Release( 5, pool.Acquire( 5 ) );
+    CHECK( pool.Prewarm( 6, 3 ) == 0 );
+
+    pool.SetPolicy( MakePolicy( SIZE_MAX, 4, 0.0 ) );
+    CHECK( pool.Prewarm( 6, 3 ) == 2 );
+    CHECK( pool.GetIdleCount( 6 ) == 2 && pool.GetIdleCount() == 4 );
+    CHECK( pool.Prewarm( 4, 1 ) == 0 );
+    CHECK( pool.GetStatistics().creations == 4 );
+
+    void* w = pool.Acquire( 7 );
+    pool.Release( 7, w );
+    CHECK( pool.GetIdleCount( 6 ) == 1 && pool.IsIdle( w ) );
+
+    // Prewarmed voices count as released when they were made.
+    pool.SetPolicy( MakePolicy( SIZE_MAX, SIZE_MAX, 1.0 ) );
+    gNow = 100.0;
+    CHECK( pool.Prewarm( 8, 1 ) == 1 );
+    CHECK( pool.Trim() == 4 );
+    CHECK( pool.GetIdleCount() == 1 && pool.GetIdleCount( 8 ) == 1 );
+}
+
+// A factory that fails or throws leaves nothing counted as in use.
+TEST( VoicePool_FactoryFailures )
+{
+    StandInFactory factory;
+    VoicePool pool( &factory, StandInClock );
+
+    factory.Fail = true;
+    CHECK( pool.Acquire( 9 ) == nullptr );
+    CHECK( pool.GetActiveCount() == 0 );
+    factory.Fail = false;
+
+    factory.Throw = true;
+    bool threw = false;
+    try
+    {
+        pool.Acquire( 9 );
+    }
+    catch ( const std::exception& )
+    {
+        threw = true;
+    }
+
+    CHECK( threw && pool.GetActiveCount() == 0 );
+    factory.Throw = false;
+
+    // Abandon forgets voices without handing them to the factory.
+    void* v = pool.Acquire( 9 );
+    pool.Release( 9, v );
+    pool.Abandon();
+    CHECK( pool.GetIdleCount() == 0 && factory.Live.size() == 1 );
+
+    VoicePool moved( std::move( pool ) );
+    CHECK( moved.GetIdleCount() == 0 );
+}
+
+// Random operations under a small budget: the pool's counts always match the
+// voices the factory has alive.
+TEST( VoicePool_RandomOperations )
+{
+    StandInFactory factory;
+    VoicePool pool( &factory, StandInClock );
+    pool.SetPolicy( MakePolicy( 20, 8, 3.0 ) );
+
+    std::mt19937 random( 1 );
+    std::vector<std::pair<unsigned int, void*>> active;
+    bool consistent = true;
+    bool keysMatch = true;
+
+    gNow = 0.0;
+    for ( int i = 0; i < 100000 && consistent; i++ )
+    {
+        gNow += 0.01;
+        unsigned int op = random() % 10;
+        if ( op < 4 )
+        {
+            unsigned int key = 1 + random() % 6;
+            void* voice = pool.Acquire( key );
+            if ( voice )
+            {
+                keysMatch = keysMatch && ( KeyOf( voice ) == key );
+                active.push_back( std::make_pair( key, voice ) );
+            }
+        }
+        else if ( op < 8 && !active.empty() )
+        {
+            size_t j = random() % active.size();
+            pool.Release( active[j].first, active[j].second );
+            active.erase( active.begin() + j );
+        }
+        else if ( op == 8 )
+        {
+            pool.Trim();
+        }
+        else
+        {
+            pool.Prewarm( 1 + random() % 6, random() % 3 );
+        }
+
+        consistent = pool.GetActiveCount() == active.size()
+                     && pool.GetIdleCount() <= 8
+                     && pool.GetIdleCount() + active.size() <= 20
+                     && factory.Live.size() == pool.GetIdleCount() + active.size();
+    }
+
+    CHECK( consistent );
+    CHECK( keysMatch );
+    CHECK( factory.DoubleDestroys == 0 );
+
+    VoicePoolStatistics stats = pool.GetStatistics();
+    wprintf( L"    hits %llu, misses %llu, evictions %llu, creations %llu, budget failures %llu\n",
+             stats.hits, stats.misses, stats.evictions, stats.creations, stats.budgetFailures );
+    CHECK( stats.hits > 0 && stats.evictions > 0 && stats.budgetFailures > 0 );
+
+    for ( auto it = active.begin(); it != active.end(); ++it )
+    {
+        pool.Release( it->first, it->second );
+    }
+
+    pool.Clear();
+    CHECK( factory.Live.empty() );
+}
+
+// The cost of a pooled Acquire and Release against creating and destroying each
+// time, with a 32-voice working set over 8 formats.
+BENCHMARK( VoicePool_AcquireRelease )
+{
+    const int iterations = 1000000;
+    const size_t workingSet = 32;
+
+    for ( int pooled = 1; pooled >= 0; pooled-- )
+    {
+        StandInFactory factory;
+        VoicePool pool( &factory );
+        pool.SetPolicy( MakePolicy( SIZE_MAX, pooled ? SIZE_MAX : 0, 0.0 ) );
+
+        std::vector<void*> voices( workingSet, nullptr );
+        double start = Tests::GetSeconds();
+        for ( int i = 0; i < iterations; i++ )
+        {
+            size_t slot = i % workingSet;
+            unsigned int key = static_cast<unsigned int>( slot % 8 );
+            if ( voices[slot] )
+            {
+                pool.Release( key, voices[slot] );
+            }
+
+            voices[slot] = pool.Acquire( key );
+        }
+
+        double seconds = Tests::GetSeconds() - start;
+        VoicePoolStatistics stats = pool.GetStatistics();
+        CHECK( stats.hits + stats.misses == uint64_t( iterations ) );
+        wprintf( L"    %s: %.0f ns per Acquire+Release, %llu hits, %llu creations\n",
+                 pooled ? L"pooled" : L"unpooled", seconds / iterations * 1e9, stats.hits, stats.creations );
+
+        for ( size_t j = 0; j < workingSet; j++ )
+        {
+            pool.Release( static_cast<unsigned int>( j % 8 ), voices[j] );
+        }
+    }
+}
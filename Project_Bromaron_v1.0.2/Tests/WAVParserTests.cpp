@@ -0,0 +1,467 @@
+//--------------------------------------------------------------------------------------
+// File: WAVParserTests.cpp
+//
+// Each parse runs over a heap copy sized exactly to the file, so a read past the
+// end is caught by the debug heap or a sanitizer rather than landing in the
+// vector's spare capacity.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "WAVParser.h"
+
+using namespace DirectX;
+
+namespace
+{
+    typedef std::vector<uint8_t> Bytes;
+
+    void AppendU16( Bytes& bytes, uint16_t value )
+    {
+        bytes.push_back( static_cast<uint8_t>( value ) );
+        bytes.push_back( static_cast<uint8_t>( value >> 8 ) );
+    }
+
+    void AppendU32( Bytes& bytes, uint32_t value )
+    {
+        for ( int i = 0; i < 4; i++ )
+        {
+            bytes.push_back( static_cast<uint8_t>( value >> ( 8 * i ) ) );
+        }
+    }
+
+    void AppendTag( Bytes& bytes, const char* tag )
+    {
+        bytes.insert( bytes.end(), tag, tag + 4 );
+    }
+
+    // Odd-sized chunks get their pad byte.
+    void AppendChunk( Bytes& bytes, const char* tag, const Bytes& body )
+    {
+        AppendTag( bytes, tag );
+        AppendU32( bytes, static_cast<uint32_t>( body.size() ) );
+        bytes.insert( bytes.end(), body.begin(), body.end() );
+        if ( body.size() & 1 )
+        {
+            bytes.push_back( 0 );
+        }
+    }
+
+    // 22.05 kHz mono 16-bit PCMWAVEFORMAT.
+    Bytes MakePCMFormat()
+    {
+        Bytes format;
+        AppendU16( format, 1 );
+        AppendU16( format, 1 );
+        AppendU32( format, 22050 );
+        AppendU32( format, 44100 );
+        AppendU16( format, 2 );
+        AppendU16( format, 16 );
+        return format;
+    }
+
+    Bytes MakeRIFF( const Bytes& chunks, const char* type = "WAVE" )
+    {
+        Bytes file;
+        AppendTag( file, "RIFF" );
+        AppendU32( file, static_cast<uint32_t>( chunks.size() + 4 ) );
+        AppendTag( file, type );
+        file.insert( file.end(), chunks.begin(), chunks.end() );
+        return file;
+    }
+
+    // A 'fmt ' chunk followed by a 'data' chunk of audioBytes.
+    Bytes MakeWAV( const Bytes& format, size_t audioBytes, const char* type = "WAVE" )
+    {
+        Bytes chunks;
+        AppendChunk( chunks, "fmt ", format );
+        AppendChunk( chunks, "data", Bytes( audioBytes, 7 ) );
+        return MakeRIFF( chunks, type );
+    }
+
+    // WAVEFORMATEXTENSIBLE, 48 kHz stereo 32-bit, with the given subformat tag.
+    Bytes MakeExtensibleFormat( uint16_t subformat )
+    {
+        static const uint8_t guidTail[12] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+        Bytes format;
+        AppendU16( format, 0xFFFE );
+        AppendU16( format, 2 );
+        AppendU32( format, 48000 );
+        AppendU32( format, 384000 );
+        AppendU16( format, 8 );
+        AppendU16( format, 32 );
+        AppendU16( format, 22 );
+        AppendU16( format, 32 );
+        AppendU32( format, 3 );
+        AppendU16( format, subformat );
+        AppendU16( format, 0 );
+        format.insert( format.end(), guidTail, guidTail + 12 );
+        return format;
+    }
+
+    // Parses a copy and checks every view lies inside it, then repoints the views
+    // into file so they stay valid.
+    WAV_PARSE_RESULT Parse( const Bytes& file, WAVFileView& view, bool* inBounds = nullptr )
+    {
+        std::unique_ptr<uint8_t[]> copy( new uint8_t[file.empty() ? 1 : file.size()] );
+        if ( !file.empty() )
+        {
+            memcpy( copy.get(), &file[0], file.size() );
+        }
+
+        const uint8_t* begin = copy.get();
+        const uint8_t* end = begin + file.size();
+
+        WAV_PARSE_RESULT result = ParseWAV( begin, file.size(), view );
+        if ( result == WAV_PARSE_OK )
+        {
+            bool ok = view.startAudio >= begin && view.startAudio + view.audioBytes <= end
+                      && view.format >= begin && view.format + view.formatBytes <= end
+                      && ( !view.seek || reinterpret_cast<const uint8_t*>( view.seek + view.seekCount ) <= end );
+            if ( inBounds )
+            {
+                *inBounds = *inBounds && ok;
+            }
+
+            view.format = &file[0] + ( view.format - begin );
+            view.startAudio = &file[0] + ( view.startAudio - begin );
+            if ( view.seek )
+            {
+                view.seek = reinterpret_cast<const uint32_t*>( &file[0] + ( reinterpret_cast<const uint8_t*>( view.seek ) - begin ) );
+            }
+        }
+
+        return result;
+    }
+
+    // Files the tests write, in the working directory.
+    const MappedFileChar TestFileName[] = L"WAVParserTests.wav";
+    const MappedFileChar EmptyFileName[] = L"WAVParserTests_empty.wav";
+    const MappedFileChar MissingFileName[] = L"WAVParserTests_missing.wav";
+
+    bool WriteTestFile( const MappedFileChar* fileName, const Bytes& bytes )
+    {
+        FILE* file = nullptr;
+        if ( _wfopen_s( &file, fileName, L"wb" ) != 0 || !file )
+        {
+            return false;
+        }
+
+        bool written = bytes.empty() || fwrite( &bytes[0], 1, bytes.size(), file ) == bytes.size();
+        fclose( file );
+        return written;
+    }
+}
+
+// Unknown and odd-sized chunks are skipped; the RIFF size may overstate the file.
+TEST( WAVParser_WalksChunks )
+{
+    WAVFileView view;
+
+    Bytes chunks;
+    AppendChunk( chunks, "LIST", Bytes( 5, 'x' ) );
+    AppendChunk( chunks, "fmt ", MakePCMFormat() );
+    AppendChunk( chunks, "data", Bytes( 101, 7 ) );
+    Bytes file = MakeRIFF( chunks );
+    CHECK( Parse( file, view ) == WAV_PARSE_OK );
+    CHECK( view.audioBytes == 101 && view.formatTag == 1 && view.loopLength == 0 );
+    CHECK( view.startAudio[0] == 7 && view.formatBytes == 16 );
+
+    file = MakeWAV( MakePCMFormat(), 100 );
+    file[4] = file[5] = file[6] = file[7] = 0xFF;
+    CHECK( Parse( file, view ) == WAV_PARSE_OK && view.audioBytes == 100 );
+
+    RIFFChunkView chunk;
+    CHECK( FindRIFFChunk( nullptr, 0, 'atad', chunk ) == WAV_PARSE_INVALID );
+    uint8_t tiny[7] = { 0 };
+    CHECK( FindRIFFChunk( tiny, sizeof( tiny ), 0, chunk ) == WAV_PARSE_INVALID );
+}
+
+TEST( WAVParser_RejectsBadFiles )
+{
+    WAVFileView view;
+
+    Bytes file = MakeWAV( MakePCMFormat(), 100 );
+    file.resize( file.size() - 10 );
+    CHECK( Parse( file, view ) == WAV_PARSE_TRUNCATED );
+
+    Bytes chunks;
+    AppendChunk( chunks, "fmt ", MakePCMFormat() );
+    AppendChunk( chunks, "junk", Bytes( 30, 0 ) );
+    CHECK( Parse( MakeRIFF( chunks ), view ) == WAV_PARSE_NO_AUDIO );
+
+    CHECK( Parse( MakeWAV( MakePCMFormat(), 0 ), view ) == WAV_PARSE_NO_AUDIO );
+    CHECK( Parse( MakeWAV( MakePCMFormat(), 10, "AVI " ), view ) == WAV_PARSE_INVALID );
+    CHECK( Parse( Bytes( 20, 0 ), view ) == WAV_PARSE_INVALID );
+
+    // cbSize claims more than the 'fmt ' chunk holds.
+    Bytes adpcm;
+    AppendU16( adpcm, 2 );
+    AppendU16( adpcm, 1 );
+    AppendU32( adpcm, 22050 );
+    AppendU32( adpcm, 11100 );
+    AppendU16( adpcm, 512 );
+    AppendU16( adpcm, 4 );
+    AppendU16( adpcm, 200 );
+    CHECK( Parse( MakeWAV( adpcm, 512 ), view ) == WAV_PARSE_INVALID );
+
+    // A chunk size that would wrap a pointer.
+    chunks.clear();
+    AppendChunk( chunks, "fmt ", MakePCMFormat() );
+    AppendTag( chunks, "junk" );
+    AppendU32( chunks, 0xFFFFFFF0 );
+    file = MakeRIFF( chunks );
+    file.resize( file.size() + 40, 0 );
+    CHECK( Parse( file, view ) == WAV_PARSE_NO_AUDIO );
+}
+
+// 'smpl' loops are inclusive of their end sample, and only the first forward loop
+// counts; 'wsmp' wins over 'smpl' wherever it is.
+TEST( WAVParser_Loops )
+{
+    WAVFileView view;
+
+    Bytes sampler( 28, 0 );
+    AppendU32( sampler, 2 );
+    AppendU32( sampler, 0 );
+    const uint32_t loops[2][6] = { { 1, 2, 5, 9, 0, 0 }, { 2, 0, 100, 199, 0, 0 } };
+    for ( int i = 0; i < 2; i++ )
+    {
+        for ( int j = 0; j < 6; j++ )
+        {
+            AppendU32( sampler, loops[i][j] );
+        }
+    }
+
+    Bytes chunks;
+    AppendChunk( chunks, "fmt ", MakePCMFormat() );
+    AppendChunk( chunks, "data", Bytes( 400, 1 ) );
+    AppendChunk( chunks, "smpl", sampler );
+    CHECK( Parse( MakeRIFF( chunks ), view ) == WAV_PARSE_OK );
+    CHECK( view.loopStart == 100 && view.loopLength == 100 );
+
+    // A loop count the chunk can't hold is ignored.
+    Bytes absurd( 28, 0 );
+    AppendU32( absurd, 0x40000000 );
+    AppendU32( absurd, 0 );
+    chunks.clear();
+    AppendChunk( chunks, "fmt ", MakePCMFormat() );
+    AppendChunk( chunks, "data", Bytes( 4, 1 ) );
+    AppendChunk( chunks, "smpl", absurd );
+    CHECK( Parse( MakeRIFF( chunks ), view ) == WAV_PARSE_OK && view.loopLength == 0 );
+
+    // WSMPL with unity note 60 and one WLOOP of 50 samples from 10.
+    Bytes wsmp;
+    AppendU32( wsmp, 20 );
+    AppendU16( wsmp, 60 );
+    AppendU16( wsmp, 0 );
+    AppendU32( wsmp, 0 );
+    AppendU32( wsmp, 0 );
+    AppendU32( wsmp, 1 );
+    AppendU32( wsmp, 16 );
+    AppendU32( wsmp, 0 );
+    AppendU32( wsmp, 10 );
+    AppendU32( wsmp, 50 );
+
+    chunks.clear();
+    AppendChunk( chunks, "wsmp", wsmp );
+    AppendChunk( chunks, "fmt ", MakePCMFormat() );
+    AppendChunk( chunks, "data", Bytes( 400, 1 ) );
+    AppendChunk( chunks, "smpl", sampler );
+    CHECK( Parse( MakeRIFF( chunks ), view ) == WAV_PARSE_OK );
+    CHECK( view.loopStart == 10 && view.loopLength == 50 );
+}
+
+// Extensible subformats, and the seek tables xWMA needs.
+TEST( WAVParser_FormatsAndSeekTables )
+{
+    WAVFileView view;
+
+    CHECK( Parse( MakeWAV( MakeExtensibleFormat( 3 ), 64 ), view ) == WAV_PARSE_OK && view.formatTag == 3 );
+    CHECK( Parse( MakeWAV( MakeExtensibleFormat( 0x166 ), 64 ), view ) == WAV_PARSE_UNSUPPORTED );
+
+    Bytes xwma = MakeExtensibleFormat( 0x161 );
+    Bytes chunks;
+    AppendChunk( chunks, "fmt ", xwma );
+    AppendChunk( chunks, "data", Bytes( 64, 0 ) );
+    AppendU32( chunks, 0 );
+    CHECK( Parse( MakeRIFF( chunks ), view ) == WAV_PARSE_OK && view.dpds && !view.seek );
+
+    // An extensible GUID that isn't the KSDATAFORMAT base.
+    xwma[30] = 1;
+    CHECK( Parse( MakeWAV( xwma, 64 ), view ) == WAV_PARSE_UNSUPPORTED );
+
+    Bytes format;
+    AppendU16( format, 0x161 );
+    AppendU16( format, 2 );
+    AppendU32( format, 44100 );
+    AppendU32( format, 6000 );
+    AppendU16( format, 2230 );
+    AppendU16( format, 16 );
+    AppendU16( format, 0 );
+
+    Bytes table;
+    for ( uint32_t i = 0; i < 5; i++ )
+    {
+        AppendU32( table, i * 1000 );
+    }
+
+    chunks.clear();
+    AppendChunk( chunks, "fmt ", format );
+    AppendChunk( chunks, "dpds", table );
+    AppendChunk( chunks, "data", Bytes( 2230, 0 ) );
+    CHECK( Parse( MakeRIFF( chunks, "XWMA" ), view ) == WAV_PARSE_OK && view.dpds && view.seekCount == 5 );
+
+    // A table that isn't whole entries.
+    table.pop_back();
+    chunks.clear();
+    AppendChunk( chunks, "fmt ", format );
+    AppendChunk( chunks, "dpds", table );
+    AppendChunk( chunks, "data", Bytes( 2230, 0 ) );
+    CHECK( Parse( MakeRIFF( chunks, "XWMA" ), view ) == WAV_PARSE_INVALID );
+
+    chunks.clear();
+    AppendChunk( chunks, "fmt ", format );
+    AppendChunk( chunks, "data", Bytes( 2230, 0 ) );
+    AppendTag( chunks, "dpds" );
+    AppendU32( chunks, 400 );
+    AppendU32( chunks, 1 );
+    CHECK( Parse( MakeRIFF( chunks, "XWMA" ), view ) == WAV_PARSE_TRUNCATED );
+}
+
+// Randomly damaged files never parse to views outside the buffer.
+TEST( WAVParser_DamagedFiles )
+{
+    std::vector<Bytes> seeds;
+    {
+        Bytes sampler( 28, 0 );
+        AppendU32( sampler, 1 );
+        AppendU32( sampler, 0 );
+        sampler.resize( 60, 0 );
+
+        Bytes chunks;
+        AppendChunk( chunks, "LIST", Bytes( 5, 'x' ) );
+        AppendChunk( chunks, "wsmp", Bytes( 36, 0 ) );
+        AppendChunk( chunks, "fmt ", MakePCMFormat() );
+        AppendChunk( chunks, "data", Bytes( 41, 7 ) );
+        AppendChunk( chunks, "smpl", sampler );
+        seeds.push_back( MakeRIFF( chunks ) );
+    }
+    {
+        Bytes chunks;
+        AppendChunk( chunks, "fmt ", MakeExtensibleFormat( 0x161 ) );
+        AppendChunk( chunks, "dpds", Bytes( 12, 1 ) );
+        AppendChunk( chunks, "data", Bytes( 30, 0 ) );
+        seeds.push_back( MakeRIFF( chunks, "XWMA" ) );
+    }
+
+    std::mt19937 random( 1234 );
+    const uint32_t sizes[] = { 0, 1, 3, 4, 7, 8, 0x7FFFFFFF, 0xFFFFFFFF, 0xFFFFFFF8 };
+    size_t results[WAV_PARSE_OPEN_FAILED + 1] = { 0 };
+    bool inBounds = true;
+
+    for ( int i = 0; i < 100000; i++ )
+    {
+        Bytes file = seeds[random() % seeds.size()];
+        int changes = 1 + random() % 8;
+        for ( int k = 0; k < changes && !file.empty(); k++ )
+        {
+            size_t offset = random() % file.size();
+            switch ( random() % 5 )
+            {
+            case 0:
+                file[offset] = static_cast<uint8_t>( random() );
+                break;
+
+            case 1:
+                if ( offset + 4 <= file.size() )
+                {
+                    uint32_t size = sizes[random() % ARRAYSIZE( sizes )];
+                    memcpy( &file[offset], &size, 4 );
+                }
+                break;
+
+            case 2:
+                file.resize( random() % ( file.size() + 1 ) );
+                break;
+
+            case 3:
+                file.insert( file.begin() + offset, random() % 9, static_cast<uint8_t>( random() ) );
+                break;
+
+            default:
+                file.erase( file.begin() + offset, file.begin() + std::min( file.size(), offset + random() % 9 ) );
+                break;
+            }
+        }
+
+        WAVFileView view;
+        results[Parse( file, view, &inBounds )]++;
+    }
+
+    CHECK( inBounds );
+    CHECK( results[WAV_PARSE_OK] > 0 && results[WAV_PARSE_INVALID] > 0 && results[WAV_PARSE_TRUNCATED] > 0 );
+    wprintf( L"    ok %u, invalid %u, truncated %u, no audio %u, unsupported %u\n",
+             static_cast<unsigned int>( results[WAV_PARSE_OK] ), static_cast<unsigned int>( results[WAV_PARSE_INVALID] ),
+             static_cast<unsigned int>( results[WAV_PARSE_TRUNCATED] ), static_cast<unsigned int>( results[WAV_PARSE_NO_AUDIO] ),
+             static_cast<unsigned int>( results[WAV_PARSE_UNSUPPORTED] ) );
+}
+
+// A mapped file parses the same as a copy, and the mapping lives as long as any
+// view of it.
+TEST( WAVParser_MapsFiles )
+{
+    Bytes file = MakeWAV( MakePCMFormat(), 4001 );
+    CHECK( WriteTestFile( TestFileName, file ) );
+
+    MappedWAV mapped;
+    CHECK( MapWAVFile( TestFileName, mapped ) == WAV_PARSE_OK );
+    CHECK( mapped.file && mapped.file->GetSize() == file.size() );
+    CHECK( mapped.wave.audioBytes == 4001 && mapped.wave.formatTag == 1 && mapped.wave.startAudio[4000] == 7 );
+
+    std::shared_ptr<const MappedFile> kept = mapped.file;
+    mapped = MappedWAV();
+    CHECK( kept.use_count() == 1 && kept->GetData()[0] == 'R' );
+    kept.reset();
+
+    CHECK( MapWAVFile( MissingFileName, mapped ) == WAV_PARSE_OPEN_FAILED && !mapped.file );
+
+    CHECK( WriteTestFile( EmptyFileName, Bytes() ) );
+    std::shared_ptr<const MappedFile> empty = MappedFile::Open( EmptyFileName );
+    CHECK( empty && empty->GetSize() == 0 && !empty->GetData() );
+    empty.reset();
+    CHECK( MapWAVFile( EmptyFileName, mapped ) == WAV_PARSE_INVALID && !mapped.file );
+
+    _wremove( TestFileName );
+    _wremove( EmptyFileName );
+}
+
+// Reading a 10 MB wave into memory against mapping it, with and without touching
+// the audio. The file is in the OS cache after the first open.
+BENCHMARK( WAVParser_OpenCopiedAndMapped )
+{
+    Bytes format;
+    AppendU16( format, 1 );
+    AppendU16( format, 2 );
+    AppendU32( format, 44100 );
+    AppendU32( format, 176400 );
+    AppendU16( format, 4 );
+    AppendU16( format, 16 );
+    CHECK( WriteTestFile( TestFileName, MakeWAV( format, 10 * 1024 * 1024 ) ) );
+
+    WAVOpenBenchmark result = BenchmarkWAVOpen( TestFileName, 20 );
+    CHECK( result.fileBytes > 10 * 1024 * 1024 );
+    wprintf( L"    %u bytes: copy %.3f ms, map %.3f ms, map and touch %.3f ms\n",
+             static_cast<unsigned int>( result.fileBytes ), result.copySeconds * 1e3,
+             result.mappedSeconds * 1e3, result.mappedTouchSeconds * 1e3 );
+
+    _wremove( TestFileName );
+}
@@ -0,0 +1,405 @@
+//--------------------------------------------------------------------------------------
+// File: WaveBankBuilderTests.cpp
+//
+// Banks are compared byte for byte, except for the build timestamp in the bank
+// header, which changes from one build to the next.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "WaveBankBuilder.h"
+
+using namespace DirectX;
+
+namespace
+{
+    typedef std::basic_string<MappedFileChar> FileName;
+    typedef std::vector<uint8_t> Bytes;
+
+    const MappedFileChar TestWavePrefix[] = L"WaveBankBuilderTests";
+    const MappedFileChar TestBankName[] = L"WaveBankBuilderTests.xwb";
+    const MappedFileChar TestCacheName[] = L"WaveBankBuilderTests.xwc";
+    const MappedFileChar BenchmarkDirectory[] = L".";
+
+    // BANKDATA::BuildTime, after the 52-byte header and 88 bytes into BANKDATA.
+    const size_t BuildTimeOffset = 140;
+    const size_t BuildTimeBytes = 8;
+
+    void AppendU16( Bytes& bytes, uint32_t value )
+    {
+        bytes.push_back( static_cast<uint8_t>( value ) );
+        bytes.push_back( static_cast<uint8_t>( value >> 8 ) );
+    }
+
+    void AppendU32( Bytes& bytes, uint32_t value )
+    {
+        for ( int i = 0; i < 4; i++ )
+        {
+            bytes.push_back( static_cast<uint8_t>( value >> ( 8 * i ) ) );
+        }
+    }
+
+    void AppendTag( Bytes& bytes, const char* tag )
+    {
+        bytes.insert( bytes.end(), tag, tag + 4 );
+    }
+
+    // A .WAV of a decaying tone picked by seed, a tenth to a fifth of a second at
+    // 22.05 kHz. Only 8- and 16-bit integer PCM are valid in a bank.
+    Bytes MakeWAV( uint32_t seed, uint32_t channels, uint32_t bitsPerSample = 16, uint32_t formatTag = 1 )
+    {
+        const uint32_t sampleRate = 22050;
+        uint32_t frames = sampleRate / 10 + ( seed * 7919u ) % ( sampleRate / 10 );
+        uint32_t blockAlign = channels * bitsPerSample / 8;
+
+        Bytes audio;
+        double frequency = 110.0 + double( seed % 880 );
+        for ( uint32_t j = 0; j < frames; j++ )
+        {
+            double t = double( j ) / sampleRate;
+            double value = sin( 6.283185307179586 * frequency * t ) * exp( -4.0 * t );
+            for ( uint32_t c = 0; c < channels; c++ )
+            {
+                int32_t sample = static_cast<int32_t>( value * 2000000000.0 );
+                for ( uint32_t b = 4 - bitsPerSample / 8; b < 4; b++ )
+                {
+                    audio.push_back( static_cast<uint8_t>( sample >> ( 8 * b ) ) );
+                }
+            }
+        }
+
+        Bytes file;
+        AppendTag( file, "RIFF" );
+        AppendU32( file, static_cast<uint32_t>( 36 + audio.size() ) );
+        AppendTag( file, "WAVE" );
+        AppendTag( file, "fmt " );
+        AppendU32( file, 16 );
+        AppendU16( file, formatTag );
+        AppendU16( file, channels );
+        AppendU32( file, sampleRate );
+        AppendU32( file, sampleRate * blockAlign );
+        AppendU16( file, blockAlign );
+        AppendU16( file, bitsPerSample );
+        AppendTag( file, "data" );
+        AppendU32( file, static_cast<uint32_t>( audio.size() ) );
+        file.insert( file.end(), audio.begin(), audio.end() );
+        return file;
+    }
+
+    FileName WaveFileName( size_t index )
+    {
+        FileName fileName( TestWavePrefix );
+        char suffix[32];
+        sprintf_s( suffix, "%u.wav", static_cast<unsigned int>( index ) );
+        for ( const char* c = suffix; *c; c++ )
+        {
+            fileName += MappedFileChar( *c );
+        }
+
+        return fileName;
+    }
+
+    bool WriteTestFile( const FileName& fileName, const Bytes& bytes )
+    {
+        FILE* file = nullptr;
+        if ( _wfopen_s( &file, fileName.c_str(), L"wb" ) != 0 || !file )
+        {
+            return false;
+        }
+
+        bool written = bytes.empty() || fwrite( &bytes[0], 1, bytes.size(), file ) == bytes.size();
+        fclose( file );
+        return written;
+    }
+
+    Bytes ReadTestFile( const MappedFileChar* fileName )
+    {
+        std::shared_ptr<const MappedFile> mapped = MappedFile::Open( fileName );
+        return ( mapped && mapped->GetSize() ) ? Bytes( mapped->GetData(), mapped->GetData() + mapped->GetSize() ) : Bytes();
+    }
+
+    // The bank as written, with its build time cleared.
+    Bytes ReadBank()
+    {
+        Bytes bank = ReadTestFile( TestBankName );
+        if ( bank.size() >= BuildTimeOffset + BuildTimeBytes )
+        {
+            memset( &bank[BuildTimeOffset], 0, BuildTimeBytes );
+        }
+
+        return bank;
+    }
+
+    // count files, every eighth a copy of the one before it.
+    std::vector<FileName> WriteWaves( size_t count, uint32_t seedBase )
+    {
+        std::vector<FileName> files;
+        for ( size_t j = 0; j < count; j++ )
+        {
+            uint32_t seed = seedBase + static_cast<uint32_t>( ( j % 8 == 7 ) ? j - 1 : j );
+            files.push_back( WaveFileName( j ) );
+            WriteTestFile( files.back(), MakeWAV( seed, 1 + seed % 2 ) );
+        }
+
+        return files;
+    }
+
+    void RemoveFiles( const std::vector<FileName>& files )
+    {
+        for ( size_t j = 0; j < files.size(); j++ )
+        {
+            _wremove( files[j].c_str() );
+        }
+
+        _wremove( TestBankName );
+        _wremove( TestCacheName );
+    }
+
+    // Loads, lays out and writes TestBankName, then saves the cache if there is one.
+    bool Build( WaveBankBuilder& builder, const std::vector<FileName>& files, WAVEBANK_BUILD_FLAGS flags,
+                unsigned int threadCount, const MappedFileChar* cacheFileName )
+    {
+        builder = WaveBankBuilder( threadCount );
+        for ( size_t j = 0; j < files.size(); j++ )
+        {
+            char entryName[32];
+            sprintf_s( entryName, "wave%u", static_cast<unsigned int>( j ) );
+            builder.AddFile( files[j].c_str(), entryName );
+        }
+
+        std::string log;
+        return builder.Load( flags, cacheFileName )
+               && builder.Layout( log )
+               && builder.Write( TestBankName, "WaveBankBuilderTests", log )
+               && ( !cacheFileName || builder.SaveCache( cacheFileName ) );
+    }
+
+    size_t CachedCount( const WaveBankBuilder& builder )
+    {
+        size_t cached = 0;
+        for ( size_t j = 0; j < builder.GetSourceCount(); j++ )
+        {
+            cached += builder.GetSource( j ).cached ? 1 : 0;
+        }
+
+        return cached;
+    }
+}
+
+// A rebuild over unchanged files takes every one from the cache, logs what the
+// first build did, and writes the same bank.
+TEST( WaveBankBuilder_CacheHitsUnchangedFiles )
+{
+    std::vector<FileName> files = WriteWaves( 12, 1 );
+    _wremove( TestCacheName );
+
+    CHECK( GetBuildCacheFileName( TestBankName ) == TestCacheName );
+
+    const WAVEBANK_BUILD_FLAGS flagSets[] = { WaveBankBuild_Default, WaveBankBuild_ADPCM | WaveBankBuild_EntryNames };
+    for ( size_t f = 0; f < ARRAYSIZE( flagSets ); f++ )
+    {
+        WaveBankBuilder cold;
+        CHECK( Build( cold, files, flagSets[f], 4, TestCacheName ) );
+        CHECK( CachedCount( cold ) == 0 );
+        Bytes coldBank = ReadBank();
+
+        WaveBankBuilder warm;
+        CHECK( Build( warm, files, flagSets[f], 4, TestCacheName ) );
+        CHECK( CachedCount( warm ) == files.size() );
+        CHECK( ReadBank() == coldBank );
+        CHECK( warm.GetSharedCount() == cold.GetSharedCount() && warm.GetSharedCount() > 0 );
+
+        bool sameLogs = true;
+        for ( size_t j = 0; j < files.size(); j++ )
+        {
+            sameLogs = sameLogs && !warm.GetSource( j ).log.empty() && warm.GetSource( j ).log == cold.GetSource( j ).log;
+        }
+
+        CHECK( sameLogs );
+    }
+
+    RemoveFiles( files );
+}
+
+// A changed file, or a change in whether waves are compressed, misses the cache
+// and builds the bank a cache-less build would; a damaged cache is ignored.
+TEST( WaveBankBuilder_CacheInvalidation )
+{
+    std::vector<FileName> files = WriteWaves( 10, 100 );
+    _wremove( TestCacheName );
+
+    WaveBankBuilder builder;
+    CHECK( Build( builder, files, WaveBankBuild_ADPCM, 4, TestCacheName ) );
+
+    // One sample of file 3 changed, keeping its size.
+    Bytes changed = MakeWAV( 103, 2 );
+    changed[changed.size() / 2] ^= 0x55;
+    CHECK( WriteTestFile( files[3], changed ) );
+
+    CHECK( Build( builder, files, WaveBankBuild_ADPCM, 4, TestCacheName ) );
+    CHECK( !builder.GetSource( 3 ).cached && CachedCount( builder ) == files.size() - 1 );
+    Bytes cachedBank = ReadBank();
+
+    CHECK( Build( builder, files, WaveBankBuild_ADPCM, 4, nullptr ) );
+    CHECK( ReadBank() == cachedBank );
+
+    // Records made with compression don't serve a build without it, or the
+    // reverse; each build replaces the cache.
+    CHECK( Build( builder, files, WaveBankBuild_Default, 4, TestCacheName ) );
+    CHECK( CachedCount( builder ) == 0 );
+    Bytes pcmBank = ReadBank();
+    CHECK( pcmBank.size() > cachedBank.size() );
+
+    CHECK( Build( builder, files, WaveBankBuild_ADPCM, 4, TestCacheName ) );
+    CHECK( CachedCount( builder ) == 0 );
+    CHECK( ReadBank() == cachedBank );
+
+    // A cache cut short keeps the records that fit; one of garbage keeps none.
+    // Either way the bank comes out the same.
+    Bytes cache = ReadTestFile( TestCacheName );
+    CHECK( cache.size() > 64 );
+    CHECK( WriteTestFile( TestCacheName, Bytes( cache.begin(), cache.begin() + cache.size() / 2 ) ) );
+    CHECK( Build( builder, files, WaveBankBuild_ADPCM, 4, TestCacheName ) );
+    size_t halfCached = CachedCount( builder );
+    CHECK( halfCached > 0 && halfCached < files.size() );
+    CHECK( ReadBank() == cachedBank );
+
+    CHECK( WriteTestFile( TestCacheName, Bytes( 4096, 0xA5 ) ) );
+    CHECK( Build( builder, files, WaveBankBuild_ADPCM, 4, TestCacheName ) );
+    CHECK( CachedCount( builder ) == 0 );
+    CHECK( ReadBank() == cachedBank );
+
+    RemoveFiles( files );
+}
+
+// Loading on a pool of threads writes exactly the bank that one thread does.
+TEST( WaveBankBuilder_ParallelMatchesSerial )
+{
+    std::vector<FileName> files = WriteWaves( 40, 200 );
+
+    const WAVEBANK_BUILD_FLAGS flagSets[] =
+    {
+        WaveBankBuild_Default,
+        WaveBankBuild_ADPCM | WaveBankBuild_EntryNames,
+        WaveBankBuild_Streaming | WaveBankBuild_NoCompact,
+    };
+
+    for ( size_t f = 0; f < ARRAYSIZE( flagSets ); f++ )
+    {
+        WaveBankBuilder serial;
+        CHECK( Build( serial, files, flagSets[f], 1, nullptr ) );
+        Bytes serialBank = ReadBank();
+        std::vector<char> serialNames;
+        if ( serial.GetEntryNames() )
+        {
+            serialNames.assign( serial.GetEntryNames(), serial.GetEntryNames() + files.size() * WaveBankEntryNameLength );
+        }
+
+        const unsigned int threadCounts[] = { 3, 8, 0 };
+        for ( size_t t = 0; t < ARRAYSIZE( threadCounts ); t++ )
+        {
+            WaveBankBuilder parallel;
+            CHECK( Build( parallel, files, flagSets[f], threadCounts[t], nullptr ) );
+            CHECK( ReadBank() == serialBank );
+            CHECK( parallel.GetSharedCount() == serial.GetSharedCount() && parallel.GetSharedCount() == 5 );
+            CHECK( parallel.IsCompact() == serial.IsCompact() && parallel.GetBankBytes() == serial.GetBankBytes() );
+            CHECK( serialNames.empty() == !parallel.GetEntryNames() );
+            if ( !serialNames.empty() && parallel.GetEntryNames() )
+            {
+                CHECK( memcmp( parallel.GetEntryNames(), &serialNames[0], serialNames.size() ) == 0 );
+            }
+        }
+    }
+
+    RemoveFiles( files );
+}
+
+// Files that are missing, not .WAVs, cut short, or in a format a bank can't hold
+// fail with a reason in their log, and only those fail.
+TEST( WaveBankBuilder_RejectsBadWaves )
+{
+    Bytes truncated = MakeWAV( 4, 1 );
+    truncated.resize( truncated.size() / 2 );
+
+    Bytes notRIFF = MakeWAV( 5, 1 );
+    memcpy( &notRIFF[0], "JUNK", 4 );
+
+    Bytes noChannels = MakeWAV( 6, 1 );
+    noChannels[22] = 0;
+
+    std::vector<Bytes> contents;
+    contents.push_back( MakeWAV( 1, 1 ) );
+    contents.push_back( Bytes() );                      // Missing
+    contents.push_back( notRIFF );
+    contents.push_back( truncated );
+    contents.push_back( MakeWAV( 7, 2, 24 ) );          // 24-bit PCM
+    contents.push_back( MakeWAV( 8, 1, 32, 3 ) );       // IEEE float
+    contents.push_back( noChannels );
+    contents.push_back( MakeWAV( 2, 2, 8 ) );
+
+    std::vector<FileName> files;
+    for ( size_t j = 0; j < contents.size(); j++ )
+    {
+        files.push_back( WaveFileName( j ) );
+        _wremove( files.back().c_str() );
+        if ( !contents[j].empty() )
+        {
+            CHECK( WriteTestFile( files.back(), contents[j] ) );
+        }
+    }
+
+    const WAVEBANK_BUILD_FLAGS flagSets[] = { WaveBankBuild_Default, WaveBankBuild_ADPCM };
+    for ( size_t f = 0; f < ARRAYSIZE( flagSets ); f++ )
+    {
+        WaveBankBuilder builder( 4 );
+        for ( size_t j = 0; j < files.size(); j++ )
+        {
+            builder.AddFile( files[j].c_str(), nullptr );
+        }
+
+        CHECK( !builder.Load( flagSets[f], nullptr ) );
+
+        bool onlyBadFailed = true;
+        for ( size_t j = 0; j < files.size(); j++ )
+        {
+            const WaveBankSource& source = builder.GetSource( j );
+            bool bad = ( j != 0 && j != files.size() - 1 );
+            onlyBadFailed = onlyBadFailed && source.failed == bad && !source.cached;
+            onlyBadFailed = onlyBadFailed && ( source.log.find( "ERROR" ) != std::string::npos ) == bad;
+        }
+
+        CHECK( onlyBadFailed );
+    }
+
+    // Once the bad files are dropped the rest build.
+    WaveBankBuilder good;
+    std::vector<FileName> goodFiles;
+    goodFiles.push_back( files.front() );
+    goodFiles.push_back( files.back() );
+    CHECK( Build( good, goodFiles, WaveBankBuild_Default, 0, nullptr ) );
+
+    RemoveFiles( files );
+}
+
+// Serial, parallel, cold cache and one-file-changed warm cache builds of a few
+// hundred generated waves, plain and compressed.
+BENCHMARK( WaveBankBuilder_Builds )
+{
+    const WAVEBANK_BUILD_FLAGS flagSets[] = { WaveBankBuild_Default, WaveBankBuild_ADPCM };
+    for ( size_t f = 0; f < ARRAYSIZE( flagSets ); f++ )
+    {
+        WaveBankBuildBenchmark result = BenchmarkWaveBankBuild( BenchmarkDirectory, 256, flagSets[f] );
+        CHECK( result.fileCount == 256 && result.bankBytes > 0 && result.serialSeconds > 0.0 && result.warmCacheSeconds > 0.0 );
+
+        wprintf( L"    %s, %u files on %u threads: serial %.1f ms, parallel %.1f ms, cold cache %.1f ms, warm cache %.1f ms\n",
+                 ( flagSets[f] & WaveBankBuild_ADPCM ) ? L"ADPCM" : L"PCM", static_cast<unsigned int>( result.fileCount ), result.threadCount,
+                 result.serialSeconds * 1e3, result.parallelSeconds * 1e3, result.coldCacheSeconds * 1e3, result.warmCacheSeconds * 1e3 );
+    }
+}
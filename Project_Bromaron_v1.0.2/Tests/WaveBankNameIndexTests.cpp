@@ -0,0 +1,263 @@
+//--------------------------------------------------------------------------------------
+// File: WaveBankNameIndexTests.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TestFramework.h"
+#include "WaveBankNameIndex.h"
+
+using namespace DirectX;
+
+namespace
+{
+    const uint32_t NotFound = uint32_t(-1);
+
+    // A names table of count slots, with short names from a small alphabet so
+    // that many repeat, some empty and some the full 64 characters. expected maps
+    // each name to the last entry that has it, as Find should.
+    struct NamesTable
+    {
+        NamesTable( std::mt19937& random, uint32_t entryCount, size_t slotStride ) :
+            table( entryCount * slotStride + 1, 0 ),
+            stride( slotStride ),
+            count( entryCount )
+        {
+            for ( uint32_t j = 0; j < count; j++ )
+            {
+                size_t length = ( random() % 5 == 0 ) ? 64 : random() % 8;
+                for ( size_t k = 0; k < length; k++ )
+                {
+                    table[j * stride + k] = static_cast<char>( 'a' + random() % 3 );
+                }
+
+                expected[NameAt( j )] = j;
+            }
+        }
+
+        std::string NameAt( uint32_t entry ) const
+        {
+            const char* slot = &table[entry * stride];
+            return std::string( slot, std::find( slot, slot + 64, '\0' ) );
+        }
+
+        const char* Names() const
+        {
+            return count ? &table[0] : nullptr;
+        }
+
+        std::vector<char>               table;
+        size_t                          stride;
+        uint32_t                        count;
+        std::map<std::string, uint32_t> expected;
+    };
+
+    bool FindsEveryName( const WaveBankNameIndex& index, const NamesTable& names )
+    {
+        for ( auto it = names.expected.begin(); it != names.expected.end(); ++it )
+        {
+            if ( index.Find( it->first.c_str() ) != it->second )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // The serialized index copied somewhere aligned, as a mapping would be.
+    std::vector<uint32_t> CopyIndex( const WaveBankNameIndex& index )
+    {
+        std::vector<uint32_t> words( index.GetSize() / sizeof( uint32_t ) );
+        if ( !words.empty() )
+        {
+            memcpy( &words[0], index.GetData(), index.GetSize() );
+        }
+
+        return words;
+    }
+
+    const uint8_t* BytesOf( const std::vector<uint32_t>& words )
+    {
+        return reinterpret_cast<const uint8_t*>( words.data() );
+    }
+
+    const MappedFileChar TestFileName[] = L"WaveBankNameIndexTests.xwi";
+}
+
+// Built indexes agree with a std::map over the same table, hits and misses, for
+// tables of every size up to a few hundred and two slot strides.
+TEST( WaveBankNameIndex_MatchesMap )
+{
+    std::mt19937 random( 1 );
+    bool matches = true;
+    for ( int trial = 0; trial < 200; trial++ )
+    {
+        NamesTable names( random, random() % 300, ( trial % 2 ) ? 64 : 80 );
+
+        WaveBankNameIndex index;
+        CHECK( index.IsEmpty() );
+        index.Build( names.Names(), names.stride, names.count );
+        matches = matches && FindsEveryName( index, names );
+
+        for ( int q = 0; q < 50; q++ )
+        {
+            std::string name;
+            size_t length = random() % 9;
+            for ( size_t k = 0; k < length; k++ )
+            {
+                name += static_cast<char>( 'a' + random() % 3 );
+            }
+
+            auto it = names.expected.find( name );
+            matches = matches && ( index.Find( name.c_str() ) == ( ( it != names.expected.end() ) ? it->second : NotFound ) );
+        }
+
+        matches = matches && ( index.Find( std::string( 65, 'a' ).c_str() ) == NotFound ) && ( index.Find( nullptr ) == NotFound );
+    }
+
+    CHECK( matches );
+}
+
+// A serialized index attaches in place only to the table it was built from.
+TEST( WaveBankNameIndex_AttachSerialized )
+{
+    std::mt19937 random( 2 );
+    NamesTable names( random, 500, 64 );
+
+    WaveBankNameIndex built;
+    built.Build( names.Names(), names.stride, names.count );
+    CHECK( !built.IsEmpty() && built.GetSize() > 0 && ( built.GetSize() % sizeof( uint32_t ) ) == 0 );
+
+    std::vector<uint32_t> words = CopyIndex( built );
+    WaveBankNameIndex attached;
+    CHECK( attached.Attach( BytesOf( words ), built.GetSize(), names.Names(), names.stride, names.count ) );
+    CHECK( FindsEveryName( attached, names ) );
+    CHECK( attached.GetData() == BytesOf( words ) && attached.GetSize() == built.GetSize() );
+
+    // A table changed since, a different stride or count, a short or misaligned
+    // copy: each is refused and leaves the index empty.
+    names.table[100] ^= 1;
+    CHECK( !attached.Attach( BytesOf( words ), built.GetSize(), names.Names(), names.stride, names.count ) );
+    CHECK( attached.IsEmpty() && attached.Find( names.NameAt( 0 ).c_str() ) == NotFound );
+    names.table[100] ^= 1;
+
+    CHECK( !attached.Attach( BytesOf( words ), built.GetSize(), names.Names(), 32, names.count ) );
+    CHECK( !attached.Attach( BytesOf( words ), built.GetSize(), names.Names(), names.stride, names.count - 1 ) );
+    CHECK( !attached.Attach( BytesOf( words ), built.GetSize() - 4, names.Names(), names.stride, names.count ) );
+    CHECK( !attached.Attach( BytesOf( words ) + 2, built.GetSize() - 4, names.Names(), names.stride, names.count ) );
+    CHECK( !attached.Attach( nullptr, 0, names.Names(), names.stride, names.count ) );
+
+    CHECK( attached.Attach( BytesOf( words ), built.GetSize(), names.Names(), names.stride, names.count ) );
+    attached.Reset();
+    CHECK( attached.IsEmpty() );
+
+    // Moving keeps the index working.
+    WaveBankNameIndex moved( std::move( built ) );
+    CHECK( FindsEveryName( moved, names ) );
+}
+
+// Flipped bits and cut-off indexes never read out of bounds, and any entry an
+// index that still attaches finds really has the name looked up.
+TEST( WaveBankNameIndex_DamagedIndexes )
+{
+    std::mt19937 random( 3 );
+    size_t attachedCount = 0;
+    bool honest = true;
+    for ( int trial = 0; trial < 50; trial++ )
+    {
+        NamesTable names( random, random() % 300 + 1, 64 );
+        WaveBankNameIndex built;
+        built.Build( names.Names(), names.stride, names.count );
+        std::vector<uint32_t> words = CopyIndex( built );
+
+        for ( int m = 0; m < 200; m++ )
+        {
+            std::vector<uint32_t> damaged( words );
+            size_t at = random() % built.GetSize();
+            reinterpret_cast<uint8_t*>( &damaged[0] )[at] ^= static_cast<uint8_t>( 1 << ( random() % 8 ) );
+
+            // Exact-size copies, so out-of-bounds reads show up under a checker.
+            size_t size = built.GetSize() - ( ( random() % 3 == 0 ) ? 4 : 0 );
+            std::unique_ptr<uint32_t[]> exact( new uint32_t[size / sizeof( uint32_t )] );
+            memcpy( exact.get(), &damaged[0], size );
+
+            WaveBankNameIndex index;
+            if ( !index.Attach( reinterpret_cast<const uint8_t*>( exact.get() ), size, names.Names(), names.stride, names.count ) )
+            {
+                continue;
+            }
+
+            attachedCount++;
+            for ( auto it = names.expected.begin(); it != names.expected.end(); ++it )
+            {
+                uint32_t entry = index.Find( it->first.c_str() );
+                honest = honest && ( entry == NotFound || names.NameAt( entry ) == it->first );
+            }
+        }
+    }
+
+    wprintf( L"    %u damaged indexes still attached\n", static_cast<unsigned int>( attachedCount ) );
+    CHECK( honest );
+}
+
+// An index written to disk attaches straight from its mapping and keeps the
+// mapping alive; the companion file name swaps the bank's extension.
+TEST( WaveBankNameIndex_MapsIndexFiles )
+{
+    std::mt19937 random( 4 );
+    NamesTable names( random, 1000, 64 );
+
+    WaveBankNameIndex built;
+    built.Build( names.Names(), names.stride, names.count );
+
+    FILE* file = nullptr;
+    CHECK( _wfopen_s( &file, TestFileName, L"wb" ) == 0 && file );
+    if ( file )
+    {
+        CHECK( fwrite( built.GetData(), 1, built.GetSize(), file ) == built.GetSize() );
+        fclose( file );
+    }
+
+    {
+        std::shared_ptr<const MappedFile> mapped = MappedFile::Open( TestFileName );
+        CHECK( mapped && mapped->GetSize() == built.GetSize() );
+
+        WaveBankNameIndex index;
+        CHECK( index.Attach( mapped, names.Names(), names.stride, names.count ) );
+        CHECK( mapped.use_count() == 2 );
+
+        mapped.reset();
+        CHECK( FindsEveryName( index, names ) );
+
+        std::shared_ptr<const MappedFile> nothing;
+        CHECK( !index.Attach( nothing, names.Names(), names.stride, names.count ) );
+    }
+
+    _wremove( TestFileName );
+
+    CHECK( GetNameIndexFileName( L"Sounds.v2\\Bank.xwb" ) == L"Sounds.v2\\Bank.xwi" );
+    CHECK( GetNameIndexFileName( L"Sounds.v2/Bank" ) == L"Sounds.v2/Bank.xwi" );
+    CHECK( GetNameIndexFileName( L"Bank.tar.xwb" ) == L"Bank.tar.xwi" );
+}
+
+// Per-lookup cost of scanning the table, a std::map and the index, and what it
+// costs to build or attach each.
+BENCHMARK( WaveBankNameIndex_Lookups )
+{
+    const uint32_t entryCounts[] = { 100, 1000, 10000, 100000 };
+    for ( size_t i = 0; i < ARRAYSIZE( entryCounts ); i++ )
+    {
+        WaveBankNameBenchmark result = BenchmarkWaveBankNameLookup( entryCounts[i], ( entryCounts[i] >= 100000 ) ? 2000 : 20000 );
+        CHECK( result.entryCount == entryCounts[i] );
+        wprintf( L"    %6u entries: linear %8.1f ns, map %6.1f ns, index %5.1f ns; build map %.2f ms, index %.2f ms, attach %.3f ms\n",
+                 result.entryCount, result.linearSeconds * 1e9, result.mapSeconds * 1e9, result.indexSeconds * 1e9,
+                 result.mapBuildSeconds * 1e3, result.buildSeconds * 1e3, result.attachSeconds * 1e3 );
+    }
+}
@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------------
+// File: pch.h
+//
+// Shared by the test sources and by the DirectXTK Audio and game Helpers sources the
+// Tests project compiles, in place of their own pch.h.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+
+#include <windows.h>
+#include <DirectXMath.h>
+#include <ppl.h>
+
+#include <intrin.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef __cplusplus_winrt
+
+// MemoryArena.cpp and EntityWorld.cpp report failures with C++/CX exceptions. Without
+// /ZW, "throw ref new Platform::X(...)" throws a Platform::X* instead, which tests
+// catch and delete. Every standard header is included above, before ref goes away.
+#define ref
+
+namespace Platform
+{
+    class Exception
+    {
+    public:
+        explicit Exception( const wchar_t* message = L"" ) : Message( message ) {}
+        const wchar_t* Message;
+    };
+
+    class OutOfMemoryException : public Exception
+    {
+    public:
+        explicit OutOfMemoryException( const wchar_t* message = L"" ) : Exception( message ) {}
+    };
+
+    class FailureException : public Exception
+    {
+    public:
+        explicit FailureException( const wchar_t* message = L"" ) : Exception( message ) {}
+    };
+}
+
+#endif
@@ -106,12 +106,18 @@ void App::Run()
     {
         if (m_windowVisible)
         {
-            m_coreWindow->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
+            PROFILE_SCOPE("Frame");
+
+            {
+                PROFILE_SCOPE("ProcessEvents");
+                m_coreWindow->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
+            }
 
             m_main->Update();
 
             if (m_main->Render())
             {
+                PROFILE_SCOPE("Present");
                 m_deviceResources->Present();
             }
         }
@@ -145,10 +151,19 @@ void App::OnSuspending(Platform::Object^ sender, SuspendingEventArgs^ args)
     // the app will be forced to exit.
     SuspendingDeferral^ deferral = args->SuspendingOperation->GetDeferral();
 
+    // Saved here on the game loop's thread, which is the only one that records input.
+    m_main->SaveInputRecording();
+
     create_task([this, deferral]()
     {
         m_deviceResources->Trim();
 
+#if PROFILER_ENABLED
+        // Leave the recent frames where chrome://tracing can load them.
+        std::wstring tracePath(Windows::Storage::ApplicationData::Current->LocalFolder->Path->Data());
+        FrameProfiler::WriteChromeTrace(tracePath + L"\\frame_trace.json");
+#endif
+
         // Insert your code here.
 
         deferral->Complete();
@@ -17,55 +17,90 @@ using namespace DirectX;
 using namespace Windows::Foundation;
 
 // Loads vertex and pixel shaders from files and instantiates the cube geometry.
-Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
+Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources, LinearArena& frameArena, unsigned int seed) :
 m_loadingComplete(false),
 m_contextReady(false),
 m_degreesPerSecond(45),
 m_indexCount(0),
 m_tracking(false),
-m_deviceResources(deviceResources)
+m_deviceResources(deviceResources),
+m_frameArena(frameArena),
+m_loadArena(LOAD_ARENA_BYTES),
+m_splineRandom(seed),
+m_splinePoint(0, 0, 0, 0),
+m_seed(seed)
 {
 	CreateDeviceDependentResources();
 	CreateWindowSizeDependentResources();
 	CreateAsteroidField();
 	CreateCamera();
+	CreateSystems();
 }
 
 void Sample3DSceneRenderer::CreateCamera()
 {
-	cam.pos = XMVectorSet(0, 0, 0, 0);
-	cam.ori = XMQuaternionRotationRollPitchYaw(0, 0, 0);
+	Pose pose;
+	pose.pos = XMVectorSet(0, 0, 0, 0);
+	pose.ori = XMQuaternionRotationRollPitchYaw(0, 0, 0);
+
+	Camera cam;
+	cam.forward = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	cam.up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	cam.left = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+
+	Laser laser;
 	laser.ori = XMQuaternionRotationRollPitchYaw(0, 0, 0);
+	laser.isFiring = false;
+	laser.type = 0;
+	laser.draw = 0;
+	laser.count = 0;
+	laser.power = 0;
+
+	m_player = m_world.CreateEntity(pose, cam, laser);
+
+	// camera is the root, the laser hangs below it and the target box sits down the laser
+	m_transforms.Clear();
+	m_cameraNode = m_transforms.AddNode();
+	m_laserNode = m_transforms.AddNode(m_cameraNode);
+	m_targetNode = m_transforms.AddNode(m_laserNode);
+	m_transforms.SetLocalTranslation(m_laserNode, XMVectorSet(0.0f, -0.2f, 0.0f, 0.0f));
+	m_transforms.SetLocalTranslation(m_targetNode, XMVectorSet(0.0f, 0.0f, 70.0f, 0.0f));
 }
 void Sample3DSceneRenderer::CameraMove(float ahead)
 {
+	Pose* pose = m_world.GetComponent<Pose>(m_player);
+	Camera* cam = m_world.GetComponent<Camera>(m_player);
+
 	// move "ahead" amount in forward direction
-	XMVECTOR aheadv = XMVectorScale(cam.forward, ahead);
-	cam.pos = XMVectorAdd(cam.pos, aheadv);
+	XMVECTOR aheadv = XMVectorScale(cam->forward, ahead);
+	pose->pos = XMVectorAdd(pose->pos, aheadv);
 }
 
 void Sample3DSceneRenderer::CameraSpin(float roll, float pitch, float yaw)
 {
+	Pose* pose = m_world.GetComponent<Pose>(m_player);
+	Camera* cam = m_world.GetComponent<Camera>(m_player);
+
 	// make sure camera properties are up to date
 	// NB: actually unnecessary, since they are updated every frame anyway; done here for clarity
-	cam.forward = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-	cam.up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-	cam.left = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	cam->forward = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	cam->up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	cam->left = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
 
-	cam.forward = XMVector4Transform(cam.forward, XMMatrixRotationQuaternion(cam.ori));
-	cam.up = XMVector4Transform(cam.up, XMMatrixRotationQuaternion(cam.ori));
-	cam.left = XMVector3Cross(cam.forward, cam.up);
+	cam->forward = XMVector4Transform(cam->forward, XMMatrixRotationQuaternion(pose->ori));
+	cam->up = XMVector4Transform(cam->up, XMMatrixRotationQuaternion(pose->ori));
+	cam->left = XMVector3Cross(cam->forward, cam->up);
 	// apply camera-relative orientation changes
 
-	XMVECTOR rollq = XMQuaternionRotationAxis(cam.forward, roll*0.05);
-	XMVECTOR pitchq = XMQuaternionRotationAxis(cam.left, pitch*0.05);
-	XMVECTOR yawq = XMQuaternionRotationAxis(cam.up, yaw*0.05);
+	XMVECTOR rollq = XMQuaternionRotationAxis(cam->forward, roll*0.05);
+	XMVECTOR pitchq = XMQuaternionRotationAxis(cam->left, pitch*0.05);
+	XMVECTOR yawq = XMQuaternionRotationAxis(cam->up, yaw*0.05);
 	//Roll:
-	cam.ori = XMQuaternionMultiply(cam.ori,rollq);
+	pose->ori = XMQuaternionMultiply(pose->ori,rollq);
 	//Pitch:
-	cam.ori = XMQuaternionMultiply(cam.ori,pitchq);
+	pose->ori = XMQuaternionMultiply(pose->ori,pitchq);
 	//Yaw:
-	cam.ori = XMQuaternionMultiply(cam.ori,yawq);
+	pose->ori = XMQuaternionMultiply(pose->ori,yawq);
 }
 
 void Sample3DSceneRenderer::LaserSpin(float laserPitch, float laserYaw)
@@ -78,18 +113,19 @@ void Sample3DSceneRenderer::LaserSpin(float laserPitch, float laserYaw)
 	XMVECTOR pitchq = XMQuaternionRotationRollPitchYaw(laserPitch*0.01, 0, 0);
 	XMVECTOR yawq = XMQuaternionRotationRollPitchYaw(0, laserYaw*0.01, 0);
 
-	laser.ori = XMQuaternionMultiply(laser.ori, pitchq);
-	laser.ori = XMQuaternionMultiply(laser.ori, yawq);
+	Laser* laser = m_world.GetComponent<Laser>(m_player);
+	laser->ori = XMQuaternionMultiply(laser->ori, pitchq);
+	laser->ori = XMQuaternionMultiply(laser->ori, yawq);
 }
 
 void Sample3DSceneRenderer::LaserFire(bool isFiring)
 {
-	laser.isFiring = isFiring;
+	m_world.GetComponent<Laser>(m_player)->isFiring = isFiring;
 }
 
 void Sample3DSceneRenderer::LaserFireType(int type)
 {
-	laser.type = type;
+	m_world.GetComponent<Laser>(m_player)->type = type;
 }
 
 // Initializes view parameters when the window size changes.
@@ -151,18 +187,76 @@ void Sample3DSceneRenderer::CreateWindowSizeDependentResources()
 void Sample3DSceneRenderer::CreateAsteroidField()
 {
 	numast = 1000;
+	srand(m_seed);
 	XMVECTOR angles;
-//	debris = malloc(numast*sizeof(Asteroid));
+	Pose pose;
+	Spin spin;
+	Destructible state;
+
 	for (int i = 0; i < numast; i++)
 	{
 		angles = XMVectorSet(3.14*(rand() % 1000) / 1000.0f, 3.14*(rand() % 1000) / 1000.0f, 3.14*(rand() % 1000) / 1000.0f, 1.0f);
-		debris[i].pos = XMVectorSet(600 * (rand() % 1000) / 1000.0f, 600 * (rand() % 1000) / 1000.0f, 600 * (rand() % 1000) / 1000.0f, 1.0f);
-		debris[i].ori = XMQuaternionRotationRollPitchYawFromVector(angles);
+		pose.pos = XMVectorSet(600 * (rand() % 1000) / 1000.0f, 600 * (rand() % 1000) / 1000.0f, 600 * (rand() % 1000) / 1000.0f, 1.0f);
+		pose.ori = XMQuaternionRotationRollPitchYawFromVector(angles);
 		angles = XMVectorSet(0.01*3.14*(rand() % 1000) / 1000.0f, 0.01*3.14*(rand() % 1000) / 1000.0f, 0.01*3.14*(rand() % 1000) / 1000.0f, 1.0f);
-		debris[i].L = XMQuaternionRotationRollPitchYawFromVector(angles);
+		spin.L = XMQuaternionRotationRollPitchYawFromVector(angles);
+		spin.vel = XMVectorZero();
+		state.boolDraw = true;
+		state.hitCounter = 0;
+
+		m_world.CreateEntity(pose, spin, state);
 	}
 }
 
+void Sample3DSceneRenderer::CreateSystems()
+{
+	//each system lists what it reads and writes; systems that don't clash run side by side
+	m_systems.Clear();
+
+	//asteroid hits: rammed by the player or cut by the laser
+	m_systems.AddSystem("AsteroidHits", ComponentMaskOf<Pose, Laser>(), ComponentMaskOf<Destructible>(), [this](EntityWorld& world)
+	{
+		XMVECTOR playerPos = world.GetComponent<Pose>(m_player)->pos;
+		const Laser* laser = world.GetComponent<Laser>(m_player);
+
+		world.ForEach<Pose, Destructible>([&](const Pose& pose, Destructible& state)
+		{
+			if (state.boolDraw == false){
+				return;
+			}
+			if (collisionDetection(playerPos, pose.pos)){
+				state.hitCounter = 3;//TODO testing only
+			}
+
+			if (intersectRaySphere(playerPos, laser->ori, pose.pos, 10.0f) && laser->isFiring){
+				state.hitCounter = 3;//TODO testing only
+			}
+
+			if (isDestroyedAsstroid(state.hitCounter)){
+				state.boolDraw = false;
+			}
+		});
+	});
+
+	//laser shot: runs after the hit test has seen this tick's trigger, then consumes it
+	m_systems.AddSystem("LaserShot", 0, ComponentMaskOf<Laser>(), [this](EntityWorld&)
+	{
+		UpdateLaser();
+	});
+
+	//player frame and view matrix; only reads poses, so it shares a stage with the hit test
+	m_systems.AddSystem("PlayerCamera", ComponentMaskOf<Pose>(), ComponentMaskOf<Camera>(), [this](EntityWorld&)
+	{
+		UpdatePlayer();
+	});
+
+	//asteroid spin; writes poses, so it waits for both of the above
+	m_systems.AddSystem("AsteroidSpin", ComponentMaskOf<Spin>(), ComponentMaskOf<Pose>(), [this](EntityWorld&)
+	{
+		UpdateWorld();
+	});
+}
+
 // Called once per frame, rotates the cube and calculates the model and view matrices.
 void Sample3DSceneRenderer::Update(DX::StepTimer const& timer)
 {
@@ -179,27 +273,102 @@ void Sample3DSceneRenderer::Update(DX::StepTimer const& timer)
 
 	m_timer = timer.GetFramesPerSecond() / 60.;
 
-	for (int i = 0; i < numast; i++)
-	{ // draw every asteroid
-		if (debris[i].boolDraw==false){
-			continue;
-		}
-		if (collisionDetection(cam.pos, debris[i].pos)){
-			debris[i].hitCounter = 3;//TODO testing only
-		}
+	//hit tests, laser shot, player camera and asteroid spin
+	m_systems.Run(m_world);
 
-		if (intersectRaySphere(cam.pos, laser.ori, debris[i].pos, 10.0f) && laser.isFiring){
-			debris[i].hitCounter = 3;//TODO testing only
+	//spline pathing; the control points come from the seeded generator, so draw from it here rather than per rendered frame
+	float circtime, t, p1w, p2w, p3w, p4w;
+
+	circtime = fmodf((m_timer / 100), 16);
+	t = circtime - floor(circtime);
+
+	p1w = (1 - t)*(1 - t)*(1 - t);
+	p2w = 3 * t*(1 - t)*(1 - t);
+	p3w = 3 * t*t*(1 - t);
+	p4w = t*t*t;
+
+	int wsec = ((int)floor(circtime)) * 4; //picks which set of control points are used 
+
+	XMFLOAT4* P;
+	P = createSpline();
+
+	m_splinePoint.x = p1w*P[0 + wsec].x + p2w*P[1 + wsec].x + p3w*P[2 + wsec].x + p4w*P[3 + wsec].x;
+	m_splinePoint.y = p1w*P[0 + wsec].y + p2w*P[1 + wsec].y + p3w*P[2 + wsec].y + p4w*P[3 + wsec].y;
+	m_splinePoint.z = p1w*P[0 + wsec].z + p2w*P[1 + wsec].z + p3w*P[2 + wsec].z + p4w*P[3 + wsec].z;
+	m_splinePoint.w = 0;
+}
+
+// FNV-1a over the simulated state (asteroids and the player), so a replay can
+// tell the first tick where it stopped matching the recording.
+unsigned int Sample3DSceneRenderer::GetStateChecksum()
+{
+	unsigned int hash = 2166136261u;
+	auto mix = [&hash](const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 16777619u;
 		}
+	};
 
-		if (isDestroyedAsstroid(debris[i].hitCounter)){
-			debris[i].boolDraw = false;
+	m_world.ForEach<Pose, Destructible>([&](const Pose& pose, const Destructible& state)
+	{
+		mix(&pose, sizeof(pose));
+		mix(&state.boolDraw, sizeof(state.boolDraw));
+		mix(&state.hitCounter, sizeof(state.hitCounter));
+	});
+
+	const Pose* player = m_world.GetComponent<Pose>(m_player);
+	const Laser* laser = m_world.GetComponent<Laser>(m_player);
+	mix(player, sizeof(*player));
+	mix(&laser->ori, sizeof(laser->ori));
+	mix(&laser->isFiring, sizeof(laser->isFiring));
+	mix(&laser->type, sizeof(laser->type));
+	mix(&laser->count, sizeof(laser->count));
+
+	return hash;
+}
+
+// Turns this tick's trigger into a shot. The trigger is consumed here, once per
+// simulation tick, so several ticks in one frame (or a replay that never renders)
+// don't apply the same shot again. Render() only draws what this leaves behind.
+void Sample3DSceneRenderer::UpdateLaser()
+{
+	Laser& laser = *m_world.GetComponent<Laser>(m_player);
+
+	laser.draw = 0;
+	if (laser.isFiring){
+		if (laser.type == 0){// This does the weaker laser shot
+			laser.draw = 1;
+			laser.power = 1;
 		}
-		
+		else if (laser.type == 1)//TODO possibly sphere shot?
+		{
+			laser.draw = 1;
+			laser.power = 3;
+		}
+		else //This does the Stronger single shot
+		{
+			if (laser.count < 7){
+				laser.count++;
+				laser.draw = 1;
+				laser.power = 2;
+			}
+			else if (laser.count > 30)
+			{
+				laser.count = 0;
+				laser.power = 0;
+			}
+			else{
+				laser.count++;
+			}
+		}
+		laser.isFiring = false;
+	}
+	else{
+		laser.count = 0;
 	}
-
-	UpdateWorld();
-	UpdatePlayer();
 }
 
 bool Sample3DSceneRenderer::isDestroyedAsstroid(int hitcount){
@@ -305,16 +474,18 @@ void Sample3DSceneRenderer::UpdatePlayer()
 	// update player: rebuild coordinate frame using current orientation,
 	// plus remake and reset camera transformation
 	XMVECTOR L;
+	const Pose* pose = m_world.GetComponent<Pose>(m_player);
+	Camera* cam = m_world.GetComponent<Camera>(m_player);
 	
 	// canonical coordinate frame
-	cam.forward = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-	cam.up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-	cam.left = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	cam->forward = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	cam->up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	cam->left = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
 
 	// rotate frame with current camera quaternion
-	cam.forward = XMVector4Transform(cam.forward, XMMatrixRotationQuaternion(cam.ori));
-	cam.up = XMVector4Transform(cam.up, XMMatrixRotationQuaternion(cam.ori));
-	cam.left = XMVector3Cross(cam.forward, cam.up);
+	cam->forward = XMVector4Transform(cam->forward, XMMatrixRotationQuaternion(pose->ori));
+	cam->up = XMVector4Transform(cam->up, XMMatrixRotationQuaternion(pose->ori));
+	cam->left = XMVector3Cross(cam->forward, cam->up);
 
 	// tiny extra rotation even when there is no input
 	//L = XMQuaternionRotationAxis(cam.forward, 0.001);
@@ -324,17 +495,17 @@ void Sample3DSceneRenderer::UpdatePlayer()
 	//cam.pos = XMVectorAdd(cam.pos, XMVectorScale(cam.forward, 0.05));
 
 	// remake view matrix, store in constant buffer data
-	XMStoreFloat4x4(&m_constantBufferData.view, XMMatrixTranspose(XMMatrixLookToRH(cam.pos,cam.forward,cam.up)));
+	XMStoreFloat4x4(&m_constantBufferData.view, XMMatrixTranspose(XMMatrixLookToRH(pose->pos,cam->forward,cam->up)));
 	// constant buffer data is headed to card on per-object basis, so no need to reset here
 }
 
 void Sample3DSceneRenderer::UpdateWorld()
 {
 	// asteroids rotate, here; could make them move also, not done now
-	for (int i = 0; i < numast; i++)
+	m_world.ForEach<Pose, Spin>([](Pose& pose, const Spin& spin)
 	{
-		debris[i].ori = XMQuaternionMultiply(debris[i].ori, debris[i].L);
-	}
+		pose.ori = XMQuaternionMultiply(pose.ori, spin.L);
+	});
 }
 
 
@@ -419,115 +590,64 @@ void Sample3DSceneRenderer::Render()
 
 	XMMATRIX thexform;
 	
-	for (int i = 0; i < numast; i++)
+	PROFILE_SCOPE("Scene.DrawAsteroids");
+	m_world.ForEach<Pose, Destructible>([&](const Pose& pose, const Destructible& state)
 	{ // draw every asteroid
-		if (debris[i].boolDraw == true){
-			thexform = XMMatrixRotationQuaternion(debris[i].ori);
-			thexform = XMMatrixMultiply(thexform, XMMatrixTranslationFromVector(debris[i].pos));
-			XMVECTOR move = {- rand() % 100 /100, - rand() % 100/100, - rand() % 100/100 };
-			// XMVECTOR move = {- rand() % 100 /10, - rand() % 100/10, - rand() % 100/10 };
-			debris[i].pos += move;
+		if (state.boolDraw == true){
+			thexform = XMMatrixRotationQuaternion(pose.ori);
+			thexform = XMMatrixMultiply(thexform, XMMatrixTranslationFromVector(pose.pos));
 			DrawOne(context, &thexform);
 		}
-	}
+	});
 
-	//camera transform, here i consider camera as root
-	XMMATRIX cameraXform, laserXform, targetXform;
-	cameraXform = XMMatrixRotationQuaternion(cam.ori);
-	cameraXform = XMMatrixMultiply(cameraXform, XMMatrixTranslationFromVector(cam.pos));
+	const Pose* player = m_world.GetComponent<Pose>(m_player);
+	const Laser& laser = *m_world.GetComponent<Laser>(m_player);
 
-	//laser's local xform
-	laserXform = XMMatrixIdentity();
-	laserXform = XMMatrixRotationQuaternion(laser.ori);
-	laserXform = XMMatrixMultiply(laserXform, XMMatrixTranslation(0.0f, -0.2f, 0.0f));
+	//camera transform, here i consider camera as root; only changed nodes get recomputed
+	m_transforms.SetLocalRotation(m_cameraNode, player->ori);
+	m_transforms.SetLocalTranslation(m_cameraNode, player->pos);
+	m_transforms.SetLocalRotation(m_laserNode, laser.ori);
+	m_transforms.Update();
 
-	//fire laser 
-	if (laser.isFiring){
+	//laser's world xform, already includes the camera
+	XMMATRIX laserWorld = m_transforms.GetWorldMatrix(m_laserNode);
+
+	//fire laser; UpdateLaser() decided whether the last tick produced a shot
+	if (laser.draw == 1){
 		if (laser.type == 0){// This does the weaker laser shot
 			//hierarchical xform from camera
 			thexform = XMMatrixIdentity();
 			thexform = XMMatrixMultiply(thexform, XMMatrixTranslation(0,0,500));
-			thexform *= XMMatrixMultiply(laserXform, cameraXform);
+			thexform *= laserWorld;
 			//thexform = XMMatrixMultiply(thexform, XMMatrixRotationNormal());//Apply rotation for camera
 			thexform = XMMatrixMultiply(XMMatrixScaling(0.1, 0.1, 1000), thexform);
 			thexform = XMMatrixMultiply(thexform, XMMatrixTranslation(0.5f, 0.0f, 0.0f));
 			
 			DrawOne(context, &thexform);
 			thexform = XMMatrixMultiply(thexform, XMMatrixTranslation(-1.0f, 0.0f, 0.0f));
-			laser.draw = 1;
-			laser.power = 1;
 		}
 		else if (laser.type == 1)//TODO possibly sphere shot?
 		{
-			thexform = XMMatrixMultiply(laserXform, cameraXform);
+			thexform = laserWorld;
 			thexform = XMMatrixMultiply(thexform, XMMatrixTranslation(0.5f, 0.0f, 0.0f));
 			thexform = XMMatrixMultiply(XMMatrixScaling(0.1, 0.1, 1000), thexform);
-			laser.draw = 1;
-			laser.power = 3;
 		}
 		else //This does the Stronger single shot
 		{
-			if (laser.count < 7){
-				thexform = XMMatrixMultiply(laserXform, cameraXform);
-				thexform = XMMatrixMultiply(XMMatrixScaling(0.1, 0.1, 1000), thexform);
-				laser.count++;
-				laser.draw = 1;
-				laser.power = 2;
-			}
-			else if (laser.count > 30)
-			{
-				laser.count = 0;
-				laser.power = 0;
-			}
-			else{
-				laser.count++;
-			}
-		}
-		if (laser.draw == 1){
-			DrawOne(context, &thexform);
+			thexform = laserWorld;
+			thexform = XMMatrixMultiply(XMMatrixScaling(0.1, 0.1, 1000), thexform);
 		}
-		laser.isFiring = false;
-	}
-	else{
-		laser.count = 0;
+		DrawOne(context, &thexform);
 	}
 
-	//target box's local xform
-	targetXform = XMMatrixIdentity();
-	targetXform = XMMatrixMultiply(targetXform, XMMatrixTranslation(0.0f, 0.0f, 70.0f));
-
-	//inherit laser xform
-	targetXform = XMMatrixMultiply(targetXform, laserXform);
-	//inherit camera xform
-	targetXform = XMMatrixMultiply(targetXform, cameraXform);
-	thexform = XMMatrixMultiply(XMMatrixScaling(2, 2, 2), targetXform);
+	//target box inherits laser and camera xforms through the hierarchy
+	thexform = XMMatrixMultiply(XMMatrixScaling(2, 2, 2), m_transforms.GetWorldMatrix(m_targetNode));
 	//DrawOne(context, &thexform);
 
-	//spline pathing
-	float circtime, t, p1w, p2w, p3w, p4w;
-
-	circtime = fmodf((m_timer / 100), 16);
-	t = circtime - floor(circtime);	
-
-	p1w = (1 - t)*(1 - t)*(1 - t);
-	p2w = 3 * t*(1 - t)*(1 - t);
-	p3w = 3 * t*t*(1 - t);
-	p4w = t*t*t;
-
-	int wsec = ((int)floor(circtime)) * 4; //picks which set of control points are used 
-
-	XMFLOAT4* P;
-	P = createSpline();
-
-	XMFLOAT4 Bt;
-	Bt.x = p1w*P[0 + wsec].x + p2w*P[1 + wsec].x + p3w*P[2 + wsec].x + p4w*P[3 + wsec].x;
-	Bt.y = p1w*P[0 + wsec].y + p2w*P[1 + wsec].y + p3w*P[2 + wsec].y + p4w*P[3 + wsec].y;
-	Bt.z = p1w*P[0 + wsec].z + p2w*P[1 + wsec].z + p3w*P[2 + wsec].z + p4w*P[3 + wsec].z;
-	Bt.w = 0;
-
+	//spline pathing, point picked in Update()
 	XMMATRIX temp;
 	temp = XMMatrixIdentity();
-	temp = XMMatrixTranslation(Bt.x, Bt.y, Bt.z);
+	temp = XMMatrixTranslation(m_splinePoint.x, m_splinePoint.y, m_splinePoint.z);
 	DrawOne(context, &temp);
 
 	//Skybox
@@ -636,19 +756,21 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 			1, 7, 5,
 		};
 
+		//all generated geometry goes back to the load arena once it is uploaded
+		ScopedArena meshArena(m_loadArena);
+
 		VertexPositionColor *particledata;
 		VertexPositionColor thisone;
 		XMFLOAT3 thisnor;
 		numParticles = 7500;
 
-		particledata = (VertexPositionColor *)malloc(numParticles*sizeof(VertexPositionColor));
+		particledata = meshArena.AllocateArray<VertexPositionColor>(numParticles);
 
 		float u, v, w, theta, phi, spray;
 		float trad = 0.4;
 		float maxspray = 0.5;
 
-		std::random_device rd;
-		std::mt19937 lotto(rd());
+		std::mt19937 lotto(m_seed);
 		std::uniform_real_distribution<> distro(0, 1);
 
 		for (int i = 0; i < numParticles; i++)
@@ -685,7 +807,7 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 		int numindices = circle*loop * 6;
 		VertexPositionColor *vertices;
 
-		vertices = (VertexPositionColor *)malloc(numvertices*sizeof(VertexPositionColor));
+		vertices = meshArena.AllocateArray<VertexPositionColor>(numvertices);
 
 
 		// a circle now
@@ -711,7 +833,7 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 		}
 
 		WORD *indices;
-		indices = (WORD *)malloc(sizeof(WORD)*numindices);
+		indices = meshArena.AllocateArray<WORD>(numindices);
 		int count = 0;
 		for (int i = 0; i < loop; i++)
 		{
@@ -778,11 +900,14 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 	ID3D11Resource *pp;
 	ID3D11ShaderResourceView *textureView;
 
-	CreateDDSTextureFromFile(m_deviceResources->GetD3DDevice(), context,
-		L"Assets/2365.dds",
-		&pp,
-		&textureView,
-		0);
+	{
+		PROFILE_SCOPE("DDSTextureLoader");
+		CreateDDSTextureFromFile(m_deviceResources->GetD3DDevice(), context,
+			L"Assets/2365.dds",
+			&pp,
+			&textureView,
+			0);
+	}
 
 	// Create the sampler state
 	ID3D11SamplerState*                 mySampler = NULL;
@@ -810,12 +935,11 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 
 XMFLOAT4* Sample3DSceneRenderer::createSpline()
 {
-	//Spline Control point set up
-	DirectX::XMFLOAT4 m_splineArray[64];
+	//Spline Control point set up, lives in the frame arena until the next frame
+	DirectX::XMFLOAT4* m_splineArray = m_frameArena.AllocateArray<DirectX::XMFLOAT4>(64);
 	float u, v, w;
 
-	std::random_device rd;
-	std::mt19937 lotto(rd());
+	std::mt19937& lotto = m_splineRandom;
 	std::uniform_real_distribution<> distro(0, 1);
 
 	//Randomize X, Y, Z
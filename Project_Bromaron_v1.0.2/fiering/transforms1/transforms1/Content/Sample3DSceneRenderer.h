@@ -10,9 +10,16 @@
 #include "..\Helpers\DeviceResources.h"
 #include "ShaderStructures.h"
 #include "..\Helpers\StepTimer.h"
+#include "..\Helpers\TransformHierarchy.h"
+#include "..\Helpers\EntityWorld.h"
+#include "..\Helpers\MemoryArena.h"
+#include "..\Helpers\FrameProfiler.h"
+#include "SceneComponents.h"
 
 #include "..\..\..\DirectXTK\Inc\DDSTextureLoader.h"
 
+#include <random>
+
 using namespace DirectX;
 
 namespace DirectXGame2
@@ -21,7 +28,7 @@ namespace DirectXGame2
     class Sample3DSceneRenderer
     {
     public:
-        Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources);
+        Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources, LinearArena& frameArena, unsigned int seed);
         void CreateDeviceDependentResources();
         void CreateWindowSizeDependentResources();
         void ReleaseDeviceDependentResources();
@@ -38,6 +45,7 @@ namespace DirectXGame2
 		void LaserSpin(float laserPitch, float laserYaw);
 		void LaserFire(bool isFiring);
 		void LaserFireType(int type);
+		unsigned int GetStateChecksum();
 		XMFLOAT4* createSpline();
 		float	m_timer;
 		bool collisionDetection(XMVECTOR objectOne, XMVECTOR objectTwo);
@@ -46,6 +54,8 @@ namespace DirectXGame2
 		void DrawOne(ID3D11DeviceContext2 *context, XMMATRIX *thexform);
 		void CreateAsteroidField();
 		void CreateCamera();
+		void CreateSystems();
+		void UpdateLaser();
 		bool intersectRaySphere(XMVECTOR rO, XMVECTOR rV, XMVECTOR sO, double sR);
     private:
         // Cached pointer to device resources.
@@ -73,42 +83,31 @@ namespace DirectXGame2
 
 
 
-		// Variables for player
-		typedef struct Camera
-		{
-			XMVECTOR pos;
-			XMVECTOR ori;
-			XMVECTOR forward;
-			XMVECTOR up;
-			XMVECTOR left; // player coordinate frame, rebuilt from orientation
-		};
+		// Scene entities: the player is Pose + Camera + Laser, asteroids are Pose + Spin + Destructible
+		EntityWorld m_world;
+		EntitySystemScheduler m_systems;
+		Entity m_player;
 
-		Camera cam;
 		// Variables for asteroid field
-		typedef struct Asteroid {
-			XMVECTOR pos; // position
-			XMVECTOR ori; // orientation
-			XMVECTOR L; // angular momentum (use as velocity)
-			XMVECTOR vel; // linear velocity
-			bool boolDraw = true;
-			int hitCounter = 0;
-		};
-
 		int numast;
-		Asteroid debris[1000];
 		bool isDestroyedAsstroid(int hitcount);
 
-		typedef struct Laser
-		{
-			XMVECTOR ori;
-			bool isFiring;
-			int type;
-			int draw = 0;
-			int count = 0;
-			int power;
-		};
-
-		Laser laser;
+		// Per-frame temporaries (owned by main, reset every frame) and load-time mesh building
+		LinearArena& m_frameArena;
+		LinearArena m_loadArena;
+
+		// Spline control point generator, seeded once, and the point it put the marker at on the last tick
+		std::mt19937 m_splineRandom;
+		XMFLOAT4 m_splinePoint;
+
+		// Seed for everything random in the scene, so a recorded session replays identically.
+		unsigned int m_seed;
+
+		// Camera-attached objects: camera -> laser -> target box.
+		TransformHierarchy m_transforms;
+		TransformNode m_cameraNode;
+		TransformNode m_laserNode;
+		TransformNode m_targetNode;
     };
 }
 
@@ -11,17 +11,46 @@
 
 using namespace DirectXGame2;
 
+namespace
+{
+    // Appends formatted text at *length. Once the buffer is full the rest is
+    // dropped, so the overlay text never needs the heap.
+    void AppendFormat(wchar_t* buffer, size_t capacity, size_t* length, const wchar_t* format, ...)
+    {
+        if (*length + 1 >= capacity)
+        {
+            return;
+        }
+
+        va_list args;
+        va_start(args, format);
+        int written = _vsnwprintf_s(buffer + *length, capacity - *length, _TRUNCATE, format, args);
+        va_end(args);
+
+        *length = (written < 0) ? capacity - 1 : *length + written;
+    }
+}
+
 // Initializes D2D resources used for text rendering.
 SampleDebugTextRenderer::SampleDebugTextRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
-Overlay(deviceResources)
+Overlay(deviceResources),
+m_gamepadPollRate(0),
+m_profileRefreshSeconds(0.0),
+m_profilerOverheadNs(0.0)
 {
     ZeroMemory(&m_textMetrics, sizeof(DWRITE_TEXT_METRICS) * XINPUT_MAX_CONTROLLERS);
     ZeroMemory(&m_textMetricsFPS, sizeof(DWRITE_TEXT_METRICS));
+    ZeroMemory(&m_eventToSimulation, sizeof(InputLatencyStats));
+    ZeroMemory(&m_simulationToSubmit, sizeof(InputLatencyStats));
+    ZeroMemory(&m_soundCache, sizeof(SoundCacheStats));
+    ZeroMemory(&m_music, sizeof(MusicStreamStats));
 
-    for (unsigned int i = 0; i < 4; i++)
+    for (unsigned int i = 0; i < XINPUT_MAX_CONTROLLERS; i++)
     {
-        m_text[i] = L"";
+        m_text[i][0] = L'\0';
     }
+    m_textFPS[0] = L'\0';
+    m_textProfile[0] = L'\0';
     // Create device-independent resources.
     DX::ThrowIfFailed(
         m_deviceResources->GetDWriteFactory()->CreateTextFormat(
@@ -40,6 +69,24 @@ Overlay(deviceResources)
         m_textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR)
         );
 
+    DX::ThrowIfFailed(
+        m_deviceResources->GetDWriteFactory()->CreateTextFormat(
+        L"Consolas",
+        nullptr,
+        DWRITE_FONT_WEIGHT_NORMAL,
+        DWRITE_FONT_STYLE_NORMAL,
+        DWRITE_FONT_STRETCH_NORMAL,
+        14.0f,
+        L"en-US",
+        &m_profileTextFormat
+        )
+        );
+
+#if PROFILER_ENABLED
+    // Measured once up front; this also clears the profiler's buffers.
+    m_profilerOverheadNs = FrameProfiler::MeasureScopeOverhead();
+#endif
+
     DX::ThrowIfFailed(
         m_deviceResources->GetD2DFactory()->CreateDrawingStateBlock(&m_stateBlock)
         );
@@ -75,76 +122,200 @@ void SampleDebugTextRenderer::Update(DX::StepTimer const& timer)
     // Update display text.
     uint32 fps = timer.GetFramesPerSecond();
 
-    m_textFPS = (fps > 0) ? std::to_wstring(fps) + L" FPS" : L" - FPS";
+    wchar_t text[DEBUG_TEXT_FPS_CHARS];
+    size_t length = 0;
+    text[0] = L'\0';
+
+    // Heap allocations made during the previous frame (debug builds only).
+    if (AllocationTracker::IsEnabled())
+    {
+        AppendFormat(text, DEBUG_TEXT_FPS_CHARS, &length, L"%u allocs  ", AllocationTracker::GetLastFrameAllocationCount());
+    }
+
+    if (fps > 0)
+    {
+        AppendFormat(text, DEBUG_TEXT_FPS_CHARS, &length, L"%u FPS", fps);
+    }
+    else
+    {
+        AppendFormat(text, DEBUG_TEXT_FPS_CHARS, &length, L" - FPS");
+    }
+
+    // The text only changes about once a second, so keep the layout until it does.
+    if ((m_textLayoutFPS == nullptr) || (wcscmp(text, m_textFPS) != 0))
+    {
+        wcscpy_s(m_textFPS, text);
+
+        DX::ThrowIfFailed(
+            m_deviceResources->GetDWriteFactory()->CreateTextLayout(
+            m_textFPS,
+            (uint32) length,
+            m_textFormat.Get(),
+            480.0f, // Max width of the FPS text.
+            50.0f, // Max height of the FPS text.
+            &m_textLayoutFPS
+            )
+            );
+
+        DX::ThrowIfFailed(
+            m_textLayoutFPS->GetMetrics(&m_textMetricsFPS)
+            );
+    }
+
+    // Summarizing walks every recorded event, so only refresh about once a second.
+    if (timer.GetTotalSeconds() < m_profileRefreshSeconds)
+    {
+        return;
+    }
+    m_profileRefreshSeconds = timer.GetTotalSeconds() + 1.0;
+
+    length = 0;
+    AppendFormat(
+        m_textProfile,
+        DEBUG_TEXT_PROFILE_CHARS,
+        &length,
+        L"Input ms (mean / max): event->sim %.2f / %.2f, sim->submit %.2f / %.2f\n",
+        m_eventToSimulation.MeanMilliseconds,
+        m_eventToSimulation.MaxMilliseconds,
+        m_simulationToSubmit.MeanMilliseconds,
+        m_simulationToSubmit.MaxMilliseconds
+        );
+
+    AppendFormat(
+        m_textProfile,
+        DEBUG_TEXT_PROFILE_CHARS,
+        &length,
+        L"Sound cache: %.0f%% hits, %.1f / %.1f MB, %u sounds\n",
+        m_soundCache.HitRate * 100.0f,
+        m_soundCache.BytesResident / (1024.0 * 1024.0),
+        m_soundCache.Budget / (1024.0 * 1024.0),
+        m_soundCache.AssetsResident
+        );
+
+    AppendFormat(
+        m_textProfile,
+        DEBUG_TEXT_PROFILE_CHARS,
+        &length,
+        L"Music: %.0f ms to first audio, %.0f KB buffered, %u underruns, %u loops\n",
+        m_music.FirstAudioMilliseconds,
+        m_music.BufferBytes / 1024.0,
+        m_music.Underruns,
+        m_music.Loops
+        );
+
+    AppendFormat(m_textProfile, DEBUG_TEXT_PROFILE_CHARS, &length, L"Gamepad: %u polls/s (target %u)\n", m_gamepadPollRate, GAMEPAD_POLLER_DEFAULT_RATE);
+
+#if PROFILER_ENABLED
+    // Summarizing allocates scratch for the events it walks; that happens once
+    // a second, not every frame.
+    FrameProfiler::GetSummary(&m_profileSummary);
+
+    AppendFormat(m_textProfile, DEBUG_TEXT_PROFILE_CHARS, &length, L"CPU ms (mean / p99 / max), scope cost %.0f ns\n", m_profilerOverheadNs);
+
+    const unsigned int maxLines = 8;
+    for (unsigned int i = 0; i < m_profileSummary.size() && i < maxLines; i++)
+    {
+        AppendFormat(
+            m_textProfile,
+            DEBUG_TEXT_PROFILE_CHARS,
+            &length,
+            L"%-22S %6.2f %6.2f %6.2f\n",
+            m_profileSummary[i].Name,
+            m_profileSummary[i].MeanMilliseconds,
+            m_profileSummary[i].P99Milliseconds,
+            m_profileSummary[i].MaxMilliseconds
+            );
+    }
+#endif
 
     DX::ThrowIfFailed(
         m_deviceResources->GetDWriteFactory()->CreateTextLayout(
-        m_textFPS.c_str(),
-        (uint32) m_textFPS.length(),
-        m_textFormat.Get(),
-        240.0f, // Max width of the FPS text.
-        50.0f, // Max height of the FPS text.
-        &m_textLayoutFPS
+        m_textProfile,
+        (uint32) length,
+        m_profileTextFormat.Get(),
+        DEBUG_INPUT_TEXT_MAX_WIDTH,
+        DEBUG_INPUT_TEXT_MAX_HEIGHT,
+        &m_textLayoutProfile
         )
         );
+}
 
-    DX::ThrowIfFailed(
-        m_textLayoutFPS->GetMetrics(&m_textMetricsFPS)
-        );
+// Stores the input latency statistics shown on the next refresh.
+void SampleDebugTextRenderer::SetInputLatency(const InputLatencyStats& eventToSimulation, const InputLatencyStats& simulationToSubmit)
+{
+    m_eventToSimulation = eventToSimulation;
+    m_simulationToSubmit = simulationToSubmit;
+}
+
+void SampleDebugTextRenderer::SetSoundCacheStats(const SoundCacheStats& soundCache)
+{
+    m_soundCache = soundCache;
+}
+
+void SampleDebugTextRenderer::SetMusicStats(const MusicStreamStats& music)
+{
+    m_music = music;
+}
+
+void SampleDebugTextRenderer::SetGamepadPollRate(unsigned int pollsPerSecond)
+{
+    m_gamepadPollRate = pollsPerSecond;
 }
 
 // Updates the text to be displayed.
-void SampleDebugTextRenderer::Update(std::vector<PlayerInputData>* playerInputs, unsigned int playersAttached)
+void SampleDebugTextRenderer::Update(const PlayerInputData* playerInputs, unsigned int playerInputCount, unsigned int playersAttached)
 {
     m_playersAttached = playersAttached;
 
     for (unsigned int i = 0; i < XINPUT_MAX_CONTROLLERS; i++)
     {
-        std::wstring inputText = L"";
-
         unsigned int playerAttached = (playersAttached & (1 << i));
 
         if (!playerAttached)
             continue;
 
-        for (unsigned int j = 0; j < playerInputs->size(); j++)
+        wchar_t inputText[DEBUG_TEXT_INPUT_CHARS];
+        size_t length = 0;
+        inputText[0] = L'\0';
+
+        AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"Input Player%u: ", i + 1);
+
+        for (unsigned int j = 0; j < playerInputCount; j++)
         {
-            PlayerInputData playerAction = (*playerInputs)[j];
+            const PlayerInputData& playerAction = playerInputs[j];
 
             if (playerAction.ID != i) continue;
 
             switch (playerAction.PlayerAction)
             {
             case PLAYER_ACTION_TYPES::INPUT_FIRE_PRESSED:
-                inputText += L"\n FirePressed(" + std::to_wstring(playerAction.NormalizedInputValue) + L") ";
+                AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"\n FirePressed(%f) ", playerAction.NormalizedInputValue);
                 break;
             case PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN:
-                inputText += L"\n FireDown(" + std::to_wstring(playerAction.NormalizedInputValue) + L") ";
+                AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"\n FireDown(%f) ", playerAction.NormalizedInputValue);
                 break;
 			case PLAYER_ACTION_TYPES::INPUT_FIRE_RELEASED:
-				inputText += L"\n FireReleased(" + std::to_wstring(playerAction.NormalizedInputValue) + L") ";
+				AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"\n FireReleased(%f) ", playerAction.NormalizedInputValue);
 				break;
 
             case PLAYER_ACTION_TYPES::INPUT_JUMP_PRESSED:
-                inputText += L"\n JumpPressed(" + std::to_wstring(playerAction.NormalizedInputValue) + L") ";
+                AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"\n JumpPressed(%f) ", playerAction.NormalizedInputValue);
                 break;
             case PLAYER_ACTION_TYPES::INPUT_JUMP_DOWN:
-                inputText += L"\n JumpDown(" + std::to_wstring(playerAction.NormalizedInputValue) + L") ";
+                AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"\n JumpDown(%f) ", playerAction.NormalizedInputValue);
                 break;
             case PLAYER_ACTION_TYPES::INPUT_JUMP_RELEASED:
-                inputText += L"\n JumpReleased(" + std::to_wstring(playerAction.NormalizedInputValue) + L") ";
+                AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"\n JumpReleased(%f) ", playerAction.NormalizedInputValue);
                 break;
 
             case PLAYER_ACTION_TYPES::INPUT_MOVE:
-				inputText += L"\n MoveX(" + std::to_wstring(playerAction.X) + L") ";
-				inputText += L"\n MoveY(" + std::to_wstring(playerAction.Y) + L") ";
+				AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"\n MoveX(%f) \n MoveY(%f) ", playerAction.X, playerAction.Y);
                 break;
             case PLAYER_ACTION_TYPES::INPUT_AIM:
-				inputText += L"\n AimX(" + std::to_wstring(playerAction.X) + L") ";
-				inputText += L"\n AimY(" + std::to_wstring(playerAction.Y) + L") ";
+				AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"\n AimX(%f) \n AimY(%f) ", playerAction.X, playerAction.Y);
                 break;
             case PLAYER_ACTION_TYPES::INPUT_BRAKE:
-                inputText += L"\n Brake(" + std::to_wstring(playerAction.NormalizedInputValue) + L") ";
+                AppendFormat(inputText, DEBUG_TEXT_INPUT_CHARS, &length, L"\n Brake(%f) ", playerAction.NormalizedInputValue);
                 break;
 
             default:
@@ -152,17 +323,16 @@ void SampleDebugTextRenderer::Update(std::vector<PlayerInputData>* playerInputs,
             }
         }
 
-        wchar_t intStringBuffer[8];
-        size_t sizeInWords = sizeof(intStringBuffer) / 2;
-        _itow_s(i + 1, intStringBuffer, sizeInWords, 10);
-        std::wstring playerIdString(intStringBuffer);
+        // Held input repeats the same text tick after tick; only lay it out again when it changes.
+        if ((m_textLayout[i] != nullptr) && (wcscmp(inputText, m_text[i]) == 0))
+            continue;
 
-        m_text[i] = L"Input Player" + playerIdString += L": " + inputText;
+        wcscpy_s(m_text[i], inputText);
 
         DX::ThrowIfFailed(
             m_deviceResources->GetDWriteFactory()->CreateTextLayout(
-            m_text[i].c_str(),
-            (uint32) m_text[i].length(),
+            m_text[i],
+            (uint32) length,
             m_textFormat.Get(),
             DEBUG_INPUT_TEXT_MAX_WIDTH,
             DEBUG_INPUT_TEXT_MAX_HEIGHT,
@@ -234,6 +404,18 @@ void SampleDebugTextRenderer::Render()
         m_whiteBrush.Get()
         );
 
+    // Position the CPU profile summary on the top left corner.
+    if (m_textLayoutProfile != nullptr)
+    {
+        context->SetTransform(m_deviceResources->GetOrientationTransform2D());
+
+        context->DrawTextLayout(
+            D2D1::Point2F(8.f, 8.f),
+            m_textLayoutProfile.Get(),
+            m_whiteBrush.Get()
+            );
+    }
+
     // Ignore D2DERR_RECREATE_TARGET here. This error indicates that the device
     // is lost. It will be handled during the next call to Present.
     HRESULT hr = context->EndDraw();
@@ -12,9 +12,20 @@
 #include "../Helpers/StepTimer.h"
 #include "../Helpers/InputManager.h"
 #include "../Helpers/OverlayManager.h"
+#include "../Helpers/MemoryArena.h"
+#include "../Helpers/FrameProfiler.h"
+#include "../Helpers/InputLatencyTracker.h"
+#include "../Helpers/SoundCache.h"
+#include "../Helpers/MusicStream.h"
 
 namespace DirectXGame2
 {
+    // Text buffer sizes. Overlay text is formatted in place into these, so
+    // refreshing it doesn't touch the heap; anything longer is truncated.
+#define DEBUG_TEXT_INPUT_CHARS          512
+#define DEBUG_TEXT_FPS_CHARS            64
+#define DEBUG_TEXT_PROFILE_CHARS        2048
+
     // Renders the current  value in the bottom right corner of the screen using Direct2D and DirectWrite.
     class SampleDebugTextRenderer : public Overlay
     {
@@ -23,20 +34,44 @@ namespace DirectXGame2
         void CreateDeviceDependentResources();
         void ReleaseDeviceDependentResources();
         void Update(DX::StepTimer const& timer);
-        void Update(std::vector<PlayerInputData>* playerInput, unsigned int playersAttached);
+        void Update(const PlayerInputData* playerInput, unsigned int playerInputCount, unsigned int playersAttached);
+        void SetInputLatency(const InputLatencyStats& eventToSimulation, const InputLatencyStats& simulationToSubmit);
+        void SetSoundCacheStats(const SoundCacheStats& soundCache);
+        void SetMusicStats(const MusicStreamStats& music);
+        void SetGamepadPollRate(unsigned int pollsPerSecond);
         void Render();
 
     private:
         // Resources related to text rendering for player input data.
-        std::wstring                                    m_text[XINPUT_MAX_CONTROLLERS];
+        wchar_t                                         m_text[XINPUT_MAX_CONTROLLERS][DEBUG_TEXT_INPUT_CHARS];
         Microsoft::WRL::ComPtr<IDWriteTextLayout>       m_textLayout[XINPUT_MAX_CONTROLLERS];
         DWRITE_TEXT_METRICS                             m_textMetrics[XINPUT_MAX_CONTROLLERS];
 
         // Resources related to rendering the FPS text.
-        std::wstring                                    m_textFPS;
+        wchar_t                                         m_textFPS[DEBUG_TEXT_FPS_CHARS];
         Microsoft::WRL::ComPtr<IDWriteTextLayout>       m_textLayoutFPS;
         DWRITE_TEXT_METRICS                             m_textMetricsFPS;
 
+        // Latest input latency statistics, shown with the CPU profile summary.
+        InputLatencyStats                               m_eventToSimulation;
+        InputLatencyStats                               m_simulationToSubmit;
+
+        // Latest sound cache statistics, shown with the CPU profile summary.
+        SoundCacheStats                                 m_soundCache;
+
+        // Latest music stream statistics, shown with the CPU profile summary.
+        MusicStreamStats                                m_music;
+
+        // Achieved gamepad polling rate, shown with the CPU profile summary.
+        unsigned int                                    m_gamepadPollRate;
+
+        // Resources related to rendering the CPU profile summary.
+        wchar_t                                         m_textProfile[DEBUG_TEXT_PROFILE_CHARS];
+        Microsoft::WRL::ComPtr<IDWriteTextLayout>       m_textLayoutProfile;
+        std::vector<ProfileScopeSummary>                m_profileSummary;
+        double                                          m_profileRefreshSeconds;
+        double                                          m_profilerOverheadNs;
+
         // Cached height of one input text block.
         float m_inputTextHeight;
 
@@ -52,5 +87,6 @@ namespace DirectXGame2
         Microsoft::WRL::ComPtr<ID2D1SolidColorBrush>    m_whiteBrush;
         Microsoft::WRL::ComPtr<ID2D1DrawingStateBlock>  m_stateBlock;
         Microsoft::WRL::ComPtr<IDWriteTextFormat>       m_textFormat;
+        Microsoft::WRL::ComPtr<IDWriteTextFormat>       m_profileTextFormat;
     };
 }
\ No newline at end of file
@@ -28,10 +28,20 @@ HRESULT SampleVirtualControllerRenderer::AddTouchControlRegion(TouchControlRegio
 {
     Windows::Foundation::Size logicalSize = m_deviceResources->GetLogicalSize();
 
-    TouchControl touchControl(touchControlRegion, false, -1.f, 270.f, -1.f, logicalSize.Height - 270.f);
+    if (touchControlRegion.DefinedAction >= PLAYER_ACTION_TYPES::INPUT_MAX)
+    {
+        return E_INVALIDARG;
+    }
 
-    m_touchControls.erase(touchControlRegion.DefinedAction);
-    m_touchControls.emplace(touchControlRegion.DefinedAction, touchControl);
+    TouchControl& touchControl = m_touchControls[touchControlRegion.DefinedAction];
+    touchControl.UpperLeftCoords = touchControlRegion.UpperLeftCoords;
+    touchControl.LowerRightCoords = touchControlRegion.LowerRightCoords;
+    touchControl.RegionType = touchControlRegion.RegionType;
+    touchControl.ButtonPressed = false;
+    touchControl.PointerRawX = -1.f;
+    touchControl.PointerThrowX = 270.f;
+    touchControl.PointerRawY = -1.f;
+    touchControl.PointerThrowY = logicalSize.Height - 270.f;
     
     return S_OK;
 }
@@ -39,7 +49,10 @@ HRESULT SampleVirtualControllerRenderer::AddTouchControlRegion(TouchControlRegio
 // Clears touch control regions.
 void SampleVirtualControllerRenderer::ClearTouchControlRegions()
 {
-    m_touchControls.clear();
+    for (unsigned int i = 0; i < PLAYER_ACTION_TYPES::INPUT_MAX; i++)
+    {
+        m_touchControls[i] = TouchControl();
+    }
 }
 
 // Updates any time-based rendering resources (currently none).
@@ -54,15 +67,15 @@ void SampleVirtualControllerRenderer::Update(DX::StepTimer const& timer)
 
 // Updates the display based on this frame's input.
 // This method is not called by the OverlayManager class.
-void SampleVirtualControllerRenderer::Update(std::vector<PlayerInputData>* playerInput)
+void SampleVirtualControllerRenderer::Update(const PlayerInputData* playerInput, unsigned int playerInputCount)
 {
     m_touchControls[PLAYER_ACTION_TYPES::INPUT_MOVE].PointerRawX = -1;
     m_touchControls[PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN].ButtonPressed = false;
     m_touchControls[PLAYER_ACTION_TYPES::INPUT_JUMP_DOWN].ButtonPressed = false;
 
-    for (unsigned int i = 0; i < playerInput->size(); i++)
+    for (unsigned int i = 0; i < playerInputCount; i++)
     {
-        PlayerInputData playerAction = (*playerInput)[i];
+        const PlayerInputData& playerAction = playerInput[i];
 
         if (!playerAction.IsTouchAction)
             continue;
@@ -70,22 +83,24 @@ void SampleVirtualControllerRenderer::Update(std::vector<PlayerInputData>* playe
         // Any valid touch on the screen should display the virtual controller.
         m_buttonFadeTimer = 6.f;
 
-        if (m_touchControls.count(playerAction.PlayerAction))
+        if (playerAction.PlayerAction < PLAYER_ACTION_TYPES::INPUT_MAX)
         {
-            switch (m_touchControls[playerAction.PlayerAction].Region.RegionType)
+            TouchControl& touchControl = m_touchControls[playerAction.PlayerAction];
+
+            switch (touchControl.RegionType)
             {
             case TOUCH_CONTROL_REGION_TYPES::TOUCH_CONTROL_REGION_ANALOG_STICK:
-                m_touchControls[playerAction.PlayerAction].PointerThrowX = playerAction.PointerThrowX;
-                m_touchControls[playerAction.PlayerAction].PointerThrowY = playerAction.PointerThrowY;
-                m_touchControls[playerAction.PlayerAction].PointerRawX = playerAction.PointerRawX;
-                m_touchControls[playerAction.PlayerAction].PointerRawY = playerAction.PointerRawY;
+                touchControl.PointerThrowX = playerAction.PointerThrowX;
+                touchControl.PointerThrowY = playerAction.PointerThrowY;
+                touchControl.PointerRawX = playerAction.PointerRawX;
+                touchControl.PointerRawY = playerAction.PointerRawY;
 
                 // The stick location is dynamic; a quick fade helps the transition.
                 m_stickFadeTimer = 0.25f;
                 break;
 
             case TOUCH_CONTROL_REGION_TYPES::TOUCH_CONTROL_REGION_BUTTON:
-                m_touchControls[playerAction.PlayerAction].ButtonPressed = true;
+                touchControl.ButtonPressed = true;
 
             default:
                 break;
@@ -102,14 +117,11 @@ void SampleVirtualControllerRenderer::Render()
     context->SaveDrawingState(m_stateBlock.Get());
     context->BeginDraw();
 
-    std::unordered_map<PLAYER_ACTION_TYPES, TouchControl>::iterator iter;
-    for (iter = m_touchControls.begin(); iter != m_touchControls.end(); ++iter)
+    for (unsigned int i = 0; i < PLAYER_ACTION_TYPES::INPUT_MAX; i++)
     {
-        PLAYER_ACTION_TYPES player_action = iter->first;
-        TouchControl touchControl = iter->second;
-        TouchControlRegion touchControlRegion = touchControl.Region;
+        const TouchControl& touchControl = m_touchControls[i];
 
-        switch (touchControlRegion.RegionType)
+        switch (touchControl.RegionType)
         {
         case TOUCH_CONTROL_REGION_TYPES::TOUCH_CONTROL_REGION_ANALOG_STICK:
             {
@@ -146,12 +158,12 @@ void SampleVirtualControllerRenderer::Render()
         case TOUCH_CONTROL_REGION_TYPES::TOUCH_CONTROL_REGION_BUTTON:
             {
                 // Draw a button.
-                float radiusx = (touchControlRegion.LowerRightCoords.x - touchControlRegion.UpperLeftCoords.x) * 0.5f;
-                float radiusy = (touchControlRegion.LowerRightCoords.y - touchControlRegion.UpperLeftCoords.y) * 0.5f;
+                float radiusx = (touchControl.LowerRightCoords.x - touchControl.UpperLeftCoords.x) * 0.5f;
+                float radiusy = (touchControl.LowerRightCoords.y - touchControl.UpperLeftCoords.y) * 0.5f;
 
                 D2D1_POINT_2F buttonLoc = D2D1::Point2F(
-                    touchControlRegion.UpperLeftCoords.x + radiusx,
-                    touchControlRegion.UpperLeftCoords.y + radiusy
+                    touchControl.UpperLeftCoords.x + radiusx,
+                    touchControl.UpperLeftCoords.y + radiusy
                     );
 
                 D2D1_ELLIPSE buttonEllipse = D2D1::Ellipse(buttonLoc, radiusx, radiusy);
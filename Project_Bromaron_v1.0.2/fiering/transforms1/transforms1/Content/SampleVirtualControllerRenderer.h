@@ -24,7 +24,7 @@ namespace DirectXGame2
         void CreateDeviceDependentResources();
         void ReleaseDeviceDependentResources();
         void Update(DX::StepTimer const& timer);
-        void Update(std::vector<PlayerInputData>* playerInput);
+        void Update(const PlayerInputData* playerInput, unsigned int playerInputCount);
         void Render();
 
         HRESULT AddTouchControlRegion(TouchControlRegion& touchControlRegion);
@@ -32,36 +32,23 @@ namespace DirectXGame2
 
     private:
         // Holds the Touch Control region and the controller state.
+        // A control whose RegionType is TOUCH_CONTROL_REGION_REPORT_COORDS_ONLY isn't drawn.
         typedef struct _touchControl
         {
-            TouchControlRegion Region;
+            XMFLOAT2                    UpperLeftCoords;
+            XMFLOAT2                    LowerRightCoords;
+            TOUCH_CONTROL_REGION_TYPES  RegionType;
             bool        ButtonPressed;
             float       PointerRawX;
             float       PointerThrowX;
             float       PointerRawY;
             float       PointerThrowY;
 
-            // Constructor
-            _touchControl(
-                TouchControlRegion region,
-                bool buttonPressed,
-                float pointerRawX,
-                float pointerThrowX,
-                float pointerRawY,
-                float pointerThrowY
-                ) :
-                Region(region),
-                ButtonPressed(buttonPressed),
-                PointerRawX(pointerRawX),
-                PointerThrowX(pointerThrowX),
-                PointerRawY(pointerRawY),
-                PointerThrowY(pointerThrowY)
-            {
-            }
-
             // Constructor
             _touchControl() :
-                Region(TouchControlRegion()),
+                UpperLeftCoords(0, 0),
+                LowerRightCoords(0, 0),
+                RegionType(TOUCH_CONTROL_REGION_REPORT_COORDS_ONLY),
                 ButtonPressed(false),
                 PointerRawX(0),
                 PointerThrowX(0),
@@ -71,7 +58,8 @@ namespace DirectXGame2
             }
         } TouchControl;
 
-        std::unordered_map<PLAYER_ACTION_TYPES, TouchControl>     m_touchControls;
+        // One control per action, indexed directly by the action a touch reports.
+        TouchControl                                    m_touchControls[PLAYER_ACTION_TYPES::INPUT_MAX];
         Microsoft::WRL::ComPtr<ID2D1SolidColorBrush>    m_whiteBrush;
         Microsoft::WRL::ComPtr<ID2D1DrawingStateBlock>  m_stateBlock;
 
@@ -0,0 +1,56 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <DirectXMath.h>
+
+namespace DirectXGame2
+{
+    // Components stored in the scene's EntityWorld. They are plain data and
+    // are copied with memcpy, so they must not own resources.
+
+    // Position and orientation. Used by the player and by every asteroid.
+    struct Pose
+    {
+        DirectX::XMVECTOR pos;
+        DirectX::XMVECTOR ori;
+    };
+
+    // Per-frame motion of an asteroid.
+    struct Spin
+    {
+        DirectX::XMVECTOR L;    // angular momentum (use as velocity)
+        DirectX::XMVECTOR vel;  // linear velocity
+    };
+
+    // Hit state of anything the player can shoot or ram.
+    struct Destructible
+    {
+        bool boolDraw;
+        int hitCounter;
+    };
+
+    // Player coordinate frame, rebuilt from the player's Pose every frame.
+    struct Camera
+    {
+        DirectX::XMVECTOR forward;
+        DirectX::XMVECTOR up;
+        DirectX::XMVECTOR left;
+    };
+
+    // Player weapon state.
+    struct Laser
+    {
+        DirectX::XMVECTOR ori;
+        bool isFiring;
+        int type;
+        int draw;
+        int count;
+        int power;
+    };
+}
@@ -14,15 +14,78 @@ using namespace Windows::Foundation;
 using namespace Windows::System::Threading;
 using namespace Concurrency;
 
+namespace
+{
+    // Clock for the input latency tracker; the same time base InputManager stamps events with.
+    long long ReadPerformanceCounter()
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    long long ReadPerformanceFrequency()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        return frequency.QuadPart;
+    }
+
+    bool FileExists(const std::wstring& path)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        return GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data) != 0;
+    }
+}
+
 // Loads and initializes application assets when the application is loaded.
 DirectXGame2Main::DirectXGame2Main(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
-    m_deviceResources(deviceResources)
+    m_deviceResources(deviceResources),
+    m_laserSound(INVALID_SOUND_ASSET_ID),
+    m_frameArena(FRAME_ARENA_BYTES),
+    m_playerActionCount(0),
+    m_inputLatency(&ReadPerformanceCounter, ReadPerformanceFrequency()),
+    m_localFolder(Windows::Storage::ApplicationData::Current->LocalFolder->Path->Data()),
+    m_replayMode(REPLAY_MODE_NONE)
 {
     // Register to be notified if the Device is lost or recreated.
     m_deviceResources->RegisterDeviceNotify(this);
 
+    // A log dropped into the local folder replaces live input for benchmark runs,
+    // and an empty record.txt there records live play so it can be replayed later.
+    if (m_inputReplay.Load(m_localFolder + L"\\replay_headless.bin"))
+    {
+        m_replayMode = REPLAY_MODE_HEADLESS;
+    }
+    else if (m_inputReplay.Load(m_localFolder + L"\\replay.bin"))
+    {
+        m_replayMode = REPLAY_MODE_REALTIME;
+    }
+
+    // Recording and replay step the simulation at a fixed 60 Hz (or the replay's
+    // recorded rate) so that the same input and seed always produce the same
+    // session. Normal play keeps the timer's variable step.
+    unsigned int seed;
+    if (m_replayMode != REPLAY_MODE_NONE)
+    {
+        seed = m_inputReplay.GetSeed();
+        m_timer.SetFixedTimeStep(true);
+        m_timer.SetTargetElapsedTicks(m_inputReplay.GetTargetElapsedTicks());
+        m_replayTimings.reserve(m_inputReplay.GetTickCount());
+    }
+    else
+    {
+        seed = std::random_device()();
+        if (FileExists(m_localFolder + L"\\record.txt"))
+        {
+            m_timer.SetFixedTimeStep(true);
+            m_timer.SetTargetElapsedSeconds(1.0 / 60);
+            m_inputRecorder.Begin(seed, DX::StepTimer::SecondsToTicks(1.0 / 60));
+        }
+    }
+
     // Note to developer: Replace this with your app's content initialization.
-    m_sceneRenderer     = std::unique_ptr<Sample3DSceneRenderer>(new Sample3DSceneRenderer(m_deviceResources));
+    m_sceneRenderer     = std::unique_ptr<Sample3DSceneRenderer>(new Sample3DSceneRenderer(m_deviceResources, m_frameArena, seed));
     m_debugTextRenderer = std::shared_ptr<SampleDebugTextRenderer>(new SampleDebugTextRenderer(m_deviceResources));
 
     // Note to developer: Use these to get input data, play audio, and draw HUDs and menus.
@@ -30,6 +93,9 @@ DirectXGame2Main::DirectXGame2Main(const std::shared_ptr<DX::DeviceResources>& d
     m_soundPlayer    = std::unique_ptr<SoundPlayer>(new SoundPlayer());
     m_overlayManager = std::unique_ptr<OverlayManager>(new OverlayManager(m_deviceResources));
 
+    m_laserSound = m_soundPlayer->InternSound(std::wstring(L"assets/chord.wav"));
+    m_soundPlayer->PreloadSound(m_laserSound);
+
     // This vector will be sent to the overlay manager.
     std::vector<std::shared_ptr<Overlay>> overlays;
     overlays.push_back(m_debugTextRenderer);
@@ -53,13 +119,6 @@ DirectXGame2Main::DirectXGame2Main(const std::shared_ptr<DX::DeviceResources>& d
     // This template supports all control types by default.
     m_inputManager->SetFilter(INPUT_DEVICE_ALL);
     m_inputManager->Initialize(CoreWindow::GetForCurrentThread());
-
-    // Note to developer: Change the timer settings if you want something other than the default variable timestep mode.
-    // e.g. for 60 FPS fixed timestep update logic, call:
-    /*
-    m_timer.SetFixedTimeStep(true);
-    m_timer.SetTargetElapsedSeconds(1.0 / 60);
-    */
 }
 
 void DirectXGame2Main::InitializeTouchRegions()
@@ -170,49 +229,139 @@ void DirectXGame2Main::CreateWindowSizeDependentResources()
 // Updates the application state once per frame.
 void DirectXGame2Main::Update()
 {
+    PROFILE_SCOPE("Update");
+
+    // Start a new frame: roll the allocation counters over and release the
+    // previous frame's temporaries.
+    AllocationTracker::BeginFrame();
+    m_frameArena.Reset();
+
+    long long updateStart = ReadPerformanceCounter();
+    m_replayFrame.Desyncs = 0;
+    m_replayFrame.Allocations = AllocationTracker::GetLastFrameAllocationCount();
+
     // Update scene objects.
-    m_timer.Tick([&]()
+    auto update = [&]()
     {
         // Note to developer: Replace these with your app's content update functions.
-        m_sceneRenderer->Update(m_timer);
-        m_overlayManager->Update(m_timer);
-        m_inputManager->Update(m_timer);
+        {
+            PROFILE_SCOPE("Scene.Update");
+            m_sceneRenderer->Update(m_timer);
+        }
+        {
+            PROFILE_SCOPE("Overlay.Update");
+            m_overlayManager->Update(m_timer);
+        }
+        {
+            PROFILE_SCOPE("Input.Update");
+            m_inputManager->Update(m_timer);
+        }
 
-        std::vector<PlayerInputData> playerActions;
-        ProcessInput(&playerActions);
+        {
+            PROFILE_SCOPE("Input.Process");
+            ProcessInput();
+        }
+
+        PROFILE_SCOPE("Overlay.Input");
+        m_debugTextRenderer->Update(m_playerActions, m_playerActionCount, m_playersConnected);
+
+        InputLatencyStats eventToSimulation, simulationToSubmit;
+        m_inputLatency.GetEventToSimulation(&eventToSimulation);
+        m_inputLatency.GetSimulationToSubmit(&simulationToSubmit);
+        m_debugTextRenderer->SetInputLatency(eventToSimulation, simulationToSubmit);
+
+        SoundCacheStats soundCache;
+        m_soundPlayer->GetSoundCacheStats(&soundCache);
+        m_debugTextRenderer->SetSoundCacheStats(soundCache);
+
+        MusicStreamStats music;
+        m_soundPlayer->GetMusicStats(&music);
+        m_debugTextRenderer->SetMusicStats(music);
 
-        m_debugTextRenderer->Update(&playerActions, m_playersConnected);
+        m_debugTextRenderer->SetGamepadPollRate(m_inputManager->GetGamepadPollRate());
 
         // Only update the virtual controller if it's present.
         if (m_virtualControllerRenderer != nullptr)
         {
-            m_virtualControllerRenderer->Update(&playerActions);
+            m_virtualControllerRenderer->Update(m_playerActions, m_playerActionCount);
+        }
+    };
+
+    // A headless replay advances one tick per frame regardless of the clock.
+    if (m_replayMode == REPLAY_MODE_HEADLESS)
+    {
+        m_timer.Step(update);
+    }
+    else
+    {
+        m_timer.Tick(update);
+    }
+
+    if (m_replayMode != REPLAY_MODE_NONE)
+    {
+        m_replayFrame.UpdateMilliseconds = static_cast<float>((ReadPerformanceCounter() - updateStart) * 1000.0 / ReadPerformanceFrequency());
+        m_replayFrame.RenderMilliseconds = 0.f;
+    }
+
+    // Headless frames are never rendered, so they're complete now.
+    if (m_replayMode == REPLAY_MODE_HEADLESS)
+    {
+        m_replayTimings.push_back(m_replayFrame);
+
+        if (m_inputReplay.IsFinished())
+        {
+            FinishReplay();
         }
-    });
+    }
 }
 
 // Process all input from the user before updating game state
-void DirectXGame2Main::ProcessInput(std::vector<PlayerInputData>* playerActions)
+void DirectXGame2Main::ProcessInput()
 {
     m_playersConnected = m_inputManager->GetPlayersConnected();
 
-    *playerActions = m_inputManager->GetPlayersActions();
+    // Live input is always drained, even when a replay overrides it, so
+    // events don't pile up in the input manager.
+    m_playerActionCount = m_inputManager->GetPlayersActions(m_playerActions, INPUT_MAX_PLAYER_ACTIONS);
 
-    for (unsigned int j = 0; j < playerActions->size(); j++)
+    // The scene has already stepped this tick, so its state must match what the
+    // recording saw at the same point.
+    if (m_replayMode != REPLAY_MODE_NONE)
     {
-        PlayerInputData playerAction = (*playerActions)[j];
+        unsigned int recordedChecksum;
+        if (m_inputReplay.NextTick(m_playerActions, INPUT_MAX_PLAYER_ACTIONS, &m_playerActionCount, &recordedChecksum) &&
+            (m_sceneRenderer->GetStateChecksum() != recordedChecksum))
+        {
+            m_replayFrame.Desyncs++;
+        }
+    }
+    else if (m_inputRecorder.IsRecording())
+    {
+        m_inputRecorder.RecordTick(m_sceneRenderer->GetStateChecksum(), m_playerActions, m_playerActionCount);
+    }
+
+    for (unsigned int j = 0; j < m_playerActionCount; j++)
+    {
+        const PlayerInputData& playerAction = m_playerActions[j];
+
+        // The scene applies this action during this tick.
+        m_inputLatency.RecordSimulation(playerAction.Timestamp);
 
         if (playerAction.ID == 0)
 
         switch (playerAction.PlayerAction)
         {
         case PLAYER_ACTION_TYPES::INPUT_FIRE_PRESSED:
-           // m_soundPlayer->PlaySound(std::wstring(L"assets/chord.wav"));
+            // One shot sound per press. Rapid presses overlap on the effect
+            // voices, and a headless replay stays silent.
+            if (m_replayMode != REPLAY_MODE_HEADLESS)
+            {
+                m_soundPlayer->PlaySound(m_laserSound, EFFECT_PRIORITY_HIGH);
+            }
 			m_sceneRenderer->LaserFire(playerAction.isFiring);
             break;
 
 		case PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN:
-			//m_soundPlayer->PlaySound(std::wstring(L"assets/chord.wav"));
 			m_sceneRenderer->LaserFire(playerAction.isFiring);
 			break;
 
@@ -246,12 +395,16 @@ void DirectXGame2Main::ProcessInput(std::vector<PlayerInputData>* playerActions)
 // Returns true if the frame was rendered and is ready to be displayed.
 bool DirectXGame2Main::Render() 
 {
-    // Don't try to render anything before the first Update.
-    if (m_timer.GetFrameCount() == 0)
+    PROFILE_SCOPE("Render");
+
+    // Don't try to render anything before the first Update, or during a headless replay.
+    if ((m_timer.GetFrameCount() == 0) || (m_replayMode == REPLAY_MODE_HEADLESS))
     {
         return false;
     }
 
+    long long renderStart = ReadPerformanceCounter();
+
     auto context = m_deviceResources->GetD3DDeviceContext();
 
     // Reset the viewport to target the whole screen.
@@ -268,13 +421,64 @@ bool DirectXGame2Main::Render()
 
     // Render the scene objects.
     // Note to developer: Replace this with your app's content rendering functions.
-	m_sceneRenderer->Render();
+    {
+        PROFILE_SCOPE("Scene.Render");
+        m_sceneRenderer->Render();
+    }
     //m_sceneRenderer->RenderAnimate();
-    m_overlayManager->Render();
+    {
+        PROFILE_SCOPE("Overlay.Render");
+        m_overlayManager->Render();
+    }
+
+    // Everything simulated since the last frame has now been submitted.
+    m_inputLatency.RecordSubmit();
+
+    if (m_replayMode == REPLAY_MODE_REALTIME)
+    {
+        m_replayFrame.RenderMilliseconds = static_cast<float>((ReadPerformanceCounter() - renderStart) * 1000.0 / ReadPerformanceFrequency());
+        m_replayTimings.push_back(m_replayFrame);
+
+        if (m_inputReplay.IsFinished())
+        {
+            FinishReplay();
+        }
+    }
 
     return true;
 }
 
+void DirectXGame2Main::SaveInputRecording()
+{
+    if (m_inputRecorder.GetTickCount() > 0)
+    {
+        m_inputRecorder.Save(m_localFolder + L"\\last_session.bin");
+    }
+}
+
+// Writes the replay's frame timings (and, when allocations are tracked, a
+// memory snapshot) and hands control back to live input. A headless run has
+// nothing left to show, so it closes the app.
+void DirectXGame2Main::FinishReplay()
+{
+    InputReplay::WriteTimingCsv(m_localFolder + L"\\replay_timing.csv", m_replayTimings);
+
+    if (AllocationTracker::IsEnabled())
+    {
+        AllocationTracker::WriteSnapshot(m_localFolder + L"\\replay_memory.json");
+    }
+
+    REPLAY_MODE finishedMode = m_replayMode;
+    m_replayMode = REPLAY_MODE_NONE;
+    m_replayTimings.clear();
+    m_timer.SetFixedTimeStep(false);
+
+    if (finishedMode == REPLAY_MODE_HEADLESS)
+    {
+        Windows::ApplicationModel::Core::CoreApplication::Exit();
+    }
+}
+
 // Notifies renderers that device resources need to be released.
 void DirectXGame2Main::OnDeviceLost()
 {
@@ -12,6 +12,10 @@
 #include "Helpers\InputManager.h"
 #include "Helpers\SoundPlayer.h"
 #include "Helpers\OverlayManager.h"
+#include "Helpers\MemoryArena.h"
+#include "Helpers\FrameProfiler.h"
+#include "Helpers\InputLatencyTracker.h"
+#include "Helpers\InputReplay.h"
 
 #include "Content\Sample3DSceneRenderer.h"
 #include "Content\SampleDebugTextRenderer.h"
@@ -20,6 +24,14 @@
 // Renders Direct2D and 3D content on the screen.
 namespace DirectXGame2
 {
+    // Where the player actions come from.
+    enum REPLAY_MODE
+    {
+        REPLAY_MODE_NONE,       // Live input, recorded to last_session.bin if record.txt exists.
+        REPLAY_MODE_REALTIME,   // replay.bin, played at the recorded tick rate and rendered.
+        REPLAY_MODE_HEADLESS,   // replay_headless.bin, one tick per frame with rendering skipped.
+    };
+
     class DirectXGame2Main : public DX::IDeviceNotify
     {
     public:
@@ -29,13 +41,17 @@ namespace DirectXGame2
         void Update();
         bool Render();
 
+        // Writes the live input recorded so far to last_session.bin in the local folder.
+        void SaveInputRecording();
+
         // IDeviceNotify
         virtual void OnDeviceLost();
         virtual void OnDeviceRestored();
 
     private:
         void InitializeTouchRegions();
-        void ProcessInput(std::vector<PlayerInputData>* playerActions);
+        void ProcessInput();
+        void FinishReplay();
 
         // Cached pointer to device resources.
         std::shared_ptr<DX::DeviceResources> m_deviceResources;
@@ -50,12 +66,35 @@ namespace DirectXGame2
         std::unique_ptr<SoundPlayer>       m_soundPlayer;
         std::shared_ptr<OverlayManager>    m_overlayManager;
 
+        // Effect played when the laser fires, decoded while the level loads.
+        SoundAssetId m_laserSound;
+
         // Rendering loop timer.
         DX::StepTimer m_timer;
 
+        // Scratch memory for the current frame. Reset at the start of every Update().
+        LinearArena m_frameArena;
+
         // Tracks which players are connected (0...3).
         unsigned int m_playersConnected;
 
+        // This frame's player actions, filled by ProcessInput().
+        PlayerInputData m_playerActions[INPUT_MAX_PLAYER_ACTIONS];
+        unsigned int    m_playerActionCount;
+
+        // Measures how long input takes to reach the simulation and the GPU.
+        InputLatencyTracker m_inputLatency;
+
+        // Deterministic input recording and replay. A replay drives the
+        // simulation from a log in place of live input and records how long
+        // each frame took.
+        std::wstring                    m_localFolder;
+        REPLAY_MODE                     m_replayMode;
+        InputRecorder                   m_inputRecorder;
+        InputReplay                     m_inputReplay;
+        ReplayFrameTiming               m_replayFrame;
+        std::vector<ReplayFrameTiming>  m_replayTimings;
+
         // Tracks the touch region ID, allowing you to enable/disable touch regions.
         // Note to developer: Expand this array if you add more touch regions, e.g. for a menu.
         unsigned int m_touchRegionIDs[3];
@@ -0,0 +1,535 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "ActionBindings.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+using namespace DirectXGame2;
+
+namespace
+{
+    struct InputName
+    {
+        const char*     Name;
+        unsigned int    Code;
+    };
+
+    // Virtual key codes, named as in Windows::System::VirtualKey.
+    const InputName KeyNames[] =
+    {
+        { "Back", 0x08 }, { "Tab", 0x09 }, { "Enter", 0x0D }, { "Shift", 0x10 }, { "Control", 0x11 },
+        { "Menu", 0x12 }, { "Pause", 0x13 }, { "Escape", 0x1B }, { "Space", 0x20 }, { "PageUp", 0x21 },
+        { "PageDown", 0x22 }, { "End", 0x23 }, { "Home", 0x24 }, { "Left", 0x25 }, { "Up", 0x26 },
+        { "Right", 0x27 }, { "Down", 0x28 }, { "Insert", 0x2D }, { "Delete", 0x2E },
+        { "LeftShift", 0xA0 }, { "RightShift", 0xA1 }, { "LeftControl", 0xA2 }, { "RightControl", 0xA3 },
+        { "LeftMenu", 0xA4 }, { "RightMenu", 0xA5 },
+    };
+
+    // XInput wButtons bits.
+    const InputName PadNames[] =
+    {
+        { "DPadUp", 0x0001 }, { "DPadDown", 0x0002 }, { "DPadLeft", 0x0004 }, { "DPadRight", 0x0008 },
+        { "Start", 0x0010 }, { "Back", 0x0020 }, { "LeftThumb", 0x0040 }, { "RightThumb", 0x0080 },
+        { "LeftShoulder", 0x0100 }, { "RightShoulder", 0x0200 },
+        { "A", 0x1000 }, { "B", 0x2000 }, { "X", 0x4000 }, { "Y", 0x8000 },
+        { "LeftTrigger", ACTION_BINDING_PAD_LEFT_TRIGGER }, { "RightTrigger", ACTION_BINDING_PAD_RIGHT_TRIGGER },
+    };
+
+    bool NameEquals(const std::string& a, const char* b)
+    {
+        if (a.size() != strlen(b))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i])))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool ParseUnsigned(const std::string& text, unsigned int* value)
+    {
+        if (text.empty())
+        {
+            return false;
+        }
+
+        char* end = nullptr;
+        unsigned long parsed = strtoul(text.c_str(), &end, 0);
+        if ((*end != '\0') || (parsed > 0xFFFFFFFFul))
+        {
+            return false;
+        }
+
+        *value = static_cast<unsigned int>(parsed);
+        return true;
+    }
+
+    bool ParseKey(const std::string& name, unsigned int* code)
+    {
+        // Single letters and digits are their own virtual key codes.
+        if (name.size() == 1 && isalnum(static_cast<unsigned char>(name[0])))
+        {
+            *code = static_cast<unsigned int>(toupper(static_cast<unsigned char>(name[0])));
+            return true;
+        }
+
+        // Number0..Number9 and F1..F24.
+        if ((name.size() == 7) && NameEquals(name.substr(0, 6), "Number") && isdigit(static_cast<unsigned char>(name[6])))
+        {
+            *code = 0x30 + (name[6] - '0');
+            return true;
+        }
+
+        if ((name.size() >= 2) && (name.size() <= 3) && ((name[0] == 'F') || (name[0] == 'f')))
+        {
+            unsigned int n;
+            if (ParseUnsigned(name.substr(1), &n) && (n >= 1) && (n <= 24))
+            {
+                *code = 0x70 + (n - 1);
+                return true;
+            }
+        }
+
+        for (unsigned int i = 0; i < sizeof(KeyNames) / sizeof(KeyNames[0]); i++)
+        {
+            if (NameEquals(name, KeyNames[i].Name))
+            {
+                *code = KeyNames[i].Code;
+                return true;
+            }
+        }
+
+        return ((name.size() > 2) && (name[0] == '0') && ((name[1] == 'x') || (name[1] == 'X')) &&
+            ParseUnsigned(name, code) && (*code < INPUT_MAX_VIRTUAL_KEYS));
+    }
+
+    bool ParsePadButton(const std::string& name, unsigned int* bit)
+    {
+        for (unsigned int i = 0; i < sizeof(PadNames) / sizeof(PadNames[0]); i++)
+        {
+            if (NameEquals(name, PadNames[i].Name))
+            {
+                *bit = PadNames[i].Code;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool ParseField(const std::string& token, BoundAction* values)
+    {
+        size_t equals = token.find('=');
+        if ((equals == std::string::npos) || (equals == 0) || (equals + 1 == token.size()))
+        {
+            return false;
+        }
+
+        std::string name = token.substr(0, equals);
+        std::string text = token.substr(equals + 1);
+
+        char* end = nullptr;
+        double number = strtod(text.c_str(), &end);
+        if (*end != '\0')
+        {
+            return false;
+        }
+
+        float value = static_cast<float>(number);
+
+        if (NameEquals(name, "value"))              values->Value = value;
+        else if (NameEquals(name, "x"))             values->X = value;
+        else if (NameEquals(name, "y"))             values->Y = value;
+        else if (NameEquals(name, "roll"))          values->Roll = value;
+        else if (NameEquals(name, "pitch"))         values->Pitch = value;
+        else if (NameEquals(name, "yaw"))           values->Yaw = value;
+        else if (NameEquals(name, "laserpitch"))    values->LaserPitch = value;
+        else if (NameEquals(name, "laseryaw"))      values->LaserYaw = value;
+        else if (NameEquals(name, "firing"))        values->IsFiring = (number != 0.0);
+        else if (NameEquals(name, "firetype"))      values->FireType = static_cast<int>(number);
+        else return false;
+
+        return true;
+    }
+
+    float Clamp(float value)
+    {
+        return (value > 1.f) ? 1.f : ((value < -1.f) ? -1.f : value);
+    }
+
+    std::string LineError(unsigned int line, const char* message, const std::string& token)
+    {
+        std::ostringstream error;
+        error << "line " << line << ": " << message << " '" << token << "'";
+        return error.str();
+    }
+}
+
+ActionBindings::ActionBindings()
+{
+    Clear();
+}
+
+void ActionBindings::Clear()
+{
+    m_keyboard.clear();
+    m_gamepad.clear();
+    m_keyboardShadows.clear();
+    m_gamepadShadows.clear();
+
+    for (unsigned int i = 0; i < ACTION_BINDING_MAX_TOUCH_REGIONS; i++)
+    {
+        m_touch[i] = ACTION_BINDING_MAX_ACTIONS;
+    }
+}
+
+bool ActionBindings::Compile(const std::string& text, const ActionName* actionNames, unsigned int actionNameCount, std::string* error)
+{
+    Clear();
+
+    std::string message;
+    std::istringstream lines(text);
+    std::string line;
+    unsigned int lineNumber = 0;
+
+    while (message.empty() && std::getline(lines, line))
+    {
+        lineNumber++;
+
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+
+        std::istringstream tokens(line);
+        std::string device, chord, equals, actionName;
+        if (!(tokens >> device))
+        {
+            continue;   // Blank or comment-only line.
+        }
+
+        if (!(tokens >> chord >> equals >> actionName) || (equals != "="))
+        {
+            message = LineError(lineNumber, "expected '<device> <input> = <action>' at", line);
+            break;
+        }
+
+        Binding binding;
+        memset(&binding, 0, sizeof(binding));
+
+        unsigned int action = ACTION_BINDING_MAX_ACTIONS;
+        for (unsigned int i = 0; i < actionNameCount; i++)
+        {
+            if (NameEquals(actionName, actionNames[i].Name))
+            {
+                action = actionNames[i].Action;
+                break;
+            }
+        }
+
+        if (action >= ACTION_BINDING_MAX_ACTIONS)
+        {
+            message = LineError(lineNumber, "unknown action", actionName);
+            break;
+        }
+
+        binding.Values.Action = action;
+
+        std::string field;
+        while (tokens >> field)
+        {
+            if (!ParseField(field, &binding.Values))
+            {
+                message = LineError(lineNumber, "bad field", field);
+                break;
+            }
+        }
+
+        if (!message.empty())
+        {
+            break;
+        }
+
+        bool isKey = NameEquals(device, "key");
+        bool isPad = NameEquals(device, "pad");
+
+        if (NameEquals(device, "touch"))
+        {
+            unsigned int region;
+            if (!ParseUnsigned(chord, &region) || (region >= ACTION_BINDING_MAX_TOUCH_REGIONS))
+            {
+                message = LineError(lineNumber, "bad touch region", chord);
+            }
+            else if (m_touch[region] != ACTION_BINDING_MAX_ACTIONS)
+            {
+                message = LineError(lineNumber, "touch region bound twice", chord);
+            }
+            else
+            {
+                m_touch[region] = action;
+            }
+            continue;
+        }
+
+        if (!isKey && !isPad)
+        {
+            message = LineError(lineNumber, "unknown device", device);
+            break;
+        }
+
+        // Split the chord on '+'.
+        size_t start = 0;
+        while (message.empty())
+        {
+            size_t plus = chord.find('+', start);
+            std::string input = chord.substr(start, (plus == std::string::npos) ? std::string::npos : plus - start);
+
+            unsigned int code;
+            if (!(isKey ? ParseKey(input, &code) : ParsePadButton(input, &code)))
+            {
+                message = LineError(lineNumber, isKey ? "unknown key" : "unknown pad button", input);
+            }
+            else if (binding.InputCount == ACTION_BINDING_MAX_CHORD)
+            {
+                message = LineError(lineNumber, "too many inputs in chord", chord);
+            }
+            else
+            {
+                binding.Inputs[binding.InputCount++] = code;
+                binding.Mask |= code;
+            }
+
+            if (plus == std::string::npos)
+            {
+                break;
+            }
+            start = plus + 1;
+        }
+
+        if (!message.empty())
+        {
+            break;
+        }
+
+        std::vector<Binding>& bindings = isKey ? m_keyboard : m_gamepad;
+        if (bindings.size() == ACTION_BINDING_MAX_BINDINGS)
+        {
+            message = LineError(lineNumber, "too many bindings for", device);
+            break;
+        }
+
+        bindings.push_back(binding);
+    }
+
+    if (!message.empty())
+    {
+        Clear();
+        if (error != nullptr)
+        {
+            *error = message;
+        }
+        return false;
+    }
+
+    LinkShadows(m_keyboard, m_keyboardShadows, false);
+    LinkShadows(m_gamepad, m_gamepadShadows, true);
+
+    return true;
+}
+
+// Records, for each binding, the bindings whose chords strictly contain its
+// own. At translation time an active containing chord suppresses it.
+void ActionBindings::LinkShadows(std::vector<Binding>& bindings, std::vector<unsigned int>& shadows, bool useMask)
+{
+    shadows.clear();
+
+    for (unsigned int i = 0; i < bindings.size(); i++)
+    {
+        Binding& binding = bindings[i];
+        binding.FirstShadow = static_cast<unsigned int>(shadows.size());
+
+        for (unsigned int j = 0; j < bindings.size(); j++)
+        {
+            const Binding& other = bindings[j];
+            bool contains;
+
+            if (useMask)
+            {
+                contains = (other.Mask != binding.Mask) && ((other.Mask & binding.Mask) == binding.Mask);
+            }
+            else
+            {
+                contains = other.InputCount > binding.InputCount;
+                for (unsigned int a = 0; contains && (a < binding.InputCount); a++)
+                {
+                    bool found = false;
+                    for (unsigned int b = 0; b < other.InputCount; b++)
+                    {
+                        found = found || (other.Inputs[b] == binding.Inputs[a]);
+                    }
+                    contains = found;
+                }
+            }
+
+            if (contains)
+            {
+                shadows.push_back(j);
+            }
+        }
+
+        binding.ShadowCount = static_cast<unsigned int>(shadows.size()) - binding.FirstShadow;
+    }
+}
+
+unsigned int ActionBindings::TranslateKeyboard(const KeyStateTable& keys, BoundAction* actions, unsigned int capacity) const
+{
+    if (keys.GetCount() == 0)
+    {
+        return 0;
+    }
+
+    bool held[ACTION_BINDING_MAX_BINDINGS];
+    long long timestamps[ACTION_BINDING_MAX_BINDINGS];
+
+    for (unsigned int i = 0; i < m_keyboard.size(); i++)
+    {
+        const Binding& binding = m_keyboard[i];
+
+        held[i] = true;
+        timestamps[i] = 0;
+
+        for (unsigned int k = 0; held[i] && (k < binding.InputCount); k++)
+        {
+            held[i] = keys.IsDown(binding.Inputs[k]);
+
+            long long downTime = keys.GetDownTime(binding.Inputs[k]);
+            if (downTime > timestamps[i])
+            {
+                timestamps[i] = downTime;
+            }
+        }
+    }
+
+    return Merge(m_keyboard, m_keyboardShadows, held, timestamps, actions, capacity);
+}
+
+unsigned int ActionBindings::TranslateGamepad(unsigned int buttons, long long timestamp, BoundAction* actions, unsigned int capacity) const
+{
+    if (buttons == 0)
+    {
+        return 0;
+    }
+
+    bool held[ACTION_BINDING_MAX_BINDINGS];
+    long long timestamps[ACTION_BINDING_MAX_BINDINGS];
+
+    for (unsigned int i = 0; i < m_gamepad.size(); i++)
+    {
+        held[i] = (buttons & m_gamepad[i].Mask) == m_gamepad[i].Mask;
+        timestamps[i] = timestamp;
+    }
+
+    return Merge(m_gamepad, m_gamepadShadows, held, timestamps, actions, capacity);
+}
+
+unsigned int ActionBindings::GetTouchAction(unsigned int region, unsigned int defaultAction) const
+{
+    if ((region >= ACTION_BINDING_MAX_TOUCH_REGIONS) || (m_touch[region] == ACTION_BINDING_MAX_ACTIONS))
+    {
+        return defaultAction;
+    }
+
+    return m_touch[region];
+}
+
+unsigned int ActionBindings::Merge(const std::vector<Binding>& bindings, const std::vector<unsigned int>& shadows, const bool* held,
+    const long long* timestamps, BoundAction* actions, unsigned int capacity) const
+{
+    BoundAction merged[ACTION_BINDING_MAX_ACTIONS];
+    unsigned long long used = 0;
+
+    for (unsigned int i = 0; i < bindings.size(); i++)
+    {
+        if (!held[i])
+        {
+            continue;
+        }
+
+        const Binding& binding = bindings[i];
+
+        bool suppressed = false;
+        for (unsigned int s = 0; !suppressed && (s < binding.ShadowCount); s++)
+        {
+            suppressed = held[shadows[binding.FirstShadow + s]];
+        }
+
+        if (suppressed)
+        {
+            continue;
+        }
+
+        unsigned int action = binding.Values.Action;
+        unsigned long long bit = 1ull << action;
+        BoundAction& result = merged[action];
+
+        if ((used & bit) == 0)
+        {
+            used |= bit;
+            result = binding.Values;
+            result.Value = Clamp(result.Value);
+            result.X = Clamp(result.X);
+            result.Y = Clamp(result.Y);
+            result.Roll = Clamp(result.Roll);
+            result.Pitch = Clamp(result.Pitch);
+            result.Yaw = Clamp(result.Yaw);
+            result.LaserPitch = Clamp(result.LaserPitch);
+            result.LaserYaw = Clamp(result.LaserYaw);
+            result.Timestamp = timestamps[i];
+            continue;
+        }
+
+        result.Value = Clamp(result.Value + binding.Values.Value);
+        result.X = Clamp(result.X + binding.Values.X);
+        result.Y = Clamp(result.Y + binding.Values.Y);
+        result.Roll = Clamp(result.Roll + binding.Values.Roll);
+        result.Pitch = Clamp(result.Pitch + binding.Values.Pitch);
+        result.Yaw = Clamp(result.Yaw + binding.Values.Yaw);
+        result.LaserPitch = Clamp(result.LaserPitch + binding.Values.LaserPitch);
+        result.LaserYaw = Clamp(result.LaserYaw + binding.Values.LaserYaw);
+        result.IsFiring = result.IsFiring || binding.Values.IsFiring;
+        result.FireType = binding.Values.FireType;
+
+        if (timestamps[i] > result.Timestamp)
+        {
+            result.Timestamp = timestamps[i];
+        }
+    }
+
+    unsigned int count = 0;
+    for (unsigned int action = 0; (used != 0) && (count < capacity); action++, used >>= 1)
+    {
+        if (used & 1)
+        {
+            actions[count++] = merged[action];
+        }
+    }
+
+    return count;
+}
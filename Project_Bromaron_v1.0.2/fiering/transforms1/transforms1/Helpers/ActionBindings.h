@@ -0,0 +1,131 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "InputStateTables.h"
+
+namespace DirectXGame2
+{
+    // Keys or buttons that can be held together in one binding.
+#define ACTION_BINDING_MAX_CHORD        4
+
+    // Bindings per device, and the number of action IDs a binding can name.
+#define ACTION_BINDING_MAX_BINDINGS     256
+#define ACTION_BINDING_MAX_ACTIONS      64
+
+    // Touch regions that can be rebound.
+#define ACTION_BINDING_MAX_TOUCH_REGIONS 32
+
+    // Gamepad inputs are XInput wButtons bits, plus these for the triggers
+    // (held when the trigger is off its rest position).
+#define ACTION_BINDING_PAD_LEFT_TRIGGER  0x10000
+#define ACTION_BINDING_PAD_RIGHT_TRIGGER 0x20000
+
+    // Maps a name used in binding files to an action ID.
+    struct ActionName
+    {
+        const char*     Name;
+        unsigned int    Action;
+    };
+
+    // The merged result of every active binding for one action.
+    struct BoundAction
+    {
+        unsigned int    Action;
+        float           Value;
+        float           X;
+        float           Y;
+        float           Roll;
+        float           Pitch;
+        float           Yaw;
+        float           LaserPitch;
+        float           LaserYaw;
+        bool            IsFiring;
+        int             FireType;
+        long long       Timestamp;      // Newest arrival time of the inputs behind it.
+    };
+
+    //
+    // The ActionBindings class turns held keys and buttons into actions
+    // using a binding file compiled into flat tables.
+    //
+    // A binding file has one binding per line:
+    //
+    //     <device> <input>[+<input>...] = <ACTION> [<field>=<value> ...]
+    //
+    // device is key, pad or touch. Keys use VirtualKey names (A, Number1
+    // or 1, Space, Left, Control, F1...) or hex codes (0x41); pad inputs
+    // are A, B, X, Y, Start, Back, DPadUp..DPadRight, LeftShoulder,
+    // RightShoulder, LeftThumb, RightThumb, LeftTrigger and RightTrigger;
+    // touch inputs are touch region IDs. Inputs joined by + form a chord
+    // that is active only while all of them are held, which is how
+    // modifiers work: while Control+1 is active a binding on 1 alone is
+    // suppressed. Fields are value, x, y, roll, pitch, yaw, laserpitch,
+    // laseryaw, firing and firetype, all zero when not given. # starts a
+    // comment.
+    //
+    // Every active binding for the same action is merged into one
+    // BoundAction: values and axes are summed and clamped to [-1, 1],
+    // firing is or'd, and the last binding's firetype wins.
+    //
+    // Compiled bindings are read-only, so one instance can be translated
+    // on the game thread while the next is compiled on another.
+    //
+    // Usage:
+    // 1. bindings.Compile(text, names, nameCount, &error);
+    // 2. Per frame: count = bindings.TranslateKeyboard(keys, actions, capacity);
+    //
+    class ActionBindings
+    {
+    public:
+        ActionBindings();
+
+        // Replaces the bindings with those in text. On a syntax error returns
+        // false, describes it in *error (if given) and leaves no bindings.
+        bool Compile(const std::string& text, const ActionName* actionNames, unsigned int actionNameCount, std::string* error);
+
+        // One pass over the keyboard bindings. Writes one entry per action,
+        // in action order, and returns the number written.
+        unsigned int TranslateKeyboard(const KeyStateTable& keys, BoundAction* actions, unsigned int capacity) const;
+
+        // Same for a gamepad; buttons holds wButtons and the trigger bits above.
+        unsigned int TranslateGamepad(unsigned int buttons, long long timestamp, BoundAction* actions, unsigned int capacity) const;
+
+        // Action bound to a touch region, or defaultAction if the file doesn't rebind it.
+        unsigned int GetTouchAction(unsigned int region, unsigned int defaultAction) const;
+
+        unsigned int GetKeyboardBindingCount() const    { return static_cast<unsigned int>(m_keyboard.size()); }
+        unsigned int GetGamepadBindingCount() const     { return static_cast<unsigned int>(m_gamepad.size()); }
+
+    private:
+        struct Binding
+        {
+            unsigned int    Inputs[ACTION_BINDING_MAX_CHORD];   // Key codes, unused for gamepads.
+            unsigned int    InputCount;
+            unsigned int    Mask;                               // Button bits, unused for keys.
+            unsigned int    FirstShadow;                        // Range in m_shadows of bindings
+            unsigned int    ShadowCount;                        // whose chords contain this one.
+            BoundAction     Values;
+        };
+
+        void Clear();
+        void LinkShadows(std::vector<Binding>& bindings, std::vector<unsigned int>& shadows, bool useMask);
+        unsigned int Merge(const std::vector<Binding>& bindings, const std::vector<unsigned int>& shadows, const bool* held,
+            const long long* timestamps, BoundAction* actions, unsigned int capacity) const;
+
+        std::vector<Binding>        m_keyboard;
+        std::vector<Binding>        m_gamepad;
+        std::vector<unsigned int>   m_keyboardShadows;
+        std::vector<unsigned int>   m_gamepadShadows;
+
+        // Action per touch region, or ACTION_BINDING_MAX_ACTIONS when unbound.
+        unsigned int                m_touch[ACTION_BINDING_MAX_TOUCH_REGIONS];
+    };
+}
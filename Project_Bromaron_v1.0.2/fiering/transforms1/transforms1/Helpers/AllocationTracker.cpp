@@ -0,0 +1,225 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "AllocationTracker.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace DirectXGame2;
+
+std::atomic<unsigned int>       AllocationTracker::s_totalCount(0);
+std::atomic<size_t>             AllocationTracker::s_totalBytes(0);
+unsigned int                    AllocationTracker::s_frameStartCount = 0;
+size_t                          AllocationTracker::s_frameStartBytes = 0;
+unsigned int                    AllocationTracker::s_lastFrameCount = 0;
+size_t                          AllocationTracker::s_lastFrameBytes = 0;
+unsigned int                    AllocationTracker::s_frameCount = 0;
+AllocationTracker::TagCounters  AllocationTracker::s_tags[MEMORY_TAG_COUNT];
+
+void AllocationTracker::BeginFrame()
+{
+    unsigned int count = s_totalCount;
+    size_t bytes = s_totalBytes;
+
+    s_lastFrameCount = count - s_frameStartCount;
+    s_lastFrameBytes = bytes - s_frameStartBytes;
+    s_frameStartCount = count;
+    s_frameStartBytes = bytes;
+
+    for (unsigned int t = 0; t < MEMORY_TAG_COUNT; t++)
+    {
+        TagCounters& counters = s_tags[t];
+        unsigned int tagCount = counters.FrameAllocations.exchange(0);
+
+        unsigned int bucket = 0;
+        while ((tagCount >> bucket) != 0 && (bucket < MEMORY_HISTOGRAM_BUCKETS - 1))
+        {
+            bucket++;
+        }
+
+        counters.FrameHistogram[bucket]++;
+        counters.LastFrameAllocations = tagCount;
+    }
+
+    s_frameCount++;
+}
+
+void AllocationTracker::RecordAllocation(MEMORY_TAG tag, size_t bytes)
+{
+    TagCounters& counters = s_tags[tag];
+
+    size_t live = (counters.LiveBytes += bytes);
+    counters.TotalAllocations++;
+    counters.FrameAllocations++;
+
+    // Raise the peak; retry only if another thread raised it in between.
+    size_t peak = counters.PeakBytes;
+    while ((live > peak) && !counters.PeakBytes.compare_exchange_weak(peak, live))
+    {
+    }
+}
+
+void AllocationTracker::RecordFree(MEMORY_TAG tag, size_t bytes)
+{
+    TagCounters& counters = s_tags[tag];
+
+    counters.LiveBytes -= bytes;
+    counters.TotalFrees++;
+}
+
+void AllocationTracker::GetSnapshot(MemorySnapshot* snapshot)
+{
+    snapshot->FrameCount = s_frameCount;
+    snapshot->TotalAllocations = s_totalCount;
+    snapshot->TotalBytes = s_totalBytes;
+    snapshot->LastFrameAllocations = s_lastFrameCount;
+    snapshot->LastFrameBytes = s_lastFrameBytes;
+
+    for (unsigned int t = 0; t < MEMORY_TAG_COUNT; t++)
+    {
+        const TagCounters& counters = s_tags[t];
+        MemoryTagStats& stats = snapshot->Tags[t];
+
+        stats.LiveBytes = counters.LiveBytes;
+        stats.PeakBytes = counters.PeakBytes;
+        stats.TotalAllocations = counters.TotalAllocations;
+        stats.TotalFrees = counters.TotalFrees;
+        stats.LastFrameAllocations = counters.LastFrameAllocations;
+
+        for (unsigned int b = 0; b < MEMORY_HISTOGRAM_BUCKETS; b++)
+        {
+            stats.FrameHistogram[b] = counters.FrameHistogram[b];
+        }
+    }
+}
+
+const char* AllocationTracker::GetTagName(MEMORY_TAG tag)
+{
+    switch (tag)
+    {
+    case MEMORY_TAG_GENERAL:    return "general";
+    case MEMORY_TAG_INPUT:      return "input";
+    case MEMORY_TAG_AUDIO:      return "audio";
+    case MEMORY_TAG_SCENE:      return "scene";
+    default:                    return "unknown";
+    }
+}
+
+// Produces:
+// { "frames": N, "heap": { "allocs": .., "bytes": .., "lastFrameAllocs": ..,
+//   "lastFrameBytes": .. }, "tags": { "input": { "live": .., "peak": ..,
+//   "allocs": .., "frees": .., "lastFrameAllocs": .., "frameHistogram": [ .. ] }, .. } }
+std::string AllocationTracker::SnapshotToJson(const MemorySnapshot& snapshot)
+{
+    std::string json = "{ \"frames\": " + std::to_string(snapshot.FrameCount);
+    json += ", \"heap\": { \"allocs\": " + std::to_string(snapshot.TotalAllocations);
+    json += ", \"bytes\": " + std::to_string(static_cast<unsigned long long>(snapshot.TotalBytes));
+    json += ", \"lastFrameAllocs\": " + std::to_string(snapshot.LastFrameAllocations);
+    json += ", \"lastFrameBytes\": " + std::to_string(static_cast<unsigned long long>(snapshot.LastFrameBytes));
+    json += " }, \"tags\": {";
+
+    for (unsigned int t = 0; t < MEMORY_TAG_COUNT; t++)
+    {
+        const MemoryTagStats& stats = snapshot.Tags[t];
+
+        json += (t == 0) ? " \"" : ", \"";
+        json += GetTagName(static_cast<MEMORY_TAG>(t));
+        json += "\": { \"live\": " + std::to_string(static_cast<unsigned long long>(stats.LiveBytes));
+        json += ", \"peak\": " + std::to_string(static_cast<unsigned long long>(stats.PeakBytes));
+        json += ", \"allocs\": " + std::to_string(stats.TotalAllocations);
+        json += ", \"frees\": " + std::to_string(stats.TotalFrees);
+        json += ", \"lastFrameAllocs\": " + std::to_string(stats.LastFrameAllocations);
+        json += ", \"frameHistogram\": [";
+
+        for (unsigned int b = 0; b < MEMORY_HISTOGRAM_BUCKETS; b++)
+        {
+            json += (b == 0) ? " " : ", ";
+            json += std::to_string(stats.FrameHistogram[b]);
+        }
+
+        json += " ] }";
+    }
+
+    json += " } }";
+
+    return json;
+}
+
+bool AllocationTracker::WriteSnapshot(const std::wstring& path)
+{
+    MemorySnapshot snapshot;
+    GetSnapshot(&snapshot);
+    std::string json = SnapshotToJson(snapshot);
+
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, path.c_str(), L"wb") != 0 || file == nullptr)
+    {
+        return false;
+    }
+
+    size_t written = fwrite(json.data(), 1, json.size(), file);
+    fclose(file);
+
+    return written == json.size();
+}
+
+#if ALLOCATION_TRACKING
+
+// Replacement global allocation functions. Everything still goes to the CRT
+// heap; the replacements only count.
+
+void* operator new(size_t size)
+{
+    AllocationTracker::RecordAllocation(size);
+
+    void* memory = malloc(size ? size : 1);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&)
+{
+    AllocationTracker::RecordAllocation(size);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag)
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* memory)
+{
+    free(memory);
+}
+
+void operator delete[](void* memory)
+{
+    free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&)
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&)
+{
+    free(memory);
+}
+
+#endif
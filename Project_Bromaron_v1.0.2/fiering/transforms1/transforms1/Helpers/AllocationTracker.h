@@ -0,0 +1,191 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <new>
+#include <utility>
+#include <stddef.h>
+
+// Heap accounting. Counts every global operator new call so that per-frame
+// heap traffic can be reported, and charges memory allocated through
+// TrackingAllocator to a subsystem tag. On by default in debug builds; define
+// ALLOCATION_TRACKING to 0 or 1 in the project settings to override. When off,
+// every counter reads zero and TrackingAllocator behaves exactly like
+// std::allocator.
+#ifndef ALLOCATION_TRACKING
+#ifdef _DEBUG
+#define ALLOCATION_TRACKING             1
+#else
+#define ALLOCATION_TRACKING             0
+#endif
+#endif
+
+namespace DirectXGame2
+{
+    // Subsystems that memory is charged to.
+    enum MEMORY_TAG
+    {
+        MEMORY_TAG_GENERAL = 0,
+        MEMORY_TAG_INPUT,
+        MEMORY_TAG_AUDIO,
+        MEMORY_TAG_SCENE,
+        MEMORY_TAG_COUNT
+    };
+
+    // Per-frame allocation count histogram. Bucket 0 counts frames with no
+    // allocations, bucket n counts frames with 2^(n-1) to 2^n - 1 allocations,
+    // and the last bucket counts everything above that.
+#define MEMORY_HISTOGRAM_BUCKETS        8
+
+    struct MemoryTagStats
+    {
+        size_t              LiveBytes;
+        size_t              PeakBytes;
+        unsigned long long  TotalAllocations;
+        unsigned long long  TotalFrees;
+        unsigned int        LastFrameAllocations;
+        unsigned int        FrameHistogram[MEMORY_HISTOGRAM_BUCKETS];
+    };
+
+    struct MemorySnapshot
+    {
+        unsigned int        FrameCount;
+
+        // Every global operator new call, tagged or not.
+        unsigned int        TotalAllocations;
+        size_t              TotalBytes;
+        unsigned int        LastFrameAllocations;
+        size_t              LastFrameBytes;
+
+        MemoryTagStats      Tags[MEMORY_TAG_COUNT];
+    };
+
+    //
+    // The AllocationTracker class reports heap allocations per frame, in
+    // total and per MEMORY_TAG.
+    //
+    // Call BeginFrame() once at the top of every frame; the Last* accessors
+    // then describe the previous frame. Record* may be called from any thread
+    // (audio callbacks included). BeginFrame() and GetSnapshot() are meant
+    // for the game loop thread.
+    //
+    class AllocationTracker
+    {
+    public:
+        // Closes the previous frame: rolls the global counters over and folds
+        // each tag's allocation count into its histogram.
+        static void BeginFrame();
+
+        static unsigned int GetLastFrameAllocationCount()   { return s_lastFrameCount; }
+        static size_t GetLastFrameAllocationBytes()         { return s_lastFrameBytes; }
+        static unsigned int GetTotalAllocationCount()       { return s_totalCount; }
+        static size_t GetTotalAllocationBytes()             { return s_totalBytes; }
+
+        static void RecordAllocation(size_t size)           { s_totalCount++; s_totalBytes += size; }
+        static void RecordAllocation(MEMORY_TAG tag, size_t bytes);
+        static void RecordFree(MEMORY_TAG tag, size_t bytes);
+
+        static void GetSnapshot(MemorySnapshot* snapshot);
+        static std::string SnapshotToJson(const MemorySnapshot& snapshot);
+        static bool WriteSnapshot(const std::wstring& path);
+        static const char* GetTagName(MEMORY_TAG tag);
+
+        static bool IsEnabled()                             { return ALLOCATION_TRACKING != 0; }
+
+    private:
+        struct TagCounters
+        {
+            std::atomic<size_t>             LiveBytes;
+            std::atomic<size_t>             PeakBytes;
+            std::atomic<unsigned long long> TotalAllocations;
+            std::atomic<unsigned long long> TotalFrees;
+            std::atomic<unsigned int>       FrameAllocations;
+            unsigned int                    LastFrameAllocations;
+            unsigned int                    FrameHistogram[MEMORY_HISTOGRAM_BUCKETS];
+        };
+
+        static std::atomic<unsigned int>    s_totalCount;
+        static std::atomic<size_t>          s_totalBytes;
+        static unsigned int                 s_frameStartCount;
+        static size_t                       s_frameStartBytes;
+        static unsigned int                 s_lastFrameCount;
+        static size_t                       s_lastFrameBytes;
+        static unsigned int                 s_frameCount;
+        static TagCounters                  s_tags[MEMORY_TAG_COUNT];
+    };
+
+    //
+    // STL allocator that charges its memory to a MEMORY_TAG, e.g.
+    //     std::vector<BYTE, TrackingAllocator<BYTE, MEMORY_TAG_AUDIO>>
+    //
+    template<typename T, MEMORY_TAG Tag>
+    class TrackingAllocator
+    {
+    public:
+        typedef T               value_type;
+        typedef T*              pointer;
+        typedef const T*        const_pointer;
+        typedef T&              reference;
+        typedef const T&        const_reference;
+        typedef size_t          size_type;
+        typedef ptrdiff_t       difference_type;
+
+        template<typename U>
+        struct rebind
+        {
+            typedef TrackingAllocator<U, Tag> other;
+        };
+
+        TrackingAllocator() {}
+        TrackingAllocator(const TrackingAllocator&) {}
+        template<typename U>
+        TrackingAllocator(const TrackingAllocator<U, Tag>&) {}
+
+        pointer address(reference value) const                  { return &value; }
+        const_pointer address(const_reference value) const      { return &value; }
+
+        pointer allocate(size_type count, const void* = nullptr)
+        {
+            if (count > max_size())
+            {
+                throw std::bad_alloc();
+            }
+
+#if ALLOCATION_TRACKING
+            AllocationTracker::RecordAllocation(Tag, count * sizeof(T));
+#endif
+            return static_cast<pointer>(::operator new(count * sizeof(T)));
+        }
+
+        void deallocate(pointer memory, size_type count)
+        {
+#if ALLOCATION_TRACKING
+            AllocationTracker::RecordFree(Tag, count * sizeof(T));
+#else
+            (void)count;
+#endif
+            ::operator delete(memory);
+        }
+
+        size_type max_size() const                              { return static_cast<size_type>(-1) / sizeof(T); }
+
+        template<typename U, typename... Args>
+        void construct(U* object, Args&&... args)               { ::new(static_cast<void*>(object)) U(std::forward<Args>(args)...); }
+
+        template<typename U>
+        void destroy(U* object)                                 { object->~U(); }
+    };
+
+    template<typename T, typename U, MEMORY_TAG Tag>
+    bool operator==(const TrackingAllocator<T, Tag>&, const TrackingAllocator<U, Tag>&)   { return true; }
+
+    template<typename T, typename U, MEMORY_TAG Tag>
+    bool operator!=(const TrackingAllocator<T, Tag>&, const TrackingAllocator<U, Tag>&)   { return false; }
+}
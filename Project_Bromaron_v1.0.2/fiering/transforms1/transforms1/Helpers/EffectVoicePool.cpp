@@ -0,0 +1,197 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "EffectVoicePool.h"
+
+using namespace DirectXGame2;
+
+EffectVoicePool::EffectVoicePool(unsigned int voiceCount, float referenceDistance) :
+    m_voiceCount((voiceCount < EFFECT_VOICE_POOL_MAX_VOICES) ? voiceCount : EFFECT_VOICE_POOL_MAX_VOICES),
+    m_referenceDistance(referenceDistance),
+    m_sequence(0),
+    m_started(0),
+    m_stolen(0),
+    m_culled(0),
+    m_rejected(0)
+{
+    for (unsigned int i = 0; i < EFFECT_VOICE_POOL_MAX_VOICES; i++)
+    {
+        m_slots[i].Submission = 0;
+        m_slots[i].Priority = EFFECT_PRIORITY_LOW;
+        m_slots[i].Audibility = 0.f;
+        m_slots[i].Sequence = 0;
+        m_ended[i].store(0, std::memory_order_relaxed);
+    }
+
+    // At most one stolen sound per voice per Update is typical; reserving
+    // keeps Allocate from reallocating in the common case.
+    m_retired.reserve(m_voiceCount * 2);
+}
+
+void EffectVoicePool::Update()
+{
+    for (unsigned int i = 0; i < m_voiceCount; i++)
+    {
+        if ((m_slots[i].Sound != nullptr) && HasEnded(i, m_slots[i].Submission))
+        {
+            m_slots[i].Sound.reset();
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < m_retired.size(); i++)
+    {
+        if (!HasEnded(m_retired[i].Slot, m_retired[i].Submission))
+        {
+            if (kept != i)
+            {
+                m_retired[kept] = std::move(m_retired[i]);
+            }
+            kept++;
+        }
+    }
+    m_retired.resize(kept);
+}
+
+EFFECT_VOICE_RESULT EffectVoicePool::Allocate(const EffectVoiceRequest& request, unsigned int* slot, float* gain)
+{
+    // Inverse distance attenuation, flat inside the reference distance.
+    float attenuation = (request.Distance > m_referenceDistance) ? (m_referenceDistance / request.Distance) : 1.f;
+    float audibility = request.Volume * attenuation;
+
+    if ((request.Sound == nullptr) || !(audibility >= EFFECT_VOICE_MIN_AUDIBILITY))
+    {
+        m_culled++;
+        return EFFECT_VOICE_CULLED;
+    }
+
+    // Prefer a free voice, then the least important playing one.
+    unsigned int chosen = m_voiceCount;
+    for (unsigned int i = 0; i < m_voiceCount; i++)
+    {
+        if (m_slots[i].Sound == nullptr)
+        {
+            chosen = i;
+            break;
+        }
+
+        if (chosen == m_voiceCount)
+        {
+            chosen = i;
+            continue;
+        }
+
+        const Slot& candidate = m_slots[i];
+        const Slot& victim = m_slots[chosen];
+        if ((candidate.Priority < victim.Priority) ||
+            ((candidate.Priority == victim.Priority) && (candidate.Audibility < victim.Audibility)) ||
+            ((candidate.Priority == victim.Priority) && (candidate.Audibility == victim.Audibility) && (candidate.Sequence < victim.Sequence)))
+        {
+            chosen = i;
+        }
+    }
+
+    if (chosen == m_voiceCount)
+    {
+        m_rejected++;
+        return EFFECT_VOICE_REJECTED;
+    }
+
+    Slot& target = m_slots[chosen];
+    EFFECT_VOICE_RESULT result = EFFECT_VOICE_FREE;
+    if (target.Sound != nullptr)
+    {
+        if ((target.Priority > request.Priority) ||
+            ((target.Priority == request.Priority) && (target.Audibility > audibility)))
+        {
+            m_rejected++;
+            return EFFECT_VOICE_REJECTED;
+        }
+
+        // The mixer may still be reading the old sound until its buffer ends.
+        Retired retired;
+        retired.Sound = std::move(target.Sound);
+        retired.Slot = chosen;
+        retired.Submission = target.Submission;
+        m_retired.push_back(std::move(retired));
+
+        m_stolen++;
+        result = EFFECT_VOICE_STOLEN;
+    }
+
+    target.Sound = request.Sound;
+    target.Submission++;
+    target.Priority = request.Priority;
+    target.Audibility = audibility;
+    target.Sequence = ++m_sequence;
+    m_started++;
+
+    *slot = chosen;
+    *gain = audibility;
+    return result;
+}
+
+void EffectVoicePool::Cancel(unsigned int slot)
+{
+    if ((slot >= m_voiceCount) || (m_slots[slot].Sound == nullptr))
+    {
+        return;
+    }
+
+    // Never submitted, so the mixer will never report it.
+    m_slots[slot].Sound.reset();
+    m_slots[slot].Submission--;
+    m_started--;
+}
+
+void EffectVoicePool::OnVoiceRecreated(unsigned int slot)
+{
+    if (slot >= m_voiceCount)
+    {
+        return;
+    }
+
+    // The old voice is gone, and with it every buffer queued on it.
+    unsigned int current = m_slots[slot].Submission;
+    m_ended[slot].store((m_slots[slot].Sound != nullptr) ? (current - 1) : current, std::memory_order_release);
+}
+
+void EffectVoicePool::OnVoiceEnd(unsigned int slot)
+{
+    if (slot < EFFECT_VOICE_POOL_MAX_VOICES)
+    {
+        // Buffers on a voice end in the order they were submitted, so a count
+        // is enough to know which have.
+        m_ended[slot].fetch_add(1, std::memory_order_release);
+    }
+}
+
+void EffectVoicePool::GetStats(EffectVoiceStats* stats) const
+{
+    stats->Started = m_started;
+    stats->Stolen = m_stolen;
+    stats->Culled = m_culled;
+    stats->Rejected = m_rejected;
+    stats->Retiring = static_cast<unsigned int>(m_retired.size());
+
+    stats->Playing = 0;
+    for (unsigned int i = 0; i < m_voiceCount; i++)
+    {
+        if (m_slots[i].Sound != nullptr)
+        {
+            stats->Playing++;
+        }
+    }
+}
+
+bool EffectVoicePool::HasEnded(unsigned int slot, unsigned int submission) const
+{
+    // Counts wrap, so compare the difference.
+    unsigned int ended = m_ended[slot].load(std::memory_order_acquire);
+    return static_cast<int>(ended - submission) >= 0;
+}
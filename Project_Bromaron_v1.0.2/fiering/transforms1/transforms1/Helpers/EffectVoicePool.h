@@ -0,0 +1,145 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "SoundCache.h"
+
+namespace DirectXGame2
+{
+    // Most voices a pool can manage.
+#define EFFECT_VOICE_POOL_MAX_VOICES    32
+
+    // Sounds quieter than this after distance attenuation (-40 dB) aren't played.
+#define EFFECT_VOICE_MIN_AUDIBILITY     0.01f
+
+    // A sound only takes a voice from one of equal or lower priority.
+    enum EFFECT_PRIORITY
+    {
+        EFFECT_PRIORITY_LOW,
+        EFFECT_PRIORITY_NORMAL,
+        EFFECT_PRIORITY_HIGH,
+        EFFECT_PRIORITY_CRITICAL
+    };
+
+    enum EFFECT_VOICE_RESULT
+    {
+        EFFECT_VOICE_FREE,          // Got a voice that wasn't playing.
+        EFFECT_VOICE_STOLEN,        // Got a voice by cutting off another sound.
+        EFFECT_VOICE_CULLED,        // Too quiet to be worth a voice.
+        EFFECT_VOICE_REJECTED       // Every voice is playing something that matters more.
+    };
+
+    struct EffectVoiceRequest
+    {
+        std::shared_ptr<const SoundAsset>   Sound;
+        EFFECT_PRIORITY                     Priority;
+        float                               Volume;
+        float                               Distance;       // From the listener, in the same units as the reference distance.
+    };
+
+    struct EffectVoiceStats
+    {
+        unsigned long long  Started;
+        unsigned long long  Stolen;
+        unsigned long long  Culled;
+        unsigned long long  Rejected;
+        unsigned int        Playing;
+        unsigned int        Retiring;       // Stolen sounds the mixer may still be reading.
+    };
+
+    //
+    // The EffectVoicePool class decides which of a fixed set of voices plays
+    // each sound effect, so overlapping effects play together instead of
+    // cutting each other off.
+    //
+    // Each sound's audibility is its volume attenuated by distance. Sounds
+    // below EFFECT_VOICE_MIN_AUDIBILITY are culled. When every voice is busy,
+    // the voice with the lowest priority is stolen, then the quietest, then
+    // the oldest, then the lowest slot, so the same sequence of requests
+    // always makes the same choices. A sound never steals from one that has
+    // a higher priority, or from a louder one of the same priority.
+    //
+    // The pool keeps each sound alive until the mixer is done with it. A
+    // stolen sound is held until the mixer reports its buffer ended, since
+    // the mixer may still be reading it after the voice is stopped.
+    //
+    // Only OnVoiceEnd is called from the mixer; it is a single atomic
+    // increment. Everything else belongs to the game thread, so the two
+    // never wait on each other.
+    //
+    // Usage:
+    // 1. Once per sound: pool.Update(); then result = pool.Allocate(request, &slot, &gain);
+    // 2. On EFFECT_VOICE_STOLEN, stop the slot's voice and flush it.
+    // 3. Submit the sound to the slot's voice at gain, with the slot as the buffer context.
+    // 4. From the voice's buffer-end callback: pool.OnVoiceEnd(slot);
+    //
+    class EffectVoicePool
+    {
+    public:
+        EffectVoicePool(unsigned int voiceCount, float referenceDistance);
+
+        unsigned int GetVoiceCount() const      { return m_voiceCount; }
+
+        // Frees the voices and stolen sounds the mixer has finished with.
+        void Update();
+
+        // Picks a voice for the sound. On EFFECT_VOICE_FREE or EFFECT_VOICE_STOLEN,
+        // slot and gain say which voice to play it on and at what volume.
+        EFFECT_VOICE_RESULT Allocate(const EffectVoiceRequest& request, unsigned int* slot, float* gain);
+
+        // The last sound allocated to the slot couldn't be submitted.
+        void Cancel(unsigned int slot);
+
+        // The slot's voice was destroyed and recreated, so nothing before its
+        // current sound will report an end.
+        void OnVoiceRecreated(unsigned int slot);
+
+        // A buffer submitted to the slot's voice has ended. Any thread.
+        void OnVoiceEnd(unsigned int slot);
+
+        void GetStats(EffectVoiceStats* stats) const;
+
+    private:
+        struct Slot
+        {
+            std::shared_ptr<const SoundAsset>   Sound;          // Null when the voice is free.
+            unsigned int                        Submission;     // Buffers submitted to the voice, counting this one.
+            EFFECT_PRIORITY                     Priority;
+            float                               Audibility;
+            unsigned long long                  Sequence;       // Order the sounds were started in.
+        };
+
+        struct Retired
+        {
+            std::shared_ptr<const SoundAsset>   Sound;
+            unsigned int                        Slot;
+            unsigned int                        Submission;
+        };
+
+        EffectVoicePool(const EffectVoicePool&);
+        EffectVoicePool& operator=(const EffectVoicePool&);
+
+        bool HasEnded(unsigned int slot, unsigned int submission) const;
+
+        unsigned int                m_voiceCount;
+        float                       m_referenceDistance;
+
+        Slot                        m_slots[EFFECT_VOICE_POOL_MAX_VOICES];
+        std::atomic<unsigned int>   m_ended[EFFECT_VOICE_POOL_MAX_VOICES];   // Buffers ended per voice, counted by the mixer.
+        std::vector<Retired>        m_retired;
+        unsigned long long          m_sequence;
+
+        unsigned long long          m_started;
+        unsigned long long          m_stolen;
+        unsigned long long          m_culled;
+        unsigned long long          m_rejected;
+    };
+}
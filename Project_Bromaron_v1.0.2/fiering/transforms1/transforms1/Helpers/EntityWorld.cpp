@@ -0,0 +1,310 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "EntityWorld.h"
+#include "FrameProfiler.h"
+
+using namespace DirectXGame2;
+
+// Pool blocks are aligned for SSE loads; each component array inside a chunk
+// is aligned to at least this much as well.
+#define ENTITY_CHUNK_ALIGNMENT          ARENA_MIN_ALIGNMENT
+
+namespace
+{
+    ComponentTypeInfo   g_componentTypes[MAX_COMPONENT_TYPES];
+    unsigned int        g_componentTypeCount = 0;
+
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+unsigned int DirectXGame2::RegisterComponentType(size_t size, size_t alignment)
+{
+    if (g_componentTypeCount >= MAX_COMPONENT_TYPES)
+    {
+        throw ref new Platform::FailureException(L"Too many component types registered.");
+    }
+
+    g_componentTypes[g_componentTypeCount].Size = size;
+    g_componentTypes[g_componentTypeCount].Alignment = (alignment > ENTITY_CHUNK_ALIGNMENT) ? alignment : ENTITY_CHUNK_ALIGNMENT;
+
+    return g_componentTypeCount++;
+}
+
+const ComponentTypeInfo& DirectXGame2::GetComponentTypeInfo(unsigned int typeId)
+{
+    return g_componentTypes[typeId];
+}
+
+//
+// ** EntityWorld **
+//
+
+EntityWorld::EntityWorld() :
+    m_liveEntities(0),
+    m_chunkPool(ENTITY_CHUNK_BYTES, ENTITY_CHUNKS_PER_PAGE, MEMORY_TAG_SCENE)
+{
+}
+
+EntityWorld::~EntityWorld()
+{
+    Clear();
+
+    for (unsigned int a = 0; a < m_archetypes.size(); a++)
+    {
+        delete m_archetypes[a];
+    }
+}
+
+void EntityWorld::Clear()
+{
+    for (unsigned int a = 0; a < m_archetypes.size(); a++)
+    {
+        Archetype* archetype = m_archetypes[a];
+
+        for (unsigned int c = 0; c < archetype->Chunks.size(); c++)
+        {
+            m_chunkPool.Free(archetype->Chunks[c]);
+        }
+
+        archetype->Chunks.clear();
+        archetype->ChunkCounts.clear();
+    }
+
+    // Bump every generation so that handles from before the clear stay dead.
+    m_freeRecords.clear();
+    for (unsigned int i = static_cast<unsigned int>(m_records.size()); i > 0; i--)
+    {
+        m_records[i - 1].Owner = nullptr;
+        m_records[i - 1].Generation++;
+        m_freeRecords.push_back(i - 1);
+    }
+
+    m_liveEntities = 0;
+}
+
+bool EntityWorld::IsAlive(Entity entity) const
+{
+    return (entity.Index < m_records.size()) &&
+        (m_records[entity.Index].Owner != nullptr) &&
+        (m_records[entity.Index].Generation == entity.Generation);
+}
+
+EntityWorld::Archetype* EntityWorld::FindOrCreateArchetype(ComponentMask mask)
+{
+    for (unsigned int a = 0; a < m_archetypes.size(); a++)
+    {
+        if (m_archetypes[a]->Mask == mask) return m_archetypes[a];
+    }
+
+    Archetype* archetype = new Archetype();
+    archetype->Mask = mask;
+
+    for (unsigned int t = 0; t < MAX_COMPONENT_TYPES; t++)
+    {
+        archetype->Offsets[t] = INVALID_COMPONENT_OFFSET;
+        if (mask & (static_cast<ComponentMask>(1) << t)) archetype->TypeIds.push_back(t);
+    }
+
+    // Work out how many rows fit: the entity index array plus one array per
+    // component, each padded up to its alignment.
+    size_t rowBytes = sizeof(unsigned int);
+    size_t paddingBytes = ENTITY_CHUNK_ALIGNMENT;
+    for (unsigned int i = 0; i < archetype->TypeIds.size(); i++)
+    {
+        const ComponentTypeInfo& info = g_componentTypes[archetype->TypeIds[i]];
+        rowBytes += info.Size;
+        paddingBytes += info.Alignment;
+    }
+
+    archetype->Capacity = static_cast<unsigned int>((ENTITY_CHUNK_BYTES - paddingBytes) / rowBytes);
+
+    size_t offset = AlignUp(archetype->Capacity * sizeof(unsigned int), ENTITY_CHUNK_ALIGNMENT);
+    for (unsigned int i = 0; i < archetype->TypeIds.size(); i++)
+    {
+        const ComponentTypeInfo& info = g_componentTypes[archetype->TypeIds[i]];
+        offset = AlignUp(offset, info.Alignment);
+        archetype->Offsets[archetype->TypeIds[i]] = static_cast<unsigned int>(offset);
+        offset += archetype->Capacity * info.Size;
+    }
+
+    m_archetypes.push_back(archetype);
+
+    return archetype;
+}
+
+Entity EntityWorld::AllocateRow(Archetype* archetype, unsigned int& chunk, unsigned int& row)
+{
+    if (archetype->Chunks.empty() || (archetype->ChunkCounts.back() == archetype->Capacity))
+    {
+        archetype->Chunks.push_back(static_cast<unsigned char*>(m_chunkPool.Allocate()));
+        archetype->ChunkCounts.push_back(0);
+    }
+
+    chunk = static_cast<unsigned int>(archetype->Chunks.size() - 1);
+    row = archetype->ChunkCounts[chunk]++;
+
+    unsigned int index;
+    if (m_freeRecords.empty())
+    {
+        index = static_cast<unsigned int>(m_records.size());
+        EntityRecord record = { nullptr, 0, 0, 0 };
+        m_records.push_back(record);
+    }
+    else
+    {
+        index = m_freeRecords.back();
+        m_freeRecords.pop_back();
+    }
+
+    EntityRecord& record = m_records[index];
+    record.Owner = archetype;
+    record.Chunk = chunk;
+    record.Row = row;
+
+    GetEntityIndices(archetype->Chunks[chunk])[row] = index;
+    m_liveEntities++;
+
+    return Entity(index, record.Generation);
+}
+
+// Moves the archetype's last row into the destroyed entity's row so that
+// every chunk but the last stays full.
+void EntityWorld::DestroyEntity(Entity entity)
+{
+    if (!IsAlive(entity)) return;
+
+    EntityRecord& record = m_records[entity.Index];
+    Archetype* archetype = record.Owner;
+
+    unsigned int lastChunk = static_cast<unsigned int>(archetype->Chunks.size() - 1);
+    unsigned int lastRow = archetype->ChunkCounts[lastChunk] - 1;
+
+    if ((record.Chunk != lastChunk) || (record.Row != lastRow))
+    {
+        unsigned char* dst = archetype->Chunks[record.Chunk];
+        unsigned char* src = archetype->Chunks[lastChunk];
+
+        for (unsigned int i = 0; i < archetype->TypeIds.size(); i++)
+        {
+            unsigned int typeId = archetype->TypeIds[i];
+            size_t size = g_componentTypes[typeId].Size;
+            unsigned int offset = archetype->Offsets[typeId];
+
+            memcpy(dst + offset + record.Row * size, src + offset + lastRow * size, size);
+        }
+
+        unsigned int movedIndex = GetEntityIndices(src)[lastRow];
+        GetEntityIndices(dst)[record.Row] = movedIndex;
+        m_records[movedIndex].Chunk = record.Chunk;
+        m_records[movedIndex].Row = record.Row;
+    }
+
+    if (--archetype->ChunkCounts[lastChunk] == 0)
+    {
+        m_chunkPool.Free(archetype->Chunks[lastChunk]);
+        archetype->Chunks.pop_back();
+        archetype->ChunkCounts.pop_back();
+    }
+
+    record.Owner = nullptr;
+    record.Generation++;
+    m_freeRecords.push_back(entity.Index);
+    m_liveEntities--;
+}
+
+//
+// ** EntitySystemScheduler **
+//
+
+EntitySystemScheduler::EntitySystemScheduler() :
+    m_stagesDirty(false)
+{
+}
+
+void EntitySystemScheduler::AddSystem(
+    _In_z_ const char* name,
+    ComponentMask reads,
+    ComponentMask writes,
+    std::function<void(EntityWorld&)> update
+    )
+{
+    EntitySystem system;
+    system.Name = name;
+    system.Reads = reads;
+    system.Writes = writes;
+    system.Update = update;
+
+    m_systems.push_back(system);
+    m_stagesDirty = true;
+}
+
+void EntitySystemScheduler::Clear()
+{
+    m_systems.clear();
+    m_stages.clear();
+    m_stagesDirty = false;
+}
+
+void EntitySystemScheduler::BuildStages()
+{
+    if (!m_stagesDirty) return;
+
+    m_stages.clear();
+    std::vector<unsigned int> stageOf(m_systems.size());
+
+    for (unsigned int s = 0; s < m_systems.size(); s++)
+    {
+        const EntitySystem& system = m_systems[s];
+        unsigned int stage = 0;
+
+        // Go one stage past the latest earlier system this one conflicts with.
+        for (unsigned int p = 0; p < s; p++)
+        {
+            const EntitySystem& previous = m_systems[p];
+            bool conflict = ((system.Writes & (previous.Reads | previous.Writes)) != 0) ||
+                ((system.Reads & previous.Writes) != 0);
+
+            if (conflict && (stageOf[p] + 1 > stage)) stage = stageOf[p] + 1;
+        }
+
+        if (stage == m_stages.size()) m_stages.push_back(std::vector<unsigned int>());
+
+        m_stages[stage].push_back(s);
+        stageOf[s] = stage;
+    }
+
+    m_stagesDirty = false;
+}
+
+void EntitySystemScheduler::Run(EntityWorld& world)
+{
+    BuildStages();
+
+    for (unsigned int i = 0; i < m_stages.size(); i++)
+    {
+        const std::vector<unsigned int>& stage = m_stages[i];
+
+        if (stage.size() == 1)
+        {
+            ProfileScope scope(m_systems[stage[0]].Name.c_str());
+            m_systems[stage[0]].Update(world);
+        }
+        else
+        {
+            Concurrency::parallel_for_each(stage.begin(), stage.end(), [this, &world](unsigned int s)
+            {
+                ProfileScope scope(m_systems[s].Name.c_str());
+                m_systems[s].Update(world);
+            });
+        }
+    }
+}
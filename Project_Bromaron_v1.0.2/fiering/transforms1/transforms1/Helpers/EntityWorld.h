@@ -0,0 +1,271 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <stdint.h>
+#include <string.h>
+#include "MemoryArena.h"
+
+namespace DirectXGame2
+{
+    //
+    // ** Component type registration **
+    //
+
+    // Maximum number of distinct component types. Component sets are stored
+    // as a 64-bit mask, one bit per registered type.
+#define MAX_COMPONENT_TYPES             64
+
+    // Size of one block of component storage.
+#define ENTITY_CHUNK_BYTES              (16 * 1024)
+
+    // Chunks are taken from a block pool in pages of this many.
+#define ENTITY_CHUNKS_PER_PAGE          8
+
+    // Index value for handles that do not refer to a live entity.
+#define INVALID_ENTITY_INDEX            0xFFFFFFFF
+
+    // Offset value for component types an archetype does not contain.
+#define INVALID_COMPONENT_OFFSET        0xFFFFFFFF
+
+    typedef uint64_t ComponentMask;
+
+    struct ComponentTypeInfo
+    {
+        size_t Size;
+        size_t Alignment;
+    };
+
+    // Registers a component type and returns its id. Called once per type by ComponentTypeId<T>().
+    unsigned int RegisterComponentType(size_t size, size_t alignment);
+    const ComponentTypeInfo& GetComponentTypeInfo(unsigned int typeId);
+
+    // Returns the id of component type T. Components must be plain data: they
+    // are moved between rows with memcpy and never have destructors run.
+    // NOTE: Register all component types from one thread before running systems in parallel.
+    template<typename T>
+    unsigned int ComponentTypeId()
+    {
+        static const unsigned int typeId = RegisterComponentType(sizeof(T), __alignof(T));
+        return typeId;
+    }
+
+    // Builds the mask for a list of component types, e.g. ComponentMaskOf<Pose, Spin>().
+    template<typename... Ts> struct ComponentMaskBuilder;
+
+    template<> struct ComponentMaskBuilder<>
+    {
+        static ComponentMask Get() { return 0; }
+    };
+
+    template<typename T, typename... Rest> struct ComponentMaskBuilder<T, Rest...>
+    {
+        static ComponentMask Get() { return (static_cast<ComponentMask>(1) << ComponentTypeId<T>()) | ComponentMaskBuilder<Rest...>::Get(); }
+    };
+
+    template<typename... Ts>
+    ComponentMask ComponentMaskOf()
+    {
+        return ComponentMaskBuilder<Ts...>::Get();
+    }
+
+    // Handle to an entity. The generation detects handles to destroyed entities.
+    struct Entity
+    {
+        unsigned int Index;
+        unsigned int Generation;
+
+        Entity() : Index(INVALID_ENTITY_INDEX), Generation(0) {}
+        Entity(unsigned int index, unsigned int generation) : Index(index), Generation(generation) {}
+    };
+
+    //
+    // The EntityWorld class stores entities by archetype.
+    //
+    // Every distinct set of component types is an archetype. An archetype owns
+    // fixed-size chunks, and each chunk stores one tightly packed array per
+    // component type (structure of arrays), so iterating a component tuple
+    // walks linear memory. All chunks of an archetype except the last are
+    // always full; destroying an entity moves the archetype's last row into
+    // the hole.
+    //
+    // Usage:
+    // 1. Create: Entity e = world.CreateEntity(Pose(...), Spin(...));
+    // 2. Iterate: world.ForEach<Pose, Spin>([](Pose& pose, Spin& spin) { ... });
+    // 3. Access one entity: Pose* pose = world.GetComponent<Pose>(e);
+    //
+    // Component pointers are only valid until the next structural change
+    // (create or destroy). Structural changes must not happen while systems
+    // run in parallel.
+    //
+    class EntityWorld
+    {
+    public:
+        EntityWorld();
+        ~EntityWorld();
+
+        template<typename... Ts>
+        Entity CreateEntity(const Ts&... components)
+        {
+            Archetype* archetype = FindOrCreateArchetype(ComponentMaskOf<Ts...>());
+            unsigned int chunk, row;
+            Entity entity = AllocateRow(archetype, chunk, row);
+
+            CopyComponents(archetype, archetype->Chunks[chunk], row, components...);
+
+            return entity;
+        }
+
+        void DestroyEntity(Entity entity);
+        void Clear();
+
+        bool IsAlive(Entity entity) const;
+        unsigned int GetEntityCount() const { return m_liveEntities; }
+
+        // Returns nullptr if the entity is dead or lacks the component.
+        template<typename T>
+        T* GetComponent(Entity entity)
+        {
+            if (!IsAlive(entity)) return nullptr;
+
+            const EntityRecord& record = m_records[entity.Index];
+            unsigned int offset = record.Owner->Offsets[ComponentTypeId<T>()];
+
+            if (offset == INVALID_COMPONENT_OFFSET) return nullptr;
+
+            return reinterpret_cast<T*>(record.Owner->Chunks[record.Chunk] + offset) + record.Row;
+        }
+
+        // Calls func(Ts&...) for every entity that has all of the listed components.
+        template<typename... Ts, typename TFunc>
+        void ForEach(const TFunc& func)
+        {
+            ComponentMask mask = ComponentMaskOf<Ts...>();
+
+            for (unsigned int a = 0; a < m_archetypes.size(); a++)
+            {
+                Archetype* archetype = m_archetypes[a];
+
+                if ((archetype->Mask & mask) != mask) continue;
+
+                for (unsigned int c = 0; c < archetype->Chunks.size(); c++)
+                {
+                    unsigned char* chunk = archetype->Chunks[c];
+                    ForEachRow(func, archetype->ChunkCounts[c], GetArray<Ts>(archetype, chunk)...);
+                }
+            }
+        }
+
+    private:
+        struct Archetype
+        {
+            ComponentMask                   Mask;
+            unsigned int                    Capacity;                       // Rows per chunk.
+            unsigned int                    Offsets[MAX_COMPONENT_TYPES];   // Byte offset of each component array in a chunk.
+            std::vector<unsigned int>       TypeIds;                        // Component types present, ascending.
+            std::vector<unsigned char*>     Chunks;
+            std::vector<unsigned int>       ChunkCounts;                    // Rows used in each chunk.
+        };
+
+        struct EntityRecord
+        {
+            Archetype*      Owner;
+            unsigned int    Chunk;
+            unsigned int    Row;
+            unsigned int    Generation;
+        };
+
+        Archetype* FindOrCreateArchetype(ComponentMask mask);
+        Entity AllocateRow(Archetype* archetype, unsigned int& chunk, unsigned int& row);
+
+        // The entity index array sits at the start of every chunk.
+        static unsigned int* GetEntityIndices(unsigned char* chunk) { return reinterpret_cast<unsigned int*>(chunk); }
+
+        template<typename T>
+        static T* GetArray(Archetype* archetype, unsigned char* chunk)
+        {
+            return reinterpret_cast<T*>(chunk + archetype->Offsets[ComponentTypeId<T>()]);
+        }
+
+        static void CopyComponents(Archetype*, unsigned char*, unsigned int)
+        {
+        }
+
+        template<typename T, typename... Rest>
+        static void CopyComponents(Archetype* archetype, unsigned char* chunk, unsigned int row, const T& component, const Rest&... rest)
+        {
+            memcpy(GetArray<T>(archetype, chunk) + row, &component, sizeof(T));
+            CopyComponents(archetype, chunk, row, rest...);
+        }
+
+        template<typename TFunc, typename... Ps>
+        static void ForEachRow(const TFunc& func, unsigned int count, Ps*... arrays)
+        {
+            for (unsigned int i = 0; i < count; i++)
+            {
+                func(arrays[i]...);
+            }
+        }
+
+        std::vector<Archetype*>         m_archetypes;
+        // Records and chunks are charged to MEMORY_TAG_SCENE.
+        std::vector<EntityRecord, TrackingAllocator<EntityRecord, MEMORY_TAG_SCENE>>    m_records;
+        std::vector<unsigned int, TrackingAllocator<unsigned int, MEMORY_TAG_SCENE>>    m_freeRecords;
+        unsigned int                    m_liveEntities;
+        BlockPool                       m_chunkPool;
+
+        EntityWorld(const EntityWorld&);
+        EntityWorld& operator=(const EntityWorld&);
+    };
+
+    //
+    // The EntitySystemScheduler class runs systems over an EntityWorld.
+    //
+    // Each system declares the component types it reads and writes. Systems
+    // are grouped into stages in registration order: a system joins the stage
+    // after the last one holding a system it conflicts with (a write against a
+    // read or write of the same type). Systems within a stage run in parallel
+    // on the PPL thread pool; stages run one after another, so conflicting
+    // systems still observe registration order.
+    //
+    class EntitySystemScheduler
+    {
+    public:
+        EntitySystemScheduler();
+
+        void AddSystem(
+            _In_z_ const char* name,
+            ComponentMask reads,
+            ComponentMask writes,
+            std::function<void(EntityWorld&)> update
+            );
+        void Clear();
+
+        void Run(EntityWorld& world);
+
+        unsigned int GetStageCount()                { BuildStages(); return static_cast<unsigned int>(m_stages.size()); }
+
+    private:
+        struct EntitySystem
+        {
+            std::string                         Name;
+            ComponentMask                       Reads;
+            ComponentMask                       Writes;
+            std::function<void(EntityWorld&)>   Update;
+        };
+
+        void BuildStages();
+
+        std::vector<EntitySystem>                   m_systems;
+        std::vector<std::vector<unsigned int>>      m_stages;
+        bool                                        m_stagesDirty;
+    };
+}
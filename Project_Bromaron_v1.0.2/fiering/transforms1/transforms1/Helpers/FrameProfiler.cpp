@@ -0,0 +1,298 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+
+using namespace DirectXGame2;
+
+namespace DirectXGame2
+{
+    // A ring entry. The fields are atomic because CollectEvents copies slots
+    // the owning thread may be overwriting; it finds and drops those copies
+    // afterwards. Relaxed loads and stores are plain moves on x86/x64.
+    struct ProfilerSlot
+    {
+        std::atomic<const char*>        Name;
+        std::atomic<unsigned __int64>   Begin;
+        std::atomic<unsigned __int64>   End;
+        std::atomic<unsigned int>       Depth;
+    };
+
+    struct ProfilerThreadBuffer
+    {
+        ProfilerSlot                Events[PROFILER_EVENTS_PER_THREAD];
+        std::atomic<unsigned int>   Count;      // Total events ever recorded; the ring index is Count % size.
+        std::atomic<unsigned int>   ResetAt;    // Count at the last Reset(); readers skip anything older.
+        unsigned int                ThreadId;
+    };
+}
+
+namespace
+{
+    // Buffers are never freed: a thread can exit while its events are still
+    // wanted for a trace, and the thread count is small and bounded.
+    ProfilerThreadBuffer*           g_threadBuffers[PROFILER_MAX_THREADS];
+    std::atomic<unsigned int>       g_threadCount(0);
+    std::mutex                      g_registerMutex;
+
+    __declspec(thread) ProfilerThreadBuffer*    t_threadBuffer = nullptr;
+    __declspec(thread) unsigned int             t_depth = 0;
+
+    // Reference points for converting ticks to time.
+    struct ClockOrigin
+    {
+        unsigned __int64    Ticks;
+        LARGE_INTEGER       Qpc;
+        LARGE_INTEGER       QpcFrequency;
+
+        ClockOrigin()
+        {
+            QueryPerformanceFrequency(&QpcFrequency);
+            QueryPerformanceCounter(&Qpc);
+            Ticks = FrameProfiler::ReadTicks();
+        }
+    };
+
+    ClockOrigin g_origin;
+}
+
+ProfilerThreadBuffer* FrameProfiler::GetThreadBuffer()
+{
+    if (t_threadBuffer != nullptr)
+    {
+        return t_threadBuffer;
+    }
+
+    std::lock_guard<std::mutex> lock(g_registerMutex);
+
+    unsigned int index = g_threadCount;
+    if (index >= PROFILER_MAX_THREADS)
+    {
+        return nullptr;
+    }
+
+    ProfilerThreadBuffer* buffer = new ProfilerThreadBuffer();
+    buffer->Count = 0;
+    buffer->ResetAt = 0;
+    buffer->ThreadId = GetCurrentThreadId();
+
+    g_threadBuffers[index] = buffer;
+    g_threadCount = index + 1;
+    t_threadBuffer = buffer;
+
+    return buffer;
+}
+
+unsigned int& FrameProfiler::ThreadDepth()
+{
+    return t_depth;
+}
+
+void FrameProfiler::Record(const char* name, unsigned __int64 begin, unsigned __int64 end, unsigned int depth)
+{
+    ProfilerThreadBuffer* buffer = GetThreadBuffer();
+    if (buffer == nullptr) return;
+
+    unsigned int count = buffer->Count.load(std::memory_order_relaxed);
+    ProfilerSlot& slot = buffer->Events[count & (PROFILER_EVENTS_PER_THREAD - 1)];
+
+    // Pairs with the fence in CollectEvents: a reader that sees any of the
+    // stores below also sees Count at least at count, and drops the slot.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.Name.store(name, std::memory_order_relaxed);
+    slot.Begin.store(begin, std::memory_order_relaxed);
+    slot.End.store(end, std::memory_order_relaxed);
+    slot.Depth.store(depth, std::memory_order_relaxed);
+
+    buffer->Count.store(count + 1, std::memory_order_release);
+}
+
+double FrameProfiler::GetTicksPerSecond()
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    LARGE_INTEGER qpc;
+    QueryPerformanceCounter(&qpc);
+    unsigned __int64 ticks = ReadTicks();
+
+    double seconds = static_cast<double>(qpc.QuadPart - g_origin.Qpc.QuadPart) / g_origin.QpcFrequency.QuadPart;
+    if (seconds <= 0.0)
+    {
+        return static_cast<double>(g_origin.QpcFrequency.QuadPart);
+    }
+
+    return static_cast<double>(ticks - g_origin.Ticks) / seconds;
+#else
+    return static_cast<double>(g_origin.QpcFrequency.QuadPart);
+#endif
+}
+
+void FrameProfiler::CollectEvents(std::vector<ProfileEvent>* events, std::vector<unsigned int>* threadIds)
+{
+    events->clear();
+    threadIds->clear();
+
+    unsigned int threadCount = g_threadCount;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        ProfilerThreadBuffer* buffer = g_threadBuffers[t];
+        unsigned int count = buffer->Count.load(std::memory_order_acquire);
+        unsigned int recorded = count - buffer->ResetAt.load(std::memory_order_acquire);
+        unsigned int available = (recorded < PROFILER_EVENTS_PER_THREAD) ? recorded : PROFILER_EVENTS_PER_THREAD;
+
+        size_t first = events->size();
+        for (unsigned int i = count - available; i != count; i++)
+        {
+            const ProfilerSlot& slot = buffer->Events[i & (PROFILER_EVENTS_PER_THREAD - 1)];
+
+            ProfileEvent profileEvent;
+            profileEvent.Name = slot.Name.load(std::memory_order_relaxed);
+            profileEvent.Begin = slot.Begin.load(std::memory_order_relaxed);
+            profileEvent.End = slot.End.load(std::memory_order_relaxed);
+            profileEvent.Depth = slot.Depth.load(std::memory_order_relaxed);
+            events->push_back(profileEvent);
+        }
+
+        // The owning thread may have kept recording during the copy. Event i's
+        // slot is reused by event i + PROFILER_EVENTS_PER_THREAD, which is written
+        // while Count still equals that number, so any copied event with
+        // i + PROFILER_EVENTS_PER_THREAD <= Count now may be torn; drop those.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        unsigned int newCount = buffer->Count.load(std::memory_order_relaxed);
+        unsigned int overwritten = newCount - (count - available);
+        overwritten = (overwritten >= PROFILER_EVENTS_PER_THREAD) ? overwritten - PROFILER_EVENTS_PER_THREAD + 1 : 0;
+        overwritten = (overwritten < available) ? overwritten : available;
+
+        events->erase(events->begin() + first, events->begin() + first + overwritten);
+        threadIds->resize(events->size(), buffer->ThreadId);
+    }
+}
+
+void FrameProfiler::GetSummary(std::vector<ProfileScopeSummary>* summary)
+{
+    std::vector<ProfileEvent> events;
+    std::vector<unsigned int> threadIds;
+    CollectEvents(&events, &threadIds);
+
+    std::map<const char*, std::vector<unsigned __int64>> durations;
+    for (unsigned int i = 0; i < events.size(); i++)
+    {
+        durations[events[i].Name].push_back(events[i].End - events[i].Begin);
+    }
+
+    double millisecondsPerTick = 1000.0 / GetTicksPerSecond();
+
+    summary->clear();
+    for (auto iter = durations.begin(); iter != durations.end(); iter++)
+    {
+        std::vector<unsigned __int64>& samples = iter->second;
+        std::sort(samples.begin(), samples.end());
+
+        unsigned __int64 total = 0;
+        for (unsigned int i = 0; i < samples.size(); i++)
+        {
+            total += samples[i];
+        }
+
+        ProfileScopeSummary scope;
+        scope.Name = iter->first;
+        scope.Count = static_cast<unsigned int>(samples.size());
+        scope.MeanMilliseconds = (static_cast<double>(total) / samples.size()) * millisecondsPerTick;
+        scope.P99Milliseconds = samples[(samples.size() - 1) * 99 / 100] * millisecondsPerTick;
+        scope.MaxMilliseconds = samples.back() * millisecondsPerTick;
+
+        summary->push_back(scope);
+    }
+
+    // Most expensive scopes first.
+    std::sort(summary->begin(), summary->end(), [](const ProfileScopeSummary& a, const ProfileScopeSummary& b)
+    {
+        return a.MeanMilliseconds * a.Count > b.MeanMilliseconds * b.Count;
+    });
+}
+
+std::string FrameProfiler::ExportChromeTrace()
+{
+    std::vector<ProfileEvent> events;
+    std::vector<unsigned int> threadIds;
+    CollectEvents(&events, &threadIds);
+
+    double microsecondsPerTick = 1000000.0 / GetTicksPerSecond();
+    std::string json = "{\"traceEvents\":[";
+    char line[256];
+
+    for (unsigned int i = 0; i < events.size(); i++)
+    {
+        const ProfileEvent& profileEvent = events[i];
+        double start = (profileEvent.Begin - g_origin.Ticks) * microsecondsPerTick;
+        double duration = (profileEvent.End - profileEvent.Begin) * microsecondsPerTick;
+
+        sprintf_s(
+            line,
+            "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+            (i == 0) ? "" : ",\n",
+            profileEvent.Name,
+            start,
+            duration,
+            threadIds[i]
+            );
+        json += line;
+    }
+
+    json += "],\"displayTimeUnit\":\"ms\"}";
+
+    return json;
+}
+
+bool FrameProfiler::WriteChromeTrace(const std::wstring& path)
+{
+    std::string json = ExportChromeTrace();
+
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, path.c_str(), L"wb") != 0 || file == nullptr)
+    {
+        return false;
+    }
+
+    size_t written = fwrite(json.data(), 1, json.size(), file);
+    fclose(file);
+
+    return written == json.size();
+}
+
+double FrameProfiler::MeasureScopeOverhead(unsigned int iterations)
+{
+    unsigned __int64 start = ReadTicks();
+
+    for (unsigned int i = 0; i < iterations; i++)
+    {
+        ProfileScope scope("ProfilerOverhead");
+    }
+
+    unsigned __int64 elapsed = ReadTicks() - start;
+
+    Reset();
+
+    return (static_cast<double>(elapsed) / iterations) * (1000000000.0 / GetTicksPerSecond());
+}
+
+void FrameProfiler::Reset()
+{
+    // Count belongs to the recording thread, so rather than clearing it
+    // (and racing a Record() in flight) move the point readers start from.
+    unsigned int threadCount = g_threadCount;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        ProfilerThreadBuffer* buffer = g_threadBuffers[t];
+        buffer->ResetAt.store(buffer->Count.load(std::memory_order_acquire), std::memory_order_release);
+    }
+}
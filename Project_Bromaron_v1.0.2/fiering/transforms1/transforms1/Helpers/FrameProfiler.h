@@ -0,0 +1,149 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#endif
+
+// Scoped CPU timers. On by default; define PROFILER_ENABLED to 0 in the
+// project settings to compile every PROFILE_SCOPE out.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED                1
+#endif
+
+namespace DirectXGame2
+{
+    // Events kept per thread. Must be a power of two; the oldest events are
+    // overwritten once a thread's ring is full.
+#define PROFILER_EVENTS_PER_THREAD      16384
+
+    // Maximum number of threads that can record events.
+#define PROFILER_MAX_THREADS            32
+
+    // One completed scope.
+    struct ProfileEvent
+    {
+        const char*         Name;
+        unsigned __int64    Begin;
+        unsigned __int64    End;
+        unsigned int        Depth;
+    };
+
+    // Per-thread event ring. Defined in FrameProfiler.cpp.
+    struct ProfilerThreadBuffer;
+
+    // Timing statistics for one scope name over the events currently recorded.
+    struct ProfileScopeSummary
+    {
+        const char*         Name;
+        unsigned int        Count;
+        double              MeanMilliseconds;
+        double              P99Milliseconds;
+        double              MaxMilliseconds;
+    };
+
+    //
+    // The FrameProfiler class collects scoped CPU timings.
+    //
+    // Each thread records into its own ring buffer, found through a
+    // thread-local pointer, so recording takes no locks. Timestamps come from
+    // the CPU time stamp counter on x86/x64 and from QueryPerformanceCounter
+    // elsewhere; the tick rate is calibrated against QPC when it is needed.
+    //
+    // Usage:
+    // 1. Time a block: { PROFILE_SCOPE("Render"); ... }
+    // 2. Read the results: GetSummary() for mean/p99/max per scope, or
+    //    ExportChromeTrace() for a file that chrome://tracing can load.
+    //
+    // Names must be string literals or otherwise outlive the profiler;
+    // only the pointer is stored.
+    //
+    class FrameProfiler
+    {
+    public:
+        static unsigned __int64 ReadTicks()
+        {
+#if defined(_M_IX86) || defined(_M_X64)
+            return __rdtsc();
+#else
+            LARGE_INTEGER counter;
+            QueryPerformanceCounter(&counter);
+            return counter.QuadPart;
+#endif
+        }
+
+        // Records a completed scope for the calling thread.
+        static void Record(const char* name, unsigned __int64 begin, unsigned __int64 end, unsigned int depth);
+
+        // Depth counter of the calling thread, used to nest scopes.
+        static unsigned int& ThreadDepth();
+
+        // Per-scope statistics over everything still in the ring buffers.
+        // Events recorded by other threads while this runs may be skipped.
+        static void GetSummary(_Out_ std::vector<ProfileScopeSummary>* summary);
+
+        // Chrome trace JSON ("traceEvents" array of complete events).
+        static std::string ExportChromeTrace();
+        static bool WriteChromeTrace(_In_ const std::wstring& path);
+
+        // Times a batch of empty scopes and returns the cost of one in
+        // nanoseconds. Drops all recorded events afterwards, so call it at startup.
+        static double MeasureScopeOverhead(unsigned int iterations = 10000);
+
+        // Drops all recorded events. Safe to call while other threads are
+        // recording; an event that completes during the call may survive it.
+        static void Reset();
+
+        static double GetTicksPerSecond();
+
+    private:
+        static ProfilerThreadBuffer* GetThreadBuffer();
+        static void CollectEvents(_Out_ std::vector<ProfileEvent>* events, _Out_ std::vector<unsigned int>* threadIds);
+    };
+
+    // Times the enclosing block. Use through PROFILE_SCOPE.
+    class ProfileScope
+    {
+    public:
+        ProfileScope(const char* name) :
+            m_name(name),
+            m_depth(FrameProfiler::ThreadDepth()++),
+            m_begin(FrameProfiler::ReadTicks())
+        {
+        }
+
+        ~ProfileScope()
+        {
+            unsigned __int64 end = FrameProfiler::ReadTicks();
+            FrameProfiler::ThreadDepth()--;
+            FrameProfiler::Record(m_name, m_begin, end, m_depth);
+        }
+
+    private:
+        const char*         m_name;
+        unsigned int        m_depth;
+        unsigned __int64    m_begin;
+
+        ProfileScope(const ProfileScope&);
+        ProfileScope& operator=(const ProfileScope&);
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b)      a##b
+#define PROFILE_CONCAT(a, b)            PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(name)             DirectXGame2::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -0,0 +1,368 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "GamepadPoller.h"
+
+#include <chrono>
+
+#if defined(_WIN32) && !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION   0x00000002
+#endif
+
+using namespace DirectXGame2;
+
+namespace
+{
+    //
+    // Sleeps the polling thread between polls.
+    //
+    // On Windows, std::this_thread::sleep_for rounds up to the system timer
+    // tick, 15.6 ms by default, which would hold a 1 kHz poller to about
+    // 64 Hz. A Store app can't raise the tick with timeBeginPeriod. So this
+    // waits on a high-resolution waitable timer, which Windows 10 1803 and
+    // later provide. Where there is none, it yields instead, and the poller
+    // keeps its rate at the cost of a busy core.
+    //
+    class PollTimer
+    {
+    public:
+        PollTimer()
+        {
+#if defined(_WIN32)
+            m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+        }
+
+        ~PollTimer()
+        {
+#if defined(_WIN32)
+            if (m_timer != nullptr)
+            {
+                CloseHandle(m_timer);
+            }
+#endif
+        }
+
+        // Waits for about ticks of a clock running at frequency.
+        void Wait(long long ticks, long long frequency)
+        {
+#if defined(_WIN32)
+            // Relative due times are negative, in 100 ns units.
+            LARGE_INTEGER dueTime;
+            dueTime.QuadPart = -(ticks * 10000000 / frequency);
+            if ((m_timer == nullptr) || (dueTime.QuadPart == 0) ||
+                !SetWaitableTimerEx(m_timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+            {
+                std::this_thread::yield();
+                return;
+            }
+
+            WaitForSingleObjectEx(m_timer, INFINITE, FALSE);
+#else
+            std::this_thread::sleep_for(std::chrono::microseconds(ticks * 1000000 / frequency));
+#endif
+        }
+
+    private:
+        PollTimer(const PollTimer&);
+        PollTimer& operator=(const PollTimer&);
+
+#if defined(_WIN32)
+        HANDLE  m_timer;
+#endif
+    };
+
+    bool IsSameState(const GamepadSample& a, const GamepadSample& b)
+    {
+        return (a.IsConnected == b.IsConnected) &&
+            (a.Buttons == b.Buttons) &&
+            (a.LeftTrigger == b.LeftTrigger) &&
+            (a.RightTrigger == b.RightTrigger) &&
+            (a.ThumbLX == b.ThumbLX) &&
+            (a.ThumbLY == b.ThumbLY) &&
+            (a.ThumbRX == b.ThumbRX) &&
+            (a.ThumbRY == b.ThumbRY);
+    }
+}
+
+#pragma region GamepadHistory
+
+GamepadHistory::GamepadHistory() :
+    m_count(0),
+    m_writing(0)
+{
+    for (unsigned int i = 0; i < GAMEPAD_HISTORY_SIZE; i++)
+    {
+        m_slots[i].Timestamp.store(0, std::memory_order_relaxed);
+        m_slots[i].Buttons.store(0, std::memory_order_relaxed);
+        m_slots[i].Thumbs.store(0, std::memory_order_relaxed);
+    }
+}
+
+void GamepadHistory::Push(const GamepadSample& sample)
+{
+    unsigned int index = m_count.load(std::memory_order_relaxed);
+
+    // Announce the overwrite before touching the slot. A reader that sees any
+    // of the new words below also sees this.
+    m_writing.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Slot& slot = m_slots[index % GAMEPAD_HISTORY_SIZE];
+    slot.Timestamp.store(static_cast<unsigned long long>(sample.Timestamp), std::memory_order_relaxed);
+    slot.Buttons.store(
+        static_cast<unsigned long long>(sample.Buttons) |
+        (static_cast<unsigned long long>(sample.LeftTrigger) << 16) |
+        (static_cast<unsigned long long>(sample.RightTrigger) << 24) |
+        (static_cast<unsigned long long>(sample.IsConnected ? 1 : 0) << 32),
+        std::memory_order_relaxed
+        );
+    slot.Thumbs.store(
+        static_cast<unsigned long long>(static_cast<unsigned short>(sample.ThumbLX)) |
+        (static_cast<unsigned long long>(static_cast<unsigned short>(sample.ThumbLY)) << 16) |
+        (static_cast<unsigned long long>(static_cast<unsigned short>(sample.ThumbRX)) << 32) |
+        (static_cast<unsigned long long>(static_cast<unsigned short>(sample.ThumbRY)) << 48),
+        std::memory_order_relaxed
+        );
+
+    m_count.store(index + 1, std::memory_order_release);
+}
+
+void GamepadHistory::Read(unsigned int index, GamepadSample* sample) const
+{
+    const Slot& slot = m_slots[index % GAMEPAD_HISTORY_SIZE];
+    unsigned long long buttons = slot.Buttons.load(std::memory_order_relaxed);
+    unsigned long long thumbs = slot.Thumbs.load(std::memory_order_relaxed);
+
+    sample->Timestamp = static_cast<long long>(slot.Timestamp.load(std::memory_order_relaxed));
+    sample->Buttons = static_cast<unsigned short>(buttons);
+    sample->LeftTrigger = static_cast<unsigned char>(buttons >> 16);
+    sample->RightTrigger = static_cast<unsigned char>(buttons >> 24);
+    sample->IsConnected = ((buttons >> 32) & 1) != 0;
+    sample->ThumbLX = static_cast<short>(static_cast<unsigned short>(thumbs));
+    sample->ThumbLY = static_cast<short>(static_cast<unsigned short>(thumbs >> 16));
+    sample->ThumbRX = static_cast<short>(static_cast<unsigned short>(thumbs >> 32));
+    sample->ThumbRY = static_cast<short>(static_cast<unsigned short>(thumbs >> 48));
+}
+
+bool GamepadHistory::GetLatest(GamepadSample* sample) const
+{
+    GamepadInterval interval;
+    if (!Query(0x7FFFFFFFFFFFFFFFLL, 0x7FFFFFFFFFFFFFFFLL, &interval))
+    {
+        return false;
+    }
+
+    *sample = interval.Latest;
+    return true;
+}
+
+bool GamepadHistory::Query(long long from, long long to, GamepadInterval* interval) const
+{
+    unsigned int count = m_count.load(std::memory_order_acquire);
+
+    // Copy samples newest first until reaching the one in effect at from.
+    // The oldest slot may be mid-overwrite, so it is never used.
+    GamepadSample samples[GAMEPAD_HISTORY_SIZE];
+    unsigned int oldest = (count >= GAMEPAD_HISTORY_SIZE) ? (count - GAMEPAD_HISTORY_SIZE + 1) : 0;
+    unsigned int first = count;
+    while (first > oldest)
+    {
+        first--;
+        GamepadSample& sample = samples[first % GAMEPAD_HISTORY_SIZE];
+        Read(first, &sample);
+        if (sample.Timestamp <= from)
+        {
+            break;
+        }
+    }
+
+    // Drop whatever the writer may have started overwriting meanwhile.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    unsigned int writing = m_writing.load(std::memory_order_relaxed);
+    if ((writing >= GAMEPAD_HISTORY_SIZE) && (first < writing - GAMEPAD_HISTORY_SIZE))
+    {
+        first = writing - GAMEPAD_HISTORY_SIZE;
+    }
+
+    // Ignore changes after the end of the interval.
+    unsigned int end = count;
+    while ((end > first) && (samples[(end - 1) % GAMEPAD_HISTORY_SIZE].Timestamp > to))
+    {
+        end--;
+    }
+
+    if (end <= first)
+    {
+        return false;
+    }
+
+    // The first sample is the state at from, or the oldest known if the
+    // history doesn't reach back that far.
+    const GamepadSample* previous = &samples[first % GAMEPAD_HISTORY_SIZE];
+
+    interval->Changed = previous->Timestamp > from;
+    interval->LastChange = previous->Timestamp;
+    interval->Pressed = 0;
+    interval->Released = 0;
+    interval->LeftTriggerPeak = previous->LeftTrigger;
+    interval->RightTriggerPeak = previous->RightTrigger;
+
+    double sumLX = 0.0, sumLY = 0.0, sumRX = 0.0, sumRY = 0.0;
+    long long time = from;
+
+    for (unsigned int index = first + 1; index < end; index++)
+    {
+        const GamepadSample* current = &samples[index % GAMEPAD_HISTORY_SIZE];
+        double held = static_cast<double>(current->Timestamp - time);
+
+        sumLX += previous->ThumbLX * held;
+        sumLY += previous->ThumbLY * held;
+        sumRX += previous->ThumbRX * held;
+        sumRY += previous->ThumbRY * held;
+        time = current->Timestamp;
+
+        interval->Changed = true;
+        interval->LastChange = current->Timestamp;
+        interval->Pressed |= current->Buttons & ~previous->Buttons;
+        interval->Released |= previous->Buttons & ~current->Buttons;
+        if (current->LeftTrigger > interval->LeftTriggerPeak)   interval->LeftTriggerPeak = current->LeftTrigger;
+        if (current->RightTrigger > interval->RightTriggerPeak) interval->RightTriggerPeak = current->RightTrigger;
+
+        previous = current;
+    }
+
+    interval->Latest = *previous;
+
+    if (to > from)
+    {
+        double held = static_cast<double>(to - time);
+        double span = static_cast<double>(to - from);
+        interval->ThumbLX = static_cast<float>((sumLX + previous->ThumbLX * held) / span);
+        interval->ThumbLY = static_cast<float>((sumLY + previous->ThumbLY * held) / span);
+        interval->ThumbRX = static_cast<float>((sumRX + previous->ThumbRX * held) / span);
+        interval->ThumbRY = static_cast<float>((sumRY + previous->ThumbRY * held) / span);
+    }
+    else
+    {
+        interval->ThumbLX = previous->ThumbLX;
+        interval->ThumbLY = previous->ThumbLY;
+        interval->ThumbRX = previous->ThumbRX;
+        interval->ThumbRY = previous->ThumbRY;
+    }
+
+    return true;
+}
+
+#pragma endregion
+
+#pragma region GamepadPoller
+
+GamepadPoller::GamepadPoller(std::unique_ptr<GamepadSource> source, unsigned int controllerCount) :
+    m_source(std::move(source)),
+    m_controllerCount((controllerCount < GAMEPAD_POLLER_MAX_CONTROLLERS) ? controllerCount : GAMEPAD_POLLER_MAX_CONTROLLERS),
+    m_stop(false),
+    m_pollRate(0)
+{
+    for (unsigned int i = 0; i < GAMEPAD_POLLER_MAX_CONTROLLERS; i++)
+    {
+        m_last[i] = GamepadSample();
+        m_hasLast[i] = false;
+    }
+}
+
+GamepadPoller::~GamepadPoller()
+{
+    Stop();
+}
+
+void GamepadPoller::Start(unsigned int pollsPerSecond)
+{
+    if (IsRunning() || (pollsPerSecond == 0))
+    {
+        return;
+    }
+
+    m_stop = false;
+    m_thread = std::thread(&GamepadPoller::Run, this, pollsPerSecond);
+}
+
+void GamepadPoller::Stop()
+{
+    if (!IsRunning())
+    {
+        return;
+    }
+
+    m_stop = true;
+    m_thread.join();
+}
+
+void GamepadPoller::Poll()
+{
+    for (unsigned int controller = 0; controller < m_controllerCount; controller++)
+    {
+        GamepadSample sample = GamepadSample();
+        sample.IsConnected = m_source->GetState(controller, &sample);
+        if (!sample.IsConnected)
+        {
+            sample = GamepadSample();
+        }
+
+        if (m_hasLast[controller] && IsSameState(sample, m_last[controller]))
+        {
+            continue;
+        }
+
+        sample.Timestamp = m_source->GetTimestamp();
+        m_history[controller].Push(sample);
+        m_last[controller] = sample;
+        m_hasLast[controller] = true;
+    }
+}
+
+void GamepadPoller::Run(unsigned int pollsPerSecond)
+{
+    const long long frequency = m_source->GetTimestampFrequency();
+    const long long period = (frequency > pollsPerSecond) ? (frequency / pollsPerSecond) : 1;
+
+    PollTimer timer;
+    long long next = m_source->GetTimestamp();
+    long long rateStart = next;
+    unsigned int ratePolls = 0;
+
+    while (!m_stop)
+    {
+        long long now = m_source->GetTimestamp();
+        if (now < next)
+        {
+            timer.Wait(next - now, frequency);
+            continue;
+        }
+
+        // Running late. Skip the missed polls rather than bunching them up.
+        if (now - next > period)
+        {
+            next = now;
+        }
+
+        Poll();
+        next += period;
+
+        // Publish the achieved rate once a second.
+        ratePolls++;
+        if (now - rateStart >= frequency)
+        {
+            m_pollRate = static_cast<unsigned int>(ratePolls * frequency / (now - rateStart));
+            rateStart = now;
+            ratePolls = 0;
+        }
+    }
+}
+
+#pragma endregion
@@ -0,0 +1,166 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace DirectXGame2
+{
+    // Controllers a poller samples.
+#define GAMEPAD_POLLER_MAX_CONTROLLERS  4
+
+    // State changes kept per controller. At most one change is recorded per
+    // poll, so at 1000 polls a second this covers at least a quarter second.
+#define GAMEPAD_HISTORY_SIZE            256
+
+    // Default polls per second.
+#define GAMEPAD_POLLER_DEFAULT_RATE     1000
+
+    // One controller state, laid out like XINPUT_GAMEPAD.
+    struct GamepadSample
+    {
+        long long       Timestamp;      // When the state was first seen, in source ticks.
+        bool            IsConnected;
+        unsigned short  Buttons;        // XINPUT_GAMEPAD_* bits.
+        unsigned char   LeftTrigger;
+        unsigned char   RightTrigger;
+        short           ThumbLX;
+        short           ThumbLY;
+        short           ThumbRX;
+        short           ThumbRY;
+    };
+
+    // A controller's input over an interval of time.
+    struct GamepadInterval
+    {
+        GamepadSample   Latest;             // State at the end of the interval.
+        bool            Changed;            // Whether the state changed during the interval,
+        long long       LastChange;         // and when it last did.
+        unsigned short  Pressed;            // Buttons that went down during the interval,
+        unsigned short  Released;           // and buttons that came up, even if only briefly.
+        unsigned char   LeftTriggerPeak;    // Furthest each trigger was pulled.
+        unsigned char   RightTriggerPeak;
+        float           ThumbLX;            // Stick positions averaged over the interval,
+        float           ThumbLY;            // weighted by how long each was held.
+        float           ThumbRX;
+        float           ThumbRY;
+    };
+
+    //
+    // The GamepadSource class is where a GamepadPoller gets controller state
+    // and time from. The app reads XInput; tests can supply a synthetic source
+    // and drive the poller by hand.
+    //
+    class GamepadSource
+    {
+    public:
+        virtual ~GamepadSource() {}
+
+        // Reads the current state of a controller. Returns false, leaving
+        // sample undefined, if the controller isn't connected. Called only
+        // from the polling thread.
+        virtual bool GetState(unsigned int controller, GamepadSample* sample) = 0;
+
+        // Current time in ticks, and ticks per second.
+        virtual long long GetTimestamp() = 0;
+        virtual long long GetTimestampFrequency() = 0;
+    };
+
+    //
+    // The GamepadHistory class holds the recent state changes of one
+    // controller in a ring, written by the polling thread and read by the
+    // game thread without locks.
+    //
+    // Each sample is stored as three atomic words. A reader copies what it
+    // needs and then checks that the writer hasn't lapped it; samples it
+    // couldn't trust are dropped, as if they had aged out of the history.
+    //
+    class GamepadHistory
+    {
+    public:
+        GamepadHistory();
+
+        // Records a new state. Writer only; timestamps must not decrease.
+        void Push(const GamepadSample& sample);
+
+        // Newest state. Returns false if nothing has been recorded yet.
+        bool GetLatest(GamepadSample* sample) const;
+
+        // Summarizes the input over (from, to]. Changes after to are ignored,
+        // so a tick can be queried after it ended. Returns false if nothing
+        // had been recorded by then.
+        bool Query(long long from, long long to, GamepadInterval* interval) const;
+
+    private:
+        struct Slot
+        {
+            std::atomic<unsigned long long> Timestamp;
+            std::atomic<unsigned long long> Buttons;     // Buttons, triggers and the connected flag.
+            std::atomic<unsigned long long> Thumbs;
+        };
+
+        void Read(unsigned int index, GamepadSample* sample) const;
+
+        Slot                                m_slots[GAMEPAD_HISTORY_SIZE];
+        std::atomic<unsigned int>           m_count;        // Samples ever pushed; the newest is m_count - 1.
+        std::atomic<unsigned int>           m_writing;      // Raised before a slot is overwritten, so readers can tell.
+    };
+
+    //
+    // The GamepadPoller class samples controllers on its own thread at a
+    // fixed rate, so presses shorter than a frame and stick motion between
+    // frames are kept for the game thread to query over its exact tick.
+    //
+    // Only state changes are recorded; a controller held still costs
+    // nothing in the history.
+    //
+    // Usage:
+    // 1. GamepadPoller poller(std::move(source), controllerCount);
+    // 2. poller.Start(GAMEPAD_POLLER_DEFAULT_RATE);
+    // 3. Per tick: poller.GetHistory(controller).Query(tickStart, tickEnd, &interval);
+    // 4. Tests can skip Start and call Poll() directly.
+    //
+    class GamepadPoller
+    {
+    public:
+        GamepadPoller(std::unique_ptr<GamepadSource> source, unsigned int controllerCount);
+        ~GamepadPoller();
+
+        void Start(unsigned int pollsPerSecond);
+        void Stop();
+        bool IsRunning() const                  { return m_thread.joinable(); }
+
+        // Samples every controller once. Only call from one thread at a time,
+        // and not while the polling thread is running.
+        void Poll();
+
+        const GamepadHistory& GetHistory(unsigned int controller) const     { return m_history[controller]; }
+        unsigned int GetControllerCount() const                             { return m_controllerCount; }
+        long long GetTimestamp() const                                      { return m_source->GetTimestamp(); }
+
+        // Polls per second the thread actually managed over its last full second.
+        unsigned int GetPollRate() const                                    { return m_pollRate; }
+
+    private:
+        GamepadPoller(const GamepadPoller&);
+        GamepadPoller& operator=(const GamepadPoller&);
+
+        void Run(unsigned int pollsPerSecond);
+
+        std::unique_ptr<GamepadSource>  m_source;
+        unsigned int                    m_controllerCount;
+        GamepadHistory                  m_history[GAMEPAD_POLLER_MAX_CONTROLLERS];
+        GamepadSample                   m_last[GAMEPAD_POLLER_MAX_CONTROLLERS];     // Last state pushed, to skip repeats.
+        bool                            m_hasLast[GAMEPAD_POLLER_MAX_CONTROLLERS];
+        std::thread                     m_thread;
+        std::atomic<bool>               m_stop;
+        std::atomic<unsigned int>       m_pollRate;
+    };
+}
@@ -0,0 +1,153 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <atomic>
+
+namespace DirectXGame2
+{
+    // Bytes of padding kept between the producer and consumer indices so the
+    // two sides don't share a cache line.
+#define INPUT_EVENT_QUEUE_PADDING       64
+
+    //
+    // The InputEventQueue class is a bounded, lock-free multi-producer,
+    // single-consumer ring.
+    //
+    // Each slot carries a sequence number. A producer claims a slot by
+    // advancing the enqueue index with a compare-exchange, writes the value,
+    // then publishes it by bumping the slot's sequence. The consumer reads a
+    // slot once its sequence says it has been published, then hands the slot
+    // back to producers for the next lap around the ring.
+    //
+    // When the ring is full TryPush() fails and the event is counted in
+    // GetDroppedCount(); producers never block or wait on the consumer.
+    //
+    // Usage:
+    // 1. Producers (any thread): m_queue.TryPush(event);
+    // 2. Consumer (one thread): m_queue.Drain([](const Event& e) { ... });
+    //
+    template<typename T, unsigned int Capacity>
+    class InputEventQueue
+    {
+        static_assert((Capacity >= 2) && ((Capacity & (Capacity - 1)) == 0), "InputEventQueue capacity must be a power of two.");
+
+    public:
+        InputEventQueue() :
+            m_enqueueIndex(0),
+            m_droppedCount(0),
+            m_dequeueIndex(0)
+        {
+            for (unsigned int i = 0; i < Capacity; i++)
+            {
+                m_slots[i].Sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Adds an event. Safe to call from any number of threads at once.
+        // Returns false, and counts the event as dropped, if the ring is full.
+        bool TryPush(const T& value)
+        {
+            unsigned int index = m_enqueueIndex.load(std::memory_order_relaxed);
+            Slot* slot;
+
+            for (;;)
+            {
+                slot = &m_slots[index & (Capacity - 1)];
+                unsigned int sequence = slot->Sequence.load(std::memory_order_acquire);
+                int difference = static_cast<int>(sequence - index);
+
+                if (difference == 0)
+                {
+                    // The slot is free for this lap; try to claim it.
+                    if (m_enqueueIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    // The consumer hasn't released this slot yet: the ring is full.
+                    m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else
+                {
+                    // Another producer claimed the slot first.
+                    index = m_enqueueIndex.load(std::memory_order_relaxed);
+                }
+            }
+
+            slot->Value = value;
+            slot->Sequence.store(index + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Removes the oldest event. Must only be called from the consumer thread.
+        bool TryPop(T* value)
+        {
+            Slot& slot = m_slots[m_dequeueIndex & (Capacity - 1)];
+            unsigned int sequence = slot.Sequence.load(std::memory_order_acquire);
+
+            if (static_cast<int>(sequence - (m_dequeueIndex + 1)) < 0)
+            {
+                // Not published yet (or the ring is empty).
+                return false;
+            }
+
+            *value = slot.Value;
+            slot.Sequence.store(m_dequeueIndex + Capacity, std::memory_order_release);
+            m_dequeueIndex++;
+
+            return true;
+        }
+
+        // Pops and handles events in the order they were pushed. Stops after
+        // one ring's worth so that busy producers can't keep the consumer here
+        // forever. Returns the number of events handled.
+        template<typename Func>
+        unsigned int Drain(Func handler)
+        {
+            T value;
+            unsigned int count = 0;
+
+            while ((count < Capacity) && TryPop(&value))
+            {
+                handler(value);
+                count++;
+            }
+
+            return count;
+        }
+
+        // Total number of events rejected because the ring was full.
+        unsigned int GetDroppedCount() const    { return m_droppedCount.load(std::memory_order_relaxed); }
+
+        unsigned int GetCapacity() const        { return Capacity; }
+
+    private:
+        struct Slot
+        {
+            std::atomic<unsigned int>   Sequence;
+            T                           Value;
+        };
+
+        Slot                        m_slots[Capacity];
+
+        char                        m_padding0[INPUT_EVENT_QUEUE_PADDING];
+        std::atomic<unsigned int>   m_enqueueIndex;     // Shared by all producers.
+        std::atomic<unsigned int>   m_droppedCount;
+
+        char                        m_padding1[INPUT_EVENT_QUEUE_PADDING];
+        unsigned int                m_dequeueIndex;     // Owned by the consumer.
+
+        InputEventQueue(const InputEventQueue&);
+        InputEventQueue& operator=(const InputEventQueue&);
+    };
+}
@@ -0,0 +1,138 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "InputLatencyTracker.h"
+
+using namespace DirectXGame2;
+
+InputLatencyTracker::InputLatencyTracker(Clock clock, long long ticksPerSecond) :
+    m_clock(clock),
+    m_millisecondsPerTick(1000.0 / static_cast<double>(ticksPerSecond))
+{
+    Reset();
+}
+
+void InputLatencyTracker::RecordSimulation(long long eventTimestamp)
+{
+    // Skip inputs without a stamp, and stamps already counted on an earlier frame.
+    if (eventTimestamp == 0)
+    {
+        return;
+    }
+
+    // A held input is seen every tick, so it stays among the most recently
+    // used stamps; a new one takes the slot used longest ago.
+    m_useCount++;
+    unsigned int oldest = 0;
+    for (unsigned int i = 0; i < INPUT_LATENCY_RECENT_STAMPS; i++)
+    {
+        if (m_recentStamps[i] == eventTimestamp)
+        {
+            m_recentLastUse[i] = m_useCount;
+            return;
+        }
+
+        if (m_useCount - m_recentLastUse[i] > m_useCount - m_recentLastUse[oldest])
+        {
+            oldest = i;
+        }
+    }
+
+    m_recentStamps[oldest] = eventTimestamp;
+    m_recentLastUse[oldest] = m_useCount;
+
+    long long now = m_clock();
+    m_eventToSimulation.Add((now - eventTimestamp) * m_millisecondsPerTick);
+
+    if (m_pendingCount < INPUT_LATENCY_MAX_PENDING)
+    {
+        m_pendingSimulation[m_pendingCount++] = now;
+    }
+}
+
+void InputLatencyTracker::RecordSubmit()
+{
+    if (m_pendingCount == 0)
+    {
+        return;
+    }
+
+    long long now = m_clock();
+    for (unsigned int i = 0; i < m_pendingCount; i++)
+    {
+        m_simulationToSubmit.Add((now - m_pendingSimulation[i]) * m_millisecondsPerTick);
+    }
+
+    m_pendingCount = 0;
+}
+
+void InputLatencyTracker::GetEventToSimulation(InputLatencyStats* stats) const
+{
+    m_eventToSimulation.ToStats(stats);
+}
+
+void InputLatencyTracker::GetSimulationToSubmit(InputLatencyStats* stats) const
+{
+    m_simulationToSubmit.ToStats(stats);
+}
+
+void InputLatencyTracker::Reset()
+{
+    for (unsigned int i = 0; i < INPUT_LATENCY_RECENT_STAMPS; i++)
+    {
+        m_recentStamps[i] = 0;
+        m_recentLastUse[i] = 0;
+    }
+
+    m_useCount = 0;
+    m_pendingCount = 0;
+
+    Accumulator empty = {};
+    m_eventToSimulation = empty;
+    m_simulationToSubmit = empty;
+}
+
+double InputLatencyTracker::GetBucketLowerBound(unsigned int bucket)
+{
+    return (bucket == 0) ? 0.0 : static_cast<double>(1u << (bucket - 1));
+}
+
+void InputLatencyTracker::Accumulator::Add(double milliseconds)
+{
+    if (milliseconds < 0.0)
+    {
+        milliseconds = 0.0;
+    }
+
+    Count++;
+    TotalMilliseconds += milliseconds;
+    if (milliseconds > MaxMilliseconds)
+    {
+        MaxMilliseconds = milliseconds;
+    }
+
+    unsigned int bucket = 0;
+    while ((bucket < INPUT_LATENCY_BUCKETS - 1) && (milliseconds >= GetBucketLowerBound(bucket + 1)))
+    {
+        bucket++;
+    }
+
+    Histogram[bucket]++;
+}
+
+void InputLatencyTracker::Accumulator::ToStats(InputLatencyStats* stats) const
+{
+    stats->Count = Count;
+    stats->MeanMilliseconds = (Count > 0) ? (TotalMilliseconds / Count) : 0.0;
+    stats->MaxMilliseconds = MaxMilliseconds;
+
+    for (unsigned int b = 0; b < INPUT_LATENCY_BUCKETS; b++)
+    {
+        stats->Histogram[b] = Histogram[b];
+    }
+}
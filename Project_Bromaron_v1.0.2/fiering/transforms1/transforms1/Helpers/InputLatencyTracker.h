@@ -0,0 +1,99 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <functional>
+
+namespace DirectXGame2
+{
+    // Latency histogram. Bucket 0 counts samples under 1 ms, bucket n counts
+    // samples from 2^(n-1) to 2^n ms, and the last bucket counts everything above that.
+#define INPUT_LATENCY_BUCKETS           9
+
+    // Simulated inputs that can wait for the frame that submits them.
+#define INPUT_LATENCY_MAX_PENDING       32
+
+    // Stamps remembered as already counted. Must cover every input that can
+    // be held at once.
+#define INPUT_LATENCY_RECENT_STAMPS     32
+
+    struct InputLatencyStats
+    {
+        unsigned int        Count;
+        double              MeanMilliseconds;
+        double              MaxMilliseconds;
+        unsigned int        Histogram[INPUT_LATENCY_BUCKETS];
+    };
+
+    //
+    // The InputLatencyTracker class measures how long input takes to reach
+    // the simulation and then the GPU.
+    //
+    // Input events are stamped when they arrive. When the simulation acts on
+    // an input it passes the stamp to RecordSimulation(), which logs the
+    // event->sim latency. When the frame holding that simulation step has
+    // been submitted for rendering, RecordSubmit() logs sim->submit for every
+    // input simulated since the previous submit.
+    //
+    // Stamps and the clock share one time base, supplied by the caller, so a
+    // synthetic clock can drive the tracker in tests. The
+    // INPUT_LATENCY_RECENT_STAMPS most recently simulated stamps are
+    // remembered and not counted again, so an input that stays held across
+    // many frames is measured on the frame it was first simulated. Stamps may
+    // arrive in any order; an older input simulated after a newer one still
+    // counts.
+    //
+    // Not thread safe; call from the game loop thread.
+    //
+    class InputLatencyTracker
+    {
+    public:
+        typedef std::function<long long()> Clock;
+
+        InputLatencyTracker(Clock clock, long long ticksPerSecond);
+
+        // The simulation consumed input that arrived at eventTimestamp.
+        // A timestamp of 0 means the input has no arrival time and is ignored.
+        void RecordSimulation(long long eventTimestamp);
+
+        // The frame containing everything simulated so far has been submitted.
+        void RecordSubmit();
+
+        void GetEventToSimulation(InputLatencyStats* stats) const;
+        void GetSimulationToSubmit(InputLatencyStats* stats) const;
+
+        void Reset();
+
+        // Lower bound in milliseconds of a histogram bucket.
+        static double GetBucketLowerBound(unsigned int bucket);
+
+    private:
+        struct Accumulator
+        {
+            unsigned int    Count;
+            double          TotalMilliseconds;
+            double          MaxMilliseconds;
+            unsigned int    Histogram[INPUT_LATENCY_BUCKETS];
+
+            void Add(double milliseconds);
+            void ToStats(InputLatencyStats* stats) const;
+        };
+
+        Clock           m_clock;
+        double          m_millisecondsPerTick;
+        long long       m_recentStamps[INPUT_LATENCY_RECENT_STAMPS];
+        unsigned int    m_recentLastUse[INPUT_LATENCY_RECENT_STAMPS];
+        unsigned int    m_useCount;
+
+        long long       m_pendingSimulation[INPUT_LATENCY_MAX_PENDING];
+        unsigned int    m_pendingCount;
+
+        Accumulator     m_eventToSimulation;
+        Accumulator     m_simulationToSubmit;
+    };
+}
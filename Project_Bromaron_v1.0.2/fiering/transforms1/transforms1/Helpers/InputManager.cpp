@@ -12,6 +12,140 @@ using namespace DirectX;
 
 using namespace DirectXGame2;
 
+namespace
+{
+    // Action names used in binding files.
+    const ActionName PlayerActionNames[] =
+    {
+        { "NONE",               PLAYER_ACTION_TYPES::INPUT_NONE },
+        { "COORDINATES_ONLY",   PLAYER_ACTION_TYPES::INPUT_COORDINATES_ONLY },
+        { "MOVE",               PLAYER_ACTION_TYPES::INPUT_MOVE },
+        { "AIM",                PLAYER_ACTION_TYPES::INPUT_AIM },
+        { "FIRE",               PLAYER_ACTION_TYPES::INPUT_FIRE },
+        { "FIRE_UP",            PLAYER_ACTION_TYPES::INPUT_FIRE_UP },
+        { "FIRE_DOWN",          PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN },
+        { "FIRE_PRESSED",       PLAYER_ACTION_TYPES::INPUT_FIRE_PRESSED },
+        { "FIRE_RELEASED",      PLAYER_ACTION_TYPES::INPUT_FIRE_RELEASED },
+        { "JUMP",               PLAYER_ACTION_TYPES::INPUT_JUMP },
+        { "JUMP_UP",            PLAYER_ACTION_TYPES::INPUT_JUMP_UP },
+        { "JUMP_DOWN",          PLAYER_ACTION_TYPES::INPUT_JUMP_DOWN },
+        { "JUMP_PRESSED",       PLAYER_ACTION_TYPES::INPUT_JUMP_PRESSED },
+        { "JUMP_RELEASED",      PLAYER_ACTION_TYPES::INPUT_JUMP_RELEASED },
+        { "ACCEL",              PLAYER_ACTION_TYPES::INPUT_ACCEL },
+        { "BRAKE",              PLAYER_ACTION_TYPES::INPUT_BRAKE },
+        { "SELECT",             PLAYER_ACTION_TYPES::INPUT_SELECT },
+        { "START",              PLAYER_ACTION_TYPES::INPUT_START },
+        { "CANCEL",             PLAYER_ACTION_TYPES::INPUT_CANCEL },
+        { "EXIT",               PLAYER_ACTION_TYPES::INPUT_EXIT },
+        { "DIRECTIONAL",        PLAYER_ACTION_TYPES::INPUT_DIRECTIONAL },
+        { "WEAPON_ONE",         PLAYER_ACTION_TYPES::INPUT_WEAPON_ONE },
+        { "WEAPON_TWO",         PLAYER_ACTION_TYPES::INPUT_WEAPON_TWO },
+        { "WEAPON_THREE",       PLAYER_ACTION_TYPES::INPUT_WEAPON_THREE },
+    };
+
+    static_assert(PLAYER_ACTION_TYPES::INPUT_MAX <= ACTION_BINDING_MAX_ACTIONS, "Binding tables are too small for PLAYER_ACTION_TYPES.");
+    static_assert(XINPUT_MAX_CONTROLLERS <= GAMEPAD_POLLER_MAX_CONTROLLERS, "The gamepad poller can't sample every XInput controller.");
+
+    // Feeds XInput state and QueryPerformanceCounter time to the gamepad poller.
+    //
+    // XInputGetState on a slot with no controller in it can block for
+    // milliseconds, so a disconnected controller is only retried every
+    // XINPUT_CONTROLLER_ENUM_TIMEOUT ms. Used only from the polling thread.
+    class XInputGamepadSource : public GamepadSource
+    {
+    public:
+        XInputGamepadSource()
+        {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            m_frequency = frequency.QuadPart;
+
+            ZeroMemory(m_isConnected, sizeof(m_isConnected));
+            ZeroMemory(m_nextConnectionCheck, sizeof(m_nextConnectionCheck));
+        }
+
+        virtual bool GetState(unsigned int controller, GamepadSample* sample)
+        {
+            if (!m_isConnected[controller] && (GetTimestamp() < m_nextConnectionCheck[controller]))
+            {
+                return false;
+            }
+
+            XINPUT_STATE xInputState;
+            ZeroMemory(&xInputState, sizeof(XINPUT_STATE));
+
+            m_isConnected[controller] = (XInputGetState(controller, &xInputState) == ERROR_SUCCESS);
+            if (!m_isConnected[controller])
+            {
+                m_nextConnectionCheck[controller] = GetTimestamp() + m_frequency * XINPUT_CONTROLLER_ENUM_TIMEOUT / 1000;
+                return false;
+            }
+
+            sample->Buttons      = xInputState.Gamepad.wButtons;
+            sample->LeftTrigger  = xInputState.Gamepad.bLeftTrigger;
+            sample->RightTrigger = xInputState.Gamepad.bRightTrigger;
+            sample->ThumbLX      = xInputState.Gamepad.sThumbLX;
+            sample->ThumbLY      = xInputState.Gamepad.sThumbLY;
+            sample->ThumbRX      = xInputState.Gamepad.sThumbRX;
+            sample->ThumbRY      = xInputState.Gamepad.sThumbRY;
+            return true;
+        }
+
+        virtual long long GetTimestamp()
+        {
+            LARGE_INTEGER timestamp;
+            QueryPerformanceCounter(&timestamp);
+            return timestamp.QuadPart;
+        }
+
+        virtual long long GetTimestampFrequency()
+        {
+            return m_frequency;
+        }
+
+    private:
+        long long   m_frequency;
+        bool        m_isConnected[XINPUT_MAX_CONTROLLERS];
+        long long   m_nextConnectionCheck[XINPUT_MAX_CONTROLLERS];
+    };
+
+    // Seconds between checks of the binding file for changes.
+    const double BindingsPollSeconds = 1.0;
+
+    bool GetFileWriteTime(const std::wstring& path, ULONGLONG* writeTime)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+        {
+            return false;
+        }
+
+        *writeTime = (static_cast<ULONGLONG>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+        return true;
+    }
+
+    bool ReadTextFile(const std::wstring& path, std::string* text)
+    {
+        FILE* file = nullptr;
+        if (_wfopen_s(&file, path.c_str(), L"rb") != 0 || file == nullptr)
+        {
+            return false;
+        }
+
+        char buffer[4096];
+        size_t read;
+        text->clear();
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            text->append(buffer, read);
+        }
+
+        bool succeeded = ferror(file) == 0;
+        fclose(file);
+        return succeeded;
+    }
+}
+
 
 #pragma region InputManagerClass
 
@@ -25,25 +159,20 @@ using namespace DirectXGame2;
 // INPUT_DEVICE_ALL, meaning that the input manager will accept input from 
 // keyboard, mouse, XInput controllers, and the touch screen.
 InputManager::InputManager() :
-    m_inputTypeFilterMask(INPUT_DEVICE_TYPES::INPUT_DEVICE_ALL),
     m_controllersConnected(0),
-    m_playersConnected(0)
+    m_playersConnected(0),
+    m_bindings(new ActionBindings()),
+    m_bindingsSource(std::make_shared<BindingsSource>()),
+    m_bindingsPollSeconds(BindingsPollSeconds),
+    m_gamepadPoller(new GamepadPoller(std::unique_ptr<GamepadSource>(new XInputGamepadSource()), XINPUT_MAX_CONTROLLERS))
 {
-    // init vectors
-    m_pXInputActions        = new std::vector<XInputControllerAction>();
-    m_pTouchControlRegions  = new std::vector<TouchControlRegion>();
-
-    // init maps
-    m_pKeyboardActions          = new std::unordered_map<unsigned int, unsigned int>();
-    m_pMouseActions             = new std::unordered_map<unsigned int, PointerControllerAction>();
-    m_pMouseActionsLastFrame    = new std::unordered_map<unsigned int, PointerControllerAction>();
-    m_pTouchActions             = new std::unordered_map<unsigned int, PointerControllerAction>();
-    m_pTouchActionsLastFrame    = new std::unordered_map<unsigned int, PointerControllerAction>();
-    m_pTouchDownMap             = new std::unordered_map<unsigned int, XMFLOAT2>();
-
-    // Initialize the cache map of actions taken in the previous frame.
-    ZeroMemory(&m_actionsLastFrame, sizeof(bool) * XUSER_MAX_COUNT * PLAYER_ACTION_TYPES::INPUT_MAX);
-    ZeroMemory(&m_resolvedActionsThisFrame, sizeof(PlayerInputData) * XUSER_MAX_COUNT * PLAYER_ACTION_TYPES::INPUT_MAX);
+    m_translator.SetBindings(m_bindings.get());
+
+    // Load the bindings now so the first frame has them; later changes are picked up in the background.
+    m_bindingsSource->OverridePath = std::wstring(Windows::Storage::ApplicationData::Current->LocalFolder->Path->Data()) + L"\\bindings.txt";
+    m_bindingsSource->DefaultPath = std::wstring(Windows::ApplicationModel::Package::Current->InstalledLocation->Path->Data()) + L"\\Assets\\bindings.txt";
+    LoadBindings(m_bindingsSource.get());
+    ReloadBindingsIfChanged();
 
     // Initialize the class that can receive CoreWindow events.
     m_refWrapper = ref new InputManagerRefWrapper(
@@ -51,6 +180,11 @@ InputManager::InputManager() :
         std::mem_fn(&InputManager::OnPointerEvent),
         std::mem_fn(&InputManager::OnKeyEvent)
         );
+
+    // Sample the controllers between frames, so short presses and stick
+    // motion aren't lost at low frame rates.
+    m_lastXInputQuery = m_gamepadPoller->GetTimestamp();
+    m_gamepadPoller->Start(GAMEPAD_POLLER_DEFAULT_RATE);
 };
 
 // Constructor overload for InputManager that takes a device configuration
@@ -59,23 +193,12 @@ InputManager::InputManager(unsigned int inputDeviceConfigMask)
 {
     InputManager();
 
-    m_inputTypeFilterMask = (INPUT_DEVICE_TYPES)inputDeviceConfigMask;
+    m_translator.SetFilter((INPUT_DEVICE_TYPES)inputDeviceConfigMask);
 };
 
-// Destructor for this type. Destroys all allocated heap data (vectors/maps).
+// Destructor for this type.
 InputManager::~InputManager()
 {
-    // delete vectors
-    delete m_pXInputActions;
-    delete m_pTouchControlRegions;
-
-    // delete maps
-    delete m_pKeyboardActions;
-    delete m_pMouseActions;
-    delete m_pMouseActionsLastFrame;
-    delete m_pTouchActions;
-    delete m_pTouchActionsLastFrame;
-    delete m_pTouchDownMap;
 };
 
 // Call this method when initializing your game object to start processing 
@@ -118,255 +241,152 @@ void InputManager::Initialize(
 void InputManager::Update(DX::StepTimer const& timer)
 {
     m_timerSeconds = timer.GetElapsedSeconds();
-}
 
-// Public method that returns a vector of gameplay actions initiated by the 
-// player.
-std::vector<PlayerInputData> InputManager::GetPlayersActions()
-{
-    std::vector<PlayerInputData> playerActions;
-
-    // First, clear the map of current actions.
-    ZeroMemory(&m_actionsThisFrame, sizeof(bool) * XUSER_MAX_COUNT * PLAYER_ACTION_TYPES::INPUT_MAX);
-    
-    // Process the set of input data received since the last frame.
-    TranslateInputToPlayerActions(&playerActions);
-
-    // Return the input data.
-    return playerActions;
+    // Periodically look for an edited binding file, unless a check is already running.
+    m_bindingsPollSeconds -= m_timerSeconds;
+    if ((m_bindingsPollSeconds <= 0.0) && !m_bindingsSource->IsReloading.exchange(true))
+    {
+        m_bindingsPollSeconds = BindingsPollSeconds;
+
+        std::shared_ptr<BindingsSource> source = m_bindingsSource;
+        Windows::System::Threading::ThreadPool::RunAsync(
+            ref new Windows::System::Threading::WorkItemHandler(
+            [source](IAsyncAction^ workItem) {
+                LoadBindings(source.get());
+                source->IsReloading = false;
+        }),
+            Windows::System::Threading::WorkItemPriority::Low
+            );
+    }
 }
 
-// Private method that performs the translation of raw input maps to a vector 
-// of player gameplay actions. Converts the raw input lists into a single 
-// unified vector of player actions that are returned to the game proper.
-void InputManager::TranslateInputToPlayerActions(std::vector<PlayerInputData>* playerActions)
+// Compiles the binding file if it changed since it was last loaded, and
+// leaves the result in source->Pending. Called once from the constructor,
+// then only from the thread pool.
+void InputManager::LoadBindings(
+    _In_ BindingsSource* source
+    )
 {
-    if (playerActions == nullptr) return;
+    // The local copy wins whenever there is one.
+    std::wstring path = source->OverridePath;
+    ULONGLONG writeTime;
+    if (!GetFileWriteTime(path, &writeTime))
+    {
+        path = source->DefaultPath;
+        if (!GetFileWriteTime(path, &writeTime))
+        {
+            return;
+        }
+    }
 
-    // First process the XInput action vector.
-    if ((m_inputTypeFilterMask & INPUT_DEVICE_TYPES::INPUT_DEVICE_XINPUT) == INPUT_DEVICE_TYPES::INPUT_DEVICE_XINPUT)
+    if ((path == source->LoadedPath) && (writeTime == source->LoadedWriteTime))
     {
-        // Pull and process data from XInput.
-        UpdateXInputState();
-        TranslateXInputToPlayerActionMap();
+        return;
     }
 
-    // Lock the input event queues until we're done processing them.
-    std::lock_guard<std::mutex> lock(m_stateMutex);
+    source->LoadedPath = path;
+    source->LoadedWriteTime = writeTime;
 
-    // Now, process the Keyboard queue and update the action map.
-    if ((m_inputTypeFilterMask & INPUT_DEVICE_TYPES::INPUT_DEVICE_KEYBOARD) == INPUT_DEVICE_TYPES::INPUT_DEVICE_KEYBOARD)
+    std::string text;
+    if (!ReadTextFile(path, &text))
     {
-        // Process keyboard events received since the last frame.
-        TranslateKeyboardToPlayerActionsMap();
+        return;
     }
 
-    // Last, process the Pointer queue and update the action map (Mouse and Touch).
-    if ((m_inputTypeFilterMask & INPUT_DEVICE_TYPES::INPUT_DEVICE_TOUCH) == INPUT_DEVICE_TYPES::INPUT_DEVICE_TOUCH)
+    std::unique_ptr<ActionBindings> bindings(new ActionBindings());
+    std::string error;
+    if (!bindings->Compile(text, PlayerActionNames, ARRAYSIZE(PlayerActionNames), &error))
     {
-        // Process pointer events received since the last frame.
-        TranslateTouchPointerActionsToPlayerActionsMap();
-
-        // Process mouse events received since the last frame.
-        TranslateMousePointerActionsToPlayerActionsMap();
+        // Keep playing with the previous bindings until the file is fixed.
+        OutputDebugStringA(("bindings.txt " + error + "\n").c_str());
+        return;
     }
 
-    // Now, if the state for any of the digital controls changed since the last frame, set the appropriate transitory state.
-    AddTransitoryStatesToEventMap();
-
-    // Process the set of input states into the client code's vector.
-    ProcessStatesToPlayerActions(playerActions);
-    
-    // Store important data for detecting state transitions between frames.
-    UpdateLastFrameActionMap();
-
-    // Clear the raw input action vectors and internal input data state to prepare for the next frame.
-    ClearInputActions();
+    delete source->Pending.exchange(bindings.release());
 }
 
-// Adds a gameplay action to the vector returned by the input manager. This 
-// method checks for redundancy, and merges similar events obtained within 
-// the frame into each player's input state.
-void InputManager::AddPlayerActionToMap(
-    _In_  PlayerInputData * const playerInput
-    )
+// Switches to newly compiled bindings, if there are any. Game thread only.
+void InputManager::ReloadBindingsIfChanged()
 {
-    unsigned int idVal = playerInput->ID;
-    unsigned int actionVal = playerInput->PlayerAction;
-
-    if (m_actionsThisFrame[idVal][actionVal]) // action already taken this frame
+    ActionBindings* bindings = m_bindingsSource->Pending.exchange(nullptr);
+    if (bindings != nullptr)
     {
-        if ((playerInput->PlayerAction == INPUT_MOVE)  || (playerInput->PlayerAction == INPUT_AIM))
-        {
-            // Resolve move conflicts with XInput and Touch controller if default pointer player ID
-            // is the same as an attached XInput controller player ID.
-            float combinedInput = m_resolvedActionsThisFrame[idVal][actionVal].NormalizedInputValue + playerInput->NormalizedInputValue;
-
-            if (combinedInput > 1.0f) m_resolvedActionsThisFrame[idVal][actionVal].NormalizedInputValue = 1.0f; // ceiling combined positive input
-            else if (combinedInput < -1.0f) m_resolvedActionsThisFrame[idVal][actionVal].NormalizedInputValue = -1.0f; // floor combined negative input
-            else m_resolvedActionsThisFrame[idVal][actionVal].NormalizedInputValue = combinedInput; // add combined input to resolved actions map
-
-            float combinedInputX = m_resolvedActionsThisFrame[idVal][actionVal].X + playerInput->X;
-            if (combinedInputX > 1.0f) m_resolvedActionsThisFrame[idVal][actionVal].X = 1.0f; // ceiling combined positive X direction input
-            else if (combinedInputX < -1.0f) m_resolvedActionsThisFrame[idVal][actionVal].X = -1.0f; // floor combined negative X input
-            else m_resolvedActionsThisFrame[idVal][actionVal].X = combinedInputX; // add combined X direction input to resolved actions map
-
-            float combinedInputY = m_resolvedActionsThisFrame[idVal][actionVal].Y + playerInput->Y;
-            if (combinedInputY > 1.0f) m_resolvedActionsThisFrame[idVal][actionVal].Y = 1.0f; // ceiling combined positive Y direction input
-            else if (combinedInputY < -1.0f) m_resolvedActionsThisFrame[idVal][actionVal].Y = -1.0f; // floor combined negative Y input
-            else m_resolvedActionsThisFrame[idVal][actionVal].Y = combinedInputY; // add combined Y direction input to resolved actions map
-
-            if (playerInput->IsTouchAction)
-            {
-                m_resolvedActionsThisFrame[idVal][actionVal].PointerRawX   = playerInput->PointerRawX;
-                m_resolvedActionsThisFrame[idVal][actionVal].PointerRawY   = playerInput->PointerRawY;
-                m_resolvedActionsThisFrame[idVal][actionVal].PointerThrowX = playerInput->PointerThrowX;
-                m_resolvedActionsThisFrame[idVal][actionVal].PointerThrowY = playerInput->PointerThrowY;
-                m_resolvedActionsThisFrame[idVal][actionVal].IsTouchAction = true;
-            }
-        }
-    }
-    else
-    {
-        // since this input is new this frame there is no resolve action needed. Add directly to input map.
-        m_resolvedActionsThisFrame[idVal][actionVal] = *playerInput;
-        m_actionsThisFrame[idVal][actionVal] = true;
+        m_translator.SetBindings(bindings);
+        m_bindings.reset(bindings);
     }
 }
 
-// Perform a cleanup pass resolving all state transitions (PRESSED, RELEASED et al) within the action vector.
-void InputManager::ProcessStatesToPlayerActions(
-    _Inout_ std::vector<PlayerInputData>* playerActions
+// Public method that fills the caller's buffer with the gameplay actions
+// initiated by the players, and returns how many were written.
+unsigned int InputManager::GetPlayersActions(
+    _Out_writes_to_(capacity, return) PlayerInputData* playerActions,
+    _In_ unsigned int capacity
     )
 {
-    for (unsigned int idVal = 0; idVal < XUSER_MAX_COUNT; idVal++)
+    if (playerActions == nullptr) return 0;
+
+    ReloadBindingsIfChanged();
+
+    // Pull what the controllers did since the last frame from the gamepad poller.
+    if ((m_translator.GetFilter() & INPUT_DEVICE_TYPES::INPUT_DEVICE_XINPUT) == INPUT_DEVICE_TYPES::INPUT_DEVICE_XINPUT)
     {
-        for (unsigned int actionVal = 0; actionVal < PLAYER_ACTION_TYPES::INPUT_MAX; actionVal++)
-        {
-            // First, check if this a buttons state processing effort 
-            if (m_actionsThisFrame[idVal][actionVal])
-            {
-                playerActions->push_back(m_resolvedActionsThisFrame[idVal][actionVal]);
-            }
-        }
+        UpdateXInputState();
     }
-}
 
-// After the player gameplay inputs have been interpreted, update an internal map
-// so the next frame knows what was performed by the player in this frame.
-void InputManager::UpdateLastFrameActionMap()
-{    
-    // Store mouse pointer actions that occurred this frame.
-    if ((m_pMouseActions != nullptr) && (m_pMouseActions->size() > 0) && (m_pMouseActionsLastFrame != nullptr))
+    // Apply the keyboard and pointer events queued by the CoreWindow thread
+    // since the last frame. Events that arrive while this runs wait for the next frame.
+    m_eventQueue.Drain([this](const RawInputEvent& rawEvent)
     {
-        m_pMouseActionsLastFrame->clear();
+        m_translator.ApplyRawInputEvent(rawEvent);
+    });
 
-        auto iter = m_pMouseActions->begin();
-        while (iter != m_pMouseActions->end())
-        {
-            m_pMouseActionsLastFrame->emplace(std::pair<unsigned int, PointerControllerAction>(iter->first, iter->second));
-            ++iter;
-        }
-    }
+    // Process the set of input data received since the last frame.
+    unsigned int count = m_translator.Translate(playerActions, capacity);
 
-    // Store touch pointer actions that occurred this frame.
-    if ((m_pTouchActions != nullptr) && (m_pTouchActions->size() > 0) && (m_pTouchActionsLastFrame != nullptr))
+    // Keyboard and pointer input mark their default player as connected.
+    unsigned int activePlayers = m_translator.GetActivePlayers();
+    if ((activePlayers & ~m_playersConnected) != 0)
     {
-        m_pTouchActionsLastFrame->clear();
-
-        auto iter = m_pTouchActions->begin();
-        while (iter != m_pTouchActions->end())
-        {
-            m_pTouchActionsLastFrame->emplace(std::pair<unsigned int, PointerControllerAction>(iter->first, iter->second));
-            ++iter;
-        }
+        InterlockedOr16(&m_playersConnected, static_cast<short>(activePlayers));
     }
 
-    // Copy the map from the current frame to the last action frame before tick
-    CopyMemory(m_actionsLastFrame, m_actionsThisFrame, sizeof(bool) * XUSER_MAX_COUNT * PLAYER_ACTION_TYPES::INPUT_MAX);
+    return count;
 }
 
-// For each possible digital action, checks for a change in state between the 
-// previous frame and the current frame.
-void InputManager::AddTransitoryStatesToEventMap(void)
+//
+// Touch region methods
+//
+
+// Public method to set a touch region.
+// Note: maxLogicalSize SHOULD be set to m_deviceResources->GetLogicalSize().
+DWORD InputManager::SetDefinedTouchRegion(
+    _In_ const TouchControlRegion * newRegion,
+    _Out_ unsigned int& regionId
+    )
 {
+    return static_cast<DWORD>(m_translator.SetDefinedTouchRegion(newRegion, regionId));
+}
 
-    // Note that the input manager does not check analog actions for state 
-    // transitions. It is up to the game to account for (and respond to 
-    // changes) in analog state in a way that's appropriate for gameplay.
-    for (unsigned int idVal = 0; idVal < XUSER_MAX_COUNT; idVal++)
-    {
-        for (unsigned int actionVal = 0; actionVal < PLAYER_ACTION_TYPES::INPUT_MAX; actionVal++)
-        {
-            if (m_actionsLastFrame[idVal][actionVal] != m_actionsThisFrame[idVal][actionVal])
-            {
-                PLAYER_ACTION_TYPES action = PLAYER_ACTION_TYPES::INPUT_NONE;
-
-                switch ((PLAYER_ACTION_TYPES)actionVal)
-                {
-                case INPUT_FIRE_DOWN:
-                    if (m_actionsThisFrame[idVal][actionVal])
-                    {
-                        action = INPUT_FIRE_PRESSED;
-                    }
-                    else
-                    {
-                        action = INPUT_FIRE_RELEASED;
-                    }
-                    break;
-
-                case INPUT_JUMP_DOWN:
-                    if (m_actionsThisFrame[idVal][actionVal])
-                    {
-                        action = INPUT_JUMP_PRESSED;
-                    }
-                    else
-                    {
-                        action = INPUT_JUMP_RELEASED;
-                    }
-                    break;
-
-                default:
-                    break;
-                };
-
-                if (action != PLAYER_ACTION_TYPES::INPUT_NONE)
-                {
-                    PlayerInputData playerInput;
-
-                    playerInput.ID = idVal;
-                    playerInput.PlayerAction = action;
-                    playerInput.NormalizedInputValue = 1.0f;
-
-                    m_resolvedActionsThisFrame[idVal][static_cast<int>(action)] = playerInput;
-                    m_actionsThisFrame[idVal][static_cast<int>(action)] = true;
-                }
-            }
-        }
-    }
+void InputManager::ClearTouchRegions(void)
+{
+    m_translator.ClearTouchRegions();
 }
 
-// Clears the XInput raw input list, pointer input list, and any state variables that only count for a single frame.
-void InputManager::ClearInputActions()
+void InputManager::EnableTouchRegion(
+    _In_ unsigned int regionId
+    )
 {
-    // Clear the XInput input action vector.
-    if ((m_pXInputActions != nullptr) && (m_pXInputActions->size() > 0))
-    {
-        m_pXInputActions->clear();
-    }
+    m_translator.EnableTouchRegion(regionId);
+}
+
+void InputManager::DisableTouchRegion(
+    _In_ unsigned int regionId
+    )
+{
+    m_translator.DisableTouchRegion(regionId);
+}
 
-    // Clear the mouse pointer input action map. 
-    if ((m_pMouseActions != nullptr) && (m_pMouseActions->size() > 0))
-    {
-        m_pMouseActions->clear();
-    }
 
-    // Clear the touch pointer input action map. 
-    if ((m_pTouchActions != nullptr) && (m_pTouchActions->size() > 0))
-    {
-        m_pTouchActions->clear();
-    }
-};
 
 //
 // ** END INPUT PROCESSING METHODS **
@@ -380,47 +400,31 @@ void InputManager::ClearInputActions()
 //
 #pragma region XInputProcessingMethods
 
-// Checks the state of the XInput controllers and updates internal fields that 
-// represent controller connectivity and capabilities. This is called whenever 
-// the game loop requests the current input state.
+// Collects what each XInput controller did since the last call from the
+// gamepad poller and updates the fields that represent controller
+// connectivity. This is called whenever the game loop requests the current
+// input state.
 void InputManager::UpdateXInputState()
 {
+    // Each call covers the time since the previous one ended.
+    LONGLONG now = m_gamepadPoller->GetTimestamp();
+
     // Loop through all controllers.
     for (unsigned int controllerId = 0; controllerId < XINPUT_MAX_CONTROLLERS; controllerId++)
     {
-        unsigned int tmpId = controllerId;
-        unsigned short controllerIdBitFlag = 1 << tmpId;
-        
-        // Check whether the controller is known to be connected.
-        if (m_controllersConnected & controllerIdBitFlag)
-        {
-            XINPUT_STATE xInputState;
-            ZeroMemory(&xInputState, sizeof(XINPUT_STATE));
+        unsigned short controllerIdBitFlag = 1 << controllerId;
 
-            // If so, attempt to get the current controller state.
-            DWORD stateResult = XInputGetState(controllerId, &xInputState);
-
-            // Check whether the controller is still connected.
-            if (stateResult == ERROR_SUCCESS)
-            {
-                // If so, append the action to the vector.
-                XInputControllerAction controllerInput;
-                ZeroMemory(&controllerInput, sizeof(XInputControllerAction));
+        GamepadInterval interval;
+        bool isConnected =
+            m_gamepadPoller->GetHistory(controllerId).Query(m_lastXInputQuery, now, &interval) &&
+            interval.Latest.IsConnected;
 
-                // Set the player controller ID.
-                controllerInput.ControllerId = controllerId;
-
-                // Push the controller state onto the XInput input action vector.
-                // Note: State contains ALL actions for that controller received during poll.
-                controllerInput.State = xInputState;
-                m_pXInputActions->push_back(controllerInput);
-            }
-            else
+        if (!isConnected)
+        {
+            if (m_controllersConnected & controllerIdBitFlag)
             {
                 // Controller was disconnected. Ensure this player and this
                 // controller are marked inactive.
-                // m_controllersConnected ^= controllerIdBitFlag;
-                // m_playersConnected     ^= controllerIdBitFlag;
                 InterlockedXor16(&m_controllersConnected, controllerIdBitFlag);
                 InterlockedXor16(&m_playersConnected, controllerIdBitFlag);
 
@@ -430,240 +434,37 @@ void InputManager::UpdateXInputState()
                 // The next keyboard, mouse, or input event will mark player 1 
                 // as active again.
             }
-        }
-        else
-        {
-            m_lastTimeCheckedXInputConnection[controllerId] -= m_timerSeconds;
-
-            if (m_lastTimeCheckedXInputConnection[controllerId]  <= 0.f) 
-            {
-                int i = 1;
-                // If it's time to check whether the controller is connected, 
-                // check for XInput controller connection by trying to get 
-                // the capabilities.
-
-                // Use a separate thread. XInputGetCapabilities is a blocking operation 
-                // that is on the order of milliseconds to complete.
-                Windows::System::Threading::ThreadPool::RunAsync(
-                    ref new Windows::System::Threading::WorkItemHandler(
-                    [&, controllerIdBitFlag, controllerId](IAsyncAction^ workItem) {
-                        DWORD getCapsResult = XInputGetCapabilities(controllerId, XINPUT_FLAG_GAMEPAD, &m_xinputCapabilities[controllerId]);
-
-                        // If it is connected then store the result.
-                        if (getCapsResult == ERROR_SUCCESS)
-                        {
-                            // Ensure this player and controller are marked active.
-                            // m_controllersConnected |= controllerIdBitFlag;
-                            // m_playersConnected     |= controllerIdBitFlag;
-                            InterlockedOr16(&m_controllersConnected, controllerIdBitFlag);
-                            InterlockedOr16(&m_playersConnected, controllerIdBitFlag);
-                        }
-                }),
-                    Windows::System::Threading::WorkItemPriority::Normal
-                    );
-
-                // Start the timer for the next check.
-                m_lastTimeCheckedXInputConnection[controllerId] = XINPUT_CONTROLLER_ENUM_TIMEOUT/1000.f;
-            }
-        }
-    }
-}
-
-// Converts XInput controller input data to player gameplay actions.
-void InputManager::TranslateXInputToPlayerActionMap()
-{
-    // Interpret queues and add actions to playerActions queue.
-    for (unsigned int i = 0; i != m_pXInputActions->size(); i++)
-    {
-        // Set up a player input data structure.
-        PlayerInputData playerInput;
-        playerInput.ID = (PLAYER_ID) (*m_pXInputActions)[i].ControllerId;
-
-        /*
-        NOTE: The wButton bitmask is defined as follows (from XInput.h):
-
-        XINPUT_GAMEPAD_DPAD_UP          0x0001
-        XINPUT_GAMEPAD_DPAD_DOWN        0x0002
-        XINPUT_GAMEPAD_DPAD_LEFT        0x0004 
-        XINPUT_GAMEPAD_DPAD_RIGHT       0x0008
-        XINPUT_GAMEPAD_START            0x0010
-        XINPUT_GAMEPAD_BACK             0x0020
-        XINPUT_GAMEPAD_LEFT_THUMB       0x0040 -- l-stick click in
-        XINPUT_GAMEPAD_RIGHT_THUMB      0x0080 -- r-stick click in
-        XINPUT_GAMEPAD_LEFT_SHOULDER    0x0100
-        XINPUT_GAMEPAD_RIGHT_SHOULDER   0x0200
-        XINPUT_GAMEPAD_A                0x1000
-        XINPUT_GAMEPAD_B                0x2000
-        XINPUT_GAMEPAD_X                0x4000
-        XINPUT_GAMEPAD_Y                0x8000
-        */
-
-        // All digital inputs are set to a value of 1.0f for usage convenience.
-        
-        //
-        // NOTE TO DEVELOPER: The following section of code is where you add 
-        // or update behaviors for different XInput input actions. Use this 
-        // implementation as a template when adding your own behaviors.
-        //
-
-        // Handle button presses.
-
-        if ((*m_pXInputActions)[i].State.Gamepad.wButtons & XINPUT_GAMEPAD_START)
-        {
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_START;
-            playerInput.NormalizedInputValue = 1.0f;
-            AddPlayerActionToMap(&playerInput);
-        }
-
-        if ((*m_pXInputActions)[i].State.Gamepad.wButtons & XINPUT_GAMEPAD_BACK)
-        {
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_EXIT;
-            playerInput.NormalizedInputValue = 1.0f;
-            AddPlayerActionToMap(&playerInput);
-        }
-
-        if ((*m_pXInputActions)[i].State.Gamepad.wButtons & XINPUT_GAMEPAD_A)
-        {
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN;
-            playerInput.NormalizedInputValue = 1.0f;
-            AddPlayerActionToMap(&playerInput);
-        }
-
-        if ((*m_pXInputActions)[i].State.Gamepad.wButtons & XINPUT_GAMEPAD_B)
-        {
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_JUMP_DOWN;
-            playerInput.NormalizedInputValue = 1.0f;
-            AddPlayerActionToMap(&playerInput);
-        }
-
-        if ((*m_pXInputActions)[i].State.Gamepad.wButtons & XINPUT_GAMEPAD_X)
-        {
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_SELECT;
-            playerInput.NormalizedInputValue = 1.0f;
-            AddPlayerActionToMap(&playerInput);
-        }
-
-        if ((*m_pXInputActions)[i].State.Gamepad.wButtons & XINPUT_GAMEPAD_Y)
-        {
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_CANCEL;
-            playerInput.NormalizedInputValue = 1.0f;
-            AddPlayerActionToMap(&playerInput);
-        }
-
-        // Handle analog inputs.
-
-        // Handle trigger inputs.
-        if ((*m_pXInputActions)[i].State.Gamepad.bLeftTrigger > 0)
-        {
-            // NOTE:  Value is between 0.f and 256.f. However, analog triggers often have a max value slightly less than 256.f.
-            const float padding = 256.f * 0.99f;
-            float paddedValue = (float) (*m_pXInputActions)[i].State.Gamepad.bLeftTrigger / (padding);
-
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_BRAKE;
-            playerInput.NormalizedInputValue = (paddedValue > 1.f) ? 1.f : paddedValue; // Check for values slightly past our padded range.
-            AddPlayerActionToMap(&playerInput);
+            continue;
         }
 
-        if ((*m_pXInputActions)[i].State.Gamepad.bRightTrigger > 0)
+        if ((m_controllersConnected & controllerIdBitFlag) == 0)
         {
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN;
-
-            // As an example, we treat the analog R-trigger as digital.
-            // Instead of using the input value we set the digital value of 1.f.
-            // If this were an analog action (like braking a car) we would have used a floating point value:
-            // playerInput.NormalizedInputValue = ((float) (*m_pXInputActions)[i].State.Gamepad.bRightTrigger / 256.0f);
-            playerInput.NormalizedInputValue = 1.f;
-            AddPlayerActionToMap(&playerInput);
+            // Ensure this player and controller are marked active.
+            InterlockedOr16(&m_controllersConnected, controllerIdBitFlag);
+            InterlockedOr16(&m_playersConnected, controllerIdBitFlag);
         }
-       
-
-        // NOTE TO DEVELOPER: Values for thumbsticks return between -32768 and 32767. The
-        // InputManager normalizes them such that all analog controls, both XInput and
-        // virtual touchscreen implementations, return a value between -1.f and 1.f.
 
-        float stickLPressMagnitude = ComputeThumbstickMagnitudeFactor(
-            (float) (*m_pXInputActions)[i].State.Gamepad.sThumbLX,
-            (float) (*m_pXInputActions)[i].State.Gamepad.sThumbLY,
-            (int) XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE,
-            XINPUT_ANALOG_STICK_THROW_MAX
-            );
+        // A button pressed and released since the last call still counts as
+        // held for this one, and a trigger reports its furthest pull. Sticks
+        // report their average position over the interval.
+        GamepadSample gamepad = interval.Latest;
+        gamepad.Buttons      = interval.Latest.Buttons | interval.Pressed;
+        gamepad.LeftTrigger  = interval.LeftTriggerPeak;
+        gamepad.RightTrigger = interval.RightTriggerPeak;
+        gamepad.ThumbLX      = static_cast<SHORT>(interval.ThumbLX);
+        gamepad.ThumbLY      = static_cast<SHORT>(interval.ThumbLY);
+        gamepad.ThumbRX      = static_cast<SHORT>(interval.ThumbRX);
+        gamepad.ThumbRY      = static_cast<SHORT>(interval.ThumbRY);
 
-        float stickRPressMagnitude = ComputeThumbstickMagnitudeFactor(
-            (float) (*m_pXInputActions)[i].State.Gamepad.sThumbRX,
-            (float) (*m_pXInputActions)[i].State.Gamepad.sThumbRY,
-            (int) XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE,
-            XINPUT_ANALOG_STICK_THROW_MAX
-            );
-
-        if (((*m_pXInputActions)[i].State.Gamepad.sThumbLX != 0) || ((*m_pXInputActions)[i].State.Gamepad.sThumbLY != 0))
-        {
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-
-            // Normalized value of stick press in X direction
-            playerInput.X =
-                (float) (*m_pXInputActions)[i].State.Gamepad.sThumbLX * stickLPressMagnitude / XINPUT_ANALOG_STICK_THROW_MAX;
-
-            // Normalized value of stick press in Y direction
-            playerInput.Y =
-                (float) (*m_pXInputActions)[i].State.Gamepad.sThumbLY * stickLPressMagnitude / XINPUT_ANALOG_STICK_THROW_MAX;
-            
-            playerInput.NormalizedInputValue = 1.f; // Use this field to indicate positive action.
-            AddPlayerActionToMap(&playerInput);
-        }
-
-        if (((*m_pXInputActions)[i].State.Gamepad.sThumbRX != 0) || ((*m_pXInputActions)[i].State.Gamepad.sThumbRY != 0))
-        {
-            // Normalized value of stick press in X direction
-            playerInput.X =
-                (float) (*m_pXInputActions)[i].State.Gamepad.sThumbRX * stickLPressMagnitude / XINPUT_ANALOG_STICK_THROW_MAX;
-
-            // Normalized value of stick press in Y direction
-            playerInput.Y =
-                (float) (*m_pXInputActions)[i].State.Gamepad.sThumbRY * stickLPressMagnitude / XINPUT_ANALOG_STICK_THROW_MAX;
-
-            playerInput.NormalizedInputValue = 1.f; // Use this field to indicate positive action.
-            AddPlayerActionToMap(&playerInput);
-        }
-        
+        // Stamp the state only when it changed, so held sticks and
+        // buttons aren't counted as new input every frame.
+        m_translator.AddGamepadState(controllerId, gamepad, interval.Changed ? interval.LastChange : 0);
     }
-}
 
-// Compute the normalized magnitude for any analog stick operation, including both 
-// the XInput analog sticks and the touch screen virtual analog stick, and normalize
-// the input values.
-float InputManager::ComputeThumbstickMagnitudeFactor(
-    _In_ float const stickX, 
-    _In_ float const stickY, 
-    _In_ int   const deadZone, 
-    _In_ float const maxThrow)
-{
-    // Determine how far the controller is pushed.
-    float magnitude = sqrt(stickX*stickX + stickY*stickY);
-
-    // Avoid dividing by zero.
-    if (magnitude == 0) return magnitude;
-
-    float normalizedMagnitude = 0;
-
-    // Check if the controller is outside a circular dead zone.
-    if (magnitude > deadZone)
-    {
-        // Clip the magnitude at its expected maximum value.
-        if (magnitude > maxThrow) magnitude = maxThrow;
-
-        // Adjust magnitude relative to the end of the dead zone.
-        magnitude -= deadZone;
-        normalizedMagnitude = magnitude / (maxThrow - deadZone);
-    }
-    else // If the controller is in the deadzone zero out the magnitude:
-    {
-        magnitude = 0.0f;
-        normalizedMagnitude = 0.0f;
-    }
-
-    return normalizedMagnitude;
+    m_lastXInputQuery = now;
 }
 
+
 // 
 // ** END XINPUT PROCESSING METHODS **
 //
@@ -683,40 +484,25 @@ void InputManager::OnPointerEvent(
     _In_ PointerEventArgs^ args, 
     INPUT_EVENT_TYPE type)
 {
-    // Initialize a new pointer input action element.
-    PointerControllerAction pointerAction;
-    ZeroMemory(&pointerAction, sizeof(PointerControllerAction));
+    // Initialize a new raw input event.
+    RawInputEvent rawEvent;
+    ZeroMemory(&rawEvent, sizeof(RawInputEvent));
+
+    LARGE_INTEGER timestamp;
+    QueryPerformanceCounter(&timestamp);
+    rawEvent.Timestamp = timestamp.QuadPart;
+    rawEvent.Type = type;
 
     // Perform processing on the pointer data returned by the
     // delegate arguments.
-    ProcessPointerData(args, &pointerAction);
+    ProcessPointerData(args, &rawEvent.Pointer);
+    rawEvent.Pointer.Timestamp = rawEvent.Timestamp;
 
-    // Updating pointer map, lock for access.
-    std::lock_guard<std::mutex> lock(m_stateMutex);
+    rawEvent.Device = rawEvent.Pointer.IsTouchEvent ? INPUT_DEVICE_TYPES::INPUT_DEVICE_TOUCH : INPUT_DEVICE_TYPES::INPUT_DEVICE_MOUSE;
 
-    if (type == INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_DOWN)
-    {
-        // Set the pointer ID and coordinate tuple for the touch down point (i.e. where the
-        // press event started).
-        XMFLOAT2 touchDownCoords = XMFLOAT2(0, 0);
-
-        touchDownCoords.x = pointerAction.CurrentX;
-        touchDownCoords.y = pointerAction.CurrentY;
-
-        // Add the pointer action to the persistent state map.
-        m_pTouchDownMap->emplace(std::pair<unsigned int, XMFLOAT2>(pointerAction.PointerId, touchDownCoords));
-    }
-
-    if (pointerAction.IsTouchEvent)
-    {
-        // Add the pointer action to the pointer action map.
-        m_pTouchActions->emplace(std::pair<unsigned int, PointerControllerAction>(pointerAction.PointerId, pointerAction));
-    }
-    else
-    {
-        // Add the pointer action to the pointer action map.
-        m_pMouseActions->emplace(std::pair<unsigned int, PointerControllerAction>(pointerAction.PointerId, pointerAction));
-    }
+    // Hand the event to the game thread. If the queue is full the event is
+    // dropped and counted; the next move event carries the pointer position anyway.
+    m_eventQueue.TryPush(rawEvent);
 }
 
 
@@ -762,413 +548,7 @@ void InputManager::ProcessPointerData(
     }
 }
 
-//
-// Touch region methods
-//
 
-// If the touch coordinates are in a region, returns an index into the region 
-// they're in. If the touch coordinates are not in a region, this method 
-// returns INVALID_TOUCH_REGION_ID (-1).
-int InputManager::IsTouchdownInRegion(
-    _In_ XMFLOAT2 touchDownPoint
-    )
-{
-    int i = 0;
-
-    auto iter = m_pTouchControlRegions->begin();
-    while (iter != m_pTouchControlRegions->end())
-    {
-        // Simple collision test checks whether a pointer is in a defined touch region.
-        // NOTE TO DEVELOPERS: You can replace this with a call to your own collision testing function.
-        XMFLOAT2 tl = iter->UpperLeftCoords;
-        XMFLOAT2 br = iter->LowerRightCoords;
-
-        if ((touchDownPoint.x > br.x) ||
-            (touchDownPoint.x < tl.x) ||
-            (touchDownPoint.y > br.y) ||
-            (touchDownPoint.y < tl.y))
-        {
-            // no collision
-            ++i;
-            ++iter;
-            continue;
-        }
-        else
-        {
-            // collision
-            return i;
-        }
-    }
-
-    return INVALID_TOUCH_REGION_ID;
-}
-
-void InputManager::EnableTouchRegion(
-    _In_ unsigned int regionId
-    )
-{
-    if (regionId <= m_pTouchControlRegions->size())
-        (*m_pTouchControlRegions)[regionId].IsEnabled = true;
-}
-
-void InputManager::DisableTouchRegion(
-    _In_ unsigned int regionId
-    )
-{
-    if (regionId <= m_pTouchControlRegions->size())
-        (*m_pTouchControlRegions)[regionId].IsEnabled = false;
-}
-
-
-// Public method to set a touch region.
-// Note: maxLogicalSize SHOULD be set to m_deviceResources->GetLogicalSize().
-DWORD InputManager::SetDefinedTouchRegion(
-    _In_ const TouchControlRegion * newRegion,
-    _Out_ unsigned int& regionId
-    )
-{
-    // First, validate all parameters. Bad touch regions can create weird artifacts!
-    
-    // Are all coordinates 0.f or greater?
-    if ((newRegion->UpperLeftCoords.x  < 0.f) || (newRegion->UpperLeftCoords.y  < 0.f) ||
-        (newRegion->LowerRightCoords.x < 0.f) || (newRegion->LowerRightCoords.y < 0.f))
-    {
-        return INVALID_TOUCH_REGION_OFFSCREEN;
-    }
-
-    // Make sure the upper left coord is in fact the upper left coord, and vice versa.
-    if ((newRegion->UpperLeftCoords.x > newRegion->LowerRightCoords.x) ||
-        (newRegion->UpperLeftCoords.y > newRegion->LowerRightCoords.y))
-    {
-        return INVALID_TOUCH_REGION_INVERTED;
-    }
-
-    std::vector<TouchControlRegion>::iterator iter = m_pTouchControlRegions->begin();
-    while (iter != m_pTouchControlRegions->end())
-    {
-        // check for overlap
-        // Note to developers: You can replace this with your own collision function.
-        if (!((newRegion->UpperLeftCoords.x > iter->LowerRightCoords.x) || (newRegion->LowerRightCoords.x < iter->UpperLeftCoords.x) ||
-            (newRegion->UpperLeftCoords.y < iter->LowerRightCoords.y) || (newRegion->LowerRightCoords.y > iter->UpperLeftCoords.y)))
-        {
-            return INVALID_TOUCH_REGION_OVERLAPS;
-        }
-
-        ++iter;
-    }
-
-    m_pTouchControlRegions->push_back(*newRegion);
-    regionId = m_pTouchControlRegions->size() - 1;
-        
-    return 0;
-}
-
-void InputManager::ClearTouchRegions(void)
-{
-    m_pTouchControlRegions->clear();
-}
-
-// Converts raw pointer input received from touch events into 
-// specific player gameplay input actions.
-void InputManager::TranslateTouchPointerActionsToPlayerActionsMap()
-{
-    std::unordered_map<unsigned int, PointerControllerAction>::iterator iter = m_pTouchActions->begin();
-
-    // Prevents multiple touch points from providing stick input.
-    bool virtualStickProcessedThisFrame[PLAYER_ACTION_TYPES::INPUT_MAX];
-    ZeroMemory(virtualStickProcessedThisFrame, sizeof(bool) * PLAYER_ACTION_TYPES::INPUT_MAX);
-
-    // Iterate over the set of pointer actions added for this frame.
-    while (iter != m_pTouchActions->end())
-    {
-        // Enable the player ID for the default pointer player assignment.
-        m_playersConnected |= (1 << DEFAULT_POINTER_PLAYER_ID);
-
-        unsigned int pointerId = iter->first;
-        PointerControllerAction pointerAction = iter->second;
-
-        int id = IsTouchdownInRegion(XMFLOAT2(pointerAction.CurrentX, pointerAction.CurrentY));
-
-        // Touching the screen provides data for player 1.
-        PlayerInputData playerInput;
-        playerInput.ID = DEFAULT_POINTER_PLAYER_ID;
-        playerInput.IsTouchAction = true;
-
-        if ((id == INVALID_TOUCH_REGION_ID) || (!(*m_pTouchControlRegions)[id].IsEnabled))
-        {
-            // Any touch input at all has to be recognized. This enables the 
-            // virtual controller to display itself when the player touches 
-            // the display.
-
-            // Construct dummy event
-            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_NONE;
-
-            // Process and add the player action to the player gameplay action vector.
-            AddPlayerActionToMap(&playerInput);
-
-            ++iter;
-            continue;
-        }
-
-        // Check for analog stick regions.
-        if ((*m_pTouchControlRegions)[id].RegionType == TOUCH_CONTROL_REGION_ANALOG_STICK)
-        {
-            // Check for thumbstick input already received for this region.
-            // This prevents random touch points from interfering with the thumbstick.
-            if (virtualStickProcessedThisFrame[(*m_pTouchControlRegions)[id].DefinedAction])
-            {
-                ++iter;
-                continue;
-            }
-            else
-            {
-                virtualStickProcessedThisFrame[(*m_pTouchControlRegions)[id].DefinedAction] = true;
-            }
-
-            float centerX, centerY;
-
-            XMFLOAT2 pointerTD = (*m_pTouchDownMap)[pointerId];
-
-            // Check to see whether we are already watching this pointer.
-            std::unordered_map<unsigned int, PointerControllerAction>::iterator val = m_pTouchActionsLastFrame->find(pointerId);
-            if (val == m_pTouchActionsLastFrame->end())
-            {
-                // We are not watching this touch point, so we need to store the initial touch coordinates.
-                // Store the center position for the virtual analog stick display.
-                centerX = pointerAction.CurrentX;
-                centerY = pointerAction.CurrentY;
-            }
-            else
-            {
-                // We are currently watching this touch point. Update state based on event type.
-                if (!pointerAction.IsLeftButtonPressed)
-                {
-                    // Pointer is up, so remove it from the processing state.
-                    auto temp = iter;
-                    ++iter;
-                    m_pTouchActions->erase(temp);
-                    m_pTouchActionsLastFrame->erase(val);
-                    continue;
-                }
-                else
-                {
-                    // Pointer has moved.
-
-                    // Get back the initial touch coordinates.
-                    centerX = pointerTD.x;
-                    centerY = pointerTD.y;
-
-                    // Already processed.
-                    m_pTouchActionsLastFrame->erase(val);
-                }
-            }
-
-            // Calculate the delta between this action and the pointer touch down action recorded
-            // previously for this pointer ID. Assume it is a touch controller or drag operation.
-            float xDelta = pointerAction.CurrentX - centerX;
-            float yDelta = pointerAction.CurrentY - centerY;
-
-            // Enforce a circular limit for the controller stick.
-            float magnitude = sqrtf(xDelta*xDelta + yDelta*yDelta);
-
-            // Move the thumbstick with the user's thumb.
-            if (magnitude > POINTER_VIRTUAL_STICK_THROW_MAX)
-            {
-                // Compute how far out the user dragged the joystick.
-                float magnitudeFactor = POINTER_VIRTUAL_STICK_THROW_MAX / magnitude;
-                float temp1 = xDelta * magnitudeFactor;
-                float temp2 = yDelta * magnitudeFactor;
-
-                // Move the center by the same amount.
-                centerX = (*m_pTouchDownMap)[pointerId].x += xDelta - temp1;
-                centerY = (*m_pTouchDownMap)[pointerId].y += yDelta - temp2;
-
-                // Reduce the "thrown" values to their max size.
-                xDelta = temp1;
-                yDelta = temp2;
-            }
-
-            // Compute the value we need to normalize the x/y values to a total distance of 1.0f.
-            float normalizedMagnitude = ComputeThumbstickMagnitudeFactor(
-                xDelta,
-                yDelta,
-                (int) POINTER_VIRTUAL_STICK_DEADZONE,
-                POINTER_VIRTUAL_STICK_THROW_MAX
-                );
-
-            // Updated the coordinate data.
-
-            // Store the stick's center position for virtual controller rendering.
-            playerInput.PointerRawX = centerX;
-            playerInput.PointerRawY = centerY;
-
-            // Store the stick's current "thrown" position for virtual controller rendering.
-            playerInput.PointerThrowX = centerX + xDelta;
-            playerInput.PointerThrowY = centerY + yDelta;
-
-            // Normalized input data. This corresponds to the normalized axis values you'd 
-            // get from a physical joystick.
-            playerInput.X = normalizedMagnitude * xDelta / POINTER_VIRTUAL_STICK_THROW_MAX;
-            // Y-value must be reversed to map pixel coordinate system to Xbox controller behaviors
-            playerInput.Y = -(normalizedMagnitude * yDelta / POINTER_VIRTUAL_STICK_THROW_MAX); 
-
-            // Move actions store the normalized axis values in X and Y, so the 
-            // NormalizedInputValue field is unused.
-            // You can use this for any additional calibration or smoothing data, like an
-            // interpolation modifier.
-            playerInput.NormalizedInputValue = 1.f;
-
-            // Store the action type for this touch region.
-            switch ((*m_pTouchControlRegions)[id].DefinedAction)
-            {
-            default:
-            case PLAYER_ACTION_TYPES::INPUT_MOVE:
-                playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-                break;
-
-            case PLAYER_ACTION_TYPES::INPUT_AIM:
-                playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_AIM;
-                break;
-            }
-
-            // Process the X and Y data and use it to update the player gameplay action vector.
-            AddPlayerActionToMap(&playerInput);
-        }
-        else if ((*m_pTouchControlRegions)[id].RegionType == TOUCH_CONTROL_REGION_BUTTON)
-        {
-            // Virtual button was pressed.
-
-            // Include updated coordinates.
-            playerInput.PointerRawX = playerInput.X = pointerAction.CurrentX;
-            playerInput.PointerRawY = playerInput.Y = pointerAction.CurrentY;
-
-            // The action type is defined with the touch region.
-            playerInput.PlayerAction = (*m_pTouchControlRegions)[id].DefinedAction;
-            playerInput.NormalizedInputValue = 1.f;
-
-            // Process and add the player action to the player gameplay action vector.
-            AddPlayerActionToMap(&playerInput);
-        }
-
-        // NOTE TO DEVELOPERS: Add your own code for handling slide controls, etc. by adding more cases here.
-
-        ++iter;
-    }
-}
-
-
-// Converts raw pointer input received from mouse events into 
-// specific player gameplay input actions.
-void InputManager::TranslateMousePointerActionsToPlayerActionsMap()
-{
-    std::unordered_map<unsigned int, PointerControllerAction>::iterator iter = m_pMouseActions->begin();
-
-    // Iterate over the set of pointer actions added for this frame.
-    while (iter != m_pMouseActions->end())
-    {
-        // Enable the player ID for the default keyboard player assignment.
-        m_playersConnected |= (1 << DEFAULT_POINTER_PLAYER_ID);
-
-        unsigned int pointerId = iter->first;
-        PointerControllerAction pointerAction = iter->second;
-
-        PlayerInputData playerInput;
-        playerInput.ID = DEFAULT_POINTER_PLAYER_ID;
-
-        // Include updated coordinates.
-        // For mouse updates, the raw input coords and the returned x and y values are the same.
-        //  This is different for "virtual" controls like the touch analog stick.
-        playerInput.PointerRawX = playerInput.X = pointerAction.CurrentX;
-        playerInput.PointerRawY = pointerAction.CurrentY = pointerAction.CurrentY;
-            
-        // Check to see whether we are already watching this pointer.
-        std::unordered_map<unsigned int, PointerControllerAction>::iterator pointerLastFrame = m_pMouseActionsLastFrame->find(pointerId);
-        if (pointerLastFrame != m_pMouseActionsLastFrame->end())
-        {
-            playerInput.PlayerAction = (pointerAction.IsLeftButtonPressed) ? PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN : PLAYER_ACTION_TYPES::INPUT_FIRE_UP;
-            playerInput.NormalizedInputValue = 1.0f;
-                
-            // if the pointer isn't providing any state, discard it
-            if (!(pointerAction.IsLeftButtonPressed || pointerAction.IsMiddleButtonPressed || pointerAction.IsRightButtonPressed))
-            {
-                if ((pointerAction.CurrentX == pointerLastFrame->second.CurrentX) && (pointerAction.CurrentY == pointerLastFrame->second.CurrentY))
-                {
-                    auto temp = iter;
-                    ++iter;
-
-                    // Erase it: we already processed it, this pointer is done for now.
-                    m_pMouseActions->erase(temp);
-                    m_pMouseActionsLastFrame->erase(pointerLastFrame);
-
-                    continue;
-                }
-                else
-                {
-                    // Return 0.f as the normalized pointerLastFrameue. The coordinate data is what 
-                    // the game will be processing in this case.
-                    playerInput.NormalizedInputValue = 0.f;
-                    playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_COORDINATES_ONLY;
-                }
-            }
-
-            // Process and add the player action to the player gameplay action vector.
-            AddPlayerActionToMap(&playerInput);
-
-            // Already processed
-            m_pMouseActionsLastFrame->erase(pointerLastFrame);
-        }
-        else
-        {
-            // This must be a pointer we're not currently tracking.
-
-            if (pointerAction.IsLeftButtonPressed)
-            {
-                // New action detected with left-click.
-                playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN;
-                playerInput.NormalizedInputValue = 1.f;
-            }
-            else
-            {
-                // Return 0.f as the normalized value. The coordinate data is what 
-                // the game will be processing in this case.
-                playerInput.NormalizedInputValue = 0.f;
-                playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_COORDINATES_ONLY;
-            }
-
-            // Process and add the X and Y data to the player gameplay action vector.
-            AddPlayerActionToMap(&playerInput);
-        }
-
-        ++iter;
-    }
-
-    iter = m_pMouseActionsLastFrame->begin();
-
-    // Look for leftover pointer actions. This indicates a mouse button is still down, but the mouse has not moved.
-    while (iter != m_pMouseActionsLastFrame->end())
-    {
-        unsigned int pointerId = iter->first;
-        PointerControllerAction pointerAction = iter->second;
-
-        if (pointerAction.IsMouseEvent)
-        {
-            PlayerInputData playerInput;
-            playerInput.ID = DEFAULT_POINTER_PLAYER_ID;
-
-            // Include updated coordinates.
-            playerInput.PointerRawX = playerInput.X = pointerAction.CurrentX;
-            playerInput.PointerRawY = pointerAction.CurrentY = pointerAction.CurrentY;
-
-            playerInput.PlayerAction = (pointerAction.IsLeftButtonPressed) ? PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN : PLAYER_ACTION_TYPES::INPUT_FIRE_UP;
-            playerInput.NormalizedInputValue = 1.0f;
-
-            // Process and add the player action to the player gameplay action vector.
-            AddPlayerActionToMap(&playerInput);
-        }
-        
-        ++iter;
-    }
-}
 
 
 // Processes a key event. Called by the inner class (ref wrapper) whenever it 
@@ -1178,303 +558,26 @@ void InputManager::OnKeyEvent(
     _In_ KeyEventArgs^ args,
     INPUT_EVENT_TYPE type)
 {
-    switch (type)
+    if ((type != INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_DOWN) && (type != INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_UP))
     {
-    case INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_DOWN:
-        {
-            // Updating keyboard input map, lock for access until we're done updating the map.
-            std::lock_guard<std::mutex> lock(m_stateMutex);
-
-            // Set the player ID to the default keyboard player assignment.
-            unsigned int ID = DEFAULT_KEYBOARD_PLAYER_ID;
-            unsigned int keyPress = (unsigned int) args->VirtualKey;
-
-            // If the keypress hasn't already registered, add it. Otherwise, ignore it.
-            if (m_pKeyboardActions->find(keyPress) == m_pKeyboardActions->end())
-            {
-                m_pKeyboardActions->insert(std::pair<unsigned int, unsigned int>(keyPress, ID));
-            }
-        }
-        break;
-
-    case INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_UP:
-        {
-            // Updating keyboard input map, lock for access until we're done updating the map.
-            std::lock_guard<std::mutex> lock(m_stateMutex);
-
-            unsigned int keyPress = (unsigned int) args->VirtualKey;
-
-            // key is released, remove from input map.
-            m_pKeyboardActions->erase(keyPress);
-        }
-        break;
+        return;
     }
-}
-
-
-// Convert keyboard keypresses and releases into player gameplay actions.
-void InputManager::TranslateKeyboardToPlayerActionsMap()
-{
-    if ((m_pKeyboardActions != nullptr) && (m_pKeyboardActions->size() > 0))
-    {
-        // Enable the player ID for the default keyboard player assignment.
-        m_playersConnected |= (1 << DEFAULT_KEYBOARD_PLAYER_ID);
-
-        // 
-        // NOTE TO DEVELOPERS: This code processes keyboard actions and translates
-        // them into player gameplay actions. You can add to or update this 
-        // code to support the gameplay actions you define for your game.
-        //
-        if (m_pKeyboardActions->find((unsigned int) VirtualKey::Escape) != m_pKeyboardActions->end()) // found
-        {
-            PlayerInputData * playerInput = new PlayerInputData();
-            
-            playerInput->ID                   = DEFAULT_KEYBOARD_PLAYER_ID;
-            playerInput->PlayerAction         = PLAYER_ACTION_TYPES::INPUT_EXIT;
-            playerInput->NormalizedInputValue = 1.0f;
-
-            AddPlayerActionToMap(playerInput);
-        }
-
-        if (m_pKeyboardActions->find((unsigned int) VirtualKey::Space) != m_pKeyboardActions->end()) // non-zero
-        {
-            PlayerInputData * playerInput = new PlayerInputData();
-
-            playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-            playerInput->PlayerAction         = PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN;
-            playerInput->NormalizedInputValue = 1.0f;
-			playerInput->isFiring = true;
-
-            AddPlayerActionToMap(playerInput);
-        }
-		//ADD WEAPONS
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::Number1) != m_pKeyboardActions->end()) // non-zero
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_WEAPON_ONE;
-			playerInput->NormalizedInputValue = 1.0f;
-			playerInput->firetype = 0;
-
-			AddPlayerActionToMap(playerInput);
-		}
-           
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::Number2) != m_pKeyboardActions->end()) // non-zero
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_WEAPON_TWO;
-			playerInput->NormalizedInputValue = 1.0f;
-			playerInput->firetype = 1;
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::Number3) != m_pKeyboardActions->end()) // non-zero
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_WEAPON_THREE;
-			playerInput->NormalizedInputValue = 1.0f;
-			playerInput->firetype = 2;
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-        if (m_pKeyboardActions->find((unsigned int) VirtualKey::Control) != m_pKeyboardActions->end()) // found
-        {
-            PlayerInputData * playerInput = new PlayerInputData();
 
-            playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-            playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_JUMP_DOWN;
-            playerInput->NormalizedInputValue = 1.0f;
+    RawInputEvent rawEvent;
+    ZeroMemory(&rawEvent, sizeof(RawInputEvent));
 
-            AddPlayerActionToMap(playerInput);
-        }
-
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::Left) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->X = -1.f; // The movement was in the left direction on the x axis.
-			playerInput->Y = 0.f; // ...and no y-axis motion.
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::E) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->Roll = 1.0f;// start rolling
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::Q) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = 1.f;
-			playerInput->Roll = -1.0f;// start rolling
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::W) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->Pitch = 1.0f;// pitch up
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-		//laser orientation change
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::I) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->laserPitch = -1.0f;// laser pitch up
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::S) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->Pitch = -1.0f; // pitch down
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-		//laser orientation change
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::K) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->laserPitch = 1.0f;// laser pitch down
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::D) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->Yaw = -1.0f; // yaw right
-
-			AddPlayerActionToMap(playerInput);
-		}
+    LARGE_INTEGER timestamp;
+    QueryPerformanceCounter(&timestamp);
+    rawEvent.Timestamp = timestamp.QuadPart;
+    rawEvent.Device = INPUT_DEVICE_TYPES::INPUT_DEVICE_KEYBOARD;
+    rawEvent.Type = type;
+    rawEvent.VirtualKey = (unsigned int) args->VirtualKey;
 
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::L) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->laserYaw = -1.0f; // laser yaw right
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::A) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->Yaw = 1.0f; // yaw left
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-		if (m_pKeyboardActions->find((unsigned int)VirtualKey::J) != m_pKeyboardActions->end()) // found
-		{
-			PlayerInputData * playerInput = new PlayerInputData();
-
-			playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-			playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-			playerInput->NormalizedInputValue = -1.f;
-			playerInput->laserYaw = 1.0f; // yaw left
-
-			AddPlayerActionToMap(playerInput);
-		}
-
-        if (m_pKeyboardActions->find((unsigned int) VirtualKey::Right) != m_pKeyboardActions->end()) // found
-        {
-            PlayerInputData * playerInput = new PlayerInputData();
-
-            playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-            playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-            playerInput->NormalizedInputValue = 1.f;
-            playerInput->X = 1.f; // The movement was in the right direction on the x axis.
-            playerInput->Y = 0.f; // ...and no y-axis motion.
-
-            AddPlayerActionToMap(playerInput);
-        }
-
-        if (m_pKeyboardActions->find((unsigned int) VirtualKey::Up) != m_pKeyboardActions->end()) // found
-        {
-            PlayerInputData * playerInput = new PlayerInputData();
-
-            playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-            playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-            playerInput->NormalizedInputValue = 1.f;
-            playerInput->Y = 1.f; // The movement was in the up direction on the y axis.
-            playerInput->X = 0.f; // ...and no x-axis motion.
-
-            AddPlayerActionToMap(playerInput);
-        }
-
-        if (m_pKeyboardActions->find((unsigned int) VirtualKey::Down) != m_pKeyboardActions->end()) // found
-        {
-            PlayerInputData * playerInput = new PlayerInputData();
-
-            playerInput->ID = DEFAULT_KEYBOARD_PLAYER_ID;
-            playerInput->PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
-            playerInput->NormalizedInputValue = -1.f;
-            playerInput->Y = -1.f; // The movement was in the down direction on the y axis.
-            playerInput->X = 0.f; // ...and no x-axis motion.
+    // Hand the key to the game thread; it updates the keyboard map when it drains the queue.
+    m_eventQueue.TryPush(rawEvent);
+}
 
-            AddPlayerActionToMap(playerInput);
-        }
 
-        // NOTE: Add if statements here for other keys. Diagonals can be processed by checking for two keypresses
-        // (e.g. Up + Right) and setting the X and Y properties of the PlayerInputData accordingly
-        // (e.g. X = 1.f, Y = 1.f).
-    }
-}
 
 #pragma endregion
 
@@ -10,8 +10,13 @@
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <Xinput.h>
 #include "../Helpers/StepTimer.h"
+#include "../Helpers/InputEventQueue.h"
+#include "../Helpers/InputTypes.h"
+#include "../Helpers/InputTranslator.h"
+#include "../Helpers/GamepadPoller.h"
 
 #include <DirectXMath.h>
 #include <interlockedapi.h>
@@ -27,303 +32,21 @@ using namespace DirectX;
 
 namespace DirectXGame2
 {
-    //
-    // ** Begin enumerations **
-    //
-
-#pragma region InputManagerEnums
-
-    // Bit values of all the actions a player can
-    // initiate, and which can be returned by the
-    // input manager after processing.
-    // NOTE TO DEVELOPERS: When you change this list, please
-    // increment or decrement DEFAULT_MAX_PLAYER_ACTION_TYPES  accordingly!
-    enum PLAYER_ACTION_TYPES
-    {
-        // These are examples of input events a game might have:
-        INPUT_NONE = 0,
-        INPUT_COORDINATES_ONLY = 1, // raw coord data
-        INPUT_MOVE,
-        INPUT_AIM,
-        INPUT_FIRE,
-        INPUT_FIRE_UP,
-        INPUT_FIRE_DOWN,
-        INPUT_FIRE_PRESSED,
-        INPUT_FIRE_RELEASED,
-        INPUT_JUMP,
-        INPUT_JUMP_UP,
-        INPUT_JUMP_DOWN,
-        INPUT_JUMP_PRESSED,
-        INPUT_JUMP_RELEASED,
-        INPUT_ACCEL,
-        INPUT_BRAKE,
-        INPUT_SELECT,
-        INPUT_START,
-        INPUT_CANCEL,
-        INPUT_EXIT,
-        INPUT_DIRECTIONAL,
-		INPUT_WEAPON_ONE,
-		INPUT_WEAPON_TWO,
-		INPUT_WEAPON_THREE,
-        // ...
-        // Note to developer: Add the input events your game demands!
-        // ...
-
-        INPUT_MAX
-    };
-
-
-    // Types of Windows input events. Used internally for handling passed-through input events.
-    enum INPUT_EVENT_TYPE
-    {
-        INPUT_EVENT_TYPE_DOWN,
-        INPUT_EVENT_TYPE_UP,
-        INPUT_EVENT_TYPE_MOVED,
-        INPUT_EVENT_TYPE_EXITED,
-
-        INPUT_EVENT_TYPE_NUM
-    };
-
-
-    // Bit values of all the input devices supported by the input manager.
-    enum INPUT_DEVICE_TYPES
-    {
-        INPUT_DEVICE_NONE     = 0x00,
-        INPUT_DEVICE_MOUSE    = 0x01,
-        INPUT_DEVICE_KEYBOARD = 0x02,
-        INPUT_DEVICE_TOUCH    = 0x04,
-        INPUT_DEVICE_XINPUT   = 0x08,
-        INPUT_DEVICE_ALL = 
-           (INPUT_DEVICE_MOUSE    |
-            INPUT_DEVICE_KEYBOARD |
-            INPUT_DEVICE_TOUCH    |
-            INPUT_DEVICE_XINPUT)
-    };
-
-
-    // Bit values for all the players supported by the input manager.
-    // NOTE TO DEVELOPERS: When you change this list, please
-    // increment or decrement XUSER_MAX_COUNT accordingly!
-    enum PLAYER_ID
-    {
-        PLAYER_ID_ONE   = 0x01,
-        PLAYER_ID_TWO   = 0x02,
-        PLAYER_ID_THREE = 0x04,
-        PLAYER_ID_FOUR  = 0x08,
-        // ...
-        // Note to developer: Add more players as your game demands, and as practically 
-        // supported by the hardware.
-        // ...
-        PLAYER_ID_MAX
-    };
-
-    // Types of touch screen virtual controls. 
-    // NOTE TO DEVELOPERS: You can add to, or update, these touch-screen
-    // control types.
-    enum TOUCH_CONTROL_REGION_TYPES
-    {
-        TOUCH_CONTROL_REGION_REPORT_COORDS_ONLY = 0,
-        TOUCH_CONTROL_REGION_ANALOG_STICK = 1,
-        TOUCH_CONTROL_REGION_BUTTON = 2,
-        TOUCH_CONTROL_REGION_ANALOG_SLIDER = 3,
-
-        TOUCH_CONTROL_REGION_MAX
-    };
-
-    //
-    // ** End InputManager enums **
-    //
-#pragma endregion
-
-    // Keyboard/touch/mouse default to player 1 (index 0).
-#define DEFAULT_KEYBOARD_PLAYER_ID               0
-#define DEFAULT_POINTER_PLAYER_ID                0
-
-
-    // Touch region definition errors
-#define INVALID_TOUCH_REGION_ID                 -1
-#define INVALID_TOUCH_REGION_OVERLAPS           -2
-#define INVALID_TOUCH_REGION_INVERTED           -3
-#define INVALID_TOUCH_REGION_OFFSCREEN          -4
-
-
-#pragma region InputManagerConsts
-
-    //
-    // Constants for handling XInput
-    //
     // Defines timeout window for dropped XInput controller connections.
 #define XINPUT_CONTROLLER_ENUM_TIMEOUT  2000
 
+    // Raw CoreWindow events that can be waiting for the game thread. Must be a power of two.
+#define INPUT_EVENT_QUEUE_CAPACITY      1024
 
-    // Defines the maximum numbers of Xinput controllers to process. XInput
-    // supports a maximum of 4 controllers.
-#define XINPUT_MAX_CONTROLLERS          4
-
-
-    // The maximum XInput analog throw value. Full range is
-    // -32768 to 32767.
-#define XINPUT_ANALOG_STICK_THROW_MAX   32767.0f
-
-
-    //
-    // Constants for handling pointer devices (mouse/touch)
-    //
-    // Pixel move radius from touchdown for virtual stick deadzone.
-#define POINTER_VIRTUAL_STICK_DEADZONE  10.0f
-#define POINTER_VIRTUAL_STICK_THROW_MAX 45.0f
-
-
-#pragma endregion
-
-#pragma region InputManagerStructs
-
-    // Contains the state of an XInput controller. This state may be examined 
-    // to see what controller actions were taken.
-    struct XInputControllerAction
-    {
-        unsigned int    ControllerId;
-        XINPUT_STATE    State;
-    };
-
-
-    // Contains the state of an individual pointer action. Note that a 
-    // PointerId is NOT the same as a player or controller ID, as it is used 
-    // to track a a press or move event from start to completion.
-    // -- CHANGE LEFT/RIGHT/MIDDLE to IsTouchPressed;
-    struct PointerControllerAction
-    {
-        unsigned int    PointerId;
-        float           CurrentX;
-        float           CurrentY;
-        bool            IsTouchEvent;
-        bool            IsMouseEvent;
-        bool            IsLeftButtonPressed;
-        bool            IsRightButtonPressed;
-        bool            IsMiddleButtonPressed;
-    };
-
-    // Defines a final player input action state returned to the game. 
-    struct PlayerInputData
-    {
-    public:
-        // The zero-based player ID value for the player that initiated the action.
-        unsigned int ID;
-
-        // The PLAYER_ACTION_TYPES value for the initiated action.
-        PLAYER_ACTION_TYPES PlayerAction;
-
-        // The normalized value (i.e. between 0.f and 1.f) returned from the 
-        // input device. For digital inputs, either a value of 0.f or 1.0f is 
-        // returned, depending on the action. 
-        float NormalizedInputValue;
-
-        // Indicates whether this possible input state is different from last frame.
-
-        // The raw screen coordinate data (x, y) for pointer events. For non-pointer events, 
-        // such as virtual key presses or XInput analog stick and digital pad actions, both
-        // of these values are used to indicate the direction of the action, where 1.0 could
-        // indicate up/forward, and -1.0 could indicate down/back. It is up to your game to
-        // interpret the meaning.
-        float X;
-        float Y;
-
-		// roll, pitch, yaw from keypresses.
-		float Roll;
-		float Pitch;
-		float Yaw;
-
-		float laserPitch = 0.0f;
-		float laserYaw = 0.0f;;
-        // Raw coordinate position for touch/mouse input. For non-pointer events, these values
-        // are set to 0.f.
-        float PointerRawX;
-        float PointerRawY;
-
-        // Value used to determine if the acion originated from a touch event.
-        bool IsTouchAction;
-
-        // Virtual throw for touch stick input. For non-touch actions, these values are set to
-        // 0.f by default. You can use them for additional calibration or smoothing information
-        // for custom controls.
-        float PointerThrowX;
-        float PointerThrowY;
-		bool isFiring;
-		int firetype;
-
-        // ctor
-		PlayerInputData() :
-			ID(0),
-			PlayerAction(INPUT_NONE),
-			NormalizedInputValue(0.f),
-			X(0.f),
-			Y(0.f),
-			Roll(0.f),
-			Pitch(0.f),
-
-			Yaw(0.f),
-			PointerRawX(0.f),
-			PointerRawY(0.f),
-			IsTouchAction(false),
-			PointerThrowX(-1.f), // -1 means this is not a relative touch input event.
-			PointerThrowY(-1.f)
-        {
-        }
-    };
-
-    // Defines a touch control region rectangle.
-    struct TouchControlRegion
-    {
-    public:
-        const XMFLOAT2                      UpperLeftCoords;
-        const XMFLOAT2                      LowerRightCoords;
-        const TOUCH_CONTROL_REGION_TYPES    RegionType;
-        const PLAYER_ACTION_TYPES           DefinedAction;
-        bool                                IsEnabled;
-        bool                                ProcessedThisFrame;
-        PLAYER_ID                           PlayerID;
-
-        // ctor
-        TouchControlRegion(
-            XMFLOAT2 const& upperLeft,
-            XMFLOAT2 const& lowerRight,
-            TOUCH_CONTROL_REGION_TYPES const& regionType,
-            PLAYER_ACTION_TYPES const& definedAction,
-            PLAYER_ID const& playerId
-            ) :
-            UpperLeftCoords(upperLeft),
-            LowerRightCoords(lowerRight),
-            RegionType(regionType),
-            DefinedAction(definedAction),
-            IsEnabled(true),
-            ProcessedThisFrame(false),
-            PlayerID(playerId)
-        {
-        };
-
-        TouchControlRegion(
-            ) :
-            UpperLeftCoords(XMFLOAT2(0,0)),
-            LowerRightCoords(XMFLOAT2(0, 0)),
-            RegionType(TOUCH_CONTROL_REGION_REPORT_COORDS_ONLY),
-            DefinedAction(PLAYER_ACTION_TYPES::INPUT_COORDINATES_ONLY),
-            IsEnabled(false),
-            ProcessedThisFrame(false),
-            PlayerID(PLAYER_ID::PLAYER_ID_ONE)
-        {
-        };
-
-    };
-
-
-#pragma endregion
+    typedef InputEventQueue<RawInputEvent, INPUT_EVENT_QUEUE_CAPACITY> RawInputEventQueue;
 
 #pragma region InputManagerClassDecl
 
     // InputManager: the implementation of an input manager type that processes
     // raw XInput controller, keyboard, and touch/mouse pointer events and data
     // into a single queue of state-friendly player actions (such as firing
-    // state, movement state, etc).
+    // state, movement state, etc). It collects the input from CoreWindow and
+    // XInput; an InputTranslator turns it into player actions.
     class InputManager final
     {
     public:
@@ -339,13 +62,19 @@ namespace DirectXGame2
         void InputManager::Update(DX::StepTimer const& timer);
 
         // ** IMPORTANT **
-        // Call this method on the game input update loop to get a vector collection of a specified player's actions.
+        // Call this method on the game input update loop to get this frame's player actions.
+        // Writes at most capacity actions to playerActions and returns how many were written;
+        // a buffer of INPUT_MAX_PLAYER_ACTIONS always has room for all of them.
         //
-        std::vector<PlayerInputData> GetPlayersActions();
+        unsigned int GetPlayersActions(
+            _Out_writes_to_(capacity, return) PlayerInputData* playerActions,
+            _In_ unsigned int capacity
+            );
 
         //
         // Call this method to set a "touch region," which is a rectangular space on a touch screen
         // surface defined for use as a specific game control. For example, an analog stick or a button press.
+        // Regions may only overlap if their priorities differ.
         //
         DWORD SetDefinedTouchRegion(
             _In_ const TouchControlRegion * newRegion,
@@ -364,11 +93,17 @@ namespace DirectXGame2
 
         // Call this method to set the input devices that will be processed. 
         // Default is INPUT_DEVICE_ALL.
-        __forceinline void SetFilter(INPUT_DEVICE_TYPES mask)   { m_inputTypeFilterMask = mask; };
+        __forceinline void SetFilter(INPUT_DEVICE_TYPES mask)   { m_translator.SetFilter(mask); };
 
         // Gets metadata describing which players are connected.
         __forceinline unsigned int GetPlayersConnected(void)    { return m_playersConnected; };
 
+        // Gets the number of CoreWindow events dropped because the event queue was full.
+        __forceinline unsigned int GetDroppedEventCount(void)   { return m_eventQueue.GetDroppedCount(); };
+
+        // Gets how many times a second the gamepad thread is really polling.
+        __forceinline unsigned int GetGamepadPollRate(void)     { return m_gamepadPoller->GetPollRate(); };
+
         //
         // Pass-through handlers. These process CoreWindow input event data 
         // received by the inner ref class.
@@ -391,71 +126,55 @@ namespace DirectXGame2
         // Internal class variables
         //
 
-        std::mutex                        m_stateMutex;           // The mutex held during internal state update operations.
-
-        INPUT_DEVICE_TYPES                m_inputTypeFilterMask;  // The input types for which player action should be processed and returned.
-        double                            m_timerSeconds;         // Step time for the current update. Used for determining controller disconnect.
-
-        // 2D array used for processing the final set of player actions. This 
-        // is used to resolve player action data from all input sources. Input 
-        // actions are differentiated between multiple players.
-        bool    m_actionsThisFrame[XUSER_MAX_COUNT][PLAYER_ACTION_TYPES::INPUT_MAX];
-
-        // 2D array used to determine if a specific action for a specific 
-        // player was returned to the game in the last update. This is for 
-        // action state management.
-        bool    m_actionsLastFrame[XUSER_MAX_COUNT][PLAYER_ACTION_TYPES::INPUT_MAX];
-
-        // 2D array used to map into player actions. Stores the data as it is 
-        // processed, then used to create the vector that's returned to the game loop.
-        PlayerInputData m_resolvedActionsThisFrame[XUSER_MAX_COUNT][PLAYER_ACTION_TYPES::INPUT_MAX];
+        RawInputEventQueue                m_eventQueue;           // CoreWindow events waiting to be applied on the game thread.
 
         //
-        // Per-frame input source data
+        // Key, button and touch region bindings, compiled from bindings.txt.
+        //
+        // A user copy in the local folder overrides the one installed with
+        // the app. A thread pool work item checks the file about once a
+        // second and compiles a changed one; the game thread picks up the
+        // result at the start of the next frame with a single exchange.
         //
-        // These input vectors and maps used to track and manage the input 
-        // from the three major input sources : XInput(controller), 
-        //  pointer(mouse and touch), and keyboard.
-        std::vector<XInputControllerAction>*                          m_pXInputActions;            // stores XInput actions for one input frame
-        std::unordered_map<unsigned int, unsigned int>*               m_pKeyboardActions;          // pair is virtual key, player id
-        std::unordered_map<unsigned int, XMFLOAT2>*                   m_pTouchDownMap;             // pair is pointer id, touchdown coordinates
-        std::unordered_map<unsigned int, PointerControllerAction>*    m_pMouseActionsLastFrame;    // Used to track mouse pointers across frames.
-        std::unordered_map<unsigned int, PointerControllerAction>*    m_pMouseActions;             // pair is pointer id, last recorded action.
-        std::unordered_map<unsigned int, PointerControllerAction>*    m_pTouchActionsLastFrame;    // Used to track touch pointers across frames.
-        std::unordered_map<unsigned int, PointerControllerAction>*    m_pTouchActions;             // pair is pointer id, last recorded action.
+        struct BindingsSource
+        {
+            std::wstring                    OverridePath;
+            std::wstring                    DefaultPath;
+            std::wstring                    LoadedPath;         // Only touched by whoever holds IsReloading.
+            ULONGLONG                       LoadedWriteTime;
+            std::atomic<ActionBindings*>    Pending;            // Compiled and waiting for the game thread.
+            std::atomic<bool>               IsReloading;
+
+            BindingsSource() : LoadedWriteTime(0), Pending(nullptr), IsReloading(false) {}
+            ~BindingsSource() { delete Pending.exchange(nullptr); }
+        };
 
+        std::unique_ptr<ActionBindings>   m_bindings;
+        std::shared_ptr<BindingsSource>   m_bindingsSource;       // Shared with a reload in flight, which may outlive this object.
+        double                            m_bindingsPollSeconds;
 
-        //
-        // Touch virtual control input region definition and management
-        //
-        std::vector<TouchControlRegion>* m_pTouchControlRegions; // pair is region id, region (coords and type)
+        double                            m_timerSeconds;         // Step time for the current update. Used for determining controller disconnect.
+
+        // Turns the collected input into player actions, and owns the touch regions.
+        InputTranslator                   m_translator;
 
-        
         //
         // XInput data
         //
-        XINPUT_CAPABILITIES   m_xinputCapabilities[XINPUT_MAX_CONTROLLERS];                  // Array of the capabilities of the XInput controllers. 
-        volatile short        m_playersConnected;                                            // The current count of players connected.
-        volatile short        m_controllersConnected;                                        // Similar, but tracks internally whether each controller is connected.
-        double                m_lastTimeCheckedXInputConnection[XINPUT_MAX_CONTROLLERS];     // Array of the times each controller was last checked for connectivity.
+        volatile short                  m_playersConnected;         // The current count of players connected.
+        volatile short                  m_controllersConnected;     // Similar, but tracks internally whether each controller is connected.
+        std::unique_ptr<GamepadPoller>  m_gamepadPoller;            // Samples the controllers on its own thread.
+        LONGLONG                        m_lastXInputQuery;          // End of the interval the last UpdateXInputState covered.
 
 
     private: // Private methods for processing input data.
 
         //
-        // Universal input processing methods
+        // Binding file methods
         //
-        void ClearInputActions(void);
-        void TranslateInputToPlayerActions(
-            _Inout_ std::vector<PlayerInputData>* playerActions
-            );
-        void AddPlayerActionToMap(
-            _In_ PlayerInputData * const playerInput
-            );
-        void UpdateLastFrameActionMap(void);
-        void AddTransitoryStatesToEventMap(void);
-        void ProcessStatesToPlayerActions(
-            _Inout_ std::vector<PlayerInputData>* playerActions
+        void ReloadBindingsIfChanged(void);
+        static void LoadBindings(
+            _In_ BindingsSource* source
             );
 
         //
@@ -465,35 +184,12 @@ namespace DirectXGame2
             _In_ PointerEventArgs^ pointerArgs,
             _Out_ PointerControllerAction * pointerAction
             );
-        void TranslateTouchPointerActionsToPlayerActionsMap(void);
-        void TranslateMousePointerActionsToPlayerActionsMap(void);
-        float InputManager::ComputeThumbstickMagnitudeFactor(
-            _In_ float const stickX,
-            _In_ float const stickY,
-            _In_ int   const deadZone,
-            _In_ float const maxThrow
-            );
-
-        //
-        // Keyboard methods
-        //
-        void TranslateKeyboardToPlayerActionsMap(void);
 
         //
         // XInput methods
         //
         void UpdateXInputState(void);
 
-        // Converts raw XInput data into specific player actions.
-        void TranslateXInputToPlayerActionMap(void);
-
-        //
-        // Touch region methods
-        //
-        int IsTouchdownInRegion(
-            _In_ XMFLOAT2 touchDownPoint
-            );
-
     private: // Private ref class to encapsulate CoreWindow events.
 
         //
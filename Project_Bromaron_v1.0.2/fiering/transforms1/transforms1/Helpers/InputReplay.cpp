@@ -0,0 +1,365 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "InputReplay.h"
+
+using namespace DirectXGame2;
+
+namespace
+{
+    // Log layout, all values little endian:
+    //
+    //   header   magic u32, version u32, seed u32, tick count u32, target elapsed ticks u64
+    //   tick     state checksum u32, action count u16, then that many actions
+    //   action   ID u8, PlayerAction u8, flags u8, firetype i8, float mask u16,
+    //            then one f32 for every bit set in the mask
+    const size_t HeaderBytes = 24;
+    const size_t ActionFixedBytes = 6;
+
+    const unsigned char ActionFlagTouch = 0x01;
+    const unsigned char ActionFlagFiring = 0x02;
+
+    // Float fields in mask bit order.
+    float PlayerInputData::* const FloatFields[] =
+    {
+        &PlayerInputData::NormalizedInputValue,
+        &PlayerInputData::X,
+        &PlayerInputData::Y,
+        &PlayerInputData::Roll,
+        &PlayerInputData::Pitch,
+        &PlayerInputData::Yaw,
+        &PlayerInputData::laserPitch,
+        &PlayerInputData::laserYaw,
+        &PlayerInputData::PointerRawX,
+        &PlayerInputData::PointerRawY,
+        &PlayerInputData::PointerThrowX,
+        &PlayerInputData::PointerThrowY,
+    };
+
+    const unsigned int FloatFieldCount = ARRAYSIZE(FloatFields);
+
+    template<typename T>
+    void Append(std::vector<unsigned char>& data, T value)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    bool Read(const std::vector<unsigned char>& data, size_t& cursor, T* value)
+    {
+        // cursor can be past the end when Load peeks ahead into a cut-off action.
+        if ((cursor > data.size()) || (data.size() - cursor < sizeof(T)))
+        {
+            return false;
+        }
+
+        memcpy(value, &data[cursor], sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    // Number of bytes of floats that follow an action with this mask.
+    size_t MaskedFloatBytes(unsigned short mask)
+    {
+        size_t bytes = 0;
+        for (unsigned int f = 0; f < FloatFieldCount; f++)
+        {
+            if (mask & (1 << f))
+            {
+                bytes += sizeof(float);
+            }
+        }
+        return bytes;
+    }
+
+    bool ReadAction(const std::vector<unsigned char>& data, size_t& cursor, PlayerInputData* action)
+    {
+        unsigned char id, playerAction, flags;
+        signed char firetype;
+        unsigned short mask;
+
+        if (!Read(data, cursor, &id) ||
+            !Read(data, cursor, &playerAction) ||
+            !Read(data, cursor, &flags) ||
+            !Read(data, cursor, &firetype) ||
+            !Read(data, cursor, &mask))
+        {
+            return false;
+        }
+
+        *action = PlayerInputData();
+        action->ID = id;
+        action->PlayerAction = static_cast<PLAYER_ACTION_TYPES>(playerAction);
+        action->IsTouchAction = (flags & ActionFlagTouch) != 0;
+        action->isFiring = (flags & ActionFlagFiring) != 0;
+        action->firetype = firetype;
+
+        for (unsigned int f = 0; f < FloatFieldCount; f++)
+        {
+            float value = 0.f;
+            if ((mask & (1 << f)) && !Read(data, cursor, &value))
+            {
+                return false;
+            }
+            action->*FloatFields[f] = value;
+        }
+
+        return true;
+    }
+
+    bool ReadFile(const std::wstring& path, std::vector<unsigned char>* data)
+    {
+        FILE* file = nullptr;
+        if (_wfopen_s(&file, path.c_str(), L"rb") != 0 || file == nullptr)
+        {
+            return false;
+        }
+
+        bool succeeded = false;
+        if (fseek(file, 0, SEEK_END) == 0)
+        {
+            long size = ftell(file);
+            if ((size >= 0) && (fseek(file, 0, SEEK_SET) == 0))
+            {
+                data->resize(static_cast<size_t>(size));
+                succeeded = (size == 0) || (fread(&(*data)[0], 1, data->size(), file) == data->size());
+            }
+        }
+
+        fclose(file);
+        return succeeded;
+    }
+}
+
+InputRecorder::InputRecorder() :
+    m_isRecording(false),
+    m_seed(0),
+    m_targetElapsedTicks(0),
+    m_tickCount(0)
+{
+}
+
+void InputRecorder::Begin(unsigned int seed, unsigned long long targetElapsedTicks)
+{
+    m_seed = seed;
+    m_targetElapsedTicks = targetElapsedTicks;
+    m_tickCount = 0;
+    m_data.clear();
+    m_data.reserve(64 * 1024);
+    m_isRecording = true;
+}
+
+void InputRecorder::RecordTick(unsigned int stateChecksum, const PlayerInputData* playerActions, unsigned int count)
+{
+    if (!m_isRecording)
+    {
+        return;
+    }
+
+    // Stop at the size cap rather than dropping ticks from the middle of the log.
+    size_t worstCase = sizeof(unsigned int) + sizeof(unsigned short) + count * (ActionFixedBytes + FloatFieldCount * sizeof(float));
+    if (m_data.size() + worstCase > INPUT_LOG_MAX_BYTES)
+    {
+        m_isRecording = false;
+        return;
+    }
+
+    Append(m_data, stateChecksum);
+    Append(m_data, static_cast<unsigned short>(count));
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const PlayerInputData& action = playerActions[i];
+
+        unsigned short mask = 0;
+        for (unsigned int f = 0; f < FloatFieldCount; f++)
+        {
+            if (action.*FloatFields[f] != 0.f)
+            {
+                mask |= static_cast<unsigned short>(1 << f);
+            }
+        }
+
+        unsigned char flags = 0;
+        if (action.IsTouchAction) flags |= ActionFlagTouch;
+        if (action.isFiring) flags |= ActionFlagFiring;
+
+        Append(m_data, static_cast<unsigned char>(action.ID));
+        Append(m_data, static_cast<unsigned char>(action.PlayerAction));
+        Append(m_data, flags);
+        Append(m_data, static_cast<signed char>(action.firetype));
+        Append(m_data, mask);
+
+        for (unsigned int f = 0; f < FloatFieldCount; f++)
+        {
+            if (mask & (1 << f))
+            {
+                Append(m_data, action.*FloatFields[f]);
+            }
+        }
+    }
+
+    m_tickCount++;
+}
+
+bool InputRecorder::Save(const std::wstring& path) const
+{
+    std::vector<unsigned char> header;
+    header.reserve(HeaderBytes);
+    Append(header, static_cast<unsigned int>(INPUT_LOG_MAGIC));
+    Append(header, static_cast<unsigned int>(INPUT_LOG_VERSION));
+    Append(header, m_seed);
+    Append(header, m_tickCount);
+    Append(header, m_targetElapsedTicks);
+
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, path.c_str(), L"wb") != 0 || file == nullptr)
+    {
+        return false;
+    }
+
+    bool succeeded = fwrite(&header[0], 1, header.size(), file) == header.size();
+    if (succeeded && !m_data.empty())
+    {
+        succeeded = fwrite(&m_data[0], 1, m_data.size(), file) == m_data.size();
+    }
+
+    fclose(file);
+    return succeeded;
+}
+
+InputReplay::InputReplay() :
+    m_seed(0),
+    m_targetElapsedTicks(0),
+    m_tickCount(0),
+    m_ticksPlayed(0),
+    m_cursor(0)
+{
+}
+
+bool InputReplay::Load(const std::wstring& path)
+{
+    *this = InputReplay();
+
+    std::vector<unsigned char> data;
+    if (!ReadFile(path, &data))
+    {
+        return false;
+    }
+
+    size_t cursor = 0;
+    unsigned int magic, version, seed, tickCount;
+    unsigned long long targetElapsedTicks;
+
+    if (!Read(data, cursor, &magic) ||
+        !Read(data, cursor, &version) ||
+        !Read(data, cursor, &seed) ||
+        !Read(data, cursor, &tickCount) ||
+        !Read(data, cursor, &targetElapsedTicks))
+    {
+        return false;
+    }
+
+    if ((magic != INPUT_LOG_MAGIC) || (version != INPUT_LOG_VERSION) || (targetElapsedTicks == 0))
+    {
+        return false;
+    }
+
+    // Walk every tick up front so that NextTick() never meets a truncated record.
+    size_t tickCursor = cursor;
+    for (unsigned int t = 0; t < tickCount; t++)
+    {
+        unsigned int stateChecksum;
+        unsigned short actionCount;
+        if (!Read(data, tickCursor, &stateChecksum) ||
+            !Read(data, tickCursor, &actionCount))
+        {
+            return false;
+        }
+
+        for (unsigned int a = 0; a < actionCount; a++)
+        {
+            unsigned short mask;
+            size_t maskCursor = tickCursor + ActionFixedBytes - sizeof(mask);
+            if (!Read(data, maskCursor, &mask))
+            {
+                return false;
+            }
+
+            size_t actionBytes = ActionFixedBytes + MaskedFloatBytes(mask);
+            if (data.size() - tickCursor < actionBytes)
+            {
+                return false;
+            }
+            tickCursor += actionBytes;
+        }
+    }
+
+    m_seed = seed;
+    m_targetElapsedTicks = targetElapsedTicks;
+    m_tickCount = tickCount;
+    m_cursor = cursor;
+    m_data.swap(data);
+
+    return true;
+}
+
+bool InputReplay::NextTick(PlayerInputData* playerActions, unsigned int capacity, unsigned int* count, unsigned int* stateChecksum)
+{
+    *count = 0;
+    *stateChecksum = 0;
+
+    if (IsFinished())
+    {
+        return false;
+    }
+
+    unsigned short actionCount = 0;
+    Read(m_data, m_cursor, stateChecksum);
+    Read(m_data, m_cursor, &actionCount);
+
+    for (unsigned int a = 0; a < actionCount; a++)
+    {
+        PlayerInputData action;
+        ReadAction(m_data, m_cursor, &action);
+
+        // Actions beyond capacity are skipped; the log itself stays in step.
+        if (*count < capacity)
+        {
+            playerActions[(*count)++] = action;
+        }
+    }
+
+    m_ticksPlayed++;
+    return true;
+}
+
+void InputReplay::Rewind()
+{
+    m_cursor = m_data.empty() ? 0 : HeaderBytes;
+    m_ticksPlayed = 0;
+}
+
+bool InputReplay::WriteTimingCsv(const std::wstring& path, const std::vector<ReplayFrameTiming>& timings)
+{
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, path.c_str(), L"w") != 0 || file == nullptr)
+    {
+        return false;
+    }
+
+    bool succeeded = fprintf(file, "frame,update_ms,render_ms,desyncs,allocs\n") > 0;
+    for (size_t i = 0; succeeded && (i < timings.size()); i++)
+    {
+        succeeded = fprintf(file, "%u,%.4f,%.4f,%u,%u\n", static_cast<unsigned int>(i), timings[i].UpdateMilliseconds, timings[i].RenderMilliseconds, timings[i].Desyncs, timings[i].Allocations) > 0;
+    }
+
+    fclose(file);
+    return succeeded;
+}
@@ -0,0 +1,116 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "InputTypes.h"
+
+namespace DirectXGame2
+{
+    // Identifies an input log ("BRIL" in a hex dump) and its layout.
+#define INPUT_LOG_MAGIC                 0x4C495242
+#define INPUT_LOG_VERSION               2
+
+    // A recording stops growing once it reaches this size, about two hours
+    // of typical play at 60 ticks per second.
+#define INPUT_LOG_MAX_BYTES             (16 * 1024 * 1024)
+
+    // Time spent on one replayed frame, for the timing CSV, how many of the
+    // frame's ticks left the simulation in a different state than the
+    // recording did, and how many heap allocations the previous frame made
+    // (always zero unless ALLOCATION_TRACKING is on).
+    struct ReplayFrameTiming
+    {
+        float           UpdateMilliseconds;
+        float           RenderMilliseconds;
+        unsigned int    Desyncs;
+        unsigned int    Allocations;
+    };
+
+    //
+    // The InputRecorder class captures the player actions the simulation
+    // consumes on each fixed-timestep tick, together with the seed the scene
+    // was built from, so that a session can be replayed exactly.
+    //
+    // Each tick is stored as a checksum of the simulation state, an action
+    // count and the actions. Float fields that are zero are left out and
+    // flagged in a per-action mask, so an idle tick costs six bytes and a
+    // typical move action about a dozen. Arrival timestamps are not recorded.
+    //
+    // Usage:
+    // 1. Call Begin() with the scene seed and the timer's fixed step.
+    // 2. Call RecordTick() once per simulation tick with the state checksum
+    //    and that tick's actions.
+    // 3. Call Save() to write the log out; recording carries on afterwards.
+    //
+    class InputRecorder
+    {
+    public:
+        InputRecorder();
+
+        void Begin(unsigned int seed, unsigned long long targetElapsedTicks);
+        void End()                                  { m_isRecording = false; }
+        bool IsRecording() const                    { return m_isRecording; }
+
+        void RecordTick(unsigned int stateChecksum, const PlayerInputData* playerActions, unsigned int count);
+
+        unsigned int GetTickCount() const           { return m_tickCount; }
+
+        // Writes the header and every tick recorded so far to path.
+        bool Save(const std::wstring& path) const;
+
+    private:
+        bool                        m_isRecording;
+        unsigned int                m_seed;
+        unsigned long long          m_targetElapsedTicks;
+        unsigned int                m_tickCount;
+        std::vector<unsigned char>  m_data;
+    };
+
+    //
+    // The InputReplay class plays back a log written by InputRecorder, one
+    // tick of player actions per call to NextTick().
+    //
+    // The replayed session only matches the recorded one if the scene is
+    // built from GetSeed() and the timer runs at GetTargetElapsedTicks().
+    //
+    class InputReplay
+    {
+    public:
+        InputReplay();
+
+        // Reads and validates a whole log. Returns false if the file is
+        // missing or malformed, leaving the replay empty.
+        bool Load(const std::wstring& path);
+
+        unsigned int GetSeed() const                        { return m_seed; }
+        unsigned long long GetTargetElapsedTicks() const    { return m_targetElapsedTicks; }
+        unsigned int GetTickCount() const                   { return m_tickCount; }
+        unsigned int GetTicksPlayed() const                 { return m_ticksPlayed; }
+        bool IsFinished() const                             { return m_ticksPlayed >= m_tickCount; }
+
+        // Copies the next tick's actions into playerActions, and the state
+        // checksum recorded with them into stateChecksum. Returns false once
+        // every tick has been played.
+        bool NextTick(PlayerInputData* playerActions, unsigned int capacity, unsigned int* count, unsigned int* stateChecksum);
+
+        void Rewind();
+
+        // Writes one "frame,update_ms,render_ms,desyncs,allocs" row per entry.
+        static bool WriteTimingCsv(const std::wstring& path, const std::vector<ReplayFrameTiming>& timings);
+
+    private:
+        unsigned int                m_seed;
+        unsigned long long          m_targetElapsedTicks;
+        unsigned int                m_tickCount;
+        unsigned int                m_ticksPlayed;
+        size_t                      m_cursor;
+        std::vector<unsigned char>  m_data;
+    };
+}
@@ -0,0 +1,184 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+// Fixed-capacity tables for the input manager's per-frame state. None of
+// these allocate after construction.
+
+namespace DirectXGame2
+{
+    // Number of virtual key codes tracked by KeyStateTable.
+#define INPUT_MAX_VIRTUAL_KEYS          256
+
+    // Number of pointers (mouse, pen and touch contacts) that can be tracked at once.
+#define INPUT_MAX_POINTER_SLOTS         16
+
+    //
+    // Set of keys currently held, indexed directly by virtual key code.
+    //
+    class KeyStateTable
+    {
+    public:
+        KeyStateTable()
+        {
+            Clear();
+        }
+
+        // timestamp is when the key went down; repeats of a held key keep the first one.
+        void SetDown(unsigned int key, long long timestamp = 0)
+        {
+            if ((key < INPUT_MAX_VIRTUAL_KEYS) && !m_down[key])
+            {
+                m_down[key] = true;
+                m_downTime[key] = timestamp;
+                m_count++;
+            }
+        }
+
+        void SetUp(unsigned int key)
+        {
+            if ((key < INPUT_MAX_VIRTUAL_KEYS) && m_down[key])
+            {
+                m_down[key] = false;
+                m_count--;
+            }
+        }
+
+        bool IsDown(unsigned int key) const     { return (key < INPUT_MAX_VIRTUAL_KEYS) && m_down[key]; }
+
+        // Timestamp passed to SetDown for a held key, 0 otherwise.
+        long long GetDownTime(unsigned int key) const   { return IsDown(key) ? m_downTime[key] : 0; }
+
+        // Number of keys currently held.
+        unsigned int GetCount() const           { return m_count; }
+
+        void Clear()
+        {
+            for (unsigned int i = 0; i < INPUT_MAX_VIRTUAL_KEYS; i++)
+            {
+                m_down[i] = false;
+            }
+            m_count = 0;
+        }
+
+    private:
+        bool            m_down[INPUT_MAX_VIRTUAL_KEYS];
+        long long       m_downTime[INPUT_MAX_VIRTUAL_KEYS];
+        unsigned int    m_count;
+    };
+
+    //
+    // Small table of values keyed by pointer ID.
+    //
+    // Pointer IDs are arbitrary (touch contacts get a new one per press), so
+    // entries live in a fixed array of slots and are found by a linear scan;
+    // with a handful of pointers this beats hashing. Slots don't move when
+    // another entry is erased, so a loop over the slots may erase the slot
+    // it's looking at.
+    //
+    // Usage:
+    //     for (unsigned int i = 0; i < table.GetSlotCount(); i++)
+    //     {
+    //         if (!table.IsSlotUsed(i)) continue;
+    //         ... table.GetSlotId(i), table.GetSlotValue(i) ...
+    //     }
+    //
+    template<typename T, unsigned int Capacity = INPUT_MAX_POINTER_SLOTS>
+    class PointerSlotTable
+    {
+    public:
+        PointerSlotTable()
+        {
+            Clear();
+        }
+
+        // Returns the value stored for pointerId, or nullptr.
+        T* Find(unsigned int pointerId)
+        {
+            for (unsigned int i = 0; i < Capacity; i++)
+            {
+                if (m_used[i] && (m_ids[i] == pointerId))
+                {
+                    return &m_values[i];
+                }
+            }
+
+            return nullptr;
+        }
+
+        // Adds value for pointerId unless the pointer already has an entry,
+        // in which case the existing value is kept. Returns false if the
+        // pointer was already present or the table is full.
+        bool Emplace(unsigned int pointerId, const T& value)
+        {
+            if (Find(pointerId) != nullptr)
+            {
+                return false;
+            }
+
+            for (unsigned int i = 0; i < Capacity; i++)
+            {
+                if (!m_used[i])
+                {
+                    m_used[i] = true;
+                    m_ids[i] = pointerId;
+                    m_values[i] = value;
+                    m_count++;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void Erase(unsigned int pointerId)
+        {
+            for (unsigned int i = 0; i < Capacity; i++)
+            {
+                if (m_used[i] && (m_ids[i] == pointerId))
+                {
+                    EraseSlot(i);
+                    return;
+                }
+            }
+        }
+
+        void EraseSlot(unsigned int slot)
+        {
+            if (m_used[slot])
+            {
+                m_used[slot] = false;
+                m_count--;
+            }
+        }
+
+        void Clear()
+        {
+            for (unsigned int i = 0; i < Capacity; i++)
+            {
+                m_used[i] = false;
+            }
+            m_count = 0;
+        }
+
+        // Number of pointers with an entry.
+        unsigned int GetCount() const                       { return m_count; }
+
+        // Slot access, for iterating over every entry.
+        unsigned int GetSlotCount() const                   { return Capacity; }
+        bool IsSlotUsed(unsigned int slot) const            { return m_used[slot]; }
+        unsigned int GetSlotId(unsigned int slot) const     { return m_ids[slot]; }
+        T& GetSlotValue(unsigned int slot)                  { return m_values[slot]; }
+
+    private:
+        bool            m_used[Capacity];
+        unsigned int    m_ids[Capacity];
+        T               m_values[Capacity];
+        unsigned int    m_count;
+    };
+}
@@ -0,0 +1,996 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "InputTranslator.h"
+#include <math.h>
+#include <string.h>
+#include <utility>
+
+using namespace DirectX;
+
+using namespace DirectXGame2;
+
+InputTranslator::InputTranslator() :
+    m_inputTypeFilterMask(INPUT_DEVICE_TYPES::INPUT_DEVICE_ALL),
+    m_bindings(&m_noBindings),
+    m_activePlayers(0),
+    m_xinputActionCount(0)
+{
+    // init double-buffered tables
+    m_pMouseActions             = &m_mouseActionTables[0];
+    m_pMouseActionsLastFrame    = &m_mouseActionTables[1];
+    m_pTouchActions             = &m_touchActionTables[0];
+    m_pTouchActionsLastFrame    = &m_touchActionTables[1];
+    m_actionsThisFrame          = m_actionMaps[0];
+    m_actionsLastFrame          = m_actionMaps[1];
+
+    // Initialize the cache map of actions taken in the previous frame.
+    memset(m_actionMaps, 0, sizeof(m_actionMaps));
+    memset(m_xinputActions, 0, sizeof(m_xinputActions));
+    for (unsigned int idVal = 0; idVal < XINPUT_MAX_CONTROLLERS; idVal++)
+    {
+        for (unsigned int actionVal = 0; actionVal < PLAYER_ACTION_TYPES::INPUT_MAX; actionVal++)
+        {
+            m_resolvedActionsThisFrame[idVal][actionVal] = PlayerInputData();
+        }
+    }
+}
+
+void InputTranslator::SetBindings(
+    _In_opt_ const ActionBindings* bindings
+    )
+{
+    m_bindings = (bindings != nullptr) ? bindings : &m_noBindings;
+}
+
+// Translates the input given since the last call into player actions, writes
+// them to the caller's buffer, and returns how many were written.
+unsigned int InputTranslator::Translate(
+    _Out_writes_to_(capacity, return) PlayerInputData* playerActions,
+    _In_ unsigned int capacity
+    )
+{
+    if (playerActions == nullptr) return 0;
+
+    // First, clear the map of current actions.
+    memset(m_actionsThisFrame, 0, sizeof(bool) * XINPUT_MAX_CONTROLLERS * PLAYER_ACTION_TYPES::INPUT_MAX);
+    m_activePlayers = 0;
+
+    // First process the XInput action vector.
+    if ((m_inputTypeFilterMask & INPUT_DEVICE_TYPES::INPUT_DEVICE_XINPUT) == INPUT_DEVICE_TYPES::INPUT_DEVICE_XINPUT)
+    {
+        TranslateXInputToPlayerActionMap();
+    }
+
+    // Now, process the Keyboard queue and update the action map.
+    if ((m_inputTypeFilterMask & INPUT_DEVICE_TYPES::INPUT_DEVICE_KEYBOARD) == INPUT_DEVICE_TYPES::INPUT_DEVICE_KEYBOARD)
+    {
+        // Process keyboard events received since the last frame.
+        TranslateKeyboardToPlayerActionsMap();
+    }
+
+    // Last, process the Pointer queue and update the action map (Mouse and Touch).
+    if ((m_inputTypeFilterMask & INPUT_DEVICE_TYPES::INPUT_DEVICE_TOUCH) == INPUT_DEVICE_TYPES::INPUT_DEVICE_TOUCH)
+    {
+        // Process pointer events received since the last frame.
+        TranslateTouchPointerActionsToPlayerActionsMap();
+
+        // Process mouse events received since the last frame.
+        TranslateMousePointerActionsToPlayerActionsMap();
+    }
+
+    // Now, if the state for any of the digital controls changed since the last frame, set the appropriate transitory state.
+    AddTransitoryStatesToEventMap();
+
+    // Process the set of input states into the client code's buffer.
+    unsigned int count = ProcessStatesToPlayerActions(playerActions, capacity);
+    
+    // Store important data for detecting state transitions between frames.
+    UpdateLastFrameActionMap();
+
+    // Clear the raw input action tables and internal input data state to prepare for the next frame.
+    ClearInputActions();
+
+    return count;
+}
+
+// Adds one controller's state for the next Translate call. Controllers that
+// aren't connected are simply not added.
+void InputTranslator::AddGamepadState(
+    _In_ unsigned int controllerId,
+    _In_ const GamepadSample& state,
+    _In_ long long timestamp
+    )
+{
+    if ((controllerId >= XINPUT_MAX_CONTROLLERS) || (m_xinputActionCount >= XINPUT_MAX_CONTROLLERS))
+    {
+        return;
+    }
+
+    XInputControllerAction& controllerInput = m_xinputActions[m_xinputActionCount++];
+    controllerInput.ControllerId = controllerId;
+    controllerInput.State = state;
+    controllerInput.Timestamp = timestamp;
+}
+
+// Adds a gameplay action to the vector returned by the input manager. This 
+// method checks for redundancy, and merges similar events obtained within 
+// the frame into each player's input state.
+void InputTranslator::AddPlayerActionToMap(
+    _In_  PlayerInputData * const playerInput
+    )
+{
+    unsigned int idVal = playerInput->ID;
+    unsigned int actionVal = playerInput->PlayerAction;
+
+    if (m_actionsThisFrame[idVal][actionVal]) // action already taken this frame
+    {
+        // Keep the arrival time of the newest event that fed this action.
+        if (playerInput->Timestamp > m_resolvedActionsThisFrame[idVal][actionVal].Timestamp)
+        {
+            m_resolvedActionsThisFrame[idVal][actionVal].Timestamp = playerInput->Timestamp;
+        }
+
+        if ((playerInput->PlayerAction == INPUT_MOVE)  || (playerInput->PlayerAction == INPUT_AIM))
+        {
+            // Resolve move conflicts with XInput and Touch controller if default pointer player ID
+            // is the same as an attached XInput controller player ID.
+            float combinedInput = m_resolvedActionsThisFrame[idVal][actionVal].NormalizedInputValue + playerInput->NormalizedInputValue;
+
+            if (combinedInput > 1.0f) m_resolvedActionsThisFrame[idVal][actionVal].NormalizedInputValue = 1.0f; // ceiling combined positive input
+            else if (combinedInput < -1.0f) m_resolvedActionsThisFrame[idVal][actionVal].NormalizedInputValue = -1.0f; // floor combined negative input
+            else m_resolvedActionsThisFrame[idVal][actionVal].NormalizedInputValue = combinedInput; // add combined input to resolved actions map
+
+            float combinedInputX = m_resolvedActionsThisFrame[idVal][actionVal].X + playerInput->X;
+            if (combinedInputX > 1.0f) m_resolvedActionsThisFrame[idVal][actionVal].X = 1.0f; // ceiling combined positive X direction input
+            else if (combinedInputX < -1.0f) m_resolvedActionsThisFrame[idVal][actionVal].X = -1.0f; // floor combined negative X input
+            else m_resolvedActionsThisFrame[idVal][actionVal].X = combinedInputX; // add combined X direction input to resolved actions map
+
+            float combinedInputY = m_resolvedActionsThisFrame[idVal][actionVal].Y + playerInput->Y;
+            if (combinedInputY > 1.0f) m_resolvedActionsThisFrame[idVal][actionVal].Y = 1.0f; // ceiling combined positive Y direction input
+            else if (combinedInputY < -1.0f) m_resolvedActionsThisFrame[idVal][actionVal].Y = -1.0f; // floor combined negative Y input
+            else m_resolvedActionsThisFrame[idVal][actionVal].Y = combinedInputY; // add combined Y direction input to resolved actions map
+
+            if (playerInput->IsTouchAction)
+            {
+                m_resolvedActionsThisFrame[idVal][actionVal].PointerRawX   = playerInput->PointerRawX;
+                m_resolvedActionsThisFrame[idVal][actionVal].PointerRawY   = playerInput->PointerRawY;
+                m_resolvedActionsThisFrame[idVal][actionVal].PointerThrowX = playerInput->PointerThrowX;
+                m_resolvedActionsThisFrame[idVal][actionVal].PointerThrowY = playerInput->PointerThrowY;
+                m_resolvedActionsThisFrame[idVal][actionVal].IsTouchAction = true;
+            }
+        }
+    }
+    else
+    {
+        // since this input is new this frame there is no resolve action needed. Add directly to input map.
+        m_resolvedActionsThisFrame[idVal][actionVal] = *playerInput;
+        m_actionsThisFrame[idVal][actionVal] = true;
+    }
+}
+
+// Adds the merged result of the bindings for one action.
+void InputTranslator::AddBoundActionToMap(
+    _In_ unsigned int playerId,
+    _In_ const BoundAction& boundAction
+    )
+{
+    PlayerInputData playerInput;
+    playerInput.ID                   = playerId;
+    playerInput.PlayerAction         = static_cast<PLAYER_ACTION_TYPES>(boundAction.Action);
+    playerInput.NormalizedInputValue = boundAction.Value;
+    playerInput.X                    = boundAction.X;
+    playerInput.Y                    = boundAction.Y;
+    playerInput.Roll                 = boundAction.Roll;
+    playerInput.Pitch                = boundAction.Pitch;
+    playerInput.Yaw                  = boundAction.Yaw;
+    playerInput.laserPitch           = boundAction.LaserPitch;
+    playerInput.laserYaw             = boundAction.LaserYaw;
+    playerInput.isFiring             = boundAction.IsFiring;
+    playerInput.firetype             = boundAction.FireType;
+    playerInput.Timestamp            = boundAction.Timestamp;
+
+    AddPlayerActionToMap(&playerInput);
+}
+
+// Perform a cleanup pass resolving all state transitions (PRESSED, RELEASED et al) within the action buffer.
+unsigned int InputTranslator::ProcessStatesToPlayerActions(
+    _Out_writes_to_(capacity, return) PlayerInputData* playerActions,
+    _In_ unsigned int capacity
+    )
+{
+    unsigned int count = 0;
+
+    for (unsigned int idVal = 0; idVal < XINPUT_MAX_CONTROLLERS; idVal++)
+    {
+        for (unsigned int actionVal = 0; actionVal < PLAYER_ACTION_TYPES::INPUT_MAX; actionVal++)
+        {
+            // First, check if this a buttons state processing effort 
+            if (m_actionsThisFrame[idVal][actionVal] && (count < capacity))
+            {
+                playerActions[count++] = m_resolvedActionsThisFrame[idVal][actionVal];
+            }
+        }
+    }
+
+    return count;
+}
+
+// After the player gameplay inputs have been interpreted, update an internal map
+// so the next frame knows what was performed by the player in this frame.
+void InputTranslator::UpdateLastFrameActionMap()
+{    
+    // Keep mouse pointer actions that occurred this frame. The tables swap, and
+    // ClearInputActions empties the old last-frame table for reuse.
+    if (m_pMouseActions->GetCount() > 0)
+    {
+        std::swap(m_pMouseActions, m_pMouseActionsLastFrame);
+    }
+
+    // Keep touch pointer actions that occurred this frame.
+    if (m_pTouchActions->GetCount() > 0)
+    {
+        std::swap(m_pTouchActions, m_pTouchActionsLastFrame);
+    }
+
+    // The current frame's action map becomes the last frame's; the next
+    // GetPlayersActions call clears the other one before it is filled.
+    std::swap(m_actionsThisFrame, m_actionsLastFrame);
+}
+
+// For each possible digital action, checks for a change in state between the 
+// previous frame and the current frame.
+void InputTranslator::AddTransitoryStatesToEventMap(void)
+{
+
+    // Note that the input manager does not check analog actions for state 
+    // transitions. It is up to the game to account for (and respond to 
+    // changes) in analog state in a way that's appropriate for gameplay.
+    for (unsigned int idVal = 0; idVal < XINPUT_MAX_CONTROLLERS; idVal++)
+    {
+        for (unsigned int actionVal = 0; actionVal < PLAYER_ACTION_TYPES::INPUT_MAX; actionVal++)
+        {
+            if (m_actionsLastFrame[idVal][actionVal] != m_actionsThisFrame[idVal][actionVal])
+            {
+                PLAYER_ACTION_TYPES action = PLAYER_ACTION_TYPES::INPUT_NONE;
+
+                switch ((PLAYER_ACTION_TYPES)actionVal)
+                {
+                case INPUT_FIRE_DOWN:
+                    if (m_actionsThisFrame[idVal][actionVal])
+                    {
+                        action = INPUT_FIRE_PRESSED;
+                    }
+                    else
+                    {
+                        action = INPUT_FIRE_RELEASED;
+                    }
+                    break;
+
+                case INPUT_JUMP_DOWN:
+                    if (m_actionsThisFrame[idVal][actionVal])
+                    {
+                        action = INPUT_JUMP_PRESSED;
+                    }
+                    else
+                    {
+                        action = INPUT_JUMP_RELEASED;
+                    }
+                    break;
+
+                default:
+                    break;
+                };
+
+                if (action != PLAYER_ACTION_TYPES::INPUT_NONE)
+                {
+                    PlayerInputData playerInput;
+
+                    playerInput.ID = idVal;
+                    playerInput.PlayerAction = action;
+                    playerInput.NormalizedInputValue = 1.0f;
+
+                    // A press carries the stamp of the input that caused it.
+                    if (m_actionsThisFrame[idVal][actionVal])
+                    {
+                        playerInput.Timestamp = m_resolvedActionsThisFrame[idVal][actionVal].Timestamp;
+                    }
+
+                    m_resolvedActionsThisFrame[idVal][static_cast<int>(action)] = playerInput;
+                    m_actionsThisFrame[idVal][static_cast<int>(action)] = true;
+                }
+            }
+        }
+    }
+}
+
+// Applies one keyboard or pointer event to the keyboard and pointer input maps.
+void InputTranslator::ApplyRawInputEvent(
+    _In_ const RawInputEvent& rawEvent
+    )
+{
+    if (rawEvent.Device == INPUT_DEVICE_TYPES::INPUT_DEVICE_KEYBOARD)
+    {
+        if (rawEvent.Type == INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_DOWN)
+        {
+            // Keys always belong to the default keyboard player. Repeated
+            // key-down events for a held key are ignored.
+            m_keyboardState.SetDown(rawEvent.VirtualKey, rawEvent.Timestamp);
+        }
+        else if (rawEvent.Type == INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_UP)
+        {
+            // key is released, remove from input table.
+            m_keyboardState.SetUp(rawEvent.VirtualKey);
+        }
+
+        return;
+    }
+
+    const PointerControllerAction& pointerAction = rawEvent.Pointer;
+
+    if (rawEvent.Type == INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_DOWN)
+    {
+        // Set the pointer ID and coordinate tuple for the touch down point (i.e. where the
+        // press event started).
+        XMFLOAT2 touchDownCoords = XMFLOAT2(pointerAction.CurrentX, pointerAction.CurrentY);
+
+        // Add the pointer action to the persistent state table.
+        m_touchDownPoints.Emplace(pointerAction.PointerId, touchDownCoords);
+    }
+    else if ((rawEvent.Type == INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_UP) || (rawEvent.Type == INPUT_EVENT_TYPE::INPUT_EVENT_TYPE_EXITED))
+    {
+        // The touchdown point is still needed while this frame is translated;
+        // drop it once the frame is done.
+        m_releasedPointers.Emplace(pointerAction.PointerId, true);
+    }
+
+    if (pointerAction.IsTouchEvent)
+    {
+        // Add the pointer action to the pointer action table.
+        m_pTouchActions->Emplace(pointerAction.PointerId, pointerAction);
+    }
+    else
+    {
+        // Add the pointer action to the pointer action table.
+        m_pMouseActions->Emplace(pointerAction.PointerId, pointerAction);
+    }
+}
+
+// Clears the XInput raw input list, pointer input list, and any state variables that only count for a single frame.
+void InputTranslator::ClearInputActions()
+{
+    // Clear the XInput input action list.
+    m_xinputActionCount = 0;
+
+    // Clear the mouse pointer input action table. 
+    m_pMouseActions->Clear();
+
+    // Clear the touch pointer input action table. 
+    m_pTouchActions->Clear();
+
+    // Forget where released pointers touched down.
+    for (unsigned int slot = 0; slot < m_releasedPointers.GetSlotCount(); slot++)
+    {
+        if (m_releasedPointers.IsSlotUsed(slot))
+        {
+            m_touchDownPoints.Erase(m_releasedPointers.GetSlotId(slot));
+        }
+    }
+    m_releasedPointers.Clear();
+};
+
+// Converts XInput controller input data to player gameplay actions.
+void InputTranslator::TranslateXInputToPlayerActionMap()
+{
+    // Interpret queues and add actions to playerActions queue.
+    for (unsigned int i = 0; i != m_xinputActionCount; i++)
+    {
+        // Set up a player input data structure.
+        PlayerInputData playerInput;
+        playerInput.ID = (PLAYER_ID) m_xinputActions[i].ControllerId;
+        playerInput.Timestamp = m_xinputActions[i].Timestamp;
+
+        /*
+        NOTE: The wButton bitmask is defined as follows (from XInput.h):
+
+        XINPUT_GAMEPAD_DPAD_UP          0x0001
+        XINPUT_GAMEPAD_DPAD_DOWN        0x0002
+        XINPUT_GAMEPAD_DPAD_LEFT        0x0004 
+        XINPUT_GAMEPAD_DPAD_RIGHT       0x0008
+        XINPUT_GAMEPAD_START            0x0010
+        XINPUT_GAMEPAD_BACK             0x0020
+        XINPUT_GAMEPAD_LEFT_THUMB       0x0040 -- l-stick click in
+        XINPUT_GAMEPAD_RIGHT_THUMB      0x0080 -- r-stick click in
+        XINPUT_GAMEPAD_LEFT_SHOULDER    0x0100
+        XINPUT_GAMEPAD_RIGHT_SHOULDER   0x0200
+        XINPUT_GAMEPAD_A                0x1000
+        XINPUT_GAMEPAD_B                0x2000
+        XINPUT_GAMEPAD_X                0x4000
+        XINPUT_GAMEPAD_Y                0x8000
+        */
+
+        // All digital inputs are set to a value of 1.0f for usage convenience.
+        
+        //
+        // NOTE TO DEVELOPER: The following section of code is where you add 
+        // or update behaviors for different XInput input actions. Use this 
+        // implementation as a template when adding your own behaviors.
+        //
+
+        // Handle button presses. Buttons, and the triggers when treated as
+        // digital, are mapped to actions by the gamepad section of bindings.txt.
+        unsigned int buttons = m_xinputActions[i].State.Buttons;
+        if (m_xinputActions[i].State.LeftTrigger > 0)  buttons |= ACTION_BINDING_PAD_LEFT_TRIGGER;
+        if (m_xinputActions[i].State.RightTrigger > 0) buttons |= ACTION_BINDING_PAD_RIGHT_TRIGGER;
+
+        BoundAction boundActions[PLAYER_ACTION_TYPES::INPUT_MAX];
+        unsigned int boundActionCount = m_bindings->TranslateGamepad(
+            buttons,
+            m_xinputActions[i].Timestamp,
+            boundActions,
+            PLAYER_ACTION_TYPES::INPUT_MAX
+            );
+
+        for (unsigned int j = 0; j < boundActionCount; j++)
+        {
+            AddBoundActionToMap(playerInput.ID, boundActions[j]);
+        }
+
+        // Handle analog inputs.
+
+        // Handle trigger inputs.
+        if (m_xinputActions[i].State.LeftTrigger > 0)
+        {
+            // NOTE:  Value is between 0.f and 256.f. However, analog triggers often have a max value slightly less than 256.f.
+            const float padding = 256.f * 0.99f;
+            float paddedValue = (float) m_xinputActions[i].State.LeftTrigger / (padding);
+
+            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_BRAKE;
+            playerInput.NormalizedInputValue = (paddedValue > 1.f) ? 1.f : paddedValue; // Check for values slightly past our padded range.
+            AddPlayerActionToMap(&playerInput);
+        }
+       
+
+        // NOTE TO DEVELOPER: Values for thumbsticks return between -32768 and 32767. The
+        // InputManager normalizes them such that all analog controls, both XInput and
+        // virtual touchscreen implementations, return a value between -1.f and 1.f.
+
+        float stickLPressMagnitude = ComputeThumbstickMagnitudeFactor(
+            (float) m_xinputActions[i].State.ThumbLX,
+            (float) m_xinputActions[i].State.ThumbLY,
+            (int) GAMEPAD_LEFT_THUMB_DEADZONE,
+            XINPUT_ANALOG_STICK_THROW_MAX
+            );
+
+        float stickRPressMagnitude = ComputeThumbstickMagnitudeFactor(
+            (float) m_xinputActions[i].State.ThumbRX,
+            (float) m_xinputActions[i].State.ThumbRY,
+            (int) GAMEPAD_RIGHT_THUMB_DEADZONE,
+            XINPUT_ANALOG_STICK_THROW_MAX
+            );
+
+        if ((m_xinputActions[i].State.ThumbLX != 0) || (m_xinputActions[i].State.ThumbLY != 0))
+        {
+            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
+
+            // Normalized value of stick press in X direction
+            playerInput.X =
+                (float) m_xinputActions[i].State.ThumbLX * stickLPressMagnitude / XINPUT_ANALOG_STICK_THROW_MAX;
+
+            // Normalized value of stick press in Y direction
+            playerInput.Y =
+                (float) m_xinputActions[i].State.ThumbLY * stickLPressMagnitude / XINPUT_ANALOG_STICK_THROW_MAX;
+            
+            playerInput.NormalizedInputValue = 1.f; // Use this field to indicate positive action.
+            AddPlayerActionToMap(&playerInput);
+        }
+
+        if ((m_xinputActions[i].State.ThumbRX != 0) || (m_xinputActions[i].State.ThumbRY != 0))
+        {
+            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_AIM;
+
+            // Normalized value of stick press in X direction
+            playerInput.X =
+                (float) m_xinputActions[i].State.ThumbRX * stickRPressMagnitude / XINPUT_ANALOG_STICK_THROW_MAX;
+
+            // Normalized value of stick press in Y direction
+            playerInput.Y =
+                (float) m_xinputActions[i].State.ThumbRY * stickRPressMagnitude / XINPUT_ANALOG_STICK_THROW_MAX;
+
+            playerInput.NormalizedInputValue = 1.f; // Use this field to indicate positive action.
+            AddPlayerActionToMap(&playerInput);
+        }
+        
+    }
+}
+
+// Compute the normalized magnitude for any analog stick operation, including both 
+// the XInput analog sticks and the touch screen virtual analog stick, and normalize
+// the input values.
+float InputTranslator::ComputeThumbstickMagnitudeFactor(
+    _In_ float const stickX, 
+    _In_ float const stickY, 
+    _In_ int   const deadZone, 
+    _In_ float const maxThrow)
+{
+    // Determine how far the controller is pushed.
+    float magnitude = sqrt(stickX*stickX + stickY*stickY);
+
+    // Avoid dividing by zero.
+    if (magnitude == 0) return magnitude;
+
+    float normalizedMagnitude = 0;
+
+    // Check if the controller is outside a circular dead zone.
+    if (magnitude > deadZone)
+    {
+        // Clip the magnitude at its expected maximum value.
+        if (magnitude > maxThrow) magnitude = maxThrow;
+
+        // Adjust magnitude relative to the end of the dead zone.
+        magnitude -= deadZone;
+        normalizedMagnitude = magnitude / (maxThrow - deadZone);
+    }
+    else // If the controller is in the deadzone zero out the magnitude:
+    {
+        magnitude = 0.0f;
+        normalizedMagnitude = 0.0f;
+    }
+
+    return normalizedMagnitude;
+}
+
+//
+// Touch region methods
+//
+
+// If the touch coordinates are in an enabled region, returns an index into the
+// region they're in, picking the highest priority one where regions overlap.
+// If the touch coordinates are not in a region, this method returns
+// INVALID_TOUCH_REGION_ID (-1).
+int InputTranslator::IsTouchdownInRegion(
+    _In_ XMFLOAT2 touchDownPoint
+    )
+{
+    // The grid only tests the regions near the point, so this stays cheap
+    // however many regions are defined.
+    int id = m_touchRegionGrid.HitTest(touchDownPoint.x, touchDownPoint.y);
+
+    return (id < 0) ? INVALID_TOUCH_REGION_ID : id;
+}
+
+void InputTranslator::EnableTouchRegion(
+    _In_ unsigned int regionId
+    )
+{
+    if (regionId < m_touchControlRegions.size())
+    {
+        m_touchControlRegions[regionId].IsEnabled = true;
+        m_touchRegionGrid.SetEnabled(regionId, true);
+    }
+}
+
+void InputTranslator::DisableTouchRegion(
+    _In_ unsigned int regionId
+    )
+{
+    if (regionId < m_touchControlRegions.size())
+    {
+        m_touchControlRegions[regionId].IsEnabled = false;
+        m_touchRegionGrid.SetEnabled(regionId, false);
+    }
+}
+
+
+// Adds a touch region. Returns 0, or one of the INVALID_TOUCH_REGION_* errors.
+int InputTranslator::SetDefinedTouchRegion(
+    _In_ const TouchControlRegion * newRegion,
+    _Out_ unsigned int& regionId
+    )
+{
+    // First, validate all parameters. Bad touch regions can create weird artifacts!
+    
+    // Are all coordinates 0.f or greater?
+    if ((newRegion->UpperLeftCoords.x  < 0.f) || (newRegion->UpperLeftCoords.y  < 0.f) ||
+        (newRegion->LowerRightCoords.x < 0.f) || (newRegion->LowerRightCoords.y < 0.f))
+    {
+        return INVALID_TOUCH_REGION_OFFSCREEN;
+    }
+
+    // Make sure the upper left coord is in fact the upper left coord, and vice versa.
+    if ((newRegion->UpperLeftCoords.x > newRegion->LowerRightCoords.x) ||
+        (newRegion->UpperLeftCoords.y > newRegion->LowerRightCoords.y))
+    {
+        return INVALID_TOUCH_REGION_INVERTED;
+    }
+
+    TouchControlRegionList::iterator iter = m_touchControlRegions.begin();
+    while (iter != m_touchControlRegions.end())
+    {
+        // Check for overlap. Overlapping regions are fine as long as the
+        // priorities say which one owns the shared area. Regions that only
+        // share an edge or a corner don't overlap; a touch right on the
+        // shared edge goes to the region added first.
+        // Note to developers: You can replace this with your own collision function.
+        if ((newRegion->Priority == iter->Priority) &&
+            !((newRegion->UpperLeftCoords.x >= iter->LowerRightCoords.x) || (newRegion->LowerRightCoords.x <= iter->UpperLeftCoords.x) ||
+              (newRegion->UpperLeftCoords.y >= iter->LowerRightCoords.y) || (newRegion->LowerRightCoords.y <= iter->UpperLeftCoords.y)))
+        {
+            return INVALID_TOUCH_REGION_OVERLAPS;
+        }
+
+        ++iter;
+    }
+
+    int gridId = m_touchRegionGrid.AddRegion(
+        newRegion->UpperLeftCoords.x,
+        newRegion->UpperLeftCoords.y,
+        newRegion->LowerRightCoords.x,
+        newRegion->LowerRightCoords.y,
+        newRegion->Priority
+        );
+
+    if (gridId < 0)
+    {
+        return INVALID_TOUCH_REGION_LIMIT;
+    }
+
+    m_touchRegionGrid.SetEnabled(gridId, newRegion->IsEnabled);
+
+    m_touchControlRegions.push_back(*newRegion);
+    regionId = m_touchControlRegions.size() - 1;
+        
+    return 0;
+}
+
+void InputTranslator::ClearTouchRegions(void)
+{
+    m_touchControlRegions.clear();
+    m_touchRegionGrid.Clear();
+}
+
+// Converts raw pointer input received from touch events into 
+// specific player gameplay input actions.
+void InputTranslator::TranslateTouchPointerActionsToPlayerActionsMap()
+{
+    // Prevents multiple touch points from providing stick input.
+    bool virtualStickProcessedThisFrame[PLAYER_ACTION_TYPES::INPUT_MAX];
+    memset(virtualStickProcessedThisFrame, 0, sizeof(bool) * PLAYER_ACTION_TYPES::INPUT_MAX);
+
+    // Iterate over the set of pointer actions added for this frame.
+    for (unsigned int slot = 0; slot < m_pTouchActions->GetSlotCount(); slot++)
+    {
+        if (!m_pTouchActions->IsSlotUsed(slot))
+        {
+            continue;
+        }
+
+        // Enable the player ID for the default pointer player assignment.
+        m_activePlayers |= (1 << DEFAULT_POINTER_PLAYER_ID);
+
+        unsigned int pointerId = m_pTouchActions->GetSlotId(slot);
+        PointerControllerAction pointerAction = m_pTouchActions->GetSlotValue(slot);
+
+        int id = IsTouchdownInRegion(XMFLOAT2(pointerAction.CurrentX, pointerAction.CurrentY));
+
+        // Touching the screen provides data for player 1.
+        PlayerInputData playerInput;
+        playerInput.ID = DEFAULT_POINTER_PLAYER_ID;
+        playerInput.IsTouchAction = true;
+        playerInput.Timestamp = pointerAction.Timestamp;
+
+        if (id == INVALID_TOUCH_REGION_ID)
+        {
+            // Any touch input at all has to be recognized. This enables the 
+            // virtual controller to display itself when the player touches 
+            // the display.
+
+            // Construct dummy event
+            playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_NONE;
+
+            // Process and add the player action to the player gameplay action vector.
+            AddPlayerActionToMap(&playerInput);
+
+            continue;
+        }
+
+        // The region's own action, unless bindings.txt rebinds it.
+        PLAYER_ACTION_TYPES regionAction = static_cast<PLAYER_ACTION_TYPES>(
+            m_bindings->GetTouchAction(id, m_touchControlRegions[id].DefinedAction)
+            );
+
+        // Check for analog stick regions.
+        if (m_touchControlRegions[id].RegionType == TOUCH_CONTROL_REGION_ANALOG_STICK)
+        {
+            // Check for thumbstick input already received for this region.
+            // This prevents random touch points from interfering with the thumbstick.
+            if (virtualStickProcessedThisFrame[regionAction])
+            {
+                continue;
+            }
+            else
+            {
+                virtualStickProcessedThisFrame[regionAction] = true;
+            }
+
+            float centerX, centerY;
+
+            // Touchdown point for this pointer. If the table was full when the
+            // pointer went down, treat the current position as the touchdown point.
+            XMFLOAT2* pointerTD = m_touchDownPoints.Find(pointerId);
+            if (pointerTD == nullptr)
+            {
+                m_touchDownPoints.Emplace(pointerId, XMFLOAT2(pointerAction.CurrentX, pointerAction.CurrentY));
+                pointerTD = m_touchDownPoints.Find(pointerId);
+            }
+
+            // Check to see whether we are already watching this pointer.
+            PointerControllerAction* val = m_pTouchActionsLastFrame->Find(pointerId);
+            if (val == nullptr)
+            {
+                // We are not watching this touch point, so we need to store the initial touch coordinates.
+                // Store the center position for the virtual analog stick display.
+                centerX = pointerAction.CurrentX;
+                centerY = pointerAction.CurrentY;
+            }
+            else
+            {
+                // We are currently watching this touch point. Update state based on event type.
+                if (!pointerAction.IsLeftButtonPressed)
+                {
+                    // Pointer is up, so remove it from the processing state.
+                    m_pTouchActions->EraseSlot(slot);
+                    m_pTouchActionsLastFrame->Erase(pointerId);
+                    continue;
+                }
+                else
+                {
+                    // Pointer has moved.
+
+                    // Get back the initial touch coordinates.
+                    centerX = (pointerTD != nullptr) ? pointerTD->x : pointerAction.CurrentX;
+                    centerY = (pointerTD != nullptr) ? pointerTD->y : pointerAction.CurrentY;
+
+                    // Already processed.
+                    m_pTouchActionsLastFrame->Erase(pointerId);
+                }
+            }
+
+            // Calculate the delta between this action and the pointer touch down action recorded
+            // previously for this pointer ID. Assume it is a touch controller or drag operation.
+            float xDelta = pointerAction.CurrentX - centerX;
+            float yDelta = pointerAction.CurrentY - centerY;
+
+            // Enforce a circular limit for the controller stick.
+            float magnitude = sqrtf(xDelta*xDelta + yDelta*yDelta);
+
+            // Move the thumbstick with the user's thumb.
+            if (magnitude > POINTER_VIRTUAL_STICK_THROW_MAX)
+            {
+                // Compute how far out the user dragged the joystick.
+                float magnitudeFactor = POINTER_VIRTUAL_STICK_THROW_MAX / magnitude;
+                float temp1 = xDelta * magnitudeFactor;
+                float temp2 = yDelta * magnitudeFactor;
+
+                // Move the center by the same amount.
+                centerX += xDelta - temp1;
+                centerY += yDelta - temp2;
+
+                if (pointerTD != nullptr)
+                {
+                    pointerTD->x = centerX;
+                    pointerTD->y = centerY;
+                }
+
+                // Reduce the "thrown" values to their max size.
+                xDelta = temp1;
+                yDelta = temp2;
+            }
+
+            // Compute the value we need to normalize the x/y values to a total distance of 1.0f.
+            float normalizedMagnitude = ComputeThumbstickMagnitudeFactor(
+                xDelta,
+                yDelta,
+                (int) POINTER_VIRTUAL_STICK_DEADZONE,
+                POINTER_VIRTUAL_STICK_THROW_MAX
+                );
+
+            // Updated the coordinate data.
+
+            // Store the stick's center position for virtual controller rendering.
+            playerInput.PointerRawX = centerX;
+            playerInput.PointerRawY = centerY;
+
+            // Store the stick's current "thrown" position for virtual controller rendering.
+            playerInput.PointerThrowX = centerX + xDelta;
+            playerInput.PointerThrowY = centerY + yDelta;
+
+            // Normalized input data. This corresponds to the normalized axis values you'd 
+            // get from a physical joystick.
+            playerInput.X = normalizedMagnitude * xDelta / POINTER_VIRTUAL_STICK_THROW_MAX;
+            // Y-value must be reversed to map pixel coordinate system to Xbox controller behaviors
+            playerInput.Y = -(normalizedMagnitude * yDelta / POINTER_VIRTUAL_STICK_THROW_MAX); 
+
+            // Move actions store the normalized axis values in X and Y, so the 
+            // NormalizedInputValue field is unused.
+            // You can use this for any additional calibration or smoothing data, like an
+            // interpolation modifier.
+            playerInput.NormalizedInputValue = 1.f;
+
+            // Store the action type for this touch region.
+            switch (regionAction)
+            {
+            default:
+            case PLAYER_ACTION_TYPES::INPUT_MOVE:
+                playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_MOVE;
+                break;
+
+            case PLAYER_ACTION_TYPES::INPUT_AIM:
+                playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_AIM;
+                break;
+            }
+
+            // Process the X and Y data and use it to update the player gameplay action vector.
+            AddPlayerActionToMap(&playerInput);
+        }
+        else if (m_touchControlRegions[id].RegionType == TOUCH_CONTROL_REGION_BUTTON)
+        {
+            // Virtual button was pressed.
+
+            // Include updated coordinates.
+            playerInput.PointerRawX = playerInput.X = pointerAction.CurrentX;
+            playerInput.PointerRawY = playerInput.Y = pointerAction.CurrentY;
+
+            // The action type is defined with the touch region.
+            playerInput.PlayerAction = regionAction;
+            playerInput.NormalizedInputValue = 1.f;
+
+            // Process and add the player action to the player gameplay action vector.
+            AddPlayerActionToMap(&playerInput);
+        }
+
+        // NOTE TO DEVELOPERS: Add your own code for handling slide controls, etc. by adding more cases here.
+    }
+}
+
+
+// Converts raw pointer input received from mouse events into 
+// specific player gameplay input actions.
+void InputTranslator::TranslateMousePointerActionsToPlayerActionsMap()
+{
+    // Iterate over the set of pointer actions added for this frame.
+    for (unsigned int slot = 0; slot < m_pMouseActions->GetSlotCount(); slot++)
+    {
+        if (!m_pMouseActions->IsSlotUsed(slot))
+        {
+            continue;
+        }
+
+        // Enable the player ID for the default keyboard player assignment.
+        m_activePlayers |= (1 << DEFAULT_POINTER_PLAYER_ID);
+
+        unsigned int pointerId = m_pMouseActions->GetSlotId(slot);
+        PointerControllerAction pointerAction = m_pMouseActions->GetSlotValue(slot);
+
+        PlayerInputData playerInput;
+        playerInput.ID = DEFAULT_POINTER_PLAYER_ID;
+        playerInput.Timestamp = pointerAction.Timestamp;
+
+        // Include updated coordinates.
+        // For mouse updates, the raw input coords and the returned x and y values are the same.
+        //  This is different for "virtual" controls like the touch analog stick.
+        playerInput.PointerRawX = playerInput.X = pointerAction.CurrentX;
+        playerInput.PointerRawY = pointerAction.CurrentY = pointerAction.CurrentY;
+            
+        // Check to see whether we are already watching this pointer.
+        PointerControllerAction* pointerLastFrame = m_pMouseActionsLastFrame->Find(pointerId);
+        if (pointerLastFrame != nullptr)
+        {
+            playerInput.PlayerAction = (pointerAction.IsLeftButtonPressed) ? PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN : PLAYER_ACTION_TYPES::INPUT_FIRE_UP;
+            playerInput.NormalizedInputValue = 1.0f;
+                
+            // if the pointer isn't providing any state, discard it
+            if (!(pointerAction.IsLeftButtonPressed || pointerAction.IsMiddleButtonPressed || pointerAction.IsRightButtonPressed))
+            {
+                if ((pointerAction.CurrentX == pointerLastFrame->CurrentX) && (pointerAction.CurrentY == pointerLastFrame->CurrentY))
+                {
+                    // Erase it: we already processed it, this pointer is done for now.
+                    m_pMouseActions->EraseSlot(slot);
+                    m_pMouseActionsLastFrame->Erase(pointerId);
+
+                    continue;
+                }
+                else
+                {
+                    // Return 0.f as the normalized pointerLastFrameue. The coordinate data is what 
+                    // the game will be processing in this case.
+                    playerInput.NormalizedInputValue = 0.f;
+                    playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_COORDINATES_ONLY;
+                }
+            }
+
+            // Process and add the player action to the player gameplay action vector.
+            AddPlayerActionToMap(&playerInput);
+
+            // Already processed
+            m_pMouseActionsLastFrame->Erase(pointerId);
+        }
+        else
+        {
+            // This must be a pointer we're not currently tracking.
+
+            if (pointerAction.IsLeftButtonPressed)
+            {
+                // New action detected with left-click.
+                playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN;
+                playerInput.NormalizedInputValue = 1.f;
+            }
+            else
+            {
+                // Return 0.f as the normalized value. The coordinate data is what 
+                // the game will be processing in this case.
+                playerInput.NormalizedInputValue = 0.f;
+                playerInput.PlayerAction = PLAYER_ACTION_TYPES::INPUT_COORDINATES_ONLY;
+            }
+
+            // Process and add the X and Y data to the player gameplay action vector.
+            AddPlayerActionToMap(&playerInput);
+        }
+    }
+
+    // Look for leftover pointer actions. This indicates a mouse button is still down, but the mouse has not moved.
+    for (unsigned int slot = 0; slot < m_pMouseActionsLastFrame->GetSlotCount(); slot++)
+    {
+        if (!m_pMouseActionsLastFrame->IsSlotUsed(slot))
+        {
+            continue;
+        }
+
+        PointerControllerAction pointerAction = m_pMouseActionsLastFrame->GetSlotValue(slot);
+
+        if (pointerAction.IsMouseEvent)
+        {
+            PlayerInputData playerInput;
+            playerInput.ID = DEFAULT_POINTER_PLAYER_ID;
+
+            // Include updated coordinates.
+            playerInput.PointerRawX = playerInput.X = pointerAction.CurrentX;
+            playerInput.PointerRawY = pointerAction.CurrentY = pointerAction.CurrentY;
+
+            playerInput.PlayerAction = (pointerAction.IsLeftButtonPressed) ? PLAYER_ACTION_TYPES::INPUT_FIRE_DOWN : PLAYER_ACTION_TYPES::INPUT_FIRE_UP;
+            playerInput.NormalizedInputValue = 1.0f;
+
+            // Process and add the player action to the player gameplay action vector.
+            AddPlayerActionToMap(&playerInput);
+        }
+    }
+}
+
+// Convert keyboard keypresses and releases into player gameplay actions.
+void InputTranslator::TranslateKeyboardToPlayerActionsMap()
+{
+    if (m_keyboardState.GetCount() > 0)
+    {
+        // Enable the player ID for the default keyboard player assignment.
+        m_activePlayers |= (1 << DEFAULT_KEYBOARD_PLAYER_ID);
+
+        //
+        // NOTE TO DEVELOPERS: Keys are mapped to player gameplay actions by
+        // the keyboard section of Assets\bindings.txt. Add or change lines
+        // there to support the gameplay actions you define for your game;
+        // chords like "key Control+1" handle modifiers and diagonals.
+        //
+        BoundAction boundActions[PLAYER_ACTION_TYPES::INPUT_MAX];
+        unsigned int boundActionCount = m_bindings->TranslateKeyboard(m_keyboardState, boundActions, PLAYER_ACTION_TYPES::INPUT_MAX);
+
+        for (unsigned int i = 0; i < boundActionCount; i++)
+        {
+            AddBoundActionToMap(DEFAULT_KEYBOARD_PLAYER_ID, boundActions[i]);
+        }
+    }
+}
@@ -0,0 +1,167 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include "InputTypes.h"
+#include "TouchRegionGrid.h"
+#include "ActionBindings.h"
+
+namespace DirectXGame2
+{
+    //
+    // The InputTranslator class turns raw keyboard, pointer and controller
+    // input into player actions.
+    //
+    // It doesn't read any device itself: the InputManager feeds it the events
+    // queued from the CoreWindow and the controller state collected by the
+    // gamepad poller, and a test or benchmark can feed it the same data
+    // directly. Everything lives in fixed-size tables, so a frame's
+    // translation doesn't allocate; only SetDefinedTouchRegion does.
+    //
+    // Usage, on one thread:
+    // 1. translator.SetBindings(&bindings);
+    // 2. Per frame: ApplyRawInputEvent() for each keyboard and pointer event,
+    //    and AddGamepadState() for each connected controller.
+    // 3. count = translator.Translate(playerActions, INPUT_MAX_PLAYER_ACTIONS);
+    //
+    class InputTranslator
+    {
+    public:
+        InputTranslator();
+
+        // Key, button and touch region bindings. Not owned; they must stay
+        // alive until they are replaced. nullptr leaves everything unbound.
+        void SetBindings(
+            _In_opt_ const ActionBindings* bindings
+            );
+
+        // Input devices whose input is translated. Default is INPUT_DEVICE_ALL.
+        void SetFilter(INPUT_DEVICE_TYPES mask)             { m_inputTypeFilterMask = mask; }
+        INPUT_DEVICE_TYPES GetFilter() const                { return m_inputTypeFilterMask; }
+
+        // Raw input for the next Translate call.
+        void ApplyRawInputEvent(
+            _In_ const RawInputEvent& rawEvent
+            );
+        void AddGamepadState(
+            _In_ unsigned int controllerId,
+            _In_ const GamepadSample& state,
+            _In_ long long timestamp
+            );
+
+        // Writes at most capacity actions to playerActions and returns how
+        // many were written; a buffer of INPUT_MAX_PLAYER_ACTIONS always has
+        // room for all of them.
+        unsigned int Translate(
+            _Out_writes_to_(capacity, return) PlayerInputData* playerActions,
+            _In_ unsigned int capacity
+            );
+
+        // Bit per player that keyboard or pointer input was translated for by
+        // the last Translate call.
+        unsigned int GetActivePlayers() const               { return m_activePlayers; }
+
+        //
+        // Touch regions. Regions may only overlap if their priorities differ.
+        // SetDefinedTouchRegion returns 0, or one of the INVALID_TOUCH_REGION_*
+        // errors.
+        //
+        int SetDefinedTouchRegion(
+            _In_ const TouchControlRegion * newRegion,
+            _Out_ unsigned int& regionId
+            );
+        void ClearTouchRegions(void);
+        void EnableTouchRegion(
+            _In_ unsigned int regionId
+            );
+        void DisableTouchRegion(
+            _In_ unsigned int regionId
+            );
+
+        // Normalized magnitude for an analog stick, XInput or virtual.
+        static float ComputeThumbstickMagnitudeFactor(
+            _In_ float const stickX,
+            _In_ float const stickY,
+            _In_ int   const deadZone,
+            _In_ float const maxThrow
+            );
+
+    private:
+        InputTranslator(const InputTranslator&);
+        InputTranslator& operator=(const InputTranslator&);
+
+        void ClearInputActions(void);
+        void AddPlayerActionToMap(
+            _In_ PlayerInputData * const playerInput
+            );
+        void UpdateLastFrameActionMap(void);
+        void AddTransitoryStatesToEventMap(void);
+        unsigned int ProcessStatesToPlayerActions(
+            _Out_writes_to_(capacity, return) PlayerInputData* playerActions,
+            _In_ unsigned int capacity
+            );
+        void AddBoundActionToMap(
+            _In_ unsigned int playerId,
+            _In_ const BoundAction& boundAction
+            );
+        void TranslateXInputToPlayerActionMap(void);
+        void TranslateKeyboardToPlayerActionsMap(void);
+        void TranslateTouchPointerActionsToPlayerActionsMap(void);
+        void TranslateMousePointerActionsToPlayerActionsMap(void);
+        int IsTouchdownInRegion(
+            _In_ DirectX::XMFLOAT2 touchDownPoint
+            );
+
+        INPUT_DEVICE_TYPES      m_inputTypeFilterMask;
+        ActionBindings          m_noBindings;
+        const ActionBindings*   m_bindings;
+        unsigned int            m_activePlayers;
+
+        // Storage for the two action maps below. They swap between frames.
+        bool    m_actionMaps[2][XINPUT_MAX_CONTROLLERS][PLAYER_ACTION_TYPES::INPUT_MAX];
+
+        // 2D array used for processing the final set of player actions. This
+        // is used to resolve player action data from all input sources. Input
+        // actions are differentiated between multiple players.
+        bool    (*m_actionsThisFrame)[PLAYER_ACTION_TYPES::INPUT_MAX];
+
+        // 2D array used to determine if a specific action for a specific
+        // player was returned to the game in the last update. This is for
+        // action state management.
+        bool    (*m_actionsLastFrame)[PLAYER_ACTION_TYPES::INPUT_MAX];
+
+        // 2D array used to map into player actions. Stores the data as it is
+        // processed, then copied to the caller's buffer.
+        PlayerInputData m_resolvedActionsThisFrame[XINPUT_MAX_CONTROLLERS][PLAYER_ACTION_TYPES::INPUT_MAX];
+
+        //
+        // Per-frame input source data
+        //
+        // These fixed-size tables track and manage the input from the three
+        // major input sources : XInput(controller), pointer(mouse and touch),
+        // and keyboard. The this-frame and last-frame pointer tables swap
+        // between frames rather than being copied.
+        XInputControllerAction  m_xinputActions[XINPUT_MAX_CONTROLLERS];   // stores XInput actions for one input frame
+        unsigned int            m_xinputActionCount;
+        KeyStateTable           m_keyboardState;             // keys held, for the default keyboard player
+        TouchDownTable          m_touchDownPoints;           // touchdown coordinates for each pointer
+        PointerReleaseTable     m_releasedPointers;          // pointers whose touchdown point is dropped at end of frame
+        PointerActionTable      m_mouseActionTables[2];      // Storage for the mouse action tables below.
+        PointerActionTable      m_touchActionTables[2];      // Storage for the touch action tables below.
+        PointerActionTable*     m_pMouseActionsLastFrame;    // Used to track mouse pointers across frames.
+        PointerActionTable*     m_pMouseActions;             // pointer id, last recorded action.
+        PointerActionTable*     m_pTouchActionsLastFrame;    // Used to track touch pointers across frames.
+        PointerActionTable*     m_pTouchActions;             // pointer id, last recorded action.
+
+        //
+        // Touch virtual control input region definition and management
+        //
+        TouchControlRegionList  m_touchControlRegions;
+        TouchRegionGrid         m_touchRegionGrid;      // Hit-test index over the same regions, with the same ids.
+    };
+}
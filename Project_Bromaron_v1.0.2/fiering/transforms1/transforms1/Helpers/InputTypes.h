@@ -0,0 +1,354 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+#include "AllocationTracker.h"
+#include "InputStateTables.h"
+#include "GamepadPoller.h"
+
+// Types shared by the input manager, the input translator and anything that
+// consumes player actions.
+
+namespace DirectXGame2
+{
+    //
+    // ** Begin enumerations **
+    //
+
+#pragma region InputManagerEnums
+
+    // Bit values of all the actions a player can
+    // initiate, and which can be returned by the
+    // input manager after processing.
+    // NOTE TO DEVELOPERS: When you change this list, please
+    // increment or decrement DEFAULT_MAX_PLAYER_ACTION_TYPES  accordingly!
+    enum PLAYER_ACTION_TYPES
+    {
+        // These are examples of input events a game might have:
+        INPUT_NONE = 0,
+        INPUT_COORDINATES_ONLY = 1, // raw coord data
+        INPUT_MOVE,
+        INPUT_AIM,
+        INPUT_FIRE,
+        INPUT_FIRE_UP,
+        INPUT_FIRE_DOWN,
+        INPUT_FIRE_PRESSED,
+        INPUT_FIRE_RELEASED,
+        INPUT_JUMP,
+        INPUT_JUMP_UP,
+        INPUT_JUMP_DOWN,
+        INPUT_JUMP_PRESSED,
+        INPUT_JUMP_RELEASED,
+        INPUT_ACCEL,
+        INPUT_BRAKE,
+        INPUT_SELECT,
+        INPUT_START,
+        INPUT_CANCEL,
+        INPUT_EXIT,
+        INPUT_DIRECTIONAL,
+		INPUT_WEAPON_ONE,
+		INPUT_WEAPON_TWO,
+		INPUT_WEAPON_THREE,
+        // ...
+        // Note to developer: Add the input events your game demands!
+        // ...
+
+        INPUT_MAX
+    };
+
+
+    // Types of Windows input events. Used internally for handling passed-through input events.
+    enum INPUT_EVENT_TYPE
+    {
+        INPUT_EVENT_TYPE_DOWN,
+        INPUT_EVENT_TYPE_UP,
+        INPUT_EVENT_TYPE_MOVED,
+        INPUT_EVENT_TYPE_EXITED,
+
+        INPUT_EVENT_TYPE_NUM
+    };
+
+
+    // Bit values of all the input devices supported by the input manager.
+    enum INPUT_DEVICE_TYPES
+    {
+        INPUT_DEVICE_NONE     = 0x00,
+        INPUT_DEVICE_MOUSE    = 0x01,
+        INPUT_DEVICE_KEYBOARD = 0x02,
+        INPUT_DEVICE_TOUCH    = 0x04,
+        INPUT_DEVICE_XINPUT   = 0x08,
+        INPUT_DEVICE_ALL = 
+           (INPUT_DEVICE_MOUSE    |
+            INPUT_DEVICE_KEYBOARD |
+            INPUT_DEVICE_TOUCH    |
+            INPUT_DEVICE_XINPUT)
+    };
+
+
+    // Bit values for all the players supported by the input manager.
+    // NOTE TO DEVELOPERS: When you change this list, please
+    // increment or decrement XINPUT_MAX_CONTROLLERS accordingly!
+    enum PLAYER_ID
+    {
+        PLAYER_ID_ONE   = 0x01,
+        PLAYER_ID_TWO   = 0x02,
+        PLAYER_ID_THREE = 0x04,
+        PLAYER_ID_FOUR  = 0x08,
+        // ...
+        // Note to developer: Add more players as your game demands, and as practically 
+        // supported by the hardware.
+        // ...
+        PLAYER_ID_MAX
+    };
+
+    // Types of touch screen virtual controls. 
+    // NOTE TO DEVELOPERS: You can add to, or update, these touch-screen
+    // control types.
+    enum TOUCH_CONTROL_REGION_TYPES
+    {
+        TOUCH_CONTROL_REGION_REPORT_COORDS_ONLY = 0,
+        TOUCH_CONTROL_REGION_ANALOG_STICK = 1,
+        TOUCH_CONTROL_REGION_BUTTON = 2,
+        TOUCH_CONTROL_REGION_ANALOG_SLIDER = 3,
+
+        TOUCH_CONTROL_REGION_MAX
+    };
+
+    //
+    // ** End InputManager enums **
+    //
+#pragma endregion
+
+    // Keyboard/touch/mouse default to player 1 (index 0).
+#define DEFAULT_KEYBOARD_PLAYER_ID               0
+#define DEFAULT_POINTER_PLAYER_ID                0
+
+
+    // Touch region definition errors
+#define INVALID_TOUCH_REGION_ID                 -1
+#define INVALID_TOUCH_REGION_OVERLAPS           -2
+#define INVALID_TOUCH_REGION_INVERTED           -3
+#define INVALID_TOUCH_REGION_OFFSCREEN          -4
+#define INVALID_TOUCH_REGION_LIMIT              -5
+
+
+#pragma region InputManagerConsts
+
+    //
+    // Constants for handling XInput
+    //
+    // Defines the maximum numbers of Xinput controllers to process. XInput
+    // supports a maximum of 4 controllers.
+#define XINPUT_MAX_CONTROLLERS          4
+
+
+    // The maximum XInput analog throw value. Full range is
+    // -32768 to 32767.
+#define XINPUT_ANALOG_STICK_THROW_MAX   32767.0f
+
+
+    // Stick dead zones, the same as XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE and
+    // XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE.
+#define GAMEPAD_LEFT_THUMB_DEADZONE     7849
+#define GAMEPAD_RIGHT_THUMB_DEADZONE    8689
+
+
+    //
+    // Constants for handling pointer devices (mouse/touch)
+    //
+    // Pixel move radius from touchdown for virtual stick deadzone.
+#define POINTER_VIRTUAL_STICK_DEADZONE  10.0f
+#define POINTER_VIRTUAL_STICK_THROW_MAX 45.0f
+
+
+#pragma endregion
+
+#pragma region InputManagerStructs
+
+    // Contains the state of an XInput controller. This state may be examined 
+    // to see what controller actions were taken.
+    struct XInputControllerAction
+    {
+        unsigned int    ControllerId;
+        GamepadSample   State;
+        long long       Timestamp;      // When the state was polled; 0 if it hasn't changed since the last poll.
+    };
+
+
+    // Contains the state of an individual pointer action. Note that a 
+    // PointerId is NOT the same as a player or controller ID, as it is used 
+    // to track a a press or move event from start to completion.
+    // -- CHANGE LEFT/RIGHT/MIDDLE to IsTouchPressed;
+    struct PointerControllerAction
+    {
+        long long       Timestamp;      // QueryPerformanceCounter value when the event arrived.
+        unsigned int    PointerId;
+        float           CurrentX;
+        float           CurrentY;
+        bool            IsTouchEvent;
+        bool            IsMouseEvent;
+        bool            IsLeftButtonPressed;
+        bool            IsRightButtonPressed;
+        bool            IsMiddleButtonPressed;
+    };
+
+    // A raw CoreWindow keyboard or pointer event. These are queued on the
+    // CoreWindow thread and applied to the input maps on the game thread.
+    struct RawInputEvent
+    {
+        long long                   Timestamp;      // QueryPerformanceCounter value when the event arrived.
+        INPUT_DEVICE_TYPES          Device;         // INPUT_DEVICE_KEYBOARD, INPUT_DEVICE_MOUSE or INPUT_DEVICE_TOUCH.
+        INPUT_EVENT_TYPE            Type;
+        unsigned int                VirtualKey;     // Keyboard events only.
+        PointerControllerAction     Pointer;        // Pointer events only.
+    };
+
+    // Defines a final player input action state returned to the game. 
+    struct PlayerInputData
+    {
+    public:
+        // The zero-based player ID value for the player that initiated the action.
+        unsigned int ID;
+
+        // The PLAYER_ACTION_TYPES value for the initiated action.
+        PLAYER_ACTION_TYPES PlayerAction;
+
+        // The normalized value (i.e. between 0.f and 1.f) returned from the 
+        // input device. For digital inputs, either a value of 0.f or 1.0f is 
+        // returned, depending on the action. 
+        float NormalizedInputValue;
+
+        // Indicates whether this possible input state is different from last frame.
+
+        // The raw screen coordinate data (x, y) for pointer events. For non-pointer events, 
+        // such as virtual key presses or XInput analog stick and digital pad actions, both
+        // of these values are used to indicate the direction of the action, where 1.0 could
+        // indicate up/forward, and -1.0 could indicate down/back. It is up to your game to
+        // interpret the meaning.
+        float X;
+        float Y;
+
+		// roll, pitch, yaw from keypresses.
+		float Roll;
+		float Pitch;
+		float Yaw;
+
+		float laserPitch = 0.0f;
+		float laserYaw = 0.0f;;
+        // Raw coordinate position for touch/mouse input. For non-pointer events, these values
+        // are set to 0.f.
+        float PointerRawX;
+        float PointerRawY;
+
+        // Value used to determine if the acion originated from a touch event.
+        bool IsTouchAction;
+
+        // Virtual throw for touch stick input. For non-touch actions, these values are set to
+        // 0.f by default. You can use them for additional calibration or smoothing information
+        // for custom controls.
+        float PointerThrowX;
+        float PointerThrowY;
+		bool isFiring;
+		int firetype;
+
+        // QueryPerformanceCounter value when the newest input event behind this
+        // action arrived, or 0 if nothing new arrived. Used to measure input latency.
+        long long Timestamp;
+
+        // ctor
+		PlayerInputData() :
+			ID(0),
+			PlayerAction(INPUT_NONE),
+			NormalizedInputValue(0.f),
+			X(0.f),
+			Y(0.f),
+			Roll(0.f),
+			Pitch(0.f),
+
+			Yaw(0.f),
+			PointerRawX(0.f),
+			PointerRawY(0.f),
+			IsTouchAction(false),
+			PointerThrowX(-1.f), // -1 means this is not a relative touch input event.
+			PointerThrowY(-1.f),
+			Timestamp(0)
+        {
+        }
+    };
+
+    // Defines a touch control region rectangle.
+    struct TouchControlRegion
+    {
+    public:
+        const DirectX::XMFLOAT2             UpperLeftCoords;
+        const DirectX::XMFLOAT2             LowerRightCoords;
+        const TOUCH_CONTROL_REGION_TYPES    RegionType;
+        const PLAYER_ACTION_TYPES           DefinedAction;
+        bool                                IsEnabled;
+        bool                                ProcessedThisFrame;
+        PLAYER_ID                           PlayerID;
+
+        // Where regions overlap, touches go to the one with the highest priority.
+        int                                 Priority;
+
+        // ctor
+        TouchControlRegion(
+            DirectX::XMFLOAT2 const& upperLeft,
+            DirectX::XMFLOAT2 const& lowerRight,
+            TOUCH_CONTROL_REGION_TYPES const& regionType,
+            PLAYER_ACTION_TYPES const& definedAction,
+            PLAYER_ID const& playerId,
+            int priority = 0
+            ) :
+            UpperLeftCoords(upperLeft),
+            LowerRightCoords(lowerRight),
+            RegionType(regionType),
+            DefinedAction(definedAction),
+            IsEnabled(true),
+            ProcessedThisFrame(false),
+            PlayerID(playerId),
+            Priority(priority)
+        {
+        };
+
+        TouchControlRegion(
+            ) :
+            UpperLeftCoords(DirectX::XMFLOAT2(0,0)),
+            LowerRightCoords(DirectX::XMFLOAT2(0, 0)),
+            RegionType(TOUCH_CONTROL_REGION_REPORT_COORDS_ONLY),
+            DefinedAction(PLAYER_ACTION_TYPES::INPUT_COORDINATES_ONLY),
+            IsEnabled(false),
+            ProcessedThisFrame(false),
+            PlayerID(PLAYER_ID::PLAYER_ID_ONE),
+            Priority(0)
+        {
+        };
+
+    };
+
+
+    //
+    // Touch region definitions. Their memory is charged to MEMORY_TAG_INPUT.
+    //
+    typedef std::vector<TouchControlRegion, TrackingAllocator<TouchControlRegion, MEMORY_TAG_INPUT>>          TouchControlRegionList;
+
+    //
+    // Fixed-size tables for per-frame input source data.
+    //
+    typedef PointerSlotTable<DirectX::XMFLOAT2>         TouchDownTable;         // pointer id -> touchdown coordinates
+    typedef PointerSlotTable<PointerControllerAction>   PointerActionTable;     // pointer id -> last recorded action
+    typedef PointerSlotTable<bool>                      PointerReleaseTable;    // pointer ids released this frame
+
+    // The most player actions GetPlayersActions can return in one frame.
+#define INPUT_MAX_PLAYER_ACTIONS        (XINPUT_MAX_CONTROLLERS * PLAYER_ACTION_TYPES::INPUT_MAX)
+
+
+#pragma endregion
+}
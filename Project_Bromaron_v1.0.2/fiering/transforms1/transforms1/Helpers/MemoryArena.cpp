@@ -0,0 +1,131 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "MemoryArena.h"
+#include <malloc.h>
+
+using namespace DirectXGame2;
+
+namespace
+{
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+//
+// ** LinearArena **
+//
+
+LinearArena::LinearArena(size_t capacity) :
+    m_capacity(AlignUp(capacity, ARENA_MIN_ALIGNMENT)),
+    m_offset(0),
+    m_peak(0)
+{
+    m_base = static_cast<unsigned char*>(_aligned_malloc(m_capacity, ARENA_MIN_ALIGNMENT));
+    if (m_base == nullptr)
+    {
+        throw ref new Platform::OutOfMemoryException();
+    }
+}
+
+LinearArena::~LinearArena()
+{
+    _aligned_free(m_base);
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+    if (alignment < ARENA_MIN_ALIGNMENT) alignment = ARENA_MIN_ALIGNMENT;
+
+    // The base is aligned to ARENA_MIN_ALIGNMENT, so larger alignments are
+    // handled by padding the offset from the real address.
+    size_t address = reinterpret_cast<size_t>(m_base) + m_offset;
+    size_t start = AlignUp(address, alignment) - reinterpret_cast<size_t>(m_base);
+
+    if ((start > m_capacity) || (size > m_capacity - start))
+    {
+        throw ref new Platform::OutOfMemoryException(L"LinearArena capacity exceeded.");
+    }
+
+    m_offset = start + size;
+    if (m_offset > m_peak) m_peak = m_offset;
+
+    return m_base + start;
+}
+
+//
+// ** BlockPool **
+//
+
+BlockPool::BlockPool(size_t blockSize, unsigned int blocksPerPage, MEMORY_TAG tag) :
+    m_freeList(nullptr),
+    m_blockSize(AlignUp((blockSize < sizeof(FreeBlock)) ? sizeof(FreeBlock) : blockSize, ARENA_MIN_ALIGNMENT)),
+    m_blocksPerPage(blocksPerPage),
+    m_blocksInUse(0),
+    m_tag(tag)
+{
+}
+
+BlockPool::~BlockPool()
+{
+    for (unsigned int i = 0; i < m_pages.size(); i++)
+    {
+        _aligned_free(m_pages[i]);
+#if ALLOCATION_TRACKING
+        AllocationTracker::RecordFree(m_tag, m_blockSize * m_blocksPerPage);
+#endif
+    }
+}
+
+void BlockPool::AddPage()
+{
+    unsigned char* page = static_cast<unsigned char*>(_aligned_malloc(m_blockSize * m_blocksPerPage, ARENA_MIN_ALIGNMENT));
+    if (page == nullptr)
+    {
+        throw ref new Platform::OutOfMemoryException();
+    }
+
+    m_pages.push_back(page);
+#if ALLOCATION_TRACKING
+    AllocationTracker::RecordAllocation(m_tag, m_blockSize * m_blocksPerPage);
+#endif
+
+    // Thread the new blocks onto the free list in address order.
+    for (unsigned int i = m_blocksPerPage; i > 0; i--)
+    {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(page + (i - 1) * m_blockSize);
+        block->Next = m_freeList;
+        m_freeList = block;
+    }
+}
+
+void* BlockPool::Allocate()
+{
+    if (m_freeList == nullptr)
+    {
+        AddPage();
+    }
+
+    FreeBlock* block = m_freeList;
+    m_freeList = block->Next;
+    m_blocksInUse++;
+
+    return block;
+}
+
+void BlockPool::Free(void* block)
+{
+    if (block == nullptr) return;
+
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->Next = m_freeList;
+    m_freeList = freed;
+    m_blocksInUse--;
+}
@@ -0,0 +1,129 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+#include "AllocationTracker.h"
+
+namespace DirectXGame2
+{
+    // Default capacities.
+#define FRAME_ARENA_BYTES               (256 * 1024)    // Per-frame temporaries.
+#define LOAD_ARENA_BYTES                (1024 * 1024)   // Procedural mesh generation.
+
+    // Every arena allocation is aligned to at least this (SSE loads).
+#define ARENA_MIN_ALIGNMENT             16
+
+    //
+    // The LinearArena class is a bump allocator over one fixed block.
+    //
+    // Allocations are never freed individually; Reset() releases everything
+    // at once, and ResetToMarker() releases everything allocated after a
+    // marker returned by GetMarker(). Running out of space throws rather than
+    // falling back to the heap, so an undersized arena shows up immediately.
+    //
+    // Not thread safe: each arena must be used from one thread at a time.
+    //
+    class LinearArena
+    {
+    public:
+        LinearArena(size_t capacity);
+        ~LinearArena();
+
+        void* Allocate(size_t size, size_t alignment = ARENA_MIN_ALIGNMENT);
+
+        // Uninitialized storage for count objects. Only use for plain data;
+        // nothing allocated from an arena has its destructor run.
+        template<typename T>
+        T* AllocateArray(size_t count)
+        {
+            return static_cast<T*>(Allocate(sizeof(T) * count, __alignof(T)));
+        }
+
+        void Reset()                                { m_offset = 0; }
+        size_t GetMarker() const                    { return m_offset; }
+        void ResetToMarker(size_t marker)           { m_offset = marker; }
+
+        size_t GetUsed() const                      { return m_offset; }
+        size_t GetCapacity() const                  { return m_capacity; }
+        size_t GetPeak() const                      { return m_peak; }
+
+    private:
+        unsigned char*  m_base;
+        size_t          m_capacity;
+        size_t          m_offset;
+        size_t          m_peak;
+
+        LinearArena(const LinearArena&);
+        LinearArena& operator=(const LinearArena&);
+    };
+
+    //
+    // The ScopedArena class hands out memory from a LinearArena and gives it
+    // all back when it goes out of scope. Used for load-time work such as
+    // building meshes, where the data only has to live until it is uploaded.
+    //
+    class ScopedArena
+    {
+    public:
+        ScopedArena(LinearArena& arena) : m_arena(arena), m_marker(arena.GetMarker()) {}
+        ~ScopedArena()                              { m_arena.ResetToMarker(m_marker); }
+
+        void* Allocate(size_t size, size_t alignment = ARENA_MIN_ALIGNMENT)    { return m_arena.Allocate(size, alignment); }
+
+        template<typename T>
+        T* AllocateArray(size_t count)              { return m_arena.AllocateArray<T>(count); }
+
+    private:
+        LinearArena&    m_arena;
+        size_t          m_marker;
+
+        ScopedArena(const ScopedArena&);
+        ScopedArena& operator=(const ScopedArena&);
+    };
+
+    //
+    // The BlockPool class hands out fixed-size blocks.
+    //
+    // Blocks are carved from pages of blocksPerPage blocks; freed blocks go on
+    // an intrusive free list and are reused before a new page is allocated.
+    // Pages are only released when the pool is destroyed, and are charged to
+    // tag while they are held.
+    //
+    class BlockPool
+    {
+    public:
+        BlockPool(size_t blockSize, unsigned int blocksPerPage, MEMORY_TAG tag = MEMORY_TAG_GENERAL);
+        ~BlockPool();
+
+        void* Allocate();
+        void Free(void* block);
+
+        size_t GetBlockSize() const                 { return m_blockSize; }
+        unsigned int GetBlocksInUse() const         { return m_blocksInUse; }
+        unsigned int GetBlockCount() const          { return static_cast<unsigned int>(m_pages.size()) * m_blocksPerPage; }
+
+    private:
+        struct FreeBlock
+        {
+            FreeBlock* Next;
+        };
+
+        void AddPage();
+
+        std::vector<unsigned char*> m_pages;
+        FreeBlock*                  m_freeList;
+        size_t                      m_blockSize;
+        unsigned int                m_blocksPerPage;
+        unsigned int                m_blocksInUse;
+        MEMORY_TAG                  m_tag;
+
+        BlockPool(const BlockPool&);
+        BlockPool& operator=(const BlockPool&);
+    };
+}
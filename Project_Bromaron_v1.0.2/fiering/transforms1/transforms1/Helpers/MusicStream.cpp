@@ -0,0 +1,224 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "MusicStream.h"
+
+#include <string.h>
+
+using namespace DirectXGame2;
+
+MusicStream::MusicStream(std::unique_ptr<MusicDecoder> decoder, Clock clock, long long ticksPerSecond) :
+    m_decoder(std::move(decoder)),
+    m_clock(clock),
+    m_ticksPerSecond(ticksPerSecond),
+    m_bufferBytes(MUSIC_STREAM_BUFFER_BYTES),
+    m_readAheadBytes(0),
+    m_loop(false),
+    m_sink(nullptr),
+    m_queued(0),
+    m_stop(false),
+    m_endOfStream(false),
+    m_startTime(0)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+MusicStream::~MusicStream()
+{
+    Stop();
+}
+
+bool MusicStream::Open(const std::wstring& name, bool loop)
+{
+    m_startTime = m_clock();
+    if (m_thread.joinable() || !m_decoder->Open(name, &m_format))
+    {
+        return false;
+    }
+
+    // Buffers hold whole blocks; nBlockAlign is at byte 12 of the WAVEFORMATEX.
+    unsigned int blockAlign = (m_format.size() >= 14) ? (m_format[12] | (m_format[13] << 8)) : 1;
+    if (blockAlign == 0 || blockAlign > MUSIC_STREAM_BUFFER_BYTES)
+    {
+        return false;
+    }
+
+    m_bufferBytes = MUSIC_STREAM_BUFFER_BYTES - (MUSIC_STREAM_BUFFER_BYTES % blockAlign);
+    m_loop = loop;
+    m_readAhead.resize(blockAlign);
+    m_readAheadBytes = 0;
+
+    // Allocated once here, so playback itself doesn't allocate.
+    for (unsigned int i = 0; i < MUSIC_STREAM_BUFFER_COUNT; i++)
+    {
+        m_buffers[i].resize(m_bufferBytes);
+    }
+    m_stats.BufferBytes = m_bufferBytes * MUSIC_STREAM_BUFFER_COUNT;
+
+    return true;
+}
+
+void MusicStream::Start(MusicSink* sink)
+{
+    if (m_thread.joinable() || (sink == nullptr) || m_format.empty())
+    {
+        return;
+    }
+
+    m_sink = sink;
+    m_thread = std::thread(&MusicStream::Run, this);
+}
+
+void MusicStream::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_bufferFree.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void MusicStream::OnBufferEnd()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_queued == 0)
+        {
+            return;
+        }
+        m_queued--;
+
+        // The sink has nothing left to play and the next buffer isn't ready.
+        if ((m_queued == 0) && !m_endOfStream && !m_stop)
+        {
+            m_stats.Underruns++;
+        }
+    }
+    m_bufferFree.notify_one();
+}
+
+bool MusicStream::IsFinished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_endOfStream && (m_queued == 0);
+}
+
+void MusicStream::GetStats(MusicStreamStats* stats) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    *stats = m_stats;
+}
+
+// Decodes into a buffer until it is full or the track ends, rewinding at
+// the end of a looping track. Returns the bytes written.
+unsigned int MusicStream::Fill(Buffer& buffer, bool* endOfStream, unsigned int* loops)
+{
+    unsigned int filled = m_readAheadBytes;
+    bool justRewound = false;
+
+    if (filled > 0)
+    {
+        memcpy(&buffer[0], &m_readAhead[0], filled);
+        m_readAheadBytes = 0;
+    }
+
+    *endOfStream = false;
+    while (filled < m_bufferBytes)
+    {
+        unsigned int read = m_decoder->Read(&buffer[filled], m_bufferBytes - filled);
+        if (read > 0)
+        {
+            filled += read;
+            justRewound = false;
+            continue;
+        }
+
+        // Rewinding into nothing would spin forever on an empty track.
+        if (m_loop && !justRewound && m_decoder->Rewind())
+        {
+            justRewound = true;
+            (*loops)++;
+            continue;
+        }
+
+        *endOfStream = true;
+        break;
+    }
+
+    // A track that ends exactly on a buffer boundary would otherwise only be
+    // found to have ended on the next fill, with nothing left to carry the
+    // flag. Read a block past a full buffer so the end goes on this one.
+    if (!*endOfStream && !m_loop)
+    {
+        m_readAheadBytes = m_decoder->Read(&m_readAhead[0], static_cast<unsigned int>(m_readAhead.size()));
+        *endOfStream = (m_readAheadBytes == 0);
+    }
+
+    return filled;
+}
+
+void MusicStream::Run()
+{
+    m_decoder->BeginDecodeThread();
+
+    unsigned int next = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop && !m_endOfStream)
+    {
+        while (!m_stop && (m_queued == MUSIC_STREAM_BUFFER_COUNT))
+        {
+            m_bufferFree.wait(lock);
+        }
+
+        if (m_stop)
+        {
+            break;
+        }
+
+        // The slot after the last one submitted is the oldest, and has played.
+        Buffer& buffer = m_buffers[next];
+        next = (next + 1) % MUSIC_STREAM_BUFFER_COUNT;
+        lock.unlock();
+
+        bool endOfStream;
+        unsigned int loops = 0;
+        unsigned int bytes = Fill(buffer, &endOfStream, &loops);
+
+        lock.lock();
+        m_stats.BytesDecoded += bytes;
+        m_stats.Loops += loops;
+        m_endOfStream = endOfStream;
+
+        if (bytes == 0)
+        {
+            // An empty track; there is nothing to play.
+            break;
+        }
+
+        m_queued++;
+        m_stats.BuffersSubmitted++;
+        if (m_stats.BuffersSubmitted == 1)
+        {
+            m_stats.FirstAudioMilliseconds = (m_clock() - m_startTime) * 1000.0 / m_ticksPerSecond;
+        }
+
+        // The sink may call OnBufferEnd from inside Submit.
+        lock.unlock();
+        m_sink->Submit(&buffer[0], bytes, endOfStream);
+        lock.lock();
+    }
+    lock.unlock();
+
+    m_decoder->EndDecodeThread();
+}
@@ -0,0 +1,152 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AllocationTracker.h"
+
+namespace DirectXGame2
+{
+    // Buffers in the ring, and the size of each. At 44.1 kHz 16-bit stereo
+    // a buffer holds about 370 ms, so the ring decodes about a second ahead.
+#define MUSIC_STREAM_BUFFER_COUNT       3
+#define MUSIC_STREAM_BUFFER_BYTES       (64 * 1024)
+
+    //
+    // The MusicDecoder class produces PCM a piece at a time for a
+    // MusicStream. Open is called on the caller's thread; Read and Rewind
+    // only on the stream's decode thread.
+    //
+    class MusicDecoder
+    {
+    public:
+        virtual ~MusicDecoder() {}
+
+        // Opens the named file. On success, format holds the WAVEFORMATEX
+        // (with any extra bytes) of the PCM that Read returns.
+        virtual bool Open(const std::wstring& name, std::vector<unsigned char>* format) = 0;
+
+        // Decodes up to capacity bytes, a whole number of blocks. Returns the
+        // number written, or 0 at the end of the stream or on an error.
+        virtual unsigned int Read(unsigned char* buffer, unsigned int capacity) = 0;
+
+        // Goes back to the start of the stream, for looping.
+        virtual bool Rewind() = 0;
+
+        // Called on the decode thread before its first and after its last Read.
+        virtual void BeginDecodeThread() {}
+        virtual void EndDecodeThread() {}
+    };
+
+    //
+    // The MusicSink class plays the buffers a MusicStream decodes, typically
+    // by queueing them on a voice. Submit is called from the decode thread.
+    // The sink calls MusicStream::OnBufferEnd once each buffer has played,
+    // in the order they were submitted.
+    //
+    class MusicSink
+    {
+    public:
+        virtual ~MusicSink() {}
+
+        // data stays valid until the matching OnBufferEnd. endOfStream is set
+        // on the last buffer of a track that doesn't loop; bytes is never 0.
+        virtual void Submit(const unsigned char* data, unsigned int bytes, bool endOfStream) = 0;
+    };
+
+    struct MusicStreamStats
+    {
+        double              FirstAudioMilliseconds;     // From Open to the first buffer submitted; 0 until then.
+        unsigned long long  BytesDecoded;
+        unsigned int        BuffersSubmitted;
+        unsigned int        Underruns;                  // Times the sink played everything it had before the next buffer was ready.
+        unsigned int        Loops;
+        size_t              BufferBytes;                // Memory held by the ring.
+    };
+
+    //
+    // The MusicStream class plays a long track without decoding all of it
+    // first.
+    //
+    // A decode thread fills a small ring of buffers ahead of playback and
+    // hands each to the sink as soon as it is full. When the sink reports a
+    // buffer played, its slot is refilled. A looping track rewinds the
+    // decoder in the middle of filling a buffer, so the end of the track and
+    // the start of the next pass share a buffer and there is no gap.
+    //
+    // Usage:
+    // 1. stream.Open(filename, loop); then create a voice for stream.GetFormat().
+    // 2. stream.Start(&sink);
+    // 3. From the voice's buffer-end callback: stream.OnBufferEnd();
+    // 4. To stop: stop the voice, then stream.Stop(), then destroy the voice.
+    //
+    class MusicStream
+    {
+    public:
+        typedef std::function<long long()> Clock;
+
+        MusicStream(std::unique_ptr<MusicDecoder> decoder, Clock clock, long long ticksPerSecond);
+        ~MusicStream();
+
+        // Opens the track. Returns false if the decoder can't.
+        bool Open(const std::wstring& name, bool loop);
+        const std::vector<unsigned char>& GetFormat() const     { return m_format; }
+
+        // Starts decoding into the sink.
+        void Start(MusicSink* sink);
+
+        // Stops decoding and waits for the decode thread. Buffers already
+        // submitted stay valid until the stream is destroyed.
+        void Stop();
+
+        // A submitted buffer has finished playing. Any thread.
+        void OnBufferEnd();
+
+        // Whether a track that doesn't loop has played to the end.
+        bool IsFinished() const;
+
+        void GetStats(MusicStreamStats* stats) const;
+
+    private:
+        typedef std::vector<unsigned char, TrackingAllocator<unsigned char, MEMORY_TAG_AUDIO>> Buffer;
+
+        MusicStream(const MusicStream&);
+        MusicStream& operator=(const MusicStream&);
+
+        unsigned int Fill(Buffer& buffer, bool* endOfStream, unsigned int* loops);
+        void Run();
+
+        std::unique_ptr<MusicDecoder>   m_decoder;
+        Clock                           m_clock;
+        long long                       m_ticksPerSecond;
+
+        std::vector<unsigned char>      m_format;
+        unsigned int                    m_bufferBytes;      // MUSIC_STREAM_BUFFER_BYTES rounded down to whole blocks.
+        Buffer                          m_readAhead;        // One block, read past a full buffer to see whether the track ends there.
+        unsigned int                    m_readAheadBytes;
+        bool                            m_loop;
+        Buffer                          m_buffers[MUSIC_STREAM_BUFFER_COUNT];
+        MusicSink*                      m_sink;
+        std::thread                     m_thread;
+
+        mutable std::mutex              m_mutex;
+        std::condition_variable         m_bufferFree;       // Signalled when a buffer plays, or on Stop.
+        unsigned int                    m_queued;           // Buffers submitted and not yet played.
+        bool                            m_stop;
+        bool                            m_endOfStream;      // The last buffer has been submitted.
+
+        long long                       m_startTime;
+        MusicStreamStats                m_stats;
+    };
+}
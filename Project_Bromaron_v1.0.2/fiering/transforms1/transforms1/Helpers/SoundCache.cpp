@@ -0,0 +1,326 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "SoundCache.h"
+
+using namespace DirectXGame2;
+
+SoundCache::SoundCache(std::unique_ptr<SoundDecoder> decoder, size_t budget) :
+    m_decoder(std::move(decoder)),
+    m_newest(INVALID_SOUND_ASSET_ID),
+    m_oldest(INVALID_SOUND_ASSET_ID),
+    m_bytesResident(0),
+    m_budget(budget),
+    m_stopLoader(false),
+    m_hits(0),
+    m_misses(0),
+    m_evictions(0)
+{
+}
+
+SoundCache::~SoundCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopLoader = true;
+    }
+    m_queued.notify_all();
+
+    if (m_loader.joinable())
+    {
+        m_loader.join();
+    }
+}
+
+SoundAssetId SoundCache::Intern(const std::wstring& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::unordered_map<std::wstring, SoundAssetId>::const_iterator found = m_ids.find(name);
+    if (found != m_ids.end())
+    {
+        return found->second;
+    }
+
+    SoundAssetId id = static_cast<SoundAssetId>(m_entries.size());
+
+    Entry entry;
+    entry.Name = name;
+    entry.Bytes = 0;
+    entry.State = ENTRY_STATE_EMPTY;
+    entry.Newer = INVALID_SOUND_ASSET_ID;
+    entry.Older = INVALID_SOUND_ASSET_ID;
+    m_entries.push_back(entry);
+    m_ids[name] = id;
+
+    return id;
+}
+
+std::wstring SoundCache::GetName(SoundAssetId id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (id < m_entries.size()) ? m_entries[id].Name : std::wstring();
+}
+
+std::shared_ptr<const SoundAsset> SoundCache::Get(SoundAssetId id)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (id >= m_entries.size())
+    {
+        return nullptr;
+    }
+
+    // Hits are counted before waiting, so a sound that was preloaded in time
+    // and one that is still on its way both count as hits.
+    if (m_entries[id].State == ENTRY_STATE_RESIDENT || m_entries[id].State == ENTRY_STATE_LOADING)
+    {
+        m_hits++;
+    }
+    else
+    {
+        m_misses++;
+    }
+
+    while (m_entries[id].State == ENTRY_STATE_LOADING)
+    {
+        m_loaded.wait(lock);
+    }
+
+    Entry& entry = m_entries[id];
+    switch (entry.State)
+    {
+    case ENTRY_STATE_RESIDENT:
+        Unlink(id);
+        LinkNewest(id);
+        return entry.Asset;
+
+    case ENTRY_STATE_FAILED:
+        return nullptr;
+
+    default:
+        break;
+    }
+
+    // Decode without holding the lock, so other sounds can still be played.
+    entry.State = ENTRY_STATE_LOADING;
+    std::wstring name = entry.Name;
+    lock.unlock();
+
+    std::shared_ptr<const SoundAsset> asset = Decode(name);
+
+    lock.lock();
+    Finish(id, asset);
+    lock.unlock();
+    m_loaded.notify_all();
+
+    return asset;
+}
+
+void SoundCache::Preload(SoundAssetId id)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if ((id >= m_entries.size()) || (m_entries[id].State != ENTRY_STATE_EMPTY))
+        {
+            return;
+        }
+
+        m_entries[id].State = ENTRY_STATE_LOADING;
+        m_preloadQueue.push_back(id);
+
+        if (!m_loader.joinable())
+        {
+            m_loader = std::thread(&SoundCache::RunLoader, this);
+        }
+    }
+    m_queued.notify_one();
+}
+
+void SoundCache::SetBudget(size_t budget)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = budget;
+    EvictToBudget();
+}
+
+void SoundCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    while (m_oldest != INVALID_SOUND_ASSET_ID)
+    {
+        Evict(m_oldest);
+    }
+
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        if (m_entries[i].State == ENTRY_STATE_FAILED)
+        {
+            m_entries[i].State = ENTRY_STATE_EMPTY;
+        }
+    }
+}
+
+void SoundCache::GetStats(SoundCacheStats* stats) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    stats->Hits = m_hits;
+    stats->Misses = m_misses;
+    stats->Evictions = m_evictions;
+    stats->HitRate = ((m_hits + m_misses) > 0) ? static_cast<float>(static_cast<double>(m_hits) / (m_hits + m_misses)) : 0.f;
+    stats->BytesResident = m_bytesResident;
+    stats->Budget = m_budget;
+
+    stats->AssetsResident = 0;
+    for (SoundAssetId id = m_newest; id != INVALID_SOUND_ASSET_ID; id = m_entries[id].Older)
+    {
+        stats->AssetsResident++;
+    }
+}
+
+std::shared_ptr<const SoundAsset> SoundCache::Decode(const std::wstring& name)
+{
+    std::shared_ptr<SoundAsset> asset = std::make_shared<SoundAsset>();
+    if (!m_decoder->Decode(name, asset.get()))
+    {
+        return nullptr;
+    }
+
+    return asset;
+}
+
+// Records the result of a decode. Called with the lock held.
+void SoundCache::Finish(SoundAssetId id, const std::shared_ptr<const SoundAsset>& asset)
+{
+    Entry& entry = m_entries[id];
+
+    if (asset == nullptr)
+    {
+        entry.State = ENTRY_STATE_FAILED;
+        return;
+    }
+
+    entry.Asset = asset;
+    entry.Bytes = asset->Format.size() + asset->Data.size();
+    entry.State = ENTRY_STATE_RESIDENT;
+    m_bytesResident += entry.Bytes;
+    LinkNewest(id);
+
+    // A sound bigger than the whole budget is evicted straight away, but the
+    // caller still gets it.
+    EvictToBudget();
+}
+
+void SoundCache::LinkNewest(SoundAssetId id)
+{
+    Entry& entry = m_entries[id];
+    entry.Newer = INVALID_SOUND_ASSET_ID;
+    entry.Older = m_newest;
+
+    if (m_newest != INVALID_SOUND_ASSET_ID)
+    {
+        m_entries[m_newest].Newer = id;
+    }
+    else
+    {
+        m_oldest = id;
+    }
+    m_newest = id;
+}
+
+void SoundCache::Unlink(SoundAssetId id)
+{
+    Entry& entry = m_entries[id];
+
+    if (entry.Newer != INVALID_SOUND_ASSET_ID)
+    {
+        m_entries[entry.Newer].Older = entry.Older;
+    }
+    else
+    {
+        m_newest = entry.Older;
+    }
+
+    if (entry.Older != INVALID_SOUND_ASSET_ID)
+    {
+        m_entries[entry.Older].Newer = entry.Newer;
+    }
+    else
+    {
+        m_oldest = entry.Newer;
+    }
+
+    entry.Newer = INVALID_SOUND_ASSET_ID;
+    entry.Older = INVALID_SOUND_ASSET_ID;
+}
+
+// Drops the cache's reference to a resident sound. Voices still playing it
+// keep it alive.
+void SoundCache::Evict(SoundAssetId id)
+{
+    Entry& entry = m_entries[id];
+
+    Unlink(id);
+    m_bytesResident -= entry.Bytes;
+    entry.Asset.reset();
+    entry.Bytes = 0;
+    entry.State = ENTRY_STATE_EMPTY;
+    m_evictions++;
+}
+
+void SoundCache::EvictToBudget()
+{
+    while ((m_bytesResident > m_budget) && (m_oldest != INVALID_SOUND_ASSET_ID))
+    {
+        Evict(m_oldest);
+    }
+}
+
+void SoundCache::RunLoader()
+{
+    m_decoder->BeginLoaderThread();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        while (!m_stopLoader && m_preloadQueue.empty())
+        {
+            m_queued.wait(lock);
+        }
+
+        if (m_stopLoader)
+        {
+            break;
+        }
+
+        SoundAssetId id = m_preloadQueue.front();
+        m_preloadQueue.pop_front();
+        std::wstring name = m_entries[id].Name;
+        lock.unlock();
+
+        std::shared_ptr<const SoundAsset> asset = Decode(name);
+
+        lock.lock();
+        Finish(id, asset);
+        m_loaded.notify_all();
+    }
+
+    // Anything still queued goes back to unloaded, so Get decodes it itself.
+    while (!m_preloadQueue.empty())
+    {
+        m_entries[m_preloadQueue.front()].State = ENTRY_STATE_EMPTY;
+        m_preloadQueue.pop_front();
+    }
+    lock.unlock();
+    m_loaded.notify_all();
+
+    m_decoder->EndLoaderThread();
+}
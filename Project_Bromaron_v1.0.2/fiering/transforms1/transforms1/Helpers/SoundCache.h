@@ -0,0 +1,165 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "AllocationTracker.h"
+
+namespace DirectXGame2
+{
+    // Decoded PCM data for a voice. Charged to MEMORY_TAG_AUDIO.
+    typedef std::vector<unsigned char, TrackingAllocator<unsigned char, MEMORY_TAG_AUDIO>> SoundDataBuffer;
+
+    // Bytes of decoded audio a cache keeps by default.
+#define SOUND_CACHE_DEFAULT_BUDGET      (16 * 1024 * 1024)
+
+    // Identifies an asset name interned by a SoundCache.
+    typedef unsigned int SoundAssetId;
+#define INVALID_SOUND_ASSET_ID          0xFFFFFFFF
+
+    // A decoded sound, ready to submit to a voice.
+    struct SoundAsset
+    {
+        std::vector<unsigned char>  Format;     // The WAVEFORMATEX, including any extra bytes.
+        SoundDataBuffer             Data;
+    };
+
+    //
+    // The SoundDecoder class turns an asset name into PCM for a SoundCache.
+    // Decode may be called from the game thread and the loader thread at the
+    // same time.
+    //
+    class SoundDecoder
+    {
+    public:
+        virtual ~SoundDecoder() {}
+
+        // Fills asset from the named file. Returns false if it can't be decoded.
+        virtual bool Decode(const std::wstring& name, SoundAsset* asset) = 0;
+
+        // Called on the loader thread before its first and after its last Decode.
+        virtual void BeginLoaderThread() {}
+        virtual void EndLoaderThread() {}
+    };
+
+    struct SoundCacheStats
+    {
+        unsigned long long  Hits;
+        unsigned long long  Misses;
+        unsigned long long  Evictions;
+        float               HitRate;            // Hits / (Hits + Misses), or 0 before the first lookup.
+        size_t              BytesResident;
+        size_t              Budget;
+        unsigned int        AssetsResident;
+    };
+
+    //
+    // The SoundCache class keeps decoded sounds in memory so that playing one
+    // again doesn't decode the file again.
+    //
+    // Names are interned into small integer ids once, and lookups by id are
+    // an array index. Decoded sounds are handed out as shared pointers, so any
+    // number of voices can play one while the cache is free to evict it; the
+    // memory goes away when the last voice lets go. When the resident sounds
+    // exceed the budget, the least recently used are evicted first.
+    //
+    // Preload decodes on a loader thread. Get on a sound that is still being
+    // preloaded waits for it instead of decoding it a second time.
+    //
+    // All methods may be called from any thread.
+    //
+    // Usage:
+    // 1. SoundAssetId id = cache.Intern(L"assets/chord.wav");
+    // 2. Optionally, when a level loads: cache.Preload(id);
+    // 3. To play: std::shared_ptr<const SoundAsset> sound = cache.Get(id);
+    //
+    class SoundCache
+    {
+    public:
+        SoundCache(std::unique_ptr<SoundDecoder> decoder, size_t budget);
+        ~SoundCache();
+
+        // Returns the id for a name, assigning one the first time it is seen.
+        SoundAssetId Intern(const std::wstring& name);
+        std::wstring GetName(SoundAssetId id) const;
+
+        // Returns the decoded sound, decoding it first on a miss. Returns
+        // nullptr if the id is unknown or the file couldn't be decoded.
+        std::shared_ptr<const SoundAsset> Get(SoundAssetId id);
+
+        // Queues the sound for decoding on the loader thread, unless it is
+        // already resident or on its way.
+        void Preload(SoundAssetId id);
+
+        // Evicts down to a new budget, if needed.
+        void SetBudget(size_t budget);
+
+        // Evicts everything and forgets failed decodes, so they are retried.
+        void Clear();
+
+        void GetStats(SoundCacheStats* stats) const;
+
+    private:
+        enum ENTRY_STATE
+        {
+            ENTRY_STATE_EMPTY,
+            ENTRY_STATE_LOADING,
+            ENTRY_STATE_RESIDENT,
+            ENTRY_STATE_FAILED
+        };
+
+        struct Entry
+        {
+            std::wstring                        Name;
+            std::shared_ptr<const SoundAsset>   Asset;
+            size_t                              Bytes;
+            ENTRY_STATE                         State;
+            SoundAssetId                        Newer;      // Neighbours in the LRU list,
+            SoundAssetId                        Older;      // while resident.
+        };
+
+        SoundCache(const SoundCache&);
+        SoundCache& operator=(const SoundCache&);
+
+        std::shared_ptr<const SoundAsset> Decode(const std::wstring& name);
+        void Finish(SoundAssetId id, const std::shared_ptr<const SoundAsset>& asset);
+        void LinkNewest(SoundAssetId id);
+        void Unlink(SoundAssetId id);
+        void Evict(SoundAssetId id);
+        void EvictToBudget();
+        void RunLoader();
+
+        std::unique_ptr<SoundDecoder>                   m_decoder;
+
+        mutable std::mutex                              m_mutex;
+        std::condition_variable                         m_loaded;       // Signalled whenever a load finishes.
+        std::condition_variable                         m_queued;       // Wakes the loader thread.
+
+        std::vector<Entry>                              m_entries;      // Indexed by SoundAssetId.
+        std::unordered_map<std::wstring, SoundAssetId>  m_ids;
+        SoundAssetId                                    m_newest;
+        SoundAssetId                                    m_oldest;
+        size_t                                          m_bytesResident;
+        size_t                                          m_budget;
+
+        std::deque<SoundAssetId>                        m_preloadQueue;
+        std::thread                                     m_loader;       // Started by the first Preload.
+        bool                                            m_stopLoader;
+
+        unsigned long long                              m_hits;
+        unsigned long long                              m_misses;
+        unsigned long long                              m_evictions;
+    };
+}
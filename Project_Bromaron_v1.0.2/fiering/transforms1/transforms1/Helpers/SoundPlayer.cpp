@@ -8,6 +8,7 @@
 #include "pch.h"
 #include "SoundPlayer.h"
 #include "DirectXHelper.h"
+#include "FrameProfiler.h"
 
 using namespace Windows::Foundation;
 using namespace DirectXGame2;
@@ -17,18 +18,271 @@ using namespace DirectXGame2;
 // performance considerations.
 #define SOUND_PLAYER_SAMPLE_RATE 44100
 
+// Distance at which effects start to get quieter, in world units.
+#define SOUND_PLAYER_EFFECT_REFERENCE_DISTANCE 1.0f
+
+namespace
+{
+    long long ReadPerformanceCounter()
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    long long ReadPerformanceFrequency()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        return frequency.QuadPart;
+    }
+
+    // Opens a source reader on the file that decodes to PCM, and returns the
+    // complete WAVEFORMATEX of what it will produce.
+    HRESULT CreatePcmReader(
+        _In_ const std::wstring& name,
+        _Out_ Microsoft::WRL::ComPtr<IMFSourceReader>* reader,
+        _Out_ std::vector<unsigned char>* format
+        )
+    {
+        // Create the source reader on the url (file).
+        // If the file does not exist, this will fail with HRESULT 0x80070002: File not found.
+        HRESULT hr = MFCreateSourceReaderFromURL(name.c_str(), nullptr, reader->ReleaseAndGetAddressOf());
+
+        // Set the decoded output format as PCM
+        // XAudio2 on Windows can process PCM and ADPCM-encoded buffers.
+        // When using MF, this sample always decodes into PCM.
+        // NOTE: The inbox ADPCM decoder supports sample rates only up to 44.1KHz. 
+        Microsoft::WRL::ComPtr<IMFMediaType> mediaType;
+        if (SUCCEEDED(hr))
+        {
+            hr = MFCreateMediaType(&mediaType);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = mediaType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = mediaType->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_PCM);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = (*reader)->SetCurrentMediaType(MF_SOURCE_READER_FIRST_AUDIO_STREAM, 0, mediaType.Get());
+        }
+
+        // Get the complete WAVEFORMAT from the Media Type
+        Microsoft::WRL::ComPtr<IMFMediaType> outputMediaType;
+        if (SUCCEEDED(hr))
+        {
+            hr = (*reader)->GetCurrentMediaType(MF_SOURCE_READER_FIRST_AUDIO_STREAM, outputMediaType.GetAddressOf());
+        }
+
+        uint32 formatByteCount = 0;
+        WAVEFORMATEX* waveFormat = nullptr;
+        if (SUCCEEDED(hr))
+        {
+            hr = MFCreateWaveFormatExFromMFMediaType(outputMediaType.Get(), &waveFormat, &formatByteCount);
+        }
+        if (SUCCEEDED(hr))
+        {
+            const BYTE* formatBytes = reinterpret_cast<const BYTE*>(waveFormat);
+            format->assign(formatBytes, formatBytes + formatByteCount);
+            CoTaskMemFree(waveFormat);
+        }
+
+        return hr;
+    }
+
+    // Reads the next decoded sample and appends its bytes to data. Returns
+    // S_FALSE at the end of the stream.
+    template <class Buffer>
+    HRESULT ReadPcmSample(_In_ IMFSourceReader* reader, _Inout_ Buffer* data)
+    {
+        HRESULT hr = S_OK;
+
+        // Stream ticks come without a sample, so keep reading until one does.
+        Microsoft::WRL::ComPtr<IMFSample> sample;
+        while (SUCCEEDED(hr) && (sample == nullptr))
+        {
+            DWORD flags = 0;
+            hr = reader->ReadSample(
+                MF_SOURCE_READER_FIRST_AUDIO_STREAM,
+                0,
+                nullptr,
+                &flags,
+                nullptr,
+                &sample
+                );
+
+            // End of stream
+            if (SUCCEEDED(hr) && (flags & MF_SOURCE_READERF_ENDOFSTREAM))
+            {
+                return S_FALSE;
+            }
+        }
+
+        Microsoft::WRL::ComPtr<IMFMediaBuffer> mediaBuffer;
+        if (SUCCEEDED(hr))
+        {
+            hr = sample->ConvertToContiguousBuffer(&mediaBuffer);
+        }
+
+        // Serialize access to the buffer by calling the IMFMediaBuffer::Lock method.
+        uint8* audioData = nullptr;
+        DWORD sampleBufferLength = 0;
+        if (SUCCEEDED(hr))
+        {
+            hr = mediaBuffer->Lock(&audioData, nullptr, &sampleBufferLength);
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            // Append the new buffer to the running total.
+            data->insert(data->end(), audioData, audioData + sampleBufferLength);
+
+            // Release the lock on the buffer.
+            hr = mediaBuffer->Unlock();
+        }
+
+        return hr;
+    }
+
+    // Decodes any audio file Media Foundation can read into PCM.
+    class MediaFoundationDecoder : public SoundDecoder
+    {
+    public:
+        virtual bool Decode(const std::wstring& name, SoundAsset* asset)
+        {
+            PROFILE_SCOPE("SoundPlayer.Decode");
+
+            // The whole file is loaded into memory, so the low latency
+            // attribute is not required here.
+            Microsoft::WRL::ComPtr<IMFSourceReader> reader;
+            HRESULT hr = CreatePcmReader(name, &reader, &asset->Format);
+
+            // Buffer the sound data in-memory.
+            while (hr == S_OK)
+            {
+                hr = ReadPcmSample(reader.Get(), &asset->Data);
+            }
+
+            return SUCCEEDED(hr);
+        }
+
+        // Media Foundation needs the Windows Runtime initialized on the cache's loader thread.
+        virtual void BeginLoaderThread()
+        {
+            RoInitialize(RO_INIT_MULTITHREADED);
+        }
+
+        virtual void EndLoaderThread()
+        {
+            RoUninitialize();
+        }
+    };
+
+    // Decodes a music file with Media Foundation a piece at a time.
+    class MediaFoundationMusicDecoder : public MusicDecoder
+    {
+    public:
+        MediaFoundationMusicDecoder() :
+            m_pendingOffset(0)
+        {
+        }
+
+        virtual bool Open(const std::wstring& name, std::vector<unsigned char>* format)
+        {
+            return SUCCEEDED(CreatePcmReader(name, &m_reader, format));
+        }
+
+        virtual unsigned int Read(unsigned char* buffer, unsigned int capacity)
+        {
+            PROFILE_SCOPE("SoundPlayer.DecodeMusic");
+
+            // Samples don't line up with the stream's buffers, so whatever
+            // doesn't fit is kept for the next Read.
+            unsigned int written = 0;
+            while (written < capacity)
+            {
+                if (m_pendingOffset == m_pending.size())
+                {
+                    m_pending.clear();
+                    m_pendingOffset = 0;
+                    if (ReadPcmSample(m_reader.Get(), &m_pending) != S_OK)
+                    {
+                        break;
+                    }
+                    continue;
+                }
+
+                size_t count = m_pending.size() - m_pendingOffset;
+                if (count > capacity - written)
+                {
+                    count = capacity - written;
+                }
+                memcpy(buffer + written, &m_pending[m_pendingOffset], count);
+                m_pendingOffset += count;
+                written += static_cast<unsigned int>(count);
+            }
+
+            return written;
+        }
+
+        virtual bool Rewind()
+        {
+            m_pending.clear();
+            m_pendingOffset = 0;
+
+            PROPVARIANT position;
+            PropVariantInit(&position);
+            position.vt = VT_I8;
+            position.hVal.QuadPart = 0;
+            HRESULT hr = m_reader->SetCurrentPosition(GUID_NULL, position);
+            PropVariantClear(&position);
+
+            return SUCCEEDED(hr);
+        }
+
+        // Media Foundation needs the Windows Runtime initialized on the stream's decode thread.
+        virtual void BeginDecodeThread()
+        {
+            RoInitialize(RO_INIT_MULTITHREADED);
+        }
+
+        virtual void EndDecodeThread()
+        {
+            RoUninitialize();
+        }
+
+    private:
+        Microsoft::WRL::ComPtr<IMFSourceReader> m_reader;
+        std::vector<unsigned char>              m_pending;
+        size_t                                  m_pendingOffset;
+    };
+}
+
 // SoundPlayer ctor.
 SoundPlayer::SoundPlayer() :
+    m_soundCache(std::unique_ptr<SoundDecoder>(new MediaFoundationDecoder()), SOUND_CACHE_DEFAULT_BUDGET),
+    m_effectVoices(SOUND_PLAYER_EFFECT_VOICES, SOUND_PLAYER_EFFECT_REFERENCE_DISTANCE),
     m_musicMasteringVoice(nullptr),
     m_effectMasteringVoice(nullptr),
     m_effectAudioEngine(nullptr),
-    m_musicAudioEngine(nullptr),
-    m_effectBusy(false),
-    m_musicBusy(false)
+    m_musicAudioEngine(nullptr)
 {
     HRESULT hr = S_OK;
     UINT32 flags = 0;
 
+    for (unsigned int i = 0; i < SOUND_PLAYER_EFFECT_VOICES; i++)
+    {
+        m_effectSourceVoices[i] = nullptr;
+    }
+
+    DX::ThrowIfFailed(
+        MFStartup(MF_VERSION)
+        );
+
     DX::ThrowIfFailed(
         XAudio2Create(&m_effectAudioEngine, flags)
         );
@@ -88,16 +342,20 @@ SoundPlayer::SoundPlayer() :
 SoundPlayer::~SoundPlayer()
 {
     // Destroy sound effect engine.
-    if (m_effectSourceVoice)
+    for (unsigned int i = 0; i < SOUND_PLAYER_EFFECT_VOICES; i++)
     {
-        // All source voices must be stoped before you can stop the mastering voice.
-        m_effectSourceVoice->Stop();
-        m_effectSourceVoice = nullptr;
+        if (m_effectSourceVoices[i])
+        {
+            // All source voices must be stoped before you can stop the mastering voice.
+            m_effectSourceVoices[i]->Stop();
+            m_effectSourceVoices[i]->DestroyVoice();
+            m_effectSourceVoices[i] = nullptr;
+        }
     }
     if (m_effectMasteringVoice)
     {
-        m_musicMasteringVoice->DestroyVoice();
-        m_musicMasteringVoice = nullptr;
+        m_effectMasteringVoice->DestroyVoice();
+        m_effectMasteringVoice = nullptr;
     }
     if (m_effectAudioEngine)
     {
@@ -106,12 +364,8 @@ SoundPlayer::~SoundPlayer()
     }
 
     // Destroy music engine.
-    if (m_musicSourceVoice)
-    {
-        // All source voices must be stoped before you can stop the mastering voice.
-        m_musicSourceVoice->Stop();
-        m_musicSourceVoice = nullptr;
-    }
+    // All source voices must be stoped before you can stop the mastering voice.
+    m_music.reset();
     if (m_musicMasteringVoice)
     {
         m_musicMasteringVoice->DestroyVoice();
@@ -124,220 +378,232 @@ SoundPlayer::~SoundPlayer()
     }
 }
 
-// Loads and plays a sound once. If a sound is already playing,
-// it will be stopped and the specified file will be played.
-HRESULT SoundPlayer::PlaySound(_In_ const std::wstring& file)
+// Plays a sound once, alongside any effects already playing. When every
+// effect voice is busy, the sound takes over the least important one, or
+// isn't played if they all matter more. Returns S_FALSE if the sound wasn't
+// played because it was too quiet or too unimportant. The file is only
+// decoded the first time, or again after the cache has evicted it.
+HRESULT SoundPlayer::PlaySound(
+    _In_ const std::wstring& file,
+    _In_ EFFECT_PRIORITY priority,
+    _In_ float volume,
+    _In_ float distance
+    )
+{
+    // Validate parameters.
+    if ((file.size() < 1))
+    {
+        return E_INVALIDARG;
+    }
+
+    return PlaySound(m_soundCache.Intern(file), priority, volume, distance);
+}
+
+// As above, for a sound already resolved with InternSound.
+HRESULT SoundPlayer::PlaySound(
+    _In_ SoundAssetId id,
+    _In_ EFFECT_PRIORITY priority,
+    _In_ float volume,
+    _In_ float distance
+    )
 {
     HRESULT hr = S_OK;
 
-    std::lock_guard<std::mutex> lock(m_criticalSection);
+    if (id == INVALID_SOUND_ASSET_ID)
+    {
+        return E_INVALIDARG;
+    }
 
-    // Validate parameters.
-    if ((file.size() < 1))
+    std::shared_ptr<const SoundAsset> sound = m_soundCache.Get(id);
+    if (sound == nullptr)
     {
-        hr = E_INVALIDARG;
+        return E_FAIL;
     }
 
-    if (m_effectBusy == true)
+    if ((sound->Format.size() < sizeof(WAVEFORMATEX)) || sound->Data.empty() || (sound->Data.size() > XAUDIO2_MAX_BUFFER_BYTES))
     {
-        m_effectSourceVoice->Stop();
-        m_effectData.clear();
+        return E_FAIL;
     }
 
-    if (SUCCEEDED(hr))
+    // Let go of the sounds the voices have finished with.
+    m_effectVoices.Update();
+
+    EffectVoiceRequest request;
+    request.Sound = sound;
+    request.Priority = priority;
+    request.Volume = volume;
+    request.Distance = distance;
+
+    unsigned int slot = 0;
+    float gain = 0.f;
+    EFFECT_VOICE_RESULT result = m_effectVoices.Allocate(request, &slot, &gain);
+    if ((result == EFFECT_VOICE_CULLED) || (result == EFFECT_VOICE_REJECTED))
     {
-        hr = StartVoice(
-            file.c_str(), 
-            m_effectAudioEngine.Get(), 
-            m_effectMasteringVoice, 
-            m_effectData, 
-            &m_effectSourceVoice
-            );
-        m_effectBusy = true;
+        return S_FALSE;
+    }
+
+    if (result == EFFECT_VOICE_STOLEN)
+    {
+        // The stolen sound ends here; the pool keeps it alive until the
+        // voice reports its buffer ended.
+        m_effectSourceVoices[slot]->Stop();
+        m_effectSourceVoices[slot]->FlushSourceBuffers();
+    }
+
+    hr = StartEffectVoice(slot, *sound, gain);
+    if (FAILED(hr))
+    {
+        m_effectVoices.Cancel(slot);
     }
 
     return hr;
 }
 
-// Loads and plays a music file once. If a music file is already playing,
-// it will be stopped and the specified file will be played.
-HRESULT SoundPlayer::PlayMusic(_In_ const std::wstring& file)
+// Plays a music file, once or looping. If a music file is already playing,
+// it will be stopped and the specified file will be played. The file is
+// streamed, so playback starts after the first buffer is decoded rather
+// than the whole file.
+HRESULT SoundPlayer::PlayMusic(_In_ const std::wstring& file, _In_ bool loop)
 {
     HRESULT hr = S_OK;
 
-    std::lock_guard<std::mutex> lock(m_criticalSection);
-
     // Validate parameters.
     if (file.size() < 1)
     {
-        hr = E_INVALIDARG;
+        return E_INVALIDARG;
     }
 
-    if (m_musicBusy == true)
+    // Music is played once in a while and is large, so it bypasses the cache.
+    std::unique_ptr<MusicStream> stream(new MusicStream(
+        std::unique_ptr<MusicDecoder>(new MediaFoundationMusicDecoder()),
+        &ReadPerformanceCounter,
+        ReadPerformanceFrequency()
+        ));
+    if (!stream->Open(file, loop))
     {
-        m_musicSourceVoice->Stop();
-        m_musicData.clear();
+        hr = E_FAIL;
     }
 
+    std::lock_guard<std::mutex> lock(m_criticalSection);
+
+    // The music voice has its own callback, so this doesn't wait on ours.
+    m_music.reset();
+
     if (SUCCEEDED(hr))
     {
-        hr = StartVoice(
-            file.c_str(), 
-            m_musicAudioEngine.Get(), 
-            m_musicMasteringVoice, 
-            m_musicData, 
-            &m_musicSourceVoice
-            );
-        m_musicBusy = true;
+        std::unique_ptr<MusicVoice> music(new MusicVoice(std::move(stream)));
+        hr = music->Start(m_musicAudioEngine.Get());
+        if (SUCCEEDED(hr))
+        {
+            m_music = std::move(music);
+        }
     }
 
     return hr;
 }
 
-
-// Internal-only method. Loads an audio file and starts a new voice playing it.
-HRESULT SoundPlayer::StartVoice(
-    _In_ const LPCWSTR url,
-    _In_ IXAudio2* engine,
-    _In_ IXAudio2MasteringVoice* masteringVoice,
-    _In_ std::vector<BYTE>& resultData,
-    _In_ IXAudio2SourceVoice** sourceVoice
-    )
+// Starts decoding a sound effect in the background, so the first
+// PlaySound of it doesn't have to.
+void SoundPlayer::PreloadSound(_In_ const std::wstring& file)
 {
-    HRESULT hr = S_OK;
-
-    if (sourceVoice == nullptr)
-    {
-        hr = E_INVALIDARG;
-    }
+    m_soundCache.Preload(m_soundCache.Intern(file));
+}
 
-    // Create a Media Foundation object and read/process the media file.
-    Microsoft::WRL::ComPtr<IMFSourceReader> reader;
-    {
-        DX::ThrowIfFailed(
-            MFStartup(MF_VERSION)
-            );
+void SoundPlayer::PreloadSound(_In_ SoundAssetId id)
+{
+    m_soundCache.Preload(id);
+}
 
-        // Create the source reader on the url (file). This will be loaded entirely into memory,
-        // so the low latency attribute is not required here; if you are attempting to stream
-        // sound effects from disk, the low latency attribute should be set.
-        // If the file does not exist, this will exhibit HRESULT 0x80070002: File not found.
-        DX::ThrowIfFailed(
-            MFCreateSourceReaderFromURL(url, nullptr, &reader) 
-            );
+SoundAssetId SoundPlayer::InternSound(_In_ const std::wstring& file)
+{
+    return m_soundCache.Intern(file);
+}
 
-        // Set the decoded output format as PCM
-        // XAudio2 on Windows can process PCM and ADPCM-encoded buffers.
-        // When using MF, this sample always decodes into PCM.
-        // NOTE: The inbox ADPCM decoder supports sample rates only up to 44.1KHz. 
-        Microsoft::WRL::ComPtr<IMFMediaType> mediaType;
-        DX::ThrowIfFailed(
-            MFCreateMediaType(&mediaType)
-            );
+void SoundPlayer::GetSoundCacheStats(_Out_ SoundCacheStats* stats) const
+{
+    m_soundCache.GetStats(stats);
+}
 
-        DX::ThrowIfFailed(
-            mediaType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio)
-            );
+void SoundPlayer::GetMusicStats(_Out_ MusicStreamStats* stats) const
+{
+    std::lock_guard<std::mutex> lock(m_criticalSection);
 
-        DX::ThrowIfFailed(
-            mediaType->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_PCM)
-            );
+    if (m_music == nullptr)
+    {
+        ZeroMemory(stats, sizeof(MusicStreamStats));
+        return;
+    }
 
-        DX::ThrowIfFailed(
-            reader->SetCurrentMediaType(MF_SOURCE_READER_FIRST_AUDIO_STREAM, 0, mediaType.Get())
-            );
+    m_music->GetStats(stats);
+}
 
-        // Get the complete WAVEFORMAT from the Media Type
-        Microsoft::WRL::ComPtr<IMFMediaType> outputMediaType;
-        DX::ThrowIfFailed(
-            reader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_AUDIO_STREAM, outputMediaType.GetAddressOf())
-            );
+// Internal-only method. Plays a decoded sound on one of the effect voices.
+// Voices are kept and reused; one is only created the first time its slot
+// is used, or again when a sound has a different format from the last.
+HRESULT SoundPlayer::StartEffectVoice(
+    _In_ unsigned int slot,
+    _In_ const SoundAsset& sound,
+    _In_ float gain
+    )
+{
+    PROFILE_SCOPE("SoundPlayer.StartVoice");
 
-        uint32 formatByteCount = 0;
-        WAVEFORMATEX* waveFormat;
-        DX::ThrowIfFailed(
-            MFCreateWaveFormatExFromMFMediaType(outputMediaType.Get(), &waveFormat, &formatByteCount)
-            );
+    HRESULT hr = S_OK;
+    IXAudio2SourceVoice*& sourceVoice = m_effectSourceVoices[slot];
 
-        // Create the source voice and start it
-        DX::ThrowIfFailed(
-            engine->CreateSourceVoice(
-            sourceVoice,
-            waveFormat,
-            0,
-            1.0f,
-            this,
-            nullptr,
-            nullptr)
-            );
-        CoTaskMemFree(waveFormat);
+    if ((sourceVoice != nullptr) && (m_effectVoiceFormats[slot] != sound.Format))
+    {
+        // Waits for the voice's callbacks, after which nothing queued on it
+        // is being read.
+        sourceVoice->DestroyVoice();
+        sourceVoice = nullptr;
+        m_effectVoices.OnVoiceRecreated(slot);
     }
 
-    // Buffer the sound data in-memory.
-    for (;;)
+    if (sourceVoice == nullptr)
     {
-        DWORD flags = 0;
-        Microsoft::WRL::ComPtr<IMFSample> sample;
-        DX::ThrowIfFailed(
-            reader->ReadSample(
-            MF_SOURCE_READER_FIRST_AUDIO_STREAM,
+        hr = m_effectAudioEngine->CreateSourceVoice(
+            &sourceVoice,
+            reinterpret_cast<const WAVEFORMATEX*>(&sound.Format[0]),
             0,
+            1.0f,
+            this,
             nullptr,
-            &flags,
-            nullptr,
-            &sample
-            )
+            nullptr
             );
 
-        // End of stream
-        if (flags & MF_SOURCE_READERF_ENDOFSTREAM)
+        if (SUCCEEDED(hr))
         {
-            break;
+            m_effectVoiceFormats[slot] = sound.Format;
+        }
+        else
+        {
+            sourceVoice = nullptr;
         }
-
-        Microsoft::WRL::ComPtr<IMFMediaBuffer> mediaBuffer;
-        DX::ThrowIfFailed(
-            sample->ConvertToContiguousBuffer(&mediaBuffer)
-            );
-
-        // Serialize access to the buffer by calling the IMFMediaBuffer::Lock method.
-        uint8* audioData = nullptr;
-        DWORD sampleBufferLength = 0;
-        DX::ThrowIfFailed(
-            mediaBuffer->Lock(&audioData, nullptr, &sampleBufferLength)
-            );
-
-        // Append the new buffer to the running total.
-        size_t lastBufferSize = resultData.size();
-        resultData.resize(lastBufferSize + sampleBufferLength);
-        CopyMemory(&resultData[lastBufferSize], audioData, sampleBufferLength);
-
-        // Release the lock on the buffer.
-        DX::ThrowIfFailed(
-            mediaBuffer->Unlock()
-            );
     }
 
-    if (resultData.size() > XAUDIO2_MAX_BUFFER_BYTES)
+    if (SUCCEEDED(hr))
     {
-        hr = E_FAIL;
+        hr = sourceVoice->SetVolume(gain);
     }
 
-    // Start playing the sound.
     if (SUCCEEDED(hr))
     {
-        // Load the audio bytes into an XAudio2 buffer.
+        // Load the audio bytes into an XAudio2 buffer. The buffer points into
+        // the shared sound, which the pool keeps alive until OnBufferEnd. The
+        // context tells OnBufferEnd which voice finished.
         XAUDIO2_BUFFER playBuffer = { 0 };
-        playBuffer.AudioBytes = static_cast<UINT32>(resultData.size());
-        playBuffer.pAudioData = &resultData[0];
-        playBuffer.pContext = *sourceVoice;
-        
+        playBuffer.AudioBytes = static_cast<UINT32>(sound.Data.size());
+        playBuffer.pAudioData = &sound.Data[0];
+        playBuffer.pContext = reinterpret_cast<void*>(static_cast<uintptr_t>(slot));
+
         // Submit the buffer and start the voice.
-        DX::ThrowIfFailed(
-            (*sourceVoice)->SubmitSourceBuffer(&playBuffer)
-            );
+        hr = sourceVoice->SubmitSourceBuffer(&playBuffer);
+    }
 
-        (*sourceVoice)->Start();
+    if (SUCCEEDED(hr))
+    {
+        hr = sourceVoice->Start();
     }
 
     return hr;
@@ -363,31 +629,129 @@ void SoundPlayer::OnBufferStart(void* /*bufferContext*/)
 
 void SoundPlayer::OnBufferEnd(void* bufferContext)
 {
-    if (bufferContext == m_effectSourceVoice)
+    // Only counts the buffer; the game thread frees the sound on its next
+    // PlaySound, so nothing here waits on it.
+    m_effectVoices.OnVoiceEnd(static_cast<unsigned int>(reinterpret_cast<uintptr_t>(bufferContext)));
+}
+
+void SoundPlayer::OnLoopEnd(void* /*bufferContext*/)
+{
+}
+
+void SoundPlayer::OnVoiceError(void* /*bufferContext*/, HRESULT /*error*/)
+{
+}
+
+void SoundPlayer::OnVoiceProcessingPassStart(UINT32 /*bytesRequired*/)
+{
+}
+
+void SoundPlayer::OnVoiceProcessingPassEnd()
+{
+}
+
+#pragma region MusicVoice
+
+MusicVoice::MusicVoice(_In_ std::unique_ptr<MusicStream> stream) :
+    m_stream(std::move(stream)),
+    m_sourceVoice(nullptr)
+{
+}
+
+MusicVoice::~MusicVoice()
+{
+    // Stop the voice first so the stream's decode thread isn't waiting on a
+    // buffer to play, and keep the stream's buffers alive until the voice is
+    // gone.
+    if (m_sourceVoice)
     {
-        m_effectData.clear();
-        m_effectBusy = false;
+        m_sourceVoice->Stop();
     }
 
-    if (bufferContext == m_musicSourceVoice)
+    m_stream->Stop();
+
+    if (m_sourceVoice)
     {
-        m_musicData.clear();
-        m_musicBusy = false;
+        m_sourceVoice->DestroyVoice();
+        m_sourceVoice = nullptr;
     }
 }
 
-void SoundPlayer::OnLoopEnd(void* /*bufferContext*/)
+HRESULT MusicVoice::Start(_In_ IXAudio2* engine)
 {
+    const std::vector<unsigned char>& format = m_stream->GetFormat();
+    if (format.size() < sizeof(WAVEFORMATEX))
+    {
+        return E_INVALIDARG;
+    }
+
+    HRESULT hr = engine->CreateSourceVoice(
+        &m_sourceVoice,
+        reinterpret_cast<const WAVEFORMATEX*>(&format[0]),
+        0,
+        1.0f,
+        this,
+        nullptr,
+        nullptr
+        );
+
+    // The voice starts out silent and begins playing as soon as the first
+    // buffer is submitted.
+    if (SUCCEEDED(hr))
+    {
+        m_stream->Start(this);
+        hr = m_sourceVoice->Start();
+    }
+
+    return hr;
 }
 
-void SoundPlayer::OnVoiceError(void* /*bufferContext*/, HRESULT /*error*/)
+void MusicVoice::GetStats(_Out_ MusicStreamStats* stats) const
 {
+    m_stream->GetStats(stats);
 }
 
-void SoundPlayer::OnVoiceProcessingPassStart(UINT32 /*bytesRequired*/)
+void MusicVoice::Submit(const unsigned char* data, unsigned int bytes, bool endOfStream)
+{
+    XAUDIO2_BUFFER playBuffer = { 0 };
+    playBuffer.AudioBytes = bytes;
+    playBuffer.pAudioData = data;
+    playBuffer.Flags = endOfStream ? XAUDIO2_END_OF_STREAM : 0;
+
+    // A buffer the voice won't take will never end, so hand it straight back.
+    if (FAILED(m_sourceVoice->SubmitSourceBuffer(&playBuffer)))
+    {
+        m_stream->OnBufferEnd();
+    }
+}
+
+void MusicVoice::OnBufferEnd(void* /*bufferContext*/)
 {
+    m_stream->OnBufferEnd();
 }
 
-void SoundPlayer::OnVoiceProcessingPassEnd()
+void MusicVoice::OnStreamEnd()
 {
 }
+
+void MusicVoice::OnBufferStart(void* /*bufferContext*/)
+{
+}
+
+void MusicVoice::OnLoopEnd(void* /*bufferContext*/)
+{
+}
+
+void MusicVoice::OnVoiceError(void* /*bufferContext*/, HRESULT /*error*/)
+{
+}
+
+void MusicVoice::OnVoiceProcessingPassStart(UINT32 /*bytesRequired*/)
+{
+}
+
+void MusicVoice::OnVoiceProcessingPassEnd()
+{
+}
+
+#pragma endregion
@@ -14,19 +14,71 @@
 #include <mfidl.h>
 #include <mfapi.h>
 #include <mfreadwrite.h>
+#include "SoundCache.h"
+#include "MusicStream.h"
+#include "EffectVoicePool.h"
 
 using namespace Windows::System::Threading;
 using namespace Windows::Foundation;
 
 namespace DirectXGame2
 {
+    // Effects that can play at once.
+#define SOUND_PLAYER_EFFECT_VOICES      16
+
+    //
+    // The MusicVoice class plays a MusicStream on an XAudio2 source voice.
+    //
+    // It is the voice's callback, so finished buffers go straight back to the
+    // stream without waiting on the SoundPlayer's critical section.
+    //
+    class MusicVoice sealed : public IXAudio2VoiceCallback, public MusicSink
+    {
+    public:
+        MusicVoice(_In_ std::unique_ptr<MusicStream> stream);
+
+        // Stops the voice and the stream's decode thread, then destroys the voice.
+        ~MusicVoice();
+
+        // Creates the voice on the engine and starts the stream playing.
+        HRESULT Start( _In_ IXAudio2* engine );
+
+        void GetStats( _Out_ MusicStreamStats* stats ) const;
+
+        // Queues a decoded buffer on the voice. Called by the stream.
+        virtual void Submit(const unsigned char* data, unsigned int bytes, bool endOfStream);
+
+        // XAudio source voice callbacks.
+        STDMETHOD_(void, OnVoiceProcessingPassStart) (THIS_ UINT32 bytesRequired);
+        STDMETHOD_(void, OnVoiceProcessingPassEnd)   (THIS);
+        STDMETHOD_(void, OnStreamEnd)   (THIS);
+        STDMETHOD_(void, OnBufferStart) (THIS_ void* bufferContext);
+        STDMETHOD_(void, OnBufferEnd)   (THIS_ void* bufferContext);
+        STDMETHOD_(void, OnLoopEnd)     (THIS_ void* bufferContext);
+        STDMETHOD_(void, OnVoiceError)  (THIS_ void* bufferContext, HRESULT error);
+
+    private:
+        std::unique_ptr<MusicStream>    m_stream;
+        IXAudio2SourceVoice*            m_sourceVoice;
+    };
+
     //
     // The SoundPlayer class enables playing an effect or music.
     // 
     // Usage: 
     // 1. Create: m_player = std::shared_ptr<AudioManager>( new AudioManager() );
-    // 4. Play a sound: m_player->PlaySound( filename );
+    // 4. Play a sound: m_player->PlaySound( filename, priority, volume, distance );
     // 3. Play a music: m_player->PlayMusic( filename );
+    // 4. Optionally, decode effects ahead of time: m_player->PreloadSound( filename );
+    //
+    // Effects played every frame are better resolved to an id once at load,
+    // with id = m_player->InternSound( filename ), and played by id, which
+    // skips hashing the file name on every call.
+    //
+    // Sound effects are decoded once and kept in a SoundCache, and play on a
+    // fixed pool of voices, so several can overlap; music is streamed,
+    // decoding a little ahead of the voice as it plays. PlaySound is meant
+    // for the game thread only.
     //
     // To destroy, let go out of scope (or reset the smart pointer). Destroy on suspend,
     // recreate on resume.
@@ -40,8 +92,27 @@ namespace DirectXGame2
         ~SoundPlayer();
 
         // Public methods for playing sound effect or music.
-        HRESULT PlaySound   ( _In_ const std::wstring& filename );
-        HRESULT PlayMusic   ( _In_ const std::wstring& filename );
+        HRESULT PlaySound   (
+            _In_ const std::wstring& filename,
+            _In_ EFFECT_PRIORITY priority = EFFECT_PRIORITY_NORMAL,
+            _In_ float volume = 1.0f,
+            _In_ float distance = 0.0f
+            );
+        HRESULT PlaySound   (
+            _In_ SoundAssetId sound,
+            _In_ EFFECT_PRIORITY priority = EFFECT_PRIORITY_NORMAL,
+            _In_ float volume = 1.0f,
+            _In_ float distance = 0.0f
+            );
+        HRESULT PlayMusic   ( _In_ const std::wstring& filename, _In_ bool loop = false );
+        void PreloadSound   ( _In_ const std::wstring& filename );
+        void PreloadSound   ( _In_ SoundAssetId sound );
+
+        // Returns the id that plays the file, for the overloads that take one.
+        SoundAssetId InternSound( _In_ const std::wstring& filename );
+
+        void GetSoundCacheStats( _Out_ SoundCacheStats* stats ) const;
+        void GetMusicStats( _Out_ MusicStreamStats* stats ) const;
 
         // Public methods for app lifecycle.
         void Suspend();
@@ -57,32 +128,30 @@ namespace DirectXGame2
         STDMETHOD_(void, OnVoiceError)  (THIS_ void* bufferContext, HRESULT error);
 
     private:
-        // Callback. Activated when a voice has started.
-        HRESULT StartVoice(
-            _In_ const LPCWSTR url, 
-            _In_ IXAudio2* engine,
-            _In_ IXAudio2MasteringVoice* masteringVoice,
-            _In_ std::vector<BYTE>& resultData,
-            _In_ IXAudio2SourceVoice** sourceVoice
+        // Plays a decoded sound on one of the effect voices.
+        HRESULT StartEffectVoice(
+            _In_ unsigned int slot,
+            _In_ const SoundAsset& sound,
+            _In_ float gain
             );
 
-        // Variables for the sound voice.
-        std::vector<BYTE>                m_effectData;
-        IXAudio2SourceVoice*             m_effectSourceVoice;
+        // Decoded sound effects, shared by the voices playing them.
+        SoundCache                       m_soundCache;
+
+        // Variables for the sound voices. The pool decides which voice plays
+        // each effect and keeps the sounds alive while they play.
+        EffectVoicePool                  m_effectVoices;
+        IXAudio2SourceVoice*             m_effectSourceVoices[SOUND_PLAYER_EFFECT_VOICES];
+        std::vector<unsigned char>       m_effectVoiceFormats[SOUND_PLAYER_EFFECT_VOICES];
         IXAudio2MasteringVoice*          m_effectMasteringVoice;
         Microsoft::WRL::ComPtr<IXAudio2> m_effectAudioEngine;
 
         // Variables for the music voice.
-        std::vector<BYTE>                m_musicData;
-        IXAudio2SourceVoice*             m_musicSourceVoice;
+        std::unique_ptr<MusicVoice>      m_music;
         IXAudio2MasteringVoice*          m_musicMasteringVoice;
         Microsoft::WRL::ComPtr<IXAudio2> m_musicAudioEngine;
 
-        // These are used to track when the voices are already playing something.
-        bool m_effectBusy;
-        bool m_musicBusy;
-
-        // Critical section to prevent thread contention with callbacks.
-        std::mutex                       m_criticalSection;
+        // Critical section guarding the music voice.
+        mutable std::mutex               m_criticalSection;
     };
 }
@@ -166,6 +166,24 @@ namespace DX
             }
         }
 
+        // Advance by exactly one fixed step without consulting the clock, calling update once.
+        // Lets a replay run the simulation as fast as the machine allows.
+        template<typename TUpdate>
+        void Step(const TUpdate& update)
+        {
+            if (!QueryPerformanceCounter(&m_qpcLastTime))
+            {
+                throw ref new Platform::FailureException();
+            }
+
+            m_elapsedTicks   = m_targetElapsedTicks;
+            m_totalTicks    += m_targetElapsedTicks;
+            m_leftOverTicks  = 0;
+            m_frameCount++;
+
+            update();
+        }
+
     private:
         // Source timing data uses QPC units.
         LARGE_INTEGER m_qpcFrequency;
@@ -0,0 +1,178 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "TouchRegionGrid.h"
+
+using namespace DirectXGame2;
+
+TouchRegionGrid::TouchRegionGrid()
+{
+    Clear();
+}
+
+int TouchRegionGrid::AddRegion(float left, float top, float right, float bottom, int priority)
+{
+    if ((m_regionCount >= TOUCH_REGION_GRID_MAX_REGIONS) || (left > right) || (top > bottom))
+    {
+        return -1;
+    }
+
+    unsigned int index = m_regionCount++;
+
+    Region& region = m_regions[index];
+    region.Left = left;
+    region.Top = top;
+    region.Right = right;
+    region.Bottom = bottom;
+    region.Priority = priority;
+
+    m_enabledMask |= (1u << index);
+
+    // Adding a region can grow the bounding box, which moves every cell
+    // edge, so the whole grid is rebuilt. Regions are only added on layout
+    // changes and there are never more than a few dozen.
+    Rebuild();
+
+    return static_cast<int>(index);
+}
+
+void TouchRegionGrid::Clear()
+{
+    m_regionCount = 0;
+    m_enabledMask = 0;
+    m_left = m_top = m_right = m_bottom = 0.f;
+    m_cellsPerUnitX = m_cellsPerUnitY = 0.f;
+
+    for (unsigned int y = 0; y < TOUCH_REGION_GRID_CELLS_Y; y++)
+    {
+        for (unsigned int x = 0; x < TOUCH_REGION_GRID_CELLS_X; x++)
+        {
+            m_cells[y][x] = 0;
+        }
+    }
+}
+
+void TouchRegionGrid::SetEnabled(unsigned int region, bool isEnabled)
+{
+    if (region >= m_regionCount)
+    {
+        return;
+    }
+
+    if (isEnabled)
+    {
+        m_enabledMask |= (1u << region);
+    }
+    else
+    {
+        m_enabledMask &= ~(1u << region);
+    }
+}
+
+bool TouchRegionGrid::IsEnabled(unsigned int region) const
+{
+    return (region < m_regionCount) && ((m_enabledMask & (1u << region)) != 0);
+}
+
+int TouchRegionGrid::HitTest(float x, float y) const
+{
+    // Nothing lies outside the bounding box.
+    if ((m_regionCount == 0) || (x < m_left) || (x > m_right) || (y < m_top) || (y > m_bottom))
+    {
+        return -1;
+    }
+
+    unsigned int candidates = m_cells[CellY(y)][CellX(x)] & m_enabledMask;
+
+    // Lowest index first, so among equal priorities the earliest region wins.
+    int best = -1;
+    for (unsigned int index = 0; candidates != 0; index++, candidates >>= 1)
+    {
+        if ((candidates & 1) == 0)
+        {
+            continue;
+        }
+
+        const Region& region = m_regions[index];
+        if ((x < region.Left) || (x > region.Right) || (y < region.Top) || (y > region.Bottom))
+        {
+            continue;
+        }
+
+        if ((best < 0) || (region.Priority > m_regions[best].Priority))
+        {
+            best = static_cast<int>(index);
+        }
+    }
+
+    return best;
+}
+
+void TouchRegionGrid::Rebuild()
+{
+    m_left = m_regions[0].Left;
+    m_top = m_regions[0].Top;
+    m_right = m_regions[0].Right;
+    m_bottom = m_regions[0].Bottom;
+
+    for (unsigned int i = 1; i < m_regionCount; i++)
+    {
+        if (m_regions[i].Left < m_left)     m_left = m_regions[i].Left;
+        if (m_regions[i].Top < m_top)       m_top = m_regions[i].Top;
+        if (m_regions[i].Right > m_right)   m_right = m_regions[i].Right;
+        if (m_regions[i].Bottom > m_bottom) m_bottom = m_regions[i].Bottom;
+    }
+
+    // A zero-width box maps everything to the first column or row.
+    float width = m_right - m_left;
+    float height = m_bottom - m_top;
+    m_cellsPerUnitX = (width > 0.f) ? (TOUCH_REGION_GRID_CELLS_X / width) : 0.f;
+    m_cellsPerUnitY = (height > 0.f) ? (TOUCH_REGION_GRID_CELLS_Y / height) : 0.f;
+
+    for (unsigned int y = 0; y < TOUCH_REGION_GRID_CELLS_Y; y++)
+    {
+        for (unsigned int x = 0; x < TOUCH_REGION_GRID_CELLS_X; x++)
+        {
+            m_cells[y][x] = 0;
+        }
+    }
+
+    for (unsigned int i = 0; i < m_regionCount; i++)
+    {
+        const Region& region = m_regions[i];
+
+        unsigned int x0 = CellX(region.Left);
+        unsigned int x1 = CellX(region.Right);
+        unsigned int y0 = CellY(region.Top);
+        unsigned int y1 = CellY(region.Bottom);
+
+        for (unsigned int y = y0; y <= y1; y++)
+        {
+            for (unsigned int x = x0; x <= x1; x++)
+            {
+                m_cells[y][x] |= (1u << i);
+            }
+        }
+    }
+}
+
+unsigned int TouchRegionGrid::CellX(float x) const
+{
+    int cell = static_cast<int>((x - m_left) * m_cellsPerUnitX);
+    if (cell < 0) return 0;
+    if (cell >= TOUCH_REGION_GRID_CELLS_X) return TOUCH_REGION_GRID_CELLS_X - 1;
+    return static_cast<unsigned int>(cell);
+}
+
+unsigned int TouchRegionGrid::CellY(float y) const
+{
+    int cell = static_cast<int>((y - m_top) * m_cellsPerUnitY);
+    if (cell < 0) return 0;
+    if (cell >= TOUCH_REGION_GRID_CELLS_Y) return TOUCH_REGION_GRID_CELLS_Y - 1;
+    return static_cast<unsigned int>(cell);
+}
@@ -0,0 +1,84 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+namespace DirectXGame2
+{
+    // Regions the grid can hold; each cell stores the regions touching it as a bit mask.
+#define TOUCH_REGION_GRID_MAX_REGIONS   32
+
+    // Cells across and down the area covered by the regions.
+#define TOUCH_REGION_GRID_CELLS_X       16
+#define TOUCH_REGION_GRID_CELLS_Y       16
+
+    //
+    // The TouchRegionGrid class finds which touch region a pointer is in.
+    //
+    // The bounding box of all regions is cut into a fixed grid, and every
+    // cell records which regions overlap it. A hit test looks up the
+    // pointer's cell and only checks the regions listed there, so its cost
+    // doesn't grow with the number of regions on screen.
+    //
+    // Regions may overlap. Where they do, the one with the highest priority
+    // wins, and between equal priorities the one added first. Disabled
+    // regions are masked out at hit test time, so enabling and disabling
+    // don't touch the grid.
+    //
+    // Usage:
+    // 1. id = grid.AddRegion(left, top, right, bottom, priority);
+    // 2. Per pointer: int region = grid.HitTest(x, y);
+    // 3. grid.SetEnabled(id, false) to take a region out of play.
+    //
+    class TouchRegionGrid
+    {
+    public:
+        TouchRegionGrid();
+
+        // Adds a region, with edges inclusive. Returns its index, or -1 if
+        // the grid is full or the rectangle is inverted.
+        int AddRegion(float left, float top, float right, float bottom, int priority = 0);
+
+        void Clear();
+
+        void SetEnabled(unsigned int region, bool isEnabled);
+        bool IsEnabled(unsigned int region) const;
+
+        // Returns the index of the enabled region at (x, y), or -1 if there is none.
+        int HitTest(float x, float y) const;
+
+        unsigned int GetRegionCount() const     { return m_regionCount; }
+
+    private:
+        struct Region
+        {
+            float   Left;
+            float   Top;
+            float   Right;
+            float   Bottom;
+            int     Priority;
+        };
+
+        void Rebuild();
+        unsigned int CellX(float x) const;
+        unsigned int CellY(float y) const;
+
+        Region          m_regions[TOUCH_REGION_GRID_MAX_REGIONS];
+        unsigned int    m_regionCount;
+        unsigned int    m_enabledMask;
+
+        // Bounding box of all regions, and its cell size.
+        float           m_left;
+        float           m_top;
+        float           m_right;
+        float           m_bottom;
+        float           m_cellsPerUnitX;
+        float           m_cellsPerUnitY;
+
+        unsigned int    m_cells[TOUCH_REGION_GRID_CELLS_Y][TOUCH_REGION_GRID_CELLS_X];
+    };
+}
@@ -0,0 +1,174 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+#include "TransformHierarchy.h"
+
+using namespace DirectX;
+using namespace DirectXGame2;
+
+// Dirty flag values.
+#define TRANSFORM_CLEAN         0x00
+#define TRANSFORM_DIRTY_LOCAL   0x01    // Local TRS changed; the local matrix must be rebuilt.
+#define TRANSFORM_DIRTY_WORLD   0x02    // An ancestor moved; only the world matrix must be rebuilt.
+
+TransformHierarchy::TransformHierarchy() :
+    m_firstDirty(0)
+{
+}
+
+void TransformHierarchy::Reserve(unsigned int nodeCount)
+{
+    m_parents.reserve(nodeCount);
+    m_scales.reserve(nodeCount);
+    m_rotations.reserve(nodeCount);
+    m_translations.reserve(nodeCount);
+    m_localMatrices.reserve(nodeCount);
+    m_worldMatrices.reserve(nodeCount);
+    m_dirty.reserve(nodeCount);
+}
+
+void TransformHierarchy::Clear()
+{
+    m_parents.clear();
+    m_scales.clear();
+    m_rotations.clear();
+    m_translations.clear();
+    m_localMatrices.clear();
+    m_worldMatrices.clear();
+    m_dirty.clear();
+    m_firstDirty = 0;
+}
+
+TransformNode TransformHierarchy::AddNode(TransformNode parent)
+{
+    TransformNode node = static_cast<TransformNode>(m_parents.size());
+
+    // Children must come after their parents, otherwise the single forward
+    // pass in Update() would read a stale parent matrix.
+    if ((parent != INVALID_TRANSFORM_NODE) && (parent >= node))
+    {
+        return INVALID_TRANSFORM_NODE;
+    }
+
+    XMFLOAT4X4 identity;
+    XMStoreFloat4x4(&identity, XMMatrixIdentity());
+
+    m_parents.push_back(parent);
+    m_scales.push_back(XMFLOAT3(1.0f, 1.0f, 1.0f));
+    m_rotations.push_back(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    m_translations.push_back(XMFLOAT3(0.0f, 0.0f, 0.0f));
+    m_localMatrices.push_back(identity);
+    m_worldMatrices.push_back(identity);
+    m_dirty.push_back(TRANSFORM_CLEAN);
+
+    // A new node still has to pick up its parent's world matrix.
+    MarkDirty(node);
+
+    return node;
+}
+
+void TransformHierarchy::SetLocalScale(TransformNode node, FXMVECTOR scale)
+{
+    if (XMVector3Equal(XMLoadFloat3(&m_scales[node]), scale)) return;
+
+    XMStoreFloat3(&m_scales[node], scale);
+    MarkDirty(node);
+}
+
+void TransformHierarchy::SetLocalRotation(TransformNode node, FXMVECTOR quaternion)
+{
+    if (XMVector4Equal(XMLoadFloat4(&m_rotations[node]), quaternion)) return;
+
+    XMStoreFloat4(&m_rotations[node], quaternion);
+    MarkDirty(node);
+}
+
+void TransformHierarchy::SetLocalTranslation(TransformNode node, FXMVECTOR translation)
+{
+    if (XMVector3Equal(XMLoadFloat3(&m_translations[node]), translation)) return;
+
+    XMStoreFloat3(&m_translations[node], translation);
+    MarkDirty(node);
+}
+
+void TransformHierarchy::SetLocalTransform(TransformNode node, FXMVECTOR scale, FXMVECTOR quaternion, FXMVECTOR translation)
+{
+    SetLocalScale(node, scale);
+    SetLocalRotation(node, quaternion);
+    SetLocalTranslation(node, translation);
+}
+
+void TransformHierarchy::MarkDirty(TransformNode node)
+{
+    m_dirty[node] |= TRANSFORM_DIRTY_LOCAL;
+
+    if (node < m_firstDirty) m_firstDirty = node;
+}
+
+// Walks the arrays once from the first dirty node. Because parents precede
+// their children, a dirty parent has always been recomputed (and still has its
+// flag set) by the time its children are visited, so the flag propagates down
+// the subtree without any recursion. Flags are cleared in a second pass.
+unsigned int TransformHierarchy::Update()
+{
+    unsigned int nodeCount = GetNodeCount();
+    unsigned int updated = 0;
+
+    if (m_firstDirty >= nodeCount)
+    {
+        return 0;
+    }
+
+    const TransformNode* parents = &m_parents[0];
+    unsigned char* dirty = &m_dirty[0];
+
+    for (unsigned int i = m_firstDirty; i < nodeCount; i++)
+    {
+        TransformNode parent = parents[i];
+
+        if ((parent != INVALID_TRANSFORM_NODE) && dirty[parent])
+        {
+            dirty[i] |= TRANSFORM_DIRTY_WORLD;
+        }
+
+        if (!dirty[i])
+        {
+            continue;
+        }
+
+        XMMATRIX local;
+        if (dirty[i] & TRANSFORM_DIRTY_LOCAL)
+        {
+            // local = S * R * T, composed in SIMD registers.
+            local = XMMatrixScalingFromVector(XMLoadFloat3(&m_scales[i]));
+            local = XMMatrixMultiply(local, XMMatrixRotationQuaternion(XMLoadFloat4(&m_rotations[i])));
+            local.r[3] = XMVectorSelect(g_XMIdentityR3, XMLoadFloat3(&m_translations[i]), g_XMSelect1110);
+            XMStoreFloat4x4(&m_localMatrices[i], local);
+        }
+        else
+        {
+            local = XMLoadFloat4x4(&m_localMatrices[i]);
+        }
+
+        if (parent == INVALID_TRANSFORM_NODE)
+        {
+            XMStoreFloat4x4(&m_worldMatrices[i], local);
+        }
+        else
+        {
+            XMStoreFloat4x4(&m_worldMatrices[i], XMMatrixMultiply(local, XMLoadFloat4x4(&m_worldMatrices[parent])));
+        }
+
+        updated++;
+    }
+
+    ZeroMemory(&dirty[m_firstDirty], nodeCount - m_firstDirty);
+    m_firstDirty = nodeCount;
+
+    return updated;
+}
@@ -0,0 +1,100 @@
+//// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+//// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+//// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+//// PARTICULAR PURPOSE.
+////
+//// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+#include "AllocationTracker.h"
+
+using namespace DirectX;
+
+namespace DirectXGame2
+{
+    // Handle to a node in a TransformHierarchy. Handles are plain indices
+    // into the hierarchy's arrays and stay valid until Clear() is called.
+    typedef unsigned int TransformNode;
+
+    // Parent value used for root nodes.
+#define INVALID_TRANSFORM_NODE          0xFFFFFFFF
+
+    //
+    // The TransformHierarchy class stores a flattened scene graph.
+    //
+    // Nodes are kept in parent-before-child order in contiguous arrays (a
+    // node's parent must already exist when the node is added), so that the
+    // world matrices can be rebuilt with a single forward pass:
+    //
+    //     world[i] = local[i] * world[parent[i]]
+    //
+    // Each node keeps its local scale / rotation / translation plus cached
+    // local and world matrices. Setting a local value only marks the node
+    // dirty; Update() recomputes dirty nodes and everything below them and
+    // leaves the rest of the hierarchy untouched.
+    //
+    // Usage:
+    // 1. Create the nodes: camera = AddNode(); laser = AddNode(camera);
+    // 2. Set local values whenever they change: SetLocalRotation(laser, q);
+    // 3. Call Update() once per frame before reading world matrices.
+    //
+    class TransformHierarchy
+    {
+    public:
+        TransformHierarchy();
+
+        // Pre-sizes the node arrays to avoid reallocation while building.
+        void Reserve(unsigned int nodeCount);
+
+        // Removes all nodes. Invalidates every handle.
+        void Clear();
+
+        // Adds a node with an identity local transform. The parent must be
+        // INVALID_TRANSFORM_NODE or an existing node.
+        TransformNode AddNode(TransformNode parent = INVALID_TRANSFORM_NODE);
+
+        // Local transform setters. Values that did not change do not dirty the node.
+        void SetLocalScale(TransformNode node, FXMVECTOR scale);
+        void SetLocalRotation(TransformNode node, FXMVECTOR quaternion);
+        void SetLocalTranslation(TransformNode node, FXMVECTOR translation);
+        void SetLocalTransform(TransformNode node, FXMVECTOR scale, FXMVECTOR quaternion, FXMVECTOR translation);
+
+        // Recomputes the world matrices of dirty nodes and their descendants.
+        // Returns the number of nodes that were recomputed.
+        unsigned int Update();
+
+        // Accessors. World matrices are only current after Update().
+        XMMATRIX GetLocalMatrix(TransformNode node) const     { return XMLoadFloat4x4(&m_localMatrices[node]); }
+        XMMATRIX GetWorldMatrix(TransformNode node) const     { return XMLoadFloat4x4(&m_worldMatrices[node]); }
+        const XMFLOAT4X4* GetWorldMatrices() const            { return m_worldMatrices.empty() ? nullptr : &m_worldMatrices[0]; }
+        TransformNode GetParent(TransformNode node) const     { return m_parents[node]; }
+        unsigned int GetNodeCount() const                     { return static_cast<unsigned int>(m_parents.size()); }
+        bool IsDirty(TransformNode node) const                { return m_dirty[node] != 0; }
+
+    private:
+        void MarkDirty(TransformNode node);
+
+        // Node data, one entry per node, in parent-before-child order. Charged
+        // to MEMORY_TAG_SCENE.
+        template<typename T>
+        struct NodeArray
+        {
+            typedef std::vector<T, TrackingAllocator<T, MEMORY_TAG_SCENE>> Type;
+        };
+
+        NodeArray<TransformNode>::Type  m_parents;
+        NodeArray<XMFLOAT3>::Type       m_scales;
+        NodeArray<XMFLOAT4>::Type       m_rotations;
+        NodeArray<XMFLOAT3>::Type       m_translations;
+        NodeArray<XMFLOAT4X4>::Type     m_localMatrices;
+        NodeArray<XMFLOAT4X4>::Type     m_worldMatrices;
+        NodeArray<unsigned char>::Type  m_dirty;
+
+        // Lowest dirty index. Update() starts its pass here, since nothing
+        // before the first dirty node can be affected by it.
+        unsigned int                m_firstDirty;
+    };
+}